@@ -267,6 +267,9 @@ def command_tools():
         sh('make', cwd=tools, console=True)
         cp('%s/cgfx2json/bin/release/cgfx2json' % tools, tools_bin)
         cp('%s/NvTriStrip/NvTriStripper/bin/release/NvTriStripper' % tools, tools_bin)
+        # Only built with make, there are no Visual Studio projects for them
+        for tool in ['json2geom', 'json2anim', 'atlaspack']:
+            cp('%s/%s/bin/release/%s' % (tools, tool, tool), tools_bin)
 
 
 @command_no_arguments
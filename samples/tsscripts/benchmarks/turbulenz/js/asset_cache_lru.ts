@@ -0,0 +1,114 @@
+// Copyright (c) 2015 Turbulenz Limited
+
+/*global BF: false*/
+/*global AssetCache: false*/
+
+//
+//  Asset cache LRU: AssetCache keeps its assets in a least recently used list
+//  so requests, gets and evictions are constant time regardless of how many
+//  assets are cached
+//
+
+//
+//  AssetCacheLRU: Requests a skewed sequence of keys through a cache that
+//  holds a quarter of them, so most requests move an asset to the most
+//  recently used end and the rest evict the oldest one
+//
+class AssetCacheLRU
+{
+    // Settings
+    numKeys = 1024;     // Number of distinct keys
+    cacheSize = 256;    // Number of assets cached
+    n = 65536;          // Number of requests
+
+    cache: AssetCache;
+    keys: string[];
+    sequence: number[];
+
+    init()
+    {
+        var numKeys = this.numKeys;
+        var keys = [];
+        var i;
+        for (i = 0; i < numKeys; i += 1)
+        {
+            keys[i] = "asset" + i;
+        }
+        this.keys = keys;
+
+        // Seeded so every run requests the same sequence, squaring the
+        // random number favours the lower keys
+        var n = this.n;
+        var sequence = [];
+        var seed = 12345;
+        for (i = 0; i < n; i += 1)
+        {
+            seed = ((seed * 1103515245) + 12345) & 0x7fffffff;
+            var r = (seed / 0x80000000);
+            sequence[i] = Math.floor(r * r * numKeys);
+        }
+        this.sequence = sequence;
+
+        this.cache = AssetCache.create({
+            size: this.cacheSize,
+            onLoad: function onLoadFn(key, params, callback)
+            {
+                callback(key);
+            }
+        });
+    }
+
+    run()
+    {
+        var cache = this.cache;
+        var keys = this.keys;
+        var sequence = this.sequence;
+        var n = this.n;
+        for (var i = 0; i < n; i += 1)
+        {
+            var key = keys[sequence[i]];
+            if (!cache.get(key))
+            {
+                cache.request(key);
+            }
+        }
+    }
+
+    destroy()
+    {
+        delete this.cache;
+        delete this.keys;
+        delete this.sequence;
+    }
+
+    // Constructor function
+    static create()
+    {
+        var a = new AssetCacheLRU();
+        a.cache = null;
+        a.keys = null;
+        a.sequence = null;
+        return a;
+    }
+}
+
+var assetCacheLRU = AssetCacheLRU.create();
+
+BF.register({
+    name: "AssetCacheLRU",
+    path: "scripts/benchmarks/turbulenz/js/asset_cache_lru.js",
+    description: [
+        "Requests 64K skewed keys out of 1024 through an AssetCache of 256 assets."
+    ],
+    init: function () {
+        return assetCacheLRU.init();
+    },
+    run: function () {
+        return assetCacheLRU.run();
+    },
+    destroy: function () {
+        return assetCacheLRU.destroy();
+    },
+    targetMean: 0.01000,
+    version: 1.0
+});
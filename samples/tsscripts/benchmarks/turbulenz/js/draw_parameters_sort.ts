@@ -0,0 +1,178 @@
+// Copyright (c) 2015 Turbulenz Limited
+
+/*global BF: false*/
+/*global TurbulenzEngine: false*/
+
+//
+//  Draw parameters sort: Array.sort with a comparator vs radix sort on the
+//  sortKey of a frame worth of draw parameters
+//
+
+//
+//  SortDrawParameters: Generates draw parameters with keys laid out like the
+//  renderers do (technique, material and a fractional distance or node term)
+//
+class SortDrawParameters
+{
+    sortKey: number;
+
+    static createArray(n: number): SortDrawParameters[]
+    {
+        var array = [];
+        for (var i = 0; i < n; i += 1)
+        {
+            var techniqueIndex = Math.floor(Math.random() * 16);
+            var materialIndex = Math.floor(Math.random() * 256);
+            var dp = new SortDrawParameters();
+            dp.sortKey = ((techniqueIndex * 0x10000) + materialIndex + (Math.random() * 0.999));
+            array[i] = dp;
+        }
+        return array;
+    }
+}
+
+//
+//  ComparatorSort: The sort used by drawArray before the radix sort
+//
+class ComparatorSort
+{
+    // Settings
+    n = 4096; // Number of draw parameters to sort
+
+    source: SortDrawParameters[];
+    array: SortDrawParameters[];
+
+    init()
+    {
+        this.source = SortDrawParameters.createArray(this.n);
+        this.array = [];
+    }
+
+    run()
+    {
+        var source = this.source;
+        var array = this.array;
+        var n = this.n;
+        for (var i = 0; i < n; i += 1)
+        {
+            array[i] = source[i];
+        }
+        array.sort(function sortPositiveFn(a, b)
+                   {
+                       return (b.sortKey - a.sortKey);
+                   });
+    }
+
+    destroy()
+    {
+        delete this.source;
+        delete this.array;
+    }
+
+    // Constructor function
+    static create()
+    {
+        var s = new ComparatorSort();
+        s.source = [];
+        s.array = [];
+        return s;
+    }
+}
+
+//
+//  RadixSort: Times WebGLGraphicsDevice._sortDrawParameters, the sort used by
+//  drawArray, on the same draw parameters
+//
+class RadixSort
+{
+    // Settings
+    n = 4096; // Number of draw parameters to sort
+
+    graphicsDevice: any; // WebGLGraphicsDevice
+    source: SortDrawParameters[];
+    array: SortDrawParameters[];
+
+    init()
+    {
+        var gd: any = (TurbulenzEngine.getGraphicsDevice() ||
+                       TurbulenzEngine.createGraphicsDevice({}));
+        if (!gd || !gd._sortDrawParameters)
+        {
+            throw new Error("RadixSort: needs the WebGL GraphicsDevice");
+        }
+        this.graphicsDevice = gd;
+        this.source = SortDrawParameters.createArray(this.n);
+        this.array = [];
+    }
+
+    run()
+    {
+        var source = this.source;
+        var array = this.array;
+        var n = this.n;
+        for (var i = 0; i < n; i += 1)
+        {
+            array[i] = source[i];
+        }
+        this.graphicsDevice._sortDrawParameters(array, n, 1);
+    }
+
+    destroy()
+    {
+        delete this.source;
+        delete this.array;
+    }
+
+    // Constructor function
+    static create()
+    {
+        var s = new RadixSort();
+        s.graphicsDevice = null;
+        s.source = [];
+        s.array = [];
+        return s;
+    }
+}
+
+var comparatorSort = ComparatorSort.create();
+var radixSort = RadixSort.create();
+
+BF.register({
+    name: "ComparatorSort",
+    path: "scripts/benchmarks/turbulenz/js/draw_parameters_sort.js",
+    description: [
+        "Sorts an array of draw parameters by decreasing sortKey using Array.sort with a comparator function.",
+        "This test can be used to compare the comparator sort with the radix sort used by GraphicsDevice.drawArray."
+    ],
+    init: function () {
+        return comparatorSort.init();
+    },
+    run: function () {
+        return comparatorSort.run();
+    },
+    destroy: function () {
+        return comparatorSort.destroy();
+    },
+    targetMean: 0.00150,
+    version: 1.0
+});
+
+BF.register({
+    name: "RadixSort",
+    path: "scripts/benchmarks/turbulenz/js/draw_parameters_sort.js",
+    description: [
+        "Sorts an array of draw parameters by decreasing sortKey with the LSD radix sort used by GraphicsDevice.drawArray.",
+        "This test needs the WebGL GraphicsDevice."
+    ],
+    init: function () {
+        return radixSort.init();
+    },
+    run: function () {
+        return radixSort.run();
+    },
+    destroy: function () {
+        return radixSort.destroy();
+    },
+    targetMean: 0.00040,
+    version: 1.0
+});
@@ -0,0 +1,169 @@
+// Copyright (c) 2015 Turbulenz Limited
+
+/*global BF: false*/
+/*global LightGrid: false*/
+/*global TurbulenzEngine: false*/
+
+//
+//  Light grid binning: LightGrid packs the lights of the tiled deferred and
+//  clustered forward renderers into a float texture, a record per cell with
+//  the offset and count of its light list, the data of every light and then
+//  the light lists
+//
+
+//
+//  LightGridBinning: Bins 128 lights into the 16x8x16 clusters of a view,
+//  every light covering a box of up to 4x4x4 cells. The texture upload does
+//  nothing so only the binning is timed.
+//
+class LightGridBinning
+{
+    // Settings
+    numX = 16;
+    numY = 8;
+    numZ = 16;
+    numLights = 128;
+
+    mathDevice: any;
+    lightGrid: LightGrid;
+    viewMatrix: any;
+    lightInstances: any[];
+    ranges: Int32Array; // min and max x, y and z cell of each light
+
+    init()
+    {
+        var md = (TurbulenzEngine.getMathDevice() ||
+                  TurbulenzEngine.createMathDevice({}));
+        this.mathDevice = md;
+        this.viewMatrix = md.m43BuildTranslation(0, 0, -10);
+
+        var numX = this.numX;
+        var numY = this.numY;
+        var numZ = this.numZ;
+        var numLights = this.numLights;
+        this.lightGrid = this.createLightGrid((numX * numY * numZ), numLights);
+
+        var lightInstances = [];
+        var ranges = new Int32Array(numLights * 6);
+        var seed = 2468;
+        var random = function randomFn(n)
+        {
+            seed = ((seed * 1103515245) + 12345) & 0x7fffffff;
+            return (seed % n);
+        };
+        var l, r;
+        for (l = 0; l < numLights; l += 1)
+        {
+            lightInstances[l] = this.createLightInstance(random(64) - 32, random(64) - 32, random(64) - 32,
+                                                         l);
+            r = (l * 6);
+            ranges[r] = random(numX);
+            ranges[r + 1] = (ranges[r] + random(4));
+            ranges[r + 2] = random(numY);
+            ranges[r + 3] = (ranges[r + 2] + random(4));
+            ranges[r + 4] = random(numZ);
+            ranges[r + 5] = (ranges[r + 4] + random(4));
+        }
+        this.lightInstances = lightInstances;
+        this.ranges = ranges;
+    }
+
+    // Float textures are not needed to bin the lights
+    createLightGrid(maxCells: number, maxLights: number): LightGrid
+    {
+        var texture = {
+            setData: function setDataFn(data)
+            {
+            },
+            destroy: function destroyFn()
+            {
+            }
+        };
+        var gd: any = {
+            PIXELFORMAT_RGBA32F: 0,
+            isSupported: function isSupportedFn(name)
+            {
+                return (name === "TEXTURE_FLOAT");
+            },
+            createTexture: function createTextureFn(params)
+            {
+                return texture;
+            }
+        };
+        return LightGrid.create(gd, this.mathDevice, maxCells, maxLights);
+    }
+
+    createLightInstance(x: number, y: number, z: number, l: number): any
+    {
+        var md = this.mathDevice;
+        return {
+            node: {
+                world: md.m43BuildTranslation(x, y, z)
+            },
+            light: {
+                origin: null,
+                halfExtents: md.v3Build(5, 5, 5),
+                color: md.v3Build((l + 1), (l + 2), (l + 3))
+            }
+        };
+    }
+
+    run()
+    {
+        var lightGrid = this.lightGrid;
+        var viewMatrix = this.viewMatrix;
+        var lightInstances = this.lightInstances;
+        var ranges = this.ranges;
+        var numLights = this.numLights;
+        lightGrid.begin(this.numX, this.numY, this.numZ);
+        for (var l = 0; l < numLights; l += 1)
+        {
+            var r = (l * 6);
+            lightGrid.addLight(lightInstances[l], viewMatrix, 1.0);
+            lightGrid.setLightCells(l, ranges[r], ranges[r + 1], ranges[r + 2], ranges[r + 3],
+                                    ranges[r + 4], ranges[r + 5]);
+        }
+        lightGrid.end();
+    }
+
+    destroy()
+    {
+        this.lightGrid.destroy();
+        delete this.lightGrid;
+        delete this.lightInstances;
+        delete this.ranges;
+    }
+
+    // Constructor function
+    static create()
+    {
+        var b = new LightGridBinning();
+        b.mathDevice = null;
+        b.lightGrid = null;
+        b.viewMatrix = null;
+        b.lightInstances = null;
+        b.ranges = null;
+        return b;
+    }
+}
+
+var lightGridBinning = LightGridBinning.create();
+
+BF.register({
+    name: "LightGridBinning",
+    path: "scripts/benchmarks/turbulenz/js/light_grid_binning.js",
+    description: [
+        "Bins 128 lights into the 16x8x16 clusters of a view with LightGrid, each covering up to 4x4x4 cells."
+    ],
+    init: function () {
+        return lightGridBinning.init();
+    },
+    run: function () {
+        return lightGridBinning.run();
+    },
+    destroy: function () {
+        return lightGridBinning.destroy();
+    },
+    targetMean: 0.01000,
+    version: 1.0
+});
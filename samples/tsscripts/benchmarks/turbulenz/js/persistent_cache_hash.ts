@@ -0,0 +1,71 @@
+// Copyright (c) 2015 Turbulenz Limited
+
+/*global BF: false*/
+/*global PersistentCache: false*/
+
+//
+//  Persistent cache hash: PersistentCache.computeHash, the MD5 digest encoded
+//  as URL safe base64 that is compared with the hash in a content hashed URL
+//  before an entry is stored or used
+//
+
+//
+//  PersistentCacheHash: Hashes a buffer the size of a large asset
+//
+class PersistentCacheHash
+{
+    // Settings
+    n = 1048576; // Number of bytes to hash
+
+    data: Uint8Array;
+
+    init()
+    {
+        var n = this.n;
+        var data = new Uint8Array(n);
+        for (var i = 0; i < n; i += 1)
+        {
+            data[i] = (((i * 131) + 7) % 256);
+        }
+        this.data = data;
+    }
+
+    run()
+    {
+        PersistentCache.computeHash(this.data);
+    }
+
+    destroy()
+    {
+        delete this.data;
+    }
+
+    // Constructor function
+    static create()
+    {
+        var h = new PersistentCacheHash();
+        h.data = null;
+        return h;
+    }
+}
+
+var persistentCacheHash = PersistentCacheHash.create();
+
+BF.register({
+    name: "PersistentCacheHash",
+    path: "scripts/benchmarks/turbulenz/js/persistent_cache_hash.js",
+    description: [
+        "Computes the URL safe base64 MD5 hash of 1MB of data with PersistentCache.computeHash."
+    ],
+    init: function () {
+        return persistentCacheHash.init();
+    },
+    run: function () {
+        return persistentCacheHash.run();
+    },
+    destroy: function () {
+        return persistentCacheHash.destroy();
+    },
+    targetMean: 0.01000,
+    version: 1.0
+});
@@ -0,0 +1,137 @@
+// Copyright (c) 2015 Turbulenz Limited
+
+/*global BF: false*/
+/*global ShadowMapping: false*/
+
+//
+//  Shadow atlas allocator: ShadowMapping packs the shadow maps of all the
+//  lights into one atlas with a buddy allocator, every level splits a block
+//  of the level above in four and freeing the last of four buddies merges
+//  them back into their parent
+//
+
+//
+//  ShadowAtlasAllocator: Requests a seeded mix of map sizes from a 4096
+//  atlas until it is full and frees them in a shuffled order
+//
+class ShadowAtlasAllocator
+{
+    // Settings
+    atlasSize = 4096;   // Texels per side of the atlas
+    numLevels = 7;      // Down to 64x64 maps
+    n = 512;            // Number of allocations per run
+
+    allocator: any;
+    levels: number[];
+    blocks: number[];
+    order: number[];
+
+    init()
+    {
+        this.allocator = this.createAllocator();
+
+        // Mostly small maps, like lights far from the camera
+        var n = this.n;
+        var numLevels = this.numLevels;
+        var levels = [];
+        var order = [];
+        var seed = 4321;
+        var i, j, r;
+        for (i = 0; i < n; i += 1)
+        {
+            seed = ((seed * 1103515245) + 12345) & 0x7fffffff;
+            r = (seed / 0x80000000);
+            levels[i] = (numLevels - 1 - Math.floor(r * r * (numLevels - 1)));
+            order[i] = i;
+        }
+        for (i = (n - 1); i > 0; i -= 1)
+        {
+            seed = ((seed * 1103515245) + 12345) & 0x7fffffff;
+            j = (seed % (i + 1));
+            r = order[i];
+            order[i] = order[j];
+            order[j] = r;
+        }
+        this.levels = levels;
+        this.order = order;
+        this.blocks = [];
+    }
+
+    // Only the allocator state of ShadowMapping, no device resources
+    createAllocator()
+    {
+        var allocator = Object.create(ShadowMapping.prototype);
+        allocator.atlasSize = this.atlasSize;
+        var freeBlocks = [];
+        var numLevels = this.numLevels;
+        for (var level = 0; level < numLevels; level += 1)
+        {
+            freeBlocks[level] = [];
+        }
+        freeBlocks[0].push(0);
+        allocator.freeBlocks = freeBlocks;
+        return allocator;
+    }
+
+    run()
+    {
+        var allocator = this.allocator;
+        var levels = this.levels;
+        var blocks = this.blocks;
+        var order = this.order;
+        var n = this.n;
+        var i, j;
+        for (i = 0; i < n; i += 1)
+        {
+            blocks[i] = allocator._allocateBlock(levels[i]);
+        }
+        for (i = 0; i < n; i += 1)
+        {
+            j = order[i];
+            if (0 <= blocks[j])
+            {
+                allocator._freeBlock(blocks[j], levels[j]);
+            }
+        }
+    }
+
+    destroy()
+    {
+        delete this.allocator;
+        delete this.levels;
+        delete this.blocks;
+        delete this.order;
+    }
+
+    // Constructor function
+    static create()
+    {
+        var s = new ShadowAtlasAllocator();
+        s.allocator = null;
+        s.levels = null;
+        s.blocks = null;
+        s.order = null;
+        return s;
+    }
+}
+
+var shadowAtlasAllocator = ShadowAtlasAllocator.create();
+
+BF.register({
+    name: "ShadowAtlasAllocator",
+    path: "scripts/benchmarks/turbulenz/js/shadow_atlas_allocator.js",
+    description: [
+        "Requests 512 shadow maps of mixed sizes from a 4096 atlas with the ShadowMapping buddy allocator, until it is full, and frees them in a shuffled order."
+    ],
+    init: function () {
+        return shadowAtlasAllocator.init();
+    },
+    run: function () {
+        return shadowAtlasAllocator.run();
+    },
+    destroy: function () {
+        return shadowAtlasAllocator.destroy();
+    },
+    targetMean: 0.01000,
+    version: 1.0
+});
@@ -0,0 +1,126 @@
+// Copyright (c) 2015 Turbulenz Limited
+
+/*global BF: false*/
+/*global Scene: false*/
+
+//
+//  Static batch Morton sort: Scene sorts the instances of a static batch
+//  along a Morton curve of their centers, quantized to 10 bits per axis, so
+//  batches split by vertex count stay spatially compact
+//
+
+//
+//  MortonSortInstance: Only the world extents of a geometry instance are
+//  needed to sort it
+//
+class MortonSortInstance
+{
+    extents: Float32Array;
+
+    getWorldExtents(): Float32Array
+    {
+        return this.extents;
+    }
+
+    static create(x: number, y: number, z: number, halfSize: number): MortonSortInstance
+    {
+        var instance = new MortonSortInstance();
+        var extents = new Float32Array(6);
+        extents[0] = (x - halfSize);
+        extents[1] = (y - halfSize);
+        extents[2] = (z - halfSize);
+        extents[3] = (x + halfSize);
+        extents[4] = (y + halfSize);
+        extents[5] = (z + halfSize);
+        instance.extents = extents;
+        return instance;
+    }
+}
+
+//
+//  StaticBatchMortonSort: Sorts 4096 instances scattered over a level in a
+//  shuffled order
+//
+class StaticBatchMortonSort
+{
+    // Settings
+    n = 4096; // Number of instances to sort
+
+    scene: any;
+    source: MortonSortInstance[];
+    instances: MortonSortInstance[];
+
+    init()
+    {
+        // Only the sort is needed, not a whole scene
+        this.scene = Object.create(Scene.prototype);
+
+        var n = this.n;
+        var source = [];
+        var seed = 13579;
+        var random = function randomFn()
+        {
+            seed = ((seed * 1103515245) + 12345) & 0x7fffffff;
+            return (seed / 0x80000000);
+        };
+        for (var i = 0; i < n; i += 1)
+        {
+            source[i] = MortonSortInstance.create((random() * 2000) - 1000,
+                                                  (random() * 100),
+                                                  (random() * 2000) - 1000,
+                                                  (1 + (random() * 10)));
+        }
+        this.source = source;
+        this.instances = [];
+    }
+
+    run()
+    {
+        var source = this.source;
+        var instances = this.instances;
+        var n = this.n;
+        for (var i = 0; i < n; i += 1)
+        {
+            instances[i] = source[i];
+        }
+        this.scene._sortStaticBatchInstances(instances);
+    }
+
+    destroy()
+    {
+        delete this.scene;
+        delete this.source;
+        delete this.instances;
+    }
+
+    // Constructor function
+    static create()
+    {
+        var s = new StaticBatchMortonSort();
+        s.scene = null;
+        s.source = null;
+        s.instances = null;
+        return s;
+    }
+}
+
+var staticBatchMortonSort = StaticBatchMortonSort.create();
+
+BF.register({
+    name: "StaticBatchMortonSort",
+    path: "scripts/benchmarks/turbulenz/js/static_batch_morton_sort.js",
+    description: [
+        "Sorts 4096 geometry instances scattered over a level along a Morton curve of their centers, as Scene does for static batches."
+    ],
+    init: function () {
+        return staticBatchMortonSort.init();
+    },
+    run: function () {
+        return staticBatchMortonSort.run();
+    },
+    destroy: function () {
+        return staticBatchMortonSort.destroy();
+    },
+    targetMean: 0.01000,
+    version: 1.0
+});
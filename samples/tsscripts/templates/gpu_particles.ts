@@ -23,6 +23,7 @@
 /*{{ javascript("jslib/scenenode.js") }}*/
 /*{{ javascript("jslib/scene.js") }}*/
 /*{{ javascript("jslib/scenedebugging.js") }}*/
+/*{{ javascript("jslib/vertexbuffermanager.js") }}*/
 /*{{ javascript("jslib/renderingcommon.js") }}*/
 /*{{ javascript("jslib/forwardrendering.js") }}*/
 /*{{ javascript("jslib/particlesystem.js") }}*/
@@ -1,5 +1,12 @@
 /*{# Copyright (c) 2010-2012 Turbulenz Limited #}*/
 
+/*{{ javascript("jslib/persistentcache.js") }}*/
+/*{{ javascript("jslib/observer.js") }}*/
+/*{{ javascript("jslib/assetcache.js") }}*/
+/*{{ javascript("jslib/shadowmapping.js") }}*/
+/*{{ javascript("jslib/renderingcommon.js") }}*/
+/*{{ javascript("jslib/scene.js") }}*/
+
 /*global TurbulenzEngine: true */
 /*global BF: true*/
 /*global params: true*/
@@ -14,11 +21,11 @@ TurbulenzEngine.onload = function onloadFn()
 
     BF.setTZ(TurbulenzEngine);
 
-    var benchmarkVersion = 1.3;
+    var benchmarkVersion = 1.4;
     // Marks the version of the benchmark to be run. This value is not directly related to the versions of the tests,
     // but should indicate which test version is being used:
     //
-    // Benchmark Version (1.3)
+    // Benchmark Version (1.4)
     // =======================
     //
     // passing_params:
@@ -49,6 +56,25 @@ TurbulenzEngine.onload = function onloadFn()
     // recursive_iterative:
     // * Recursive:             1.0
     // * Iterative:             1.0
+    //
+    // draw_parameters_sort:
+    // * ComparatorSort:        1.0
+    // * RadixSort:             1.0
+    //
+    // persistent_cache_hash:
+    // * PersistentCacheHash:   1.0
+    //
+    // asset_cache_lru:
+    // * AssetCacheLRU:         1.0
+    //
+    // shadow_atlas_allocator:
+    // * ShadowAtlasAllocator:  1.0
+    //
+    // light_grid_binning:
+    // * LightGridBinning:      1.0
+    //
+    // static_batch_morton_sort:
+    // * StaticBatchMortonSort: 1.0
 
     window.$('#version').append('(Version ' + benchmarkVersion + ')');
 
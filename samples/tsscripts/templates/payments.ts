@@ -16,6 +16,7 @@
 /*{{ javascript("jslib/services/gamesession.js") }}*/
 /*{{ javascript("jslib/services/mappingtable.js") }}*/
 /*{{ javascript("jslib/shadermanager.js") }}*/
+/*{{ javascript("jslib/vertexbuffermanager.js") }}*/
 /*{{ javascript("jslib/draw2d.js") }}*/
 /*{{ javascript("jslib/fontmanager.js") }}*/
 
@@ -19,8 +19,10 @@
 /*{{ javascript("jslib/services/mappingtable.js") }}*/
 /*{{ javascript("jslib/shadermanager.js") }}*/
 /*{{ javascript("jslib/physics2ddevice.js") }}*/
+/*{{ javascript("jslib/vertexbuffermanager.js") }}*/
 /*{{ javascript("jslib/draw2d.js") }}*/
 /*{{ javascript("jslib/boxtree.js") }}*/
+/*{{ javascript("jslib/indexbuffermanager.js") }}*/
 /*{{ javascript("jslib/physics2ddebugdraw.js") }}*/
 /*{{ javascript("jslib/textureeffects.js") }}*/
 /*{{ javascript("scripts/htmlcontrols.js") }}*/
@@ -13,8 +13,10 @@ from hashlib import md5
 from base64 import urlsafe_b64encode
 from subprocess import Popen, PIPE, STDOUT
 from platform import system, machine
-from threading import Thread, Lock
-from time import sleep
+from threading import Thread, Condition
+from multiprocessing.pool import ThreadPool
+from heapq import heappush, heappop
+from time import time
 import multiprocessing
 import argparse
 import errno
@@ -98,7 +100,6 @@ class Source(object):
             self.hash = self.calculate_hash()
             self.hash_checked = True
             self.changed = True
-        self.built = False
 
     def has_changed(self):
         if self.hash_checked:
@@ -170,10 +171,10 @@ class Tool(object):
             error('command %s failed\n%s' % (' '.join(e.cmd), e.output))
             raise
 
-# pylint: disable=R0201
-    def check_external_deps(self, src, dst, args):
-        return False
-# pylint: enable=R0201
+# pylint: disable=R0201,W0613
+    def get_external_deps(self, src, args):
+        return []
+# pylint: enable=R0201,W0613
 
 class CopyTool(object):
     def __init__(self, name='copy', path=None):
@@ -195,8 +196,8 @@ class CopyTool(object):
         return False
 
     @staticmethod
-    def check_external_deps(src, dst, args):
-        return False
+    def get_external_deps(src, args):
+        return []
 
 class Tga2Json(Tool):
     def get_version(self, version_file_path):
@@ -279,19 +280,25 @@ class Cgfx2JsonTool(Tool):
             print "CMD: %s" % " ".join(cmd)
         return self.run_sh(cmd, verbose=verbose)
 
-    def check_external_deps(self, src, dst, args):
+    def get_external_deps(self, src, args):
         cmd = [self.path, '-i', src, '-M']
         try:
             dep_files = sh(cmd, verbose=False)
         except CalledProcessError as e:
             error('deps command %s failed ignoring external deps\n%s' % (' '.join(e.cmd), e.output))
-            return False
+            return []
         if not dep_files:
-            return False
-        dst_mtime = getmtime(dst)
-        for filename in dep_files.replace('\r\n', '\n').split('\n'):
-            if getmtime(filename) > dst_mtime:
-                return True
+            return []
+        return [f for f in dep_files.replace('\r\n', '\n').split('\n') if f]
+
+def check_external_deps(dep_files, dst):
+    if not dep_files:
+        return False
+    dst_mtime = getmtime(dst)
+    for filename in dep_files:
+        if not path_exists(filename) or getmtime(filename) > dst_mtime:
+            return True
+    return False
 
 
 class Tools(object):
@@ -427,7 +434,7 @@ def build_asset(tool, asset_path, dst_path, verbose, args):
         raise
 
 
-def check_and_build_asset(asset_info, source_list, tools, build_path, verbose):
+def check_and_build_asset(asset_info, source_list, tools, build_path, verbose, external_deps=None):
     src = asset_info.path
 
     asset_tool = tools.get_asset_tool(src)
@@ -440,20 +447,282 @@ def check_and_build_asset(asset_info, source_list, tools, build_path, verbose):
     source = source_list.get_source(src)
     deps = [source_list.get_source(path) for path in asset_info.deps]
     if any([dep.has_changed() for dep in deps]) or asset_tool.has_changed() or not path_exists(dst_path) \
-            or asset_tool.check_external_deps(source.asset_path, dst_path, asset_info.args):
+            or check_external_deps(external_deps, dst_path):
         stdout.write('[%s] %s\n' % (asset_tool.name.upper(), src))
-        # asset_tool.run(source.asset_path, dst_path, verbose, asset_info.args)
         build_asset(asset_tool,
                     source.asset_path,
                     dst_path,
                     verbose,
                     asset_info.args)
-        source.built = True
         return True
     else:
-        source.built = True
         return False
 
+
+def get_material_references(material_path):
+    # Every string value in a material file is a candidate reference, effects and textures are resolved against
+    # the assets in the graph so anything else is ignored
+    try:
+        with open(material_path, 'r') as f:
+            material = load_yaml(f.read())
+    except (IOError, ValueError):
+        return []
+    references = []
+    pending = [material]
+    while pending:
+        value = pending.pop()
+        if isinstance(value, dict):
+            pending.extend(value.itervalues())
+        elif isinstance(value, list):
+            pending.extend(value)
+        elif isinstance(value, basestring):
+            references.append(normpath(value))
+    return references
+
+class AssetJob(object):
+    def __init__(self, index, asset_info, tool):
+        self.index = index
+        self.asset_info = asset_info
+        self.path = asset_info.path
+        self.tool = tool
+        self.deps = set()
+        self.dependants = set()
+        self.external_deps = []
+        self.num_pending = 0
+        self.estimate = 0.0
+        self.priority = 0.0
+        self.worker = None
+        self.start = None
+        self.end = None
+        self.rebuilt = False
+
+    def duration(self):
+        if self.start is None or self.end is None:
+            return 0.0
+        return self.end - self.start
+
+class AssetJobGraph(object):
+    """Dependency graph of the asset builds.
+
+    Edges come from the deps listed in deps.yaml, from the files reported by the tools -M option and from the
+    effects and textures referenced by materials. Jobs are prioritized by the longest estimated path to the end of
+    the build, using the durations recorded in the previous build trace."""
+
+    def __init__(self, asset_build_info, source_list, tools, num_threads):
+        self.jobs = [AssetJob(n, a, tools.get_asset_tool(a.path)) for (n, a) in enumerate(asset_build_info)]
+        self.order = None
+
+        jobs_by_path = {}
+        jobs_by_file = {}
+        for job in self.jobs:
+            jobs_by_path[job.path] = job
+            jobs_by_file[normpath(source_list.get_source(job.path).asset_path)] = job
+            # Ensure all sources are in the source list so that the threads aren't writing to the list
+            for dep in job.asset_info.deps:
+                source_list.get_source(dep)
+
+        def get_external_deps(job):
+            source = source_list.get_source(job.path)
+            return job.tool.get_external_deps(source.asset_path, job.asset_info.args)
+
+        pool = ThreadPool(max(1, num_threads))
+        try:
+            external_deps = pool.map(get_external_deps, self.jobs)
+        finally:
+            pool.close()
+            pool.join()
+
+        for (job, job_external_deps) in zip(self.jobs, external_deps):
+            job.external_deps = job_external_deps
+            for path in job.asset_info.deps:
+                self._add_edge(jobs_by_path.get(path), job)
+            for filename in job_external_deps:
+                self._add_edge(jobs_by_file.get(normpath(filename)), job)
+            if splitext(job.path)[1] == '.material':
+                for path in get_material_references(source_list.get_source(job.path).asset_path):
+                    self._add_edge(jobs_by_path.get(path), job)
+
+    @staticmethod
+    def _add_edge(dep, job):
+        if dep is not None and dep is not job and dep not in job.deps:
+            job.deps.add(dep)
+            dep.dependants.add(job)
+
+    def sort(self):
+        # Kahn's algorithm, in the order the assets are listed for stable builds
+        num_pending = dict((job, len(job.deps)) for job in self.jobs)
+        order = [job for job in self.jobs if not job.deps]
+        n = 0
+        while n < len(order):
+            for dependant in sorted(order[n].dependants, key=lambda j: j.index):
+                num_pending[dependant] -= 1
+                if num_pending[dependant] == 0:
+                    order.append(dependant)
+            n += 1
+        if len(order) != len(self.jobs):
+            return [job for job in self.jobs if num_pending[job] > 0]
+        self.order = order
+        return None
+
+    def prioritize(self, estimates):
+        for job in reversed(self.order):
+            job.estimate = estimates.get(job.path, 1.0)
+            job.priority = job.estimate + max([d.priority for d in job.dependants] or [0.0])
+
+    def get_critical_path(self):
+        # Longest chain of measured durations through the dependency edges
+        finish = {}
+        previous = {}
+        for job in self.order:
+            longest_dep = None
+            for dep in job.deps:
+                if longest_dep is None or finish[dep] > finish[longest_dep]:
+                    longest_dep = dep
+            previous[job] = longest_dep
+            finish[job] = job.duration() + (finish[longest_dep] if longest_dep is not None else 0.0)
+        if not finish:
+            return []
+        job = max(self.order, key=lambda j: finish[j])
+        path = []
+        while job is not None:
+            path.append(job)
+            job = previous[job]
+        path.reverse()
+        return path
+
+class AssetJobScheduler(object):
+    """Runs the jobs of a sorted AssetJobGraph on a bounded pool of worker threads.
+
+    Each worker runs one tool process at a time and picks the ready job with the highest priority. After an error
+    no new jobs are started and the jobs already running are allowed to finish."""
+
+    def __init__(self, graph, num_threads, build_job):
+        self.graph = graph
+        self.num_threads = max(1, num_threads)
+        self.build_job = build_job
+        self.condition = Condition()
+        self.ready = []
+        self.num_finished = 0
+        self.assets_rebuilt = 0
+        self.error = None
+
+    def _push_ready(self, job):
+        heappush(self.ready, (-job.priority, job.index, job))
+
+    def _worker(self, worker_id):
+        condition = self.condition
+        num_jobs = len(self.graph.jobs)
+        while True:
+            condition.acquire()
+            try:
+                while not self.ready and self.error is None and self.num_finished < num_jobs:
+                    condition.wait()
+                if self.error is not None or not self.ready:
+                    return
+                job = heappop(self.ready)[2]
+            finally:
+                condition.release()
+
+            job.worker = worker_id
+            job.start = time()
+            job_error = None
+            try:
+                job.rebuilt = self.build_job(job)
+            except CalledProcessError as e:
+                job_error = '%s - Tool failed - %s' % (job.path, str(e))
+            except IOError as e:
+                job_error = str(e)
+            job.end = time()
+
+            condition.acquire()
+            try:
+                if job_error is not None:
+                    if self.error is None:
+                        self.error = job_error
+                else:
+                    self.num_finished += 1
+                    if job.rebuilt:
+                        self.assets_rebuilt += 1
+                    for dependant in job.dependants:
+                        dependant.num_pending -= 1
+                        if dependant.num_pending == 0:
+                            self._push_ready(dependant)
+                condition.notifyAll()
+            finally:
+                condition.release()
+
+    def run(self):
+        for job in self.graph.jobs:
+            job.num_pending = len(job.deps)
+            if job.num_pending == 0:
+                self._push_ready(job)
+
+        threads = []
+        for t in xrange(self.num_threads):
+            thread = Thread(target=self._worker, args=(t,))
+            thread.daemon = True
+            threads.append(thread)
+            thread.start()
+
+        while any(t.isAlive() for t in threads):
+            for t in threads:
+                t.join(0.1)
+
+        return self.error is None
+
+def load_build_estimates(trace_path):
+    try:
+        with open(trace_path, 'r') as f:
+            trace = load_json(f.read())
+    except (IOError, ValueError):
+        return {}
+    estimates = {}
+    for event in trace.get('traceEvents', []):
+        if event.get('ph') == 'X' and event.get('cat') != 'critical':
+            estimates[event['name']] = event['dur'] * 1e-6
+    return estimates
+
+def write_build_trace(trace_path, graph, num_threads, build_start, build_end):
+    """Write the build in the Chrome trace event format, loadable in chrome://tracing."""
+    critical_path = graph.get_critical_path()
+    critical_tid = num_threads
+    events = [{'name': 'process_name', 'ph': 'M', 'pid': 0, 'args': {'name': 'buildassets'}},
+              {'name': 'thread_name', 'ph': 'M', 'pid': 0, 'tid': critical_tid, 'args': {'name': 'critical path'}}]
+    for t in xrange(num_threads):
+        events.append({'name': 'thread_name', 'ph': 'M', 'pid': 0, 'tid': t, 'args': {'name': 'worker %d' % t}})
+
+    def job_event(job, cat, tid):
+        return {'name': job.path,
+                'cat': cat,
+                'ph': 'X',
+                'pid': 0,
+                'tid': tid,
+                'ts': int((job.start - build_start) * 1e6),
+                'dur': int(job.duration() * 1e6),
+                'args': {'tool': job.tool.name,
+                         'rebuilt': job.rebuilt,
+                         'deps': sorted(d.path for d in job.deps)}}
+
+    for job in graph.jobs:
+        if job.start is not None and job.end is not None:
+            events.append(job_event(job, job.tool.name, job.worker))
+    for job in critical_path:
+        if job.start is not None and job.end is not None:
+            events.append(job_event(job, 'critical', critical_tid))
+
+    total_duration = sum(job.duration() for job in graph.jobs)
+    critical_duration = sum(job.duration() for job in critical_path)
+    with open(trace_path, 'w') as f:
+        f.write(dump_json({'traceEvents': events,
+                           'displayTimeUnit': 'ms',
+                           'otherData': {'threads': num_threads,
+                                         'wallTime': build_end - build_start,
+                                         'toolTime': total_duration,
+                                         'criticalPath': [job.path for job in critical_path],
+                                         'criticalPathTime': critical_duration}}))
+
+    return (total_duration, critical_path, critical_duration)
+
 def install(install_asset_info, install_path):
     old_install_files = listdir(install_path)
     mapping = {}
@@ -490,6 +759,7 @@ def remove_old_build_files(build_asset_info, build_path):
     old_build_files = []
     exludes = [
         path_join(build_path, 'sourcehashes.json'),
+        path_join(build_path, 'buildtrace.json'),
         path_join(build_path, 'cgfx2json.version'),
         path_join(build_path, 'json2json.version'),
         path_join(build_path, 'obj2json.version'),
@@ -542,8 +812,10 @@ def main():
         default_num_threads = multiprocessing.cpu_count()
     except NotImplementedError:
         default_num_threads = 1
-    parser.add_argument('-j', '--num-threads', help="Specify how many threads to use for building",
+    parser.add_argument('-j', '--num-threads', help="Specify how many tool processes to run in parallel",
                         default=default_num_threads, type=int)
+    parser.add_argument('--trace', help="Path to write the Chrome trace of the build to "
+                                        "(defaults to buildtrace.json in the build path)")
 
     args = parser.parse_args(argv[1:])
 
@@ -569,107 +841,48 @@ def main():
             print 'No source hash file'
         source_list = SourceList({}, assets_paths)
 
-    # Ensure all sources are in the source list so that the threads aren't writing to the list
-    for a in asset_build_info:
-        source_list.get_source(a.path)
-
-    class AssetBuildThread(Thread):
-        def __init__(self, asset_list, asset_list_mutex):
-            Thread.__init__(self)
-            self.asset_list = asset_list
-            self.mutex = asset_list_mutex
-            self.assets_rebuilt = 0
-            self.exit = False
-            self.error = None
-
-        def run(self):
-            while True:
-                if self.exit:
-                    return 0
-                self.mutex.acquire(True)
-                try:
-                    # Try and pull the head off the list and if all it's dependencies are already built then
-                    # build it. This could iterate down the remaining list in case the head isn't buildable but
-                    # things later in the list are
-                    asset_info = self.asset_list[0]
-                    deps = [source_list.get_source(path) for path in asset_info.deps if path != asset_info.path]
-                    if any([not d.built for d in deps]):
-                        self.mutex.release()
-                        sleep(0.01)
-                        continue
-                    self.asset_list.pop(0)
-                    self.mutex.release()
-                except IndexError:
-                    self.mutex.release()
-                    return 0
-                try:
-                    rebuild = check_and_build_asset(asset_info,
-                                                    source_list,
-                                                    tools,
-                                                    base_build_path,
-                                                    args.verbose)
-                except CalledProcessError as e:
-                    self.error = '%s - Tool failed - %s' % (asset_info.path, str(e))
-                    return 1
-                except IOError as e:
-                    self.error = str(e)
-                    return 1
-
-                if rebuild:
-                    self.assets_rebuilt += 1
-
-    num_threads = args.num_threads
-
-    # Sort assets by dependencies
-    assets_to_build = []
-    while len(assets_to_build) != len(asset_build_info):
-        num_assets_sorted = len(assets_to_build)
-        for asset in asset_build_info:
-            if asset in assets_to_build:
-                continue
-            for dep in asset.deps:
-                if dep != asset.path and dep not in [a.path for a in assets_to_build]:
-                    break
-            else:
-                assets_to_build.append(asset)
-        if num_assets_sorted == len(assets_to_build):
-            assets_left = [a for a in asset_build_info if a not in assets_to_build]
-            error('Detected cyclic dependencies between assets within - \n%s' %
-                  '\n'.join([a.path for a in assets_left]))
-            return 1
-
-
-    # Create and start threads to build the assets in the sorted dependency list
-    asset_threads = []
-    asset_list_mutex = Lock()
-    for t in xrange(num_threads):
-        asset_threads.append(AssetBuildThread(assets_to_build, asset_list_mutex))
-
-    for t in xrange(num_threads):
-        asset_threads[t].start()
-
-    while any(a.isAlive() for a in asset_threads):
-        for t in xrange(num_threads):
-            asset_threads[t].join(0.1)
-            if not asset_threads[t].isAlive() and asset_threads[t].error:
-                # One thread has an error ask all the others to finish asap
-                for o in xrange(num_threads):
-                    asset_threads[o].exit = True
-
-    # Update the stats on number of assets rebuilt
-    assets_rebuilt = 0
-    for t in xrange(num_threads):
-        assets_rebuilt += asset_threads[t].assets_rebuilt
+    trace_path = args.trace or path_join(base_build_path, 'buildtrace.json')
+    num_threads = max(1, args.num_threads)
+
+    graph = AssetJobGraph(asset_build_info, source_list, tools, num_threads)
+    cyclic_jobs = graph.sort()
+    if cyclic_jobs:
+        error('Detected cyclic dependencies between assets within - \n%s' %
+              '\n'.join([job.path for job in cyclic_jobs]))
+        return 1
+    graph.prioritize(load_build_estimates(trace_path))
+
+    def build_job(job):
+        return check_and_build_asset(job.asset_info,
+                                     source_list,
+                                     tools,
+                                     base_build_path,
+                                     args.verbose,
+                                     job.external_deps)
+
+    # Build the assets on a pool of threads, each running one tool process at a time as soon as its dependencies
+    # have been built
+    scheduler = AssetJobScheduler(graph, num_threads, build_job)
+    build_start = time()
+    build_succeeded = scheduler.run()
+    build_end = time()
+    assets_rebuilt = scheduler.assets_rebuilt
+
+    (tool_time, critical_path, critical_time) = \
+        write_build_trace(trace_path, graph, num_threads, build_start, build_end)
+    if args.verbose:
+        print 'Build took %.2fs with %d threads, %.2fs of tool time, critical path %.2fs through %d assets' % \
+            (build_end - build_start, num_threads, tool_time, critical_time, len(critical_path))
+        print 'Build trace written to ' + trace_path
 
     # Dump the state of the build for partial rebuilds
     with open(path_join(base_build_path, 'sourcehashes.json'), 'w') as f:
         f.write(dump_json(source_list.get_hashes()))
 
-    # Check if any build threads failed and if so exit with an error
-    for t in xrange(num_threads):
-        if asset_threads[t].error:
-            error(asset_threads[t].error)
-            return 1
+    # Check if any build failed and if so exit with an error
+    if not build_succeeded:
+        error(scheduler.error)
+        return 1
 
     # Dump the mapping table for the built assets
     print 'Installing assets and building mapping table...'
@@ -0,0 +1,569 @@
+// Copyright (c) 2015 Turbulenz Limited
+
+#include "../common/jsonreader.h"
+#include "../common/jsonwriter.h"
+#include "image.h"
+#include "rectpacker.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <set>
+
+#define VERSION_STRING "atlaspack 0.1"
+
+static bool sVerbose = false;
+
+void ErrorMessage(const char *message, ...);
+
+struct Sprite
+{
+    std::string name;
+    std::string fileName;
+    Image       image;
+    PackedRect  rect;
+};
+
+// Larger sprites first, the offline packer fills gaps with the smaller ones
+static bool CompareSpriteSize(const Sprite *a, const Sprite *b)
+{
+    const unsigned aSide = std::max(a->image.GetWidth(), a->image.GetHeight());
+    const unsigned bSide = std::max(b->image.GetWidth(), b->image.GetHeight());
+    if (aSide != bSide)
+    {
+        return (aSide > bSide);
+    }
+    const unsigned aArea = (a->image.GetWidth() * a->image.GetHeight());
+    const unsigned bArea = (b->image.GetWidth() * b->image.GetHeight());
+    if (aArea != bArea)
+    {
+        return (aArea > bArea);
+    }
+    return (a->name < b->name);
+}
+
+static std::string SpriteName(const std::string &fileName)
+{
+    std::string name(fileName);
+    const size_t slash = name.find_last_of("/\\");
+    if (std::string::npos != slash)
+    {
+        name.erase(0, (slash + 1));
+    }
+    const size_t dot = name.rfind('.');
+    if (std::string::npos != dot)
+    {
+        name.erase(dot);
+    }
+    return name;
+}
+
+static std::string BaseName(const std::string &fileName)
+{
+    const size_t slash = fileName.find_last_of("/\\");
+    if (std::string::npos != slash)
+    {
+        return fileName.substr(slash + 1);
+    }
+    return fileName;
+}
+
+static std::string PageFileName(const char *outputFileName, size_t page, const char *extension)
+{
+    std::string pageFileName(outputFileName);
+    const size_t dot = pageFileName.rfind('.');
+    const size_t slash = pageFileName.find_last_of("/\\");
+    if (std::string::npos != dot &&
+        (std::string::npos == slash || dot > slash))
+    {
+        pageFileName.erase(dot);
+    }
+    char suffix[32];
+    sprintf(suffix, "_%u.", (unsigned)page);
+    pageFileName += suffix;
+    pageFileName += extension;
+    return pageFileName;
+}
+
+// Copies the sprite into the page and repeats its border pixels outwards
+static void BlitSprite(Image &page, const Sprite &sprite, unsigned extrude)
+{
+    const Image &image = sprite.image;
+    const int width = (int)image.GetWidth();
+    const int height = (int)image.GetHeight();
+    const int x0 = (int)(sprite.rect.x + extrude);
+    const int y0 = (int)(sprite.rect.y + extrude);
+    const int e = (int)extrude;
+    for (int y = -e; y < (height + e); y++)
+    {
+        const int sy = ((y < 0) ? 0 : ((y >= height) ? (height - 1) : y));
+        for (int x = -e; x < (width + e); x++)
+        {
+            const int sx = ((x < 0) ? 0 : ((x >= width) ? (width - 1) : x));
+            memcpy(page.GetPixel((unsigned)(x0 + x), (unsigned)(y0 + y)),
+                   image.GetPixel((unsigned)sx, (unsigned)sy), 4);
+        }
+    }
+}
+
+// Packs the sprites in the given order into bins growing up to maxSize
+static bool PackSpritesOnline(std::vector<Sprite *> &order,
+                              unsigned maxSize,
+                              unsigned border,
+                              std::vector<PackedRect> &bins)
+{
+    OnlineTexturePacker packer(maxSize, maxSize);
+    for (size_t n = 0; n < order.size(); n++)
+    {
+        Sprite &sprite = *order[n];
+        if (!packer.Pack((sprite.image.GetWidth() + border),
+                         (sprite.image.GetHeight() + border),
+                         sprite.rect))
+        {
+            ErrorMessage("Sprite %s is larger than the maximum page size", sprite.fileName.c_str());
+            return false;
+        }
+    }
+
+    for (size_t n = 0; n < packer.GetNumBins(); n++)
+    {
+        bins.push_back(packer.GetBin(n));
+    }
+    return true;
+}
+
+static size_t PackPage(std::vector<Sprite *> &order,
+                       size_t first,
+                       unsigned width,
+                       unsigned height,
+                       unsigned bin,
+                       unsigned border,
+                       bool partial,
+                       PackedRect &used)
+{
+    MaxRectsPacker packer(width, height, bin);
+    size_t numPacked = 0;
+    for (size_t n = first; n < order.size(); n++)
+    {
+        Sprite &sprite = *order[n];
+        if (packer.Pack((sprite.image.GetWidth() + border),
+                        (sprite.image.GetHeight() + border),
+                        sprite.rect))
+        {
+            // Keep the packed sprites together at the front of the pending ones
+            std::swap(order[first + numPacked], order[n]);
+            numPacked++;
+        }
+        else if (!partial)
+        {
+            return 0;
+        }
+    }
+    used.x = 0;
+    used.y = 0;
+    used.w = packer.GetUsedWidth();
+    used.h = packer.GetUsedHeight();
+    used.bin = bin;
+    return numPacked;
+}
+
+// Packs every page into the smallest power of 2 size that holds all the
+// remaining sprites, filling pages of maxSize when they do not fit
+static bool PackSpritesOffline(std::vector<Sprite *> &order,
+                               unsigned maxSize,
+                               unsigned border,
+                               std::vector<PackedRect> &bins)
+{
+    for (size_t n = 0; n < order.size(); n++)
+    {
+        const Sprite &sprite = *order[n];
+        if ((sprite.image.GetWidth() + border) > maxSize ||
+            (sprite.image.GetHeight() + border) > maxSize)
+        {
+            ErrorMessage("Sprite %s is larger than the maximum page size", sprite.fileName.c_str());
+            return false;
+        }
+    }
+
+    size_t first = 0;
+    while (first < order.size())
+    {
+        const unsigned bin = (unsigned)bins.size();
+        unsigned width = 1;
+        unsigned height = 1;
+        size_t area = 0;
+        for (size_t n = first; n < order.size(); n++)
+        {
+            const unsigned w = (order[n]->image.GetWidth() + border);
+            const unsigned h = (order[n]->image.GetHeight() + border);
+            width = std::max(width, NearPow2Geq(w));
+            height = std::max(height, NearPow2Geq(h));
+            area += ((size_t)w * h);
+        }
+
+        PackedRect used;
+        size_t numPacked = 0;
+        for (;;)
+        {
+            if (((size_t)width * height) >= area)
+            {
+                // Failed attempts reorder the pending sprites
+                std::sort((order.begin() + first), order.end(), CompareSpriteSize);
+                numPacked = PackPage(order, first, width, height, bin, border, false, used);
+                if (0 < numPacked)
+                {
+                    break;
+                }
+            }
+
+            if (width == maxSize && height == maxSize)
+            {
+                std::sort((order.begin() + first), order.end(), CompareSpriteSize);
+                numPacked = PackPage(order, first, width, height, bin, border, true, used);
+                break;
+            }
+
+            if (width <= height && width < maxSize)
+            {
+                width *= 2;
+            }
+            else
+            {
+                height *= 2;
+            }
+        }
+
+        used.w = width;
+        used.h = height;
+        bins.push_back(used);
+        first += numPacked;
+    }
+    return true;
+}
+
+void ErrorMessage(const char *message, ...)
+{
+    va_list args;
+    va_start(args, message);
+    fputs("ERROR: ", stderr);
+    vfprintf(stderr, message, args);
+    fputc('\n', stderr);
+    va_end(args);
+}
+
+static bool ReadList(const char *fileName, std::vector<std::string> &fileNames)
+{
+    FILE *f = fopen(fileName, "r");
+    if (NULL == f)
+    {
+        return false;
+    }
+    char line[4096];
+    while (NULL != fgets(line, sizeof(line), f))
+    {
+        std::string entry(line);
+        while (!entry.empty() &&
+               ('\n' == entry[entry.size() - 1] ||
+                '\r' == entry[entry.size() - 1] ||
+                ' ' == entry[entry.size() - 1]))
+        {
+            entry.erase(entry.size() - 1);
+        }
+        if (!entry.empty() && '#' != entry[0])
+        {
+            fileNames.push_back(entry);
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+static void Usage()
+{
+    puts(VERSION_STRING);
+    puts("Usage: atlaspack [options] -o <atlas.json> <image> [<image> ...]");
+    puts("");
+    puts("Packs PNG and TGA images into power of 2 atlas pages and writes a JSON");
+    puts("map of the texture rectangle of every sprite, usable as Draw2DSprite");
+    puts("parameters.");
+    puts("");
+    puts("  -o, --output=FILE       output JSON file, pages are written next to it");
+    puts("  -l, --list=FILE         text file with one input image per line");
+    puts("  -s, --max_size=N        maximum page width and height, a power of 2 (default 2048)");
+    puts("  -p, --padding=N         empty pixels between sprites (default 2)");
+    puts("  -e, --extrude=N         border pixels repeated around every sprite (default 1)");
+    puts("  --online                pack in input order with the runtime OnlineTexturePacker algorithm");
+    puts("  --tga                   write TGA pages instead of PNG");
+    puts("  -j, --json_indent=N     indentation step for the JSON output (default 0)");
+    puts("  -v, --verbose           print information about every page");
+    puts("  -h, --help              show this message");
+    puts("  --version               show the version");
+}
+
+static bool GetOption(int argc, char **argv, int &argn,
+                      const char *shortName, const char *longName,
+                      const char *&value)
+{
+    const char *arg = argv[argn];
+    if (NULL != shortName && 0 == strcmp(arg, shortName))
+    {
+        argn++;
+        if (argn >= argc)
+        {
+            ErrorMessage("Missing value for %s", shortName);
+            exit(1);
+        }
+        value = argv[argn];
+        return true;
+    }
+
+    const size_t longLength = strlen(longName);
+    if (0 == strncmp(arg, longName, longLength) && '=' == arg[longLength])
+    {
+        value = (arg + longLength + 1);
+        return true;
+    }
+    return false;
+}
+
+int main(int argc, char **argv)
+{
+    const char *outputFileName = NULL;
+    std::vector<std::string> inputFileNames;
+    unsigned maxSize = 2048;
+    unsigned padding = 2;
+    unsigned extrude = 1;
+    bool online = false;
+    bool tga = false;
+    int indentationStep = 0;
+
+    for (int argn = 1; argn < argc; argn++)
+    {
+        const char *value = NULL;
+        if (GetOption(argc, argv, argn, "-o", "--output", value))
+        {
+            outputFileName = value;
+        }
+        else if (GetOption(argc, argv, argn, "-l", "--list", value))
+        {
+            if (!ReadList(value, inputFileNames))
+            {
+                ErrorMessage("Failed to read %s", value);
+                return 1;
+            }
+        }
+        else if (GetOption(argc, argv, argn, "-s", "--max_size", value))
+        {
+            maxSize = (unsigned)atoi(value);
+        }
+        else if (GetOption(argc, argv, argn, "-p", "--padding", value))
+        {
+            padding = (unsigned)atoi(value);
+        }
+        else if (GetOption(argc, argv, argn, "-e", "--extrude", value))
+        {
+            extrude = (unsigned)atoi(value);
+        }
+        else if (GetOption(argc, argv, argn, "-j", "--json_indent", value))
+        {
+            indentationStep = atoi(value);
+        }
+        else if (0 == strcmp(argv[argn], "--online"))
+        {
+            online = true;
+        }
+        else if (0 == strcmp(argv[argn], "--tga"))
+        {
+            tga = true;
+        }
+        else if (0 == strcmp(argv[argn], "-v") ||
+                 0 == strcmp(argv[argn], "--verbose"))
+        {
+            sVerbose = true;
+        }
+        else if (0 == strcmp(argv[argn], "-h") ||
+                 0 == strcmp(argv[argn], "--help"))
+        {
+            Usage();
+            return 0;
+        }
+        else if (0 == strcmp(argv[argn], "--version"))
+        {
+            puts(VERSION_STRING);
+            return 0;
+        }
+        else if ('-' == argv[argn][0])
+        {
+            ErrorMessage("Unknown option %s", argv[argn]);
+            Usage();
+            return 1;
+        }
+        else
+        {
+            inputFileNames.push_back(argv[argn]);
+        }
+    }
+
+    if (NULL == outputFileName || inputFileNames.empty())
+    {
+        Usage();
+        return 1;
+    }
+
+    if (0 == maxSize || maxSize != NearPow2Geq(maxSize))
+    {
+        ErrorMessage("The maximum page size must be a power of 2");
+        return 1;
+    }
+
+    std::vector<Sprite> sprites(inputFileNames.size());
+    std::set<std::string> names;
+    for (size_t n = 0; n < inputFileNames.size(); n++)
+    {
+        Sprite &sprite = sprites[n];
+        sprite.fileName = inputFileNames[n];
+        sprite.name = SpriteName(sprite.fileName);
+        if (!names.insert(sprite.name).second)
+        {
+            ErrorMessage("Duplicated sprite name %s (%s)", sprite.name.c_str(), sprite.fileName.c_str());
+            return 1;
+        }
+
+        std::string error;
+        if (!sprite.image.Load(sprite.fileName.c_str(), error))
+        {
+            ErrorMessage("%s: %s", sprite.fileName.c_str(), error.c_str());
+            return 1;
+        }
+    }
+
+    std::vector<Sprite *> order(sprites.size());
+    for (size_t n = 0; n < sprites.size(); n++)
+    {
+        order[n] = &sprites[n];
+    }
+
+    const unsigned border = ((2 * extrude) + padding);
+    std::vector<PackedRect> bins;
+    if (online)
+    {
+        if (!PackSpritesOnline(order, maxSize, border, bins))
+        {
+            return 1;
+        }
+    }
+    else if (!PackSpritesOffline(order, maxSize, border, bins))
+    {
+        return 1;
+    }
+
+    const size_t numPages = bins.size();
+    std::vector<Image> pages(numPages);
+    for (size_t n = 0; n < numPages; n++)
+    {
+        pages[n].Create(NearPow2Geq(bins[n].w), NearPow2Geq(bins[n].h));
+    }
+
+    for (size_t n = 0; n < sprites.size(); n++)
+    {
+        BlitSprite(pages[sprites[n].rect.bin], sprites[n], extrude);
+    }
+
+    std::vector<std::string> pageFileNames(numPages);
+    for (size_t n = 0; n < numPages; n++)
+    {
+        pageFileNames[n] = PageFileName(outputFileName, n, (tga ? "tga" : "png"));
+
+        std::string error;
+        if (!pages[n].Save(pageFileNames[n].c_str(), error))
+        {
+            ErrorMessage("%s: %s", pageFileNames[n].c_str(), error.c_str());
+            return 1;
+        }
+
+        if (sVerbose)
+        {
+            unsigned used = 0;
+            for (size_t s = 0; s < sprites.size(); s++)
+            {
+                if (n == sprites[s].rect.bin)
+                {
+                    used += (sprites[s].image.GetWidth() * sprites[s].image.GetHeight());
+                }
+            }
+            const unsigned total = (pages[n].GetWidth() * pages[n].GetHeight());
+            printf("%s: %ux%u, %.1f%% used\n", pageFileNames[n].c_str(),
+                   pages[n].GetWidth(), pages[n].GetHeight(),
+                   ((100.0 * used) / total));
+        }
+    }
+
+    JSONStreamWriter writer;
+    if (!writer.Initialize(outputFileName, indentationStep))
+    {
+        ErrorMessage("Failed to open %s", outputFileName);
+        return 1;
+    }
+
+    writer.BeginObject();
+    writer.Key("version", 7);
+    writer.Number(1);
+
+    writer.Key("pages", 5);
+    writer.BeginArray();
+    for (size_t n = 0; n < numPages; n++)
+    {
+        const std::string image = BaseName(pageFileNames[n]);
+        writer.BeginObject();
+        writer.Key("image", 5);
+        writer.String(image.c_str(), image.size());
+        writer.Key("width", 5);
+        writer.Number(pages[n].GetWidth());
+        writer.Key("height", 6);
+        writer.Number(pages[n].GetHeight());
+        writer.EndObject();
+    }
+    writer.EndArray();
+
+    // Every sprite entry is a valid set of Draw2DSprite parameters once
+    // the texture of its page is added
+    writer.Key("sprites", 7);
+    writer.BeginObject();
+    for (size_t n = 0; n < sprites.size(); n++)
+    {
+        const Sprite &sprite = sprites[n];
+        const unsigned width = sprite.image.GetWidth();
+        const unsigned height = sprite.image.GetHeight();
+        const unsigned left = (sprite.rect.x + extrude);
+        const unsigned top = (sprite.rect.y + extrude);
+        std::vector<double> textureRectangle(4);
+        textureRectangle[0] = left;
+        textureRectangle[1] = top;
+        textureRectangle[2] = (left + width);
+        textureRectangle[3] = (top + height);
+
+        writer.Key(sprite.name.c_str(), sprite.name.size());
+        writer.BeginObject();
+        writer.Key("page", 4);
+        writer.Number(sprite.rect.bin);
+        writer.Key("textureRectangle", 16);
+        writer.NumberArray(textureRectangle);
+        writer.Key("width", 5);
+        writer.Number(width);
+        writer.Key("height", 6);
+        writer.Number(height);
+        writer.EndObject();
+    }
+    writer.EndObject();
+    writer.EndObject();
+
+    if (!writer.Close())
+    {
+        ErrorMessage("Failed to write %s", outputFileName);
+        return 1;
+    }
+    return 0;
+}
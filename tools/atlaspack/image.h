@@ -0,0 +1,564 @@
+// Copyright (c) 2015 Turbulenz Limited
+#ifndef __IMAGE_H__
+#define __IMAGE_H__
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+//
+// Image
+//
+// 8 bit RGBA image with loaders for TGA and PNG files and writers for the
+// same formats, enough for the atlas packer without further dependencies
+// than zlib.
+//
+class Image
+{
+public:
+    Image() :
+      mWidth(0),
+      mHeight(0)
+    {
+    }
+
+    void Create(unsigned width, unsigned height)
+    {
+        mWidth = width;
+        mHeight = height;
+        mPixels.assign((size_t)width * height * 4, 0);
+    }
+
+    unsigned GetWidth() const
+    {
+        return mWidth;
+    }
+
+    unsigned GetHeight() const
+    {
+        return mHeight;
+    }
+
+    unsigned char *GetPixel(unsigned x, unsigned y)
+    {
+        return &mPixels[(((size_t)y * mWidth) + x) * 4];
+    }
+
+    const unsigned char *GetPixel(unsigned x, unsigned y) const
+    {
+        return &mPixels[(((size_t)y * mWidth) + x) * 4];
+    }
+
+    bool Load(const char *fileName, std::string &error)
+    {
+        std::vector<unsigned char> data;
+        if (!ReadFile(fileName, data))
+        {
+            error = "Failed to read file";
+            return false;
+        }
+
+        static const unsigned char pngSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+        if (8 <= data.size() && 0 == memcmp(&data[0], pngSignature, 8))
+        {
+            return LoadPNG(data, error);
+        }
+        if (HasExtension(fileName, ".tga"))
+        {
+            return LoadTGA(data, error);
+        }
+        error = "Unsupported image format, only PNG and TGA files are supported";
+        return false;
+    }
+
+    bool Save(const char *fileName, std::string &error) const
+    {
+        std::vector<unsigned char> data;
+        if (HasExtension(fileName, ".tga"))
+        {
+            SaveTGA(data);
+        }
+        else if (!SavePNG(data))
+        {
+            error = "Failed to compress image";
+            return false;
+        }
+
+        FILE *f = fopen(fileName, "wb");
+        if (NULL == f)
+        {
+            error = "Failed to open file";
+            return false;
+        }
+        const bool written = (data.size() == fwrite(&data[0], 1, data.size(), f));
+        if (0 != fclose(f) || !written)
+        {
+            error = "Failed to write file";
+            return false;
+        }
+        return true;
+    }
+
+private:
+    static bool HasExtension(const char *fileName, const char *extension)
+    {
+        const size_t length = strlen(fileName);
+        const size_t extensionLength = strlen(extension);
+        if (length < extensionLength)
+        {
+            return false;
+        }
+        const char *end = (fileName + length - extensionLength);
+        for (size_t n = 0; n < extensionLength; n++)
+        {
+            char c = end[n];
+            if ('A' <= c && c <= 'Z')
+            {
+                c = (char)(c - 'A' + 'a');
+            }
+            if (c != extension[n])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static bool ReadFile(const char *fileName, std::vector<unsigned char> &data)
+    {
+        FILE *f = fopen(fileName, "rb");
+        if (NULL == f)
+        {
+            return false;
+        }
+        unsigned char buffer[64 * 1024];
+        size_t read;
+        while (0 < (read = fread(buffer, 1, sizeof(buffer), f)))
+        {
+            data.insert(data.end(), buffer, (buffer + read));
+        }
+        const bool failed = (0 != ferror(f));
+        fclose(f);
+        return !failed;
+    }
+
+    static uint32_t ReadBigEndian32(const unsigned char *data)
+    {
+        return (((uint32_t)data[0] << 24) |
+                ((uint32_t)data[1] << 16) |
+                ((uint32_t)data[2] << 8) |
+                (uint32_t)data[3]);
+    }
+
+    static void WriteBigEndian32(std::vector<unsigned char> &data, uint32_t value)
+    {
+        data.push_back((unsigned char)(value >> 24));
+        data.push_back((unsigned char)(value >> 16));
+        data.push_back((unsigned char)(value >> 8));
+        data.push_back((unsigned char)value);
+    }
+
+    //
+    // TGA
+    //
+
+    bool LoadTGA(const std::vector<unsigned char> &data, std::string &error)
+    {
+        if (data.size() < 18)
+        {
+            error = "Truncated TGA header";
+            return false;
+        }
+
+        const unsigned idLength = data[0];
+        const unsigned colorMapType = data[1];
+        const unsigned imageType = data[2];
+        const unsigned width = (data[12] | (data[13] << 8));
+        const unsigned height = (data[14] | (data[15] << 8));
+        const unsigned bitsPerPixel = data[16];
+        const unsigned descriptor = data[17];
+
+        const bool rle = (10 == imageType || 11 == imageType);
+        const bool gray = (3 == imageType || 11 == imageType);
+        if (0 != colorMapType ||
+            (2 != imageType && 3 != imageType && 10 != imageType && 11 != imageType) ||
+            (gray ? (8 != bitsPerPixel) : (24 != bitsPerPixel && 32 != bitsPerPixel)))
+        {
+            error = "Unsupported TGA format, only 8 bit grayscale and 24/32 bit color images are supported";
+            return false;
+        }
+
+        const unsigned bytesPerPixel = (bitsPerPixel / 8);
+        const size_t numPixels = ((size_t)width * height);
+        std::vector<unsigned char> pixels(numPixels * bytesPerPixel);
+
+        size_t offset = (18 + idLength);
+        if (rle)
+        {
+            size_t written = 0;
+            while (written < pixels.size())
+            {
+                if (offset >= data.size())
+                {
+                    error = "Truncated TGA data";
+                    return false;
+                }
+                const unsigned header = data[offset++];
+                const size_t count = ((header & 0x7f) + 1);
+                const size_t bytes = (count * bytesPerPixel);
+                if ((written + bytes) > pixels.size())
+                {
+                    error = "Invalid TGA data";
+                    return false;
+                }
+                if (0 != (header & 0x80))
+                {
+                    if ((offset + bytesPerPixel) > data.size())
+                    {
+                        error = "Truncated TGA data";
+                        return false;
+                    }
+                    for (size_t n = 0; n < count; n++)
+                    {
+                        memcpy(&pixels[written], &data[offset], bytesPerPixel);
+                        written += bytesPerPixel;
+                    }
+                    offset += bytesPerPixel;
+                }
+                else
+                {
+                    if ((offset + bytes) > data.size())
+                    {
+                        error = "Truncated TGA data";
+                        return false;
+                    }
+                    memcpy(&pixels[written], &data[offset], bytes);
+                    written += bytes;
+                    offset += bytes;
+                }
+            }
+        }
+        else
+        {
+            if ((offset + pixels.size()) > data.size())
+            {
+                error = "Truncated TGA data";
+                return false;
+            }
+            if (!pixels.empty())
+            {
+                memcpy(&pixels[0], &data[offset], pixels.size());
+            }
+        }
+
+        // Rows are stored bottom up unless bit 5 of the descriptor is set
+        const bool topDown = (0 != (descriptor & 0x20));
+        Create(width, height);
+        for (unsigned y = 0; y < height; y++)
+        {
+            const unsigned row = (topDown ? y : (height - 1 - y));
+            const unsigned char *source = &pixels[(size_t)row * width * bytesPerPixel];
+            unsigned char *target = GetPixel(0, y);
+            for (unsigned x = 0; x < width; x++)
+            {
+                if (gray)
+                {
+                    target[0] = target[1] = target[2] = source[0];
+                    target[3] = 255;
+                }
+                else
+                {
+                    target[0] = source[2];
+                    target[1] = source[1];
+                    target[2] = source[0];
+                    target[3] = ((4 == bytesPerPixel) ? source[3] : 255);
+                }
+                source += bytesPerPixel;
+                target += 4;
+            }
+        }
+        return true;
+    }
+
+    void SaveTGA(std::vector<unsigned char> &data) const
+    {
+        const unsigned char header[18] =
+        {
+            0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+            (unsigned char)(mWidth & 0xff), (unsigned char)(mWidth >> 8),
+            (unsigned char)(mHeight & 0xff), (unsigned char)(mHeight >> 8),
+            32, 0x28
+        };
+        data.assign(header, (header + 18));
+        data.reserve(18 + mPixels.size());
+        for (size_t n = 0; n < mPixels.size(); n += 4)
+        {
+            data.push_back(mPixels[n + 2]);
+            data.push_back(mPixels[n + 1]);
+            data.push_back(mPixels[n]);
+            data.push_back(mPixels[n + 3]);
+        }
+    }
+
+    //
+    // PNG
+    //
+
+    static unsigned PaethPredictor(int a, int b, int c)
+    {
+        const int p = (a + b - c);
+        const int pa = abs(p - a);
+        const int pb = abs(p - b);
+        const int pc = abs(p - c);
+        if (pa <= pb && pa <= pc)
+        {
+            return (unsigned)a;
+        }
+        if (pb <= pc)
+        {
+            return (unsigned)b;
+        }
+        return (unsigned)c;
+    }
+
+    bool LoadPNG(const std::vector<unsigned char> &data, std::string &error)
+    {
+        unsigned width = 0, height = 0;
+        unsigned bitDepth = 0, colorType = 0, interlace = 0;
+        std::vector<unsigned char> compressed;
+        std::vector<unsigned char> palette;
+        std::vector<unsigned char> paletteAlpha;
+
+        size_t offset = 8;
+        while ((offset + 12) <= data.size())
+        {
+            const uint32_t length = ReadBigEndian32(&data[offset]);
+            const unsigned char *type = &data[offset + 4];
+            const unsigned char *chunk = &data[offset + 8];
+            if ((offset + 12 + length) > data.size())
+            {
+                error = "Truncated PNG chunk";
+                return false;
+            }
+
+            if (0 == memcmp(type, "IHDR", 4) && 13 <= length)
+            {
+                width = ReadBigEndian32(chunk);
+                height = ReadBigEndian32(chunk + 4);
+                bitDepth = chunk[8];
+                colorType = chunk[9];
+                interlace = chunk[12];
+            }
+            else if (0 == memcmp(type, "PLTE", 4))
+            {
+                palette.assign(chunk, (chunk + length));
+            }
+            else if (0 == memcmp(type, "tRNS", 4))
+            {
+                paletteAlpha.assign(chunk, (chunk + length));
+            }
+            else if (0 == memcmp(type, "IDAT", 4))
+            {
+                compressed.insert(compressed.end(), chunk, (chunk + length));
+            }
+            else if (0 == memcmp(type, "IEND", 4))
+            {
+                break;
+            }
+            offset += (12 + length);
+        }
+
+        unsigned channels;
+        switch (colorType)
+        {
+        case 0: channels = 1; break;
+        case 2: channels = 3; break;
+        case 3: channels = 1; break;
+        case 4: channels = 2; break;
+        case 6: channels = 4; break;
+        default: channels = 0; break;
+        }
+
+        if (0 == width || 0 == height || 0 == channels || 0 != interlace ||
+            (8 != bitDepth && 16 != bitDepth) ||
+            (3 == colorType && 8 != bitDepth))
+        {
+            error = "Unsupported PNG format, only non interlaced 8 and 16 bit images are supported";
+            return false;
+        }
+
+        const size_t bytesPerPixel = (channels * (bitDepth / 8));
+        const size_t stride = (width * bytesPerPixel);
+        std::vector<unsigned char> raw(((stride + 1) * height));
+        uLongf rawLength = (uLongf)raw.size();
+        if (compressed.empty() ||
+            Z_OK != uncompress(&raw[0], &rawLength, &compressed[0], (uLong)compressed.size()) ||
+            rawLength != raw.size())
+        {
+            error = "Invalid PNG data";
+            return false;
+        }
+
+        // Undo the per row filters in place
+        std::vector<unsigned char> previous(stride, 0);
+        for (unsigned y = 0; y < height; y++)
+        {
+            const unsigned filter = raw[y * (stride + 1)];
+            unsigned char *row = &raw[(y * (stride + 1)) + 1];
+            for (size_t x = 0; x < stride; x++)
+            {
+                const unsigned a = ((x >= bytesPerPixel) ? row[x - bytesPerPixel] : 0);
+                const unsigned b = previous[x];
+                const unsigned c = ((x >= bytesPerPixel) ? previous[x - bytesPerPixel] : 0);
+                unsigned predictor;
+                switch (filter)
+                {
+                case 0: predictor = 0; break;
+                case 1: predictor = a; break;
+                case 2: predictor = b; break;
+                case 3: predictor = ((a + b) / 2); break;
+                case 4: predictor = PaethPredictor((int)a, (int)b, (int)c); break;
+                default:
+                    error = "Invalid PNG filter";
+                    return false;
+                }
+                row[x] = (unsigned char)(row[x] + predictor);
+            }
+            memcpy(&previous[0], row, stride);
+        }
+
+        Create(width, height);
+        const size_t sampleSize = (bitDepth / 8);
+        for (unsigned y = 0; y < height; y++)
+        {
+            const unsigned char *source = &raw[(y * (stride + 1)) + 1];
+            unsigned char *target = GetPixel(0, y);
+            for (unsigned x = 0; x < width; x++)
+            {
+                // The most significant byte comes first for 16 bit samples
+                unsigned char samples[4];
+                for (unsigned n = 0; n < channels; n++)
+                {
+                    samples[n] = source[n * sampleSize];
+                }
+                switch (colorType)
+                {
+                case 0:
+                    target[0] = target[1] = target[2] = samples[0];
+                    target[3] = 255;
+                    break;
+                case 2:
+                    target[0] = samples[0];
+                    target[1] = samples[1];
+                    target[2] = samples[2];
+                    target[3] = 255;
+                    break;
+                case 3:
+                    {
+                        const unsigned index = samples[0];
+                        if ((index * 3 + 2) >= palette.size())
+                        {
+                            error = "Invalid PNG palette index";
+                            return false;
+                        }
+                        target[0] = palette[index * 3];
+                        target[1] = palette[index * 3 + 1];
+                        target[2] = palette[index * 3 + 2];
+                        target[3] = ((index < paletteAlpha.size()) ? paletteAlpha[index] : 255);
+                    }
+                    break;
+                case 4:
+                    target[0] = target[1] = target[2] = samples[0];
+                    target[3] = samples[1];
+                    break;
+                default:
+                    target[0] = samples[0];
+                    target[1] = samples[1];
+                    target[2] = samples[2];
+                    target[3] = samples[3];
+                    break;
+                }
+                source += bytesPerPixel;
+                target += 4;
+            }
+        }
+        return true;
+    }
+
+    static void WriteChunk(std::vector<unsigned char> &data,
+                           const char *type,
+                           const unsigned char *chunk,
+                           size_t length)
+    {
+        WriteBigEndian32(data, (uint32_t)length);
+        const size_t start = data.size();
+        data.insert(data.end(), type, (type + 4));
+        if (0 < length)
+        {
+            data.insert(data.end(), chunk, (chunk + length));
+        }
+        const uLong crc = crc32(0, &data[start], (uInt)(data.size() - start));
+        WriteBigEndian32(data, (uint32_t)crc);
+    }
+
+    bool SavePNG(std::vector<unsigned char> &data) const
+    {
+        // Every row uses the 'up' filter, good enough for sprite sheets
+        const size_t stride = ((size_t)mWidth * 4);
+        std::vector<unsigned char> raw((stride + 1) * mHeight);
+        for (unsigned y = 0; y < mHeight; y++)
+        {
+            unsigned char *row = &raw[y * (stride + 1)];
+            const unsigned char *source = GetPixel(0, y);
+            row[0] = 2;
+            for (size_t x = 0; x < stride; x++)
+            {
+                const unsigned char above = ((0 < y) ? source[x - stride] : 0);
+                row[x + 1] = (unsigned char)(source[x] - above);
+            }
+        }
+
+        uLongf compressedLength = compressBound((uLong)raw.size());
+        std::vector<unsigned char> compressed(compressedLength);
+        if (Z_OK != compress2(&compressed[0], &compressedLength, &raw[0], (uLong)raw.size(), Z_BEST_COMPRESSION))
+        {
+            return false;
+        }
+
+        static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+        data.assign(signature, (signature + 8));
+
+        unsigned char header[13];
+        header[0] = (unsigned char)(mWidth >> 24);
+        header[1] = (unsigned char)(mWidth >> 16);
+        header[2] = (unsigned char)(mWidth >> 8);
+        header[3] = (unsigned char)mWidth;
+        header[4] = (unsigned char)(mHeight >> 24);
+        header[5] = (unsigned char)(mHeight >> 16);
+        header[6] = (unsigned char)(mHeight >> 8);
+        header[7] = (unsigned char)mHeight;
+        header[8] = 8;  // bit depth
+        header[9] = 6;  // RGBA
+        header[10] = 0;
+        header[11] = 0;
+        header[12] = 0;
+        WriteChunk(data, "IHDR", header, 13);
+        WriteChunk(data, "IDAT", &compressed[0], compressedLength);
+        WriteChunk(data, "IEND", NULL, 0);
+        return true;
+    }
+
+    unsigned                    mWidth;
+    unsigned                    mHeight;
+    std::vector<unsigned char>  mPixels;
+};
+
+#endif // __IMAGE_H__
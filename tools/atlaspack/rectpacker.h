@@ -0,0 +1,659 @@
+// Copyright (c) 2015 Turbulenz Limited
+#ifndef __RECTPACKER_H__
+#define __RECTPACKER_H__
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#include <math.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <vector>
+
+struct PackedRect
+{
+    unsigned x;
+    unsigned y;
+    unsigned w;
+    unsigned h;
+    unsigned bin;
+};
+
+static inline unsigned NearPow2Geq(unsigned x)
+{
+    unsigned pow2 = 1;
+    while (pow2 < x)
+    {
+        pow2 <<= 1;
+    }
+    return pow2;
+}
+
+//
+// SizeTree
+//
+// Port of SizeTree from tslib/particlesystem.ts, keep both in sync. A
+// balanced 2D AABB tree of the sizes of the free spaces, searched depth
+// first while discarding the subtrees too small for the request. The
+// search visits the spaces in an order that depends on the shape of the
+// tree, which decides between spaces of equal cost, so the tree is built,
+// balanced and searched exactly as the runtime one. Nodes live in a vector
+// and refer to each other by index, removed nodes are reused.
+//
+class SizeTree
+{
+public:
+    SizeTree() :
+      mRoot(-1)
+    {
+    }
+
+    int Insert(const PackedRect &data)
+    {
+        const int leaf = Gen(data.w, data.h);
+        mNodes[leaf].data = data;
+        if (mRoot < 0)
+        {
+            mRoot = leaf;
+            return leaf;
+        }
+
+        const int lw = (int)data.w;
+        const int lh = (int)data.h;
+        int node = mRoot;
+        while (0 <= mNodes[node].child[0])
+        {
+            const Node &n = mNodes[node];
+            const Node &child0 = mNodes[n.child[0]];
+            const Node &child1 = mNodes[n.child[1]];
+
+            // Cost of creating a new parent for this node and the leaf,
+            // the sum of the node dimensions
+            const int ncost = (Max(n.w, lw) + Max(n.h, lh));
+            // Cost of pushing the leaf further down the tree
+            const int icost = (ncost - (n.w + n.h));
+            // Cost of descending into each child
+            int cost0 = (Max(child0.w, lw) + Max(child0.h, lh) + icost);
+            int cost1 = (Max(child1.w, lw) + Max(child1.h, lh) + icost);
+            if (0 <= child0.child[0])
+            {
+                cost0 -= (child0.w + child0.h);
+            }
+            if (0 <= child1.child[0])
+            {
+                cost1 -= (child1.w + child1.h);
+            }
+
+            if (ncost < cost0 && ncost < cost1)
+            {
+                break;
+            }
+            node = ((cost0 < cost1) ? n.child[0] : n.child[1]);
+        }
+
+        // Create a new parent for the sibling and the leaf
+        const int sibling = node;
+        const int oparent = mNodes[sibling].parent;
+        const int nparent = Gen(Max(lw, mNodes[sibling].w), Max(lh, mNodes[sibling].h));
+        mNodes[nparent].parent = oparent;
+        mNodes[nparent].height = (mNodes[sibling].height + 1);
+        mNodes[sibling].parent = nparent;
+        mNodes[leaf].parent = nparent;
+        mNodes[nparent].child[0] = sibling;
+        mNodes[nparent].child[1] = leaf;
+
+        if (0 <= oparent)
+        {
+            mNodes[oparent].child[(mNodes[oparent].child[0] == sibling) ? 0 : 1] = nparent;
+        }
+        else
+        {
+            mRoot = nparent;
+        }
+
+        FilterUp(nparent);
+        return leaf;
+    }
+
+    void Remove(int leaf)
+    {
+        if (leaf == mRoot)
+        {
+            mRoot = -1;
+        }
+        else
+        {
+            const int parent = mNodes[leaf].parent;
+            const int gparent = mNodes[parent].parent;
+            const int sibling = mNodes[parent].child[(mNodes[parent].child[0] == leaf) ? 1 : 0];
+
+            if (0 <= gparent)
+            {
+                mNodes[gparent].child[(mNodes[gparent].child[0] == parent) ? 0 : 1] = sibling;
+                mNodes[sibling].parent = gparent;
+                FilterUp(gparent);
+            }
+            else
+            {
+                mRoot = sibling;
+                mNodes[sibling].parent = -1;
+            }
+            mUnused.push_back(parent);
+        }
+        mUnused.push_back(leaf);
+    }
+
+    const PackedRect &GetData(int leaf) const
+    {
+        return mNodes[leaf].data;
+    }
+
+    // Returns the leaf of minimum cost at least (w, h) in size, or -1. A
+    // cost of -HUGE_VAL is a best fit and ends the search.
+    template <typename CostFn>
+    int SearchBestFit(unsigned w, unsigned h, CostFn getCost)
+    {
+        std::vector<int> &stack = mStack;
+        if (0 <= mRoot)
+        {
+            stack.push_back(mRoot);
+        }
+
+        double minCost = HUGE_VAL;
+        int minLeaf = -1;
+        while (!stack.empty())
+        {
+            const int node = stack.back();
+            stack.pop_back();
+            const Node &n = mNodes[node];
+            if (n.w >= (int)w && n.h >= (int)h)
+            {
+                if (0 <= n.child[0])
+                {
+                    stack.push_back(n.child[0]);
+                    stack.push_back(n.child[1]);
+                }
+                else
+                {
+                    const double cost = getCost(w, h, n.data);
+                    if (cost == -HUGE_VAL)
+                    {
+                        minLeaf = node;
+                        stack.clear();
+                        break;
+                    }
+                    else if (cost < minCost)
+                    {
+                        minCost = cost;
+                        minLeaf = node;
+                    }
+                }
+            }
+        }
+        return minLeaf;
+    }
+
+private:
+    struct Node
+    {
+        int w;
+        int h;
+        PackedRect data;    // Leaves only
+        int parent;
+        int height;
+        int child[2];       // Non leaves only, -1 on leaves
+    };
+
+    static int Max(int a, int b)
+    {
+        return ((a > b) ? a : b);
+    }
+
+    int Gen(unsigned w, unsigned h)
+    {
+        int node;
+        if (!mUnused.empty())
+        {
+            node = mUnused.back();
+            mUnused.pop_back();
+        }
+        else
+        {
+            node = (int)mNodes.size();
+            mNodes.push_back(Node());
+        }
+        Node &n = mNodes[node];
+        n.w = (int)w;
+        n.h = (int)h;
+        n.parent = -1;
+        n.height = 0;
+        n.child[0] = -1;
+        n.child[1] = -1;
+        return node;
+    }
+
+    void FilterUp(int node)
+    {
+        while (0 <= node)
+        {
+            node = Balance(node);
+
+            Node &n = mNodes[node];
+            const Node &child0 = mNodes[n.child[0]];
+            const Node &child1 = mNodes[n.child[1]];
+            n.height = (1 + Max(child0.height, child1.height));
+            n.w = Max(child0.w, child1.w);
+            n.h = Max(child0.h, child1.h);
+
+            node = n.parent;
+        }
+    }
+
+    int Balance(int node)
+    {
+        if (mNodes[node].child[0] < 0 || mNodes[node].height < 2)
+        {
+            return node;
+        }
+
+        const int child0 = mNodes[node].child[0];
+        const int child1 = mNodes[node].child[1];
+        const int balance = (mNodes[child1].height - mNodes[child0].height);
+        if (balance >= -1 && balance <= 1)
+        {
+            return node;
+        }
+
+        // Decide which direction to rotate the sub tree
+        int rotate, other, childN;
+        if (balance > 0)
+        {
+            rotate = child1;
+            other = child0;
+            childN = 1;
+        }
+        else
+        {
+            rotate = child0;
+            other = child1;
+            childN = 0;
+        }
+
+        const int grandchild0 = mNodes[rotate].child[0];
+        const int grandchild1 = mNodes[rotate].child[1];
+
+        // Swap the node with rotate
+        mNodes[rotate].child[1 - childN] = node;
+        mNodes[rotate].parent = mNodes[node].parent;
+        mNodes[node].parent = rotate;
+
+        const int rparent = mNodes[rotate].parent;
+        if (0 <= rparent)
+        {
+            mNodes[rparent].child[(mNodes[rparent].child[0] == node) ? 0 : 1] = rotate;
+        }
+        else
+        {
+            mRoot = rotate;
+        }
+
+        // Decide which grandchild to swing
+        int pivot, swing;
+        if (mNodes[grandchild0].height > mNodes[grandchild1].height)
+        {
+            pivot = grandchild0;
+            swing = grandchild1;
+        }
+        else
+        {
+            pivot = grandchild1;
+            swing = grandchild0;
+        }
+
+        mNodes[rotate].child[childN] = pivot;
+        mNodes[node].child[childN] = swing;
+        mNodes[swing].parent = node;
+
+        // Recompute the bounds and heights
+        Node &n = mNodes[node];
+        Node &r = mNodes[rotate];
+        const Node &o = mNodes[other];
+        const Node &s = mNodes[swing];
+        const Node &p = mNodes[pivot];
+        n.w = Max(o.w, s.w);
+        n.h = Max(o.h, s.h);
+        r.w = Max(n.w, p.w);
+        r.h = Max(n.h, p.h);
+        n.height = (1 + Max(o.height, s.height));
+        r.height = (1 + Max(n.height, p.height));
+
+        return rotate;
+    }
+
+    int               mRoot;
+    std::vector<Node> mNodes;
+    std::vector<int>  mUnused;
+    std::vector<int>  mStack;
+};
+
+//
+// OnlineTexturePacker
+//
+// Port of OnlineTexturePacker from tslib/particlesystem.ts, keep both in
+// sync. Rectangles are packed in the order they are given into bins that
+// grow towards (maxWidth, maxHeight), choosing the free space with the same
+// cost function and splitting it the same way as the runtime packer. The
+// free spaces are kept in the same SizeTree, so spaces of equal cost are
+// chosen in the same order and atlases built offline have exactly the
+// layout the runtime would build.
+//
+class OnlineTexturePacker
+{
+public:
+    OnlineTexturePacker(unsigned maxWidth, unsigned maxHeight) :
+      mMaxWidth(maxWidth),
+      mMaxHeight(maxHeight)
+    {
+    }
+
+    bool Pack(unsigned w, unsigned h, PackedRect &result)
+    {
+        if (w > mMaxWidth || h > mMaxHeight)
+        {
+            return false;
+        }
+
+        const int node = mFree.SearchBestFit(w, h, CostFit);
+        if (0 <= node)
+        {
+            const PackedRect rect = mFree.GetData(node);
+            mFree.Remove(node);
+            result = Split(rect, w, h);
+        }
+        else
+        {
+            result = Grow(w, h, 0);
+        }
+        return true;
+    }
+
+    size_t GetNumBins() const
+    {
+        return mBins.size();
+    }
+
+    const PackedRect &GetBin(size_t bin) const
+    {
+        return mBins[bin];
+    }
+
+private:
+    // Exact fits return -HUGE_VAL and terminate the search, other costs
+    // can be negative too
+    static double CostFit(unsigned w, unsigned h, const PackedRect &rect)
+    {
+        if (rect.w == w && rect.h == h)
+        {
+            return -HUGE_VAL;
+        }
+        const double fw = ((double)rect.w / w);
+        const double fh = ((double)rect.h / h);
+        const double pi = 3.14159265358979323846;
+        const double cw = sin((1.0 - (fw * fw)) * pi);
+        const double ch = sin((1.0 - (fh * fh)) * pi);
+        return ((cw * ch) + (cw + ch));
+    }
+
+    void ReleaseSpace(unsigned bin, unsigned x, unsigned y, unsigned w, unsigned h)
+    {
+        if (0 != w && 0 != h)
+        {
+            const PackedRect rect = { x, y, w, h, bin };
+            mFree.Insert(rect);
+        }
+    }
+
+    PackedRect Split(const PackedRect &rect, unsigned w, unsigned h)
+    {
+        if ((rect.w - w) < (rect.h - h))
+        {
+            ReleaseSpace(rect.bin, rect.x, (rect.y + h), rect.w, (rect.h - h));
+            ReleaseSpace(rect.bin, (rect.x + w), rect.y, (rect.w - w), h);
+        }
+        else
+        {
+            ReleaseSpace(rect.bin, rect.x, (rect.y + h), w, (rect.h - h));
+            ReleaseSpace(rect.bin, (rect.x + w), rect.y, (rect.w - w), rect.h);
+        }
+        const PackedRect fit = { rect.x, rect.y, w, h, rect.bin };
+        return fit;
+    }
+
+    PackedRect Grow(unsigned w, unsigned h, unsigned bin)
+    {
+        if (bin >= mBins.size())
+        {
+            const PackedRect empty = { 0, 0, 0, 0, bin };
+            mBins.push_back(empty);
+        }
+
+        PackedRect &rect = mBins[bin];
+        const bool canGrowRight = ((rect.x + rect.w + w) <= mMaxWidth);
+        const bool canGrowDown = ((rect.y + rect.h + h) <= mMaxHeight);
+
+        // Avoid creating narrow regions and crossing power of 2 boundaries
+        const bool wExpand = (NearPow2Geq(rect.w) != NearPow2Geq(rect.w + w));
+        const bool hExpand = (NearPow2Geq(rect.h) != NearPow2Geq(rect.h + h));
+        const int dh = ((int)rect.h - (int)h);
+        const int dw = ((int)rect.w - (int)w);
+        const bool shouldGrowRight = ((wExpand == hExpand) ? (abs(dh) > abs(dw)) : !wExpand);
+
+        if (canGrowRight && shouldGrowRight)
+        {
+            return GrowRight(rect, w, h);
+        }
+        else if (canGrowDown)
+        {
+            return GrowDown(rect, w, h);
+        }
+        return Grow(w, h, (bin + 1));
+    }
+
+    PackedRect GrowRight(PackedRect &rect, unsigned w, unsigned h)
+    {
+        const PackedRect fit = { (rect.x + rect.w), rect.y, w, h, rect.bin };
+        if (h < rect.h)
+        {
+            ReleaseSpace(rect.bin, (rect.x + rect.w), (rect.y + h), w, (rect.h - h));
+        }
+        else
+        {
+            ReleaseSpace(rect.bin, rect.x, (rect.y + rect.h), rect.w, (h - rect.h));
+            rect.h = h;
+        }
+        rect.w += w;
+        return fit;
+    }
+
+    PackedRect GrowDown(PackedRect &rect, unsigned w, unsigned h)
+    {
+        const PackedRect fit = { rect.x, (rect.y + rect.h), w, h, rect.bin };
+        if (w < rect.w)
+        {
+            ReleaseSpace(rect.bin, (rect.x + w), (rect.y + rect.h), (rect.w - w), h);
+        }
+        else
+        {
+            ReleaseSpace(rect.bin, (rect.x + rect.w), rect.y, (w - rect.w), rect.h);
+            rect.w = w;
+        }
+        rect.h += h;
+        return fit;
+    }
+
+    unsigned                mMaxWidth;
+    unsigned                mMaxHeight;
+    SizeTree                mFree;
+    std::vector<PackedRect> mBins;
+};
+
+//
+// MaxRectsPacker
+//
+// Offline packer for a single bin keeping every maximal free rectangle,
+// placing rectangles with the best short side fit heuristic. Denser than the
+// online packer when all the rectangles are known up front and sorted by
+// size.
+//
+class MaxRectsPacker
+{
+public:
+    MaxRectsPacker(unsigned width, unsigned height, unsigned bin) :
+      mBin(bin),
+      mUsedWidth(0),
+      mUsedHeight(0)
+    {
+        const PackedRect all = { 0, 0, width, height, bin };
+        mFree.push_back(all);
+    }
+
+    bool Pack(unsigned w, unsigned h, PackedRect &result)
+    {
+        const size_t node = FindPosition(w, h);
+        if (node >= mFree.size())
+        {
+            return false;
+        }
+
+        const PackedRect fit = { mFree[node].x, mFree[node].y, w, h, mBin };
+        Place(fit);
+        result = fit;
+        return true;
+    }
+
+    unsigned GetUsedWidth() const
+    {
+        return mUsedWidth;
+    }
+
+    unsigned GetUsedHeight() const
+    {
+        return mUsedHeight;
+    }
+
+private:
+    size_t FindPosition(unsigned w, unsigned h) const
+    {
+        unsigned bestShortSide = UINT_MAX;
+        unsigned bestLongSide = UINT_MAX;
+        size_t bestNode = mFree.size();
+        for (size_t n = 0; n < mFree.size(); n++)
+        {
+            const PackedRect &space = mFree[n];
+            if (space.w >= w && space.h >= h)
+            {
+                const unsigned leftoverW = (space.w - w);
+                const unsigned leftoverH = (space.h - h);
+                const unsigned shortSide = ((leftoverW < leftoverH) ? leftoverW : leftoverH);
+                const unsigned longSide = ((leftoverW < leftoverH) ? leftoverH : leftoverW);
+                if (shortSide < bestShortSide ||
+                    (shortSide == bestShortSide && longSide < bestLongSide))
+                {
+                    bestShortSide = shortSide;
+                    bestLongSide = longSide;
+                    bestNode = n;
+                }
+            }
+        }
+        return bestNode;
+    }
+
+    static bool Contains(const PackedRect &a, const PackedRect &b)
+    {
+        return (a.x <= b.x && a.y <= b.y &&
+                (b.x + b.w) <= (a.x + a.w) &&
+                (b.y + b.h) <= (a.y + a.h));
+    }
+
+    static void SplitFree(const PackedRect &space, const PackedRect &used, std::vector<PackedRect> &output)
+    {
+        if (used.x >= (space.x + space.w) || (used.x + used.w) <= space.x ||
+            used.y >= (space.y + space.h) || (used.y + used.h) <= space.y)
+        {
+            output.push_back(space);
+            return;
+        }
+
+        if (used.x > space.x)
+        {
+            const PackedRect left = { space.x, space.y, (used.x - space.x), space.h, space.bin };
+            output.push_back(left);
+        }
+        if ((used.x + used.w) < (space.x + space.w))
+        {
+            const PackedRect right = { (used.x + used.w), space.y,
+                                       ((space.x + space.w) - (used.x + used.w)), space.h, space.bin };
+            output.push_back(right);
+        }
+        if (used.y > space.y)
+        {
+            const PackedRect top = { space.x, space.y, space.w, (used.y - space.y), space.bin };
+            output.push_back(top);
+        }
+        if ((used.y + used.h) < (space.y + space.h))
+        {
+            const PackedRect bottom = { space.x, (used.y + used.h), space.w,
+                                        ((space.y + space.h) - (used.y + used.h)), space.bin };
+            output.push_back(bottom);
+        }
+    }
+
+    void Place(const PackedRect &fit)
+    {
+        std::vector<PackedRect> free;
+        free.reserve(mFree.size() + 4);
+        for (size_t n = 0; n < mFree.size(); n++)
+        {
+            SplitFree(mFree[n], fit, free);
+        }
+
+        // Remove the spaces contained by others, keeping one of any duplicates
+        std::vector<PackedRect> pruned;
+        pruned.reserve(free.size());
+        for (size_t i = 0; i < free.size(); i++)
+        {
+            bool contained = false;
+            for (size_t j = 0; j < free.size(); j++)
+            {
+                if (i != j && Contains(free[j], free[i]) &&
+                    (!Contains(free[i], free[j]) || j < i))
+                {
+                    contained = true;
+                    break;
+                }
+            }
+            if (!contained)
+            {
+                pruned.push_back(free[i]);
+            }
+        }
+        mFree.swap(pruned);
+
+        if (mUsedWidth < (fit.x + fit.w))
+        {
+            mUsedWidth = (fit.x + fit.w);
+        }
+        if (mUsedHeight < (fit.y + fit.h))
+        {
+            mUsedHeight = (fit.y + fit.h);
+        }
+    }
+
+    unsigned                mBin;
+    unsigned                mUsedWidth;
+    unsigned                mUsedHeight;
+    std::vector<PackedRect> mFree;
+};
+
+#endif // __RECTPACKER_H__
@@ -0,0 +1,292 @@
+// Copyright (c) 2015 Turbulenz Limited
+
+//
+// rectpackercheck
+//
+// Packs sets of pseudo random rectangles with both packers in rectpacker.h
+// and checks that every placement is inside its bin and that no two
+// placements in the same bin overlap, and that the online packer places a
+// reference sequence exactly like the runtime one. Returns non zero on
+// failure.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+
+#include "rectpacker.h"
+
+struct InputRect
+{
+    unsigned w;
+    unsigned h;
+};
+
+static bool SortByMaxSide(const InputRect &a, const InputRect &b)
+{
+    const unsigned maxA = ((a.w > a.h) ? a.w : a.h);
+    const unsigned maxB = ((b.w > b.h) ? b.w : b.h);
+    return (maxA > maxB);
+}
+
+static unsigned sSeed = 1;
+
+static unsigned Random(unsigned range)
+{
+    sSeed = ((sSeed * 1103515245u) + 12345u);
+    return ((sSeed >> 16) % range);
+}
+
+static void RandomRects(unsigned count, unsigned maxSide, std::vector<InputRect> &rects)
+{
+    rects.resize(count);
+    for (unsigned n = 0; n < count; n++)
+    {
+        rects[n].w = (1 + Random(maxSide));
+        rects[n].h = (1 + Random(maxSide));
+    }
+}
+
+static bool Overlap(const PackedRect &a, const PackedRect &b)
+{
+    return (a.bin == b.bin &&
+            a.x < (b.x + b.w) && b.x < (a.x + a.w) &&
+            a.y < (b.y + b.h) && b.y < (a.y + a.h));
+}
+
+static bool CheckNoOverlaps(const char *name, const std::vector<PackedRect> &placed)
+{
+    for (size_t i = 0; i < placed.size(); i++)
+    {
+        for (size_t j = (i + 1); j < placed.size(); j++)
+        {
+            if (Overlap(placed[i], placed[j]))
+            {
+                fprintf(stderr, "%s: rects %u and %u overlap\n", name, (unsigned)i, (unsigned)j);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool CheckMaxRects(unsigned size, unsigned count, unsigned maxSide)
+{
+    std::vector<InputRect> rects;
+    RandomRects(count, maxSide, rects);
+    std::sort(rects.begin(), rects.end(), SortByMaxSide);
+
+    MaxRectsPacker packer(size, size, 0);
+    std::vector<PackedRect> placed;
+    unsigned maxX = 0;
+    unsigned maxY = 0;
+    for (size_t n = 0; n < rects.size(); n++)
+    {
+        PackedRect result;
+        if (!packer.Pack(rects[n].w, rects[n].h, result))
+        {
+            continue;
+        }
+        if (result.w != rects[n].w || result.h != rects[n].h ||
+            (result.x + result.w) > size || (result.y + result.h) > size)
+        {
+            fprintf(stderr, "MaxRects: rect %u placed outside the bin\n", (unsigned)n);
+            return false;
+        }
+        if (maxX < (result.x + result.w))
+        {
+            maxX = (result.x + result.w);
+        }
+        if (maxY < (result.y + result.h))
+        {
+            maxY = (result.y + result.h);
+        }
+        placed.push_back(result);
+    }
+
+    if (packer.GetUsedWidth() != maxX || packer.GetUsedHeight() != maxY)
+    {
+        fprintf(stderr, "MaxRects: used size %ux%u, expected %ux%u\n",
+                packer.GetUsedWidth(), packer.GetUsedHeight(), maxX, maxY);
+        return false;
+    }
+    return CheckNoOverlaps("MaxRects", placed);
+}
+
+// Equal squares that tile the bin exactly must all fit
+static bool CheckMaxRectsExactFill()
+{
+    MaxRectsPacker packer(256, 256, 0);
+    std::vector<PackedRect> placed;
+    for (unsigned n = 0; n < 16; n++)
+    {
+        PackedRect result;
+        if (!packer.Pack(64, 64, result))
+        {
+            fprintf(stderr, "MaxRects: square %u of 16 did not fit\n", n);
+            return false;
+        }
+        placed.push_back(result);
+    }
+
+    PackedRect result;
+    if (packer.Pack(1, 1, result))
+    {
+        fprintf(stderr, "MaxRects: packed into a full bin\n");
+        return false;
+    }
+    return CheckNoOverlaps("MaxRects", placed);
+}
+
+static bool CheckOnline(unsigned maxSize, unsigned count, unsigned maxSide)
+{
+    std::vector<InputRect> rects;
+    RandomRects(count, maxSide, rects);
+
+    OnlineTexturePacker packer(maxSize, maxSize);
+    std::vector<PackedRect> placed;
+    for (size_t n = 0; n < rects.size(); n++)
+    {
+        PackedRect result;
+        if (!packer.Pack(rects[n].w, rects[n].h, result))
+        {
+            fprintf(stderr, "Online: rect %u was not packed\n", (unsigned)n);
+            return false;
+        }
+        if (result.w != rects[n].w || result.h != rects[n].h)
+        {
+            fprintf(stderr, "Online: rect %u has the wrong size\n", (unsigned)n);
+            return false;
+        }
+        placed.push_back(result);
+    }
+
+    for (size_t n = 0; n < placed.size(); n++)
+    {
+        const PackedRect &result = placed[n];
+        if (result.bin >= packer.GetNumBins())
+        {
+            fprintf(stderr, "Online: rect %u placed in a missing bin\n", (unsigned)n);
+            return false;
+        }
+        const PackedRect &bin = packer.GetBin(result.bin);
+        if ((result.x + result.w) > (bin.x + bin.w) ||
+            (result.y + result.h) > (bin.y + bin.h) ||
+            (bin.x + bin.w) > maxSize ||
+            (bin.y + bin.h) > maxSize)
+        {
+            fprintf(stderr, "Online: rect %u placed outside its bin\n", (unsigned)n);
+            return false;
+        }
+    }
+
+    // Rects larger than the maximum bin are rejected
+    PackedRect result;
+    if (packer.Pack((maxSize + 1), 1, result))
+    {
+        fprintf(stderr, "Online: packed a rect larger than the bins\n");
+        return false;
+    }
+    return CheckNoOverlaps("Online", placed);
+}
+
+// Placements made by OnlineTexturePacker in tslib/particlesystem.ts for a
+// sequence of sizes multiple of 8, so many free spaces have the same cost
+// and the order the SizeTree visits them decides the layout
+struct ReferenceRect
+{
+    unsigned w;
+    unsigned h;
+    unsigned x;
+    unsigned y;
+    unsigned bin;
+};
+
+static const ReferenceRect sOnlineReference[] =
+{
+    {  24,  24,   0,   0,   0 },
+    {  16,  32,   0,  24,   0 },
+    {  32,  32,  24,   0,   0 },
+    {  24,  32,   0,  56,   0 },
+    {   8,  24,  24,  56,   0 },
+    {  16,  32,  32,  56,   0 },
+    {   8,   8,  24,  80,   0 },
+    {  16,  32,   0,  88,   0 },
+    {  16,  32,  16,  88,   0 },
+    {  16,  24,  32,  88,   0 },
+    {  24,  24,  24,  32,   0 },
+    {  32,  32,  56,   0,   0 },
+    {  32,  24,  56,  32,   0 },
+    {  32,  16,  56,  56,   0 },
+    {  24,   8,  56,  72,   0 },
+    {   8,  16,  48,  56,   0 },
+    {  24,  24,  56,  80,   0 },
+    {  32,  32,  88,   0,   0 },
+    {  24,  16,  56, 104,   0 },
+    {  16,   8,  32, 112,   0 },
+    {   8,   8,  80,  72,   0 },
+    {  16,  32,  88,  32,   0 },
+    {  32,  24,  88,  64,   0 },
+    {  16,  32, 104,  32,   0 },
+    {  24,  24,  88,  88,   0 },
+    {  16,   8,  88, 112,   0 },
+    {   8,  32,  16,  24,   0 },
+    {  24,  24,   0,   0,   1 },
+    {  24,  32,  24,   0,   1 },
+    {  16,  16,  48,   0,   1 },
+    {  32,  32,   0,  32,   1 },
+    {  32,  24,  32,  32,   1 },
+    {  24,  32,   0,  64,   1 },
+    {   8,  16,  80, 104,   0 },
+    {  16,  24,  24,  64,   1 },
+    {  24,  24,  40,  64,   1 },
+    {  24,   8,  40,  88,   1 },
+    {  24,  24,   0,  96,   1 },
+    {   8,  16,  48,  72,   0 },
+    {  16,  24,  24,  96,   1 }
+};
+
+static bool CheckOnlineReference()
+{
+    OnlineTexturePacker packer(128, 128);
+    const unsigned count = (sizeof(sOnlineReference) / sizeof(sOnlineReference[0]));
+    for (unsigned n = 0; n < count; n++)
+    {
+        const ReferenceRect &reference = sOnlineReference[n];
+        PackedRect result;
+        if (!packer.Pack(reference.w, reference.h, result) ||
+            result.x != reference.x ||
+            result.y != reference.y ||
+            result.bin != reference.bin)
+        {
+            fprintf(stderr, "Online: rect %u placed differently from the runtime packer\n", n);
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    bool ok = CheckMaxRectsExactFill();
+    ok = (CheckOnlineReference() && ok);
+    for (unsigned seed = 1; seed <= 8; seed++)
+    {
+        sSeed = seed;
+        ok = (CheckMaxRects(1024, 400, 96) && ok);
+        sSeed = seed;
+        ok = (CheckOnline(512, 400, 96) && ok);
+    }
+
+    if (!ok)
+    {
+        fprintf(stderr, "rectpackercheck: FAILED\n");
+        return 1;
+    }
+    printf("rectpackercheck: OK\n");
+    return 0;
+}
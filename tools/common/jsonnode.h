@@ -0,0 +1,270 @@
+// Copyright (c) 2015 Turbulenz Limited
+#ifndef __JSONNODE_H__
+#define __JSONNODE_H__
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+//
+// JSONNode
+//
+// Small document tree for the parts of a file a tool needs to modify as a
+// whole. Arrays of numbers are kept unboxed.
+//
+class JSONNode
+{
+public:
+    enum Type
+    {
+        TYPE_NULL,
+        TYPE_BOOLEAN,
+        TYPE_NUMBER,
+        TYPE_STRING,
+        TYPE_ARRAY,
+        TYPE_OBJECT
+    };
+
+    typedef std::pair<std::string, JSONNode *> Member;
+
+    explicit JSONNode(Type type) :
+      mType(type),
+      mBoolean(false),
+      mNumber(0.0),
+      mNumbersOnly(true)
+    {
+    }
+
+    ~JSONNode()
+    {
+        for (size_t n = 0; n < mMembers.size(); n++)
+        {
+            delete mMembers[n].second;
+        }
+        for (size_t n = 0; n < mElements.size(); n++)
+        {
+            delete mElements[n];
+        }
+    }
+
+    JSONNode *Find(const char *name) const
+    {
+        for (size_t n = 0; n < mMembers.size(); n++)
+        {
+            if (mMembers[n].first == name)
+            {
+                return mMembers[n].second;
+            }
+        }
+        return NULL;
+    }
+
+    void Remove(const char *name)
+    {
+        for (size_t n = 0; n < mMembers.size(); n++)
+        {
+            if (mMembers[n].first == name)
+            {
+                delete mMembers[n].second;
+                mMembers.erase(mMembers.begin() + n);
+                return;
+            }
+        }
+    }
+
+    void Add(const char *name, JSONNode *node)
+    {
+        Remove(name);
+        mMembers.push_back(Member(name, node));
+    }
+
+    static JSONNode *CreateNumber(double value)
+    {
+        JSONNode *node = new JSONNode(TYPE_NUMBER);
+        node->mNumber = value;
+        return node;
+    }
+
+    static JSONNode *CreateString(const std::string &value)
+    {
+        JSONNode *node = new JSONNode(TYPE_STRING);
+        node->mString = value;
+        return node;
+    }
+
+    // Arrays of numbers are stored unboxed until a non-number is added
+    void AddNumber(double value)
+    {
+        if (mNumbersOnly)
+        {
+            mNumbers.push_back(value);
+        }
+        else
+        {
+            mElements.push_back(CreateNumber(value));
+        }
+    }
+
+    void AddElement(JSONNode *node)
+    {
+        if (mNumbersOnly)
+        {
+            mNumbersOnly = false;
+            for (size_t n = 0; n < mNumbers.size(); n++)
+            {
+                mElements.push_back(CreateNumber(mNumbers[n]));
+            }
+            mNumbers.clear();
+        }
+        mElements.push_back(node);
+    }
+
+    bool IsNumberArray() const
+    {
+        return (TYPE_ARRAY == mType && mNumbersOnly);
+    }
+
+    Type                  mType;
+    bool                  mBoolean;
+    double                mNumber;
+    std::string           mString;
+    bool                  mNumbersOnly;
+    std::vector<double>   mNumbers;
+    std::vector<JSONNode *> mElements;
+    std::vector<Member>   mMembers;
+};
+
+//
+// JSONNodeBuilder
+//
+// JSONReader handler that builds a JSONNode tree.
+//
+class JSONNodeBuilder
+{
+public:
+    JSONNodeBuilder() :
+      mRoot(NULL)
+    {
+    }
+
+    ~JSONNodeBuilder()
+    {
+        delete mRoot;
+    }
+
+    JSONNode *Detach()
+    {
+        JSONNode *root = mRoot;
+        mRoot = NULL;
+        return root;
+    }
+
+    bool IsComplete() const
+    {
+        return (NULL != mRoot && mStack.empty());
+    }
+
+    bool Null()
+    {
+        return AddNode(new JSONNode(JSONNode::TYPE_NULL));
+    }
+
+    bool Boolean(bool value)
+    {
+        JSONNode *node = new JSONNode(JSONNode::TYPE_BOOLEAN);
+        node->mBoolean = value;
+        return AddNode(node);
+    }
+
+    bool Number(double value)
+    {
+        if (!mStack.empty() &&
+            JSONNode::TYPE_ARRAY == mStack.back()->mType)
+        {
+            mStack.back()->AddNumber(value);
+            return true;
+        }
+        return AddNode(JSONNode::CreateNumber(value));
+    }
+
+    bool String(const char *text, size_t length)
+    {
+        return AddNode(JSONNode::CreateString(std::string(text, length)));
+    }
+
+    bool Key(const char *text, size_t length)
+    {
+        mKey.assign(text, length);
+        return true;
+    }
+
+    bool BeginObject()
+    {
+        JSONNode *node = new JSONNode(JSONNode::TYPE_OBJECT);
+        if (!AddNode(node))
+        {
+            return false;
+        }
+        mStack.push_back(node);
+        return true;
+    }
+
+    bool EndObject()
+    {
+        mStack.pop_back();
+        return true;
+    }
+
+    bool BeginArray()
+    {
+        JSONNode *node = new JSONNode(JSONNode::TYPE_ARRAY);
+        if (!AddNode(node))
+        {
+            return false;
+        }
+        mStack.push_back(node);
+        return true;
+    }
+
+    bool EndArray()
+    {
+        mStack.pop_back();
+        return true;
+    }
+
+private:
+    bool AddNode(JSONNode *node)
+    {
+        if (mStack.empty())
+        {
+            if (NULL != mRoot)
+            {
+                delete node;
+                return false;
+            }
+            mRoot = node;
+            return true;
+        }
+
+        JSONNode *parent = mStack.back();
+        if (JSONNode::TYPE_OBJECT == parent->mType)
+        {
+            parent->mMembers.push_back(JSONNode::Member(mKey, node));
+        }
+        else
+        {
+            parent->AddElement(node);
+        }
+        return true;
+    }
+
+    JSONNode               *mRoot;
+    std::vector<JSONNode *> mStack;
+    std::string             mKey;
+};
+
+#endif // __JSONNODE_H__
@@ -0,0 +1,669 @@
+// Copyright (c) 2015 Turbulenz Limited
+#ifndef __JSONREADER_H__
+#define __JSONREADER_H__
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+//
+// JSONReader
+//
+// SAX style JSON reader that works in-situ on a mutable buffer.
+//
+// Strings and keys are passed to the handler as pointer and length pairs
+// into the buffer, they are not NUL terminated. Only strings containing
+// escape sequences are written to, when they get unescaped in place, so a
+// private file mapping stays backed by the file for everything else.
+// Nesting is tracked on a fixed size stack so no memory is allocated while
+// parsing, regardless of the size of the input.
+//
+// Parsing modifies the buffer, a fresh copy or mapping is required to parse
+// the same input again.
+//
+// The Handler type must provide:
+//
+//   bool Null();
+//   bool Boolean(bool value);
+//   bool Number(double value);
+//   bool String(const char *text, size_t length);
+//   bool Key(const char *text, size_t length);
+//   bool BeginObject();
+//   bool EndObject();
+//   bool BeginArray();
+//   bool EndArray();
+//
+// Returning false from any of them stops the parsing.
+//
+class JSONReader
+{
+public:
+    enum
+    {
+        MAX_DEPTH = 256
+    };
+
+    JSONReader() :
+      mBegin(NULL),
+      mCursor(NULL),
+      mEnd(NULL),
+      mDepth(0),
+      mError(NULL),
+      mErrorOffset(0)
+    {
+    }
+
+    template <class Handler>
+    bool Parse(char *text, size_t length, Handler &handler)
+    {
+        mBegin = text;
+        mCursor = text;
+        mEnd = (text + length);
+        mDepth = 0;
+        mError = NULL;
+        mErrorOffset = 0;
+
+        for (;;)
+        {
+            bool complete;
+            if (!ParseValue(handler, complete))
+            {
+                return false;
+            }
+
+            if (complete)
+            {
+                // Close containers until we find the next value
+                for (;;)
+                {
+                    SkipWhitespace();
+
+                    if (0 == mDepth)
+                    {
+                        if (mCursor != mEnd)
+                        {
+                            return Fail("Unexpected characters after the root value");
+                        }
+                        return true;
+                    }
+
+                    if (mCursor >= mEnd)
+                    {
+                        return Fail("Unexpected end of input");
+                    }
+
+                    const char c = *mCursor;
+                    const char container = mStack[mDepth - 1];
+                    if (',' == c)
+                    {
+                        mCursor++;
+                        if ('{' == container &&
+                            !ParseKey(handler))
+                        {
+                            return false;
+                        }
+                        break;
+                    }
+                    else if ('}' == c && '{' == container)
+                    {
+                        mCursor++;
+                        mDepth--;
+                        if (!handler.EndObject())
+                        {
+                            return Abort();
+                        }
+                    }
+                    else if (']' == c && '[' == container)
+                    {
+                        mCursor++;
+                        mDepth--;
+                        if (!handler.EndArray())
+                        {
+                            return Abort();
+                        }
+                    }
+                    else
+                    {
+                        return Fail("Expected ',' or closing bracket");
+                    }
+                }
+            }
+        }
+    }
+
+    const char *GetError() const
+    {
+        return mError;
+    }
+
+    size_t GetErrorOffset() const
+    {
+        return mErrorOffset;
+    }
+
+private:
+    // Parses the value at the cursor, 'complete' is set to false if the
+    // value is a non-empty container whose first element follows.
+    template <class Handler>
+    bool ParseValue(Handler &handler, bool &complete)
+    {
+        SkipWhitespace();
+
+        if (mCursor >= mEnd)
+        {
+            return Fail("Unexpected end of input");
+        }
+
+        complete = true;
+
+        const char c = *mCursor;
+        if ('{' == c || '[' == c)
+        {
+            mCursor++;
+
+            if (MAX_DEPTH <= mDepth)
+            {
+                return Fail("Nesting too deep");
+            }
+
+            const bool isObject = ('{' == c);
+            if (!(isObject ? handler.BeginObject() : handler.BeginArray()))
+            {
+                return Abort();
+            }
+
+            SkipWhitespace();
+            if (mCursor < mEnd &&
+                *mCursor == (isObject ? '}' : ']'))
+            {
+                mCursor++;
+                if (!(isObject ? handler.EndObject() : handler.EndArray()))
+                {
+                    return Abort();
+                }
+                return true;
+            }
+
+            mStack[mDepth] = c;
+            mDepth++;
+            complete = false;
+
+            if (isObject)
+            {
+                return ParseKey(handler);
+            }
+            return true;
+        }
+        else if ('\"' == c)
+        {
+            char *text;
+            size_t length;
+            if (!ParseString(text, length))
+            {
+                return false;
+            }
+            if (!handler.String(text, length))
+            {
+                return Abort();
+            }
+            return true;
+        }
+        else if ('t' == c)
+        {
+            if (!ParseLiteral("true", 4))
+            {
+                return false;
+            }
+            if (!handler.Boolean(true))
+            {
+                return Abort();
+            }
+            return true;
+        }
+        else if ('f' == c)
+        {
+            if (!ParseLiteral("false", 5))
+            {
+                return false;
+            }
+            if (!handler.Boolean(false))
+            {
+                return Abort();
+            }
+            return true;
+        }
+        else if ('n' == c)
+        {
+            if (!ParseLiteral("null", 4))
+            {
+                return false;
+            }
+            if (!handler.Null())
+            {
+                return Abort();
+            }
+            return true;
+        }
+        else
+        {
+            double value;
+            if (!ParseNumber(value))
+            {
+                return false;
+            }
+            if (!handler.Number(value))
+            {
+                return Abort();
+            }
+            return true;
+        }
+    }
+
+    template <class Handler>
+    bool ParseKey(Handler &handler)
+    {
+        SkipWhitespace();
+
+        if (mCursor >= mEnd || '\"' != *mCursor)
+        {
+            return Fail("Expected object key");
+        }
+
+        char *text;
+        size_t length;
+        if (!ParseString(text, length))
+        {
+            return false;
+        }
+
+        SkipWhitespace();
+
+        if (mCursor >= mEnd || ':' != *mCursor)
+        {
+            return Fail("Expected ':' after object key");
+        }
+        mCursor++;
+
+        if (!handler.Key(text, length))
+        {
+            return Abort();
+        }
+        return true;
+    }
+
+    bool ParseString(char *&text, size_t &length)
+    {
+        mCursor++; // skip opening quote
+
+        char * const start = mCursor;
+        char * const end = mEnd;
+        char *cursor = start;
+
+        // Fast scan while there is nothing to unescape
+        while (cursor < end)
+        {
+            const char c = *cursor;
+            if ('\"' == c || '\\' == c || (unsigned char)c < 0x20)
+            {
+                break;
+            }
+            cursor++;
+        }
+
+        char *write = cursor;
+        while (cursor < end)
+        {
+            const char c = *cursor;
+            if ('\"' == c)
+            {
+                mCursor = (cursor + 1);
+                text = start;
+                length = (size_t)(write - start);
+                return true;
+            }
+            else if ('\\' == c)
+            {
+                cursor++;
+                if (cursor >= end)
+                {
+                    break;
+                }
+
+                const char e = *cursor;
+                cursor++;
+                switch (e)
+                {
+                case '\"': *write++ = '\"'; break;
+                case '\\': *write++ = '\\'; break;
+                case '/':  *write++ = '/';  break;
+                case 'b':  *write++ = '\b'; break;
+                case 'f':  *write++ = '\f'; break;
+                case 'n':  *write++ = '\n'; break;
+                case 'r':  *write++ = '\r'; break;
+                case 't':  *write++ = '\t'; break;
+                case 'u':
+                    {
+                        unsigned codepoint;
+                        if (!ParseHex4(cursor, codepoint))
+                        {
+                            return false;
+                        }
+                        if (0xD800 <= codepoint && codepoint <= 0xDBFF)
+                        {
+                            unsigned low;
+                            if ((cursor + 2) > end ||
+                                '\\' != cursor[0] ||
+                                'u' != cursor[1])
+                            {
+                                mCursor = cursor;
+                                return Fail("Invalid surrogate pair");
+                            }
+                            cursor += 2;
+                            if (!ParseHex4(cursor, low) ||
+                                low < 0xDC00 || 0xDFFF < low)
+                            {
+                                mCursor = cursor;
+                                return Fail("Invalid surrogate pair");
+                            }
+                            codepoint = (0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00));
+                        }
+                        write = EncodeUTF8(write, codepoint);
+                    }
+                    break;
+                default:
+                    mCursor = (cursor - 1);
+                    return Fail("Invalid escape sequence");
+                }
+            }
+            else if ((unsigned char)c < 0x20)
+            {
+                mCursor = cursor;
+                return Fail("Control character in string");
+            }
+            else
+            {
+                *write++ = c;
+                cursor++;
+            }
+        }
+
+        mCursor = end;
+        return Fail("Unterminated string");
+    }
+
+    bool ParseHex4(char *&cursor, unsigned &value)
+    {
+        if ((cursor + 4) > mEnd)
+        {
+            mCursor = cursor;
+            return Fail("Invalid unicode escape");
+        }
+
+        value = 0;
+        for (int n = 0; n < 4; n++)
+        {
+            const char h = cursor[n];
+            value <<= 4;
+            if ('0' <= h && h <= '9')
+            {
+                value |= (unsigned)(h - '0');
+            }
+            else if ('a' <= h && h <= 'f')
+            {
+                value |= (unsigned)(h - 'a' + 10);
+            }
+            else if ('A' <= h && h <= 'F')
+            {
+                value |= (unsigned)(h - 'A' + 10);
+            }
+            else
+            {
+                mCursor = (cursor + n);
+                return Fail("Invalid unicode escape");
+            }
+        }
+        cursor += 4;
+        return true;
+    }
+
+    // The UTF-8 encoding is never longer than the escape sequence it replaces
+    static char *EncodeUTF8(char *write, unsigned codepoint)
+    {
+        if (codepoint < 0x80)
+        {
+            *write++ = (char)codepoint;
+        }
+        else if (codepoint < 0x800)
+        {
+            *write++ = (char)(0xC0 | (codepoint >> 6));
+            *write++ = (char)(0x80 | (codepoint & 0x3F));
+        }
+        else if (codepoint < 0x10000)
+        {
+            *write++ = (char)(0xE0 | (codepoint >> 12));
+            *write++ = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+            *write++ = (char)(0x80 | (codepoint & 0x3F));
+        }
+        else
+        {
+            *write++ = (char)(0xF0 | (codepoint >> 18));
+            *write++ = (char)(0x80 | ((codepoint >> 12) & 0x3F));
+            *write++ = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+            *write++ = (char)(0x80 | (codepoint & 0x3F));
+        }
+        return write;
+    }
+
+    bool ParseLiteral(const char *literal, size_t length)
+    {
+        if ((size_t)(mEnd - mCursor) < length ||
+            0 != memcmp(mCursor, literal, length))
+        {
+            return Fail("Invalid literal");
+        }
+        mCursor += length;
+        return true;
+    }
+
+    // Numbers with up to 15 significant digits and a small decimal exponent
+    // are converted with a single exactly rounded multiplication or division,
+    // anything else falls back to strtod.
+    bool ParseNumber(double &value)
+    {
+        static const double powersOf10[] =
+        {
+            1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+            1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+            1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+
+        const char * const start = mCursor;
+        const char * const end = mEnd;
+        const char *cursor = start;
+
+        bool negative = false;
+        if (cursor < end && '-' == *cursor)
+        {
+            negative = true;
+            cursor++;
+        }
+
+        if (cursor >= end || !IsDigit(*cursor))
+        {
+            return Fail("Invalid value");
+        }
+
+        unsigned long long mantissa = 0;
+        int numDigits = 0;
+        int exponent = 0;
+        bool exact = true;
+
+        if ('0' == *cursor)
+        {
+            cursor++;
+        }
+        else
+        {
+            do
+            {
+                if (numDigits < 19)
+                {
+                    mantissa = ((mantissa * 10) + (unsigned)(*cursor - '0'));
+                    numDigits++;
+                }
+                else
+                {
+                    exponent++;
+                    exact = false;
+                }
+                cursor++;
+            }
+            while (cursor < end && IsDigit(*cursor));
+        }
+
+        if (cursor < end && '.' == *cursor)
+        {
+            cursor++;
+            if (cursor >= end || !IsDigit(*cursor))
+            {
+                mCursor = (char *)cursor;
+                return Fail("Invalid number");
+            }
+            do
+            {
+                if (numDigits < 19)
+                {
+                    mantissa = ((mantissa * 10) + (unsigned)(*cursor - '0'));
+                    if (0 != mantissa)
+                    {
+                        numDigits++;
+                    }
+                    exponent--;
+                }
+                else
+                {
+                    exact = false;
+                }
+                cursor++;
+            }
+            while (cursor < end && IsDigit(*cursor));
+        }
+
+        if (cursor < end && ('e' == *cursor || 'E' == *cursor))
+        {
+            cursor++;
+            bool negativeExponent = false;
+            if (cursor < end && ('+' == *cursor || '-' == *cursor))
+            {
+                negativeExponent = ('-' == *cursor);
+                cursor++;
+            }
+            if (cursor >= end || !IsDigit(*cursor))
+            {
+                mCursor = (char *)cursor;
+                return Fail("Invalid number");
+            }
+            int explicitExponent = 0;
+            do
+            {
+                if (explicitExponent < 100000)
+                {
+                    explicitExponent = ((explicitExponent * 10) + (*cursor - '0'));
+                }
+                cursor++;
+            }
+            while (cursor < end && IsDigit(*cursor));
+            exponent += (negativeExponent ? -explicitExponent : explicitExponent);
+        }
+
+        if (0 == mantissa)
+        {
+            value = (negative ? -0.0 : 0.0);
+        }
+        else if (exact &&
+                 numDigits <= 15 &&
+                 -22 <= exponent && exponent <= 22)
+        {
+            value = (double)mantissa;
+            if (0 > exponent)
+            {
+                value /= powersOf10[-exponent];
+            }
+            else
+            {
+                value *= powersOf10[exponent];
+            }
+            if (negative)
+            {
+                value = -value;
+            }
+        }
+        else
+        {
+            // The input is not NUL terminated so strtod works on a copy
+            const size_t length = (size_t)(cursor - start);
+            char buffer[64];
+            if (length < sizeof(buffer))
+            {
+                memcpy(buffer, start, length);
+                buffer[length] = '\0';
+                value = strtod(buffer, NULL);
+            }
+            else
+            {
+                const std::string number(start, length);
+                value = strtod(number.c_str(), NULL);
+            }
+        }
+
+        mCursor = (char *)cursor;
+        return true;
+    }
+
+    static bool IsDigit(char c)
+    {
+        return ('0' <= c && c <= '9');
+    }
+
+    void SkipWhitespace()
+    {
+        const char * const end = mEnd;
+        char *cursor = mCursor;
+        while (cursor < end)
+        {
+            const char c = *cursor;
+            if (' ' != c && '\n' != c && '\r' != c && '\t' != c)
+            {
+                break;
+            }
+            cursor++;
+        }
+        mCursor = cursor;
+    }
+
+    bool Fail(const char *error)
+    {
+        mError = error;
+        mErrorOffset = (size_t)(mCursor - mBegin);
+        return false;
+    }
+
+    bool Abort()
+    {
+        return Fail("Parsing stopped by handler");
+    }
+
+    char       *mBegin;
+    char       *mCursor;
+    char       *mEnd;
+    unsigned    mDepth;
+    const char *mError;
+    size_t      mErrorOffset;
+    char        mStack[MAX_DEPTH];
+};
+
+#endif // __JSONREADER_H__
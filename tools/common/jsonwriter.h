@@ -0,0 +1,311 @@
+// Copyright (c) 2015 Turbulenz Limited
+#ifndef __JSONWRITER_H__
+#define __JSONWRITER_H__
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#include "jsonreader.h"
+#include "jsonnode.h"
+#include <stdio.h>
+#include <vector>
+
+//
+// JSONStreamWriter
+//
+// Writes JSON events straight to a file, can also be used as a JSONReader
+// handler to pass a document through.
+//
+class JSONStreamWriter
+{
+public:
+    enum
+    {
+        MAX_DEPTH = JSONReader::MAX_DEPTH
+    };
+
+    JSONStreamWriter() :
+      mFile(NULL),
+      mIndentationStep(0),
+      mDepth(0),
+      mAfterKey(false)
+    {
+        mFirst[0] = true;
+    }
+
+    ~JSONStreamWriter()
+    {
+        if (NULL != mFile)
+        {
+            fclose(mFile);
+        }
+    }
+
+    bool Initialize(const char *filename, int indentationStep)
+    {
+        mFile = fopen(filename, "wb");
+        mIndentationStep = indentationStep;
+        return (NULL != mFile);
+    }
+
+    bool Close()
+    {
+        if (mIndentationStep)
+        {
+            fputc('\n', mFile);
+        }
+        const bool failed = (0 != ferror(mFile));
+        fclose(mFile);
+        mFile = NULL;
+        return !failed;
+    }
+
+    bool Null()
+    {
+        Separator();
+        fwrite("null", 1, 4, mFile);
+        return true;
+    }
+
+    bool Boolean(bool value)
+    {
+        Separator();
+        if (value)
+        {
+            fwrite("true", 1, 4, mFile);
+        }
+        else
+        {
+            fwrite("false", 1, 5, mFile);
+        }
+        return true;
+    }
+
+    bool Number(double value)
+    {
+        Separator();
+        WriteNumber(value);
+        return true;
+    }
+
+    bool String(const char *text, size_t length)
+    {
+        Separator();
+        WriteString(text, length);
+        return true;
+    }
+
+    bool Key(const char *text, size_t length)
+    {
+        Separator();
+        WriteString(text, length);
+        fputc(':', mFile);
+        if (mIndentationStep)
+        {
+            fputc(' ', mFile);
+        }
+        mAfterKey = true;
+        return true;
+    }
+
+    bool BeginObject()
+    {
+        return Begin('{');
+    }
+
+    bool EndObject()
+    {
+        return End('}');
+    }
+
+    bool BeginArray()
+    {
+        return Begin('[');
+    }
+
+    bool EndArray()
+    {
+        return End(']');
+    }
+
+    // Numbers arrays are written in a single line
+    void NumberArray(const std::vector<double> &numbers)
+    {
+        Separator();
+        fputc('[', mFile);
+        const size_t numNumbers = numbers.size();
+        for (size_t n = 0; n < numNumbers; n++)
+        {
+            if (0 < n)
+            {
+                fputc(',', mFile);
+            }
+            WriteNumber(numbers[n]);
+        }
+        fputc(']', mFile);
+    }
+
+    void Node(const JSONNode *node)
+    {
+        switch (node->mType)
+        {
+        case JSONNode::TYPE_NULL:
+            Null();
+            break;
+        case JSONNode::TYPE_BOOLEAN:
+            Boolean(node->mBoolean);
+            break;
+        case JSONNode::TYPE_NUMBER:
+            Number(node->mNumber);
+            break;
+        case JSONNode::TYPE_STRING:
+            String(node->mString.c_str(), node->mString.size());
+            break;
+        case JSONNode::TYPE_ARRAY:
+            if (node->mNumbersOnly)
+            {
+                NumberArray(node->mNumbers);
+            }
+            else
+            {
+                BeginArray();
+                for (size_t n = 0; n < node->mElements.size(); n++)
+                {
+                    Node(node->mElements[n]);
+                }
+                EndArray();
+            }
+            break;
+        case JSONNode::TYPE_OBJECT:
+            BeginObject();
+            for (size_t n = 0; n < node->mMembers.size(); n++)
+            {
+                const JSONNode::Member &member = node->mMembers[n];
+                Key(member.first.c_str(), member.first.size());
+                Node(member.second);
+            }
+            EndObject();
+            break;
+        }
+    }
+
+private:
+    bool Begin(char bracket)
+    {
+        if (MAX_DEPTH <= (mDepth + 1))
+        {
+            return false;
+        }
+        Separator();
+        fputc(bracket, mFile);
+        mDepth++;
+        mFirst[mDepth] = true;
+        return true;
+    }
+
+    bool End(char bracket)
+    {
+        const bool empty = mFirst[mDepth];
+        mDepth--;
+        if (!empty)
+        {
+            Indent();
+        }
+        fputc(bracket, mFile);
+        return true;
+    }
+
+    void Separator()
+    {
+        if (mAfterKey)
+        {
+            mAfterKey = false;
+            return;
+        }
+        if (0 < mDepth)
+        {
+            if (mFirst[mDepth])
+            {
+                mFirst[mDepth] = false;
+            }
+            else
+            {
+                fputc(',', mFile);
+            }
+            Indent();
+        }
+    }
+
+    void Indent()
+    {
+        if (mIndentationStep)
+        {
+            fputc('\n', mFile);
+            for (int n = (mDepth * mIndentationStep); 0 < n; n--)
+            {
+                fputc(' ', mFile);
+            }
+        }
+    }
+
+    void WriteNumber(double value)
+    {
+        const int valueInt = (int)value;
+        if ((double)valueInt == value)
+        {
+            fprintf(mFile, "%d", valueInt);
+        }
+        else
+        {
+            fprintf(mFile, "%.15g", value);
+        }
+    }
+
+    void WriteString(const char *text, size_t length)
+    {
+        fputc('\"', mFile);
+        const char * const end = (text + length);
+        while (text < end)
+        {
+            const unsigned char c = (unsigned char)*text++;
+            if ('\"' == c || '\\' == c)
+            {
+                fputc('\\', mFile);
+                fputc(c, mFile);
+            }
+            else if (c < 0x20)
+            {
+                if ('\n' == c)
+                {
+                    fputs("\\n", mFile);
+                }
+                else if ('\t' == c)
+                {
+                    fputs("\\t", mFile);
+                }
+                else if ('\r' == c)
+                {
+                    fputs("\\r", mFile);
+                }
+                else
+                {
+                    fprintf(mFile, "\\u%04x", c);
+                }
+            }
+            else
+            {
+                fputc(c, mFile);
+            }
+        }
+        fputc('\"', mFile);
+    }
+
+    FILE *mFile;
+    int   mIndentationStep;
+    int   mDepth;
+    bool  mAfterKey;
+    bool  mFirst[MAX_DEPTH];
+};
+
+#endif // __JSONWRITER_H__
@@ -0,0 +1,237 @@
+// Copyright (c) 2015 Turbulenz Limited
+#ifndef __MAPPEDFILE_H__
+#define __MAPPEDFILE_H__
+
+#ifdef _MSC_VER
+#pragma once
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+//
+// MappedFile
+//
+// Maps a whole file copy-on-write for parsing in place. Pages that are only
+// read stay backed by the file, so the resident memory of a sequential parse
+// is bounded by what the kernel chooses to keep cached rather than by the
+// size of the file. Falls back to reading the file into memory when it can
+// not be mapped (pipes, special files).
+//
+class MappedFile
+{
+public:
+    MappedFile() :
+      mData(NULL),
+      mSize(0),
+      mMapped(false)
+#ifdef _WIN32
+      , mFile(INVALID_HANDLE_VALUE),
+      mMapping(NULL)
+#endif
+    {
+    }
+
+    ~MappedFile()
+    {
+        Close();
+    }
+
+    bool Open(const char *fileName)
+    {
+        Close();
+        if (Map(fileName))
+        {
+            return true;
+        }
+        return Read(fileName);
+    }
+
+    void Close()
+    {
+        if (mMapped)
+        {
+#ifdef _WIN32
+            UnmapViewOfFile(mData);
+            CloseHandle(mMapping);
+            CloseHandle(mFile);
+            mMapping = NULL;
+            mFile = INVALID_HANDLE_VALUE;
+#else
+            munmap(mData, mSize);
+#endif
+        }
+        else
+        {
+            free(mData);
+        }
+        mData = NULL;
+        mSize = 0;
+        mMapped = false;
+    }
+
+    char *GetData() const
+    {
+        return mData;
+    }
+
+    size_t GetSize() const
+    {
+        return mSize;
+    }
+
+    bool IsMapped() const
+    {
+        return mMapped;
+    }
+
+private:
+    MappedFile(const MappedFile &);
+    MappedFile &operator=(const MappedFile &);
+
+#ifdef _WIN32
+    bool Map(const char *fileName)
+    {
+        HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, NULL,
+                                  OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (INVALID_HANDLE_VALUE == file)
+        {
+            return false;
+        }
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size) ||
+            0 == size.QuadPart ||
+            (unsigned long long)size.QuadPart != (size_t)size.QuadPart)
+        {
+            CloseHandle(file);
+            return false;
+        }
+
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+        if (NULL == mapping)
+        {
+            CloseHandle(file);
+            return false;
+        }
+
+        void *data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+        if (NULL == data)
+        {
+            CloseHandle(mapping);
+            CloseHandle(file);
+            return false;
+        }
+
+        mFile = file;
+        mMapping = mapping;
+        mData = (char *)data;
+        mSize = (size_t)size.QuadPart;
+        mMapped = true;
+        return true;
+    }
+#else
+    bool Map(const char *fileName)
+    {
+        const int fd = open(fileName, O_RDONLY);
+        if (0 > fd)
+        {
+            return false;
+        }
+
+        struct stat st;
+        if (0 != fstat(fd, &st) ||
+            !S_ISREG(st.st_mode) ||
+            0 == st.st_size)
+        {
+            close(fd);
+            return false;
+        }
+
+        const size_t size = (size_t)st.st_size;
+        void *data = mmap(NULL, size, (PROT_READ | PROT_WRITE), MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (MAP_FAILED == data)
+        {
+            return false;
+        }
+
+#ifdef MADV_SEQUENTIAL
+        madvise(data, size, MADV_SEQUENTIAL);
+#endif
+
+        mData = (char *)data;
+        mSize = size;
+        mMapped = true;
+        return true;
+    }
+#endif
+
+    bool Read(const char *fileName)
+    {
+        FILE *f = fopen(fileName, "rb");
+        if (NULL == f)
+        {
+            return false;
+        }
+
+        size_t capacity = 0;
+        size_t size = 0;
+        char *data = NULL;
+        for (;;)
+        {
+            if (size == capacity)
+            {
+                capacity = (0 == capacity ? (64 * 1024) : (capacity * 2));
+                char *newData = (char *)realloc(data, capacity);
+                if (NULL == newData)
+                {
+                    free(data);
+                    fclose(f);
+                    return false;
+                }
+                data = newData;
+            }
+
+            const size_t read = fread((data + size), 1, (capacity - size), f);
+            if (0 == read)
+            {
+                break;
+            }
+            size += read;
+        }
+
+        const bool failed = (0 != ferror(f));
+        fclose(f);
+        if (failed)
+        {
+            free(data);
+            return false;
+        }
+
+        mData = data;
+        mSize = size;
+        mMapped = false;
+        return true;
+    }
+
+    char    *mData;
+    size_t  mSize;
+    bool    mMapped;
+#ifdef _WIN32
+    HANDLE  mFile;
+    HANDLE  mMapping;
+#endif
+};
+
+#endif // __MAPPEDFILE_H__
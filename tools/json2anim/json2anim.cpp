@@ -0,0 +1,991 @@
+// Copyright (c) 2015 Turbulenz Limited
+
+#include "../common/jsonreader.h"
+#include "../common/mappedfile.h"
+#include "../common/jsonnode.h"
+#include "../common/jsonwriter.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#define VERSION_STRING "json2anim 0.1"
+
+//
+// Binary animation container layout:
+//
+//   0: 'TZAB'
+//   4: uint32 version
+//   8: uint32 number of animations
+//  12: uint32 reserved
+//  16: per animation, a block of uint16 values starting at a 4 byte aligned
+//      offset
+//
+// All values are little endian. Every animated channel of a node stores its
+// key times followed by 3 uint16 values per key:
+//
+//   time         - key time in units of binary.timeScale
+//   rotation     - smallest three: the 3 smallest quaternion components
+//                  mapped from [-1/sqrt(2), 1/sqrt(2)] to 0..32766, the top
+//                  bits of the first two values hold the index of the largest
+//                  component, which is always positive
+//   translation  - min + (value * step) per component
+//   scale        - min + (value * step) per component
+//
+// The JSON output keeps everything but the keyframes, each animation gets a
+// 'binary' object with the location of its block and each animated node a
+// 'channels' object with the location and range of its tracks.
+//
+
+static const uint32_t ANIMATION_VERSION = 1;
+static const uint32_t ANIMATION_ALIGNMENT = 4;
+
+static const double SQRT_HALF = 0.70710678118654752440;
+
+static bool sVerbose = false;
+static double sRotationTolerance = 0.0005;
+static double sTranslationTolerance = 0.0001;
+static double sScaleTolerance = 0.0001;
+
+void ErrorMessage(const char *message, ...);
+
+// -----------------------------------------------------------------------------
+// Tracks
+// -----------------------------------------------------------------------------
+
+enum TrackType
+{
+    TRACK_ROTATION,
+    TRACK_TRANSLATION,
+    TRACK_SCALE,
+    NUM_TRACK_TYPES
+};
+
+static const char * const sTrackNames[NUM_TRACK_TYPES] =
+{
+    "rotation",
+    "translation",
+    "scale"
+};
+
+static const unsigned sTrackDimensions[NUM_TRACK_TYPES] = { 4, 3, 3 };
+
+struct Track
+{
+    TrackType           type;
+    std::vector<double> times;
+    std::vector<double> values;
+
+    unsigned Dimension() const
+    {
+        return sTrackDimensions[type];
+    }
+
+    size_t NumKeys() const
+    {
+        return times.size();
+    }
+
+    const double *Value(size_t key) const
+    {
+        return &values[key * Dimension()];
+    }
+};
+
+static void NormalizeQuat(double *q)
+{
+    const double lengthSq = ((q[0] * q[0]) + (q[1] * q[1]) + (q[2] * q[2]) + (q[3] * q[3]));
+    if (0.0 < lengthSq)
+    {
+        const double scale = (1.0 / sqrt(lengthSq));
+        q[0] *= scale;
+        q[1] *= scale;
+        q[2] *= scale;
+        q[3] *= scale;
+    }
+    else
+    {
+        q[0] = q[1] = q[2] = 0.0;
+        q[3] = 1.0;
+    }
+}
+
+// Matches the shortest path slerp used at runtime, including returning the
+// first rotation when both are almost the same
+static void InterpolateQuat(const double *q1, const double *q2, double t, double *result)
+{
+    double cosom = ((q1[0] * q2[0]) + (q1[1] * q2[1]) + (q1[2] * q2[2]) + (q1[3] * q2[3]));
+    double sign = 1.0;
+    if (cosom < 0.0)
+    {
+        cosom = -cosom;
+        sign = -1.0;
+    }
+
+    double scale1, scale2;
+    if (cosom > (1.0 - 1e-6))
+    {
+        scale1 = 1.0;
+        scale2 = 0.0;
+    }
+    else
+    {
+        const double omega = acos(cosom);
+        const double invSinOmega = (1.0 / sin(omega));
+        scale1 = (sin((1.0 - t) * omega) * invSinOmega);
+        scale2 = (sin(t * omega) * invSinOmega);
+    }
+
+    for (unsigned n = 0; n < 4; n++)
+    {
+        result[n] = ((sign * scale1 * q1[n]) + (scale2 * q2[n]));
+    }
+    NormalizeQuat(result);
+}
+
+// Angle between two rotations, in radians
+static double QuatError(const double *q1, const double *q2)
+{
+    double cosom = fabs((q1[0] * q2[0]) + (q1[1] * q2[1]) + (q1[2] * q2[2]) + (q1[3] * q2[3]));
+    if (cosom > 1.0)
+    {
+        cosom = 1.0;
+    }
+    return (2.0 * acos(cosom));
+}
+
+static double VectorError(const double *v1, const double *v2)
+{
+    double error = 0.0;
+    for (unsigned n = 0; n < 3; n++)
+    {
+        const double d = fabs(v1[n] - v2[n]);
+        if (error < d)
+        {
+            error = d;
+        }
+    }
+    return error;
+}
+
+static double KeyError(const Track &track, const double *a, const double *b)
+{
+    if (TRACK_ROTATION == track.type)
+    {
+        return QuatError(a, b);
+    }
+    return VectorError(a, b);
+}
+
+static void Interpolate(const Track &track, size_t key1, size_t key2, double time, double *result)
+{
+    const double t1 = track.times[key1];
+    const double t2 = track.times[key2];
+    const double t = ((t2 > t1) ? ((time - t1) / (t2 - t1)) : 0.0);
+    const double *v1 = track.Value(key1);
+    const double *v2 = track.Value(key2);
+    if (TRACK_ROTATION == track.type)
+    {
+        InterpolateQuat(v1, v2, t, result);
+    }
+    else
+    {
+        for (unsigned n = 0; n < 3; n++)
+        {
+            result[n] = (v1[n] + ((v2[n] - v1[n]) * t));
+        }
+    }
+}
+
+// Checks the keys between key1 and key2 can be rebuilt by interpolating them
+static bool CanSkipKeys(const Track &track, size_t key1, size_t key2, double tolerance)
+{
+    double result[4];
+    for (size_t key = (key1 + 1); key < key2; key++)
+    {
+        Interpolate(track, key1, key2, track.times[key], result);
+        if (KeyError(track, result, track.Value(key)) > tolerance)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Greedily extends every segment for as long as the skipped keys stay within
+// the tolerance, tracks that do not change collapse into a single key
+static void ReduceKeys(Track &track, double tolerance)
+{
+    const size_t numKeys = track.NumKeys();
+    const unsigned dimension = track.Dimension();
+    if (numKeys <= 1)
+    {
+        return;
+    }
+
+    bool constant = true;
+    for (size_t key = 1; key < numKeys; key++)
+    {
+        if (KeyError(track, track.Value(0), track.Value(key)) > tolerance)
+        {
+            constant = false;
+            break;
+        }
+    }
+
+    std::vector<size_t> keep;
+    keep.push_back(0);
+    if (!constant)
+    {
+        size_t start = 0;
+        while (start < (numKeys - 1))
+        {
+            size_t end = (start + 1);
+            while ((end + 1) < numKeys &&
+                   CanSkipKeys(track, start, (end + 1), tolerance))
+            {
+                end++;
+            }
+            keep.push_back(end);
+            start = end;
+        }
+    }
+
+    std::vector<double> times;
+    std::vector<double> values;
+    for (size_t n = 0; n < keep.size(); n++)
+    {
+        const size_t key = keep[n];
+        times.push_back(track.times[key]);
+        const double *value = track.Value(key);
+        values.insert(values.end(), value, (value + dimension));
+    }
+    track.times.swap(times);
+    track.values.swap(values);
+}
+
+// -----------------------------------------------------------------------------
+// AnimationPacker
+// -----------------------------------------------------------------------------
+
+class AnimationPacker
+{
+public:
+    AnimationPacker() :
+      mFile(NULL),
+      mOffset(0),
+      mNumAnimations(0),
+      mNumKeysIn(0),
+      mNumKeysOut(0),
+      mBytesIn(0),
+      mBytesOut(0)
+    {
+    }
+
+    ~AnimationPacker()
+    {
+        if (NULL != mFile)
+        {
+            fclose(mFile);
+        }
+    }
+
+    bool Initialize(const char *fileName)
+    {
+        mFile = fopen(fileName, "wb");
+        if (NULL == mFile)
+        {
+            return false;
+        }
+
+        const uint32_t header[4] = { 0x42415A54, ANIMATION_VERSION, 0, 0 };
+        WriteUInt32(header, 4);
+        return true;
+    }
+
+    bool Close()
+    {
+        // Patch the number of animations
+        fseek(mFile, 8, SEEK_SET);
+        WriteUInt32(&mNumAnimations, 1);
+
+        const bool failed = (0 != ferror(mFile));
+        fclose(mFile);
+        mFile = NULL;
+        return !failed;
+    }
+
+    bool Pack(const std::string &name, JSONNode *animation)
+    {
+        const JSONNode *lengthNode = animation->Find("length");
+        JSONNode *nodeDataArray = animation->Find("nodeData");
+        if (NULL == lengthNode ||
+            JSONNode::TYPE_NUMBER != lengthNode->mType ||
+            NULL == nodeDataArray ||
+            JSONNode::TYPE_ARRAY != nodeDataArray->mType)
+        {
+            ErrorMessage("Animation '%s' has no length or nodeData", name.c_str());
+            return false;
+        }
+
+        const double length = lengthNode->mNumber;
+        const double timeScale = ((0.0 < length) ? (length / 65535.0) : 1.0);
+
+        mData.clear();
+
+        const size_t numNodes = nodeDataArray->mElements.size();
+        for (size_t n = 0; n < numNodes; n++)
+        {
+            JSONNode *nodeData = nodeDataArray->mElements[n];
+            if (JSONNode::TYPE_OBJECT != nodeData->mType ||
+                NULL == nodeData->Find("keyframes"))
+            {
+                continue;
+            }
+
+            Track tracks[NUM_TRACK_TYPES];
+            if (!ExtractTracks(name, nodeData, tracks))
+            {
+                return false;
+            }
+
+            JSONNode *channels = new JSONNode(JSONNode::TYPE_OBJECT);
+            for (unsigned t = 0; t < NUM_TRACK_TYPES; t++)
+            {
+                Track &track = tracks[t];
+                if (tracks[t].times.empty())
+                {
+                    continue;
+                }
+
+                mNumKeysIn += track.NumKeys();
+                mBytesIn += (track.NumKeys() * (1 + track.Dimension()) * sizeof(float));
+
+                ReduceKeys(track, Tolerance(track.type));
+
+                // A single key matching the base frame is not needed at all
+                if (1 == track.NumKeys() && MatchesBaseFrame(nodeData, track))
+                {
+                    continue;
+                }
+
+                mNumKeysOut += track.NumKeys();
+                channels->Add(sTrackNames[t], WriteTrack(track, timeScale));
+            }
+
+            nodeData->Remove("keyframes");
+            if (channels->mMembers.empty())
+            {
+                delete channels;
+                nodeData->Remove("channels");
+            }
+            else
+            {
+                nodeData->Add("channels", channels);
+            }
+        }
+
+        while (0 != ((mData.size() * sizeof(uint16_t)) % ANIMATION_ALIGNMENT))
+        {
+            mData.push_back(0);
+        }
+
+        JSONNode *binary = new JSONNode(JSONNode::TYPE_OBJECT);
+        binary->Add("offset", JSONNode::CreateNumber((double)mOffset));
+        binary->Add("length", JSONNode::CreateNumber((double)mData.size()));
+        binary->Add("timeScale", JSONNode::CreateNumber(timeScale));
+        animation->Add("binary", binary);
+
+        if (!mData.empty())
+        {
+            WriteUInt16(&mData[0], mData.size());
+        }
+        mBytesOut += (mData.size() * sizeof(uint16_t));
+        mNumAnimations++;
+
+        if (sVerbose)
+        {
+            printf("%s: %u nodes, %u bytes\n", name.c_str(), (unsigned)numNodes,
+                   (unsigned)(mData.size() * sizeof(uint16_t)));
+        }
+        return true;
+    }
+
+    void PrintSummary() const
+    {
+        printf("Keys: %u -> %u, data: %u -> %u bytes (%.2fx)\n",
+               (unsigned)mNumKeysIn, (unsigned)mNumKeysOut,
+               (unsigned)mBytesIn, (unsigned)mBytesOut,
+               ((0 < mBytesOut) ? ((double)mBytesIn / (double)mBytesOut) : 0.0));
+    }
+
+private:
+    static double Tolerance(TrackType type)
+    {
+        if (TRACK_ROTATION == type)
+        {
+            return sRotationTolerance;
+        }
+        else if (TRACK_TRANSLATION == type)
+        {
+            return sTranslationTolerance;
+        }
+        return sScaleTolerance;
+    }
+
+    static bool GetValue(const JSONNode *node, unsigned dimension, double *value)
+    {
+        if (NULL == node ||
+            !node->IsNumberArray() ||
+            node->mNumbers.size() < dimension)
+        {
+            return false;
+        }
+        for (unsigned n = 0; n < dimension; n++)
+        {
+            value[n] = node->mNumbers[n];
+        }
+        return true;
+    }
+
+    static void DefaultValue(TrackType type, double *value)
+    {
+        const double defaults[NUM_TRACK_TYPES][4] =
+        {
+            { 0.0, 0.0, 0.0, 1.0 },
+            { 0.0, 0.0, 0.0, 0.0 },
+            { 1.0, 1.0, 1.0, 0.0 }
+        };
+        memcpy(value, defaults[type], (4 * sizeof(double)));
+    }
+
+    static bool MatchesBaseFrame(const JSONNode *nodeData, const Track &track)
+    {
+        const JSONNode *baseframe = nodeData->Find("baseframe");
+        double value[4];
+        if (NULL == baseframe ||
+            !GetValue(baseframe->Find(sTrackNames[track.type]), track.Dimension(), value))
+        {
+            return false;
+        }
+        if (TRACK_ROTATION == track.type)
+        {
+            NormalizeQuat(value);
+        }
+        return (KeyError(track, value, track.Value(0)) <= Tolerance(track.type));
+    }
+
+    // Supports both the keyframe objects written by dae2json and the flat
+    // arrays described by a 'channels' object
+    static bool ExtractTracks(const std::string &name, const JSONNode *nodeData, Track *tracks)
+    {
+        const JSONNode *keyframes = nodeData->Find("keyframes");
+        const JSONNode *baseframe = nodeData->Find("baseframe");
+        const JSONNode *channels = nodeData->Find("channels");
+
+        for (unsigned t = 0; t < NUM_TRACK_TYPES; t++)
+        {
+            tracks[t].type = (TrackType)t;
+        }
+
+        if (keyframes->IsNumberArray())
+        {
+            if (NULL == channels)
+            {
+                ErrorMessage("Animation '%s' has flat keyframes without channels", name.c_str());
+                return false;
+            }
+
+            const std::vector<double> &keys = keyframes->mNumbers;
+            for (unsigned t = 0; t < NUM_TRACK_TYPES; t++)
+            {
+                const JSONNode *channel = channels->Find(sTrackNames[t]);
+                if (NULL == channel)
+                {
+                    continue;
+                }
+
+                const JSONNode *offsetNode = channel->Find("offset");
+                const JSONNode *strideNode = channel->Find("stride");
+                const JSONNode *countNode = channel->Find("count");
+                Track &track = tracks[t];
+                const unsigned dimension = track.Dimension();
+                if (NULL == offsetNode || NULL == strideNode || NULL == countNode ||
+                    (unsigned)strideNode->mNumber != (dimension + 1))
+                {
+                    ErrorMessage("Animation '%s' has an invalid %s channel", name.c_str(), sTrackNames[t]);
+                    return false;
+                }
+
+                const size_t offset = (size_t)offsetNode->mNumber;
+                const size_t count = (size_t)countNode->mNumber;
+                if (keys.size() < (offset + (count * (dimension + 1))))
+                {
+                    ErrorMessage("Animation '%s' has a truncated %s channel", name.c_str(), sTrackNames[t]);
+                    return false;
+                }
+
+                for (size_t k = 0; k < count; k++)
+                {
+                    const double *key = &keys[offset + (k * (dimension + 1))];
+                    track.times.push_back(key[0]);
+                    track.values.insert(track.values.end(), (key + 1), (key + 1 + dimension));
+                }
+            }
+        }
+        else
+        {
+            bool present[NUM_TRACK_TYPES] = { false, false, false };
+            const size_t numKeys = keyframes->mElements.size();
+            for (size_t k = 0; k < numKeys; k++)
+            {
+                for (unsigned t = 0; t < NUM_TRACK_TYPES; t++)
+                {
+                    if (NULL != keyframes->mElements[k]->Find(sTrackNames[t]))
+                    {
+                        present[t] = true;
+                    }
+                }
+            }
+
+            for (unsigned t = 0; t < NUM_TRACK_TYPES; t++)
+            {
+                if (!present[t])
+                {
+                    continue;
+                }
+
+                Track &track = tracks[t];
+                const unsigned dimension = track.Dimension();
+                double base[4];
+                if (NULL == baseframe ||
+                    !GetValue(baseframe->Find(sTrackNames[t]), dimension, base))
+                {
+                    DefaultValue((TrackType)t, base);
+                }
+
+                for (size_t k = 0; k < numKeys; k++)
+                {
+                    const JSONNode *keyframe = keyframes->mElements[k];
+                    const JSONNode *time = keyframe->Find("time");
+                    if (NULL == time || JSONNode::TYPE_NUMBER != time->mType)
+                    {
+                        ErrorMessage("Animation '%s' has a keyframe without time", name.c_str());
+                        return false;
+                    }
+
+                    double value[4];
+                    if (!GetValue(keyframe->Find(sTrackNames[t]), dimension, value))
+                    {
+                        memcpy(value, base, sizeof(value));
+                    }
+
+                    track.times.push_back(time->mNumber);
+                    track.values.insert(track.values.end(), value, (value + dimension));
+                }
+            }
+        }
+
+        Track &rotations = tracks[TRACK_ROTATION];
+        for (size_t k = 0; k < rotations.NumKeys(); k++)
+        {
+            NormalizeQuat(&rotations.values[k * 4]);
+        }
+        return true;
+    }
+
+    static uint16_t Quantize(double value, double scale)
+    {
+        const double q = floor((value * scale) + 0.5);
+        if (q <= 0.0)
+        {
+            return 0;
+        }
+        if (q >= 65535.0)
+        {
+            return 65535;
+        }
+        return (uint16_t)q;
+    }
+
+    JSONNode *WriteTrack(const Track &track, double timeScale)
+    {
+        const size_t numKeys = track.NumKeys();
+
+        JSONNode *channel = new JSONNode(JSONNode::TYPE_OBJECT);
+        channel->Add("count", JSONNode::CreateNumber((double)numKeys));
+        channel->Add("offset", JSONNode::CreateNumber((double)mData.size()));
+
+        for (size_t k = 0; k < numKeys; k++)
+        {
+            mData.push_back(Quantize(track.times[k], (1.0 / timeScale)));
+        }
+
+        if (TRACK_ROTATION == track.type)
+        {
+            // An even number of steps keeps 0 exactly representable
+            const double step = ((2.0 * SQRT_HALF) / 32766.0);
+            for (size_t k = 0; k < numKeys; k++)
+            {
+                double q[4];
+                memcpy(q, track.Value(k), sizeof(q));
+
+                unsigned largest = 0;
+                for (unsigned n = 1; n < 4; n++)
+                {
+                    if (fabs(q[n]) > fabs(q[largest]))
+                    {
+                        largest = n;
+                    }
+                }
+                if (q[largest] < 0.0)
+                {
+                    q[0] = -q[0];
+                    q[1] = -q[1];
+                    q[2] = -q[2];
+                    q[3] = -q[3];
+                }
+
+                uint16_t values[3];
+                unsigned v = 0;
+                for (unsigned n = 0; n < 4; n++)
+                {
+                    if (n != largest)
+                    {
+                        uint16_t value = Quantize((q[n] + SQRT_HALF), (1.0 / step));
+                        if (32767 < value)
+                        {
+                            value = 32767;
+                        }
+                        values[v++] = value;
+                    }
+                }
+                values[0] = (uint16_t)(values[0] | ((largest & 1) << 15));
+                values[1] = (uint16_t)(values[1] | ((largest >> 1) << 15));
+                mData.insert(mData.end(), values, (values + 3));
+            }
+        }
+        else
+        {
+            double min[3], max[3];
+            for (unsigned n = 0; n < 3; n++)
+            {
+                min[n] = max[n] = track.Value(0)[n];
+            }
+            for (size_t k = 1; k < numKeys; k++)
+            {
+                const double *value = track.Value(k);
+                for (unsigned n = 0; n < 3; n++)
+                {
+                    if (min[n] > value[n])
+                    {
+                        min[n] = value[n];
+                    }
+                    if (max[n] < value[n])
+                    {
+                        max[n] = value[n];
+                    }
+                }
+            }
+
+            // Round trip through float so the runtime decodes exactly the
+            // same range that was used to quantize
+            double step[3];
+            JSONNode *minNode = new JSONNode(JSONNode::TYPE_ARRAY);
+            JSONNode *stepNode = new JSONNode(JSONNode::TYPE_ARRAY);
+            for (unsigned n = 0; n < 3; n++)
+            {
+                min[n] = (double)(float)min[n];
+                step[n] = (double)(float)((max[n] - min[n]) / 65535.0);
+                if (step[n] < 0.0)
+                {
+                    step[n] = 0.0;
+                }
+                minNode->AddNumber(min[n]);
+                stepNode->AddNumber(step[n]);
+            }
+            channel->Add("min", minNode);
+            channel->Add("step", stepNode);
+
+            for (size_t k = 0; k < numKeys; k++)
+            {
+                const double *value = track.Value(k);
+                for (unsigned n = 0; n < 3; n++)
+                {
+                    mData.push_back((0.0 < step[n]) ? Quantize((value[n] - min[n]), (1.0 / step[n])) : 0);
+                }
+            }
+        }
+
+        return channel;
+    }
+
+    void WriteUInt32(const uint32_t *values, size_t count)
+    {
+        for (size_t n = 0; n < count; n++)
+        {
+            const uint32_t value = values[n];
+            const unsigned char bytes[4] =
+            {
+                (unsigned char)(value & 0xff),
+                (unsigned char)((value >> 8) & 0xff),
+                (unsigned char)((value >> 16) & 0xff),
+                (unsigned char)((value >> 24) & 0xff)
+            };
+            fwrite(bytes, 1, 4, mFile);
+        }
+        mOffset += (uint32_t)(count * 4);
+    }
+
+    void WriteUInt16(const uint16_t *values, size_t count)
+    {
+        for (size_t n = 0; n < count; n++)
+        {
+            const uint16_t value = values[n];
+            const unsigned char bytes[2] =
+            {
+                (unsigned char)(value & 0xff),
+                (unsigned char)((value >> 8) & 0xff)
+            };
+            fwrite(bytes, 1, 2, mFile);
+        }
+        mOffset += (uint32_t)(count * 2);
+    }
+
+    FILE                    *mFile;
+    uint32_t                mOffset;
+    uint32_t                mNumAnimations;
+    std::vector<uint16_t>   mData;
+    size_t                  mNumKeysIn;
+    size_t                  mNumKeysOut;
+    size_t                  mBytesIn;
+    size_t                  mBytesOut;
+};
+
+// -----------------------------------------------------------------------------
+// Main
+// -----------------------------------------------------------------------------
+
+void ErrorMessage(const char *message, ...)
+{
+    va_list args;
+    va_start(args, message);
+    fputs("ERROR: ", stderr);
+    vfprintf(stderr, message, args);
+    fputc('\n', stderr);
+    va_end(args);
+}
+
+static std::string DefaultBinaryFileName(const char *outputFileName)
+{
+    std::string binaryFileName(outputFileName);
+    const size_t dot = binaryFileName.rfind('.');
+    const size_t slash = binaryFileName.find_last_of("/\\");
+    if (std::string::npos != dot &&
+        (std::string::npos == slash || dot > slash))
+    {
+        binaryFileName.erase(dot);
+    }
+    binaryFileName += ".bin";
+    return binaryFileName;
+}
+
+static void Usage()
+{
+    puts(VERSION_STRING);
+    puts("Usage: json2anim [options] -i <input.json> -o <output.json>");
+    puts("");
+    puts("Removes redundant animation keys, quantizes the remaining ones and");
+    puts("moves them to a binary file loaded with AnimationManager.loadData.");
+    puts("");
+    puts("  -i, --input=FILE        input JSON file");
+    puts("  -o, --output=FILE       output JSON file");
+    puts("  -b, --binary=FILE       output binary file (default output with .bin extension)");
+    puts("  -r, --rotation=N        rotation tolerance in radians (default 0.0005)");
+    puts("  -t, --translation=N     translation tolerance in units (default 0.0001)");
+    puts("  -s, --scale=N           scale tolerance (default 0.0001)");
+    puts("  -j, --json_indent=N     indentation step for the JSON output (default 0)");
+    puts("  -v, --verbose           print information about every animation");
+    puts("  -h, --help              show this message");
+    puts("  --version               show the version");
+}
+
+static bool GetOption(int argc, char **argv, int &argn,
+                      const char *shortName, const char *longName,
+                      const char *&value)
+{
+    const char *arg = argv[argn];
+    if (0 == strcmp(arg, shortName))
+    {
+        argn++;
+        if (argn >= argc)
+        {
+            ErrorMessage("Missing value for %s", shortName);
+            exit(1);
+        }
+        value = argv[argn];
+        return true;
+    }
+
+    const size_t longLength = strlen(longName);
+    if (0 == strncmp(arg, longName, longLength) && '=' == arg[longLength])
+    {
+        value = (arg + longLength + 1);
+        return true;
+    }
+    return false;
+}
+
+int main(int argc, char **argv)
+{
+    const char *inputFileName = NULL;
+    const char *outputFileName = NULL;
+    const char *binaryFileName = NULL;
+    int indentationStep = 0;
+
+    for (int argn = 1; argn < argc; argn++)
+    {
+        const char *value = NULL;
+        if (GetOption(argc, argv, argn, "-i", "--input", value))
+        {
+            inputFileName = value;
+        }
+        else if (GetOption(argc, argv, argn, "-o", "--output", value))
+        {
+            outputFileName = value;
+        }
+        else if (GetOption(argc, argv, argn, "-b", "--binary", value))
+        {
+            binaryFileName = value;
+        }
+        else if (GetOption(argc, argv, argn, "-r", "--rotation", value))
+        {
+            sRotationTolerance = atof(value);
+        }
+        else if (GetOption(argc, argv, argn, "-t", "--translation", value))
+        {
+            sTranslationTolerance = atof(value);
+        }
+        else if (GetOption(argc, argv, argn, "-s", "--scale", value))
+        {
+            sScaleTolerance = atof(value);
+        }
+        else if (GetOption(argc, argv, argn, "-j", "--json_indent", value))
+        {
+            indentationStep = atoi(value);
+        }
+        else if (0 == strcmp(argv[argn], "-v") ||
+                 0 == strcmp(argv[argn], "--verbose"))
+        {
+            sVerbose = true;
+        }
+        else if (0 == strcmp(argv[argn], "-h") ||
+                 0 == strcmp(argv[argn], "--help"))
+        {
+            Usage();
+            return 0;
+        }
+        else if (0 == strcmp(argv[argn], "--version"))
+        {
+            puts(VERSION_STRING);
+            return 0;
+        }
+        else
+        {
+            ErrorMessage("Unknown option %s", argv[argn]);
+            Usage();
+            return 1;
+        }
+    }
+
+    if (NULL == inputFileName || NULL == outputFileName)
+    {
+        Usage();
+        return 1;
+    }
+
+    std::string defaultBinaryFileName;
+    if (NULL == binaryFileName)
+    {
+        defaultBinaryFileName = DefaultBinaryFileName(outputFileName);
+        binaryFileName = defaultBinaryFileName.c_str();
+    }
+
+    JSONNode *root = NULL;
+    {
+        MappedFile file;
+        if (!file.Open(inputFileName) || 0 == file.GetSize())
+        {
+            ErrorMessage("Failed to read %s", inputFileName);
+            return 1;
+        }
+
+        JSONNodeBuilder builder;
+        JSONReader reader;
+        if (!reader.Parse(file.GetData(), file.GetSize(), builder))
+        {
+            ErrorMessage("%s:%u: %s", inputFileName, (unsigned)reader.GetErrorOffset(), reader.GetError());
+            return 1;
+        }
+        root = builder.Detach();
+    }
+
+    JSONNode *animations = root->Find("animations");
+    if (NULL == animations || JSONNode::TYPE_OBJECT != animations->mType)
+    {
+        ErrorMessage("No animations found in %s", inputFileName);
+        delete root;
+        return 1;
+    }
+
+    AnimationPacker packer;
+    if (!packer.Initialize(binaryFileName))
+    {
+        ErrorMessage("Failed to open %s", binaryFileName);
+        delete root;
+        return 1;
+    }
+
+    for (size_t n = 0; n < animations->mMembers.size(); n++)
+    {
+        JSONNode::Member &member = animations->mMembers[n];
+        if (JSONNode::TYPE_OBJECT == member.second->mType &&
+            !packer.Pack(member.first, member.second))
+        {
+            delete root;
+            return 1;
+        }
+    }
+
+    if (!packer.Close())
+    {
+        ErrorMessage("Failed to write %s", binaryFileName);
+        delete root;
+        return 1;
+    }
+
+    JSONStreamWriter writer;
+    if (!writer.Initialize(outputFileName, indentationStep))
+    {
+        ErrorMessage("Failed to open %s", outputFileName);
+        delete root;
+        return 1;
+    }
+    writer.Node(root);
+    delete root;
+    if (!writer.Close())
+    {
+        ErrorMessage("Failed to write %s", outputFileName);
+        return 1;
+    }
+
+    if (sVerbose)
+    {
+        packer.PrintSummary();
+    }
+    return 0;
+}
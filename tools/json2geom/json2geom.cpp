@@ -0,0 +1,1283 @@
+// Copyright (c) 2015 Turbulenz Limited
+
+#include "../common/jsonreader.h"
+#include "../common/mappedfile.h"
+#include "../common/jsonnode.h"
+#include "../common/jsonwriter.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <stdint.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+
+#define VERSION_STRING "json2geom 0.1"
+
+//
+// Binary geometry container layout:
+//
+//   0: 'TZGB'
+//   4: uint32 version
+//   8: uint32 number of shapes
+//  12: uint32 reserved
+//  16: per shape, interleaved vertex data followed by the index data of all
+//      its indexed surfaces, each block starting at a 16 byte aligned offset
+//
+// All values are little endian. The layout of every shape is described by a
+// 'binary' object added to its entry in the output JSON, which keeps
+// everything but the bulk vertex and index arrays.
+//
+
+static const uint32_t GEOMETRY_VERSION = 1;
+static const uint32_t GEOMETRY_ALIGNMENT = 16;
+
+static bool sVerbose = false;
+
+void ErrorMessage(const char *message, ...);
+
+// -----------------------------------------------------------------------------
+// Vertex formats
+// -----------------------------------------------------------------------------
+
+struct VertexFormat
+{
+    const char *name;
+    unsigned    numComponents;
+    unsigned    componentSize;
+    bool        isFloat;
+    bool        isSigned;
+    bool        normalized;
+};
+
+static const VertexFormat sVertexFormats[] =
+{
+    { "FLOAT1",   1, 4, true,  true,  false },
+    { "FLOAT2",   2, 4, true,  true,  false },
+    { "FLOAT3",   3, 4, true,  true,  false },
+    { "FLOAT4",   4, 4, true,  true,  false },
+    { "BYTE4N",   4, 1, false, true,  true  },
+    { "UBYTE4",   4, 1, false, false, false },
+    { "UBYTE4N",  4, 1, false, false, true  },
+    { "SHORT2N",  2, 2, false, true,  true  },
+    { "SHORT4N",  4, 2, false, true,  true  },
+    { "USHORT2N", 2, 2, false, false, true  },
+    { "USHORT4N", 4, 2, false, false, true  }
+};
+
+static const VertexFormat *FindVertexFormat(const char *name)
+{
+    for (size_t n = 0; n < (sizeof(sVertexFormats) / sizeof(sVertexFormats[0])); n++)
+    {
+        if (0 == strcmp(sVertexFormats[n].name, name))
+        {
+            return &sVertexFormats[n];
+        }
+    }
+    return NULL;
+}
+
+// Attribute locations used by the GraphicsDevice, only used for ordering
+struct SemanticInfo
+{
+    const char *name;
+    int         location;
+};
+
+static const SemanticInfo sSemantics[] =
+{
+    { "POSITION", 0 }, { "POSITION0", 0 },
+    { "BLENDWEIGHT", 1 }, { "BLENDWEIGHT0", 1 },
+    { "NORMAL", 2 }, { "NORMAL0", 2 },
+    { "COLOR", 3 }, { "COLOR0", 3 }, { "COLOR1", 4 }, { "SPECULAR", 4 },
+    { "FOGCOORD", 5 }, { "TESSFACTOR", 5 },
+    { "PSIZE", 6 }, { "PSIZE0", 6 },
+    { "BLENDINDICES", 7 }, { "BLENDINDICES0", 7 },
+    { "TEXCOORD", 8 }, { "TEXCOORD0", 8 }, { "TEXCOORD1", 9 },
+    { "TEXCOORD2", 10 }, { "TEXCOORD3", 11 }, { "TEXCOORD4", 12 },
+    { "TEXCOORD5", 13 }, { "TEXCOORD6", 14 }, { "TEXCOORD7", 15 },
+    { "TANGENT", 14 }, { "TANGENT0", 14 },
+    { "BINORMAL", 15 }, { "BINORMAL0", 15 },
+    { "ATTR0", 0 }, { "ATTR1", 1 }, { "ATTR2", 2 }, { "ATTR3", 3 },
+    { "ATTR4", 4 }, { "ATTR5", 5 }, { "ATTR6", 6 }, { "ATTR7", 7 },
+    { "ATTR8", 8 }, { "ATTR9", 9 }, { "ATTR10", 10 }, { "ATTR11", 11 },
+    { "ATTR12", 12 }, { "ATTR13", 13 }, { "ATTR14", 14 }, { "ATTR15", 15 }
+};
+
+static int FindSemanticLocation(const std::string &name)
+{
+    for (size_t n = 0; n < (sizeof(sSemantics) / sizeof(sSemantics[0])); n++)
+    {
+        if (name == sSemantics[n].name)
+        {
+            return sSemantics[n].location;
+        }
+    }
+    return -1;
+}
+
+static bool StartsWith(const std::string &text, const char *prefix)
+{
+    return (0 == text.compare(0, strlen(prefix), prefix));
+}
+
+struct VertexStream
+{
+    std::string                semantic;
+    int                        location;
+    unsigned                   offset;
+    unsigned                   stride;
+    const std::vector<double> *data;
+    JSONNode                  *source;
+    std::vector<double>        min;
+    std::vector<double>        max;
+    const VertexFormat        *format;
+
+    bool operator < (const VertexStream &other) const
+    {
+        return (location < other.location);
+    }
+
+    bool InRange(double minValue, double maxValue) const
+    {
+        for (unsigned n = 0; n < stride; n++)
+        {
+            if (min[n] < minValue || max[n] > maxValue)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+static const VertexFormat *ChooseVertexFormat(const VertexStream &stream, bool quantise)
+{
+    const std::string &semantic = stream.semantic;
+    const unsigned stride = stream.stride;
+
+    // Same choice the Scene makes at runtime
+    if (StartsWith(semantic, "BLENDINDICES"))
+    {
+        if (4 == stride && stream.InRange(0.0, 255.0))
+        {
+            return FindVertexFormat("UBYTE4");
+        }
+    }
+    else if (quantise)
+    {
+        if (StartsWith(semantic, "NORMAL") ||
+            StartsWith(semantic, "TANGENT") ||
+            StartsWith(semantic, "BINORMAL"))
+        {
+            if (3 <= stride && stride <= 4 && stream.InRange(-1.0, 1.0))
+            {
+                return FindVertexFormat("BYTE4N");
+            }
+        }
+        else if (StartsWith(semantic, "BLENDWEIGHT") ||
+                 StartsWith(semantic, "COLOR"))
+        {
+            if (stride <= 4 && stream.InRange(0.0, 1.0))
+            {
+                return FindVertexFormat("UBYTE4N");
+            }
+        }
+        else if (StartsWith(semantic, "TEXCOORD"))
+        {
+            if (2 == stride)
+            {
+                if (stream.InRange(0.0, 1.0))
+                {
+                    return FindVertexFormat("USHORT2N");
+                }
+                else if (stream.InRange(-1.0, 1.0))
+                {
+                    return FindVertexFormat("SHORT2N");
+                }
+            }
+            else if (stride <= 4 && stream.InRange(0.0, 1.0))
+            {
+                return FindVertexFormat("USHORT4N");
+            }
+        }
+    }
+
+    if (1 <= stride && stride <= 4)
+    {
+        static const char *floatFormats[] = { "FLOAT1", "FLOAT2", "FLOAT3", "FLOAT4" };
+        return FindVertexFormat(floatFormats[stride - 1]);
+    }
+
+    return NULL;
+}
+
+template <typename T>
+static T Quantise(double value, double scale, double minValue, double maxValue)
+{
+    double scaled = floor((value * scale) + 0.5);
+    if (scaled < minValue)
+    {
+        scaled = minValue;
+    }
+    else if (scaled > maxValue)
+    {
+        scaled = maxValue;
+    }
+    return (T)scaled;
+}
+
+static uint8_t *EncodeComponent(uint8_t *dest, const VertexFormat *format, double value)
+{
+    if (format->isFloat)
+    {
+        const float f = (float)value;
+        memcpy(dest, &f, 4);
+        return (dest + 4);
+    }
+
+    if (1 == format->componentSize)
+    {
+        if (format->isSigned)
+        {
+            const int8_t v = Quantise<int8_t>(value, (format->normalized ? 127.0 : 1.0), -127.0, 127.0);
+            memcpy(dest, &v, 1);
+        }
+        else
+        {
+            const uint8_t v = Quantise<uint8_t>(value, (format->normalized ? 255.0 : 1.0), 0.0, 255.0);
+            memcpy(dest, &v, 1);
+        }
+        return (dest + 1);
+    }
+    else
+    {
+        if (format->isSigned)
+        {
+            const int16_t v = Quantise<int16_t>(value, (format->normalized ? 32767.0 : 1.0), -32767.0, 32767.0);
+            memcpy(dest, &v, 2);
+        }
+        else
+        {
+            const uint16_t v = Quantise<uint16_t>(value, (format->normalized ? 65535.0 : 1.0), 0.0, 65535.0);
+            memcpy(dest, &v, 2);
+        }
+        return (dest + 2);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// GeometryPacker
+// -----------------------------------------------------------------------------
+
+class GeometryPacker
+{
+public:
+    GeometryPacker() :
+      mFile(NULL),
+      mOffset(0),
+      mNumShapes(0),
+      mQuantise(true),
+      mTotalVertexBytes(0),
+      mTotalIndexBytes(0)
+    {
+    }
+
+    ~GeometryPacker()
+    {
+        if (NULL != mFile)
+        {
+            fclose(mFile);
+        }
+    }
+
+    bool Initialize(const char *filename, bool quantise)
+    {
+        mFile = fopen(filename, "wb");
+        if (NULL == mFile)
+        {
+            return false;
+        }
+
+        mQuantise = quantise;
+
+        // The number of shapes is patched on Close
+        const uint32_t header[3] = { GEOMETRY_VERSION, 0, 0 };
+        Write("TZGB", 4);
+        Write(header, sizeof(header));
+        return true;
+    }
+
+    bool Close()
+    {
+        const uint32_t numShapes = mNumShapes;
+        fseek(mFile, 8, SEEK_SET);
+        fwrite(&numShapes, sizeof(numShapes), 1, mFile);
+
+        const bool failed = (0 != ferror(mFile));
+        fclose(mFile);
+        mFile = NULL;
+
+        if (sVerbose)
+        {
+            printf("Packed %u shapes: %u bytes of vertices, %u bytes of indices\n",
+                   mNumShapes, mTotalVertexBytes, mTotalIndexBytes);
+        }
+        return !failed;
+    }
+
+    // Writes the vertex and index data of the geometry to the binary file
+    // and replaces the data arrays on the node with their description.
+    bool Pack(const std::string &name, JSONNode *geometry, bool keepData)
+    {
+        JSONNode *inputs = geometry->Find("inputs");
+        JSONNode *sources = geometry->Find("sources");
+        if (NULL == inputs || NULL == sources ||
+            JSONNode::TYPE_OBJECT != inputs->mType ||
+            JSONNode::TYPE_OBJECT != sources->mType)
+        {
+            return false;
+        }
+
+        // Gather vertex streams
+        std::vector<VertexStream> streams;
+        unsigned maxOffset = 0;
+        for (size_t n = 0; n < inputs->mMembers.size(); n++)
+        {
+            const JSONNode::Member &input = inputs->mMembers[n];
+
+            VertexStream stream;
+            stream.semantic = input.first;
+            stream.location = FindSemanticLocation(stream.semantic);
+            if (0 > stream.location)
+            {
+                if (sVerbose)
+                {
+                    printf("%s: skipping unknown semantic %s\n", name.c_str(), stream.semantic.c_str());
+                }
+                continue;
+            }
+
+            const JSONNode *sourceName = input.second->Find("source");
+            const JSONNode *offset = input.second->Find("offset");
+            if (NULL == sourceName || JSONNode::TYPE_STRING != sourceName->mType)
+            {
+                return false;
+            }
+
+            stream.source = sources->Find(sourceName->mString.c_str());
+            if (NULL == stream.source)
+            {
+                ErrorMessage("%s: missing source %s", name.c_str(), sourceName->mString.c_str());
+                return false;
+            }
+
+            const JSONNode *stride = stream.source->Find("stride");
+            const JSONNode *data = stream.source->Find("data");
+            if (NULL == stride || NULL == data || !data->IsNumberArray())
+            {
+                return false;
+            }
+
+            stream.offset = (NULL != offset ? (unsigned)offset->mNumber : 0);
+            stream.stride = (unsigned)stride->mNumber;
+            stream.data = &data->mNumbers;
+            if (0 == stream.stride || 4 < stream.stride)
+            {
+                return false;
+            }
+
+            CalculateRange(stream);
+
+            stream.format = ChooseVertexFormat(stream, mQuantise);
+            if (NULL == stream.format)
+            {
+                return false;
+            }
+
+            if (maxOffset < stream.offset)
+            {
+                maxOffset = stream.offset;
+            }
+
+            streams.push_back(stream);
+        }
+
+        if (streams.empty())
+        {
+            return false;
+        }
+
+        std::stable_sort(streams.begin(), streams.end());
+
+        const unsigned indicesPerVertex = (maxOffset + 1);
+
+        // Gather surfaces
+        std::vector<std::string> surfaceNames;
+        std::vector<JSONNode *> surfaceNodes;
+        JSONNode *surfaces = geometry->Find("surfaces");
+        if (NULL != surfaces)
+        {
+            if (JSONNode::TYPE_OBJECT != surfaces->mType)
+            {
+                return false;
+            }
+            for (size_t n = 0; n < surfaces->mMembers.size(); n++)
+            {
+                surfaceNames.push_back(surfaces->mMembers[n].first);
+                surfaceNodes.push_back(surfaces->mMembers[n].second);
+            }
+        }
+        else
+        {
+            surfaceNames.push_back("singleSurface");
+            surfaceNodes.push_back(geometry);
+        }
+
+        const size_t numSurfaces = surfaceNodes.size();
+        std::vector<const char *> primitives(numSurfaces, (const char *)NULL);
+        std::vector< std::vector<uint32_t> > faces(numSurfaces);
+
+        // Build the table of unique vertices
+        std::vector<uint32_t> uniqueVertices;
+        uint32_t numVertices = 0;
+        typedef std::map<std::vector<uint32_t>, uint32_t> VertexMap;
+        VertexMap vertexMap;
+        std::vector<uint32_t> key(indicesPerVertex);
+
+        for (size_t s = 0; s < numSurfaces; s++)
+        {
+            const JSONNode *surfaceFaces = surfaceNodes[s]->Find("triangles");
+            if (NULL != surfaceFaces)
+            {
+                primitives[s] = "triangles";
+            }
+            else
+            {
+                surfaceFaces = surfaceNodes[s]->Find("lines");
+                if (NULL != surfaceFaces)
+                {
+                    primitives[s] = "lines";
+                }
+            }
+
+            if (NULL == surfaceFaces)
+            {
+                continue;
+            }
+
+            if (!surfaceFaces->IsNumberArray())
+            {
+                return false;
+            }
+
+            const std::vector<double> &srcFaces = surfaceFaces->mNumbers;
+            const size_t numSrcIndices = srcFaces.size();
+            if (0 != (numSrcIndices % indicesPerVertex))
+            {
+                ErrorMessage("%s: invalid number of indices", name.c_str());
+                return false;
+            }
+
+            std::vector<uint32_t> &dstFaces = faces[s];
+            dstFaces.reserve(numSrcIndices / indicesPerVertex);
+
+            if (1 == indicesPerVertex)
+            {
+                for (size_t i = 0; i < numSrcIndices; i++)
+                {
+                    dstFaces.push_back((uint32_t)srcFaces[i]);
+                }
+            }
+            else
+            {
+                for (size_t i = 0; i < numSrcIndices; i += indicesPerVertex)
+                {
+                    for (unsigned k = 0; k < indicesPerVertex; k++)
+                    {
+                        key[k] = (uint32_t)srcFaces[i + k];
+                    }
+
+                    std::pair<VertexMap::iterator, bool> inserted =
+                        vertexMap.insert(VertexMap::value_type(key, numVertices));
+                    if (inserted.second)
+                    {
+                        uniqueVertices.insert(uniqueVertices.end(), key.begin(), key.end());
+                        numVertices++;
+                    }
+                    dstFaces.push_back(inserted.first->second);
+                }
+            }
+        }
+
+        vertexMap.clear();
+
+        const size_t numStreams = streams.size();
+        if (1 == indicesPerVertex)
+        {
+            numVertices = (uint32_t)(streams[0].data->size() / streams[0].stride);
+            for (size_t v = 1; v < numStreams; v++)
+            {
+                const uint32_t streamVertices = (uint32_t)(streams[v].data->size() / streams[v].stride);
+                if (numVertices > streamVertices)
+                {
+                    numVertices = streamVertices;
+                }
+            }
+        }
+
+        if (0 == numVertices)
+        {
+            return false;
+        }
+
+        // Validate indices
+        for (size_t v = 0; v < numStreams; v++)
+        {
+            const VertexStream &stream = streams[v];
+            const size_t streamVertices = (stream.data->size() / stream.stride);
+            if (1 == indicesPerVertex)
+            {
+                continue;
+            }
+            for (uint32_t i = 0; i < numVertices; i++)
+            {
+                if (uniqueVertices[(i * indicesPerVertex) + stream.offset] >= streamVertices)
+                {
+                    ErrorMessage("%s: index out of range for %s", name.c_str(), stream.semantic.c_str());
+                    return false;
+                }
+            }
+        }
+        for (size_t s = 0; s < numSurfaces; s++)
+        {
+            const std::vector<uint32_t> &surfaceFaces = faces[s];
+            for (size_t i = 0; i < surfaceFaces.size(); i++)
+            {
+                if (surfaceFaces[i] >= numVertices)
+                {
+                    ErrorMessage("%s: index out of range", name.c_str());
+                    return false;
+                }
+            }
+        }
+
+        // Interleave and quantise the vertices
+        unsigned vertexStride = 0;
+        for (size_t v = 0; v < numStreams; v++)
+        {
+            const VertexFormat *format = streams[v].format;
+            vertexStride += (format->numComponents * format->componentSize);
+        }
+
+        AlignOutput();
+
+        const uint32_t vertexOffset = mOffset;
+        std::vector<uint8_t> vertexData((size_t)numVertices * vertexStride);
+        uint8_t *dest = &vertexData[0];
+        for (uint32_t i = 0; i < numVertices; i++)
+        {
+            for (size_t v = 0; v < numStreams; v++)
+            {
+                const VertexStream &stream = streams[v];
+                const VertexFormat *format = stream.format;
+                const uint32_t srcVertex = (1 == indicesPerVertex ?
+                                            i :
+                                            uniqueVertices[(i * indicesPerVertex) + stream.offset]);
+                const double *src = &(*stream.data)[(size_t)srcVertex * stream.stride];
+                for (unsigned c = 0; c < format->numComponents; c++)
+                {
+                    dest = EncodeComponent(dest, format, (c < stream.stride ? src[c] : 0.0));
+                }
+            }
+        }
+        Write(&vertexData[0], vertexData.size());
+        mTotalVertexBytes += (uint32_t)vertexData.size();
+
+        uniqueVertices.clear();
+        vertexData.clear();
+
+        // Indices for all the indexed surfaces are stored together
+        const bool shortIndices = (numVertices <= 65536);
+        const unsigned indexSize = (shortIndices ? 2 : 4);
+
+        AlignOutput();
+
+        const uint32_t indexOffset = mOffset;
+        uint32_t numIndices = 0;
+
+        JSONNode *binary = new JSONNode(JSONNode::TYPE_OBJECT);
+        JSONNode *binarySurfaces = new JSONNode(JSONNode::TYPE_OBJECT);
+
+        for (size_t s = 0; s < numSurfaces; s++)
+        {
+            const std::vector<uint32_t> &surfaceFaces = faces[s];
+            const uint32_t numSurfaceIndices = (uint32_t)surfaceFaces.size();
+            if (NULL == primitives[s] || 0 == numSurfaceIndices)
+            {
+                continue;
+            }
+
+            JSONNode *surface = new JSONNode(JSONNode::TYPE_OBJECT);
+            surface->Add("primitive", JSONNode::CreateString(primitives[s]));
+
+            if (IsSequential(surfaceFaces))
+            {
+                surface->Add("first", JSONNode::CreateNumber(surfaceFaces[0]));
+                surface->Add("numVertices", JSONNode::CreateNumber(numSurfaceIndices));
+            }
+            else
+            {
+                uint32_t minIndex = surfaceFaces[0];
+                uint32_t maxIndex = minIndex;
+                for (uint32_t i = 0; i < numSurfaceIndices; i++)
+                {
+                    const uint32_t index = surfaceFaces[i];
+                    if (minIndex > index)
+                    {
+                        minIndex = index;
+                    }
+                    else if (maxIndex < index)
+                    {
+                        maxIndex = index;
+                    }
+                }
+
+                surface->Add("first", JSONNode::CreateNumber(numIndices));
+                surface->Add("numIndices", JSONNode::CreateNumber(numSurfaceIndices));
+                surface->Add("numVertices", JSONNode::CreateNumber(maxIndex - minIndex + 1));
+
+                if (shortIndices)
+                {
+                    std::vector<uint16_t> indices(surfaceFaces.begin(), surfaceFaces.end());
+                    Write(&indices[0], (numSurfaceIndices * indexSize));
+                }
+                else
+                {
+                    Write(&surfaceFaces[0], (numSurfaceIndices * indexSize));
+                }
+
+                numIndices += numSurfaceIndices;
+            }
+
+            binarySurfaces->Add(surfaceNames[s].c_str(), surface);
+        }
+
+        mTotalIndexBytes += (numIndices * indexSize);
+
+        JSONNode *semantics = new JSONNode(JSONNode::TYPE_ARRAY);
+        JSONNode *formats = new JSONNode(JSONNode::TYPE_ARRAY);
+        for (size_t v = 0; v < numStreams; v++)
+        {
+            semantics->AddElement(JSONNode::CreateString(streams[v].semantic));
+            formats->AddElement(JSONNode::CreateString(streams[v].format->name));
+        }
+
+        binary->Add("numVertices", JSONNode::CreateNumber(numVertices));
+        binary->Add("vertexOffset", JSONNode::CreateNumber(vertexOffset));
+        binary->Add("vertexStride", JSONNode::CreateNumber(vertexStride));
+        binary->Add("semantics", semantics);
+        binary->Add("formats", formats);
+        if (0 < numIndices)
+        {
+            binary->Add("indexOffset", JSONNode::CreateNumber(indexOffset));
+            binary->Add("numIndices", JSONNode::CreateNumber(numIndices));
+            binary->Add("indexFormat", JSONNode::CreateString(shortIndices ? "USHORT" : "UINT"));
+        }
+        binary->Add("surfaces", binarySurfaces);
+
+        // Keep the stream ranges, the Scene uses them for the extents
+        for (size_t v = 0; v < numStreams; v++)
+        {
+            const VertexStream &stream = streams[v];
+            JSONNode *source = stream.source;
+            if (NULL == source->Find("min") || NULL == source->Find("max"))
+            {
+                JSONNode *min = new JSONNode(JSONNode::TYPE_ARRAY);
+                JSONNode *max = new JSONNode(JSONNode::TYPE_ARRAY);
+                min->mNumbers = stream.min;
+                max->mNumbers = stream.max;
+                source->Add("min", min);
+                source->Add("max", max);
+            }
+        }
+
+        if (!keepData)
+        {
+            for (size_t n = 0; n < sources->mMembers.size(); n++)
+            {
+                sources->mMembers[n].second->Remove("data");
+            }
+            for (size_t s = 0; s < numSurfaces; s++)
+            {
+                if (NULL != primitives[s])
+                {
+                    surfaceNodes[s]->Remove("triangles");
+                    surfaceNodes[s]->Remove("lines");
+                }
+            }
+        }
+
+        geometry->Add("binary", binary);
+
+        mNumShapes++;
+
+        if (sVerbose)
+        {
+            printf("%s: %u vertices of %u bytes, %u indices\n",
+                   name.c_str(), numVertices, vertexStride, numIndices);
+        }
+
+        return true;
+    }
+
+private:
+    static void CalculateRange(VertexStream &stream)
+    {
+        const unsigned stride = stream.stride;
+        const std::vector<double> &data = *stream.data;
+        const size_t numValues = ((data.size() / stride) * stride);
+
+        stream.min.assign(stride, DBL_MAX);
+        stream.max.assign(stride, -DBL_MAX);
+        for (size_t n = 0; n < numValues; n += stride)
+        {
+            for (unsigned c = 0; c < stride; c++)
+            {
+                const double value = data[n + c];
+                if (stream.min[c] > value)
+                {
+                    stream.min[c] = value;
+                }
+                if (stream.max[c] < value)
+                {
+                    stream.max[c] = value;
+                }
+            }
+        }
+    }
+
+    static bool IsSequential(const std::vector<uint32_t> &indices)
+    {
+        const uint32_t baseIndex = indices[0];
+        const size_t numIndices = indices.size();
+        for (size_t n = 1; n < numIndices; n++)
+        {
+            if (indices[n] != (baseIndex + n))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void AlignOutput()
+    {
+        static const uint8_t padding[GEOMETRY_ALIGNMENT] = { 0 };
+        const uint32_t remainder = (mOffset % GEOMETRY_ALIGNMENT);
+        if (0 != remainder)
+        {
+            Write(padding, (GEOMETRY_ALIGNMENT - remainder));
+        }
+    }
+
+    void Write(const void *data, size_t size)
+    {
+        fwrite(data, 1, size, mFile);
+        mOffset += (uint32_t)size;
+    }
+
+    FILE     *mFile;
+    uint32_t  mOffset;
+    uint32_t  mNumShapes;
+    bool      mQuantise;
+    uint32_t  mTotalVertexBytes;
+    uint32_t  mTotalIndexBytes;
+};
+
+// -----------------------------------------------------------------------------
+// Scene handlers
+// -----------------------------------------------------------------------------
+
+// Collects the names of the geometries used by physics models, their data
+// arrays are still required at runtime.
+class PhysicsGeometryCollector
+{
+public:
+    explicit PhysicsGeometryCollector(std::set<std::string> &geometries) :
+      mGeometries(geometries),
+      mDepth(0),
+      mInPhysicsModels(false),
+      mGeometryKey(false)
+    {
+    }
+
+    bool Null()
+    {
+        mGeometryKey = false;
+        return true;
+    }
+
+    bool Boolean(bool)
+    {
+        mGeometryKey = false;
+        return true;
+    }
+
+    bool Number(double)
+    {
+        mGeometryKey = false;
+        return true;
+    }
+
+    bool String(const char *text, size_t length)
+    {
+        if (mGeometryKey)
+        {
+            mGeometries.insert(std::string(text, length));
+            mGeometryKey = false;
+        }
+        return true;
+    }
+
+    bool Key(const char *text, size_t length)
+    {
+        if (1 == mDepth)
+        {
+            mInPhysicsModels = (13 == length && 0 == memcmp(text, "physicsmodels", 13));
+        }
+        else if (3 == mDepth && mInPhysicsModels)
+        {
+            mGeometryKey = (8 == length && 0 == memcmp(text, "geometry", 8));
+        }
+        return true;
+    }
+
+    bool BeginObject()
+    {
+        mGeometryKey = false;
+        mDepth++;
+        return true;
+    }
+
+    bool EndObject()
+    {
+        mDepth--;
+        return true;
+    }
+
+    bool BeginArray()
+    {
+        mGeometryKey = false;
+        mDepth++;
+        return true;
+    }
+
+    bool EndArray()
+    {
+        mDepth--;
+        return true;
+    }
+
+private:
+    std::set<std::string> &mGeometries;
+    unsigned               mDepth;
+    bool                   mInPhysicsModels;
+    bool                   mGeometryKey;
+};
+
+// Copies the scene to the output, packing the geometries on the way
+class SceneConverter
+{
+public:
+    SceneConverter(JSONStreamWriter &writer,
+                   GeometryPacker &packer,
+                   const std::set<std::string> &keepData) :
+      mWriter(writer),
+      mPacker(packer),
+      mKeepData(keepData),
+      mDepth(0),
+      mInGeometries(false),
+      mBuilder(NULL)
+    {
+    }
+
+    ~SceneConverter()
+    {
+        delete mBuilder;
+    }
+
+    bool Null()
+    {
+        if (NULL != mBuilder)
+        {
+            return mBuilder->Null();
+        }
+        return mWriter.Null();
+    }
+
+    bool Boolean(bool value)
+    {
+        if (NULL != mBuilder)
+        {
+            return mBuilder->Boolean(value);
+        }
+        return mWriter.Boolean(value);
+    }
+
+    bool Number(double value)
+    {
+        if (NULL != mBuilder)
+        {
+            return mBuilder->Number(value);
+        }
+        return mWriter.Number(value);
+    }
+
+    bool String(const char *text, size_t length)
+    {
+        if (NULL != mBuilder)
+        {
+            return mBuilder->String(text, length);
+        }
+        return mWriter.String(text, length);
+    }
+
+    bool Key(const char *text, size_t length)
+    {
+        if (NULL != mBuilder)
+        {
+            return mBuilder->Key(text, length);
+        }
+
+        if (1 == mDepth)
+        {
+            mInGeometries = (10 == length && 0 == memcmp(text, "geometries", 10));
+        }
+        else if (2 == mDepth && mInGeometries)
+        {
+            mGeometryName.assign(text, length);
+        }
+        return mWriter.Key(text, length);
+    }
+
+    bool BeginObject()
+    {
+        if (NULL != mBuilder)
+        {
+            return mBuilder->BeginObject();
+        }
+
+        if (2 == mDepth && mInGeometries)
+        {
+            mBuilder = new JSONNodeBuilder();
+            return mBuilder->BeginObject();
+        }
+
+        mDepth++;
+        return mWriter.BeginObject();
+    }
+
+    bool EndObject()
+    {
+        if (NULL != mBuilder)
+        {
+            if (!mBuilder->EndObject())
+            {
+                return false;
+            }
+            if (mBuilder->IsComplete())
+            {
+                return FlushGeometry();
+            }
+            return true;
+        }
+
+        mDepth--;
+        return mWriter.EndObject();
+    }
+
+    bool BeginArray()
+    {
+        if (NULL != mBuilder)
+        {
+            return mBuilder->BeginArray();
+        }
+
+        mDepth++;
+        return mWriter.BeginArray();
+    }
+
+    bool EndArray()
+    {
+        if (NULL != mBuilder)
+        {
+            return mBuilder->EndArray();
+        }
+
+        mDepth--;
+        return mWriter.EndArray();
+    }
+
+private:
+    bool FlushGeometry()
+    {
+        JSONNode *geometry = mBuilder->Detach();
+        delete mBuilder;
+        mBuilder = NULL;
+
+        const bool keepData = (mKeepData.end() != mKeepData.find(mGeometryName));
+        if (!mPacker.Pack(mGeometryName, geometry, keepData) && sVerbose)
+        {
+            printf("%s: left unpacked\n", mGeometryName.c_str());
+        }
+
+        mWriter.Node(geometry);
+        delete geometry;
+        return true;
+    }
+
+    JSONStreamWriter            &mWriter;
+    GeometryPacker              &mPacker;
+    const std::set<std::string> &mKeepData;
+    unsigned                     mDepth;
+    bool                         mInGeometries;
+    std::string                  mGeometryName;
+    JSONNodeBuilder             *mBuilder;
+};
+
+// -----------------------------------------------------------------------------
+// Main
+// -----------------------------------------------------------------------------
+
+void ErrorMessage(const char *message, ...)
+{
+    va_list args;
+    va_start(args, message);
+    fputs("ERROR: ", stderr);
+    vfprintf(stderr, message, args);
+    fputc('\n', stderr);
+    va_end(args);
+}
+
+template <class Handler>
+static bool ParseFile(const char *fileName, Handler &handler)
+{
+    // Every pass maps the file again because parsing modifies the buffer
+    MappedFile file;
+    if (!file.Open(fileName))
+    {
+        ErrorMessage("Failed to read %s", fileName);
+        return false;
+    }
+
+    if (0 == file.GetSize())
+    {
+        ErrorMessage("Empty input %s", fileName);
+        return false;
+    }
+
+    JSONReader reader;
+    if (!reader.Parse(file.GetData(), file.GetSize(), handler))
+    {
+        ErrorMessage("%s:%u: %s", fileName, (unsigned)reader.GetErrorOffset(), reader.GetError());
+        return false;
+    }
+    return true;
+}
+
+static std::string DefaultBinaryFileName(const char *outputFileName)
+{
+    std::string binaryFileName(outputFileName);
+    const size_t dot = binaryFileName.rfind('.');
+    const size_t slash = binaryFileName.find_last_of("/\\");
+    if (std::string::npos != dot &&
+        (std::string::npos == slash || dot > slash))
+    {
+        binaryFileName.erase(dot);
+    }
+    binaryFileName += ".bin";
+    return binaryFileName;
+}
+
+static void PrintHelp(int error=0)
+{
+    puts(
+"Usage\n"
+"=====\n"
+"  json2geom [options]\n"
+"\n"
+"Packs the geometries of a scene JSON file into a binary geometry file.\n"
+"\n"
+"Options\n"
+"=======\n"
+"--version               show program's version number and exit\n"
+"--help, -h              show this help message and exit\n"
+"--verbose, -v           verbose output\n"
+"\n"
+"Asset Generation Options\n"
+"------------------------\n"
+"--float                 keep all the vertex attributes as floats\n"
+"--json_indent=SIZE, -j SIZE\n"
+"                        json output pretty printing indent size, defaults to 0\n"
+"\n"
+"File Options\n"
+"------------\n"
+"--input=FILE, -i FILE   source FILE to process\n"
+"--output=FILE, -o FILE  output FILE to write the scene JSON to\n"
+"--binary=FILE, -b FILE  output FILE to write the geometry data to,\n"
+"                        defaults to the output with a .bin extension\n"
+         );
+    exit(error);
+}
+
+int main(int argc, char **argv)
+{
+    const char *inputFileName  = NULL;
+    const char *outputFileName = NULL;
+    const char *binaryFileName = NULL;
+
+    int indentationStep = 0;
+    bool quantise = true;
+
+    sVerbose = false;
+
+    for (int argn = 1; argn < argc; argn++)
+    {
+        if (0 == strcmp(argv[argn], "-i"))
+        {
+            argn++;
+            if (argn < argc)
+            {
+                inputFileName = argv[argn];
+            }
+        }
+        else if (0 == memcmp(argv[argn], "--input=", (sizeof("--input=") - 1)))
+        {
+            inputFileName = (argv[argn] + 8);
+        }
+        else if (0 == strcmp(argv[argn], "-o"))
+        {
+            argn++;
+            if (argn < argc)
+            {
+                outputFileName = argv[argn];
+            }
+        }
+        else if (0 == memcmp(argv[argn], "--output=", (sizeof("--output=") - 1)))
+        {
+            outputFileName = (argv[argn] + 9);
+        }
+        else if (0 == strcmp(argv[argn], "-b"))
+        {
+            argn++;
+            if (argn < argc)
+            {
+                binaryFileName = argv[argn];
+            }
+        }
+        else if (0 == memcmp(argv[argn], "--binary=", (sizeof("--binary=") - 1)))
+        {
+            binaryFileName = (argv[argn] + 9);
+        }
+        else if (0 == strcmp(argv[argn], "-j"))
+        {
+            argn++;
+            if (argn < argc)
+            {
+                indentationStep = atoi(argv[argn]);
+            }
+        }
+        else if (0 == memcmp(argv[argn], "--json_indent=", (sizeof("--json_indent=") - 1)))
+        {
+            indentationStep = atoi(argv[argn] + 14);
+        }
+        else if (0 == strcmp(argv[argn], "--float"))
+        {
+            quantise = false;
+        }
+        else if (0 == strcmp(argv[argn], "-v") ||
+                 0 == strcmp(argv[argn], "--verbose"))
+        {
+            sVerbose = true;
+        }
+        else if (0 == strcmp(argv[argn], "-h") ||
+                 0 == strcmp(argv[argn], "--help"))
+        {
+            PrintHelp();
+        }
+        else if (0 == strcmp(argv[argn], "--version"))
+        {
+            puts(VERSION_STRING);
+            return 0;
+        }
+        else
+        {
+            ErrorMessage("Unknown option %s", argv[argn]);
+            PrintHelp(1);
+        }
+    }
+
+    if (NULL == inputFileName || NULL == outputFileName)
+    {
+        PrintHelp(1);
+    }
+
+    std::string defaultBinaryFileName;
+    if (NULL == binaryFileName)
+    {
+        defaultBinaryFileName = DefaultBinaryFileName(outputFileName);
+        binaryFileName = defaultBinaryFileName.c_str();
+    }
+
+    // First pass finds the geometries that must keep their data
+    std::set<std::string> physicsGeometries;
+    {
+        PhysicsGeometryCollector collector(physicsGeometries);
+        if (!ParseFile(inputFileName, collector))
+        {
+            return 1;
+        }
+    }
+
+    JSONStreamWriter writer;
+    if (!writer.Initialize(outputFileName, indentationStep))
+    {
+        ErrorMessage("Failed to open %s", outputFileName);
+        return 1;
+    }
+
+    GeometryPacker packer;
+    if (!packer.Initialize(binaryFileName, quantise))
+    {
+        ErrorMessage("Failed to open %s", binaryFileName);
+        return 1;
+    }
+
+    {
+        SceneConverter converter(writer, packer, physicsGeometries);
+        if (!ParseFile(inputFileName, converter))
+        {
+            return 1;
+        }
+    }
+
+    if (!writer.Close())
+    {
+        ErrorMessage("Failed to write %s", outputFileName);
+        return 1;
+    }
+
+    if (!packer.Close())
+    {
+        ErrorMessage("Failed to write %s", binaryFileName);
+        return 1;
+    }
+
+    return 0;
+}
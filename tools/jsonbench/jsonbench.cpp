@@ -0,0 +1,406 @@
+// Copyright (c) 2015 Turbulenz Limited
+
+#include "../common/jsonreader.h"
+#include "../common/mappedfile.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <vector>
+
+#define VERSION_STRING "jsonbench 0.1"
+
+// -----------------------------------------------------------------------------
+// Timers
+// -----------------------------------------------------------------------------
+
+static bool   sInitialized = false;
+static double sTicksToSeconds = 1.0;
+
+#if defined(_MSC_VER)
+# include <windows.h>
+# undef max
+# undef min
+typedef __int64 Ticks;
+#elif defined(__APPLE__)
+# include <mach/mach_time.h>
+# include <sys/resource.h>
+typedef uint64_t Ticks;
+#else
+# include <sys/time.h>
+# include <sys/resource.h>
+# include <time.h>
+typedef unsigned long long Ticks;
+#endif
+
+void InitializeTimer()
+{
+    sInitialized = true;
+#if defined(_MSC_VER)
+    Ticks frequency;
+    QueryPerformanceFrequency((LARGE_INTEGER *)(&frequency));
+    sTicksToSeconds = (1.0 / (double)frequency);
+#elif defined(__APPLE__)
+    mach_timebase_info_data_t info;
+    mach_timebase_info(&info);
+    sTicksToSeconds = ((double)(info.numer) / (double)(info.denom) * 1e-9);
+#else
+    sTicksToSeconds = 1.0 / 1000000;
+#endif
+}
+
+Ticks GetTicks()
+{
+#if defined(_MSC_VER)
+    Ticks ticks;
+    QueryPerformanceCounter((LARGE_INTEGER *)(&ticks));
+    return ticks;
+#elif defined(__APPLE__)
+    return mach_absolute_time();
+#else
+    timeval now;
+    gettimeofday(&now, NULL);
+    Ticks ticks = (Ticks)now.tv_sec;
+    ticks *= 1000000;
+    ticks += now.tv_usec;
+    return ticks;
+#endif
+}
+
+double TicksToSeconds(Ticks ticks)
+{
+    return ((double)ticks * sTicksToSeconds);
+}
+
+// Peak resident set size in kilobytes, 0 if unknown
+static unsigned long PeakMemory()
+{
+#if defined(_MSC_VER)
+    return 0;
+#elif defined(__APPLE__)
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (unsigned long)(usage.ru_maxrss / 1024);
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (unsigned long)usage.ru_maxrss;
+#endif
+}
+
+// -----------------------------------------------------------------------------
+// Handler
+// -----------------------------------------------------------------------------
+
+//
+// Counts the events and accumulates every value so the parse can not be
+// optimized away and results can be compared between input methods.
+//
+class CountingHandler
+{
+public:
+    CountingHandler()
+    {
+        Reset();
+    }
+
+    void Reset()
+    {
+        mNumValues = 0;
+        mNumNumbers = 0;
+        mNumStrings = 0;
+        mNumKeys = 0;
+        mNumContainers = 0;
+        mStringBytes = 0;
+        mNumberSum = 0.0;
+    }
+
+    bool Null()
+    {
+        mNumValues++;
+        return true;
+    }
+
+    bool Boolean(bool)
+    {
+        mNumValues++;
+        return true;
+    }
+
+    bool Number(double value)
+    {
+        mNumValues++;
+        mNumNumbers++;
+        mNumberSum += value;
+        return true;
+    }
+
+    bool String(const char *, size_t length)
+    {
+        mNumValues++;
+        mNumStrings++;
+        mStringBytes += length;
+        return true;
+    }
+
+    bool Key(const char *, size_t length)
+    {
+        mNumKeys++;
+        mStringBytes += length;
+        return true;
+    }
+
+    bool BeginObject()
+    {
+        mNumValues++;
+        mNumContainers++;
+        return true;
+    }
+
+    bool EndObject()
+    {
+        return true;
+    }
+
+    bool BeginArray()
+    {
+        mNumValues++;
+        mNumContainers++;
+        return true;
+    }
+
+    bool EndArray()
+    {
+        return true;
+    }
+
+    size_t  mNumValues;
+    size_t  mNumNumbers;
+    size_t  mNumStrings;
+    size_t  mNumKeys;
+    size_t  mNumContainers;
+    size_t  mStringBytes;
+    double  mNumberSum;
+};
+
+// -----------------------------------------------------------------------------
+// Main
+// -----------------------------------------------------------------------------
+
+void ErrorMessage(const char *message, ...)
+{
+    va_list args;
+    va_start(args, message);
+    fputs("ERROR: ", stderr);
+    vfprintf(stderr, message, args);
+    fputc('\n', stderr);
+    va_end(args);
+}
+
+static bool ReadFile(const char *fileName, std::vector<char> &data)
+{
+    FILE *f = fopen(fileName, "rb");
+    if (NULL == f)
+    {
+        return false;
+    }
+
+    char buffer[64 * 1024];
+    size_t read;
+    data.clear();
+    while (0 < (read = fread(buffer, 1, sizeof(buffer), f)))
+    {
+        data.insert(data.end(), buffer, (buffer + read));
+    }
+
+    const bool failed = (0 != ferror(f));
+    fclose(f);
+    return !failed;
+}
+
+static bool Report(const char *fileName,
+                   const char *method,
+                   size_t size,
+                   unsigned int iterations,
+                   Ticks ticks,
+                   const CountingHandler &handler)
+{
+    const double seconds = TicksToSeconds(ticks);
+    const double perIteration = (seconds / iterations);
+    const double megabytes = ((double)size / (1024.0 * 1024.0));
+    printf("%s [%s]: %.2f MB, %.3f ms/parse, %.1f MB/s, "
+           "%u values, %u numbers, %u strings, %u keys, sum %.17g\n",
+           fileName,
+           method,
+           megabytes,
+           (perIteration * 1000.0),
+           (0.0 < perIteration ? (megabytes / perIteration) : 0.0),
+           (unsigned)handler.mNumValues,
+           (unsigned)handler.mNumNumbers,
+           (unsigned)handler.mNumStrings,
+           (unsigned)handler.mNumKeys,
+           handler.mNumberSum);
+    return true;
+}
+
+static bool BenchmarkMapped(const char *fileName, unsigned int iterations)
+{
+    CountingHandler handler;
+    JSONReader reader;
+    size_t size = 0;
+    Ticks total = 0;
+    for (unsigned int n = 0; n < iterations; n++)
+    {
+        handler.Reset();
+
+        // Mapping is part of the cost because every parse needs a fresh one
+        const Ticks start = GetTicks();
+        MappedFile file;
+        if (!file.Open(fileName))
+        {
+            ErrorMessage("Failed to read %s", fileName);
+            return false;
+        }
+        size = file.GetSize();
+        if (!reader.Parse(file.GetData(), size, handler))
+        {
+            ErrorMessage("%s:%u: %s", fileName, (unsigned)reader.GetErrorOffset(), reader.GetError());
+            return false;
+        }
+        file.Close();
+        total += (GetTicks() - start);
+    }
+    return Report(fileName, "mapped", size, iterations, total, handler);
+}
+
+static bool BenchmarkRead(const char *fileName, unsigned int iterations)
+{
+    CountingHandler handler;
+    JSONReader reader;
+    std::vector<char> data;
+    size_t size = 0;
+    Ticks total = 0;
+    for (unsigned int n = 0; n < iterations; n++)
+    {
+        handler.Reset();
+
+        const Ticks start = GetTicks();
+        if (!ReadFile(fileName, data))
+        {
+            ErrorMessage("Failed to read %s", fileName);
+            return false;
+        }
+        size = data.size();
+        if (0 < size &&
+            !reader.Parse(&data[0], size, handler))
+        {
+            ErrorMessage("%s:%u: %s", fileName, (unsigned)reader.GetErrorOffset(), reader.GetError());
+            return false;
+        }
+        total += (GetTicks() - start);
+    }
+    return Report(fileName, "read", size, iterations, total, handler);
+}
+
+static void Usage()
+{
+    puts(VERSION_STRING);
+    puts("Usage: jsonbench [options] <file.json> [<file.json> ...]");
+    puts("");
+    puts("Parses every file with tools/common/jsonreader.h and reports the");
+    puts("throughput for a mapped input and for an input read into memory.");
+    puts("");
+    puts("  -n, --iterations=N   number of parses per file and method (default 10)");
+    puts("  --mapped             only benchmark the mapped input");
+    puts("  --read               only benchmark the input read into memory");
+    puts("  -h, --help           show this message");
+    puts("  --version            show the version");
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int iterations = 10;
+    bool mapped = true;
+    bool read = true;
+    std::vector<const char *> fileNames;
+
+    for (int argn = 1; argn < argc; argn++)
+    {
+        if (0 == strcmp(argv[argn], "-n"))
+        {
+            argn++;
+            if (argn < argc)
+            {
+                iterations = (unsigned int)atoi(argv[argn]);
+            }
+            else
+            {
+                ErrorMessage("Missing value for -n");
+                return 1;
+            }
+        }
+        else if (0 == strncmp(argv[argn], "--iterations=", 13))
+        {
+            iterations = (unsigned int)atoi(argv[argn] + 13);
+        }
+        else if (0 == strcmp(argv[argn], "--mapped"))
+        {
+            mapped = true;
+            read = false;
+        }
+        else if (0 == strcmp(argv[argn], "--read"))
+        {
+            mapped = false;
+            read = true;
+        }
+        else if (0 == strcmp(argv[argn], "-h") ||
+                 0 == strcmp(argv[argn], "--help"))
+        {
+            Usage();
+            return 0;
+        }
+        else if (0 == strcmp(argv[argn], "--version"))
+        {
+            puts(VERSION_STRING);
+            return 0;
+        }
+        else if ('-' == argv[argn][0])
+        {
+            ErrorMessage("Unknown option %s", argv[argn]);
+            return 1;
+        }
+        else
+        {
+            fileNames.push_back(argv[argn]);
+        }
+    }
+
+    if (fileNames.empty() || 0 == iterations)
+    {
+        Usage();
+        return 1;
+    }
+
+    InitializeTimer();
+
+    for (size_t n = 0; n < fileNames.size(); n++)
+    {
+        if (mapped && !BenchmarkMapped(fileNames[n], iterations))
+        {
+            return 1;
+        }
+        if (read && !BenchmarkRead(fileNames[n], iterations))
+        {
+            return 1;
+        }
+    }
+
+    const unsigned long peak = PeakMemory();
+    if (0 != peak)
+    {
+        printf("Peak resident memory: %lu KB\n", peak);
+    }
+
+    return 0;
+}
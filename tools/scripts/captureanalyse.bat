@@ -0,0 +1,5 @@
+@rem Copyright (c) 2015 Turbulenz Limited
+@echo off
+@rem Report redundant work in a binary graphics capture stream
+
+@node %~dp0\captureanalyse %*
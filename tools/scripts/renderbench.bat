@@ -0,0 +1,5 @@
+@rem Copyright (c) 2015 Turbulenz Limited
+@echo off
+@rem Render a sample scene headless and report CPU time per frame
+
+@node %~dp0\renderbench %*
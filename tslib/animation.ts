@@ -64,6 +64,8 @@ interface Animation
     nodeData: any;
     channels: any;
     bounds: any;
+    keyData?: Uint16Array;  // quantized keys, see json2anim
+    keyTimeScale?: number;
 };
 
 var AnimationMath =
@@ -381,6 +383,12 @@ class InterpolatorController implements ControllerBaseClass
         var mathDevice = this.mathDevice;
 
         var anim = this.currentAnim;
+        if (anim.keyData)
+        {
+            this._updateQuantized();
+            return;
+        }
+
         var nodeData = anim.nodeData;
         var numJoints = this.hierarchy.numNodes;
         var outputArray = this.output;
@@ -628,6 +636,231 @@ class InterpolatorController implements ControllerBaseClass
         }
     }
 
+    // Samples animations compressed by json2anim. Every channel stores its key
+    // times followed by 3 values per key in anim.keyData, the per track
+    // cursors remember the last key pair used so playing forward only moves
+    // a few keys per frame.
+    _updateQuantized()
+    {
+        var mathDevice = this.mathDevice;
+
+        var anim = this.currentAnim;
+        var nodeData = anim.nodeData;
+        var keyData = anim.keyData;
+        var numJoints = this.hierarchy.numNodes;
+        var outputArray = this.output;
+        var time = (this.currentTime / anim.keyTimeScale);
+
+        var animHasScale = anim.channels.scale;
+
+        var defaultScale;
+        if (animHasScale)
+        {
+            defaultScale = mathDevice.v3Build(1, 1, 1);
+        }
+
+        var j;
+        for (j = 0; j < numJoints; j += 1)
+        {
+            var data = nodeData[j];
+            var channels = data.channels;
+            var jointBase = data.baseframe;
+            var jointOutput = outputArray[j];
+            var baseQuat, basePos, baseScale;
+
+            if (jointBase)
+            {
+                baseQuat = jointBase.rotation;
+                basePos = jointBase.translation;
+                baseScale = jointBase.scale;
+            }
+
+            if (channels && channels.rotation)
+            {
+                jointOutput.rotation = this._sampleQuantizedRotation(keyData, channels.rotation, time,
+                                                                     this.rotationEndFrames, j,
+                                                                     jointOutput.rotation);
+            }
+            else
+            {
+                jointOutput.rotation = mathDevice.quatCopy(baseQuat, jointOutput.rotation);
+            }
+
+            if (channels && channels.translation)
+            {
+                jointOutput.translation = this._sampleQuantizedVector(keyData, channels.translation, time,
+                                                                      this.translationEndFrames, j,
+                                                                      jointOutput.translation);
+            }
+            else
+            {
+                jointOutput.translation = mathDevice.v3Copy(basePos, jointOutput.translation);
+            }
+
+            if (channels && channels.scale)
+            {
+                jointOutput.scale = this._sampleQuantizedVector(keyData, channels.scale, time,
+                                                                this.scaleEndFrames, j,
+                                                                jointOutput.scale);
+            }
+            else if (animHasScale)
+            {
+                jointOutput.scale = mathDevice.v3Copy((baseScale || defaultScale), jointOutput.scale);
+            }
+        }
+
+        this.dirty = false;
+
+        if (this.dirtyBounds)
+        {
+            this.updateBounds();
+        }
+    }
+
+    // Returns the index of the key ending the interval containing time,
+    // 0 before the first key and count after the last one
+    _findQuantizedKey(keyData: Uint16Array, offset: number, count: number, time: number,
+                      cursors: Uint32Array, index: number): number
+    {
+        if (time <= keyData[offset])
+        {
+            return 0;
+        }
+        if (time >= keyData[offset + count - 1])
+        {
+            return count;
+        }
+
+        var key = cursors[index];
+        if (key === 0 || time <= keyData[offset + key - 1])
+        {
+            // Time went backwards, start again
+            key = 1;
+        }
+        while (time > keyData[offset + key])
+        {
+            key += 1;
+        }
+        cursors[index] = key;
+        return key;
+    }
+
+    _sampleQuantizedVector(keyData: Uint16Array, channel: any, time: number,
+                           cursors: Uint32Array, index: number, dst: any): any
+    {
+        var offset = channel.offset;
+        var count = channel.count;
+        var min = channel.min;
+        var step = channel.step;
+        var values = (offset + count);
+        var mathDevice = this.mathDevice;
+
+        var key = this._findQuantizedKey(keyData, offset, count, time, cursors, index);
+        if (key === 0 || key === count)
+        {
+            var v = (values + (3 * (key === 0 ? 0 : (count - 1))));
+            return mathDevice.v3Build((min[0] + (keyData[v] * step[0])),
+                                      (min[1] + (keyData[v + 1] * step[1])),
+                                      (min[2] + (keyData[v + 2] * step[2])),
+                                      dst);
+        }
+
+        var startTime = keyData[offset + key - 1];
+        var delta = ((time - startTime) / (keyData[offset + key] - startTime));
+
+        var scratchPad = InterpolatorController.prototype.scratchPad;
+        var v1 = scratchPad.v1;
+        var v2 = scratchPad.v2;
+        var start = (values + (3 * (key - 1)));
+        var end = (start + 3);
+
+        v1[0] = (min[0] + (keyData[start] * step[0]));
+        v1[1] = (min[1] + (keyData[start + 1] * step[1]));
+        v1[2] = (min[2] + (keyData[start + 2] * step[2]));
+
+        v2[0] = (min[0] + (keyData[end] * step[0]));
+        v2[1] = (min[1] + (keyData[end + 1] * step[1]));
+        v2[2] = (min[2] + (keyData[end + 2] * step[2]));
+
+        return mathDevice.v3Lerp(v1, v2, delta, dst);
+    }
+
+    _sampleQuantizedRotation(keyData: Uint16Array, channel: any, time: number,
+                             cursors: Uint32Array, index: number, dst: any): any
+    {
+        var offset = channel.offset;
+        var count = channel.count;
+        var values = (offset + count);
+        var decode = InterpolatorController._decodeQuantizedRotation;
+
+        var key = this._findQuantizedKey(keyData, offset, count, time, cursors, index);
+        if (key === 0 || key === count)
+        {
+            if (!dst)
+            {
+                dst = this.mathDevice.quatBuild(0, 0, 0, 1);
+            }
+            return decode(keyData, (values + (3 * (key === 0 ? 0 : (count - 1)))), dst);
+        }
+
+        var startTime = keyData[offset + key - 1];
+        var delta = ((time - startTime) / (keyData[offset + key] - startTime));
+
+        var scratchPad = InterpolatorController.prototype.scratchPad;
+        var q1 = decode(keyData, (values + (3 * (key - 1))), scratchPad.q1);
+        var q2 = decode(keyData, (values + (3 * key)), scratchPad.q2);
+
+        return this.mathDevice.quatSlerp(q1, q2, delta, dst);
+    }
+
+    // Smallest three encoding, the top bits of the first 2 values hold the
+    // index of the largest component
+    static _decodeQuantizedRotation(keyData: Uint16Array, index: number, dst: any): any
+    {
+        /* tslint:disable:no-bitwise */
+        var a = keyData[index];
+        var b = keyData[index + 1];
+        var c = keyData[index + 2];
+        var largest = ((a >>> 15) | ((b >>> 15) << 1));
+        var step = (1.4142135623730951 / 32766);
+        var x = (((a & 0x7fff) * step) - 0.7071067811865476);
+        var y = (((b & 0x7fff) * step) - 0.7071067811865476);
+        var z = ((c * step) - 0.7071067811865476);
+        /* tslint:enable:no-bitwise */
+        var wSq = (1.0 - ((x * x) + (y * y) + (z * z)));
+        var w = (wSq > 0.0 ? Math.sqrt(wSq) : 0.0);
+
+        if (largest === 0)
+        {
+            dst[0] = w;
+            dst[1] = x;
+            dst[2] = y;
+            dst[3] = z;
+        }
+        else if (largest === 1)
+        {
+            dst[0] = x;
+            dst[1] = w;
+            dst[2] = y;
+            dst[3] = z;
+        }
+        else if (largest === 2)
+        {
+            dst[0] = x;
+            dst[1] = y;
+            dst[2] = w;
+            dst[3] = z;
+        }
+        else
+        {
+            dst[0] = x;
+            dst[1] = y;
+            dst[2] = z;
+            dst[3] = w;
+        }
+        return dst;
+    }
+
     updateBounds()
     {
         if (!this.dirtyBounds)
@@ -721,6 +954,12 @@ class InterpolatorController implements ControllerBaseClass
 
         var anim = this.currentAnim;
         var animHasScale = anim.channels.scale;
+        if (this.dirty && anim.keyData)
+        {
+            // Quantized keys are only decoded by a full update
+            this.update();
+        }
+
         if (this.dirty)
         {
             var nodeData = anim.nodeData;
@@ -2557,6 +2796,8 @@ class GPUSkinController implements SkinControllerBase
                 numFloats : size,
                 dynamic : true
             });
+            // Only written with setData so it can be versioned
+            this.output.version = 1;
         }
     }
 
@@ -20,7 +20,7 @@ class AnimationManager
     // Methods
     loadFile(path: string, callback: any)
     { debug.abort("abstract method"); }
-    loadData(data: any, prefix?: string)
+    loadData(data: any, prefix?: string, animationData?: ArrayBuffer)
     { debug.abort("abstract method"); }
     get(name: string): Animation
     { debug.abort("abstract method"); return null; }
@@ -47,7 +47,7 @@ class AnimationManager
         var pathRemapping = null;
         var pathPrefix = "";
 
-        var loadAnimationData = function loadAnimationDataFn(data, prefix?)
+        var loadAnimationData = function loadAnimationDataFn(data, prefix?, animationData?)
         {
             var fileAnimations = data.animations;
             var a;
@@ -63,6 +63,19 @@ class AnimationManager
                     }
                     var anim = fileAnimations[a];
 
+                    // Quantized keys written by json2anim live in a separate binary file
+                    var binary = anim.binary;
+                    if (binary)
+                    {
+                        if (!animationData)
+                        {
+                            errorCallback("Animation '" + name + "' requires binary animation data");
+                            continue;
+                        }
+                        anim.keyData = new Uint16Array(animationData, binary.offset, binary.length);
+                        anim.keyTimeScale = binary.timeScale;
+                    }
+
                     var numNodes = anim.numNodes;
                     var nodeDataArray = anim.nodeData;
                     var n;
@@ -326,10 +339,10 @@ class AnimationManager
             };
 
             animationManager.loadData =
-                function loadAnimationDataLogFn(data, prefix?)
+                function loadAnimationDataLogFn(data, prefix?, animationData?)
             {
                 log.innerHTML += "AnimationManager.loadData";
-                return loadAnimationData(data, prefix);
+                return loadAnimationData(data, prefix, animationData);
             };
 
             animationManager.get = function getAnimationLogFn(name)
@@ -10,11 +10,16 @@ interface CachedAsset
     isLoading: boolean;
     key: string;
     observer: Observer;
+    bytes: number;
+    pinCount: number;
+    // Least recently used list, pinned assets are not linked
+    prev: CachedAsset;
+    next: CachedAsset;
 };
 
 interface AssetCacheOnLoadFn { (key: string,
                                 params: any,
-                                callback: { (asset: any): void; }): void; };
+                                callback: { (asset: any, bytes?: number): void; }): void; };
 
 interface AssetCacheOnDestroyFn { (oldestKey: string, asset: any): void; };
 
@@ -23,10 +28,20 @@ interface AssetCacheOnLoadedFn { (key: string, asset: any, params: any): void; }
 interface AssetCacheParams
 {
     size?: number;
+    maxBytes?: number;
     onLoad: AssetCacheOnLoadFn;
     onDestroy?: AssetCacheOnDestroyFn;
 };
 
+interface AssetCacheMetrics
+{
+    hits: number;
+    misses: number;
+    evictions: number;
+    numAssets: number;
+    bytes: number;
+};
+
 //
 // AssetCache
 //
@@ -34,16 +49,21 @@ interface AssetCacheParams
 class AssetCache
 {
     /* tslint:disable:no-unused-variable */
-    static version = 2;
+    static version = 3;
     /* tslint:enable:no-unused-variable */
 
     maxCacheSize: number;
+    maxBytes: number;
     onLoad: AssetCacheOnLoadFn;
     onDestroy: AssetCacheOnDestroyFn;
 
     hitCounter: number;
     cache: { [idx: string]: CachedAsset; };
-    cacheArray: CachedAsset[];
+    metrics: AssetCacheMetrics;
+
+    // Least recently used first
+    private lruHead: CachedAsset;
+    private lruTail: CachedAsset;
 
     exists(key: string): boolean
     {
@@ -67,10 +87,11 @@ class AssetCache
         var cachedAsset = this.cache[key];
         if (cachedAsset)
         {
-            cachedAsset.cacheHit = this.hitCounter;
-            this.hitCounter += 1;
+            this.metrics.hits += 1;
+            this._touch(cachedAsset);
             return cachedAsset.asset;
         }
+        this.metrics.misses += 1;
         return null;
     }
 
@@ -78,11 +99,12 @@ class AssetCache
     {
         debug.assert(key, "Key is invalid");
 
+        var metrics = this.metrics;
         var cachedAsset = this.cache[key];
         if (cachedAsset)
         {
-            cachedAsset.cacheHit = this.hitCounter;
-            this.hitCounter += 1;
+            metrics.hits += 1;
+            this._touch(cachedAsset);
             if (!callback)
             {
                 return;
@@ -100,52 +122,32 @@ class AssetCache
             return;
         }
 
-        var cacheArray = this.cacheArray;
-        var cacheArrayLength = cacheArray.length;
+        metrics.misses += 1;
 
-        if (cacheArrayLength >= this.maxCacheSize)
+        // Make room for the new asset, its size is not known until loaded
+        while (metrics.numAssets >= this.maxCacheSize)
         {
-            var cache = this.cache;
-            var oldestCacheHit = this.hitCounter;
-            var oldestKey = null;
-            var oldestIndex;
-            var i;
-
-            for (i = 0; i < cacheArrayLength; i += 1)
-            {
-                if (cacheArray[i].cacheHit < oldestCacheHit)
-                {
-                    oldestCacheHit = cacheArray[i].cacheHit;
-                    oldestIndex = i;
-                }
-            }
-
-            cachedAsset = cacheArray[oldestIndex];
-            oldestKey = cachedAsset.key;
-
-            if (this.onDestroy && !cachedAsset.isLoading)
+            if (!this._evictOldest(null))
             {
-                this.onDestroy(oldestKey, cachedAsset.asset);
+                break;
             }
-            delete cache[oldestKey];
-            cachedAsset.cacheHit = this.hitCounter;
-            cachedAsset.asset = null;
-            cachedAsset.isLoading = true;
-            cachedAsset.key = key;
-            cachedAsset.observer = Observer.create();
-            this.cache[key] = cachedAsset;
-        }
-        else
-        {
-            cachedAsset = this.cache[key] = cacheArray[cacheArrayLength] = {
-                cacheHit: this.hitCounter,
-                asset: null,
-                isLoading: true,
-                key: key,
-                observer: Observer.create()
-            };
         }
+
+        cachedAsset = {
+            cacheHit: this.hitCounter,
+            asset: null,
+            isLoading: true,
+            key: key,
+            observer: Observer.create(),
+            bytes: 0,
+            pinCount: 0,
+            prev: null,
+            next: null
+        };
         this.hitCounter += 1;
+        this.cache[key] = cachedAsset;
+        this._link(cachedAsset);
+        metrics.numAssets += 1;
 
         var that = this;
         var observer = cachedAsset.observer;
@@ -153,16 +155,23 @@ class AssetCache
         {
             observer.subscribe(callback);
         }
-        this.onLoad(key, params, function onLoadedAssetFn(asset)
+        this.onLoad(key, params, function onLoadedAssetFn(asset, bytes?: number)
                 {
-                    // Check cacheAsset has not been replaced during loading
-                    if (cachedAsset.key === key)
+                    // Check cacheAsset has not been evicted during loading
+                    if (that.cache[key] === cachedAsset)
                     {
                         cachedAsset.cacheHit = that.hitCounter;
                         cachedAsset.asset = asset;
                         cachedAsset.isLoading = false;
                         that.hitCounter += 1;
 
+                        if (bytes)
+                        {
+                            cachedAsset.bytes = bytes;
+                            metrics.bytes += bytes;
+                            that._enforceBudget(cachedAsset);
+                        }
+
                         cachedAsset.observer.notify(key, asset, params);
                     }
                     else
@@ -176,6 +185,148 @@ class AssetCache
                 });
     }
 
+    // Pinned assets are never evicted, pins are counted so every pin call
+    // requires an unpin call. Returns false if the key is not in the cache.
+    pin(key: string): boolean
+    {
+        var cachedAsset = this.cache[key];
+        if (cachedAsset)
+        {
+            if (cachedAsset.pinCount === 0)
+            {
+                this._unlink(cachedAsset);
+            }
+            cachedAsset.pinCount += 1;
+            return true;
+        }
+        return false;
+    }
+
+    unpin(key: string): boolean
+    {
+        var cachedAsset = this.cache[key];
+        if (cachedAsset && cachedAsset.pinCount > 0)
+        {
+            cachedAsset.pinCount -= 1;
+            if (cachedAsset.pinCount === 0)
+            {
+                this._link(cachedAsset);
+                this._enforceBudget(cachedAsset);
+            }
+            return true;
+        }
+        return false;
+    }
+
+    resetMetrics()
+    {
+        var metrics = this.metrics;
+        metrics.hits = 0;
+        metrics.misses = 0;
+        metrics.evictions = 0;
+    }
+
+    // Moves the asset to the most recently used end of the list
+    private _touch(cachedAsset: CachedAsset)
+    {
+        cachedAsset.cacheHit = this.hitCounter;
+        this.hitCounter += 1;
+        if (cachedAsset.pinCount === 0 &&
+            cachedAsset !== this.lruTail)
+        {
+            this._unlink(cachedAsset);
+            this._link(cachedAsset);
+        }
+    }
+
+    private _link(cachedAsset: CachedAsset)
+    {
+        var tail = this.lruTail;
+        cachedAsset.prev = tail;
+        cachedAsset.next = null;
+        if (tail)
+        {
+            tail.next = cachedAsset;
+        }
+        else
+        {
+            this.lruHead = cachedAsset;
+        }
+        this.lruTail = cachedAsset;
+    }
+
+    private _unlink(cachedAsset: CachedAsset)
+    {
+        var prev = cachedAsset.prev;
+        var next = cachedAsset.next;
+        if (prev)
+        {
+            prev.next = next;
+        }
+        else
+        {
+            this.lruHead = next;
+        }
+        if (next)
+        {
+            next.prev = prev;
+        }
+        else
+        {
+            this.lruTail = prev;
+        }
+        cachedAsset.prev = null;
+        cachedAsset.next = null;
+    }
+
+    // Evicts least recently used assets until the byte budget is met,
+    // the given asset is kept even if it does not fit on its own
+    private _enforceBudget(keep: CachedAsset)
+    {
+        var metrics = this.metrics;
+        var maxBytes = this.maxBytes;
+        while (metrics.bytes > maxBytes)
+        {
+            if (!this._evictOldest(keep))
+            {
+                break;
+            }
+        }
+    }
+
+    // Evicts the least recently used asset other than keep, returns false
+    // if there is none
+    private _evictOldest(keep: CachedAsset): boolean
+    {
+        var cachedAsset = this.lruHead;
+        if (cachedAsset === keep && cachedAsset)
+        {
+            cachedAsset = cachedAsset.next;
+        }
+        if (!cachedAsset)
+        {
+            return false;
+        }
+
+        this._unlink(cachedAsset);
+
+        var key = cachedAsset.key;
+        delete this.cache[key];
+
+        var metrics = this.metrics;
+        metrics.evictions += 1;
+        metrics.numAssets -= 1;
+        metrics.bytes -= cachedAsset.bytes;
+
+        // Assets still loading are destroyed when their load completes
+        if (this.onDestroy && !cachedAsset.isLoading)
+        {
+            this.onDestroy(key, cachedAsset.asset);
+        }
+        cachedAsset.asset = null;
+        return true;
+    }
+
     // Constructor function
     static create(cacheParams: AssetCacheParams): AssetCache
     {
@@ -186,13 +337,32 @@ class AssetCache
 
         var assetCache = new AssetCache();
 
-        assetCache.maxCacheSize = cacheParams.size || 64;
+        // With a byte budget the number of assets is only limited if requested
+        var maxBytes = cacheParams.maxBytes;
+        if (maxBytes)
+        {
+            assetCache.maxCacheSize = cacheParams.size || Number.MAX_VALUE;
+            assetCache.maxBytes = maxBytes;
+        }
+        else
+        {
+            assetCache.maxCacheSize = cacheParams.size || 64;
+            assetCache.maxBytes = Number.MAX_VALUE;
+        }
         assetCache.onLoad = cacheParams.onLoad;
         assetCache.onDestroy = cacheParams.onDestroy;
 
         assetCache.hitCounter = 0;
         assetCache.cache = {};
-        assetCache.cacheArray = [];
+        assetCache.metrics = {
+            hits: 0,
+            misses: 0,
+            evictions: 0,
+            numAssets: 0,
+            bytes: 0
+        };
+        assetCache.lruHead = null;
+        assetCache.lruTail = null;
 
         return assetCache;
     }
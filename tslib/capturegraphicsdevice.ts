@@ -18,9 +18,362 @@ var CaptureGraphicsCommand =
     setViewport:            13,
     beginOcclusionQuery:    14,
     endOcclusionQuery:      15,
-    updateTextureData:      16
+    updateTextureData:      16,
+    setInstanceStream:      17,
+    drawIndexedInstanced:   18,
+    drawInstanced:          19
 };
 
+//
+// CaptureStreamWriter
+//
+// Serialises a capture incrementally as a binary stream, so long captures do
+// not have to be kept in memory as JavaScript objects. The stream starts with
+// the 'TZCS' header and a varint version, followed by records made of a
+// record type byte and its payload:
+//
+//   name      : id, string
+//   data      : id, type, length, raw little endian values
+//   object    : id, count, (name id, value) pairs
+//   command   : id, method, count, values
+//   frame     : width, height, count, command ids
+//   resources : JSON string with the resources created since the last one
+//   reset     : full flag, forget the data, objects and commands, plus the
+//               names and resources when the flag is set
+//
+// Integers are unsigned LEB128 varints and strings are a varint byte length
+// followed by UTF-8. Values are a tag byte followed by the value, see
+// CaptureStreamValue. Data, objects and commands are interned as they are
+// by CaptureGraphicsDevice, each one is written once when first seen and
+// later referenced by id.
+//
+var CaptureStreamRecord =
+{
+    name:       1,
+    data:       2,
+    object:     3,
+    command:    4,
+    frame:      5,
+    resources:  6,
+    reset:      7
+};
+
+var CaptureStreamValue =
+{
+    none:       0,
+    boolFalse:  1,
+    boolTrue:   2,
+    integer:    3,
+    negative:   4,
+    float:      5,
+    id:         6,
+    string:     7,
+    array:      8,
+    json:       9
+};
+
+var CaptureStreamDataType =
+{
+    float32:    1,
+    uint8:      2,
+    int8:       3,
+    uint16:     4,
+    int16:      5,
+    uint32:     6,
+    int32:      7
+};
+
+interface CaptureStreamWriterParameters
+{
+    onchunk: { (chunk: Uint8Array): void; };
+    chunkSize?: number;
+}
+
+class CaptureStreamWriter
+{
+    public static version = 1;
+
+    onchunk: { (chunk: Uint8Array): void; };
+    chunkSize: number;
+    bytes: Uint8Array;
+    offset: number;
+    totalBytes: number;
+    tableBytes: number;
+    scratch: DataView;
+    scratchBytes: Uint8Array;
+
+    constructor(params: CaptureStreamWriterParameters)
+    {
+        this.onchunk = params.onchunk;
+        this.chunkSize = (params.chunkSize || (64 * 1024));
+        this.bytes = new Uint8Array(this.chunkSize);
+        this.offset = 0;
+        this.totalBytes = 0;
+        this.tableBytes = 0;
+        var scratchBuffer = new ArrayBuffer(8);
+        this.scratch = new DataView(scratchBuffer);
+        this.scratchBytes = new Uint8Array(scratchBuffer);
+
+        var header = 'TZCS';
+        this._reserve(4);
+        for (var n = 0; n < 4; n += 1)
+        {
+            this.bytes[n] = header.charCodeAt(n);
+        }
+        this.offset = 4;
+        this._writeVarint(CaptureStreamWriter.version);
+        return this;
+    }
+
+    private _reserve(size: number)
+    {
+        if (this.bytes.length < (this.offset + size))
+        {
+            this.flush();
+            if (this.bytes.length < size)
+            {
+                this.bytes = new Uint8Array(size);
+            }
+        }
+    }
+
+    private _writeByte(value: number)
+    {
+        this._reserve(1);
+        this.bytes[this.offset] = value;
+        this.offset += 1;
+    }
+
+    private _writeVarint(value: number)
+    {
+        this._reserve(8);
+        var bytes = this.bytes;
+        var offset = this.offset;
+        while (128 <= value)
+        {
+            bytes[offset] = (128 + (value % 128));
+            offset += 1;
+            value = Math.floor(value / 128);
+        }
+        bytes[offset] = value;
+        this.offset = (offset + 1);
+    }
+
+    private _writeBytes(source: Uint8Array)
+    {
+        this._reserve(source.length);
+        this.bytes.set(source, this.offset);
+        this.offset += source.length;
+    }
+
+    private _writeString(value: string)
+    {
+        var utf8 = unescape(encodeURIComponent(value));
+        var length = utf8.length;
+        this._writeVarint(length);
+        this._reserve(length);
+        var bytes = this.bytes;
+        var offset = this.offset;
+        for (var n = 0; n < length; n += 1)
+        {
+            bytes[offset + n] = utf8.charCodeAt(n);
+        }
+        this.offset = (offset + length);
+    }
+
+    private _writeValue(value: any)
+    {
+        if (value === undefined || value === null)
+        {
+            this._writeByte(CaptureStreamValue.none);
+        }
+        else if (typeof value === "boolean")
+        {
+            this._writeByte(value ? CaptureStreamValue.boolTrue : CaptureStreamValue.boolFalse);
+        }
+        else if (typeof value === "number")
+        {
+            if (Math.floor(value) === value &&
+                Math.abs(value) <= 9007199254740991)
+            {
+                if (0 <= value)
+                {
+                    this._writeByte(CaptureStreamValue.integer);
+                    this._writeVarint(value);
+                }
+                else
+                {
+                    this._writeByte(CaptureStreamValue.negative);
+                    this._writeVarint(-1 - value);
+                }
+            }
+            else
+            {
+                this._writeByte(CaptureStreamValue.float);
+                this.scratch.setFloat32(0, value, true);
+                this._reserve(4);
+                this.bytes.set(this.scratchBytes.subarray(0, 4), this.offset);
+                this.offset += 4;
+            }
+        }
+        else if (typeof value === "string")
+        {
+            // Ids of entities are stored as strings by the capture
+            var id = parseInt(value, 10);
+            if (0 <= id && id.toString() === value)
+            {
+                this._writeByte(CaptureStreamValue.id);
+                this._writeVarint(id);
+            }
+            else
+            {
+                this._writeByte(CaptureStreamValue.string);
+                this._writeString(value);
+            }
+        }
+        else if (value instanceof Array)
+        {
+            var length = value.length;
+            this._writeByte(CaptureStreamValue.array);
+            this._writeVarint(length);
+            for (var n = 0; n < length; n += 1)
+            {
+                this._writeValue(value[n]);
+            }
+        }
+        else
+        {
+            this._writeByte(CaptureStreamValue.json);
+            this._writeString(JSON.stringify(value));
+        }
+    }
+
+    // Hands the bytes written so far to onchunk
+    public flush()
+    {
+        var offset = this.offset;
+        if (0 < offset)
+        {
+            var chunk = this.bytes.subarray(0, offset);
+            this.totalBytes += offset;
+            this.bytes = new Uint8Array(this.chunkSize);
+            this.offset = 0;
+            this.onchunk(chunk);
+        }
+    }
+
+    public writeName(id: number, name: string)
+    {
+        var start = this.totalBytes + this.offset;
+        this._writeByte(CaptureStreamRecord.name);
+        this._writeVarint(id);
+        this._writeString(name);
+        this.tableBytes += (this.totalBytes + this.offset - start);
+    }
+
+    public writeData(id: number, data: any)
+    {
+        var type;
+        if (data instanceof Float32Array)
+        {
+            type = CaptureStreamDataType.float32;
+        }
+        else if (data instanceof Int8Array)
+        {
+            type = CaptureStreamDataType.int8;
+        }
+        else if (data instanceof Uint16Array)
+        {
+            type = CaptureStreamDataType.uint16;
+        }
+        else if (data instanceof Int16Array)
+        {
+            type = CaptureStreamDataType.int16;
+        }
+        else if (data instanceof Uint32Array)
+        {
+            type = CaptureStreamDataType.uint32;
+        }
+        else if (data instanceof Int32Array)
+        {
+            type = CaptureStreamDataType.int32;
+        }
+        else
+        {
+            type = CaptureStreamDataType.uint8;
+        }
+
+        var start = this.totalBytes + this.offset;
+        this._writeByte(CaptureStreamRecord.data);
+        this._writeVarint(id);
+        this._writeByte(type);
+        this._writeVarint(data.length);
+        this._writeBytes(new Uint8Array(data.buffer, data.byteOffset, data.byteLength));
+        this.tableBytes += (this.totalBytes + this.offset - start);
+    }
+
+    public writeObject(id: number, objectArray: any[])
+    {
+        var length = objectArray.length;
+        var start = this.totalBytes + this.offset;
+        this._writeByte(CaptureStreamRecord.object);
+        this._writeVarint(id);
+        this._writeVarint(length >>> 1);
+        for (var n = 0; n < length; n += 2)
+        {
+            this._writeVarint(objectArray[n]);
+            this._writeValue(objectArray[n + 1]);
+        }
+        this.tableBytes += (this.totalBytes + this.offset - start);
+    }
+
+    public writeCommand(id: number, command: any[])
+    {
+        var length = command.length;
+        var start = this.totalBytes + this.offset;
+        this._writeByte(CaptureStreamRecord.command);
+        this._writeVarint(id);
+        this._writeVarint(command[0]);
+        this._writeVarint(length - 1);
+        for (var a = 1; a < length; a += 1)
+        {
+            this._writeValue(command[a]);
+        }
+        this.tableBytes += (this.totalBytes + this.offset - start);
+    }
+
+    public writeFrame(width: number, height: number, commandIds: number[])
+    {
+        var numCommands = commandIds.length;
+        this._writeByte(CaptureStreamRecord.frame);
+        this._writeVarint(width);
+        this._writeVarint(height);
+        this._writeVarint(numCommands);
+        for (var n = 0; n < numCommands; n += 1)
+        {
+            this._writeVarint(commandIds[n]);
+        }
+    }
+
+    public writeResources(resourcesString: string)
+    {
+        this._writeByte(CaptureStreamRecord.resources);
+        this._writeString(resourcesString);
+    }
+
+    public writeReset(full: boolean)
+    {
+        this._writeByte(CaptureStreamRecord.reset);
+        this._writeByte(full ? 1 : 0);
+        this.tableBytes = 0;
+    }
+
+    public static create(params: CaptureStreamWriterParameters) : CaptureStreamWriter
+    {
+        return new CaptureStreamWriter(params);
+    }
+}
+
 class CaptureGraphicsDevice
 {
     public static version = 1;
@@ -57,6 +410,9 @@ class CaptureGraphicsDevice
     renderTargets: {};
     occlusionQueries: {};
     reverseSemantic: string[];
+    stream: CaptureStreamWriter;
+    streamTableSize: number;
+    streamedResources: {};
 
     constructor(gd)
     {
@@ -109,6 +465,9 @@ class CaptureGraphicsDevice
         this.renderTargets = {};
         this.occlusionQueries = {};
         this.reverseSemantic = reverseSemantic;
+        this.stream = null;
+        this.streamTableSize = 0;
+        this.streamedResources = {};
         return this;
     }
 
@@ -286,6 +645,11 @@ class CaptureGraphicsDevice
             dataBin.push(id, clonedData);
         }
 
+        if (this.stream)
+        {
+            this.stream.writeData(id, clonedData);
+        }
+
         return id.toString();
     }
 
@@ -354,6 +718,11 @@ class CaptureGraphicsDevice
             commandsBin.push(cmdId, command);
         }
 
+        if (this.stream)
+        {
+            this.stream.writeCommand(cmdId, command);
+        }
+
         this.current.push(cmdId);
     }
 
@@ -422,6 +791,11 @@ class CaptureGraphicsDevice
             nameId = this.numNames;
             this.numNames += 1;
             this.names[name] = nameId;
+
+            if (this.stream)
+            {
+                this.stream.writeName(nameId, name);
+            }
         }
         return nameId;
     }
@@ -480,6 +854,11 @@ class CaptureGraphicsDevice
             objectsBin.push(id, objectArray.slice());
         }
 
+        if (this.stream)
+        {
+            this.stream.writeObject(id, objectArray);
+        }
+
         return id.toString();
     }
 
@@ -987,6 +1366,20 @@ class CaptureGraphicsDevice
         this._addCommand(CaptureGraphicsCommand.draw, primitive, numVertices, first || 0);
     }
 
+    public drawIndexedInstanced(primitive, numIndices, numInstances, first)
+    {
+        this.gd.drawIndexedInstanced(primitive, numIndices, numInstances, first);
+
+        this._addCommand(CaptureGraphicsCommand.drawIndexedInstanced, primitive, numIndices, numInstances, first || 0);
+    }
+
+    public drawInstanced(primitive, numVertices, numInstances, first)
+    {
+        this.gd.drawInstanced(primitive, numVertices, numInstances, first);
+
+        this._addCommand(CaptureGraphicsCommand.drawInstanced, primitive, numVertices, numInstances, first || 0);
+    }
+
     public setTechniqueParameters(unused?)
     {
         var numTechniqueParameters = arguments.length;
@@ -1060,6 +1453,17 @@ class CaptureGraphicsDevice
         this.gd.setStream(vertexBuffer, semantics, offset);
     }
 
+    public setInstanceStream(vertexBuffer, semantics, offset)
+    {
+        if (offset === undefined)
+        {
+            offset = 0;
+        }
+        this._addCommand(CaptureGraphicsCommand.setInstanceStream, vertexBuffer._id, semantics._id, offset);
+
+        this.gd.setInstanceStream(vertexBuffer, semantics, offset);
+    }
+
     public setIndexBuffer(indexBuffer)
     {
         this._addCommand(CaptureGraphicsCommand.setIndexBuffer, indexBuffer._id);
@@ -1067,6 +1471,11 @@ class CaptureGraphicsDevice
         this.gd.setIndexBuffer(indexBuffer);
     }
 
+    public setTechniqueInstancing(technique, instancing)
+    {
+        return this.gd.setTechniqueInstancing(technique, instancing);
+    }
+
     public drawArray(drawParametersArray, globalTechniqueParametersArray, sortMode)
     {
         var numDrawParameters = drawParametersArray.length;
@@ -1091,6 +1500,16 @@ class CaptureGraphicsDevice
             }
         }
 
+        var gd = this.gd;
+
+        // The instance buffers of the batches are created through the capture
+        // so their data is recorded, the batches play back as instanced draws
+        if (gd._numInstancedTechniques)
+        {
+            drawParametersArray = gd._batchInstances(drawParametersArray, this);
+            numDrawParameters = drawParametersArray.length;
+        }
+
         var numGlobalTechniqueParameters = globalTechniqueParametersArray.length;
 
         var currentParameters = null;
@@ -1107,7 +1526,6 @@ class CaptureGraphicsDevice
 
         var drawCommand = -1;
         var current = this.current;
-        var gd = this.gd;
 
         for (var n = 0; n < numDrawParameters; n += 1)
         {
@@ -1120,6 +1538,8 @@ class CaptureGraphicsDevice
             var primitive = drawParameters.primitive;
             var count = drawParameters.count;
             var firstIndex = drawParameters.firstIndex;
+            var instanceCount = drawParameters.instanceCount;
+            var instanceStreams = drawParameters._instanceStreams;
 
             if (lastTechnique !== technique)
             {
@@ -1153,7 +1573,8 @@ class CaptureGraphicsDevice
                                                      currentParameters);
             }
 
-            streamsMatch = (lastEndStreams === endStreams);
+            streamsMatch = (lastEndStreams === endStreams &&
+                            lastDrawParameters._instanceStreams === instanceStreams);
             for (v = 0; streamsMatch && v < endStreams; v += 3)
             {
                 streamsMatch = (lastDrawParameters[v]     === drawParameters[v]     &&
@@ -1171,7 +1592,16 @@ class CaptureGraphicsDevice
                     vertexBuffer = drawParameters[v];
                     if (vertexBuffer)
                     {
-                        this.setStream(vertexBuffer, drawParameters[v + 1], drawParameters[v + 2]);
+                        /* tslint:disable:no-bitwise */
+                        if (0 === (instanceStreams & (1 << (v / 3))))
+                        {
+                            this.setStream(vertexBuffer, drawParameters[v + 1], drawParameters[v + 2]);
+                        }
+                        else
+                        {
+                            this.setInstanceStream(vertexBuffer, drawParameters[v + 1], drawParameters[v + 2]);
+                        }
+                        /* tslint:enable:no-bitwise */
                     }
                 }
             }
@@ -1209,6 +1639,10 @@ class CaptureGraphicsDevice
                     }
                     while (t < endInstances);
                 }
+                else if (instanceCount)
+                {
+                    this.drawIndexedInstanced(primitive, count, instanceCount, firstIndex);
+                }
                 else
                 {
                     this.drawIndexed(primitive, count, firstIndex);
@@ -1240,6 +1674,10 @@ class CaptureGraphicsDevice
                     }
                     while (t < endInstances);
                 }
+                else if (instanceCount)
+                {
+                    this.drawInstanced(primitive, count, instanceCount, firstIndex);
+                }
                 else
                 {
                     this.draw(primitive, count, firstIndex);
@@ -1353,6 +1791,11 @@ class CaptureGraphicsDevice
         return this.gd.beginFrame();
     }
 
+    public updateShaderPrograms(maxTime)
+    {
+        return this.gd.updateShaderPrograms(maxTime);
+    }
+
     public beginRenderTarget(renderTarget)
     {
         this._addCommand(CaptureGraphicsCommand.beginRenderTarget, renderTarget._id);
@@ -1383,8 +1826,24 @@ class CaptureGraphicsDevice
 
     public endFrame()
     {
-        this.frames.push(this.current);
-        this.current = [];
+        var stream = this.stream;
+        if (stream)
+        {
+            // Frames are not kept once written to the stream
+            this._streamResources();
+            stream.writeFrame(this.gd.width, this.gd.height, this.current);
+            this.current.length = 0;
+
+            if (this.streamTableSize < stream.tableBytes)
+            {
+                this._resetStreamTables();
+            }
+        }
+        else
+        {
+            this.frames.push(this.current);
+            this.current = [];
+        }
 
         this.gd.endFrame();
 
@@ -2451,6 +2910,184 @@ class CaptureGraphicsDevice
         });
     }
 
+    // Writes the resources created since the last call
+    private _streamResources()
+    {
+        var resources = {
+            vertexBuffers: this.vertexBuffers,
+            indexBuffers: this.indexBuffers,
+            techniqueParameterBuffers: this.techniqueParameterBuffers,
+            semantics: this.semantics,
+            formats: this.formats,
+            textures: this.textures,
+            shaders: this.shaders,
+            techniques: this.techniques,
+            videos: this.videos,
+            renderBuffers: this.renderBuffers,
+            renderTargets: this.renderTargets
+        };
+        var streamedResources = this.streamedResources;
+        var newResources = null;
+        var type, resourceMap, streamedMap, id;
+        for (type in resources)
+        {
+            if (resources.hasOwnProperty(type))
+            {
+                resourceMap = resources[type];
+                streamedMap = streamedResources[type];
+                if (streamedMap === undefined)
+                {
+                    streamedResources[type] = streamedMap = {};
+                }
+                for (id in resourceMap)
+                {
+                    if (resourceMap.hasOwnProperty(id) &&
+                        streamedMap[id] === undefined)
+                    {
+                        streamedMap[id] = true;
+                        if (!newResources)
+                        {
+                            newResources = {};
+                        }
+                        if (newResources[type] === undefined)
+                        {
+                            newResources[type] = {};
+                        }
+                        newResources[type][id] = resourceMap[id];
+                    }
+                }
+            }
+        }
+
+        if (newResources)
+        {
+            this.stream.writeResources(JSON.stringify({
+                version: 1,
+                resources: newResources
+            }));
+        }
+    }
+
+    // Writes everything captured so far, used when a stream is attached late
+    private _streamTables()
+    {
+        var stream = this.stream;
+        var p, n, bin, binLength;
+
+        var names = this.names;
+        for (p in names)
+        {
+            if (names.hasOwnProperty(p))
+            {
+                stream.writeName(names[p], p);
+            }
+        }
+
+        var dataBinsArray = [this.integerData, this.floatData, this.mixedData];
+        for (var d = 0; d < 3; d += 1)
+        {
+            var dataBins = dataBinsArray[d];
+            for (p in dataBins)
+            {
+                if (dataBins.hasOwnProperty(p))
+                {
+                    bin = dataBins[p];
+                    binLength = bin.length;
+                    for (n = 0; n < binLength; n += 2)
+                    {
+                        stream.writeData(bin[n], bin[n + 1]);
+                    }
+                }
+            }
+        }
+
+        var objects = this.objects;
+        for (p in objects)
+        {
+            if (objects.hasOwnProperty(p))
+            {
+                bin = objects[p];
+                binLength = bin.length;
+                for (n = 0; n < binLength; n += 2)
+                {
+                    stream.writeObject(bin[n], bin[n + 1]);
+                }
+            }
+        }
+
+        var commands = this.commands;
+        var numMethods = commands.length;
+        for (p = 0; p < numMethods; p += 1)
+        {
+            bin = commands[p];
+            if (bin !== undefined)
+            {
+                binLength = bin.length;
+                for (n = 0; n < binLength; n += 2)
+                {
+                    stream.writeCommand(bin[n], bin[n + 1]);
+                }
+            }
+        }
+
+        this._streamResources();
+
+        var frames = this.frames;
+        var numFrames = frames.length;
+        for (n = 0; n < numFrames; n += 1)
+        {
+            stream.writeFrame(this.gd.width, this.gd.height, frames[n]);
+            frames[n] = null;
+        }
+        frames.length = 0;
+    }
+
+    // Forgets the interned commands, objects and data so their memory does not
+    // grow without bounds while streaming, the resources and names are kept
+    private _resetStreamTables()
+    {
+        var commands = this.commands;
+        var numMethods = commands.length;
+        var n;
+        for (n = 0; n < numMethods; n += 1)
+        {
+            if (commands[n] !== undefined)
+            {
+                commands[n].length = 0;
+            }
+        }
+        this.numCommands = 0;
+
+        this._recycleDataBinIds(this.integerData);
+        this._recycleDataBinIds(this.floatData);
+        this._recycleDataBinIds(this.mixedData);
+        this._recycleDataBinIds(this.objects);
+
+        // Sort higher to lower so we pop low ids first
+        this.recycledIds.sort(function (a, b) { return (b - a); });
+
+        this.stream.writeReset(false);
+    }
+
+    // Serialises the capture into the given stream from now on instead of
+    // keeping the frames in memory. Anything already captured is written
+    // first. The interned data is reset whenever the definitions written
+    // since the last reset go over tableSize bytes.
+    public setStreamWriter(stream: CaptureStreamWriter, tableSize?: number)
+    {
+        if (this.stream)
+        {
+            this.stream.flush();
+        }
+        this.stream = stream;
+        this.streamTableSize = (tableSize || (16 * 1024 * 1024));
+        this.streamedResources = {};
+        if (stream)
+        {
+            this._streamTables();
+        }
+    }
+
     private _recycleDataBinIds(dataBins)
     {
         var recycledIds = this.recycledIds;
@@ -2534,6 +3171,12 @@ class CaptureGraphicsDevice
         this.names = {};
         this.numNames = 0;
 
+        if (this.stream)
+        {
+            this.stream.writeReset(true);
+            this.streamedResources = {};
+        }
+
         this.vertexBuffers = {};
         this.indexBuffers = {};
         this.techniqueParameterBuffers = {};
@@ -2550,6 +3193,11 @@ class CaptureGraphicsDevice
 
     public destroy()
     {
+        if (this.stream)
+        {
+            this.stream.flush();
+            this.stream = null;
+        }
         this.gd.destroy();
         this.gd = null;
         this.current = null;
@@ -3223,6 +3871,19 @@ class PlaybackGraphicsDevice
                 command[1] = this._resolveEntity(command[1]); // Object
                 command[2] = this._resolveEntity(command[2]); // Data
             }
+            else if (method === CaptureGraphicsCommand.setInstanceStream)
+            {
+                command[1] = this._resolveEntity(command[1]); // VertexBuffer
+                command[2] = this._resolveEntity(command[2]); // Semantics
+            }
+            else if (method === CaptureGraphicsCommand.drawIndexedInstanced)
+            {
+                // Nothing to resolve
+            }
+            else if (method === CaptureGraphicsCommand.drawInstanced)
+            {
+                // Nothing to resolve
+            }
             else
             {
                 if (this.onerror)
@@ -3524,6 +4185,26 @@ class PlaybackGraphicsDevice
                                    command[5], command[6],
                                    command[7], command[8]);
             }
+            else if (method === CaptureGraphicsCommand.setInstanceStream)
+            {
+                gd.setInstanceStream(command[1],
+                                     command[2],
+                                     command[3]);
+            }
+            else if (method === CaptureGraphicsCommand.drawIndexedInstanced)
+            {
+                gd.drawIndexedInstanced(command[1],
+                                        command[2],
+                                        command[3],
+                                        command[4]);
+            }
+            else if (method === CaptureGraphicsCommand.drawInstanced)
+            {
+                gd.drawInstanced(command[1],
+                                 command[2],
+                                 command[3],
+                                 command[4]);
+            }
             else
             {
                 if (this.onerror)
@@ -62,6 +62,14 @@ class CascadedShadowSplit
     numOverlappingRenderables: number;
     needsRedraw: boolean;
     needsBlur: boolean;
+    needsRefilter: boolean;
+
+    // Light space bounds of the receivers visible in the split
+    minReceiverX: number;
+    maxReceiverX: number;
+    minReceiverY: number;
+    maxReceiverY: number;
+    maxReceiverDistance: number;
 
     overlappingRenderables: Renderable[];
     overlappingExtents: Float32Array[]; // AABB
@@ -113,6 +121,13 @@ class CascadedShadowSplit
         this.numStaticOverlappingRenderables = -1;
         this.needsRedraw = false;
         this.needsBlur = false;
+        this.needsRefilter = false;
+
+        this.minReceiverX = 0;
+        this.maxReceiverX = 0;
+        this.minReceiverY = 0;
+        this.maxReceiverY = 0;
+        this.maxReceiverDistance = 0;
 
         this.overlappingRenderables = [];
         this.overlappingExtents = [];
@@ -160,6 +175,11 @@ class CascadedShadowMapping
 
     static splitDistances = [1.0 / 100.0, 4.0 / 100.0, 20.0 / 100.0, 1.0];
 
+    // Number of frames between redraws of each split, staggered so the far
+    // splits are not all redrawn on the same frame. In between, the previous
+    // map is reprojected as long as it still covers the split.
+    static splitUpdateIntervals = [1, 2, 4, 8];
+
     gd                  : GraphicsDevice;
     md                  : MathDevice;
     clearColor          : any; // v4
@@ -497,6 +517,15 @@ class CascadedShadowMapping
                     });
                     if (this.renderTarget)
                     {
+                        // The previous maps are lost
+                        var splits = this.splits;
+                        var numSplits = splits.length;
+                        var n;
+                        for (n = 0; n < numSplits; n += 1)
+                        {
+                            splits[n].staticNodesChangeCounter = -1;
+                        }
+
                         var techniqueParameters = this.techniqueParameters;
                         /* tslint:disable:no-string-literal */
                         techniqueParameters['shadowSize'] = size;
@@ -659,11 +688,19 @@ class CascadedShadowMapping
         var yaxis = md.v3Cross(zaxis, xaxis, this.tempV3AxisY);
 
         var splitDistances = CascadedShadowMapping.splitDistances;
+        var splitUpdateIntervals = CascadedShadowMapping.splitUpdateIntervals;
         var splits = this.splits;
         var numSplits = splits.length;
         var splitStart = -sideCamera.nearPlane;
         var previousSplitPoints = [];
-        var n, split, splitEnd;
+        var frameIndex = scene.frameIndex;
+        var staticNodesChangeCounter = scene.staticNodesChangeCounter;
+        var n, split, splitEnd, interval, drawn;
+
+        // Trimming a split against the previous ones, or skipping the occluders
+        // they fully contain, is only safe while they are all redrawn together
+        var splitsInStep = true;
+
         for (n = 0; n < numSplits; n += 1)
         {
             split = splits[n];
@@ -677,31 +714,20 @@ class CascadedShadowMapping
                                                                        maxDistance,
                                                                        floorPlane);
 
-            this._updateSplit(split,
-                              xaxis,
-                              yaxis,
-                              zaxis,
-                              cameraMatrix,
-                              this.clampedFrustumPoints,
-                              numClampedFrustumPoints,
-                              previousSplitPoints,
-                              scene,
-                              maxDistance);
-
-            splitStart = splitEnd;
-
-            if (0 === split.occludersToDraw.length &&
-                (n + 1) < numSplits)
+            interval = (splitUpdateIntervals[n] || 1);
+            if (1 < interval)
             {
-                splitEnd = (splitEnd + (sideCameraMaxDistance * splitDistances[n + 1])) / 2.0;
-
-                numClampedFrustumPoints = this._getSideCameraFrustumPoints(splitEnd,
-                                                                           splitStart,
-                                                                           direction,
-                                                                           camera,
-                                                                           maxDistance,
-                                                                           floorPlane);
+                splitsInStep = false;
+            }
 
+            if (((frameIndex + n) % interval) === 0 ||
+                !this._splitCovers(split,
+                                   zaxis,
+                                   staticNodesChangeCounter,
+                                   this.clampedFrustumPoints,
+                                   numClampedFrustumPoints))
+            {
+                drawn = true;
                 this._updateSplit(split,
                                   xaxis,
                                   yaxis,
@@ -709,9 +735,46 @@ class CascadedShadowMapping
                                   cameraMatrix,
                                   this.clampedFrustumPoints,
                                   numClampedFrustumPoints,
-                                  previousSplitPoints,
+                                  (splitsInStep ? previousSplitPoints : []),
                                   scene,
-                                  maxDistance);
+                                  maxDistance,
+                                  splitsInStep);
+            }
+            else
+            {
+                // Keep the previous map and reproject it for the current view
+                drawn = false;
+                this._updateViewShadowProjection(split, cameraMatrix);
+            }
+
+            splitStart = splitEnd;
+
+            if (0 === split.occludersToDraw.length &&
+                (n + 1) < numSplits)
+            {
+                splitEnd = (splitEnd + (sideCameraMaxDistance * splitDistances[n + 1])) / 2.0;
+
+                if (drawn)
+                {
+                    numClampedFrustumPoints = this._getSideCameraFrustumPoints(splitEnd,
+                                                                               splitStart,
+                                                                               direction,
+                                                                               camera,
+                                                                               maxDistance,
+                                                                               floorPlane);
+
+                    this._updateSplit(split,
+                                      xaxis,
+                                      yaxis,
+                                      zaxis,
+                                      cameraMatrix,
+                                      this.clampedFrustumPoints,
+                                      numClampedFrustumPoints,
+                                      (splitsInStep ? previousSplitPoints : []),
+                                      scene,
+                                      maxDistance,
+                                      splitsInStep);
+                }
 
                 splitStart = splitEnd;
             }
@@ -1388,7 +1451,8 @@ class CascadedShadowMapping
                          numFrustumPoints: number,
                          previousSplitPoints: any[],
                          scene: Scene,
-                         maxDistance: number): void
+                         maxDistance: number,
+                         splitsInStep: boolean): void
     {
         var md = this.md;
 
@@ -1552,6 +1616,7 @@ class CascadedShadowMapping
         var numStaticOverlappingRenderables = split.numStaticOverlappingRenderables;
 
         if (frustumUpdated ||
+            split.needsRefilter ||
             numStaticOverlappingRenderables !== numOverlappingRenderables)
         {
             if (!split.needsRedraw)
@@ -1560,6 +1625,10 @@ class CascadedShadowMapping
                 this.numSplitsToRedraw += 1;
             }
 
+            // The receivers are the ones visible on the previous frame, so check
+            // them again on the next frame even if the split does not move
+            split.needsRefilter = frustumUpdated;
+
             var occludeesExtents = this.occludeesExtents;
             var occludersExtents = this.occludersExtents;
 
@@ -1571,6 +1640,10 @@ class CascadedShadowMapping
                                                      occludersExtents,
                                                      (scene.frameIndex - 1));
 
+            this._updateReceiversLimits(split,
+                                        viewMatrix,
+                                        occludeesExtents);
+
             numOccluders = this._updateOccludersLimits(split,
                                                        viewMatrix,
                                                        occluders,
@@ -1773,7 +1846,8 @@ class CascadedShadowMapping
                                                                    occludersToDraw,
                                                                    camera.frustumPlanes,
                                                                    (scene.frameIndex - 1),
-                                                                   split.numOccluders);
+                                                                   split.numOccluders,
+                                                                   splitsInStep);
             occludersToDraw.length = numOccludersToDraw;
 
             if (1 < numOccludersToDraw)
@@ -1782,7 +1856,80 @@ class CascadedShadowMapping
             }
         }
 
-        var shadowProjection = camera.viewProjectionMatrix;
+        this._updateViewShadowProjection(split, mainCameraMatrix);
+
+        if (occludersToDraw.length)
+        {
+            frustumPoints = camera.getFrustumFarPoints(camera.farPlane, split.frustumPoints);
+            for (n = 0; n < 4; n += 1)
+            {
+                previousSplitPoints.push(frustumPoints[n]);
+            }
+        }
+    }
+
+    // Checks if the map drawn for the split still covers the given split
+    // frustum, which is the case while the light direction and the static
+    // nodes are unchanged and the frustum is inside the previous split window
+    private _splitCovers(split: CascadedShadowSplit,
+                         zaxis: any,
+                         staticNodesChangeCounter: number,
+                         frustumPoints: any[],
+                         numFrustumPoints: number): boolean
+    {
+        var at = split.at;
+        if (split.staticNodesChangeCounter !== staticNodesChangeCounter ||
+            at[0] !== zaxis[0] ||
+            at[1] !== zaxis[1] ||
+            at[2] !== zaxis[2])
+        {
+            return false;
+        }
+
+        var matrix = split.camera.matrix;
+        var r0 = matrix[0];
+        var r1 = matrix[1];
+        var r2 = matrix[2];
+        var u0 = matrix[3];
+        var u1 = matrix[4];
+        var u2 = matrix[5];
+
+        var origin = split.origin;
+        var o0 = origin[0];
+        var o1 = origin[1];
+        var o2 = origin[2];
+
+        var viewWindowX = split.viewWindowX;
+        var viewWindowY = split.viewWindowY;
+
+        var n, p, d0, d1, d2, d;
+        for (n = 0; n < numFrustumPoints; n += 1)
+        {
+            p = frustumPoints[n];
+            d0 = (p[0] - o0);
+            d1 = (p[1] - o1);
+            d2 = (p[2] - o2);
+
+            d = ((r0 * d0) + (r1 * d1) + (r2 * d2));
+            if (d < -viewWindowX || viewWindowX < d)
+            {
+                return false;
+            }
+
+            d = ((u0 * d0) + (u1 * d1) + (u2 * d2));
+            if (d < -viewWindowY || viewWindowY < d)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    private _updateViewShadowProjection(split: CascadedShadowSplit, mainCameraMatrix: any): void
+    {
+        var md = this.md;
+        var shadowProjection = split.camera.viewProjectionMatrix;
 
         var shadowDepthScale = split.shadowDepthScale;
         var shadowDepthOffset = (shadowDepthScale ? split.shadowDepthOffset : 1.0);
@@ -1807,15 +1954,6 @@ class CascadedShadowMapping
         var shadowOffset = split.shadowOffset;
         shadowOffset[0] = (split.viewportX * invSize) + 0.25;
         shadowOffset[1] = (split.viewportY * invSize) + 0.25;
-
-        if (occludersToDraw.length)
-        {
-            frustumPoints = camera.getFrustumFarPoints(camera.farPlane, split.frustumPoints);
-            for (n = 0; n < 4; n += 1)
-            {
-                previousSplitPoints.push(frustumPoints[n]);
-            }
-        }
     }
 
     private _updateRenderables(split: CascadedShadowSplit,
@@ -2200,12 +2338,14 @@ class CascadedShadowMapping
         }
     }
 
-    private _updateOccludersLimits(split: CascadedShadowSplit,
+    // Light space bounds of the receivers inside the split window, occluders
+    // outside them or behind all of them cannot cast visible shadows
+    private _updateReceiversLimits(split: CascadedShadowSplit,
                                    viewMatrix: any,
-                                   occluders: CascadedShadowOccluder[],
-                                   occludersExtents: Float32Array[],
-                                   numOccluders: number): number
+                                   occludeesExtents: Float32Array[]): void
     {
+        var numOccludees = this.numOccludees;
+
         var r0 = -viewMatrix[0];
         var r1 = -viewMatrix[3];
         var r2 = -viewMatrix[6];
@@ -2227,6 +2367,125 @@ class CascadedShadowMapping
         var minWindowY = -maxWindowY;
         var maxWindowZ = split.lightDepth;
 
+        var minReceiverX = Number.MAX_VALUE;
+        var maxReceiverX = -minReceiverX;
+        var minReceiverY = minReceiverX;
+        var maxReceiverY = -minReceiverX;
+        var maxReceiverDistance = -minReceiverX;
+        var numReceivers = 0;
+
+        var n, extents, n0, n1, n2, p0, p1, p2;
+        var minX, maxX, minY, maxY, minZ, maxZ;
+
+        for (n = 0; n < numOccludees; n += 1)
+        {
+            extents = occludeesExtents[n];
+            n0 = extents[0];
+            n1 = extents[1];
+            n2 = extents[2];
+            p0 = extents[3];
+            p1 = extents[4];
+            p2 = extents[5];
+
+            minX = ((r0 * (r0 > 0 ? n0 : p0)) +
+                    (r1 * (r1 > 0 ? n1 : p1)) +
+                    (r2 * (r2 > 0 ? n2 : p2)) -
+                    roffset);
+            maxX = ((r0 * (r0 > 0 ? p0 : n0)) +
+                    (r1 * (r1 > 0 ? p1 : n1)) +
+                    (r2 * (r2 > 0 ? p2 : n2)) -
+                    roffset);
+            minY = ((u0 * (u0 > 0 ? n0 : p0)) +
+                    (u1 * (u1 > 0 ? n1 : p1)) +
+                    (u2 * (u2 > 0 ? n2 : p2)) -
+                    uoffset);
+            maxY = ((u0 * (u0 > 0 ? p0 : n0)) +
+                    (u1 * (u1 > 0 ? p1 : n1)) +
+                    (u2 * (u2 > 0 ? p2 : n2)) -
+                    uoffset);
+            minZ = ((d0 * (d0 > 0 ? n0 : p0)) +
+                    (d1 * (d1 > 0 ? n1 : p1)) +
+                    (d2 * (d2 > 0 ? n2 : p2)) -
+                    offset);
+            if (minX < maxWindowX && maxX > minWindowX &&
+                minY < maxWindowY && maxY > minWindowY &&
+                minZ < maxWindowZ)
+            {
+                maxZ = ((d0 * (d0 > 0 ? p0 : n0)) +
+                        (d1 * (d1 > 0 ? p1 : n1)) +
+                        (d2 * (d2 > 0 ? p2 : n2)) -
+                        offset);
+
+                if (minX < minReceiverX)
+                {
+                    minReceiverX = minX;
+                }
+                if (maxReceiverX < maxX)
+                {
+                    maxReceiverX = maxX;
+                }
+                if (minY < minReceiverY)
+                {
+                    minReceiverY = minY;
+                }
+                if (maxReceiverY < maxY)
+                {
+                    maxReceiverY = maxY;
+                }
+                if (maxReceiverDistance < maxZ)
+                {
+                    maxReceiverDistance = maxZ;
+                }
+                numReceivers += 1;
+            }
+        }
+
+        if (0 === numReceivers)
+        {
+            // Nothing was visible yet, do not cull any occluder
+            split.minReceiverX = minWindowX;
+            split.maxReceiverX = maxWindowX;
+            split.minReceiverY = minWindowY;
+            split.maxReceiverY = maxWindowY;
+            split.maxReceiverDistance = maxWindowZ;
+        }
+        else
+        {
+            split.minReceiverX = Math.max(minReceiverX, minWindowX);
+            split.maxReceiverX = Math.min(maxReceiverX, maxWindowX);
+            split.minReceiverY = Math.max(minReceiverY, minWindowY);
+            split.maxReceiverY = Math.min(maxReceiverY, maxWindowY);
+            split.maxReceiverDistance = Math.min(maxReceiverDistance, maxWindowZ);
+        }
+    }
+
+    private _updateOccludersLimits(split: CascadedShadowSplit,
+                                   viewMatrix: any,
+                                   occluders: CascadedShadowOccluder[],
+                                   occludersExtents: Float32Array[],
+                                   numOccluders: number): number
+    {
+        var r0 = -viewMatrix[0];
+        var r1 = -viewMatrix[3];
+        var r2 = -viewMatrix[6];
+        var roffset = viewMatrix[9];
+
+        var u0 = -viewMatrix[1];
+        var u1 = -viewMatrix[4];
+        var u2 = -viewMatrix[7];
+        var uoffset = viewMatrix[10];
+
+        var d0 = -viewMatrix[2];
+        var d1 = -viewMatrix[5];
+        var d2 = -viewMatrix[8];
+        var offset = viewMatrix[11];
+
+        var maxWindowX = split.maxReceiverX;
+        var minWindowX = split.minReceiverX;
+        var maxWindowY = split.maxReceiverY;
+        var minWindowY = split.minReceiverY;
+        var maxWindowZ = split.maxReceiverDistance;
+
         var minLightDistance = Number.MAX_VALUE;
         var maxLightDistance = -minLightDistance;
         var minLightDistanceX = minLightDistance;
@@ -2320,6 +2579,7 @@ class CascadedShadowMapping
             }
 
             // if we reach this code is because the occluder is out of bounds
+            // or cannot shadow any receiver
             numOccluders -= 1;
             if (n < numOccluders)
             {
@@ -2356,14 +2616,25 @@ class CascadedShadowMapping
         return numOccluders;
     }
 
-    // Filter out occluders fully included on previous splits
+    // Filter out occluders fully included on previous splits, only possible
+    // when the previous splits were drawn on the same frame
     private _filterRedundantOccuders(occluders: CascadedShadowOccluder[],
                                      occludersExtents: Float32Array[],
                                      occludersToDraw: DrawParameters[],
                                      frustumPlanes: any[],
                                      frameIndex: number,
-                                     numOccluders: number): number
+                                     numOccluders: number,
+                                     splitsInStep: boolean): number
     {
+        if (!splitsInStep)
+        {
+            for (var m = 0; m < numOccluders; m += 1)
+            {
+                occludersToDraw[m] = occluders[m].drawParameters;
+            }
+            return numOccluders;
+        }
+
         var numPlanes = frustumPlanes.length;
         var numToDraw = 0;
         for (var n = 0; n < numOccluders; n += 1)
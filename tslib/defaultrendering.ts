@@ -185,6 +185,7 @@ class DefaultRendering
         /* tslint:disable:no-string-literal */
         this.globalTechniqueParameters['time'] = currentTime;
         /* tslint:enable:no-string-literal */
+        this.globalTechniqueParameters.version += 1;
         this.camera = camera;
         this.scene = scene;
     }
@@ -258,16 +259,19 @@ class DefaultRendering
     setGlobalLightColor(color)
     {
         this.globalTechniqueParameters['lightColor'] = color;
+        this.globalTechniqueParameters.version += 1;
     }
 
     setAmbientColor(color)
     {
         this.globalTechniqueParameters['ambientColor'] = color;
+        this.globalTechniqueParameters.version += 1;
     }
 
     setDefaultTexture(tex)
     {
         this.globalTechniqueParameters['diffuse'] = tex;
+        this.globalTechniqueParameters.version += 1;
     }
     /* tslint:enable:no-string-literal */
 
@@ -413,6 +417,8 @@ class DefaultRendering
             ambientColor : md.v3Build(0.2, 0.2, 0.3),
             time : 0.0
         });
+        // Versioned, update and the setters increment it after writing the values
+        dr.globalTechniqueParameters.version = 1;
         dr.globalTechniqueParametersArray = [dr.globalTechniqueParameters];
 
         dr.passes = [[], [], []];
@@ -24,7 +24,8 @@ interface DeferredEffectTypeData extends EffectPrepareObject
 //
 /*global ShadowMapping: false, VMath: false, Effect: false,
          renderingCommonCreateRendererInfoFn: false,
-         renderingCommonSortKeyFn: false*/
+         renderingCommonSortKeyFn: false,
+         renderingCommonUpdateTextureUsageFn: false, LightGrid: false*/
 
 class DeferredRendering
 {
@@ -34,6 +35,11 @@ class DeferredRendering
 
     minPixelCount = 256;
 
+    // Tiled lighting limits
+    static tileSize: number = 32;
+    static maxTiles: number = 4096;
+    static maxTiledLights: number = 256;
+
     md                                      : MathDevice;
     black                                   : any; // v4
 
@@ -88,6 +94,15 @@ class DeferredRendering
     spotLightShadowTechnique                : Technique;
     pointLightSpecularShadowTechnique       : Technique;
     pointLightSpecularShadowOpaqueTechnique : Technique;
+    tiledLightsTechnique                    : Technique;
+
+    tiledLighting                           : boolean;
+    textureStreaming                        : boolean;
+    tiledLights                             : LightInstance[];
+    tiledTechniqueParameters                : TechniqueParameters;
+    tileGrid                                : any; // v4
+    tileViewRay                             : any; // v4
+    lightGrid                               : LightGrid;
 
     shadowMaps                              : ShadowMapping;
 
@@ -140,6 +155,10 @@ class DeferredRendering
             this.pointLightSpecularOpaqueTechnique = shader.getTechnique("point_light_specular_opaque");
             this.fogLightTechnique = shader.getTechnique("fog_light");
             this.mixTechnique = shader.getTechnique("mix");
+            if (this.tiledLighting)
+            {
+                this.tiledLightsTechnique = shader.getTechnique("tiled_lights");
+            }
             if (this.shadowMaps)
             {
                 this.spotLightShadowTechnique = shader.getTechnique("spot_light_shadow");
@@ -311,6 +330,11 @@ class DeferredRendering
 
         this.sortRenderablesAndLights(camera, scene);
 
+        if (this.textureStreaming)
+        {
+            renderingCommonUpdateTextureUsageFn(scene.getCurrentVisibleRenderables(), camera, gd.height);
+        }
+
         var viewMatrix = camera.viewMatrix;
         var viewProjectionMatrix = camera.viewProjectionMatrix;
 
@@ -331,6 +355,7 @@ class DeferredRendering
                        -viewMatrix[8]  * maxDepthReciprocal,
                        -viewMatrix[11] * maxDepthReciprocal,
                        globalTechniqueParameters['viewDepth']);
+        globalTechniqueParameters.version += 1;
 
         this.globalCameraMatrix = camera.matrix;
 
@@ -404,10 +429,20 @@ class DeferredRendering
             }
         }
 
+        var tiledLights = this.tiledLights;
+        var numTiled = 0;
+
         var pointInstances = this.pointLights;
         var numPointInstances = pointInstances.length;
         if (numPointInstances)
         {
+            var tiledLighting = this.tiledLighting;
+            var maxTiledLights = DeferredRendering.maxTiledLights;
+            if (tiledLighting)
+            {
+                scene.calculateLightsScreenExtents(camera);
+            }
+
             l = 0;
             do
             {
@@ -418,6 +453,29 @@ class DeferredRendering
 
                 if (this.lightFindVisibleRenderables(lightInstance, scene))
                 {
+                    // Unshadowed point lights are shaded by the tiled pass
+                    // instead of drawing their volumes
+                    if (tiledLighting &&
+                        !light.shadows &&
+                        !light.ambient &&
+                        lightInstance.screenExtents &&
+                        numTiled < maxTiledLights)
+                    {
+                        tiledLights[numTiled] = lightInstance;
+                        numTiled += 1;
+
+                        numPointInstances -= 1;
+                        if (l < numPointInstances)
+                        {
+                            pointInstances[l] = pointInstances[numPointInstances];
+                            continue;
+                        }
+                        else
+                        {
+                            break;
+                        }
+                    }
+
                     matrix = node.world;
                     tp = lightInstance.techniqueParameters;
                     if (!tp)
@@ -471,6 +529,12 @@ class DeferredRendering
             }
         }
 
+        tiledLights.length = numTiled;
+        if (numTiled)
+        {
+            this.updateTiles(camera);
+        }
+
         var spotInstances = this.spotLights;
         var numSpotInstances = spotInstances.length;
         if (numSpotInstances)
@@ -605,6 +669,55 @@ class DeferredRendering
         }
     }
 
+    // Bins the tiled lights into the screen tiles of the light grid covered by
+    // their screen extents
+    updateTiles(camera)
+    {
+        var tiledLights = this.tiledLights;
+        var numLights = tiledLights.length;
+
+        var tileGrid = this.tileGrid;
+        var numX = tileGrid[0];
+        var numY = tileGrid[1];
+        var scaleX = (tileGrid[2] * 0.5);
+        var scaleY = (tileGrid[3] * 0.5);
+        var floor = Math.floor;
+
+        var viewMatrix = camera.viewMatrix;
+        var lightGrid = this.lightGrid;
+        lightGrid.begin(numX, numY, 1);
+
+        var l, lightInstance, screenExtents;
+        for (l = 0; l < numLights; l += 1)
+        {
+            lightInstance = tiledLights[l];
+            lightGrid.addLight(lightInstance, viewMatrix, 1.0);
+
+            // Tiles covered by the screen extents, in clip space
+            screenExtents = lightInstance.screenExtents;
+            lightGrid.setLightCells(l,
+                                    floor((screenExtents[0] + 1.0) * scaleX),
+                                    floor((screenExtents[2] + 1.0) * scaleX),
+                                    floor((screenExtents[1] + 1.0) * scaleY),
+                                    floor((screenExtents[3] + 1.0) * scaleY),
+                                    0, 0);
+        }
+
+        lightGrid.end();
+
+        // View space ray through each pixel, scaled by its depth in the shader
+        var p = camera.projectionMatrix;
+        var tileViewRay = this.tileViewRay;
+        tileViewRay[0] = (-1.0 / p[0]);
+        tileViewRay[1] = (-1.0 / p[5]);
+        tileViewRay[2] = (-p[8] / p[0]);
+        tileViewRay[3] = (-p[9] / p[5]);
+
+        /* tslint:disable:no-string-literal */
+        this.tiledTechniqueParameters['tileViewRay'] = tileViewRay;
+        /* tslint:enable:no-string-literal */
+    }
+
     lightFindVisibleRenderables(lightInstance, scene) : boolean
     {
         var origin, overlappingRenderables, numOverlappingRenderables;
@@ -895,6 +1008,11 @@ class DeferredRendering
                     depthBuffer: this.depthBuffer
                 });
 
+            if (this.tiledLighting)
+            {
+                this.updateTileGrid(deviceWidth, deviceHeight);
+            }
+
             if (this.baseRenderTarget &&
                 this.lightingRenderTarget &&
                 this.mixRenderTarget)
@@ -911,6 +1029,34 @@ class DeferredRendering
         return false;
     }
 
+    // Tiles of tileSize pixels, larger if needed to fit maxTiles
+    updateTileGrid(width, height)
+    {
+        var tileSize = DeferredRendering.tileSize;
+        var maxTiles = DeferredRendering.maxTiles;
+        var numX, numY;
+        for (;;)
+        {
+            numX = Math.ceil(width / tileSize);
+            numY = Math.ceil(height / tileSize);
+            if ((numX * numY) <= maxTiles)
+            {
+                break;
+            }
+            tileSize *= 2;
+        }
+
+        var tileGrid = this.tileGrid;
+        tileGrid[0] = numX;
+        tileGrid[1] = numY;
+        tileGrid[2] = (width / tileSize);
+        tileGrid[3] = (height / tileSize);
+
+        /* tslint:disable:no-string-literal */
+        this.tiledTechniqueParameters['tileGrid'] = tileGrid;
+        /* tslint:enable:no-string-literal */
+    }
+
     pixelCountCompare(nodeA, nodeB)
     {
         return (nodeB.pixelCount - nodeA.pixelCount);
@@ -1049,8 +1195,6 @@ class DeferredRendering
             var minExtentsHigh = (Math.max((sceneExtents[3] - sceneExtents[0]),
                                            (sceneExtents[4] - sceneExtents[1]),
                                            (sceneExtents[5] - sceneExtents[2])) / 6);
-            shadowMaps.lowIndex = 0;
-            shadowMaps.highIndex = 0;
 
             if (numDirectionalInstances)
             {
@@ -1241,6 +1385,20 @@ class DeferredRendering
                 gd.clear(this.black);
             }
 
+            // Tiled lights, all of them in a single fullscreen pass
+            if (this.tiledLights.length)
+            {
+                gd.setStream(quadVertexBuffer, quadSemantics);
+
+                gd.setTechnique(this.tiledLightsTechnique);
+
+                gd.setTechniqueParameters(sharedTechniqueParameters, this.tiledTechniqueParameters);
+
+                gd.draw(quadPrimitive, 4);
+
+                firstLight = false;
+            }
+
             // Local lights
             var technique, currentTechnique;
 
@@ -1575,17 +1733,7 @@ class DeferredRendering
         }
         else if (this.sm)
         {
-            var sm = (this.sm - 1);
-            var shadowMapsHigh = shadowMaps.shadowMapsHigh;
-            var shadowMapsLow = shadowMaps.shadowMapsLow;
-            if (sm < shadowMapsHigh.length)
-            {
-                finalTexture = shadowMapsHigh[sm].texture;
-            }
-            else
-            {
-                finalTexture = shadowMapsLow[sm - shadowMapsHigh.length].texture;
-            }
+            finalTexture = shadowMaps.atlasTexture;
         }
         postFXsetupFn(gd, finalTexture);
 
@@ -1621,6 +1769,7 @@ class DeferredRendering
         delete this.spotLightShadowTechnique;
         delete this.pointLightSpecularShadowTechnique;
         delete this.pointLightSpecularShadowOpaqueTechnique;
+        delete this.tiledLightsTechnique;
         delete this.sharedTechniqueParameters;
         delete this.lightPrimitive;
         delete this.lightSemantics;
@@ -1659,6 +1808,16 @@ class DeferredRendering
         delete this.pointLights;
         delete this.fogLights;
         delete this.sceneExtents;
+
+        delete this.tiledLights;
+        delete this.tiledTechniqueParameters;
+        if (this.lightGrid)
+        {
+            this.lightGrid.destroy();
+            delete this.lightGrid;
+        }
+        delete this.tileGrid;
+        delete this.tileViewRay;
         delete this.sceneGlobalLights;
 
         var shadowMaps = this.shadowMaps;
@@ -1702,6 +1861,8 @@ class DeferredRendering
             viewDepth: md.v4BuildZero(),
             time: 0,
         });
+        // Versioned, update increments it after writing the values
+        dr.globalTechniqueParameters.version = 1;
         dr.sharedTechniqueParameters = gd.createTechniqueParameters({
             normalTexture: null,
             depthTexture: null,
@@ -1785,6 +1946,27 @@ class DeferredRendering
         dr.pointLights = [];
         dr.fogLights = [];
 
+        dr.textureStreaming = !!(settings && settings.textureStreaming);
+
+        dr.tiledLighting = false;
+        dr.tiledLights = [];
+        if (settings && settings.tiledLighting)
+        {
+            dr.lightGrid = LightGrid.create(gd, md, DeferredRendering.maxTiles, DeferredRendering.maxTiledLights);
+            if (dr.lightGrid)
+            {
+                dr.tiledLighting = true;
+                dr.tileGrid = md.v4Build(1, 1, 1, 1);
+                dr.tileViewRay = md.v4BuildZero();
+                dr.tiledTechniqueParameters = gd.createTechniqueParameters({
+                    lightgrid: dr.lightGrid.texture,
+                    lightGridTextureSize: dr.lightGrid.textureSize,
+                    tileGrid: dr.tileGrid,
+                    tileViewRay: dr.tileViewRay
+                });
+            }
+        }
+
 
         var onShaderLoaded = function onShaderLoadedFn(shader)
         {
@@ -3,6 +3,7 @@
 /*global
 Draw2D: false
 Float32Array: false
+VertexBufferRing: false
 */
 
 //
@@ -21,6 +22,7 @@ class Draw2DGroup
     numSets          : number;
     vertexBufferData : any; // new Draw2D.floatArray(1024);
     numVertices      : number;
+    vertexIndex      : number; // first vertex on the GPU vertex buffer
 
     static create() : Draw2DGroup
     {
@@ -34,6 +36,7 @@ class Draw2DGroup
         // vertex buffer for group.
         group.vertexBufferData = new Draw2D.floatArray(1024);
         group.numVertices = 0;
+        group.vertexIndex = 0;
 
         return group;
     }
@@ -520,6 +523,40 @@ class Draw2DSprite
         s._invalidate();
         return s;
     }
+
+    // Creates a sprite from the JSON map written by the atlaspack tool,
+    // textures must hold the atlas pages in the same order as atlas.pages.
+    // Any params given override the ones from the atlas.
+    static createFromAtlas(atlas: any, name: string, textures: Texture[],
+                           params?: Draw2DSpriteParams): Draw2DSprite
+    {
+        var entry = atlas.sprites[name];
+        if (!entry)
+        {
+            return null;
+        }
+
+        var spriteParams: Draw2DSpriteParams = {
+            texture: textures[entry.page],
+            textureRectangle: entry.textureRectangle,
+            width: entry.width,
+            height: entry.height
+        };
+
+        if (params)
+        {
+            var p;
+            for (p in params)
+            {
+                if (params.hasOwnProperty(p))
+                {
+                    spriteParams[p] = params[p];
+                }
+            }
+        }
+
+        return Draw2DSprite.create(spriteParams);
+    }
 }
 
 //
@@ -732,8 +769,8 @@ class Draw2D
     currentTextureGroup           : Draw2DGroup;
 
     techniqueParameters           : TechniqueParameters;
-    vertexBufferParameters        : VertexBufferParameters;
-    vertexBuffer                  : VertexBuffer;
+    vertexAttributes              : any[];
+    vertexRing                    : VertexBufferRing;
     indexBufferParameters         : IndexBufferParameters;
     indexBuffer                   : IndexBuffer;
     semantics                     : Semantics;
@@ -770,6 +807,10 @@ class Draw2D
 
     maxVertices                   : number;
 
+    // number of regions of vertexRing, written in turn so a region is only
+    // overwritten after the others have been used.
+    bufferFrames                  : number;
+
     // number of bytes used per-sprite on cpu vertex buffers.
     cpuStride                     : number;
 
@@ -1214,9 +1255,9 @@ class Draw2D
 
         this.graphicsDevice = null;
 
-        if (this.vertexBuffer)
+        if (this.vertexRing)
         {
-            this.vertexBuffer.destroy();
+            this.vertexRing.destroy();
         }
         if (this.indexBuffer)
         {
@@ -1265,6 +1306,9 @@ class Draw2D
             // Check the buffers are correct before we render
             this.update();
 
+            // Each begin/end pair writes its vertices to the next region
+            this.vertexRing.nextFrame();
+
             if (!this.currentRenderTarget)
             {
                 this.graphicsDevice.setScissor(this.scissorX, this.scissorY, this.scissorWidth, this.scissorHeight);
@@ -1319,10 +1363,10 @@ class Draw2D
     private _bufferSprite(group, sprite)
     {
         var vertexData = group.vertexBufferData;
-        var vertexBuffer = this.vertexBuffer;
+        var stride = this.vertexRing.stride;
 
-        var index = group.numVertices * vertexBuffer.stride;
-        var total = index + (4 * vertexBuffer.stride);
+        var index = group.numVertices * stride;
+        var total = index + (4 * stride);
         if (total >= vertexData.length)
         {
             // allocate new vertex buffer data array.
@@ -1393,7 +1437,7 @@ class Draw2D
     private bufferMultiSprite(group, buffer, count?, offset?)
     {
         var vertexData = group.vertexBufferData;
-        var vertexBuffer = this.vertexBuffer;
+        var stride = this.vertexRing.stride;
 
         var numSprites = (count === undefined) ? Math.floor(buffer.length / 16) : count;
         count = numSprites * 16;
@@ -1401,8 +1445,8 @@ class Draw2D
         offset = (offset !== undefined ? offset : 0) * 16;
 
         var i;
-        var index = (group.numVertices * vertexBuffer.stride);
-        var total = index + (numSprites * 4 * vertexBuffer.stride);
+        var index = (group.numVertices * stride);
+        var total = index + (numSprites * 4 * stride);
         if (total >= vertexData.length)
         {
             // allocate new vertex buffer data array.
@@ -1494,57 +1538,116 @@ class Draw2D
         return indexData;
     }
 
-    // upload group buffer to graphics device vertexBuffer.
-    uploadBuffer(group, count, offset)
+    // resize vertex and index buffers to fit count vertices per region.
+    resizeBuffers(count)
     {
-        var vertexBuffer = this.vertexBuffer;
-        var vertexBufferParameters = this.vertexBufferParameters;
         var graphicsDevice = this.graphicsDevice;
-        var vertexData = group.vertexBufferData;
-
-        var performanceData = this.performanceData;
+        var bufferFrames = this.bufferFrames;
 
-        // Resize buffers.
-        if (count > vertexBufferParameters.numVertices)
+        var newSize = this.bufferSizeAlgorithm(count, this.gpuStride);
+        if (newSize > this.maxVertices)
         {
-            var newSize = this.bufferSizeAlgorithm(count, this.gpuStride);
-            if (newSize > this.maxVertices)
-            {
-                newSize = this.maxVertices;
-            }
+            newSize = this.maxVertices;
+        }
 
-            vertexBufferParameters.numVertices = newSize;
-            this.vertexBuffer.destroy();
-            this.vertexBuffer = vertexBuffer = graphicsDevice.createVertexBuffer(vertexBufferParameters);
+        this.vertexRing.destroy();
+        this.vertexRing = VertexBufferRing.create(graphicsDevice, newSize, this.vertexAttributes, bufferFrames);
 
-            // 32 bytes per vertex.
-            // 2 bytes per index, 1.5 indices per vertex.
-            performanceData.gpuMemoryUsage = newSize * 35; // 32 + (1.5 * 2)
+        // 32 bytes per vertex per region.
+        // 2 bytes per index, 1.5 indices per vertex.
+        this.performanceData.gpuMemoryUsage = newSize * ((32 * bufferFrames) + 3);
 
-            newSize *= 1.5;
+        newSize *= 1.5;
 
-            // Set indices.
-            var indexBufferParameters = this.indexBufferParameters;
-            indexBufferParameters.data = this.indexData(newSize);
-            indexBufferParameters.numIndices = newSize;
-            this.indexBuffer.destroy();
-            this.indexBuffer = graphicsDevice.createIndexBuffer(indexBufferParameters);
-            indexBufferParameters.data = null;
-            graphicsDevice.setIndexBuffer(this.indexBuffer);
+        // Set indices, relative to the region start given to setStream.
+        var indexBufferParameters = this.indexBufferParameters;
+        indexBufferParameters.data = this.indexData(newSize);
+        indexBufferParameters.numIndices = newSize;
+        this.indexBuffer.destroy();
+        this.indexBuffer = graphicsDevice.createIndexBuffer(indexBufferParameters);
+        indexBufferParameters.data = null;
+        graphicsDevice.setIndexBuffer(this.indexBuffer);
+    }
+
+    // upload all groups to the vertex ring with a single transfer,
+    // returns false if they do not fit in a region.
+    uploadGroups(): boolean
+    {
+        var drawGroups = this.drawGroups;
+        var numGroups = this.numGroups;
+        var total = 0;
+        var i;
+        for (i = 0; i < numGroups; i += 1)
+        {
+            total += drawGroups[i].numVertices;
         }
 
-        performanceData.dataTransfers += 1;
+        if (total > this.maxVertices)
+        {
+            return false;
+        }
+        if (total === 0)
+        {
+            return true;
+        }
 
-        // Upload data.
-        if (offset === 0)
+        if (total > this.vertexRing.numVertices)
         {
-            vertexBuffer.setData(vertexData, 0, count);
+            this.resizeBuffers(total);
         }
-        else
+
+        var vertexRing = this.vertexRing;
+        var vertexIndex = vertexRing.allocate(total);
+        var stride = vertexRing.stride;
+        var ringData = vertexRing.data;
+        var offset = (vertexIndex * stride);
+        for (i = 0; i < numGroups; i += 1)
         {
-            var stride = vertexBuffer.stride;
-            vertexBuffer.setData(vertexData.subarray(offset * stride, (offset + count) * stride), 0, count);
+            var group = drawGroups[i];
+            var vertexData = group.vertexBufferData;
+            var numValues = (group.numVertices * stride);
+
+            group.vertexIndex = vertexIndex;
+            vertexIndex += group.numVertices;
+
+            if (vertexData.subarray)
+            {
+                ringData.set(vertexData.subarray(0, numValues), offset);
+                offset += numValues;
+            }
+            else
+            {
+                var n;
+                for (n = 0; n < numValues; n += 1)
+                {
+                    ringData[offset] = vertexData[n];
+                    offset += 1;
+                }
+            }
         }
+
+        vertexRing.flush();
+        this.performanceData.dataTransfers += 1;
+
+        return true;
+    }
+
+    // upload group buffer to the vertex ring,
+    // returns the index of the first vertex uploaded.
+    uploadBuffer(group, count, offset): number
+    {
+        if (count > this.vertexRing.numVertices)
+        {
+            this.resizeBuffers(count);
+        }
+
+        var vertexRing = this.vertexRing;
+        var vertexIndex = vertexRing.write(group.vertexBufferData, count, offset);
+        vertexRing.flush();
+
+        this.performanceData.dataTransfers += 1;
+
+        return vertexIndex;
     }
 
     ////////////////////////////////////////////////////////////////////////////
@@ -1897,6 +2000,10 @@ class Draw2D
 
         var graphicsDevice = this.graphicsDevice;
         var techniqueParameters = this.techniqueParameters;
+
+        // Upload every group at once when they fit in a region
+        var uploaded = this.uploadGroups();
+
         graphicsDevice.setIndexBuffer(this.indexBuffer);
 
         var drawGroups = this.drawGroups;
@@ -1930,8 +2037,8 @@ class Draw2D
                 }
 
                 // Upload group vertex sub-buffer to graphics device.
-                this.uploadBuffer(group, vcount, vindex);
-                graphicsDevice.setStream(this.vertexBuffer, this.semantics);
+                var vertexIndex = (uploaded ? group.vertexIndex : this.uploadBuffer(group, vcount, vindex));
+                graphicsDevice.setStream(this.vertexRing.vertexBuffer, this.semantics, vertexIndex);
 
                 // sprite uses 4 vertices, and 6 indices
                 // so for 'vcount' number of vertices, we have vcount * 1.5 indices
@@ -2406,28 +2513,35 @@ class Draw2D
             initial = 2293760;
         }
 
-        o.performanceData = {
-            gpuMemoryUsage : initial,
-            minBatchSize : 0,
-            maxBatchSize : 0,
-            avgBatchSize : 0,
-            batchCount : 0,
-            dataTransfers : 0
-        };
-
         o.maxGpuMemory = (params.maxGpuMemory ? params.maxGpuMemory : 2293760);
         if (o.maxGpuMemory < initial)
         {
             o.maxGpuMemory = initial;
         }
 
-        var initialVertices = Math.floor(initial / 140) * 4;
-        o.maxVertices = Math.floor(o.maxGpuMemory / 140) * 4;
+        // Vertices are written to one of 3 regions of the vertex ring in
+        // turn, so each sprite uses 4 * 32 bytes per region + 6 * 2 bytes of
+        // indices out of the same budget. A budget too small for a sprite in
+        // 3 regions falls back to a single region.
+        o.bufferFrames = (o.maxGpuMemory >= ((4 * 32 * 3) + 12) ? 3 : 1);
+        var spriteSize = ((4 * 32 * o.bufferFrames) + 12);
+
+        var initialVertices = Math.max(Math.floor(initial / spriteSize), 1) * 4;
+        o.maxVertices = Math.floor(o.maxGpuMemory / spriteSize) * 4;
         if (o.maxVertices > 65536)
         {
             o.maxVertices = 65536;
         }
 
+        o.performanceData = {
+            gpuMemoryUsage : (initialVertices * ((32 * o.bufferFrames) + 3)),
+            minBatchSize : 0,
+            maxBatchSize : 0,
+            avgBatchSize : 0,
+            batchCount : 0,
+            dataTransfers : 0
+        };
+
         // number of bytes used per-sprite on cpu vertex buffers.
         o.cpuStride = 64;
 
@@ -2436,12 +2550,8 @@ class Draw2D
         o.gpuStride = 4;
 
         // Index and vertex buffer setup.
-        o.vertexBufferParameters = {
-            numVertices: initialVertices,
-            attributes: [gd.VERTEXFORMAT_FLOAT2, gd.VERTEXFORMAT_FLOAT4, gd.VERTEXFORMAT_FLOAT2],
-            'transient': true
-        };
-        o.vertexBuffer = gd.createVertexBuffer(o.vertexBufferParameters);
+        o.vertexAttributes = [gd.VERTEXFORMAT_FLOAT2, gd.VERTEXFORMAT_FLOAT4, gd.VERTEXFORMAT_FLOAT2];
+        o.vertexRing = VertexBufferRing.create(gd, initialVertices, o.vertexAttributes, o.bufferFrames);
 
         o.semantics = gd.createSemantics([gd.SEMANTIC_POSITION, gd.SEMANTIC_COLOR, gd.SEMANTIC_TEXCOORD0]);
         o.indexBufferParameters = {
@@ -1,6 +1,7 @@
 // Copyright (c) 2009-2013 Turbulenz Limited
 
 /*global TurbulenzEngine: false */
+/*global VertexBufferRing: false */
 
 class DrawPrimitives
 {
@@ -15,55 +16,46 @@ class DrawPrimitives
     private technique: Technique;
     private techniqueParameters: TechniqueParameters;
 
-    private rectPositionsParameters =
-    {
-        numVertices: 4,
-        attributes: ['SHORT2'],
-        dynamic: true
-    };
+    private rectAttributes = ['SHORT2'];
     private rectSemanticsParameters = ['POSITION'];
     private rectNumVertices = 4;
     private rectPrimitive: number;
-    private rectPositions : VertexBuffer;
+    private rectPositions : VertexBufferRing;
+    private rectIndex = 0;
     private rectSemantics: Semantics;
 
-    private rectTexPositionsParameters =
-    {
-        numVertices: 4,
-        attributes: ['SHORT2', 'SHORT2'],
-        dynamic: true
-    };
+    private rectTexAttributes = ['SHORT2', 'SHORT2'];
     private rectTexSemanticsParameters = ['POSITION', 'TEXCOORD0'];
     private rectTexNumVertices = 4;
     private rectTexPrimitive: number;
-    private rectTexPositions : VertexBuffer;
+    private rectTexPositions : VertexBufferRing;
+    private rectTexIndex = 0;
     private rectTexSemantics: Semantics;
 
-    private boxPositionsParameters =
-    {
-        numVertices: 36,
-        attributes: ['FLOAT3'],
-        dynamic: true
-    };
+    private boxAttributes = ['FLOAT3'];
     private boxSemanticsParameters = ['POSITION'];
     private boxNumVertices = 36;
     private boxPrimitive: number;
-    private boxPositions : VertexBuffer;
+    private boxPositions : VertexBufferRing;
+    private boxIndex = 0;
     private boxSemantics: Semantics;
 
     initalize(gd, shaderPath)
     {
         this.device = gd;
         this.boxPrimitive = gd.PRIMITIVE_TRIANGLES;
-        this.boxPositions = gd.createVertexBuffer(this.boxPositionsParameters);
+        this.boxPositions = VertexBufferRing.create(gd, this.boxNumVertices,
+                                                    this.boxAttributes);
         this.boxSemantics = gd.createSemantics(this.boxSemanticsParameters);
 
         this.rectPrimitive = gd.PRIMITIVE_TRIANGLE_STRIP;
-        this.rectPositions = gd.createVertexBuffer(this.rectPositionsParameters);
+        this.rectPositions = VertexBufferRing.create(gd, this.rectNumVertices,
+                                                     this.rectAttributes);
         this.rectSemantics = gd.createSemantics(this.rectSemanticsParameters);
 
         this.rectTexPrimitive = gd.PRIMITIVE_TRIANGLE_STRIP;
-        this.rectTexPositions = gd.createVertexBuffer(this.rectTexPositionsParameters);
+        this.rectTexPositions = VertexBufferRing.create(gd, this.rectTexNumVertices,
+                                                        this.rectTexAttributes);
         this.rectTexSemantics = gd.createSemantics(this.rectTexSemanticsParameters);
 
         debug.assert((this.boxPositions && this.rectPositions &&
@@ -117,8 +109,8 @@ class DrawPrimitives
     update2DTex(posa, posb)
     {
         var positions = this.rectTexPositions;
-        var writer = positions.map();
-        if (writer)
+        var index = positions.allocate(this.rectTexNumVertices);
+        if (index !== -1)
         {
             var v = [
                 [ posa[0], posa[1] ],
@@ -134,18 +126,25 @@ class DrawPrimitives
                 [1, 0]
             ];
 
-            var index = [
+            var order = [
                 0, 1, 3, 2
             ];
 
+            var data = positions.data;
+            var dst = (index * positions.stride);
             var i, j;
             for (i = 0; i < 4; i += 1)
             {
-                j = index[i];
-                writer(v[j], t[j]);
+                j = order[i];
+                data[dst] = v[j][0];
+                data[dst + 1] = v[j][1];
+                data[dst + 2] = t[j][0];
+                data[dst + 3] = t[j][1];
+                dst += 4;
             }
 
-            positions.unmap(writer);
+            positions.flush();
+            this.rectTexIndex = index;
             this.isTextured = true;
         }
     }
@@ -153,8 +152,8 @@ class DrawPrimitives
     update2D(posa, posb)
     {
         var positions = this.rectPositions;
-        var writer = positions.map();
-        if (writer)
+        var index = positions.allocate(this.rectNumVertices);
+        if (index !== -1)
         {
             var v = [
                 [ posa[0], posa[1] ],
@@ -163,25 +162,31 @@ class DrawPrimitives
                 [ posb[0], posa[1] ]
             ];
 
-            var index = [
+            var order = [
                 0, 1, 3, 2
             ];
 
-            var i;
+            var data = positions.data;
+            var dst = (index * positions.stride);
+            var i, j;
             for (i = 0; i < 4; i += 1)
             {
-                writer(v[index[i]]);
+                j = order[i];
+                data[dst] = v[j][0];
+                data[dst + 1] = v[j][1];
+                dst += 2;
             }
 
-            positions.unmap(writer);
+            positions.flush();
+            this.rectIndex = index;
         }
     }
 
     update(posa, posb)
     {
         var positions = this.boxPositions;
-        var writer = positions.map();
-        if (writer)
+        var index = positions.allocate(this.boxNumVertices);
+        if (index !== -1)
         {
             var v = [
                 [ posa[0], posa[1], posa[2] ],
@@ -194,7 +199,7 @@ class DrawPrimitives
                 [ posb[0], posb[1], posb[2] ]
             ];
 
-            var index = [
+            var order = [
                 0, 2, 1,    1, 2, 3,
                 0, 1, 4,    1, 5, 4,
                 1, 3, 5,    3, 7, 5,
@@ -203,13 +208,20 @@ class DrawPrimitives
                 4, 5, 6,    5, 7, 6
             ];
 
-            var i;
+            var data = positions.data;
+            var dst = (index * positions.stride);
+            var i, j;
             for (i = 0; i < 3 * 12; i += 1)
             {
-                writer(v[index[i]]);
+                j = order[i];
+                data[dst] = v[j][0];
+                data[dst + 1] = v[j][1];
+                data[dst + 2] = v[j][2];
+                dst += 3;
             }
 
-            positions.unmap(writer);
+            positions.flush();
+            this.boxIndex = index;
         }
     }
 
@@ -220,20 +232,22 @@ class DrawPrimitives
         var isTechnique2D = this.isTechnique2D;
         var isTextured = this.isTextured;
 
-        var vertexBuffer, semantics, primitive, numVertices;
+        var positions, vertexIndex, semantics, primitive, numVertices;
 
         if (isTechnique2D)
         {
             if (isTextured)
             {
-                vertexBuffer = this.rectTexPositions;
+                positions = this.rectTexPositions;
+                vertexIndex = this.rectTexIndex;
                 semantics = this.rectTexSemantics;
                 primitive = this.rectTexPrimitive;
                 numVertices = this.rectTexNumVertices;
             }
             else
             {
-                vertexBuffer = this.rectPositions;
+                positions = this.rectPositions;
+                vertexIndex = this.rectIndex;
                 semantics = this.rectSemantics;
                 primitive = this.rectPrimitive;
                 numVertices = this.rectNumVertices;
@@ -241,7 +255,8 @@ class DrawPrimitives
         }
         else
         {
-            vertexBuffer = this.boxPositions;
+            positions = this.boxPositions;
+            vertexIndex = this.boxIndex;
             semantics = this.boxSemantics;
             primitive = this.boxPrimitive;
             numVertices = this.boxNumVertices;
@@ -256,7 +271,7 @@ class DrawPrimitives
 
             gd.setTechnique(technique);
             gd.setTechniqueParameters(techniqueParameters);
-            gd.setStream(vertexBuffer, semantics);
+            gd.setStream(positions.vertexBuffer, semantics, vertexIndex);
             gd.draw(primitive, numVertices);
         }
     }
@@ -39,6 +39,9 @@ class ForwardRendering
 
     static nextNodeID: number = 0;
 
+    // Clustered lighting limits
+    static maxClusteredLights: number = 256;
+
     spotLights: LightInstance[];
     pointLights: LightInstance[];
     localDirectionalLights: LightInstance[];
@@ -117,6 +120,14 @@ class ForwardRendering
 
     sharedUserData: any[];
 
+    clusteredLighting: boolean;
+    textureStreaming: boolean;
+    clusteredLights: LightInstance[];
+    clusteredQueue: DrawParameters[];
+    clusterGrid: any; // v4
+    clusterDepth: any; // v4
+    lightGrid: LightGrid;
+
     //minPixelCount: 16,
     //minPixelCountShadows: 256,
 
@@ -222,6 +233,9 @@ class ForwardRendering
             passesSize[passIndex] = 0;
         }
 
+        var clusteredQueue = this.clusteredQueue;
+        var numClusteredQueue = 0;
+
         var visibleRenderables = scene.getCurrentVisibleRenderables();
         this.visibleRenderables = visibleRenderables;
         var numVisibleRenderables = visibleRenderables.length;
@@ -314,6 +328,21 @@ class ForwardRendering
                     }
                 }
 
+                drawParametersArray = renderable.clusteredDrawParameters;
+                if (drawParametersArray)
+                {
+                    numDrawParameters = drawParametersArray.length;
+                    for (drawParametersIndex = 0; drawParametersIndex < numDrawParameters; drawParametersIndex += 1)
+                    {
+                        drawParameters = drawParametersArray[drawParametersIndex];
+                        /* tslint:disable:no-bitwise */
+                        drawParameters.sortKey = ((drawParameters.sortKey | 0) + sortDistance);
+                        /* tslint:enable:no-bitwise */
+                        clusteredQueue[numClusteredQueue] = drawParameters;
+                        numClusteredQueue += 1;
+                    }
+                }
+
                 n += 1;
             }
             while (n < numVisibleRenderables);
@@ -323,6 +352,8 @@ class ForwardRendering
         {
             passes[passIndex].length = passesSize[passIndex];
         }
+
+        clusteredQueue.length = numClusteredQueue;
     }
 
     prepareLights(gd, scene)
@@ -332,14 +363,20 @@ class ForwardRendering
         var localDirectionalLights = this.localDirectionalLights;
         var globalDirectionalLights = this.globalDirectionalLights;
 
+        var clusteredLights = this.clusteredLights;
+        var clusteredLighting = this.clusteredLighting;
+        var maxClusteredLights = ForwardRendering.maxClusteredLights;
+        var shadowMaps = this.shadowMaps;
+
         var numPoint = 0;
         var numSpot = 0;
         var numLocalDirectional = 0;
         var numGlobalDirectional = 0;
+        var numClustered = 0;
 
         var visibleLights = scene.getCurrentVisibleLights();
         var numVisibleLights = visibleLights.length;
-        var lightInstance, light, l;
+        var lightInstance, light, l, clustered;
         if (numVisibleLights)
         {
             //var widthToPixel = (0.5 * gd.width);
@@ -386,9 +423,27 @@ class ForwardRendering
                     {
                         lightInstance.shadows = false;
 
-                        if (this.lightFindVisibleRenderables(gd, lightInstance, scene))
+                        // Unshadowed point lights are evaluated per cluster for the
+                        // renderables that support it
+                        clustered = (clusteredLighting &&
+                                     light.point &&
+                                     !(shadowMaps && light.shadows) &&
+                                     numClustered < maxClusteredLights);
+
+                        if (this.lightFindVisibleRenderables(gd, lightInstance, scene, clustered))
                         {
-                            if (light.spot)
+                            if (clustered)
+                            {
+                                clusteredLights[numClustered] = lightInstance;
+                                numClustered += 1;
+
+                                if (lightInstance.numVisibleDrawParameters)
+                                {
+                                    pointLights[numPoint] = lightInstance;
+                                    numPoint += 1;
+                                }
+                            }
+                            else if (light.spot)
                             {
                                 spotLights[numSpot] = lightInstance;
                                 numSpot += 1;
@@ -457,6 +512,7 @@ class ForwardRendering
         localDirectionalLights.length = numLocalDirectional;
         pointLights.length = numPoint;
         spotLights.length = numSpot;
+        clusteredLights.length = numClustered;
     }
 
     addToDiffuseQueue(gd, renderableDrawParameters,
@@ -475,7 +531,7 @@ class ForwardRendering
     }
 
     //TODO name.
-    lightFindVisibleRenderables(gd, lightInstance, scene): boolean
+    lightFindVisibleRenderables(gd, lightInstance, scene, clustered?: boolean): boolean
     {
         var origin, overlappingRenderables, numOverlappingRenderables;
         var n, meta, extents, lightFrameVisible;
@@ -605,6 +661,7 @@ class ForwardRendering
         var renderableID;
         var drawParameterIndex, numDrawParameters, drawParametersArray, drawParameters;
         var numVisibleDrawParameters = 0;
+        var numClusteredRenderables = 0;
 
         var usingShadows = false;
         if (shadowMaps &&
@@ -620,12 +677,20 @@ class ForwardRendering
             lightInstanceTechniqueParameters = gd.createTechniqueParameters(light.techniqueParameters);
             lightInstanceTechniqueParameters.lightViewInverseTransposeFalloff =
                                                gd.createTechniqueParameterBuffer({ numFloats: 16 });
+            lightInstanceTechniqueParameters.lightViewInverseTransposeFalloff.version = 1;
             lightInstance.techniqueParameters = lightInstanceTechniqueParameters;
         }
 
         for (n = 0; n < numLightVisibleRenderables; n += 1)
         {
             renderable = lightVisibleRenderables[n];
+            if (clustered && renderable.clusteredDrawParameters)
+            {
+                // Lit by the clustered pass
+                numClusteredRenderables += 1;
+                continue;
+            }
+
             renderableID = (renderable.rendererInfo.id || 0);
 
             if (usingShadows)
@@ -651,7 +716,7 @@ class ForwardRendering
 
         lightInstance.numVisibleDrawParameters = numVisibleDrawParameters;
 
-        return (0 < numVisibleDrawParameters);
+        return (0 < numVisibleDrawParameters || 0 < numClusteredRenderables);
     }
 
     directionalLightsUpdateVisibleRenderables(gd /*, scene */) : boolean
@@ -726,6 +791,11 @@ class ForwardRendering
 
         this.prepareRenderables(camera, scene);
 
+        if (this.textureStreaming)
+        {
+            renderingCommonUpdateTextureUsageFn(this.visibleRenderables, camera, gd.height);
+        }
+
         this.prepareLights(gd, scene);
 
         var md = this.md;
@@ -1009,6 +1079,139 @@ class ForwardRendering
             }
             while (l < numSpotInstances);
         }
+
+        if (this.clusteredLights && this.clusteredLights.length)
+        {
+            this.updateClusters(camera, lightingScale);
+        }
+
+        this.globalTechniqueParameters.version += 1;
+    }
+
+    // Bins the clustered lights into the view frustum cells of the light grid
+    updateClusters(camera, lightingScale)
+    {
+        var clusteredLights = this.clusteredLights;
+        var numLights = clusteredLights.length;
+
+        var clusterGrid = this.clusterGrid;
+        var numX = clusterGrid[0];
+        var numY = clusterGrid[1];
+        var numZ = clusterGrid[2];
+
+        var near = camera.nearPlane;
+        var far = camera.farPlane;
+        var log = Math.log;
+        var floor = Math.floor;
+        var sliceScale = (numZ / log(far / near));
+
+        var clusterDepth = this.clusterDepth;
+        clusterDepth[0] = near;
+        clusterDepth[1] = sliceScale;
+
+        var viewMatrix = camera.viewMatrix;
+        var p = camera.projectionMatrix;
+        var p0 = p[0], p1 = p[1], p3 = p[3], p4 = p[4], p5 = p[5], p7 = p[7];
+        var p8 = p[8], p9 = p[9], p11 = p[11], p12 = p[12], p13 = p[13], p15 = p[15];
+
+        var lightGrid = this.lightGrid;
+        lightGrid.begin(numX, numY, numZ);
+
+        var l, i, j, k, worldView, halfExtents;
+        var h0, h1, h2, radius, cx, cy, depth, depthMin, depthMax;
+        var minX, maxX, minY, maxY, vx, vy, vz, w, ndcX, ndcY;
+        for (l = 0; l < numLights; l += 1)
+        {
+            var lightInstance = clusteredLights[l];
+            worldView = lightGrid.addLight(lightInstance, viewMatrix, lightingScale);
+
+            // Bounding sphere of the light box in view space
+            halfExtents = lightInstance.light.halfExtents;
+            h0 = halfExtents[0];
+            h1 = halfExtents[1];
+            h2 = halfExtents[2];
+            radius = Math.sqrt((h0 * h0 * ((worldView[0] * worldView[0]) +
+                                           (worldView[1] * worldView[1]) +
+                                           (worldView[2] * worldView[2]))) +
+                               (h1 * h1 * ((worldView[3] * worldView[3]) +
+                                           (worldView[4] * worldView[4]) +
+                                           (worldView[5] * worldView[5]))) +
+                               (h2 * h2 * ((worldView[6] * worldView[6]) +
+                                           (worldView[7] * worldView[7]) +
+                                           (worldView[8] * worldView[8]))));
+            cx = worldView[9];
+            cy = worldView[10];
+            depth = -worldView[11];
+
+            depthMin = (depth - radius);
+            depthMax = (depth + radius);
+            if (depthMax < near || depthMin > far)
+            {
+                continue;
+            }
+            if (depthMin < near)
+            {
+                depthMin = near;
+            }
+            if (depthMax > far)
+            {
+                depthMax = far;
+            }
+
+            // Project the corners of the clipped bounding box
+            minX = minY = Number.MAX_VALUE;
+            maxX = maxY = -Number.MAX_VALUE;
+            for (k = 0; k < 2; k += 1)
+            {
+                vz = (k ? -depthMax : -depthMin);
+                for (j = 0; j < 2; j += 1)
+                {
+                    vy = (j ? (cy + radius) : (cy - radius));
+                    for (i = 0; i < 2; i += 1)
+                    {
+                        vx = (i ? (cx + radius) : (cx - radius));
+                        w = ((vx * p3) + (vy * p7) + (vz * p11) + p15);
+                        ndcX = (((vx * p0) + (vy * p4) + (vz * p8) + p12) / w);
+                        ndcY = (((vx * p1) + (vy * p5) + (vz * p9) + p13) / w);
+                        if (minX > ndcX)
+                        {
+                            minX = ndcX;
+                        }
+                        if (maxX < ndcX)
+                        {
+                            maxX = ndcX;
+                        }
+                        if (minY > ndcY)
+                        {
+                            minY = ndcY;
+                        }
+                        if (maxY < ndcY)
+                        {
+                            maxY = ndcY;
+                        }
+                    }
+                }
+            }
+
+            if (maxX < -1 || minX > 1 || maxY < -1 || minY > 1)
+            {
+                continue;
+            }
+
+            lightGrid.setLightCells(l,
+                                    floor(((minX * 0.5) + 0.5) * numX),
+                                    floor(((maxX * 0.5) + 0.5) * numX),
+                                    floor(((minY * 0.5) + 0.5) * numY),
+                                    floor(((maxY * 0.5) + 0.5) * numY),
+                                    floor(log(depthMin / near) * sliceScale),
+                                    floor(log(depthMax / near) * sliceScale));
+        }
+
+        lightGrid.end();
+
+        /* tslint:disable:no-string-literal */
+        this.globalTechniqueParameters['clusterDepth'] = clusterDepth;
+        /* tslint:enable:no-string-literal */
     }
 
     forceRenderInfoUpdate(scene)
@@ -1157,8 +1360,6 @@ class ForwardRendering
                                            (sceneExtents[4] - sceneExtents[1]),
                                            (sceneExtents[5] - sceneExtents[2])) / 6);
 
-            shadowMaps.lowIndex = 0;
-            shadowMaps.highIndex = 0;
             this.drawShadowMaps(gd, globalTechniqueParameters, this.pointLights, shadowMaps, minExtentsHigh);
             this.drawShadowMaps(gd, globalTechniqueParameters, this.spotLights, shadowMaps, minExtentsHigh);
             this.drawShadowMaps(gd, globalTechniqueParameters, this.localDirectionalLights, shadowMaps, minExtentsHigh);
@@ -1230,6 +1431,14 @@ class ForwardRendering
             gd.drawArray(diffuseQueue, globalTechniqueParametersArray, -1);
         }
 
+        // clustered diffuse pass, all the clustered lights at once
+        var clusteredQueue = this.clusteredQueue;
+        if (0 < this.clusteredLights.length &&
+            0 < clusteredQueue.length)
+        {
+            gd.drawArray(clusteredQueue, globalTechniqueParametersArray, -1);
+        }
+
         // decals
         var pass = this.passes[this.passIndex.decal];
         if (0 < pass.length)
@@ -1295,6 +1504,16 @@ class ForwardRendering
         delete this.globalCameraMatrix;
 
         delete this.diffuseQueue;
+        delete this.clusteredQueue;
+        delete this.clusteredLights;
+
+        if (this.lightGrid)
+        {
+            this.lightGrid.destroy();
+            delete this.lightGrid;
+        }
+        delete this.clusterGrid;
+        delete this.clusterDepth;
 
         delete this.spotLights;
         delete this.pointLights;
@@ -1377,9 +1596,11 @@ class ForwardRendering
 
         fr.md = md;
 
+        // Versioned, update increments it after writing the values
         fr.globalTechniqueParameters = gd.createTechniqueParameters({
             time : 0.0
         });
+        fr.globalTechniqueParameters.version = 1;
 
         fr.ambientTechniqueParameters = gd.createTechniqueParameters({
             ambientColor: md.v3BuildZero()
@@ -1418,9 +1639,35 @@ class ForwardRendering
         fr.lightViewInverseTransposeFalloff = gd.createTechniqueParameterBuffer({
             numFloats: 16
         });
+        fr.lightViewInverseTransposeFalloff.version = 1;
         fr.lightViewInverseTranspose = md.m43BuildIdentity();
         fr.lightFalloff = md.v4BuildZero();
 
+        fr.textureStreaming = !!(settings && settings.textureStreaming);
+
+        fr.clusteredLighting = false;
+        fr.clusteredLights = [];
+        fr.clusteredQueue = [];
+        if (settings && settings.clusteredLighting)
+        {
+            // 16x8 tiles and 24 depth slices
+            fr.lightGrid = LightGrid.create(gd, md, (16 * 8 * 24), ForwardRendering.maxClusteredLights);
+            if (fr.lightGrid)
+            {
+                fr.clusteredLighting = true;
+                fr.clusterGrid = md.v4Build(16, 8, 24, 0);
+                fr.clusterDepth = md.v4Build(1, 1, 0, 0);
+
+                /* tslint:disable:no-string-literal */
+                var globalTechniqueParameters = fr.globalTechniqueParameters;
+                globalTechniqueParameters['lightgrid'] = fr.lightGrid.texture;
+                globalTechniqueParameters['lightGridTextureSize'] = fr.lightGrid.textureSize;
+                globalTechniqueParameters['clusterGrid'] = fr.clusterGrid;
+                globalTechniqueParameters['clusterDepth'] = fr.clusterDepth;
+                /* tslint:enable:no-string-literal */
+            }
+        }
+
         fr.v3Zero = md.v3BuildZero();
         fr.v4Zero = md.v4BuildZero();
         fr.v4One = md.v4BuildOne();
@@ -1817,6 +2064,24 @@ class ForwardRendering
                 {
                     drawParameters.userData = fr.sharedUserData[fr.passIndex.diffuse];
                     geometryInstance.diffuseDrawParameters = [drawParameters];
+
+                    if (fr.clusteredLighting && this.clusteredTechnique)
+                    {
+                        var clusteredDrawParameters = gd.createDrawParameters();
+                        clusteredDrawParameters.userData = fr.sharedUserData[fr.passIndex.diffuse];
+                        geometryInstance.prepareDrawParameters(clusteredDrawParameters);
+
+                        clusteredDrawParameters.technique = this.clusteredTechnique;
+                        /* tslint:disable:no-bitwise */
+                        clusteredDrawParameters.sortKey = renderingCommonSortKeyFn(sortOffset | this.clusteredTechniqueIndex,
+                                                                                   meta.materialIndex);
+                        /* tslint:enable:no-bitwise */
+
+                        clusteredDrawParameters.setTechniqueParameters(0, sharedMaterialTechniqueParameters);
+                        clusteredDrawParameters.setTechniqueParameters(1, geometryInstanceTechniqueParameters);
+
+                        geometryInstance.clusteredDrawParameters = [clusteredDrawParameters];
+                    }
                 }
 
                 if (fr.shadowMaps && this.shadowTechnique)
@@ -2338,6 +2603,16 @@ class ForwardRendering
             };
             shaderManager.load(this.shaderName, callback);
 
+            if (fr.clusteredLighting && this.clusteredTechniqueName)
+            {
+                var clusteredCallback = function shaderLoadedClusteredCallbackFn(shader)
+                {
+                    that.clusteredTechnique = shader.getTechnique(that.clusteredTechniqueName);
+                    that.clusteredTechniqueIndex = that.clusteredTechnique.id;
+                };
+                shaderManager.load(this.shaderName, clusteredCallback);
+            }
+
             if (fr.shadowMaps)
             {
                 if (this.shadowMappingTechniqueName)
@@ -2872,6 +3147,7 @@ class ForwardRendering
                             shadowMappingUpdate : shadowMappingUpdateFn,
                             shadowShaderName : "shaders/forwardrenderingshadows.cgfx",
                             shadowTechniqueName : "blinn_shadows",
+                            clusteredTechniqueName : "blinn_clustered",
                             loadTechniques : loadTechniques };
         effectTypeData.loadTechniques(shaderManager);
         effect.add(rigid, effectTypeData);
@@ -2885,6 +3161,7 @@ class ForwardRendering
                             shadowMappingUpdate : shadowMappingSkinnedUpdateFn,
                             shadowShaderName : "shaders/forwardrenderingshadows.cgfx",
                             shadowTechniqueName : "blinn_skinned_shadows",
+                            clusteredTechniqueName : "blinn_skinned_clustered",
                             loadTechniques : loadTechniques };
         effectTypeData.loadTechniques(shaderManager);
         effect.add(skinned, effectTypeData);
@@ -2904,6 +3181,7 @@ class ForwardRendering
                             shadowMappingUpdate : shadowMappingUpdateFn,
                             shadowShaderName : "shaders/forwardrenderingshadows.cgfx",
                             shadowTechniqueName : "blinn_shadows_nocull",
+                            clusteredTechniqueName : "blinn_nocull_clustered",
                             loadTechniques : loadTechniques };
         effectTypeData.loadTechniques(shaderManager);
         effect.add(rigid, effectTypeData);
@@ -2917,6 +3195,7 @@ class ForwardRendering
                             shadowMappingUpdate : shadowMappingSkinnedUpdateFn,
                             shadowShaderName : "shaders/forwardrenderingshadows.cgfx",
                             shadowTechniqueName : "blinn_skinned_shadows_nocull",
+                            clusteredTechniqueName : "blinn_skinned_nocull_clustered",
                             loadTechniques : loadTechniques };
         effectTypeData.loadTechniques(shaderManager);
         effect.add(skinned, effectTypeData);
@@ -2936,6 +3215,7 @@ class ForwardRendering
                             shadowMappingUpdate : shadowMappingUpdateFn,
                             shadowShaderName : "shaders/forwardrenderingshadows.cgfx",
                             shadowTechniqueName : "normalmap_shadows",
+                            clusteredTechniqueName : "normalmap_clustered",
                             loadTechniques : loadTechniques };
         effectTypeData.loadTechniques(shaderManager);
         effect.add(rigid, effectTypeData);
@@ -2949,6 +3229,7 @@ class ForwardRendering
                             shadowMappingUpdate : shadowMappingSkinnedUpdateFn,
                             shadowShaderName : "shaders/forwardrenderingshadows.cgfx",
                             shadowTechniqueName : "normalmap_skinned_shadows",
+                            clusteredTechniqueName : "normalmap_skinned_clustered",
                             loadTechniques : loadTechniques };
         effectTypeData.loadTechniques(shaderManager);
         effect.add(skinned, effectTypeData);
@@ -2968,6 +3249,7 @@ class ForwardRendering
                             shadowMappingUpdate : shadowMappingUpdateFn,
                             shadowShaderName : "shaders/forwardrenderingshadows.cgfx",
                             shadowTechniqueName : "normalmap_specularmap_shadows",
+                            clusteredTechniqueName : "normalmap_specularmap_clustered",
                             loadTechniques : loadTechniques };
         effectTypeData.loadTechniques(shaderManager);
         effect.add(rigid, effectTypeData);
@@ -2981,6 +3263,7 @@ class ForwardRendering
                             shadowMappingUpdate : shadowMappingSkinnedUpdateFn,
                             shadowShaderName : "shaders/forwardrenderingshadows.cgfx",
                             shadowTechniqueName : "normalmap_specularmap_skinned_shadows",
+                            clusteredTechniqueName : "normalmap_specularmap_skinned_clustered",
                             loadTechniques : loadTechniques };
         effectTypeData.loadTechniques(shaderManager);
         effect.add(skinned, effectTypeData);
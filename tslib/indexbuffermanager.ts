@@ -24,6 +24,192 @@ interface IndexBuffersPool
     indexBufferData: IndexBufferData[];
 };
 
+//
+// IndexBufferRing
+//
+// Index counterpart of VertexBufferRing: the dynamic index buffer is split in
+// numFrames regions, indices are written to a CPU copy and uploaded with a
+// single setData per flush.
+//
+class IndexBufferRing
+{
+    static version = 1;
+
+    indexBuffer: IndexBuffer;
+    format: number;
+    numIndices: number;     // Indices per region
+    numFrames: number;
+    data: any;              // CPU copy of the whole index buffer
+    numUploads: number;
+
+    private regionIndex: number;
+    private head: number;       // Next index to allocate
+    private uploaded: number;   // First index not uploaded yet
+
+    //
+    // allocate
+    //
+    allocate(numIndices: number): number
+    {
+        if (numIndices > this.numIndices)
+        {
+            return -1;
+        }
+
+        var head = this.head;
+        if ((head + numIndices) > ((this.regionIndex + 1) * this.numIndices))
+        {
+            this.nextFrame();
+            head = this.head;
+        }
+        this.head = (head + numIndices);
+        return head;
+    }
+
+    //
+    // write
+    //
+    // Allocates numIndices and copies them from data, starting at offset
+    write(data: any, numIndices: number, offset?: number): number
+    {
+        var index = this.allocate(numIndices);
+        if (index !== -1)
+        {
+            var start = (offset || 0);
+            var ringData = this.data;
+            if (data.subarray)
+            {
+                if (start === 0 && numIndices === data.length)
+                {
+                    ringData.set(data, index);
+                }
+                else
+                {
+                    ringData.set(data.subarray(start, (start + numIndices)), index);
+                }
+            }
+            else
+            {
+                var n;
+                for (n = 0; n < numIndices; n += 1)
+                {
+                    ringData[index + n] = data[start + n];
+                }
+            }
+        }
+        return index;
+    }
+
+    //
+    // flush
+    //
+    flush()
+    {
+        var uploaded = this.uploaded;
+        var head = this.head;
+        if (uploaded < head)
+        {
+            this.indexBuffer.setData(this.data.subarray(uploaded, head),
+                                     uploaded,
+                                     (head - uploaded));
+            this.uploaded = head;
+            this.numUploads += 1;
+        }
+    }
+
+    //
+    // nextFrame
+    //
+    // Does nothing if the current region is still empty
+    nextFrame()
+    {
+        this.flush();
+
+        var numIndices = this.numIndices;
+        if (this.head === (this.regionIndex * numIndices))
+        {
+            return;
+        }
+
+        var regionIndex = (this.regionIndex + 1);
+        if (regionIndex >= this.numFrames)
+        {
+            regionIndex = 0;
+        }
+        this.regionIndex = regionIndex;
+        this.head = this.uploaded = (regionIndex * numIndices);
+    }
+
+    //
+    // destroy
+    //
+    destroy()
+    {
+        if (this.indexBuffer)
+        {
+            this.indexBuffer.destroy();
+            this.indexBuffer = null;
+        }
+        this.data = null;
+    }
+
+    //
+    // create
+    //
+    static create(graphicsDevice: GraphicsDevice,
+                  numIndices: number,
+                  format: any,
+                  numFrames?: number) : IndexBufferRing
+    {
+        numFrames = (numFrames || 3);
+
+        if (typeof format === "string")
+        {
+            format = graphicsDevice['INDEXFORMAT_' + format];
+        }
+
+        var indexBuffer = graphicsDevice.createIndexBuffer({
+            numIndices: (numIndices * numFrames),
+            format: format,
+            dynamic: true
+        });
+
+        debug.assert(indexBuffer, "IndexBuffer not created.");
+
+        if (!indexBuffer)
+        {
+            return null;
+        }
+
+        var totalIndices = (numIndices * numFrames);
+        var data;
+        if (format === graphicsDevice.INDEXFORMAT_UINT)
+        {
+            data = new Uint32Array(totalIndices);
+        }
+        else if (format === graphicsDevice.INDEXFORMAT_UBYTE)
+        {
+            data = new Uint8Array(totalIndices);
+        }
+        else
+        {
+            data = new Uint16Array(totalIndices);
+        }
+
+        var ring = new IndexBufferRing();
+        ring.indexBuffer = indexBuffer;
+        ring.format = format;
+        ring.numIndices = numIndices;
+        ring.numFrames = numFrames;
+        ring.data = data;
+        ring.numUploads = 0;
+        ring.regionIndex = 0;
+        ring.head = 0;
+        ring.uploaded = 0;
+        return ring;
+    }
+}
+
 //
 // IndexBufferManager
 //
@@ -36,6 +222,7 @@ class IndexBufferManager
     numBuckets = 10;
 
     indexBuffersPools: IndexBuffersPool[];  //Array keyed-off attribute
+    indexBufferRings: IndexBufferRing[];
     debugCreatedIndexBuffers: number;
     graphicsDevice: GraphicsDevice;
     dynamicIndexBuffers: boolean;
@@ -406,11 +593,68 @@ class IndexBufferManager
         }
     }
 
+    //
+    // createRing
+    //
+    // For dynamic indices written every frame, see IndexBufferRing
+    createRing(numIndices: number, format: any, numFrames?: number) : IndexBufferRing
+    {
+        var ring = IndexBufferRing.create(this.graphicsDevice, numIndices, format, numFrames);
+        if (ring)
+        {
+            this.indexBufferRings.push(ring);
+            this.debugCreatedIndexBuffers += 1;
+        }
+        return ring;
+    }
+
+    //
+    // destroyRing
+    //
+    destroyRing(ring: IndexBufferRing)
+    {
+        var indexBufferRings = this.indexBufferRings;
+        var index = indexBufferRings.indexOf(ring);
+        if (index !== -1)
+        {
+            indexBufferRings.splice(index, 1);
+        }
+        ring.destroy();
+    }
+
+    //
+    // nextFrame
+    //
+    // Moves all the rings created by the manager to their next region
+    nextFrame()
+    {
+        var indexBufferRings = this.indexBufferRings;
+        var numRings = indexBufferRings.length;
+        var n;
+        for (n = 0; n < numRings; n += 1)
+        {
+            indexBufferRings[n].nextFrame();
+        }
+    }
+
     //
     // destroy
     //
     destroy()
     {
+        var indexBufferRings = this.indexBufferRings;
+        if (indexBufferRings)
+        {
+            var numRings = indexBufferRings.length;
+            var n;
+            for (n = 0; n < numRings; n += 1)
+            {
+                indexBufferRings[n].destroy();
+            }
+            indexBufferRings.length = 0;
+            this.indexBufferRings = null;
+        }
+
         var indexBuffersPools = this.indexBuffersPools;
         if (indexBuffersPools)
         {
@@ -459,6 +703,7 @@ class IndexBufferManager
         var manager = new IndexBufferManager();
 
         manager.indexBuffersPools = [];    //Array keyed-off attribute
+        manager.indexBufferRings = [];
         manager.debugCreatedIndexBuffers = 0;
         manager.graphicsDevice = graphicsDevice;
         manager.dynamicIndexBuffers = dynamicIndexBuffers ? true : false;
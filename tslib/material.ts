@@ -8,7 +8,7 @@
 class Material
 {
     /* tslint:disable:no-unused-variable */
-    static version = 1;
+    static version = 2;
     /* tslint:enable:no-unused-variable */
 
     name                : string;
@@ -157,6 +157,24 @@ class Material
         }
     }
 
+    // Removes the references to the texture instances loaded by
+    // loadTextures, the texture names are kept to load them again.
+    releaseTextures()
+    {
+        var textureInstances = this.textureInstances;
+        for (var p in textureInstances)
+        {
+            if (textureInstances.hasOwnProperty(p))
+            {
+                var textureInstance = textureInstances[p];
+                textureInstance.unsubscribeTextureChanged(this.onTextureChanged);
+                this.techniqueParameters[p] = null;
+                textureInstance.reference.remove();
+            }
+        }
+        delete this.textureInstances;
+    }
+
     setTextureInstance(propertryName, textureInstance)
     {
         if (!this.textureInstances)
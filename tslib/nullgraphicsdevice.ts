@@ -0,0 +1,2062 @@
+// Copyright (c) 2015 Turbulenz Limited
+
+/*global TurbulenzEngine: false*/
+/*global _tz_techniqueParameterBufferCreate: false*/
+
+//
+// NullGraphicsDevice
+//
+// Implements the full GraphicsDevice interface without a GL context so the
+// CPU side of the renderers can run headless, under Node or in a worker.
+// Nothing is rendered, instead the device counts the work that the WebGL
+// device would have submitted: technique and render state changes, uniform
+// values, texture bindings, stream and index buffer changes, bytes uploaded
+// to buffers and textures, and draw calls and primitives. The constants match
+// the WebGL device so sort keys and formats behave the same.
+//
+
+interface NullGraphicsDeviceMetrics extends GraphicsDeviceMetrics
+{
+    uniformUploads: number;
+    bufferBytes: number;
+    textureBytes: number;
+    clears: number;
+    frames: number;
+}
+
+interface NullGraphicsDeviceParameters
+{
+    width?: number;
+    height?: number;
+    features?: { [name: string]: any; };
+}
+
+interface NullVertexFormat
+{
+    numComponents: number;
+    stride: number;
+    componentStride: number;
+    format: number;
+    name: string;
+    normalized: boolean;
+    normalizationScale: number;
+}
+
+//
+// NullTexture
+//
+class NullTexture implements Texture
+{
+    /* tslint:disable:no-unused-variable */
+    static version = 1;
+    /* tslint:enable:no-unused-variable */
+
+    id: number;
+    name: string;
+    width: number;
+    height: number;
+    depth: number;
+    format: number;
+    mipmaps: boolean;
+    cubemap: boolean;
+    dynamic: boolean;
+    renderable: boolean;
+
+    _gd: NullGraphicsDevice;
+
+    setData(data: any, face?: number, level?: number, x?: number, y?: number, w?: number, h?: number)
+    {
+        if (data)
+        {
+            this._gd.metrics.textureBytes += (data.byteLength !== undefined ? data.byteLength : data.length);
+        }
+    }
+
+    typedArrayIsValid(array: any): boolean
+    {
+        return (array instanceof Uint8Array ||
+                array instanceof Uint16Array ||
+                array instanceof Float32Array);
+    }
+
+    destroy()
+    {
+        this._gd = null;
+    }
+
+    static create(gd: NullGraphicsDevice, params: TextureParameters): NullTexture
+    {
+        var texture = new NullTexture();
+        texture.id = ++gd._counters.textures;
+        texture.name = (params.name || params.src || null);
+        texture.width = (params.width || 1);
+        texture.height = (params.height || 1);
+        texture.depth = (params.depth || 1);
+        texture.mipmaps = !!params.mipmaps;
+        texture.cubemap = !!params.cubemap;
+        texture.dynamic = !!params.dynamic;
+        texture.renderable = !!params.renderable;
+        texture._gd = gd;
+
+        var format = params.format;
+        if (typeof format === "string")
+        {
+            format = gd['PIXELFORMAT_' + format];
+        }
+        texture.format = (format !== undefined ? format : gd.PIXELFORMAT_R8G8B8A8);
+
+        // Data given with a source is the file to decode, not texels
+        if (params.data && !params.src)
+        {
+            texture.setData(params.data);
+        }
+
+        var onload = params.onload;
+        if (onload)
+        {
+            // Image files are never decoded, report them as loaded 1x1 textures
+            TurbulenzEngine.setTimeout(function nullTextureLoadedFn()
+            {
+                onload(texture, 200);
+            }, 0);
+        }
+
+        return texture;
+    }
+}
+
+//
+// NullRenderBuffer
+//
+class NullRenderBuffer implements RenderBuffer
+{
+    /* tslint:disable:no-unused-variable */
+    static version = 1;
+    /* tslint:enable:no-unused-variable */
+
+    id: number;
+    width: number;
+    height: number;
+    format: number;
+
+    destroy()
+    {
+        this.width = 0;
+        this.height = 0;
+    }
+
+    static create(gd: NullGraphicsDevice, params: RenderBufferParameters): NullRenderBuffer
+    {
+        var renderBuffer = new NullRenderBuffer();
+        renderBuffer.id = ++gd._counters.renderBuffers;
+        renderBuffer.width = params.width;
+        renderBuffer.height = params.height;
+        var format = params.format;
+        if (typeof format === "string")
+        {
+            format = gd['PIXELFORMAT_' + format];
+        }
+        renderBuffer.format = (format !== undefined ? format : gd.PIXELFORMAT_D24S8);
+        return renderBuffer;
+    }
+}
+
+//
+// NullRenderTarget
+//
+class NullRenderTarget implements RenderTarget
+{
+    /* tslint:disable:no-unused-variable */
+    static version = 1;
+    /* tslint:enable:no-unused-variable */
+
+    id: number;
+    width: number;
+    height: number;
+    face: number;
+    colorTexture0: Texture;
+    colorTexture1: Texture;
+    colorTexture2: Texture;
+    colorTexture3: Texture;
+    depthBuffer: RenderBuffer;
+    depthTexture: Texture;
+
+    getWidth(): number
+    {
+        return this.width;
+    }
+
+    getHeight(): number
+    {
+        return this.height;
+    }
+
+    setColorTexture0(colorTexture0: Texture): void
+    {
+        this.colorTexture0 = colorTexture0;
+    }
+
+    setColorTexture1(colorTexture1: Texture): void
+    {
+        this.colorTexture1 = colorTexture1;
+    }
+
+    setColorTexture2(colorTexture2: Texture): void
+    {
+        this.colorTexture2 = colorTexture2;
+    }
+
+    setColorTexture3(colorTexture3: Texture): void
+    {
+        this.colorTexture3 = colorTexture3;
+    }
+
+    destroy(): void
+    {
+        this.colorTexture0 = null;
+        this.colorTexture1 = null;
+        this.colorTexture2 = null;
+        this.colorTexture3 = null;
+        this.depthBuffer = null;
+        this.depthTexture = null;
+    }
+
+    static create(gd: NullGraphicsDevice, params: RenderTargetParameters): NullRenderTarget
+    {
+        var renderTarget = new NullRenderTarget();
+        renderTarget.id = ++gd._counters.renderTargets;
+        renderTarget.face = (params.face || 0);
+        renderTarget.colorTexture0 = (params.colorTexture0 || null);
+        renderTarget.colorTexture1 = (params.colorTexture1 || null);
+        renderTarget.colorTexture2 = (params.colorTexture2 || null);
+        renderTarget.colorTexture3 = (params.colorTexture3 || null);
+        renderTarget.depthBuffer = (params.depthBuffer || null);
+        renderTarget.depthTexture = (<any>(params.depthTexture) || null);
+
+        var size: any = (renderTarget.colorTexture0 || renderTarget.depthTexture || renderTarget.depthBuffer);
+        renderTarget.width = (size ? size.width : 0);
+        renderTarget.height = (size ? size.height : 0);
+        return renderTarget;
+    }
+}
+
+//
+// NullSemantics
+//
+class NullSemantics implements Semantics
+{
+    /* tslint:disable:no-unused-variable */
+    static version = 1;
+    /* tslint:enable:no-unused-variable */
+
+    length: number;
+    [index: number]: any;
+
+    static create(gd: NullGraphicsDevice, semantics: any[]): NullSemantics
+    {
+        var s = new NullSemantics();
+        var numSemantics = semantics.length;
+        s.length = numSemantics;
+        for (var i = 0; i < numSemantics; i += 1)
+        {
+            var semantic = semantics[i];
+            s[i] = (typeof semantic === "string" ? gd['SEMANTIC_' + semantic] : semantic);
+        }
+        return s;
+    }
+}
+
+//
+// NullVertexBuffer
+//
+class NullVertexBuffer implements VertexBuffer
+{
+    /* tslint:disable:no-unused-variable */
+    static version = 1;
+    /* tslint:enable:no-unused-variable */
+
+    id: number;
+    numVertices: number;
+    stride: number;
+    transient: boolean;
+    dynamic: boolean;
+    numAttributes: number;
+    attributes: any[];
+
+    _gd: NullGraphicsDevice;
+
+    setData(data: any, offset?: number, numVertices?: number): void
+    {
+        if (numVertices === undefined)
+        {
+            numVertices = (this.numVertices - (offset || 0));
+        }
+        this._gd.metrics.bufferBytes += (numVertices * this.stride);
+    }
+
+    map(offset?: number, numVertices?: number): VertexWriteIterator
+    {
+        // Each call to the writer writes one vertex
+        var writer: any = function nullVertexWriteFn()
+        {
+            writer.numWritten += 1;
+        };
+        writer.write = writer;
+        writer.numWritten = 0;
+        return writer;
+    }
+
+    unmap(writer: VertexWriteIterator): void
+    {
+        if (writer)
+        {
+            this._gd.metrics.bufferBytes += ((<any>writer).numWritten * this.stride);
+        }
+    }
+
+    destroy(): void
+    {
+        this._gd = null;
+    }
+
+    static create(gd: NullGraphicsDevice, params: VertexBufferParameters): NullVertexBuffer
+    {
+        var vertexBuffer = new NullVertexBuffer();
+        vertexBuffer.id = ++gd._counters.vertexBuffers;
+        vertexBuffer.numVertices = params.numVertices;
+        vertexBuffer.transient = !!params.transient;
+        vertexBuffer.dynamic = (vertexBuffer.transient || !!params.dynamic);
+        vertexBuffer._gd = gd;
+
+        var attributes = params.attributes;
+        var numAttributes = attributes.length;
+        var stride = 0;
+        var formats = [];
+        for (var n = 0; n < numAttributes; n += 1)
+        {
+            var format = attributes[n];
+            if (typeof format === "string")
+            {
+                format = gd['VERTEXFORMAT_' + format];
+            }
+            formats[n] = format;
+            stride += format.stride;
+        }
+        vertexBuffer.attributes = formats;
+        vertexBuffer.numAttributes = numAttributes;
+        vertexBuffer.stride = stride;
+
+        if (params.data)
+        {
+            vertexBuffer.setData(params.data, 0, params.numVertices);
+        }
+
+        return vertexBuffer;
+    }
+}
+
+//
+// NullIndexBuffer
+//
+class NullIndexBuffer implements IndexBuffer
+{
+    /* tslint:disable:no-unused-variable */
+    static version = 1;
+    /* tslint:enable:no-unused-variable */
+
+    id: number;
+    numIndices: number;
+    format: number;
+    dynamic: boolean;
+    transient: boolean;
+
+    _stride: number;
+    _gd: NullGraphicsDevice;
+
+    setData(data: any, offset?: number, numIndices?: number): void
+    {
+        if (numIndices === undefined)
+        {
+            numIndices = (this.numIndices - (offset || 0));
+        }
+        this._gd.metrics.bufferBytes += (numIndices * this._stride);
+    }
+
+    map(offset?: number, numIndices?: number): IndexWriteIterator
+    {
+        // Each call to the writer writes all its arguments
+        var writer: any = function nullIndexWriteFn()
+        {
+            writer.numWritten += arguments.length;
+        };
+        writer.write = writer;
+        writer.numWritten = 0;
+        return writer;
+    }
+
+    unmap(writer: IndexWriteIterator): void
+    {
+        if (writer)
+        {
+            this._gd.metrics.bufferBytes += ((<any>writer).numWritten * this._stride);
+        }
+    }
+
+    destroy(): void
+    {
+        this._gd = null;
+    }
+
+    static create(gd: NullGraphicsDevice, params: IndexBufferParameters): NullIndexBuffer
+    {
+        var indexBuffer = new NullIndexBuffer();
+        indexBuffer.id = ++gd._counters.indexBuffers;
+        indexBuffer.numIndices = params.numIndices;
+        indexBuffer.transient = !!params.transient;
+        indexBuffer.dynamic = (indexBuffer.transient || !!params.dynamic);
+        indexBuffer._gd = gd;
+
+        var format = params.format;
+        if (typeof format === "string")
+        {
+            format = gd['INDEXFORMAT_' + format];
+        }
+        indexBuffer.format = format;
+        if (format === gd.INDEXFORMAT_UBYTE)
+        {
+            indexBuffer._stride = 1;
+        }
+        else if (format === gd.INDEXFORMAT_UINT)
+        {
+            indexBuffer._stride = 4;
+        }
+        else
+        {
+            indexBuffer._stride = 2;
+        }
+
+        if (params.data)
+        {
+            indexBuffer.setData(params.data, 0, params.numIndices);
+        }
+
+        return indexBuffer;
+    }
+}
+
+//
+// NullPass
+//
+class NullPass implements Pass
+{
+    /* tslint:disable:no-unused-variable */
+    static version = 1;
+    /* tslint:enable:no-unused-variable */
+
+    name: string;
+
+    // Maps each parameter used by the pass to true for samplers, false otherwise
+    parameters: { [name: string]: boolean; };
+    numParameters: number;
+    stateNames: string[];
+    stateValues: string[];
+    states: { [name: string]: string; };
+
+    static create(shaderParameters: { [name: string]: ShaderParametersParameter; },
+                  params: ShaderParametersPass): NullPass
+    {
+        var pass = new NullPass();
+        pass.name = (params.name || null);
+
+        var parameters = {};
+        var parameterNames = (params.parameters || []);
+        var numParameters = parameterNames.length;
+        var n;
+        for (n = 0; n < numParameters; n += 1)
+        {
+            var name = parameterNames[n];
+            var parameter = (shaderParameters ? shaderParameters[name] : null);
+            parameters[name] = (parameter ? 0 === parameter.type.indexOf('sampler') : false);
+        }
+        pass.parameters = parameters;
+        pass.numParameters = numParameters;
+
+        // State values are compared as strings, some of them are arrays
+        var stateNames = [];
+        var stateValues = [];
+        var states = {};
+        var passStates = params.states;
+        var s;
+        for (s in passStates)
+        {
+            if (passStates.hasOwnProperty(s))
+            {
+                var value = String(passStates[s]);
+                stateNames.push(s);
+                stateValues.push(value);
+                states[s] = value;
+            }
+        }
+        pass.stateNames = stateNames;
+        pass.stateValues = stateValues;
+        pass.states = states;
+
+        return pass;
+    }
+}
+
+//
+// NullTechnique
+//
+class NullTechnique implements Technique
+{
+    /* tslint:disable:no-unused-variable */
+    static version = 1;
+    /* tslint:enable:no-unused-variable */
+
+    id: number;
+    initialized: boolean;
+    shader: NullShader;
+    name: string;
+    passes: NullPass[];
+    numPasses: number;
+    numParameters: number;
+    device: GraphicsDevice;
+
+    // Nothing is linked, always ready
+    isReady(): boolean
+    {
+        return true;
+    }
+
+    getPass(id): NullPass
+    {
+        var passes = this.passes;
+        var numPasses = passes.length;
+        if (typeof id === "string")
+        {
+            for (var n = 0; n < numPasses; n += 1)
+            {
+                if (passes[n].name === id)
+                {
+                    return passes[n];
+                }
+            }
+            return null;
+        }
+        return (id < numPasses ? passes[id] : null);
+    }
+
+    static create(gd: NullGraphicsDevice, shader: NullShader, name: string,
+                  shaderParameters: { [name: string]: ShaderParametersParameter; },
+                  passes: ShaderParametersPass[]): NullTechnique
+    {
+        var technique = new NullTechnique();
+        technique.id = ++gd._counters.techniques;
+        technique.initialized = true;
+        technique.shader = shader;
+        technique.name = name;
+        technique.device = gd;
+
+        var numPasses = passes.length;
+        var numParameters = 0;
+        technique.passes = [];
+        for (var n = 0; n < numPasses; n += 1)
+        {
+            var pass = NullPass.create(shaderParameters, passes[n]);
+            numParameters += pass.numParameters;
+            technique.passes[n] = pass;
+        }
+        technique.numPasses = numPasses;
+        technique.numParameters = numParameters;
+        return technique;
+    }
+}
+
+//
+// NullShader
+//
+class NullShader implements Shader
+{
+    /* tslint:disable:no-unused-variable */
+    static version = 1;
+    /* tslint:enable:no-unused-variable */
+
+    id: number;
+    name: string;
+    numTechniques: number;
+    numParameters: number;
+
+    _techniques: { [name: string]: NullTechnique; };
+    _techniquesArray: NullTechnique[];
+    _parameters: { [name: string]: ShaderParameter; };
+    _parametersArray: ShaderParameter[];
+
+    getTechnique(name: any): Technique
+    {
+        if (typeof name === "string")
+        {
+            return this._techniques[name];
+        }
+        return (this._techniquesArray[name] || null);
+    }
+
+    getParameter(name: any): ShaderParameter
+    {
+        if (typeof name === "string")
+        {
+            return this._parameters[name];
+        }
+        return this._parametersArray[name];
+    }
+
+    destroy()
+    {
+        this._techniques = null;
+        this._techniquesArray = null;
+        this._parameters = null;
+        this._parametersArray = null;
+    }
+
+    static create(gd: NullGraphicsDevice, params: ShaderParameters,
+                  onload?: { (shader: Shader): void; }): NullShader
+    {
+        var shader = new NullShader();
+        shader.id = ++gd._counters.shaders;
+        shader.name = params.name;
+
+        var p;
+        var shaderParameters = params.parameters;
+        shader._parameters = {};
+        shader._parametersArray = [];
+        for (p in shaderParameters)
+        {
+            if (shaderParameters.hasOwnProperty(p))
+            {
+                var fileParameter = shaderParameters[p];
+                var parameter = {
+                    name: p,
+                    type: fileParameter.type,
+                    rows: (fileParameter.rows || 1),
+                    columns: (fileParameter.columns || 1)
+                };
+                shader._parameters[p] = parameter;
+                shader._parametersArray.push(parameter);
+            }
+        }
+        shader.numParameters = shader._parametersArray.length;
+
+        var techniques = params.techniques;
+        shader._techniques = {};
+        shader._techniquesArray = [];
+        for (p in techniques)
+        {
+            if (techniques.hasOwnProperty(p))
+            {
+                var technique = NullTechnique.create(gd, shader, p, shaderParameters, techniques[p]);
+                shader._techniques[p] = technique;
+                shader._techniquesArray.push(technique);
+            }
+        }
+        shader.numTechniques = shader._techniquesArray.length;
+
+        if (onload)
+        {
+            TurbulenzEngine.setTimeout(function nullShaderLoadedFn()
+            {
+                onload(shader);
+            }, 0);
+        }
+
+        return shader;
+    }
+}
+
+//
+// NullTechniqueParameters
+//
+class NullTechniqueParameters implements TechniqueParameters
+{
+    [paramName: string]: any;
+
+    static create(params: any): TechniqueParameters
+    {
+        var techniqueParameters = new NullTechniqueParameters();
+        Object.defineProperty(techniqueParameters, "version", {
+            value: 0,
+            writable: true
+        });
+        if (params)
+        {
+            for (var p in params)
+            {
+                if (params.hasOwnProperty(p))
+                {
+                    techniqueParameters[p] = params[p];
+                }
+            }
+        }
+        return techniqueParameters;
+    }
+}
+
+//
+// NullDrawParameters
+//
+// Same layout as WebGLDrawParameters: 16 streams of (vertexBuffer, semantics,
+// offset) triplets, then 8 TechniqueParameters slots, then the instances.
+//
+class NullDrawParameters implements DrawParameters
+{
+    /* tslint:disable:no-unused-variable */
+    static version = 1;
+    /* tslint:enable:no-unused-variable */
+
+    technique: Technique;
+    primitive: number;
+    indexBuffer: IndexBuffer;
+    count: number;
+    firstIndex: number;
+    sortKey: number;
+    userData: any;
+    instanceCount: number;
+    [idx: number]: any;
+
+    _endStreams: number;
+    _instanceStreams: number;
+    _endTechniqueParameters: number;
+    _endInstances: number;
+
+    constructor()
+    {
+        this.technique = null;
+        this.primitive = -1;
+        this.indexBuffer = null;
+        this.count = 0;
+        this.firstIndex = 0;
+        this.sortKey = 0;
+        this.userData = null;
+        this.instanceCount = 0;
+        this._endStreams = 0;
+        this._instanceStreams = 0;
+        this._endTechniqueParameters = (16 * 3);
+        this._endInstances = ((16 * 3) + 8);
+
+        var n;
+        for (n = 0; n < (16 * 3); n += 3)
+        {
+            this[n + 0] = null;
+            this[n + 1] = null;
+            this[n + 2] = 0;
+        }
+        for (n = (16 * 3); n < ((16 * 3) + 8); n += 1)
+        {
+            this[n] = null;
+        }
+        return this;
+    }
+
+    clone(dst?: NullDrawParameters): NullDrawParameters
+    {
+        if (!dst)
+        {
+            dst = new NullDrawParameters();
+        }
+        dst.technique = this.technique;
+        dst.primitive = this.primitive;
+        dst.indexBuffer = this.indexBuffer;
+        dst.count = this.count;
+        dst.firstIndex = this.firstIndex;
+        dst.sortKey = this.sortKey;
+        dst.userData = this.userData;
+        dst.instanceCount = this.instanceCount;
+        dst._endStreams = this._endStreams;
+        dst._instanceStreams = this._instanceStreams;
+        dst._endTechniqueParameters = this._endTechniqueParameters;
+        dst._endInstances = this._endInstances;
+        for (var i = 0; i < this._endInstances; i += 1)
+        {
+            dst[i] = this[i];
+        }
+        return dst;
+    }
+
+    setTechniqueParameters(indx: number, techniqueParameters: TechniqueParameters): void
+    {
+        debug.assert(indx < 8, "indx out of range");
+        if (indx < 8)
+        {
+            indx += (16 * 3);
+            this[indx] = techniqueParameters;
+
+            var endTechniqueParameters = this._endTechniqueParameters;
+            if (techniqueParameters)
+            {
+                if (endTechniqueParameters <= indx)
+                {
+                    this._endTechniqueParameters = (indx + 1);
+                }
+            }
+            else
+            {
+                while ((16 * 3) < endTechniqueParameters &&
+                       !this[endTechniqueParameters - 1])
+                {
+                    endTechniqueParameters -= 1;
+                }
+                this._endTechniqueParameters = endTechniqueParameters;
+            }
+        }
+    }
+
+    setVertexBuffer(indx: number, vertexBuffer: VertexBuffer): void
+    {
+        debug.assert(indx < 16, "index out of range");
+        if (indx < 16)
+        {
+            indx *= 3;
+            this[indx] = vertexBuffer;
+
+            var endStreams = this._endStreams;
+            if (vertexBuffer)
+            {
+                if (endStreams <= indx)
+                {
+                    this._endStreams = (indx + 3);
+                }
+            }
+            else
+            {
+                while (0 < endStreams &&
+                       !this[endStreams - 3])
+                {
+                    endStreams -= 3;
+                }
+                this._endStreams = endStreams;
+            }
+        }
+    }
+
+    setSemantics(indx: number, semantics: Semantics): void
+    {
+        debug.assert(indx < 16, "index parameter out of range");
+        if (indx < 16)
+        {
+            this[(indx * 3) + 1] = semantics;
+        }
+    }
+
+    setOffset(indx: number, offset: number): void
+    {
+        debug.assert(indx < 16, "index parameter out of range");
+        if (indx < 16)
+        {
+            this[(indx * 3) + 2] = offset;
+        }
+    }
+
+    setStreamPerInstance(indx: number, perInstance: boolean): void
+    {
+        debug.assert(indx < 16, "index parameter out of range");
+        if (indx < 16)
+        {
+            /* tslint:disable:no-bitwise */
+            if (perInstance)
+            {
+                this._instanceStreams |= (1 << indx);
+            }
+            else
+            {
+                this._instanceStreams &= ~(1 << indx);
+            }
+            /* tslint:enable:no-bitwise */
+        }
+    }
+
+    getStreamPerInstance(indx: number): boolean
+    {
+        /* tslint:disable:no-bitwise */
+        return (indx < 16 && 0 !== (this._instanceStreams & (1 << indx)));
+        /* tslint:enable:no-bitwise */
+    }
+
+    getTechniqueParameters(indx: number): TechniqueParameters
+    {
+        return (indx < 8 ? this[indx + (16 * 3)] : undefined);
+    }
+
+    getVertexBuffer(indx: number): VertexBuffer
+    {
+        return (indx < 16 ? this[(indx * 3) + 0] : undefined);
+    }
+
+    getSemantics(indx: number): Semantics
+    {
+        return (indx < 16 ? this[(indx * 3) + 1] : undefined);
+    }
+
+    getOffset(indx: number): number
+    {
+        return (indx < 16 ? this[(indx * 3) + 2] : undefined);
+    }
+
+    addInstance(instanceParameters: TechniqueParameters): void
+    {
+        if (instanceParameters)
+        {
+            var endInstances = this._endInstances;
+            this._endInstances = (endInstances + 1);
+            this[endInstances] = instanceParameters;
+        }
+    }
+
+    removeInstances(): void
+    {
+        this._endInstances = ((16 * 3) + 8);
+    }
+
+    getNumInstances(): number
+    {
+        return (this._endInstances - ((16 * 3) + 8));
+    }
+
+    static create(): NullDrawParameters
+    {
+        return new NullDrawParameters();
+    }
+}
+
+//
+// NullGraphicsDevice
+//
+class NullGraphicsDevice implements GraphicsDevice
+{
+    /* tslint:disable:no-unused-variable */
+    static version = 1;
+    /* tslint:enable:no-unused-variable */
+
+    // GraphicsDevice
+    PIXELFORMAT_A8           : number;
+    PIXELFORMAT_L8           : number;
+    PIXELFORMAT_L8A8         : number;
+    PIXELFORMAT_R5G5B5A1     : number;
+    PIXELFORMAT_R5G6B5       : number;
+    PIXELFORMAT_R4G4B4A4     : number;
+    PIXELFORMAT_R8G8B8A8     : number;
+    PIXELFORMAT_R8G8B8       : number;
+    PIXELFORMAT_D24S8        : number;
+    PIXELFORMAT_D16          : number;
+    PIXELFORMAT_DXT1         : number;
+    PIXELFORMAT_DXT3         : number;
+    PIXELFORMAT_DXT5         : number;
+    PIXELFORMAT_S8           : number;
+    PIXELFORMAT_RGBA32F      : number;
+    PIXELFORMAT_RGB32F       : number;
+    PIXELFORMAT_RGBA16F      : number;
+    PIXELFORMAT_RGB16F       : number;
+    PIXELFORMAT_D32          : number;
+
+    PRIMITIVE_POINTS         : number;
+    PRIMITIVE_LINES          : number;
+    PRIMITIVE_LINE_LOOP      : number;
+    PRIMITIVE_LINE_STRIP     : number;
+    PRIMITIVE_TRIANGLES      : number;
+    PRIMITIVE_TRIANGLE_STRIP : number;
+    PRIMITIVE_TRIANGLE_FAN   : number;
+
+    INDEXFORMAT_UBYTE        : number;
+    INDEXFORMAT_USHORT       : number;
+    INDEXFORMAT_UINT         : number;
+
+    VERTEXFORMAT_BYTE4       : NullVertexFormat;
+    VERTEXFORMAT_BYTE4N      : NullVertexFormat;
+    VERTEXFORMAT_UBYTE4      : NullVertexFormat;
+    VERTEXFORMAT_UBYTE4N     : NullVertexFormat;
+    VERTEXFORMAT_SHORT2      : NullVertexFormat;
+    VERTEXFORMAT_SHORT2N     : NullVertexFormat;
+    VERTEXFORMAT_SHORT4      : NullVertexFormat;
+    VERTEXFORMAT_SHORT4N     : NullVertexFormat;
+    VERTEXFORMAT_USHORT2     : NullVertexFormat;
+    VERTEXFORMAT_USHORT2N    : NullVertexFormat;
+    VERTEXFORMAT_USHORT4     : NullVertexFormat;
+    VERTEXFORMAT_USHORT4N    : NullVertexFormat;
+    VERTEXFORMAT_FLOAT1      : NullVertexFormat;
+    VERTEXFORMAT_FLOAT2      : NullVertexFormat;
+    VERTEXFORMAT_FLOAT3      : NullVertexFormat;
+    VERTEXFORMAT_FLOAT4      : NullVertexFormat;
+
+    SEMANTIC_POSITION        : number;
+    SEMANTIC_POSITION0       : number;
+    SEMANTIC_BLENDWEIGHT     : number;
+    SEMANTIC_BLENDWEIGHT0    : number;
+    SEMANTIC_NORMAL          : number;
+    SEMANTIC_NORMAL0         : number;
+    SEMANTIC_COLOR           : number;
+    SEMANTIC_COLOR0          : number;
+    SEMANTIC_COLOR1          : number;
+    SEMANTIC_SPECULAR        : number;
+    SEMANTIC_FOGCOORD        : number;
+    SEMANTIC_TESSFACTOR      : number;
+    SEMANTIC_PSIZE0          : number;
+    SEMANTIC_BLENDINDICES    : number;
+    SEMANTIC_BLENDINDICES0   : number;
+    SEMANTIC_TEXCOORD        : number;
+    SEMANTIC_TEXCOORD0       : number;
+    SEMANTIC_TEXCOORD1       : number;
+    SEMANTIC_TEXCOORD2       : number;
+    SEMANTIC_TEXCOORD3       : number;
+    SEMANTIC_TEXCOORD4       : number;
+    SEMANTIC_TEXCOORD5       : number;
+    SEMANTIC_TEXCOORD6       : number;
+    SEMANTIC_TEXCOORD7       : number;
+    SEMANTIC_TANGENT         : number;
+    SEMANTIC_TANGENT0        : number;
+    SEMANTIC_BINORMAL0       : number;
+    SEMANTIC_BINORMAL        : number;
+    SEMANTIC_PSIZE           : number;
+    SEMANTIC_ATTR0           : number;
+    SEMANTIC_ATTR1           : number;
+    SEMANTIC_ATTR2           : number;
+    SEMANTIC_ATTR3           : number;
+    SEMANTIC_ATTR4           : number;
+    SEMANTIC_ATTR5           : number;
+    SEMANTIC_ATTR6           : number;
+    SEMANTIC_ATTR7           : number;
+    SEMANTIC_ATTR8           : number;
+    SEMANTIC_ATTR9           : number;
+    SEMANTIC_ATTR10          : number;
+    SEMANTIC_ATTR11          : number;
+    SEMANTIC_ATTR12          : number;
+    SEMANTIC_ATTR13          : number;
+    SEMANTIC_ATTR14          : number;
+    SEMANTIC_ATTR15          : number;
+
+    DEFAULT_SAMPLER: {
+        minFilter: number;
+        magFilter: number;
+        wrapS: number;
+        wrapT: number;
+        wrapR: number;
+        maxAnisotropy: number;
+    };
+
+    width: number;
+    height: number;
+    extensions: string;
+    shadingLanguageVersion: string;
+    fullscreen: boolean;
+    rendererVersion: string;
+    renderer: string;
+    vendor: string;
+    videoRam: number;
+    desktopWidth: number;
+    desktopHeight: number;
+    fps: number;
+
+    metrics: NullGraphicsDeviceMetrics;
+
+    shaderLinkTime: number;
+
+    // NullGraphicsDevice (internal)
+    _counters: {
+        textures: number;
+        vertexBuffers: number;
+        indexBuffers: number;
+        renderTargets: number;
+        renderBuffers: number;
+        shaders: number;
+        techniques: number;
+    };
+    _features: { [name: string]: any; };
+    _activeTechnique: NullTechnique;
+    _activePass: NullPass;
+    _activeIndexBuffer: NullIndexBuffer;
+    _activeRenderTarget: NullRenderTarget;
+    _renderStates: { [name: string]: string; };
+    _boundTextures: { [name: string]: any; };
+    _instancedTechniques: { [id: number]: TechniqueInstancingParameters; };
+    _numInstancedTechniques: number;
+    _instanceBatches: NullDrawParameters[];
+    _instanceVertexBuffers: NullVertexBuffer[];
+    _numInstanceBatches: number;
+    _batchedDrawParameters: NullDrawParameters[];
+    _immediatePrimitive: number;
+    _immediateWriter: any;
+
+    beginFrame(): boolean
+    {
+        this.metrics.frames += 1;
+        this._numInstanceBatches = 0;
+        return true;
+    }
+
+    endFrame(): void
+    {
+        debug.assert(!this._activeRenderTarget,
+                     "endFrame called before calling endRenderTarget on current render target");
+        this._activeTechnique = null;
+        this._activePass = null;
+    }
+
+    // Shaders are never queued for linking
+    updateShaderPrograms(maxTime: number): number
+    {
+        return 0;
+    }
+
+    // Zeroes all the counters, usually called at the start of each measured frame
+    resetMetrics(): void
+    {
+        var metrics = this.metrics;
+        metrics.renderTargetChanges = 0;
+        metrics.textureChanges = 0;
+        metrics.renderStateChanges = 0;
+        metrics.vertexAttributesChanges = 0;
+        metrics.vertexBufferChanges = 0;
+        metrics.indexBufferChanges = 0;
+        metrics.vertexArrayObjectChanges = 0;
+        metrics.techniqueParametersChanges = 0;
+        metrics.techniqueParametersSkipped = 0;
+        metrics.techniqueParameterBuffersSkipped = 0;
+        metrics.techniqueChanges = 0;
+        metrics.drawCalls = 0;
+        metrics.primitives = 0;
+        metrics.uniformUploads = 0;
+        metrics.bufferBytes = 0;
+        metrics.textureBytes = 0;
+        metrics.clears = 0;
+        metrics.frames = 0;
+    }
+
+    _addPrimitives(primitive: number, count: number, numInstances?: number): void
+    {
+        var metrics = this.metrics;
+        metrics.drawCalls += 1;
+        var numPrimitives = 0;
+        /* tslint:disable:no-bitwise */
+        switch (primitive)
+        {
+        case 0x0000: //POINTS
+            numPrimitives = count;
+            break;
+        case 0x0001: //LINES
+            numPrimitives = (count >> 1);
+            break;
+        case 0x0002: //LINE_LOOP
+            numPrimitives = count;
+            break;
+        case 0x0003: //LINE_STRIP
+            numPrimitives = count - 1;
+            break;
+        case 0x0004: //TRIANGLES
+            numPrimitives = (count / 3) | 0;
+            break;
+        case 0x0005: //TRIANGLE_STRIP
+            numPrimitives = count - 2;
+            break;
+        case 0x0006: //TRIANGLE_FAN
+            numPrimitives = count - 2;
+            break;
+        }
+        /* tslint:enable:no-bitwise */
+        if (numInstances)
+        {
+            numPrimitives *= numInstances;
+        }
+        metrics.primitives += numPrimitives;
+    }
+
+    _setTechnique(technique: NullTechnique): void
+    {
+        if (this._activeTechnique === technique)
+        {
+            return;
+        }
+        this._activeTechnique = technique;
+        this.metrics.techniqueChanges += 1;
+
+        var pass = technique.passes[0];
+        var lastPass = this._activePass;
+        if (lastPass === pass)
+        {
+            return;
+        }
+        this._activePass = pass;
+
+        // States set by the new pass that differ from the current ones, plus
+        // the states of the old pass that go back to their defaults
+        var renderStates = this._renderStates;
+        var renderStateChanges = 0;
+        var stateNames = pass.stateNames;
+        var stateValues = pass.stateValues;
+        var numStates = stateNames.length;
+        var n, name;
+        for (n = 0; n < numStates; n += 1)
+        {
+            name = stateNames[n];
+            if (renderStates[name] !== stateValues[n])
+            {
+                renderStates[name] = stateValues[n];
+                renderStateChanges += 1;
+            }
+        }
+        if (lastPass)
+        {
+            var passStates = pass.states;
+            stateNames = lastPass.stateNames;
+            numStates = stateNames.length;
+            for (n = 0; n < numStates; n += 1)
+            {
+                name = stateNames[n];
+                if (passStates[name] === undefined &&
+                    renderStates[name] !== undefined)
+                {
+                    renderStates[name] = undefined;
+                    renderStateChanges += 1;
+                }
+            }
+        }
+        this.metrics.renderStateChanges += renderStateChanges;
+    }
+
+    // Counts the values of techniqueParameters used by the active pass
+    _setParameters(techniqueParameters: TechniqueParameters): void
+    {
+        var passParameters = this._activePass.parameters;
+        var boundTextures = this._boundTextures;
+        var metrics = this.metrics;
+        for (var p in techniqueParameters)
+        {
+            var sampler = passParameters[p];
+            if (sampler !== undefined)
+            {
+                var value = techniqueParameters[p];
+                if (value !== undefined)
+                {
+                    if (sampler)
+                    {
+                        if (boundTextures[p] !== value)
+                        {
+                            boundTextures[p] = value;
+                            metrics.textureChanges += 1;
+                        }
+                    }
+                    else
+                    {
+                        metrics.uniformUploads += 1;
+                    }
+                }
+            }
+        }
+    }
+
+    setTechnique(technique: Technique): void
+    {
+        this._setTechnique(<NullTechnique>technique);
+    }
+
+    setTechniqueParameters(): void
+    {
+        var activePass = this._activePass;
+        if (activePass)
+        {
+            var numTechniqueParameters = arguments.length;
+            for (var t = 0; t < numTechniqueParameters; t += 1)
+            {
+                var techniqueParameters = arguments[t];
+                if (techniqueParameters)
+                {
+                    this._setParameters(techniqueParameters);
+                    this.metrics.techniqueParametersChanges += 1;
+                }
+            }
+        }
+    }
+
+    setStream(vertexBuffer: VertexBuffer, semantics: Semantics, offset?: number): void
+    {
+        var metrics = this.metrics;
+        metrics.vertexBufferChanges += 1;
+        metrics.vertexAttributesChanges += semantics.length;
+    }
+
+    setInstanceStream(vertexBuffer: VertexBuffer, semantics: Semantics, offset?: number): void
+    {
+        this.setStream(vertexBuffer, semantics, offset);
+    }
+
+    setIndexBuffer(indexBuffer: IndexBuffer): void
+    {
+        if (this._activeIndexBuffer !== indexBuffer)
+        {
+            this._activeIndexBuffer = <NullIndexBuffer>indexBuffer;
+            this.metrics.indexBufferChanges += 1;
+        }
+    }
+
+    drawIndexed(primitive: number, numIndices: number, first?: number): void
+    {
+        this._addPrimitives(primitive, numIndices);
+    }
+
+    draw(primitive: number, numVertices: number, first?: number): void
+    {
+        this._addPrimitives(primitive, numVertices);
+    }
+
+    drawIndexedInstanced(primitive: number, numIndices: number, numInstances: number, first?: number): void
+    {
+        this._addPrimitives(primitive, numIndices, numInstances);
+    }
+
+    drawInstanced(primitive: number, numVertices: number, numInstances: number, first?: number): void
+    {
+        this._addPrimitives(primitive, numVertices, numInstances);
+    }
+
+    // Walks the draw parameters like WebGLGraphicsDevice.drawArray does,
+    // counting the calls it would have made. Sorting uses Array.sort.
+    drawArray(drawParametersArray: DrawParameters[],
+              globalTechniqueParametersArray: TechniqueParameters[],
+              sortMode?: number): void
+    {
+        var numDrawParameters = drawParametersArray.length;
+        if (numDrawParameters > 1 && sortMode)
+        {
+            if (sortMode > 0)
+            {
+                drawParametersArray.sort(function drawArraySortPositive(a, b) {
+                    return (b.sortKey - a.sortKey);
+                });
+            }
+            else if (sortMode < 0)
+            {
+                drawParametersArray.sort(function drawArraySortNegative(a, b) {
+                    return (a.sortKey - b.sortKey);
+                });
+            }
+        }
+
+        if (this._numInstancedTechniques)
+        {
+            drawParametersArray = this._batchInstances(drawParametersArray);
+            numDrawParameters = drawParametersArray.length;
+        }
+
+        var metrics = this.metrics;
+        var numGlobalTechniqueParameters = globalTechniqueParametersArray.length;
+        var lastTechnique = null;
+        var lastDrawParameters = null;
+        var lastEndStreams = -1;
+        var numPasses = 1;
+        var n, p, t, v, streamsMatch;
+
+        for (n = 0; n < numDrawParameters; n += 1)
+        {
+            var drawParameters = <NullDrawParameters>drawParametersArray[n];
+            var technique = <NullTechnique>drawParameters.technique;
+            var endTechniqueParameters = drawParameters._endTechniqueParameters;
+            var endStreams = drawParameters._endStreams;
+            var endInstances = drawParameters._endInstances;
+            var indexBuffer = drawParameters.indexBuffer;
+            var primitive = drawParameters.primitive;
+            var count = drawParameters.count;
+            var instanceCount = drawParameters.instanceCount;
+
+            if (lastTechnique !== technique)
+            {
+                lastTechnique = technique;
+                this._setTechnique(technique);
+                numPasses = technique.numPasses;
+
+                for (t = 0; t < numGlobalTechniqueParameters; t += 1)
+                {
+                    this._setParameters(globalTechniqueParametersArray[t]);
+                }
+            }
+
+            for (t = (16 * 3); t < endTechniqueParameters; t += 1)
+            {
+                if (drawParameters[t])
+                {
+                    this._setParameters(drawParameters[t]);
+                }
+            }
+
+            streamsMatch = (lastEndStreams === endStreams &&
+                            lastDrawParameters._instanceStreams === drawParameters._instanceStreams);
+            for (v = 0; streamsMatch && v < endStreams; v += 3)
+            {
+                streamsMatch = (lastDrawParameters[v]     === drawParameters[v]     &&
+                                lastDrawParameters[v + 1] === drawParameters[v + 1] &&
+                                lastDrawParameters[v + 2] === drawParameters[v + 2]);
+            }
+            if (!streamsMatch)
+            {
+                lastEndStreams = endStreams;
+                for (v = 0; v < endStreams; v += 3)
+                {
+                    if (drawParameters[v])
+                    {
+                        metrics.vertexBufferChanges += 1;
+                        metrics.vertexAttributesChanges += drawParameters[v + 1].length;
+                    }
+                }
+            }
+            lastDrawParameters = drawParameters;
+
+            if (indexBuffer)
+            {
+                this.setIndexBuffer(indexBuffer);
+            }
+
+            for (p = 0; p < numPasses; p += 1)
+            {
+                t = ((16 * 3) + 8);
+                if (t < endInstances)
+                {
+                    do
+                    {
+                        this._setParameters(drawParameters[t]);
+                        this._addPrimitives(primitive, count);
+                        t += 1;
+                    }
+                    while (t < endInstances);
+                }
+                else
+                {
+                    this._addPrimitives(primitive, count, instanceCount);
+                }
+            }
+        }
+    }
+
+    setTechniqueInstancing(technique: Technique,
+                           instancing: TechniqueInstancingParameters): boolean
+    {
+        if (instancing)
+        {
+            if (!this.isSupported("INSTANCED_ARRAYS"))
+            {
+                return false;
+            }
+            if (!this._instancedTechniques[technique.id])
+            {
+                this._numInstancedTechniques += 1;
+            }
+            this._instancedTechniques[technique.id] = {
+                technique: instancing.technique,
+                parameters: instancing.parameters.slice(),
+                semantics: instancing.semantics,
+                minInstances: (instancing.minInstances || 2)
+            };
+        }
+        else if (this._instancedTechniques[technique.id])
+        {
+            delete this._instancedTechniques[technique.id];
+            this._numInstancedTechniques -= 1;
+        }
+        return true;
+    }
+
+    // Same test as WebGLGraphicsDevice._canBatchInstance
+    _canBatchInstance(first: NullDrawParameters,
+                      drawParameters: NullDrawParameters,
+                      instanceParameters: string[]): boolean
+    {
+        var endStreams = first._endStreams;
+        var endTechniqueParameters = first._endTechniqueParameters;
+        if (first.technique !== drawParameters.technique ||
+            first.indexBuffer !== drawParameters.indexBuffer ||
+            first.primitive !== drawParameters.primitive ||
+            first.count !== drawParameters.count ||
+            first.firstIndex !== drawParameters.firstIndex ||
+            endStreams !== drawParameters._endStreams ||
+            endTechniqueParameters !== drawParameters._endTechniqueParameters ||
+            drawParameters._endInstances !== ((16 * 3) + 8) ||
+            drawParameters._instanceStreams !== 0 ||
+            drawParameters.instanceCount !== 0)
+        {
+            return false;
+        }
+
+        var v;
+        for (v = 0; v < endStreams; v += 1)
+        {
+            if (first[v] !== drawParameters[v])
+            {
+                return false;
+            }
+        }
+
+        var t, p;
+        for (t = (16 * 3); t < endTechniqueParameters; t += 1)
+        {
+            var firstParameters = first[t];
+            var techniqueParameters = drawParameters[t];
+            if (firstParameters !== techniqueParameters)
+            {
+                if (!firstParameters || !techniqueParameters)
+                {
+                    return false;
+                }
+
+                for (p in techniqueParameters)
+                {
+                    if (firstParameters[p] !== techniqueParameters[p] &&
+                        instanceParameters.indexOf(p) === -1)
+                    {
+                        return false;
+                    }
+                }
+
+                for (p in firstParameters)
+                {
+                    if (techniqueParameters[p] === undefined &&
+                        firstParameters[p] !== undefined)
+                    {
+                        return false;
+                    }
+                }
+            }
+        }
+
+        return true;
+    }
+
+    // The batch draws the technique of the instancing with an extra per
+    // instance stream. The instance data is not built, only its upload of
+    // whole FLOAT4 attributes per instance is counted.
+    _createInstanceBatch(instancing: TechniqueInstancingParameters,
+                         first: NullDrawParameters,
+                         numInstances: number): NullDrawParameters
+    {
+        var index = this._numInstanceBatches;
+        var batch = this._instanceBatches[index];
+        if (!batch)
+        {
+            batch = this._instanceBatches[index] = NullDrawParameters.create();
+            this._instanceVertexBuffers[index] = NullVertexBuffer.create(this, {
+                numVertices: 0,
+                attributes: [],
+                dynamic: true
+            });
+        }
+        this._numInstanceBatches += 1;
+
+        var parameters = instancing.parameters;
+        var numParameters = parameters.length;
+        var endTechniqueParameters = first._endTechniqueParameters;
+        var size = 0;
+        var p, t;
+        for (p = 0; p < numParameters; p += 1)
+        {
+            for (t = (endTechniqueParameters - 1); t >= (16 * 3); t -= 1)
+            {
+                var techniqueParameters = first[t];
+                if (techniqueParameters && techniqueParameters[parameters[p]] !== undefined)
+                {
+                    var value = techniqueParameters[parameters[p]];
+                    size += (typeof value === "number" ? 1 : value.length);
+                    break;
+                }
+            }
+        }
+        this.metrics.bufferBytes += (numInstances * Math.ceil(size / 4) * 16);
+
+        first.clone(batch);
+        batch.technique = instancing.technique;
+        batch.instanceCount = numInstances;
+
+        var endStreams = first._endStreams;
+        batch[endStreams] = this._instanceVertexBuffers[index];
+        batch[endStreams + 1] = instancing.semantics;
+        batch[endStreams + 2] = 0;
+        batch._endStreams = (endStreams + 3);
+        /* tslint:disable:no-bitwise */
+        batch._instanceStreams = (1 << (endStreams / 3));
+        /* tslint:enable:no-bitwise */
+        return batch;
+    }
+
+    // Replaces the runs of draw parameters that can be instanced by their
+    // batches, like WebGLGraphicsDevice._batchInstances
+    _batchInstances(drawParametersArray: DrawParameters[]): DrawParameters[]
+    {
+        var instancedTechniques = this._instancedTechniques;
+        var batchedDrawParameters = this._batchedDrawParameters;
+        var numDrawParameters = drawParametersArray.length;
+        var numBatched = 0;
+        var n = 0;
+        while (n < numDrawParameters)
+        {
+            var drawParameters = <NullDrawParameters>drawParametersArray[n];
+            var instancing = instancedTechniques[drawParameters.technique.id];
+            var end = (n + 1);
+            if (instancing &&
+                drawParameters._endInstances === ((16 * 3) + 8) &&
+                drawParameters._instanceStreams === 0 &&
+                drawParameters.instanceCount === 0)
+            {
+                while (end < numDrawParameters &&
+                       this._canBatchInstance(drawParameters, <NullDrawParameters>drawParametersArray[end],
+                                              instancing.parameters))
+                {
+                    end += 1;
+                }
+            }
+
+            if (instancing && instancing.minInstances <= (end - n))
+            {
+                batchedDrawParameters[numBatched] = this._createInstanceBatch(instancing, drawParameters, (end - n));
+                numBatched += 1;
+                n = end;
+            }
+            else
+            {
+                do
+                {
+                    batchedDrawParameters[numBatched] = <NullDrawParameters>drawParametersArray[n];
+                    numBatched += 1;
+                    n += 1;
+                }
+                while (n < end);
+            }
+        }
+        batchedDrawParameters.length = numBatched;
+        return batchedDrawParameters;
+    }
+
+    beginDraw(primitive: number, numVertices: number, formats: any[],
+              semantics: Semantics): VertexWriteIterator
+    {
+        var stride = 0;
+        var numFormats = formats.length;
+        for (var n = 0; n < numFormats; n += 1)
+        {
+            var format = formats[n];
+            if (typeof format === "string")
+            {
+                format = this['VERTEXFORMAT_' + format];
+            }
+            stride += format.stride;
+        }
+
+        this._immediatePrimitive = primitive;
+
+        var writer: any = function nullDrawWriteFn()
+        {
+            writer.numWritten += 1;
+        };
+        writer.write = writer;
+        writer.numWritten = 0;
+        writer.numVertices = numVertices;
+        writer.stride = stride;
+        this._immediateWriter = writer;
+        return writer;
+    }
+
+    endDraw(writer: VertexWriteIterator): void
+    {
+        var immediateWriter = this._immediateWriter;
+        if (immediateWriter && immediateWriter === writer)
+        {
+            this.metrics.bufferBytes += (immediateWriter.numWritten * immediateWriter.stride);
+            this._addPrimitives(this._immediatePrimitive, immediateWriter.numVertices);
+        }
+        this._immediateWriter = null;
+    }
+
+    beginRenderTarget(renderTarget: RenderTarget): boolean
+    {
+        debug.assert(!this._activeRenderTarget,
+                     "beginRenderTarget called before calling endRenderTarget on current render target");
+        this._activeRenderTarget = <NullRenderTarget>renderTarget;
+        this.metrics.renderTargetChanges += 1;
+        return true;
+    }
+
+    endRenderTarget(): void
+    {
+        this._activeRenderTarget = null;
+    }
+
+    beginOcclusionQuery(occlusionQuery: OcclusionQuery): boolean
+    {
+        return false;
+    }
+
+    endOcclusionQuery(): void
+    {
+        return;
+    }
+
+    beginTimerQuery(timerQuery: TimerQuery): boolean
+    {
+        return false;
+    }
+
+    endTimerQuery(): void
+    {
+        return;
+    }
+
+    clear(clearColor: number[], clearDepth?: number, clearStencil?: number): void
+    {
+        this.metrics.clears += 1;
+    }
+
+    setViewport(x: number, y: number, width: number, height: number): void
+    {
+        this.metrics.renderStateChanges += 1;
+    }
+
+    setScissor(x: number, y: number, width: number, height: number): void
+    {
+        this.metrics.renderStateChanges += 1;
+    }
+
+    createVertexBuffer(params: VertexBufferParameters): VertexBuffer
+    {
+        return NullVertexBuffer.create(this, params);
+    }
+
+    createIndexBuffer(params: IndexBufferParameters): IndexBuffer
+    {
+        return NullIndexBuffer.create(this, params);
+    }
+
+    createTexture(params: TextureParameters): Texture
+    {
+        return NullTexture.create(this, params);
+    }
+
+    createShader(params: any, onload?: { (shader: Shader): void; }): Shader
+    {
+        if (typeof params === "string")
+        {
+            params = JSON.parse(params);
+        }
+        return NullShader.create(this, params, onload);
+    }
+
+    createSemantics(attributes: any[]): Semantics
+    {
+        return NullSemantics.create(this, attributes);
+    }
+
+    createDrawParameters(): DrawParameters
+    {
+        return NullDrawParameters.create();
+    }
+
+    createTechniqueParameters(params?: any): TechniqueParameters
+    {
+        return NullTechniqueParameters.create(params);
+    }
+
+    createTechniqueParameterBuffer(params: TechniqueParameterBufferParameters): TechniqueParameterBuffer
+    {
+        // See vmath.ts
+        return _tz_techniqueParameterBufferCreate(params);
+    }
+
+    createRenderBuffer(params: RenderBufferParameters): RenderBuffer
+    {
+        return NullRenderBuffer.create(this, params);
+    }
+
+    createRenderTarget(params: RenderTargetParameters): RenderTarget
+    {
+        return NullRenderTarget.create(this, params);
+    }
+
+    createOcclusionQuery(): OcclusionQuery
+    {
+        return null;
+    }
+
+    createTimerQuery(): TimerQuery
+    {
+        return null;
+    }
+
+    createVideo(params: VideoParameters): Video
+    {
+        return null;
+    }
+
+    isSupported(name: string): boolean
+    {
+        return !!this._features[name];
+    }
+
+    maxSupported(name: string): number
+    {
+        return (this._features[name] || 0);
+    }
+
+    // The archive contents are unknown, no textures are reported
+    loadTexturesArchive(params: TextureArchiveParams): boolean
+    {
+        var onload = params.onload;
+        if (onload)
+        {
+            TurbulenzEngine.setTimeout(function nullArchiveLoadedFn()
+            {
+                onload(true, 200);
+            }, 0);
+        }
+        return true;
+    }
+
+    getScreenshot(compress: boolean, x?: number, y?: number,
+                  width?: number, height?: number): any
+    {
+        return null;
+    }
+
+    flush(): void
+    {
+        return;
+    }
+
+    finish(): void
+    {
+        return;
+    }
+
+    destroy(): void
+    {
+        this._activeTechnique = null;
+        this._activePass = null;
+        this._activeIndexBuffer = null;
+        this._activeRenderTarget = null;
+        this._renderStates = null;
+        this._boundTextures = null;
+        this._instancedTechniques = null;
+        this._instanceBatches = null;
+        this._instanceVertexBuffers = null;
+        this._batchedDrawParameters = null;
+        this._immediateWriter = null;
+    }
+
+    static create(params?: NullGraphicsDeviceParameters): NullGraphicsDevice
+    {
+        params = (params || {});
+
+        var gd = new NullGraphicsDevice();
+        gd.width = (params.width || 1280);
+        gd.height = (params.height || 720);
+        gd.desktopWidth = gd.width;
+        gd.desktopHeight = gd.height;
+        gd.extensions = "";
+        gd.shadingLanguageVersion = "1.00";
+        gd.fullscreen = false;
+        gd.rendererVersion = "1.0";
+        gd.renderer = "Null";
+        gd.vendor = "Turbulenz";
+        gd.videoRam = 0;
+        gd.fps = 0;
+        gd.shaderLinkTime = 2;
+
+        gd._counters = {
+            textures: 0,
+            vertexBuffers: 0,
+            indexBuffers: 0,
+            renderTargets: 0,
+            renderBuffers: 0,
+            shaders: 0,
+            techniques: 0
+        };
+
+        // Defaults describe a typical desktop WebGL implementation
+        var features = {
+            OCCLUSION_QUERIES: false,
+            TIMER_QUERIES: false,
+            NPOT_MIPMAPPED_TEXTURES: false,
+            TEXTURE_DXT1: true,
+            TEXTURE_DXT3: true,
+            TEXTURE_DXT5: true,
+            TEXTURE_ETC1: false,
+            TEXTURE_FLOAT: true,
+            TEXTURE_HALF_FLOAT: true,
+            INDEXFORMAT_UINT: true,
+            FILEFORMAT_WEBM: false,
+            FILEFORMAT_MP4: false,
+            FILEFORMAT_M4V: false,
+            FILEFORMAT_JPG: true,
+            FILEFORMAT_PNG: true,
+            FILEFORMAT_DDS: true,
+            FILEFORMAT_TGA: true,
+            DEPTH_TEXTURE: true,
+            STANDARD_DERIVATIVES: true,
+            INSTANCED_ARRAYS: false,
+            PARALLEL_SHADER_COMPILE: false,
+            ANISOTROPY: 16,
+            TEXTURE_SIZE: 8192,
+            CUBEMAP_TEXTURE_SIZE: 8192,
+            RENDERTARGET_COLOR_TEXTURES: 4,
+            RENDERBUFFER_SIZE: 8192,
+            TEXTURE_UNITS: 16,
+            VERTEX_TEXTURE_UNITS: 4,
+            VERTEX_SHADER_PRECISION: 23,
+            FRAGMENT_SHADER_PRECISION: 23
+        };
+        var overrides = params.features;
+        if (overrides)
+        {
+            for (var f in overrides)
+            {
+                if (overrides.hasOwnProperty(f))
+                {
+                    features[f] = overrides[f];
+                }
+            }
+        }
+        gd._features = features;
+
+        gd.metrics = <NullGraphicsDeviceMetrics>{};
+        gd.resetMetrics();
+
+        gd._activeTechnique = null;
+        gd._activePass = null;
+        gd._activeIndexBuffer = null;
+        gd._activeRenderTarget = null;
+        gd._renderStates = {};
+        gd._boundTextures = {};
+        gd._instancedTechniques = {};
+        gd._numInstancedTechniques = 0;
+        gd._instanceBatches = [];
+        gd._instanceVertexBuffers = [];
+        gd._numInstanceBatches = 0;
+        gd._batchedDrawParameters = [];
+        gd._immediatePrimitive = -1;
+        gd._immediateWriter = null;
+
+        return gd;
+    }
+}
+
+(function nullGraphicsDeviceSetupFn()
+{
+    var proto = NullGraphicsDevice.prototype;
+
+    // Same values as the WebGL device, the GL enums for primitives and index formats
+    proto.PRIMITIVE_POINTS         = 0x0000;
+    proto.PRIMITIVE_LINES          = 0x0001;
+    proto.PRIMITIVE_LINE_LOOP      = 0x0002;
+    proto.PRIMITIVE_LINE_STRIP     = 0x0003;
+    proto.PRIMITIVE_TRIANGLES      = 0x0004;
+    proto.PRIMITIVE_TRIANGLE_STRIP = 0x0005;
+    proto.PRIMITIVE_TRIANGLE_FAN   = 0x0006;
+
+    proto.INDEXFORMAT_UBYTE  = 0x1401;
+    proto.INDEXFORMAT_USHORT = 0x1403;
+    proto.INDEXFORMAT_UINT   = 0x1405;
+
+    var makeVertexformat = function makeVertexformatFn(n, c, s, f, name): NullVertexFormat
+    {
+        return {
+            numComponents: c,
+            stride: s,
+            componentStride: (s / c),
+            format: f,
+            name: name,
+            normalized: !!n,
+            normalizationScale: 1
+        };
+    };
+
+    proto.VERTEXFORMAT_BYTE4    = makeVertexformat(0, 4,  4, 0x1400, 'BYTE4');
+    proto.VERTEXFORMAT_UBYTE4   = makeVertexformat(0, 4,  4, 0x1401, 'UBYTE4');
+    proto.VERTEXFORMAT_SHORT2   = makeVertexformat(0, 2,  4, 0x1402, 'SHORT2');
+    proto.VERTEXFORMAT_SHORT4   = makeVertexformat(0, 4,  8, 0x1402, 'SHORT4');
+    proto.VERTEXFORMAT_USHORT2  = makeVertexformat(0, 2,  4, 0x1403, 'USHORT2');
+    proto.VERTEXFORMAT_USHORT4  = makeVertexformat(0, 4,  8, 0x1403, 'USHORT4');
+    proto.VERTEXFORMAT_BYTE4N   = makeVertexformat(1, 4,  4, 0x1400, 'BYTE4N');
+    proto.VERTEXFORMAT_UBYTE4N  = makeVertexformat(1, 4,  4, 0x1401, 'UBYTE4N');
+    proto.VERTEXFORMAT_SHORT2N  = makeVertexformat(1, 2,  4, 0x1402, 'SHORT2N');
+    proto.VERTEXFORMAT_SHORT4N  = makeVertexformat(1, 4,  8, 0x1402, 'SHORT4N');
+    proto.VERTEXFORMAT_USHORT2N = makeVertexformat(1, 2,  4, 0x1403, 'USHORT2N');
+    proto.VERTEXFORMAT_USHORT4N = makeVertexformat(1, 4,  8, 0x1403, 'USHORT4N');
+    proto.VERTEXFORMAT_FLOAT1   = makeVertexformat(0, 1,  4, 0x1406, 'FLOAT1');
+    proto.VERTEXFORMAT_FLOAT2   = makeVertexformat(0, 2,  8, 0x1406, 'FLOAT2');
+    proto.VERTEXFORMAT_FLOAT3   = makeVertexformat(0, 3, 12, 0x1406, 'FLOAT3');
+    proto.VERTEXFORMAT_FLOAT4   = makeVertexformat(0, 4, 16, 0x1406, 'FLOAT4');
+
+    proto.DEFAULT_SAMPLER = {
+        minFilter : 0x2703, // LINEAR_MIPMAP_LINEAR
+        magFilter : 0x2601, // LINEAR
+        wrapS : 0x2901, // REPEAT
+        wrapT : 0x2901,
+        wrapR : 0x2901,
+        maxAnisotropy : 1
+    };
+
+    proto.SEMANTIC_POSITION = 0;
+    proto.SEMANTIC_POSITION0 = 0;
+    proto.SEMANTIC_BLENDWEIGHT = 1;
+    proto.SEMANTIC_BLENDWEIGHT0 = 1;
+    proto.SEMANTIC_NORMAL = 2;
+    proto.SEMANTIC_NORMAL0 = 2;
+    proto.SEMANTIC_COLOR = 3;
+    proto.SEMANTIC_COLOR0 = 3;
+    proto.SEMANTIC_COLOR1 = 4;
+    proto.SEMANTIC_SPECULAR = 4;
+    proto.SEMANTIC_FOGCOORD = 5;
+    proto.SEMANTIC_TESSFACTOR = 5;
+    proto.SEMANTIC_PSIZE0 = 6;
+    proto.SEMANTIC_BLENDINDICES = 7;
+    proto.SEMANTIC_BLENDINDICES0 = 7;
+    proto.SEMANTIC_TEXCOORD = 8;
+    proto.SEMANTIC_TEXCOORD0 = 8;
+    proto.SEMANTIC_TEXCOORD1 = 9;
+    proto.SEMANTIC_TEXCOORD2 = 10;
+    proto.SEMANTIC_TEXCOORD3 = 11;
+    proto.SEMANTIC_TEXCOORD4 = 12;
+    proto.SEMANTIC_TEXCOORD5 = 13;
+    proto.SEMANTIC_TEXCOORD6 = 14;
+    proto.SEMANTIC_TEXCOORD7 = 15;
+    proto.SEMANTIC_TANGENT = 14;
+    proto.SEMANTIC_TANGENT0 = 14;
+    proto.SEMANTIC_BINORMAL0 = 15;
+    proto.SEMANTIC_BINORMAL = 15;
+    proto.SEMANTIC_PSIZE = 6;
+    proto.SEMANTIC_ATTR0 = 0;
+    proto.SEMANTIC_ATTR1 = 1;
+    proto.SEMANTIC_ATTR2 = 2;
+    proto.SEMANTIC_ATTR3 = 3;
+    proto.SEMANTIC_ATTR4 = 4;
+    proto.SEMANTIC_ATTR5 = 5;
+    proto.SEMANTIC_ATTR6 = 6;
+    proto.SEMANTIC_ATTR7 = 7;
+    proto.SEMANTIC_ATTR8 = 8;
+    proto.SEMANTIC_ATTR9 = 9;
+    proto.SEMANTIC_ATTR10 = 10;
+    proto.SEMANTIC_ATTR11 = 11;
+    proto.SEMANTIC_ATTR12 = 12;
+    proto.SEMANTIC_ATTR13 = 13;
+    proto.SEMANTIC_ATTR14 = 14;
+    proto.SEMANTIC_ATTR15 = 15;
+
+    proto.PIXELFORMAT_A8 = 0;
+    proto.PIXELFORMAT_L8 = 1;
+    proto.PIXELFORMAT_L8A8 = 2;
+    proto.PIXELFORMAT_R5G5B5A1 = 3;
+    proto.PIXELFORMAT_R5G6B5 = 4;
+    proto.PIXELFORMAT_R4G4B4A4 = 5;
+    proto.PIXELFORMAT_R8G8B8A8 = 6;
+    proto.PIXELFORMAT_R8G8B8 = 7;
+    proto.PIXELFORMAT_D24S8 = 8;
+    proto.PIXELFORMAT_D16 = 9;
+    proto.PIXELFORMAT_DXT1 = 10;
+    proto.PIXELFORMAT_DXT3 = 11;
+    proto.PIXELFORMAT_DXT5 = 12;
+    proto.PIXELFORMAT_S8 = 13;
+    proto.PIXELFORMAT_RGBA32F = 14;
+    proto.PIXELFORMAT_RGB32F = 15;
+    proto.PIXELFORMAT_RGBA16F = 16;
+    proto.PIXELFORMAT_RGB16F = 17;
+    proto.PIXELFORMAT_D32 = 18;
+}());
@@ -555,6 +555,9 @@ class SizeTree<T>
 // Although intended for use with integer w/h (in which case x/y would also be integer in results)
 // There is no reason for this not to be used with any finite strictly positive w/h
 //
+// The atlaspack tool (tools/atlaspack/rectpacker.h) has a native port of this packer used by its
+// --online option, changes to the cost function or to the split and grow rules should be made to both.
+//
 // The type actually returned from public API:
 interface PackedRect
 {
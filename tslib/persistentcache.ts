@@ -0,0 +1,822 @@
+// Copyright (c) 2015 Turbulenz Limited
+
+/*global window: false*/
+/*global TurbulenzEngine: false*/
+
+interface PersistentCacheOnLoadFn { (cache: PersistentCache): void; };
+
+interface PersistentCacheOnDataFn { (data: Uint8Array, status: number): void; };
+
+interface PersistentCacheParams
+{
+    name?        : string;  // database name
+    maxBytes?    : number;
+    verifyReads? : boolean; // check the hash of the data read back
+    onload?      : PersistentCacheOnLoadFn;
+};
+
+interface PersistentCacheEntry
+{
+    url      : string;
+    bytes    : number;
+    lastUsed : number;
+    // Least recently used list, not stored
+    prev     : PersistentCacheEntry;
+    next     : PersistentCacheEntry;
+};
+
+interface PersistentCacheMetrics
+{
+    hits              : number;
+    misses            : number;
+    stores            : number;
+    evictions         : number;
+    integrityFailures : number;
+    numEntries        : number;
+    bytes             : number;
+};
+
+//
+// PersistentCache
+//
+// Keeps the data of content hashed URLs, as returned by
+// MappingTable.getURL, in IndexedDB so they can be loaded again on later
+// sessions without any network request. The file name of those URLs is
+// the MD5 digest of their data encoded as URL safe base64, the data is
+// checked against it before being stored and when it is read back.
+//
+class PersistentCache
+{
+    /* tslint:disable:no-unused-variable */
+    static version = 1;
+    /* tslint:enable:no-unused-variable */
+
+    static dataStoreName = "data";
+    static entryStoreName = "entries";
+
+    name        : string;
+    maxBytes    : number;
+    verifyReads : boolean;
+    metrics     : PersistentCacheMetrics;
+
+    private db       : any; // IDBDatabase
+    private isOpen   : boolean;
+    private pending  : { (): void; }[]; // requests made while opening
+    private entries  : { [url: string]: PersistentCacheEntry; };
+    private useCounter : number;
+
+    // Least recently used first
+    private lruHead  : PersistentCacheEntry;
+    private lruTail  : PersistentCacheEntry;
+
+    // Returns true if the URL is content hashed and can be cached
+    canStore(url: string): boolean
+    {
+        return ((!this.isOpen || this.db !== null) &&
+                PersistentCache.getHash(url) !== null);
+    }
+
+    exists(url: string): boolean
+    {
+        return this.entries.hasOwnProperty(url);
+    }
+
+    // Loads the data of the URL from the cache, or from the network if
+    // missing or corrupted. Data received from the network is stored if it
+    // matches the hash of the URL. onload is called with null data and the
+    // status of the request on failure.
+    request(url: string, onload: PersistentCacheOnDataFn)
+    {
+        var that = this;
+        if (!this.isOpen)
+        {
+            this.pending.push(function pendingRequestFn()
+                              {
+                                  that.request(url, onload);
+                              });
+            return;
+        }
+
+        var entry = this.entries[url];
+        if (!entry)
+        {
+            this.metrics.misses += 1;
+            this._fetch(url, onload);
+            return;
+        }
+
+        var onFailed = function onReadFailedFn()
+        {
+            that.metrics.integrityFailures += 1;
+            that.remove(url);
+            that.metrics.misses += 1;
+            that._fetch(url, onload);
+        };
+
+        var transaction;
+        try
+        {
+            transaction = this.db.transaction([PersistentCache.dataStoreName], "readonly");
+        }
+        catch (e)
+        {
+            onFailed();
+            return;
+        }
+
+        var dataRequest = transaction.objectStore(PersistentCache.dataStoreName).get(url);
+        dataRequest.onsuccess = function onDataReadFn()
+        {
+            var result = dataRequest.result;
+            if (!result)
+            {
+                onFailed();
+                return;
+            }
+
+            var data = new Uint8Array(result);
+            if (that.verifyReads &&
+                PersistentCache.computeHash(data) !== PersistentCache.getHash(url))
+            {
+                onFailed();
+                return;
+            }
+
+            that.metrics.hits += 1;
+            that._touch(entry);
+            onload(data, 200);
+        };
+        dataRequest.onerror = onFailed;
+    }
+
+    remove(url: string)
+    {
+        var entry = this.entries[url];
+        if (entry)
+        {
+            delete this.entries[url];
+            this._unlink(entry);
+
+            var metrics = this.metrics;
+            metrics.numEntries -= 1;
+            metrics.bytes -= entry.bytes;
+
+            this._write(function removeEntryFn(dataStore, entryStore)
+                        {
+                            dataStore["delete"](url);
+                            entryStore["delete"](url);
+                        });
+        }
+    }
+
+    clear()
+    {
+        this.entries = {};
+        this.lruHead = null;
+        this.lruTail = null;
+
+        var metrics = this.metrics;
+        metrics.numEntries = 0;
+        metrics.bytes = 0;
+
+        this._write(function clearStoresFn(dataStore, entryStore)
+                    {
+                        dataStore.clear();
+                        entryStore.clear();
+                    });
+    }
+
+    resetMetrics()
+    {
+        var metrics = this.metrics;
+        metrics.hits = 0;
+        metrics.misses = 0;
+        metrics.stores = 0;
+        metrics.evictions = 0;
+        metrics.integrityFailures = 0;
+    }
+
+    destroy()
+    {
+        if (this.db)
+        {
+            this.db.close();
+            this.db = null;
+        }
+        this.isOpen = true;
+        this._flushPending();
+        this.entries = {};
+        this.lruHead = null;
+        this.lruTail = null;
+    }
+
+    private _fetch(url: string, onload: PersistentCacheOnDataFn)
+    {
+        var that = this;
+        TurbulenzEngine.request(url, function fetchedFn(data, status)
+                                {
+                                    if (status === 200 && data)
+                                    {
+                                        // Stored before the data is handed over, its
+                                        // buffer could be transferred to a worker
+                                        if (PersistentCache.computeHash(data) === PersistentCache.getHash(url))
+                                        {
+                                            that._store(url, data);
+                                        }
+                                        else
+                                        {
+                                            that.metrics.integrityFailures += 1;
+                                        }
+                                        onload(data, status);
+                                    }
+                                    else
+                                    {
+                                        onload(null, status);
+                                    }
+                                }, true);
+    }
+
+    private _store(url: string, data: Uint8Array)
+    {
+        var bytes = data.length;
+        if (!this.db || bytes > this.maxBytes || this.entries[url])
+        {
+            return;
+        }
+
+        this._evict(this.maxBytes - bytes);
+
+        var entry = {
+            url: url,
+            bytes: bytes,
+            lastUsed: this.useCounter,
+            prev: null,
+            next: null
+        };
+        this.useCounter += 1;
+        this.entries[url] = entry;
+        this._link(entry);
+
+        var metrics = this.metrics;
+        metrics.stores += 1;
+        metrics.numEntries += 1;
+        metrics.bytes += bytes;
+
+        // IndexedDB copies the data when put is called
+        var buffer = data.buffer;
+        if (data.byteOffset !== 0 || data.byteLength !== buffer.byteLength)
+        {
+            buffer = buffer.slice(data.byteOffset, data.byteOffset + data.byteLength);
+        }
+
+        var that = this;
+        var transaction = this._write(function storeEntryFn(dataStore, entryStore)
+                                      {
+                                          dataStore.put(buffer, url);
+                                          entryStore.put(PersistentCache._record(entry));
+                                      });
+        if (transaction)
+        {
+            // Usually the storage quota was exceeded
+            transaction.onabort = function onStoreAbortFn()
+            {
+                if (that.entries[url] === entry)
+                {
+                    delete that.entries[url];
+                    that._unlink(entry);
+                    metrics.numEntries -= 1;
+                    metrics.bytes -= bytes;
+                }
+            };
+        }
+    }
+
+    // Removes the least recently used entries until they take maxBytes or less
+    private _evict(maxBytes: number)
+    {
+        var metrics = this.metrics;
+        while (metrics.bytes > maxBytes && this.lruHead)
+        {
+            this.remove(this.lruHead.url);
+            metrics.evictions += 1;
+        }
+    }
+
+    private _touch(entry: PersistentCacheEntry)
+    {
+        entry.lastUsed = this.useCounter;
+        this.useCounter += 1;
+
+        if (entry !== this.lruTail)
+        {
+            this._unlink(entry);
+            this._link(entry);
+        }
+
+        this._write(function touchEntryFn(dataStore, entryStore)
+                    {
+                        entryStore.put(PersistentCache._record(entry));
+                    });
+    }
+
+    private _link(entry: PersistentCacheEntry)
+    {
+        var tail = this.lruTail;
+        entry.prev = tail;
+        entry.next = null;
+        if (tail)
+        {
+            tail.next = entry;
+        }
+        else
+        {
+            this.lruHead = entry;
+        }
+        this.lruTail = entry;
+    }
+
+    private _unlink(entry: PersistentCacheEntry)
+    {
+        var prev = entry.prev;
+        var next = entry.next;
+        if (prev)
+        {
+            prev.next = next;
+        }
+        else
+        {
+            this.lruHead = next;
+        }
+        if (next)
+        {
+            next.prev = prev;
+        }
+        else
+        {
+            this.lruTail = prev;
+        }
+        entry.prev = null;
+        entry.next = null;
+    }
+
+    // The entry as stored in IndexedDB, without the list links
+    private static _record(entry: PersistentCacheEntry): any
+    {
+        return {
+            url: entry.url,
+            bytes: entry.bytes,
+            lastUsed: entry.lastUsed
+        };
+    }
+
+    private _write(writeFn: { (dataStore: any, entryStore: any): void; }): any
+    {
+        if (!this.db)
+        {
+            return null;
+        }
+
+        var transaction;
+        try
+        {
+            transaction = this.db.transaction([PersistentCache.dataStoreName,
+                                                PersistentCache.entryStoreName],
+                                               "readwrite");
+        }
+        catch (e)
+        {
+            return null;
+        }
+        writeFn(transaction.objectStore(PersistentCache.dataStoreName),
+                transaction.objectStore(PersistentCache.entryStoreName));
+        return transaction;
+    }
+
+    private _flushPending()
+    {
+        var pending = this.pending;
+        this.pending = [];
+        var numPending = pending.length;
+        var n;
+        for (n = 0; n < numPending; n += 1)
+        {
+            pending[n]();
+        }
+    }
+
+    private _onOpen(db: any, onload: PersistentCacheOnLoadFn)
+    {
+        var that = this;
+        var loaded = function loadedFn()
+        {
+            that.isOpen = true;
+            // The entries of an earlier session may take more than the budget
+            that._evict(that.maxBytes);
+            that._flushPending();
+            if (onload)
+            {
+                onload(that);
+            }
+        };
+
+        if (!db)
+        {
+            this.db = null;
+            loaded();
+            return;
+        }
+
+        this.db = db;
+
+        var entries = this.entries;
+        var metrics = this.metrics;
+        var loadedEntries = [];
+        var transaction = db.transaction([PersistentCache.entryStoreName], "readonly");
+        var cursorRequest = transaction.objectStore(PersistentCache.entryStoreName).openCursor();
+        cursorRequest.onsuccess = function onCursorFn()
+        {
+            var cursor = cursorRequest.result;
+            if (cursor)
+            {
+                var record = cursor.value;
+                var entry = {
+                    url: record.url,
+                    bytes: record.bytes,
+                    lastUsed: record.lastUsed,
+                    prev: null,
+                    next: null
+                };
+                entries[entry.url] = entry;
+                loadedEntries.push(entry);
+                metrics.numEntries += 1;
+                metrics.bytes += entry.bytes;
+                if (that.useCounter <= entry.lastUsed)
+                {
+                    that.useCounter = (entry.lastUsed + 1);
+                }
+                cursor["continue"]();
+            }
+            else
+            {
+                // Entries are read in URL order, the list is only sorted
+                // once per session
+                loadedEntries.sort(function sortEntriesFn(a, b)
+                                   {
+                                       return (a.lastUsed - b.lastUsed);
+                                   });
+                var numLoaded = loadedEntries.length;
+                var n;
+                for (n = 0; n < numLoaded; n += 1)
+                {
+                    that._link(loadedEntries[n]);
+                }
+                loaded();
+            }
+        };
+        cursorRequest.onerror = function onCursorErrorFn()
+        {
+            db.close();
+            that.db = null;
+            that.entries = {};
+            that.lruHead = null;
+            that.lruTail = null;
+            metrics.numEntries = 0;
+            metrics.bytes = 0;
+            loaded();
+        };
+    }
+
+    // Returns the hash in the file name of a content hashed URL, or null
+    static getHash(url: string): string
+    {
+        var end = url.search(/[?#]/);
+        if (end !== -1)
+        {
+            url = url.slice(0, end);
+        }
+        var fileName = url.slice(url.lastIndexOf("/") + 1);
+        var extension = fileName.indexOf(".");
+        if (extension !== -1)
+        {
+            fileName = fileName.slice(0, extension);
+        }
+        if (/^[A-Za-z0-9_\-]{22}$/.test(fileName))
+        {
+            return fileName;
+        }
+        return null;
+    }
+
+    // MD5 digest of the data encoded as URL safe base64 without padding
+    static computeHash(data: Uint8Array): string
+    {
+        /* tslint:disable:no-bitwise */
+        var K = PersistentCache.md5Constants;
+        var S = PersistentCache.md5Shifts;
+        var words = new Int32Array(16);
+        var h0 = 0x67452301;
+        var h1 = (0xefcdab89 | 0);
+        var h2 = (0x98badcfe | 0);
+        var h3 = 0x10325476;
+
+        var processBlock = function processBlockFn(bytes: Uint8Array, offset: number)
+        {
+            var i;
+            for (i = 0; i < 16; i += 1)
+            {
+                var o = (offset + (i << 2));
+                words[i] = (bytes[o] |
+                            (bytes[o + 1] << 8) |
+                            (bytes[o + 2] << 16) |
+                            (bytes[o + 3] << 24));
+            }
+
+            var a = h0;
+            var b = h1;
+            var c = h2;
+            var d = h3;
+            for (i = 0; i < 64; i += 1)
+            {
+                var f, g;
+                if (i < 16)
+                {
+                    f = ((b & c) | (~b & d));
+                    g = i;
+                }
+                else if (i < 32)
+                {
+                    f = ((d & b) | (~d & c));
+                    g = (((5 * i) + 1) & 15);
+                }
+                else if (i < 48)
+                {
+                    f = (b ^ c ^ d);
+                    g = (((3 * i) + 5) & 15);
+                }
+                else
+                {
+                    f = (c ^ (b | ~d));
+                    g = ((7 * i) & 15);
+                }
+                var x = ((a + f + K[i] + words[g]) | 0);
+                var s = S[i];
+                a = d;
+                d = c;
+                c = b;
+                b = ((b + ((x << s) | (x >>> (32 - s)))) | 0);
+            }
+
+            h0 = ((h0 + a) | 0);
+            h1 = ((h1 + b) | 0);
+            h2 = ((h2 + c) | 0);
+            h3 = ((h3 + d) | 0);
+        };
+
+        var numBytes = data.length;
+        var numFullBytes = (numBytes - (numBytes & 63));
+        var offset;
+        for (offset = 0; offset < numFullBytes; offset += 64)
+        {
+            processBlock(data, offset);
+        }
+
+        // Padding and length in bits, little endian
+        var tail = new Uint8Array(128);
+        var numTailBytes = (numBytes - numFullBytes);
+        tail.set(data.subarray(numFullBytes), 0);
+        tail[numTailBytes] = 0x80;
+        var tailLength = (numTailBytes < 56 ? 64 : 128);
+        var bitsLow = ((numBytes << 3) >>> 0);
+        var bitsHigh = Math.floor(numBytes / 0x20000000);
+        var n;
+        for (n = 0; n < 4; n += 1)
+        {
+            tail[tailLength - 8 + n] = ((bitsLow >>> (n << 3)) & 0xff);
+            tail[tailLength - 4 + n] = ((bitsHigh >>> (n << 3)) & 0xff);
+        }
+        for (offset = 0; offset < tailLength; offset += 64)
+        {
+            processBlock(tail, offset);
+        }
+
+        var digest = [h0, h1, h2, h3];
+        var chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+        var hash = "";
+        var bits = 0;
+        var numBits = 0;
+        for (n = 0; n < 16; n += 1)
+        {
+            bits = ((bits << 8) | ((digest[n >> 2] >>> ((n & 3) << 3)) & 0xff));
+            numBits += 8;
+            while (numBits >= 6)
+            {
+                numBits -= 6;
+                hash += chars[(bits >>> numBits) & 63];
+            }
+        }
+        hash += chars[(bits << (6 - numBits)) & 63];
+        /* tslint:enable:no-bitwise */
+        return hash;
+    }
+
+    static md5Shifts = [7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+                        5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20,
+                        4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+                        6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21];
+
+    static md5Constants = (function md5ConstantsFn()
+    {
+        var constants = new Int32Array(64);
+        var n;
+        for (n = 0; n < 64; n += 1)
+        {
+            constants[n] = (Math.floor(Math.abs(Math.sin(n + 1)) * 4294967296) | 0);
+        }
+        return constants;
+    }());
+
+    // Decodes UTF-8 data as returned by TurbulenzEngine.request, returns
+    // null if the data is not valid UTF-8
+    static decodeText(data: Uint8Array): string
+    {
+        var TextDecoder = window['TextDecoder'];
+        if (TextDecoder)
+        {
+            try
+            {
+                return new TextDecoder("utf-8", { fatal: true }).decode(data);
+            }
+            catch (e)
+            {
+                return null;
+            }
+        }
+
+        /* tslint:disable:no-bitwise */
+        var text = "";
+        var codes = [];
+        var numCodes = 0;
+        var numBytes = data.length;
+        var n = 0;
+        // The byte order mark is skipped like TextDecoder does
+        if (numBytes >= 3 && data[0] === 0xef && data[1] === 0xbb && data[2] === 0xbf)
+        {
+            n = 3;
+        }
+        while (n < numBytes)
+        {
+            var code = data[n];
+            var numExtra, minCode;
+            if (code < 0x80)
+            {
+                numExtra = 0;
+                minCode = 0;
+            }
+            else if (code < 0xc0)
+            {
+                return null;
+            }
+            else if (code < 0xe0)
+            {
+                numExtra = 1;
+                minCode = 0x80;
+                code &= 0x1f;
+            }
+            else if (code < 0xf0)
+            {
+                numExtra = 2;
+                minCode = 0x800;
+                code &= 0x0f;
+            }
+            else if (code < 0xf8)
+            {
+                numExtra = 3;
+                minCode = 0x10000;
+                code &= 0x07;
+            }
+            else
+            {
+                return null;
+            }
+
+            if ((n + numExtra) >= numBytes)
+            {
+                return null;
+            }
+            n += 1;
+            while (numExtra)
+            {
+                var extra = data[n];
+                if ((extra & 0xc0) !== 0x80)
+                {
+                    return null;
+                }
+                code = ((code << 6) | (extra & 0x3f));
+                n += 1;
+                numExtra -= 1;
+            }
+
+            // Overlong encodings, surrogates and values beyond Unicode
+            if (code < minCode ||
+                (0xd800 <= code && code < 0xe000) ||
+                code > 0x10ffff)
+            {
+                return null;
+            }
+
+            if (code < 0x10000)
+            {
+                codes[numCodes] = code;
+                numCodes += 1;
+            }
+            else
+            {
+                code -= 0x10000;
+                codes[numCodes] = (0xd800 | (code >>> 10));
+                codes[numCodes + 1] = (0xdc00 | (code & 0x3ff));
+                numCodes += 2;
+            }
+
+            // Converted in chunks to keep the argument list short
+            if (numCodes >= 4096)
+            {
+                codes.length = numCodes;
+                text += String.fromCharCode.apply(null, codes);
+                numCodes = 0;
+            }
+        }
+        /* tslint:enable:no-bitwise */
+
+        codes.length = numCodes;
+        return (text + String.fromCharCode.apply(null, codes));
+    }
+
+    static isSupported(): boolean
+    {
+        return (typeof window !== "undefined" &&
+                !!window.indexedDB &&
+                typeof Uint8Array !== "undefined");
+    }
+
+    // Constructor function, returns null if IndexedDB is not available.
+    // Requests made before the database is open wait for it.
+    static create(params: PersistentCacheParams): PersistentCache
+    {
+        if (!PersistentCache.isSupported())
+        {
+            return null;
+        }
+
+        var cache = new PersistentCache();
+        cache.name = params.name || "turbulenz-assets";
+        cache.maxBytes = params.maxBytes || (256 * 1024 * 1024);
+        cache.verifyReads = (params.verifyReads !== false);
+        cache.metrics = {
+            hits: 0,
+            misses: 0,
+            stores: 0,
+            evictions: 0,
+            integrityFailures: 0,
+            numEntries: 0,
+            bytes: 0
+        };
+        cache.db = null;
+        cache.isOpen = false;
+        cache.pending = [];
+        cache.entries = {};
+        cache.useCounter = 0;
+        cache.lruHead = null;
+        cache.lruTail = null;
+
+        var onload = params.onload;
+        var openRequest;
+        try
+        {
+            openRequest = window.indexedDB.open(cache.name, 1);
+        }
+        catch (e)
+        {
+            cache._onOpen(null, onload);
+            return cache;
+        }
+
+        openRequest.onupgradeneeded = function onUpgradeNeededFn()
+        {
+            var db = openRequest.result;
+            db.createObjectStore(PersistentCache.dataStoreName);
+            db.createObjectStore(PersistentCache.entryStoreName, { keyPath: "url" });
+        };
+        openRequest.onsuccess = function onOpenFn()
+        {
+            cache._onOpen(openRequest.result, onload);
+        };
+        // Private browsing modes may refuse the database, everything is
+        // then loaded from the network
+        openRequest.onerror = function onOpenErrorFn()
+        {
+            cache._onOpen(null, onload);
+        };
+
+        return cache;
+    }
+}
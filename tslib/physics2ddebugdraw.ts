@@ -10,6 +10,8 @@ Physics2DDistanceConstraint: false
 Physics2DAngleConstraint: false
 Physics2DLineConstraint: false
 Physics2DPulleyConstraint: false
+VertexBufferRing: false
+IndexBufferRing: false
 */
 
 "use strict";
@@ -93,11 +95,10 @@ class Physics2DDebugDraw
     private _techniqueParams: TechniqueParameters;
     private _technique: Technique;
 
-    private _vertexBufferParameters: VertexBufferParameters;
-    private _vertexBuffer: VertexBuffer;
+    private _vertexAttributes: any[];
+    private _vertexRing: VertexBufferRing;
     private _semantics: Semantics;
-    private _indexBufferParameters: IndexBufferParameters;
-    private _indexBuffer: IndexBuffer;
+    private _indexRing: IndexBufferRing;
 
     private _vertexData: any; // new Physics2DDevice.prototype.floatArray(60);
     private _indexData: any; // new Physics2DDevice.prototype.uint16Array(60);
@@ -847,6 +848,10 @@ class Physics2DDebugDraw
 
     begin()
     {
+        // Each begin/end pair writes its lines to the next ring regions
+        this._vertexRing.nextFrame();
+        this._indexRing.nextFrame();
+
         var gd = this._graphicsDevice;
         var width = gd.width;
         var height = gd.height;
@@ -975,12 +980,8 @@ class Physics2DDebugDraw
     _dispatch()
     {
         var graphicsDevice = this._graphicsDevice;
-        var vertexBuffer = this._vertexBuffer;
-        var vertexBufferParameters = this._vertexBufferParameters;
-        var vertexData = this._vertexData;
-        var indexBuffer = this._indexBuffer;
-        var indexBufferParameters = this._indexBufferParameters;
-        var indexData = this._indexData;
+        var vertexRing = this._vertexRing;
+        var indexRing = this._indexRing;
 
         var count = this._numVertices;
         if (count === 0)
@@ -988,32 +989,33 @@ class Physics2DDebugDraw
             return;
         }
 
-        var newSize;
-        // Resize buffer.
-        if (count > vertexBufferParameters.numVertices)
+        // Resize ring.
+        if (count > vertexRing.numVertices)
         {
-            newSize = this._bufferSizeAlgorithm(count);
-            vertexBufferParameters.numVertices = newSize;
-            this._vertexBuffer.destroy();
-            this._vertexBuffer = vertexBuffer = graphicsDevice.createVertexBuffer(vertexBufferParameters);
+            vertexRing.destroy();
+            this._vertexRing = vertexRing =
+                VertexBufferRing.create(graphicsDevice, this._bufferSizeAlgorithm(count), this._vertexAttributes);
         }
 
-        vertexBuffer.setData(vertexData, 0, count);
+        var vertexIndex = vertexRing.write(this._vertexData, count);
+        vertexRing.flush();
 
         count = (this._numLines * 2);
-        // Resize buffer.
-        if (count > indexBufferParameters.numIndices)
+        // Resize ring.
+        if (count > indexRing.numIndices)
         {
-            newSize = this._bufferSizeAlgorithm(count);
-            indexBufferParameters.numIndices = newSize;
-            this._indexBuffer.destroy();
-            this._indexBuffer = indexBuffer = graphicsDevice.createIndexBuffer(indexBufferParameters);
+            indexRing.destroy();
+            this._indexRing = indexRing =
+                IndexBufferRing.create(graphicsDevice, this._bufferSizeAlgorithm(count), graphicsDevice.INDEXFORMAT_USHORT);
         }
 
-        indexBuffer.setData(indexData, 0, count);
-        graphicsDevice.setStream(vertexBuffer, this._semantics);
-        graphicsDevice.setIndexBuffer(indexBuffer);
-        graphicsDevice.drawIndexed(graphicsDevice.PRIMITIVE_LINES, count);
+        var indexIndex = indexRing.write(this._indexData, count);
+        indexRing.flush();
+
+        // Indices are relative to the first vertex given to setStream.
+        graphicsDevice.setStream(vertexRing.vertexBuffer, this._semantics, vertexIndex);
+        graphicsDevice.setIndexBuffer(indexRing.indexBuffer);
+        graphicsDevice.drawIndexed(graphicsDevice.PRIMITIVE_LINES, count, indexIndex);
 
         this._numVertices = 0;
         this._numLines = 0;
@@ -1026,8 +1028,8 @@ class Physics2DDebugDraw
         this._curveVerts.length = 0;
         this._colors.length = 0;
 
-        this._vertexBuffer.destroy();
-        this._indexBuffer.destroy();
+        this._vertexRing.destroy();
+        this._indexRing.destroy();
     }
 
     static create(params) : Physics2DDebugDraw
@@ -1144,21 +1146,14 @@ class Physics2DDebugDraw
         var initialVertices = 4;
         var initialIndices = 4;
 
-        o._vertexBufferParameters = {
-            numVertices : initialVertices,
-            attributes : [gd.VERTEXFORMAT_FLOAT2, gd.VERTEXFORMAT_FLOAT4],
-            'transient': true
-        };
-        o._vertexBuffer = gd.createVertexBuffer(o._vertexBufferParameters);
+        // Vertices and indices are streamed through rings so a dispatch does
+        // not overwrite the data of the previous one.
+        o._vertexAttributes = [gd.VERTEXFORMAT_FLOAT2, gd.VERTEXFORMAT_FLOAT4];
+        o._vertexRing = VertexBufferRing.create(gd, initialVertices, o._vertexAttributes);
 
         o._semantics = gd.createSemantics([gd.SEMANTIC_POSITION, gd.SEMANTIC_COLOR]);
 
-        o._indexBufferParameters = {
-            numIndices : initialIndices,
-            format : gd.INDEXFORMAT_USHORT,
-            'transient' : true
-        };
-        o._indexBuffer = gd.createIndexBuffer(o._indexBufferParameters);
+        o._indexRing = IndexBufferRing.create(gd, initialIndices, gd.INDEXFORMAT_USHORT);
 
         o._vertexData = new Physics2DDevice.prototype.floatArray(60);
         o._indexData = new Physics2DDevice.prototype.uint16Array(60);
@@ -1,8 +1,12 @@
 // Copyright (c) 2010-2014 Turbulenz Limited
 
+/*global debug: false*/
+
 /*exported renderingCommonSortKeyFn*/
 /*exported renderingCommonCreateRendererInfoFn*/
 /*exported renderingCommonAddDrawParameterFastestFn*/
+/*exported renderingCommonUpdateTextureUsageFn*/
+/*exported LightGrid*/
 
 //
 // renderingCommonGetTechniqueIndexFn
@@ -73,3 +77,327 @@ function renderingCommonAddDrawParameterFastestFn(drawParameters)
     var array = this.array;
     array[array.length] = drawParameters;
 }
+
+//
+// renderingCommonUpdateTextureUsageFn
+//
+// Reports to the texture instances of the visible renderables their size
+// on screen in pixels, assuming the texture coordinates span the extents of
+// the renderable, for the TextureManager to choose the mip levels to stream.
+//
+/* tslint:disable:no-unused-variable */
+function renderingCommonUpdateTextureUsageFn(visibleRenderables, camera, screenHeight)
+/* tslint:enable:no-unused-variable */
+{
+    var numVisibleRenderables = visibleRenderables.length;
+    var pixelsPerUnit = (0.5 * screenHeight * camera.recipViewWindowY * camera.aspectRatio);
+    var nearPlane = camera.nearPlane;
+    var n, p;
+    for (n = 0; n < numVisibleRenderables; n += 1)
+    {
+        var renderable = visibleRenderables[n];
+        var textureInstances = renderable.sharedMaterial.textureInstances;
+        var halfExtents = renderable.halfExtents;
+        if (textureInstances && halfExtents)
+        {
+            var radius = Math.max(halfExtents[0], halfExtents[1], halfExtents[2]);
+
+            // The renderable distance is to its furthest corner
+            var distance = (renderable.distance - radius);
+            if (distance < nearPlane)
+            {
+                distance = nearPlane;
+            }
+
+            var pixels = ((2.0 * radius * pixelsPerUnit) / distance);
+            for (p in textureInstances)
+            {
+                if (textureInstances.hasOwnProperty(p))
+                {
+                    textureInstances[p].reportUsage(pixels);
+                }
+            }
+        }
+    }
+}
+
+//
+// LightGrid
+//
+// Bins lights into the cells of a grid, the screen tiles of the tiled
+// deferred lights or the view frustum clusters of the clustered forward
+// lights, and packs them into a float texture read by lightgrid.cgh.
+// Texel n holds the offset and count of the light list of cell n, followed
+// by 5 texels per light with the view space origin, the color and the rows
+// of the light space transform for the X, Y and Z (falloff) coordinates,
+// and then the light lists.
+//
+class LightGrid
+{
+    /* tslint:disable:no-unused-variable */
+    static version = 1;
+    /* tslint:enable:no-unused-variable */
+
+    // maxCellLights must match MAX_CELL_LIGHTS in lightgrid.cgh
+    static textureWidth: number = 256;
+    static textureHeight: number = 64;
+    static maxCellLights: number = 32;
+
+    md          : MathDevice;
+    texture     : Texture;
+    textureSize : any; // v4
+    maxCells    : number;
+    maxLights   : number;
+
+    numX        : number;
+    numY        : number;
+    numZ        : number;
+    numLights   : number;
+
+    private data                      : Float32Array;
+    private counts                    : Uint8Array;
+    private offsets                   : Uint16Array;
+    private bounds                    : Int32Array; // min and max x, y and z cell of each light
+    private worldView                 : any; // m43
+    private lightViewInverseTranspose : any; // m43
+    private origin                    : any; // v3
+
+    // Starts binning the lights into a grid of numX by numY by numZ cells
+    begin(numX: number, numY: number, numZ: number)
+    {
+        var numCells = (numX * numY * numZ);
+        debug.assert(numCells <= this.maxCells);
+
+        this.numX = numX;
+        this.numY = numY;
+        this.numZ = numZ;
+        this.numLights = 0;
+
+        var counts = this.counts;
+        var c;
+        for (c = 0; c < numCells; c += 1)
+        {
+            counts[c] = 0;
+        }
+    }
+
+    // Packs the data of the light, which covers no cell until setLightCells
+    // is called with its index, and returns its transform to view space
+    addLight(lightInstance: LightInstance, viewMatrix: any, colorScale: number): any
+    {
+        var md = this.md;
+        var light = lightInstance.light;
+        var l = this.numLights;
+        debug.assert(l < this.maxLights);
+        this.numLights = (l + 1);
+
+        var worldView = md.m43Mul(lightInstance.node.world, viewMatrix, this.worldView);
+
+        var origin = this.origin;
+        var lightOrigin = light.origin;
+        if (lightOrigin)
+        {
+            origin = md.m43TransformPoint(worldView, lightOrigin, origin);
+        }
+        else
+        {
+            origin = md.m43Pos(worldView, origin);
+        }
+
+        var lightViewInverseTranspose = md.m43InverseTransposeProjection(worldView, light.halfExtents,
+                                                                         this.lightViewInverseTranspose);
+
+        var lightColor = light.color;
+        var data = this.data;
+        var o = (((this.numX * this.numY * this.numZ) + (l * 5)) * 4);
+        data[o] = origin[0];
+        data[o + 1] = origin[1];
+        data[o + 2] = origin[2];
+        data[o + 3] = 0;
+        data[o + 4] = (colorScale * lightColor[0]);
+        data[o + 5] = (colorScale * lightColor[1]);
+        data[o + 6] = (colorScale * lightColor[2]);
+        data[o + 7] = 0;
+        var i;
+        for (i = 0; i < 12; i += 1)
+        {
+            data[o + 8 + i] = lightViewInverseTranspose[i];
+        }
+
+        var b = (l * 6);
+        var bounds = this.bounds;
+        bounds[b + 4] = 0;
+        bounds[b + 5] = -1;
+
+        return worldView;
+    }
+
+    // Adds the light to the cells in the given inclusive ranges, clamped to
+    // the grid, cells already holding maxCellLights lights are skipped
+    setLightCells(l: number,
+                  minX: number, maxX: number,
+                  minY: number, maxY: number,
+                  minZ: number, maxZ: number)
+    {
+        var numX = this.numX;
+        var numXY = (numX * this.numY);
+        minX = Math.max(0, minX);
+        maxX = Math.min((numX - 1), maxX);
+        minY = Math.max(0, minY);
+        maxY = Math.min((this.numY - 1), maxY);
+        minZ = Math.max(0, minZ);
+        maxZ = Math.min((this.numZ - 1), maxZ);
+
+        var b = (l * 6);
+        var bounds = this.bounds;
+        bounds[b] = minX;
+        bounds[b + 1] = maxX;
+        bounds[b + 2] = minY;
+        bounds[b + 3] = maxY;
+        bounds[b + 4] = minZ;
+        bounds[b + 5] = maxZ;
+
+        var counts = this.counts;
+        var maxCellLights = LightGrid.maxCellLights;
+        var c, x, y, z;
+        for (z = minZ; z <= maxZ; z += 1)
+        {
+            for (y = minY; y <= maxY; y += 1)
+            {
+                c = ((z * numXY) + (y * numX) + minX);
+                for (x = minX; x <= maxX; x += 1)
+                {
+                    if (counts[c] < maxCellLights)
+                    {
+                        counts[c] += 1;
+                    }
+                    c += 1;
+                }
+            }
+        }
+    }
+
+    // Writes the cell records and light lists and uploads the texture rows
+    // in use
+    end()
+    {
+        var numX = this.numX;
+        var numXY = (numX * this.numY);
+        var numCells = (numXY * this.numZ);
+        var numLights = this.numLights;
+
+        var data = this.data;
+        var counts = this.counts;
+        var offsets = this.offsets;
+        var bounds = this.bounds;
+        var textureWidth = LightGrid.textureWidth;
+        var lightDataStart = numCells;
+        var indexStart = (lightDataStart + (numLights * 5));
+        var maxIndices = ((textureWidth * LightGrid.textureHeight) - indexStart);
+
+        // Cell records: offset and number of entries of the light list
+        var numIndices = 0;
+        var c, o, count;
+        for (c = 0; c < numCells; c += 1)
+        {
+            count = counts[c];
+            if (count > (maxIndices - numIndices))
+            {
+                count = (maxIndices - numIndices);
+            }
+            o = (c * 4);
+            data[o] = (indexStart + numIndices);
+            data[o + 1] = count;
+            offsets[c] = numIndices;
+            counts[c] = 0;
+            numIndices += count;
+        }
+
+        var l, b, x, y, z;
+        for (l = 0; l < numLights; l += 1)
+        {
+            b = (l * 6);
+            for (z = bounds[b + 4]; z <= bounds[b + 5]; z += 1)
+            {
+                for (y = bounds[b + 2]; y <= bounds[b + 3]; y += 1)
+                {
+                    c = ((z * numXY) + (y * numX) + bounds[b]);
+                    for (x = bounds[b]; x <= bounds[b + 1]; x += 1)
+                    {
+                        count = counts[c];
+                        if (count < data[(c * 4) + 1])
+                        {
+                            data[(indexStart + offsets[c] + count) * 4] = (lightDataStart + (l * 5));
+                            counts[c] = (count + 1);
+                        }
+                        c += 1;
+                    }
+                }
+            }
+        }
+
+        var numRows = Math.ceil((indexStart + numIndices) / textureWidth);
+        this.texture.setData(data.subarray(0, (numRows * textureWidth * 4)),
+                             0, 0, 0, 0, textureWidth, numRows);
+    }
+
+    destroy()
+    {
+        if (this.texture)
+        {
+            this.texture.destroy();
+            this.texture = null;
+        }
+        this.data = null;
+        this.counts = null;
+        this.offsets = null;
+        this.bounds = null;
+    }
+
+    // Returns null if float textures are not supported
+    static create(gd: GraphicsDevice, md: MathDevice,
+                  maxCells: number, maxLights: number): LightGrid
+    {
+        if (!gd.isSupported("TEXTURE_FLOAT"))
+        {
+            return null;
+        }
+
+        var textureWidth = LightGrid.textureWidth;
+        var textureHeight = LightGrid.textureHeight;
+        var texture = gd.createTexture({
+            name      : "lightgrid",
+            width     : textureWidth,
+            height    : textureHeight,
+            depth     : 1,
+            format    : gd.PIXELFORMAT_RGBA32F,
+            mipmaps   : false,
+            cubemap   : false,
+            dynamic   : true
+        });
+        if (!texture)
+        {
+            return null;
+        }
+
+        var lightGrid = new LightGrid();
+        lightGrid.md = md;
+        lightGrid.texture = texture;
+        lightGrid.textureSize = md.v4Build(textureWidth, textureHeight,
+                                           (1.0 / textureWidth), (1.0 / textureHeight));
+        lightGrid.maxCells = maxCells;
+        lightGrid.maxLights = maxLights;
+        lightGrid.numX = 1;
+        lightGrid.numY = 1;
+        lightGrid.numZ = 1;
+        lightGrid.numLights = 0;
+        lightGrid.data = new Float32Array(textureWidth * textureHeight * 4);
+        lightGrid.counts = new Uint8Array(maxCells);
+        lightGrid.offsets = new Uint16Array(maxCells);
+        lightGrid.bounds = new Int32Array(maxLights * 6);
+        lightGrid.worldView = md.m43BuildIdentity();
+        lightGrid.lightViewInverseTranspose = md.m43BuildIdentity();
+        lightGrid.origin = md.v3BuildZero();
+        return lightGrid;
+    }
+}
@@ -2,6 +2,8 @@
 
 /*global TurbulenzEngine*/
 /*global Observer*/
+/*global PersistentCache*/
+/*global Trace*/
 
 interface RequestFn
 {
@@ -32,6 +34,31 @@ interface RequestHandlerCallContext
     requestFn?      : RequestFn;
     requestOwner?   : RequestOwner;
     responseFilter? : RequestHandlerResponseFilter;
+    userData?       : any;
+    priority?       : number; // lower values are requested first
+    cancelled?      : boolean;
+    queueTime?      : number; // seconds waiting for a free request slot
+    requestTime?    : number; // seconds from the request being made to the response
+    startTime?      : number;
+    persistent?     : boolean; // requestFn loads callContext.data when given
+    data?           : Uint8Array; // set when read through the persistent cache
+    traceId?        : number; // id of the async trace spans while tracing
+}
+
+interface RequestHandlerQueueEntry
+{
+    callContext : RequestHandlerCallContext;
+    makeRequest : { (): void; };
+    order       : number;
+    queuedTime  : number;
+}
+
+// Concurrent requests for the same URL share the response of the first one
+interface RequestHandlerSharedRequest
+{
+    callContext : RequestHandlerCallContext;
+    duplicates  : { callContext: RequestHandlerCallContext;
+                    responseCallback: { (responseAsset: any, status: number): void; }; }[];
 }
 
 interface RequestHandlerHandlers
@@ -66,9 +93,27 @@ class RequestHandler
                        responseAsset: any,
                        status: number): void; };
 
+    // Maximum number of requests in flight, 0 for no limit
+    maxRequests: number;
+    numActiveRequests: number;
+
+    // Content hashed URLs are read through it when set
+    persistentCache: PersistentCache;
+
+    private queue: RequestHandlerQueueEntry[]; // sorted by priority
+    private queueCounter: number;
+    private activeRequests: RequestHandlerCallContext[];
+    private sharedRequests: { [src: string]: RequestHandlerSharedRequest; };
+
     reasonConnectionLost = 0;
     reasonServiceBusy = 1;
 
+    priorityCritical = 0;
+    priorityHigh = 1;
+    priorityNormal = 2;
+    priorityLow = 3;
+    priorityBackground = 4;
+
     retryExponential(callContext, requestFn, status)
     {
         if (!this.notifiedConnectionLost &&
@@ -165,6 +210,7 @@ class RequestHandler
     {
         var makeRequest;
         var that = this;
+        var downloading = false;
 
         var responseCallback = function responseCallbackFn(responseAsset, status)
         {
@@ -173,9 +219,50 @@ class RequestHandler
                 return;
             }
 
+            if (downloading)
+            {
+                downloading = false;
+                Trace.endAsync("download", callContext.traceId, "request", { status: status });
+            }
+
             var sendEventToHandlers = that.sendEventToHandlers;
             var handlers = that.handlers;
 
+            callContext.requestTime = (TurbulenzEngine.time - callContext.startTime);
+
+            // Retries are made without waiting for a free slot
+            var activeRequests = that.activeRequests;
+            var activeIndex = activeRequests.indexOf(callContext);
+            if (activeIndex !== -1)
+            {
+                activeRequests.splice(activeIndex, 1);
+                that.numActiveRequests -= 1;
+                that._dispatch();
+                if (callContext.traceId)
+                {
+                    Trace.counter("Active requests", that.numActiveRequests, "request");
+                }
+            }
+
+            var src = callContext.src;
+            var sharedRequest = that.sharedRequests[src];
+            if (sharedRequest && sharedRequest.callContext !== callContext)
+            {
+                sharedRequest = null;
+            }
+
+            if (callContext.cancelled &&
+                (!sharedRequest || !sharedRequest.duplicates.length))
+            {
+                if (sharedRequest)
+                {
+                    delete that.sharedRequests[src];
+                }
+                that._endTrace(callContext, status);
+                callContext = null;
+                return;
+            }
+
             // 0 Connection Lost
             // 408 Request Timeout
             // 429 Too Many Requests
@@ -187,6 +274,26 @@ class RequestHandler
                 return;
             }
 
+            if (sharedRequest)
+            {
+                delete that.sharedRequests[src];
+
+                var duplicates = sharedRequest.duplicates;
+                var numDuplicates = duplicates.length;
+                var n;
+                for (n = 0; n < numDuplicates; n += 1)
+                {
+                    duplicates[n].responseCallback(responseAsset, status);
+                }
+
+                if (callContext.cancelled)
+                {
+                    that._endTrace(callContext, status);
+                    callContext = null;
+                    return;
+                }
+            }
+
             if (!that.connected)
             {
                 // Reconnected!
@@ -223,21 +330,34 @@ class RequestHandler
                     nameStr = callContext.src;
                 }
 
-                sendEventToHandlers(handlers.eventOnload, {eventType: "eventOnload", name: nameStr});
+                sendEventToHandlers(handlers.eventOnload, {
+                    eventType: "eventOnload",
+                    name: nameStr,
+                    queueTime: callContext.queueTime,
+                    requestTime: callContext.requestTime
+                });
+
+                var traceId = callContext.traceId;
+                if (traceId)
+                {
+                    Trace.begin("onload", "request", { src: callContext.src });
+                    Trace.flowEnd("request", traceId, "request");
+                }
 
                 callContext.onload(responseAsset, status, callContext);
                 callContext.onload = null;
+
+                if (traceId)
+                {
+                    Trace.end("onload", "request");
+                }
             }
+            that._endTrace(callContext, status);
             callContext = null;
         };
 
-        makeRequest = function makeRequestFn()
+        var sendRequest = function sendRequestFn()
         {
-            if (that.destroyed)
-            {
-                return;
-            }
-
             if (callContext.requestFn)
             {
                 if (callContext.requestOwner)
@@ -262,7 +382,333 @@ class RequestHandler
             }
         };
 
-        makeRequest();
+        makeRequest = function makeRequestFn()
+        {
+            if (that.destroyed)
+            {
+                return;
+            }
+
+            if (callContext.traceId)
+            {
+                downloading = true;
+                Trace.beginAsync("download", callContext.traceId, "request");
+            }
+
+            var persistentCache = that.persistentCache;
+            if (persistentCache &&
+                that._isPersistent(callContext) &&
+                persistentCache.canStore(callContext.src))
+            {
+                persistentCache.request(callContext.src,
+                                        function persistentDataFn(data, status)
+                {
+                    if (that.destroyed)
+                    {
+                        return;
+                    }
+
+                    if (!data)
+                    {
+                        responseCallback(null, status);
+                    }
+                    else if (callContext.persistent)
+                    {
+                        callContext.data = data;
+                        sendRequest();
+                        callContext.data = null;
+                    }
+                    else
+                    {
+                        var text = PersistentCache.decodeText(data);
+                        if (text !== null)
+                        {
+                            responseCallback(text, status);
+                        }
+                        else
+                        {
+                            // Not text after all, request it as usual
+                            persistentCache.remove(callContext.src);
+                            sendRequest();
+                        }
+                    }
+                });
+            }
+            else
+            {
+                sendRequest();
+            }
+        };
+
+        if (callContext.priority === undefined)
+        {
+            callContext.priority = this.priorityNormal;
+        }
+        callContext.cancelled = false;
+
+        if (typeof Trace !== "undefined" && Trace.enabled)
+        {
+            var traceId = Trace.newId();
+            callContext.traceId = traceId;
+            Trace.beginAsync(callContext.src, traceId, "request");
+            Trace.flowStart("request", traceId, "request");
+        }
+
+        // Requests made with TurbulenzEngine.request return the same
+        // response for the same URL so concurrent ones are merged
+        if (!callContext.requestFn && !callContext.requestOwner)
+        {
+            var src = callContext.src;
+            var sharedRequest = this.sharedRequests[src];
+            if (sharedRequest)
+            {
+                callContext.queueTime = 0;
+                callContext.startTime = TurbulenzEngine.time;
+                sharedRequest.duplicates.push({
+                    callContext: callContext,
+                    responseCallback: responseCallback
+                });
+
+                var sharedCallContext = sharedRequest.callContext;
+                if (sharedCallContext.priority > callContext.priority)
+                {
+                    this.setPriority(sharedCallContext, callContext.priority);
+                }
+                return;
+            }
+
+            this.sharedRequests[src] = {
+                callContext: callContext,
+                duplicates: []
+            };
+        }
+
+        if (callContext.traceId)
+        {
+            Trace.beginAsync("queue", callContext.traceId, "request");
+        }
+
+        var entry = {
+            callContext: callContext,
+            makeRequest: makeRequest,
+            order: this.queueCounter,
+            queuedTime: TurbulenzEngine.time
+        };
+        this.queueCounter += 1;
+
+        var maxRequests = this.maxRequests;
+        if (maxRequests && this.numActiveRequests >= maxRequests)
+        {
+            this._enqueue(entry);
+        }
+        else
+        {
+            this._start(entry);
+        }
+    }
+
+    // Changes the priority of a request, only requests waiting for a free
+    // slot are affected
+    setPriority(callContext: RequestHandlerCallContext, priority: number)
+    {
+        callContext.priority = priority;
+
+        var queue = this.queue;
+        var numQueued = queue.length;
+        var n;
+        for (n = 0; n < numQueued; n += 1)
+        {
+            var entry = queue[n];
+            if (entry.callContext === callContext)
+            {
+                queue.splice(n, 1);
+                this._enqueue(entry);
+                break;
+            }
+        }
+    }
+
+    // Calls priorityFn for every waiting request and reorders the queue
+    // with the returned priorities, undefined keeps the current priority.
+    // Useful to request first the assets closer to the camera.
+    updatePriorities(priorityFn: { (callContext: RequestHandlerCallContext): number; })
+    {
+        var queue = this.queue;
+        var numQueued = queue.length;
+        if (numQueued)
+        {
+            var n;
+            for (n = 0; n < numQueued; n += 1)
+            {
+                var callContext = queue[n].callContext;
+                var priority = priorityFn(callContext);
+                if (priority !== undefined)
+                {
+                    callContext.priority = priority;
+                }
+            }
+
+            queue.sort(RequestHandler.compareEntries);
+        }
+    }
+
+    // Requests waiting for a slot are discarded, requests in flight are not
+    // aborted but their onload is not called. Returns false if the request
+    // has already finished.
+    cancel(callContext: RequestHandlerCallContext): boolean
+    {
+        if (callContext.cancelled || !callContext.onload)
+        {
+            return false;
+        }
+        callContext.cancelled = true;
+
+        var src = callContext.src;
+        var sharedRequest = this.sharedRequests[src];
+        if (sharedRequest)
+        {
+            var sharedCallContext = sharedRequest.callContext;
+            var duplicates = sharedRequest.duplicates;
+            if (sharedCallContext !== callContext)
+            {
+                var numDuplicates = duplicates.length;
+                var n;
+                for (n = 0; n < numDuplicates; n += 1)
+                {
+                    if (duplicates[n].callContext === callContext)
+                    {
+                        duplicates.splice(n, 1);
+                        this._endTrace(callContext, 0);
+                        break;
+                    }
+                }
+                if (!sharedCallContext.cancelled)
+                {
+                    return true;
+                }
+            }
+
+            // The shared request is still made while other requests wait for it
+            if (duplicates.length)
+            {
+                return true;
+            }
+            delete this.sharedRequests[src];
+            this._removeQueued(sharedCallContext);
+        }
+
+        this._removeQueued(callContext);
+        return true;
+    }
+
+    getNumQueuedRequests(): number
+    {
+        return this.queue.length;
+    }
+
+    // Text requests are read through the persistent cache, other requests
+    // only if their requestFn accepts the data
+    private _isPersistent(callContext: RequestHandlerCallContext): boolean
+    {
+        if (callContext.persistent)
+        {
+            return true;
+        }
+        return (!callContext.requestFn &&
+                (!callContext.requestOwner ||
+                 callContext.requestOwner === <any>TurbulenzEngine));
+    }
+
+    private _removeQueued(callContext: RequestHandlerCallContext)
+    {
+        var queue = this.queue;
+        var numQueued = queue.length;
+        var n;
+        for (n = 0; n < numQueued; n += 1)
+        {
+            if (queue[n].callContext === callContext)
+            {
+                queue.splice(n, 1);
+                if (callContext.traceId)
+                {
+                    Trace.endAsync("queue", callContext.traceId, "request");
+                    this._endTrace(callContext, 0);
+                }
+                break;
+            }
+        }
+    }
+
+    private _endTrace(callContext: RequestHandlerCallContext, status: number)
+    {
+        var traceId = callContext.traceId;
+        if (traceId)
+        {
+            callContext.traceId = 0;
+            Trace.endAsync(callContext.src, traceId, "request", { status: status });
+        }
+    }
+
+    private _enqueue(entry: RequestHandlerQueueEntry)
+    {
+        // Binary search for the last position keeps the order of requests
+        // with the same priority
+        var queue = this.queue;
+        var low = 0;
+        var high = queue.length;
+        while (low < high)
+        {
+            /* tslint:disable:no-bitwise */
+            var mid = ((low + high) >>> 1);
+            /* tslint:enable:no-bitwise */
+            if (RequestHandler.compareEntries(queue[mid], entry) <= 0)
+            {
+                low = (mid + 1);
+            }
+            else
+            {
+                high = mid;
+            }
+        }
+        queue.splice(low, 0, entry);
+    }
+
+    private _start(entry: RequestHandlerQueueEntry)
+    {
+        var callContext = entry.callContext;
+        var time = TurbulenzEngine.time;
+        callContext.queueTime = (time - entry.queuedTime);
+        callContext.startTime = time;
+        this.activeRequests.push(callContext);
+        this.numActiveRequests += 1;
+        if (callContext.traceId)
+        {
+            Trace.endAsync("queue", callContext.traceId, "request");
+            Trace.counter("Active requests", this.numActiveRequests, "request");
+        }
+        entry.makeRequest();
+    }
+
+    private _dispatch()
+    {
+        var queue = this.queue;
+        var maxRequests = this.maxRequests;
+        while (queue.length &&
+               (!maxRequests || this.numActiveRequests < maxRequests))
+        {
+            this._start(queue.shift());
+        }
+    }
+
+    static compareEntries(a: RequestHandlerQueueEntry,
+                          b: RequestHandlerQueueEntry): number
+    {
+        var delta = (a.callContext.priority - b.callContext.priority);
+        if (delta === 0)
+        {
+            delta = (a.order - b.order);
+        }
+        return delta;
     }
 
     addEventListener(eventType, eventListener)
@@ -335,6 +781,9 @@ class RequestHandler
     destroy()
     {
         this.destroyed = true;
+        this.queue = [];
+        this.activeRequests = [];
+        this.sharedRequests = {};
         this.handlers = null;
         this.onReconnected = null;
         this.onRequestTimeout = null;
@@ -348,6 +797,14 @@ class RequestHandler
         rh.notifyTime = params.notifyTime || 4 * 1000;
         rh.maxRetryTime = params.maxRetryTime || 8 * 1000;
 
+        rh.maxRequests = params.maxRequests || 0;
+        rh.numActiveRequests = 0;
+        rh.queue = [];
+        rh.queueCounter = 0;
+        rh.activeRequests = [];
+        rh.sharedRequests = {};
+        rh.persistentCache = (params.persistentCache || null);
+
         rh.notifiedConnectionLost = false;
         rh.connected = true;
         rh.reconnectedObserver = Observer.create();
@@ -1,6 +1,7 @@
 // Copyright (c) 2010-2014 Turbulenz Limited
 /*global TurbulenzEngine:false*/
 /*global VMath:false*/
+/*global Trace:false*/
 
 interface LoadParameters
 {
@@ -38,13 +39,33 @@ interface SceneNodeParameters // extends SceneNode
     matrix: number[];
 };
 
+// A node waiting to be resolved, root nodes are finished once all their
+// children have been resolved
+interface ResourceLoaderNodeTask
+{
+    fileNode: SceneNodeParameters;
+    name: string;
+    parentPath: string;
+    parent: SceneNodeParameters; // null for root nodes
+    node: SceneNodeParameters;   // set once a root node has been resolved
+};
+
+// A call to resolve waiting to be completed
+interface ResourceLoaderJob
+{
+    loadParams: any;
+    stage: number;
+    nodeTasks: ResourceLoaderNodeTask[];
+    traceId: number;
+};
+
 //
 // ResourceLoader
 //
 class ResourceLoader
 {
     /* tslint:disable:no-unused-variable */
-    static version = 1;
+    static version = 2;
     /* tslint:enable:no-unused-variable */
 
     nodesMap             : { [name: string]: SceneNodeParameters; };
@@ -54,6 +75,13 @@ class ResourceLoader
     skeletonNames        : { [name: string]: string; };
     data                 : any;
 
+    // Milliseconds of resolving done before yielding, 0 resolves at once
+    maxTime              : number;
+    yieldFn              : { (callback: { (): void; }): void; };
+    jobs                 : ResourceLoaderJob[];
+    running              : boolean;
+    resumeFn             : { (): void; };
+
     //
     // clear
     //
@@ -81,19 +109,7 @@ class ResourceLoader
 
     resolveShapes(loadParams)
     {
-        var copyObject = function copyObjectFn(o)
-        {
-            var newObj = { };
-            for (var p in o)
-            {
-                if (o.hasOwnProperty(p))
-                {
-                    newObj[p] = o[p];
-                }
-            }
-            return newObj;
-        };
-
+        var ownsData = loadParams.ownsData;
         var shapesNamePrefix = loadParams.shapesNamePrefix;
         // we reuse shapesNamePrefix to save adding prefixes for everything
         var skeletonNamePrefix = loadParams.shapesNamePrefix;
@@ -119,7 +135,7 @@ class ResourceLoader
                 {
                     // the shape has to be copied if it has a skeleton as the same shape
                     // can be used with multiple skeletons
-                    targetShapes[targetShapeName] = copyObject(fileShape);
+                    targetShapes[targetShapeName] = (ownsData ? fileShape : ResourceLoader.copyObject(fileShape));
                     targetShapes[targetShapeName].skeleton = (skeletonNamePrefix ?
                                                               (skeletonNamePrefix + "-" + fileSkeletonName) :
                                                               fileSkeletonName);
@@ -195,7 +211,10 @@ class ResourceLoader
             }
             //Utilities.log("resolved ref for " + anim + " count now " + (currentLoader.numReferencesPending-1));
             currentLoader.numReferencesPending -= 1;
-            if (currentLoader.numReferencesPending <= 0)
+
+            // Resolves still in progress end the loading themselves
+            if (currentLoader.numReferencesPending <= 0 &&
+                !currentLoader.jobs.length)
             {
                 currentLoader.endLoading(loadParams.onload);
             }
@@ -237,236 +256,302 @@ class ResourceLoader
     //
     resolveNodes(loadParams: LoadParameters)
     {
-        var sceneData = loadParams.data;
-
-        var references = this.referencesPending;
-        var numReferences = 0;
-        var nodesMap = this.nodesMap;
-
-        var currentLoader = this;
+        var nodeTasks = this.beginResolveNodes(loadParams);
+        while (nodeTasks.length)
+        {
+            this.resolveNextNode(loadParams, nodeTasks);
+        }
+    }
 
+    // Returns the stack of root nodes to be resolved, in order
+    beginResolveNodes(loadParams: LoadParameters): ResourceLoaderNodeTask[]
+    {
+        var fileNodes = loadParams.data.nodes;
         var nodesNamePrefix = loadParams.nodesNamePrefix;
-        var shapesNamePrefix = loadParams.shapesNamePrefix;
-
-        var requestOwner =
-            (loadParams.request ? <any>loadParams : <any>TurbulenzEngine);
-
-        var copyObject = function copyObjectFn(o)
+        var nodeTasks: ResourceLoaderNodeTask[] = [];
+        for (var fn in fileNodes)
         {
-            var newObj = { };
-            for (var p in o)
+            if (fileNodes.hasOwnProperty(fn) && fileNodes[fn])
             {
-                if (o.hasOwnProperty(p))
-                {
-                    newObj[p] = o[p];
-                }
+                nodeTasks.push({
+                    fileNode: fileNodes[fn],
+                    name: fn,
+                    parentPath: nodesNamePrefix,
+                    parent: null,
+                    node: null
+                });
             }
-            return newObj;
-        };
+        }
+        nodeTasks.reverse();
+        return nodeTasks;
+    }
 
-        var resolveNode =
-            function resolveNodeFn(fileNode: SceneNodeParameters,
-                                   nodeName: string,
-                                   parentNodePath: string) : SceneNodeParameters
+    resolveNextNode(loadParams: LoadParameters,
+                    nodeTasks: ResourceLoaderNodeTask[])
+    {
+        var task = nodeTasks.pop();
+        if (task.node)
         {
-            // We're changing a node which may be referenced multiple
-            // times so take a copy
-            var node = <SceneNodeParameters>(copyObject(fileNode));
-            var nodePath = parentNodePath ? (parentNodePath + "/" + nodeName) : nodeName;
-
-            var reference = node.reference;
-            if (reference)
-            {
-                //Utilities.log("Reference resolve for " + nodePath);
+            this.addRootNode(loadParams, task.name, task.node);
+            return;
+        }
 
-                var internalReferenceIndex = reference.indexOf("#");
-                if (internalReferenceIndex === -1)
-                {
-                    var referenceParameters = references[reference];
-                    if (!referenceParameters || referenceParameters.length === 0 || !node.inplace)
-                    {
-                        numReferences += 1;
-                        //Utilities.log("adding ref for " + nodePath + " numrefs now " + numReferences);
+        var nodesMap = this.nodesMap;
+        var fileNode = task.fileNode;
+        var nodeName = task.name;
+        var parentNodePath = task.parentPath;
+        var nodePath = parentNodePath ? (parentNodePath + "/" + nodeName) : nodeName;
 
-                        var sceneParameters = <SceneParameters>
-                            copyObject(loadParams);
-                        sceneParameters.append = true;
-                        if (node.inplace)
-                        {
-                            sceneParameters.nodesNamePrefix = parentNodePath;
-                            sceneParameters.shapesNamePrefix = null;
-                            sceneParameters.parentNode = null;
-                        }
-                        else
-                        {
-                            sceneParameters.nodesNamePrefix = nodePath;
-                            sceneParameters.shapesNamePrefix = reference;
-                            sceneParameters.parentNode = node;
-                        }
-                        if (node.skin)
-                        {
-                            sceneParameters.skin = node.skin;
-                        }
+        var parent = task.parent;
+        if (parent && nodesMap[nodePath])
+        {
+            return;
+        }
 
-                        if (!referenceParameters || referenceParameters.length === 0)
-                        {
-                            referenceParameters = [sceneParameters];
-                            references[reference] = referenceParameters;
+        // Data shared with other loads may reference a node multiple
+        // times so take a copy before changing it
+        var ownsData = (<any>loadParams).ownsData;
+        var node = (ownsData ? fileNode : <SceneNodeParameters>(ResourceLoader.copyObject(fileNode)));
 
-                            var loadReference = function (sceneText)
-                            {
-                                var numInstances = referenceParameters.length;
-                                var sceneData;
-                                if (sceneText)
-                                {
-                                    sceneData = JSON.parse(sceneText);
-                                }
-                                else
-                                {
-                                    // Make sure we can call scene
-                                    // load to correctly deal with
-                                    // reference counts when a
-                                    // reference is missing
-                                    sceneData = {};
-                                }
-                                var params;
-                                for (var n = 0; n < numInstances; n += 1)
-                                {
-                                    params = referenceParameters[n];
-                                    params.data = sceneData;
-                                    params.isReference = true;
-                                    currentLoader.resolve(params);
-                                }
-                                referenceParameters.length = 0;
-                            };
-
-                            loadParams.requestHandler.request({
-                                    src: reference,
-                                    requestOwner: requestOwner,
-                                    onload: loadReference
-                                });
-                        }
-                        else
-                        {
-                            referenceParameters.push(sceneParameters);
-                        }
-                    }
-                }
-                delete node.reference;
-                delete node.inplace;
-            }
+        var reference = node.reference;
+        if (reference)
+        {
+            //Utilities.log("Reference resolve for " + nodePath);
+            this.resolveReference(loadParams, node, nodePath, parentNodePath);
+            delete node.reference;
+            delete node.inplace;
+        }
 
-            var geometryinstances = node.geometryinstances;
-            if (shapesNamePrefix && geometryinstances)
+        var shapesNamePrefix = loadParams.shapesNamePrefix;
+        var geometryinstances = node.geometryinstances;
+        if (shapesNamePrefix && geometryinstances)
+        {
+            // Need to copy the geometry instances dictionary because we're prefixing the names
+            if (!ownsData)
             {
-                // Need to deep copy the geometry instances dictionary because we're prefixing the names
                 node.geometryinstances = { };
-                for (var gi in geometryinstances)
+            }
+            for (var gi in geometryinstances)
+            {
+                if (geometryinstances.hasOwnProperty(gi))
                 {
-                    if (geometryinstances.hasOwnProperty(gi))
+                    var geometryInstance = geometryinstances[gi];
+                    if (!ownsData)
                     {
-                        node.geometryinstances[gi] = <GeometryInstanceParameters>
-                            copyObject(geometryinstances[gi]);
-                        var geometryInstance = node.geometryinstances[gi];
-
-                        //Utilities.log("prefixing " + geometryInstance.geometry + " with " + shapesNamePrefix);
-                        geometryInstance.geometry = shapesNamePrefix + "-" + geometryInstance.geometry;
+                        geometryInstance = <GeometryInstanceParameters>
+                            ResourceLoader.copyObject(geometryInstance);
+                        node.geometryinstances[gi] = geometryInstance;
                     }
+
+                    //Utilities.log("prefixing " + geometryInstance.geometry + " with " + shapesNamePrefix);
+                    geometryInstance.geometry = shapesNamePrefix + "-" + geometryInstance.geometry;
                 }
             }
+        }
+
+        if (parent)
+        {
+            parent.nodes[nodeName] = node;
+            nodesMap[nodePath] = node;
+        }
+        else
+        {
+            // Finish the root node after its children
+            task.node = node;
+            nodeTasks.push(task);
+        }
+
+        var fileChildren = fileNode.nodes;
+        if (fileChildren)
+        {
+            node.nodes = {};
 
-            var fileChildren = fileNode.nodes;
-            if (fileChildren)
+            var firstChild = nodeTasks.length;
+            for (var c in fileChildren)
             {
-                node.nodes = {};
-                for (var c in fileChildren)
+                if (fileChildren.hasOwnProperty(c))
                 {
-                    if (fileChildren.hasOwnProperty(c))
-                    {
-                        var childPath = nodePath + "/" + c;
-                        if (!nodesMap[childPath])
-                        {
-                            node.nodes[c] = resolveNode(fileChildren[c], c, nodePath);
-                            nodesMap[childPath] = node.nodes[c];
-                        }
-                    }
+                    nodeTasks.push({
+                        fileNode: fileChildren[c],
+                        name: c,
+                        parentPath: nodePath,
+                        parent: node,
+                        node: null
+                    });
                 }
             }
 
-            return node;
-        };
+            // Reverse the children so they are resolved in order
+            var lastChild = (nodeTasks.length - 1);
+            while (firstChild < lastChild)
+            {
+                var childTask = nodeTasks[firstChild];
+                nodeTasks[firstChild] = nodeTasks[lastChild];
+                nodeTasks[lastChild] = childTask;
+                firstChild += 1;
+                lastChild -= 1;
+            }
+        }
+    }
 
-        var fileNodes = sceneData.nodes;
-        var parentNode = loadParams.parentNode;
-        for (var fn in fileNodes)
+    // Requests the scene referenced by a node, the reference is resolved
+    // with every node referencing it once it is loaded
+    resolveReference(loadParams: LoadParameters,
+                     node: SceneNodeParameters,
+                     nodePath: string,
+                     parentNodePath: string)
+    {
+        var reference = node.reference;
+        var internalReferenceIndex = reference.indexOf("#");
+        if (internalReferenceIndex !== -1)
         {
-            if (fileNodes.hasOwnProperty(fn) && fileNodes[fn])
-            {
-                var nodeName = fn;
-                var fileNode =
-                    resolveNode(fileNodes[fn], nodeName, nodesNamePrefix);
-                var nodePath = (nodesNamePrefix ? (nodesNamePrefix + "/" + fn) : fn);
-                var overloadedNode = nodesMap[nodePath];
+            return;
+        }
 
-                if (overloadedNode)
-                {
-                    //Utilities.log("Overloaded node '" + nodePath + "'");
+        var references = this.referencesPending;
+        var referenceParameters = references[reference];
+        if (referenceParameters && referenceParameters.length !== 0 && node.inplace)
+        {
+            return;
+        }
 
-                    var overloadedMatrix = overloadedNode.matrix;
-                    if (overloadedMatrix && fileNode.matrix)
-                    {
-                        overloadedNode.matrix = VMath.m43Mul(fileNode.matrix, overloadedMatrix);
-                        overloadedMatrix = null;
-                    }
+        this.numReferencesPending += 1;
+        //Utilities.log("adding ref for " + nodePath + " numrefs now " + this.numReferencesPending);
 
-                    var overloadedChildren = overloadedNode.nodes;
-                    if (overloadedChildren && fileNode.nodes)
-                    {
-                        //Utilities.log("Concat children of node '" + nodePath + "'");
-                        for (var c in fileNode.nodes)
-                        {
-                            if (fileNode.nodes.hasOwnProperty(c))
-                            {
-                                overloadedChildren[c] = fileNode.nodes[c];
-                            }
-                        }
-                    }
-                    else if (fileNode.nodes)
-                    {
-                        overloadedNode.nodes = fileNode.nodes;
-                    }
+        var sceneParameters = <SceneParameters>
+            ResourceLoader.copyObject(loadParams);
+        sceneParameters.append = true;
+        if (node.inplace)
+        {
+            sceneParameters.nodesNamePrefix = parentNodePath;
+            sceneParameters.shapesNamePrefix = null;
+            sceneParameters.parentNode = null;
+        }
+        else
+        {
+            sceneParameters.nodesNamePrefix = nodePath;
+            sceneParameters.shapesNamePrefix = reference;
+            sceneParameters.parentNode = node;
+        }
+        if (node.skin)
+        {
+            sceneParameters.skin = node.skin;
+        }
 
-                    for (var on in fileNode)
-                    {
-                        if (fileNode.hasOwnProperty(on))
-                        {
-                            overloadedNode[on] = fileNode[on];
-                        }
-                    }
-                    fileNode = overloadedNode;
+        if (!referenceParameters || referenceParameters.length === 0)
+        {
+            referenceParameters = [sceneParameters];
+            references[reference] = referenceParameters;
+
+            var currentLoader = this;
+            var loadReference = function (sceneText)
+            {
+                var numInstances = referenceParameters.length;
+                var sceneData;
+                if (sceneText)
+                {
+                    sceneData = JSON.parse(sceneText);
                 }
                 else
                 {
-                    if (loadParams.isReference && parentNode)
-                    {
-                        if (!parentNode.nodes)
-                        {
-                            parentNode.nodes = {};
-                        }
-                        parentNode.nodes[fn] = fileNode;
-                    }
-                    else
+                    // Make sure we can call scene
+                    // load to correctly deal with
+                    // reference counts when a
+                    // reference is missing
+                    sceneData = {};
+                }
+                var params;
+                for (var n = 0; n < numInstances; n += 1)
+                {
+                    params = referenceParameters[n];
+                    params.data = sceneData;
+                    params.isReference = true;
+                    // Nothing else uses the data if there is a single instance
+                    params.ownsData = (numInstances === 1);
+                    currentLoader.resolve(params);
+                }
+                referenceParameters.length = 0;
+            };
+
+            var requestOwner =
+                (loadParams.request ? <any>loadParams : <any>TurbulenzEngine);
+            loadParams.requestHandler.request({
+                    src: reference,
+                    requestOwner: requestOwner,
+                    onload: loadReference
+                });
+        }
+        else
+        {
+            referenceParameters.push(sceneParameters);
+        }
+    }
+
+    // Adds a resolved root node to the parent node or the data, a node
+    // already loaded with the same path is updated instead
+    addRootNode(loadParams: LoadParameters,
+                nodeName: string,
+                fileNode: SceneNodeParameters)
+    {
+        var nodesMap = this.nodesMap;
+        var nodesNamePrefix = loadParams.nodesNamePrefix;
+        var nodePath = (nodesNamePrefix ? (nodesNamePrefix + "/" + nodeName) : nodeName);
+        var overloadedNode = nodesMap[nodePath];
+
+        if (overloadedNode)
+        {
+            //Utilities.log("Overloaded node '" + nodePath + "'");
+
+            var overloadedMatrix = overloadedNode.matrix;
+            if (overloadedMatrix && fileNode.matrix)
+            {
+                overloadedNode.matrix = VMath.m43Mul(fileNode.matrix, overloadedMatrix);
+                overloadedMatrix = null;
+            }
+
+            var overloadedChildren = overloadedNode.nodes;
+            if (overloadedChildren && fileNode.nodes)
+            {
+                //Utilities.log("Concat children of node '" + nodePath + "'");
+                for (var c in fileNode.nodes)
+                {
+                    if (fileNode.nodes.hasOwnProperty(c))
                     {
-                        this.data.nodes[fn] = fileNode;
+                        overloadedChildren[c] = fileNode.nodes[c];
                     }
+                }
+            }
+            else if (fileNode.nodes)
+            {
+                overloadedNode.nodes = fileNode.nodes;
+            }
 
-                    nodesMap[nodePath] = fileNode;
+            for (var on in fileNode)
+            {
+                if (fileNode.hasOwnProperty(on))
+                {
+                    overloadedNode[on] = fileNode[on];
                 }
             }
         }
+        else
+        {
+            var parentNode = loadParams.parentNode;
+            if (loadParams.isReference && parentNode)
+            {
+                if (!parentNode.nodes)
+                {
+                    parentNode.nodes = {};
+                }
+                parentNode.nodes[nodeName] = fileNode;
+            }
+            else
+            {
+                this.data.nodes[nodeName] = fileNode;
+            }
 
-        this.numReferencesPending += numReferences;
-        //Utilities.log("total refs now " + this.numReferencesPending);
+            nodesMap[nodePath] = fileNode;
+        }
     }
 
     //
@@ -598,9 +683,9 @@ class ResourceLoader
     }
 
     //
-    // resolve
+    // resolveData
     //
-    resolve(loadParams)
+    resolveData(loadParams)
     {
         if (!loadParams.append)
         {
@@ -646,24 +731,146 @@ class ResourceLoader
         this.resolveSkeletons(loadParams);
 
         this.resolveAnimations(loadParams);
+    }
+
+    //
+    // resolve
+    //
+    resolve(loadParams)
+    {
+        var traceId = (typeof Trace !== "undefined" ? Trace.newId() : 0);
+        if (traceId)
+        {
+            Trace.beginAsync("ResourceLoader.resolve", traceId, "scene",
+                             { isReference: !!loadParams.isReference });
+        }
 
-        this.resolveNodes(loadParams);
+        this.jobs.push({
+            loadParams: loadParams,
+            stage: 0,
+            nodeTasks: null,
+            traceId: traceId
+        });
 
-        this.resolvePhysicsNodes(loadParams);
+        // Resolves requested while resolving are done in order
+        if (!this.running)
+        {
+            this.processJobs();
+        }
+    }
 
-        this.resolveAreas(loadParams);
+    // Resolving longer than maxTime milliseconds continues on the callback
+    // given to yieldFn, by default the next call to TurbulenzEngine.setTimeout
+    setTimeBudget(maxTime: number, yieldFn?: { (callback: { (): void; }): void; })
+    {
+        this.maxTime = maxTime;
+        this.yieldFn = (yieldFn || ResourceLoader.defaultYield);
+    }
+
+    getNumPendingJobs(): number
+    {
+        return this.jobs.length;
+    }
+
+    // Resolves the pending jobs in order until they are all done or the
+    // time budget is used
+    processJobs()
+    {
+        var jobs = this.jobs;
+        var maxTime = this.maxTime;
+        var endTime = (maxTime > 0 ? (TurbulenzEngine.getTime() + maxTime) : 0);
 
-        if (loadParams.isReference)
+        this.running = true;
+
+        var tracing = (typeof Trace !== "undefined" && Trace.enabled);
+        if (tracing)
+        {
+            Trace.begin("ResourceLoader.processJobs", "scene", { numJobs: jobs.length });
+        }
+
+        while (jobs.length)
+        {
+            var job = jobs[0];
+            if (this.resolveJob(job, endTime))
+            {
+                jobs.shift();
+
+                if (job.traceId)
+                {
+                    Trace.endAsync("ResourceLoader.resolve", job.traceId, "scene");
+                }
+
+                var loadParams = job.loadParams;
+                if (loadParams.isReference)
+                {
+                    this.numReferencesPending -= 1;
+                    //Utilities.log("loaded ref now " + this.numReferencesPending);
+                }
+
+                if (this.numReferencesPending <= 0)
+                {
+                    this.endLoading(loadParams.onload);
+                }
+            }
+
+            if (endTime &&
+                jobs.length &&
+                TurbulenzEngine.getTime() >= endTime)
+            {
+                if (tracing)
+                {
+                    Trace.end("ResourceLoader.processJobs", "scene");
+                }
+                this.yieldFn(this.resumeFn);
+                return;
+            }
+        }
+
+        if (tracing)
+        {
+            Trace.end("ResourceLoader.processJobs", "scene");
+        }
+
+        this.running = false;
+    }
+
+    // Returns true once the job is complete, nodes are resolved one at a
+    // time until endTime if there is one
+    resolveJob(job: ResourceLoaderJob, endTime: number): boolean
+    {
+        var loadParams = job.loadParams;
+
+        if (job.stage === 0)
         {
-            this.numReferencesPending -= 1;
-            //Utilities.log("loaded ref now " + this.numReferencesPending);
+            this.resolveData(loadParams);
+            job.nodeTasks = this.beginResolveNodes(loadParams);
+            job.stage = 1;
         }
 
-        if (this.numReferencesPending <= 0)
+        if (job.stage === 1)
         {
-            this.endLoading(loadParams.onload);
+            var nodeTasks = job.nodeTasks;
+            while (nodeTasks.length)
+            {
+                this.resolveNextNode(loadParams, nodeTasks);
+
+                if (endTime && TurbulenzEngine.getTime() >= endTime)
+                {
+                    if (nodeTasks.length)
+                    {
+                        return false;
+                    }
+                }
+            }
+            job.nodeTasks = null;
+            job.stage = 2;
         }
 
+        this.resolvePhysicsNodes(loadParams);
+
+        this.resolveAreas(loadParams);
+
+        return true;
     }
 
     //
@@ -677,11 +884,24 @@ class ResourceLoader
             var sceneData = {};
             if (text)
             {
+                var tracing = (typeof Trace !== "undefined" && Trace.enabled);
+                if (tracing)
+                {
+                    Trace.begin("JSON.parse", "scene", { src: assetPath, length: text.length });
+                }
+
                 sceneData = JSON.parse(text);
+
+                if (tracing)
+                {
+                    Trace.end("JSON.parse", "scene");
+                }
             }
 
             loadParams.data = sceneData;
             loadParams.append = false;
+            // Nothing else uses the data parsed here
+            loadParams.ownsData = true;
             loader.resolve(loadParams);
         };
 
@@ -692,6 +912,24 @@ class ResourceLoader
             });
     }
 
+    static copyObject(o: any): any
+    {
+        var newObj = { };
+        for (var p in o)
+        {
+            if (o.hasOwnProperty(p))
+            {
+                newObj[p] = o[p];
+            }
+        }
+        return newObj;
+    }
+
+    static defaultYield(callback: { (): void; })
+    {
+        TurbulenzEngine.setTimeout(callback, 0);
+    }
+
     // Constructor function
     static create() : ResourceLoader
     {
@@ -700,6 +938,15 @@ class ResourceLoader
 
         rl.skeletonNames = {};
 
+        rl.maxTime = 0;
+        rl.yieldFn = ResourceLoader.defaultYield;
+        rl.jobs = [];
+        rl.running = false;
+        rl.resumeFn = function resourceLoaderResumeFn()
+        {
+            rl.processJobs();
+        };
+
         return rl;
     }
 }
@@ -13,6 +13,8 @@
 /*global Uint16Array*/
 /*global Uint32Array*/
 /*global Float32Array*/
+/*global TurbulenzEngine*/
+/*global Trace*/
 
 /* tslint:disable:max-line-length */
 
@@ -32,6 +34,12 @@ interface SceneArea
     target?        : SceneNode;
     queryCounter?  : number;
     externalNodes? : SceneNode[];
+
+    // Area streaming
+    streamingShapes?    : SceneStreamedShape[];
+    streamingMaterials? : SceneStreamedMaterial[];
+    streamingRequested? : boolean;
+    streamingDistance?  : number;
 };
 
 interface SceneBSPNode
@@ -41,6 +49,99 @@ interface SceneBSPNode
     neg: any; // TODO:
 };
 
+// Shape created without buffers, loaded while an area using it is requested
+interface SceneStreamedShape
+{
+    name         : string;
+    fileName     : string;
+    shape        : Geometry;
+    loadParams   : any;
+    instances    : GeometryInstance[];
+    references   : number;  // requested areas using the shape, plus pins
+    pinned       : boolean; // used outside of the areas
+    resident     : boolean;
+    queued       : boolean;
+    bytes        : number;
+    distance     : number;  // nearest requesting area when queued
+    queryCounter : number;
+};
+
+// Material whose textures are loaded while an area using it is requested
+interface SceneStreamedMaterial
+{
+    material     : Material;
+    instances    : GeometryInstance[];
+    references   : number;
+    pinned       : boolean;
+    external     : boolean; // used by geometry that is not streamed
+    queryCounter : number;
+};
+
+// Texture of the streamed materials, counted towards the streaming budget
+interface SceneStreamedTexture
+{
+    instance   : TextureInstance;
+    references : number;
+    bytes      : number;
+};
+
+interface SceneAreaStreamingParams
+{
+    loadDistance    : number;
+    unloadDistance? : number;
+    maxBytes?       : number;
+    maxTime?        : number;
+};
+
+interface SceneAreaStreaming
+{
+    loadDistance   : number;
+    unloadDistance : number;
+    maxBytes       : number;
+    maxTime        : number;
+    yieldFn        : { (callback: { (): void; }): void; };
+    graphicsDevice : GraphicsDevice;
+    textureManager : TextureManager;
+    shapes         : { [name: string]: SceneStreamedShape; };
+    materials      : { [name: string]: SceneStreamedMaterial; };
+    textures       : { [name: string]: SceneStreamedTexture; };
+    requestedAreas : SceneArea[];
+    budgetDistance : number; // areas as far were released to keep within maxBytes
+    queue          : SceneStreamedShape[];
+    queryExtents   : any; // Array or Float32Array(6)
+    bytes          : number;
+    running        : boolean;
+    resume         : { (): void; };
+    onTextureChanged : { (textureInstance: TextureInstance): void; };
+};
+
+interface SceneStaticBatchingParams
+{
+    cellSize?            : number; // grid cell size for instances outside areas
+    maxVertices?         : number; // per batch, at most 65536
+    maxInstanceVertices? : number; // larger instances are not batched
+};
+
+// Rigid instances of static nodes merged into a single renderable, the
+// indices of every instance are kept as a piece to cull them individually
+interface SceneStaticBatch
+{
+    renderable   : GeometryInstance;
+    node         : SceneNode;
+    instances    : GeometryInstance[]; // disabled while batched
+    vertexBuffer : VertexBuffer;
+    indexBuffer  : IndexBuffer;
+    indexData    : any; // Uint16Array, indices of all the pieces followed by the compacted ones
+    numIndices   : number;
+    pieceExtents : any[]; // world extents of every piece
+    pieceFirst   : any; // Uint32Array
+    pieceCount   : any; // Uint32Array
+    visible      : any; // Uint8Array, pieces visible on the last update
+    compacted    : any; // Uint16Array after the full list, visible indices when not contiguous
+    first        : number; // current range for the camera passes
+    count        : number;
+};
+
 interface SpatialMap
 {
     add: (externalNode, extents: any) => void;
@@ -61,7 +162,7 @@ interface SpatialMap
 class Scene
 {
     /* tslint:disable:no-unused-variable */
-    static version = 1;
+    static version = 3;
     /* tslint:enable:no-unused-variable */
 
     md: MathDevice;
@@ -116,6 +217,10 @@ class Scene
 
     bspNodes: SceneBSPNode[];
 
+    streaming: SceneAreaStreaming;
+
+    staticBatches: SceneStaticBatch[];
+
     float32ArrayConstructor: any; // on prototype
     uint16ArrayConstructor: any; // on prototype
     uint32ArrayConstructor: any; // on prototype
@@ -134,12 +239,43 @@ class Scene
         {
             geometry.reference.unsubscribeDestroyed(scene.onGeometryDestroyed);
             delete scene.shapes[geometry.name];
+
+            var streaming = scene.streaming;
+            if (streaming)
+            {
+                var streamedShape = streaming.shapes[geometry.name];
+                if (streamedShape && streamedShape.shape === geometry)
+                {
+                    if (streamedShape.resident)
+                    {
+                        streamedShape.resident = false;
+                        streaming.bytes -= streamedShape.bytes;
+                    }
+                    streamedShape.shape = null;
+                    delete streaming.shapes[geometry.name];
+                }
+            }
         };
 
         this.onMaterialDestroyed = function sceneOnMaterialDestroyedFn(material)
         {
             material.reference.unsubscribeDestroyed(scene.onMaterialDestroyed);
             delete scene.materials[material.name];
+
+            var streaming = scene.streaming;
+            if (streaming)
+            {
+                var streamedMaterial = streaming.materials[material.name];
+                if (streamedMaterial && streamedMaterial.material === material)
+                {
+                    if (streamedMaterial.references > 0 && streaming.textureManager)
+                    {
+                        scene._referenceStreamedTextures(material, -1);
+                    }
+                    streamedMaterial.material = null;
+                    delete streaming.materials[material.name];
+                }
+            }
         };
     }
 
@@ -157,6 +293,8 @@ class Scene
     drawAnimationHierarchy: (gd, sm, camera, hierarchy, numJoints, controller, matrix, boneColor, boundsColor) => void;
     getDebugSemanticsPos: () => Semantics;
     getDebugSemanticsPosCol: () => Semantics;
+    beginDebugDraw: (gd, primitive, numVertices, formats, semantics) => any;
+    endDebugDraw: (gd, writer) => void;
     getMetrics: () => any;
     getVisibilityMetrics: () => any;
     drawWireframe: (gd, sm, camera, wireframeInfo) => void;
@@ -1978,6 +2116,11 @@ class Scene
             this._updateVisibleNodesNoAreas(camera);
         }
 
+        if (this.staticBatches)
+        {
+            this._updateStaticBatches();
+        }
+
         this.frameIndex += 1;
     }
 
@@ -2691,6 +2834,13 @@ class Scene
             //Note this leaves extents of areas as large as they ever got.
             this.initializeAreas();
         }
+
+        // The debug drawing rings move on to their next region every frame
+        var vertexBufferManager = this.vertexBufferManager;
+        if (vertexBufferManager)
+        {
+            vertexBufferManager.nextFrame();
+        }
     }
 
     //
@@ -3016,6 +3166,11 @@ class Scene
     //
     clear()
     {
+        if (this.staticBatches)
+        {
+            this.clearStaticBatches();
+        }
+        this.staticBatches = null;
         this.effects = [];
         this.effectsMap = {};
         this.semantics = <Semantics><any>{}; // TODO: null?
@@ -3044,6 +3199,7 @@ class Scene
         this.overlappingPortals = [];
         this.newPoints = [];
         this.queryVisibleNodes = [];
+        this.streaming = null;
     }
 
     //
@@ -3452,228 +3608,988 @@ class Scene
             }
         }
         this.areaInitalizeStaticNodesChangeCounter = this.staticNodesChangeCounter;
+
+        if (this.streaming)
+        {
+            this.initializeAreaStreaming();
+        }
     }
 
     //
-    // createMaterial
+    // initializeAreaStreaming
     //
-    createMaterial(materialName, fileMaterial, effectName, fileEffects, fileImages, graphicsDevice)
+    // Builds the lists of streamed shapes and materials used by each area,
+    // the ones also used outside of the areas are pinned.
+    initializeAreaStreaming()
     {
-        var materials = this.materials;
+        var streaming = this.streaming;
+        var shapes = streaming.shapes;
+        var materials = streaming.materials;
+        var areas = this.areas;
+        var requestedAreas = streaming.requestedAreas;
+        var numRequestedAreas = requestedAreas.length;
+        var n, i, p, area;
 
-        var material = Material.create(graphicsDevice);
-        var param, filename, effectType, p;
-        var fileEffectMeta;
+        var oldShapes = [];
+        var oldMaterials = [];
+        for (n = 0; n < numRequestedAreas; n += 1)
+        {
+            area = requestedAreas[n];
+            oldShapes[n] = area.streamingShapes;
+            oldMaterials[n] = area.streamingMaterials;
+        }
 
-        // Effect associated, load from file
-        if (fileEffects)
+        if (areas)
         {
-            var fileEffect = fileEffects[effectName];
-            if (fileEffect)
+            var numAreas = areas.length;
+            for (n = 0; n < numAreas; n += 1)
             {
-                var effectParameters = fileEffect.parameters;
-                for (p in effectParameters)
+                area = areas[n];
+                var queryCounter = this.getQueryCounter();
+                var areaShapes = [];
+                var areaMaterials = [];
+                var nodes = area.nodes;
+                var numNodes = area.numStaticNodes;
+                for (i = 0; i < numNodes; i += 1)
                 {
-                    if (effectParameters.hasOwnProperty(p))
+                    var renderables = nodes[i].renderables;
+                    if (renderables)
                     {
-                        param = effectParameters[p];
-                        if (typeof param === 'string')
+                        var numRenderables = renderables.length;
+                        for (var r = 0; r < numRenderables; r += 1)
                         {
-                            if (fileImages)
-                            {
-                                filename = fileImages[param] || param;
-                            }
-                            else
+                            var renderable = renderables[r];
+                            var geometry = renderable.geometry;
+                            var streamedShape = (geometry ? shapes[geometry.name] : null);
+                            if (streamedShape &&
+                                streamedShape.queryCounter !== queryCounter)
                             {
-                                filename = param;
+                                streamedShape.queryCounter = queryCounter;
+                                areaShapes.push(streamedShape);
                             }
-
-                            if (!material.texturesNames)
+                            var material = renderable.sharedMaterial;
+                            var streamedMaterial = (material ? materials[material.name] : null);
+                            if (streamedMaterial &&
+                                streamedMaterial.queryCounter !== queryCounter)
                             {
-                                material.texturesNames = {};
+                                streamedMaterial.queryCounter = queryCounter;
+                                areaMaterials.push(streamedMaterial);
                             }
-                            material.texturesNames[p] = filename;
-                            material.techniqueParameters[p] = null;
-                        }
-                        else
-                        {
-                            material.techniqueParameters[p] = param;
                         }
                     }
                 }
-                effectType = fileEffect.type;
-                fileEffectMeta = fileEffect.meta;
-            }
-            else
-            {
-                effectType = effectName;
+                area.streamingShapes = areaShapes;
+                area.streamingMaterials = areaMaterials;
             }
         }
-        else
-        {
-            effectType = effectName;
-        }
 
-        var materialParameters = fileMaterial.parameters;
-        for (p in materialParameters)
+        // New references are added before the old ones are removed so the
+        // resources still in use are not reloaded
+        var unpinnedShapes = [];
+        var unpinnedMaterials = [];
+        var pinned;
+        for (p in shapes)
         {
-            if (materialParameters.hasOwnProperty(p))
+            if (shapes.hasOwnProperty(p))
             {
-                param = materialParameters[p];
-                if (typeof param === 'string')
+                var shapeToPin = shapes[p];
+                pinned = (!areas || Scene._isUsedOutsideAreas(shapeToPin.instances));
+                if (pinned !== shapeToPin.pinned)
                 {
-                    if (fileImages)
+                    shapeToPin.pinned = pinned;
+                    if (pinned)
                     {
-                        filename = fileImages[param] || param;
+                        this._acquireStreamedShape(shapeToPin, 0);
                     }
                     else
                     {
-                        filename = param;
-                    }
-
-                    if (!material.texturesNames)
-                    {
-                        material.texturesNames = {};
+                        unpinnedShapes.push(shapeToPin);
                     }
-                    material.texturesNames[p] = filename;
-
-                    material.techniqueParameters[p] = null;
-                }
-                else
-                {
-                    material.techniqueParameters[p] = param;
                 }
             }
         }
-
-        material.effectName = effectType;
-
-        var fileMaterialMeta = fileMaterial.meta;
-        if (fileMaterialMeta)
+        for (p in materials)
         {
-            if (fileEffectMeta)
+            if (materials.hasOwnProperty(p))
             {
-                for (p in fileEffectMeta)
+                var materialToPin = materials[p];
+                pinned = (!areas ||
+                          materialToPin.external ||
+                          Scene._isUsedOutsideAreas(materialToPin.instances));
+                if (pinned !== materialToPin.pinned)
                 {
-                    if (fileEffectMeta.hasOwnProperty(p) &&
-                        !fileMaterialMeta.hasOwnProperty(p))
+                    materialToPin.pinned = pinned;
+                    if (pinned)
                     {
-                        fileMaterialMeta[p] = fileEffectMeta[p];
+                        this._acquireStreamedMaterial(materialToPin);
+                    }
+                    else
+                    {
+                        unpinnedMaterials.push(materialToPin);
                     }
                 }
             }
-            material.meta = fileMaterialMeta;
         }
-        else if (fileEffectMeta)
+
+        for (n = 0; n < numRequestedAreas; n += 1)
         {
-            material.meta = fileEffectMeta;
+            area = requestedAreas[n];
+            this._acquireStreamedResources(area.streamingShapes,
+                                           area.streamingMaterials,
+                                           area.streamingDistance);
         }
+        for (n = 0; n < numRequestedAreas; n += 1)
+        {
+            this._releaseStreamedResources(oldShapes[n], oldMaterials[n]);
+        }
+        this._releaseStreamedResources(unpinnedShapes, unpinnedMaterials);
 
-        materials[materialName] = material;
-        material.name = materialName;
-        material.reference.subscribeDestroyed(this.onMaterialDestroyed);
-
-        return material;
+        if (streaming.queue.length && !streaming.running)
+        {
+            this._startAreaStreaming();
+        }
     }
 
     //
-    // loadMaterials
+    // updateAreaStreaming
     //
-    loadMaterials(loadParams)
+    // Requests the areas within the load distance of the position and
+    // releases the ones beyond the unload distance, returns the number of
+    // shapes waiting to be loaded.
+    updateAreaStreaming(position): number
     {
-        var sceneData = loadParams.data;
-        var gd = loadParams.graphicsDevice;
-        var textureManager = loadParams.textureManager;
-        var createMaterial = this.createMaterial;
-
-        if (!loadParams.append)
+        var streaming = this.streaming;
+        if (!streaming)
         {
-            this.effects = [];
-            this.effectsMap = {};
-            this.clearMaterials();
+            return 0;
         }
 
-        // Import materials
-        var fileMaterials = sceneData.materials;
-        if (fileMaterials)
+        var areas = this.areas;
+        if (areas)
         {
-            var fileImages = sceneData.images;
-            var fileEffects = sceneData.effects;
-            var materials = this.materials;
-            for (var m in fileMaterials)
+            var p0 = position[0];
+            var p1 = position[1];
+            var p2 = position[2];
+            var loadDistance = streaming.loadDistance;
+            var unloadDistance = Math.max(streaming.unloadDistance, loadDistance);
+            var requestedAreas = streaming.requestedAreas;
+            var numRequestedAreas = requestedAreas.length;
+            var areaDistance = Scene._areaDistance;
+            var n, area, distance;
+
+            // Areas beyond the unload distance are released after the new
+            // ones are requested so the resources they share are kept
+            var releasedAreas = [];
+            n = 0;
+            while (n < numRequestedAreas)
             {
-                if (fileMaterials.hasOwnProperty(m) &&
-                    !materials[m])
+                area = requestedAreas[n];
+                distance = areaDistance(area.extents, p0, p1, p2);
+                if (distance > unloadDistance)
                 {
-                    var fileMaterial = fileMaterials[m];
-                    var effectName = (fileMaterial.effect || "default");
-                    createMaterial.call(this, m, fileMaterial, effectName, fileEffects, fileImages, gd, textureManager);
+                    releasedAreas.push(area);
+                    numRequestedAreas -= 1;
+                    requestedAreas[n] = requestedAreas[numRequestedAreas];
+                    requestedAreas.length = numRequestedAreas;
+                }
+                else
+                {
+                    area.streamingDistance = distance;
+                    n += 1;
                 }
             }
-        }
-    }
 
-    //
-    // loadSkeletons
-    //
-    loadSkeletons(loadParams)
-    {
-        var sceneData = loadParams.data;
-        var fileSkeletons = sceneData.skeletons;
-
-        var md = this.md;
-        var m43Build = md.m43Build;
-
-        var invLTM, bindPose;
-
-        for (var s in fileSkeletons)
-        {
-            if (fileSkeletons.hasOwnProperty(s))
+            // Releasing areas may make room for the ones dropped to keep
+            // within the budget
+            if (releasedAreas.length)
             {
-                var skeleton = fileSkeletons[s];
-
-                var numJoints = skeleton.numNodes;
-                var invLTMs = skeleton.invBoneLTMs;
-                var bindPoses = skeleton.bindPoses;
-
-                // copy the inv bone ltms and bind poses to make them native
-                for (var b = 0; b < numJoints; b += 1)
+                streaming.budgetDistance = Number.MAX_VALUE;
+            }
+            var budgetDistance = streaming.budgetDistance;
+
+            // Only the areas reachable through portals are requested
+            var bspNodes = this.bspNodes;
+            var extents = streaming.queryExtents;
+            extents[0] = (p0 - loadDistance);
+            extents[1] = (p1 - loadDistance);
+            extents[2] = (p2 - loadDistance);
+            extents[3] = (p0 + loadDistance);
+            extents[4] = (p1 + loadDistance);
+            extents[5] = (p2 + loadDistance);
+
+            var candidateAreas;
+            var areaIndex = this.findAreaIndex(bspNodes, p0, p1, p2);
+            if (areaIndex >= 0)
+            {
+                candidateAreas = this.findOverlappingAreas(areaIndex, extents);
+                candidateAreas.push(areas[areaIndex]);
+            }
+            else
+            {
+                var areaIndices = this.findAreaIndicesAABB(bspNodes,
+                                                           extents[0], extents[1], extents[2],
+                                                           extents[3], extents[4], extents[5]);
+                var numAreaIndices = areaIndices.length;
+                candidateAreas = [];
+                for (n = 0; n < numAreaIndices; n += 1)
                 {
-                    invLTM = invLTMs[b];
-                    bindPose = bindPoses[b];
+                    candidateAreas[n] = areas[areaIndices[n]];
+                }
+            }
 
-                    invLTMs[b] = m43Build.apply(md, invLTM);
-                    bindPoses[b] = m43Build.apply(md, bindPose);
+            var newAreas = [];
+            var numCandidateAreas = candidateAreas.length;
+            for (n = 0; n < numCandidateAreas; n += 1)
+            {
+                area = candidateAreas[n];
+                if (!area.streamingRequested)
+                {
+                    distance = areaDistance(area.extents, p0, p1, p2);
+                    if (distance <= loadDistance &&
+                        distance < budgetDistance)
+                    {
+                        area.streamingDistance = distance;
+                        newAreas.push(area);
+                    }
                 }
+            }
 
-                if (loadParams.skeletonNamePrefix)
+            var numNewAreas = newAreas.length;
+            if (numNewAreas)
+            {
+                // Nearest areas are loaded first
+                newAreas.sort(function sortAreasFn(a, b) {
+                    return (a.streamingDistance - b.streamingDistance);
+                });
+                for (n = 0; n < numNewAreas; n += 1)
                 {
-                    s = loadParams.skeletonNamePrefix + s;
+                    area = newAreas[n];
+                    this._requestStreamedArea(area);
+                    requestedAreas.push(area);
                 }
+                streaming.queue.sort(function sortShapesFn(a, b) {
+                    return (a.distance - b.distance);
+                });
+            }
 
-                this.skeletons[s] = skeleton;
+            var numReleasedAreas = releasedAreas.length;
+            for (n = 0; n < numReleasedAreas; n += 1)
+            {
+                this._releaseStreamedArea(releasedAreas[n]);
+            }
+
+            // Areas kept by the unload distance are the first to go when
+            // over budget, then the farthest ones within the load distance
+            // except the nearest, and areas as far are not requested again
+            // until others are released
+            var maxBytes = streaming.maxBytes;
+            while (maxBytes < streaming.bytes)
+            {
+                if (this._evictStreamedArea(loadDistance) < 0)
+                {
+                    break;
+                }
+            }
+            while (maxBytes < streaming.bytes &&
+                   1 < requestedAreas.length)
+            {
+                streaming.budgetDistance = this._evictStreamedArea(-1);
             }
         }
+
+        var queue = streaming.queue;
+        if (queue.length && !streaming.running)
+        {
+            this._startAreaStreaming();
+        }
+        return queue.length;
     }
 
-    // For cases where > 1-index per vertex we process it to create 1-index per vertex from data
-    _updateSingleIndexTables(surface,
-                             indicesPerVertex,
-                             verticesAsIndexLists,
-                             verticesAsIndexListTable,
-                             numUniqueVertices)
+    //
+    // getAreaStreamingBytes
+    //
+    getAreaStreamingBytes(): number
     {
-        var faces = surface.faces;
-        var numIndices = faces.length;
-
-        var newFaces = [];
-        newFaces.length = numIndices;
+        var streaming = this.streaming;
+        return (streaming ? streaming.bytes : 0);
+    }
 
-        var numUniqueVertIndex = verticesAsIndexLists.length;
-        var vertIdx = 0;
-        var srcIdx = 0;
-        var n, maxn, index;
-        var currentLevel, nextLevel, thisVertIndex;
+    _addStreamedInstance(instance: GeometryInstance): void
+    {
+        var streaming = this.streaming;
+        var material = instance.sharedMaterial;
+        var streamedMaterial = streaming.materials[material.name];
+        if (!streamedMaterial)
+        {
+            streamedMaterial = {
+                material: material,
+                instances: [],
+                references: 0,
+                pinned: false,
+                external: false,
+                queryCounter: -1
+            };
+            streaming.materials[material.name] = streamedMaterial;
+        }
+
+        var geometry = instance.geometry;
+        var streamedShape = streaming.shapes[geometry.name];
+        if (streamedShape && streamedShape.shape === geometry)
+        {
+            streamedShape.instances.push(instance);
+            streamedMaterial.instances.push(instance);
+            instance.disabled = (!streamedShape.resident || streamedMaterial.references === 0);
+        }
+        else
+        {
+            // Geometry loaded up front, the material keeps its textures
+            streamedMaterial.external = true;
+        }
+    }
+
+    _requestStreamedArea(area: SceneArea): void
+    {
+        area.streamingRequested = true;
+        this._acquireStreamedResources(area.streamingShapes,
+                                       area.streamingMaterials,
+                                       area.streamingDistance);
+    }
+
+    _releaseStreamedArea(area: SceneArea): void
+    {
+        area.streamingRequested = false;
+        this._releaseStreamedResources(area.streamingShapes,
+                                       area.streamingMaterials);
+    }
+
+    // Releases the farthest requested area beyond the given distance,
+    // returns its distance or -1 if there is none
+    _evictStreamedArea(minDistance: number): number
+    {
+        var requestedAreas = this.streaming.requestedAreas;
+        var numRequestedAreas = requestedAreas.length;
+        var farthestIndex = -1;
+        var farthestDistance = minDistance;
+        for (var n = 0; n < numRequestedAreas; n += 1)
+        {
+            var distance = requestedAreas[n].streamingDistance;
+            if (distance > farthestDistance)
+            {
+                farthestDistance = distance;
+                farthestIndex = n;
+            }
+        }
+
+        if (farthestIndex < 0)
+        {
+            return -1;
+        }
+
+        this._releaseStreamedArea(requestedAreas[farthestIndex]);
+        numRequestedAreas -= 1;
+        requestedAreas[farthestIndex] = requestedAreas[numRequestedAreas];
+        requestedAreas.length = numRequestedAreas;
+        return farthestDistance;
+    }
+
+    _acquireStreamedResources(shapes: SceneStreamedShape[],
+                              materials: SceneStreamedMaterial[],
+                              distance: number): void
+    {
+        var n;
+        if (shapes)
+        {
+            var numShapes = shapes.length;
+            for (n = 0; n < numShapes; n += 1)
+            {
+                this._acquireStreamedShape(shapes[n], distance);
+            }
+        }
+        if (materials)
+        {
+            var numMaterials = materials.length;
+            for (n = 0; n < numMaterials; n += 1)
+            {
+                this._acquireStreamedMaterial(materials[n]);
+            }
+        }
+    }
+
+    _releaseStreamedResources(shapes: SceneStreamedShape[],
+                              materials: SceneStreamedMaterial[]): void
+    {
+        var n;
+        if (shapes)
+        {
+            var numShapes = shapes.length;
+            for (n = 0; n < numShapes; n += 1)
+            {
+                this._releaseStreamedShape(shapes[n]);
+            }
+        }
+        if (materials)
+        {
+            var numMaterials = materials.length;
+            for (n = 0; n < numMaterials; n += 1)
+            {
+                this._releaseStreamedMaterial(materials[n]);
+            }
+        }
+    }
+
+    _acquireStreamedShape(streamedShape: SceneStreamedShape, distance: number): void
+    {
+        var references = streamedShape.references;
+        streamedShape.references = (references + 1);
+        if (references === 0 ||
+            distance < streamedShape.distance)
+        {
+            streamedShape.distance = distance;
+        }
+        if (!streamedShape.resident &&
+            !streamedShape.queued &&
+            streamedShape.shape)
+        {
+            streamedShape.queued = true;
+            this.streaming.queue.push(streamedShape);
+        }
+    }
+
+    _releaseStreamedShape(streamedShape: SceneStreamedShape): void
+    {
+        streamedShape.references -= 1;
+        if (streamedShape.references === 0 &&
+            streamedShape.resident)
+        {
+            var shape = streamedShape.shape;
+            if (shape.vertexBufferAllocation)
+            {
+                shape.vertexBufferManager.free(shape.vertexBufferAllocation);
+                delete shape.vertexBufferManager;
+                delete shape.vertexBufferAllocation;
+            }
+            if (shape.indexBufferAllocation)
+            {
+                shape.indexBufferManager.free(shape.indexBufferAllocation);
+                delete shape.indexBufferManager;
+                delete shape.indexBufferAllocation;
+            }
+            shape.vertexBuffer = null;
+            shape.semantics = null;
+            delete shape.indexBuffer;
+            delete shape.vertexData;
+            delete shape.indexData;
+
+            var surfaces = shape.surfaces;
+            if (surfaces)
+            {
+                for (var s in surfaces)
+                {
+                    if (surfaces.hasOwnProperty(s))
+                    {
+                        var surface = surfaces[s];
+                        delete surface.indexBuffer;
+                        delete surface.vertexData;
+                        delete surface.indexData;
+                    }
+                }
+            }
+
+            streamedShape.resident = false;
+            this.streaming.bytes -= streamedShape.bytes;
+            streamedShape.bytes = 0;
+
+            this._updateStreamedInstances(streamedShape.instances);
+        }
+    }
+
+    _acquireStreamedMaterial(streamedMaterial: SceneStreamedMaterial): void
+    {
+        streamedMaterial.references += 1;
+        var material = streamedMaterial.material;
+        if (streamedMaterial.references === 1 && material)
+        {
+            var textureManager = this.streaming.textureManager;
+            if (textureManager)
+            {
+                material.loadTextures(textureManager);
+                this._referenceStreamedTextures(material, 1);
+            }
+            this._updateStreamedInstances(streamedMaterial.instances);
+        }
+    }
+
+    _releaseStreamedMaterial(streamedMaterial: SceneStreamedMaterial): void
+    {
+        streamedMaterial.references -= 1;
+        var material = streamedMaterial.material;
+        if (streamedMaterial.references === 0 && material)
+        {
+            this._referenceStreamedTextures(material, -1);
+            material.releaseTextures();
+            this._updateStreamedInstances(streamedMaterial.instances);
+        }
+    }
+
+    // Textures shared by several streamed materials are only counted once
+    _referenceStreamedTextures(material: Material, delta: number): void
+    {
+        var streaming = this.streaming;
+        var textures = streaming.textures;
+        var textureInstances = material.textureInstances;
+        for (var p in textureInstances)
+        {
+            if (textureInstances.hasOwnProperty(p))
+            {
+                var textureInstance = textureInstances[p];
+                var name = textureInstance.name;
+                var streamedTexture = textures[name];
+                if (!streamedTexture)
+                {
+                    if (delta < 0)
+                    {
+                        continue;
+                    }
+                    streamedTexture = {
+                        instance: textureInstance,
+                        references: 0,
+                        bytes: 0
+                    };
+                    textures[name] = streamedTexture;
+                    textureInstance.subscribeTextureChanged(streaming.onTextureChanged);
+                }
+
+                streamedTexture.references += delta;
+                if (streamedTexture.references > 0)
+                {
+                    this._updateStreamedTextureBytes(streamedTexture);
+                }
+                else
+                {
+                    textureInstance.unsubscribeTextureChanged(streaming.onTextureChanged);
+                    streaming.bytes -= streamedTexture.bytes;
+                    delete textures[name];
+                }
+            }
+        }
+    }
+
+    // Streamed textures change size as their levels are loaded and dropped
+    _updateStreamedTextureBytes(streamedTexture: SceneStreamedTexture): void
+    {
+        var streaming = this.streaming;
+        var bytes = streaming.textureManager.getTextureBytes(streamedTexture.instance.name);
+        streaming.bytes += (bytes - streamedTexture.bytes);
+        streamedTexture.bytes = bytes;
+    }
+
+    // Instances are only drawn while both their shape and material are loaded
+    _updateStreamedInstances(instances: GeometryInstance[]): void
+    {
+        var streaming = this.streaming;
+        var shapes = streaming.shapes;
+        var materials = streaming.materials;
+        var numInstances = instances.length;
+        var changed = false;
+        for (var n = 0; n < numInstances; n += 1)
+        {
+            var instance = instances[n];
+            var geometry = instance.geometry;
+            var material = instance.sharedMaterial;
+            if (geometry && material)
+            {
+                var streamedShape = shapes[geometry.name];
+                var streamedMaterial = materials[material.name];
+                if ((!streamedShape || streamedShape.resident) &&
+                    (!streamedMaterial || 0 < streamedMaterial.references))
+                {
+                    if (instance.disabled)
+                    {
+                        // Draw parameters are prepared again for the new buffers
+                        instance.disabled = false;
+                        instance.semantics = geometry.semantics;
+                        instance.renderUpdate = undefined;
+                        instance.rendererInfo = undefined;
+                        changed = true;
+                    }
+                }
+                else if (!instance.disabled)
+                {
+                    instance.disabled = true;
+                    changed = true;
+                }
+            }
+        }
+
+        if (changed)
+        {
+            // Renderers cache the static renderables overlapping each light,
+            // the areas do not need to be initialized again
+            var staticNodesChangeCounter = (this.staticNodesChangeCounter + 1);
+            if (this.areaInitalizeStaticNodesChangeCounter === this.staticNodesChangeCounter)
+            {
+                this.areaInitalizeStaticNodesChangeCounter = staticNodesChangeCounter;
+            }
+            this.staticNodesChangeCounter = staticNodesChangeCounter;
+        }
+    }
+
+    _startAreaStreaming(): void
+    {
+        var streaming = this.streaming;
+        if (!streaming.resume)
+        {
+            var scene = this;
+            streaming.resume = function sceneStreamAreaShapesFn()
+            {
+                // The scene may have been cleared or reloaded meanwhile
+                if (scene.streaming === streaming)
+                {
+                    scene._streamAreaShapes();
+                }
+            };
+        }
+        streaming.running = true;
+        streaming.yieldFn(streaming.resume);
+    }
+
+    _streamAreaShapes(): void
+    {
+        var streaming = this.streaming;
+        var queue = streaming.queue;
+        var maxBytes = streaming.maxBytes;
+        var endTime = (TurbulenzEngine.getTime() + streaming.maxTime);
+        var blocked = false;
+
+        while (queue.length)
+        {
+            var streamedShape = queue[0];
+            if (0 < streamedShape.references && streamedShape.shape)
+            {
+                // Make room releasing areas farther than the ones waiting
+                // for this shape, otherwise wait for areas to be released
+                while (maxBytes <= streaming.bytes)
+                {
+                    if (this._evictStreamedArea(streamedShape.distance) < 0)
+                    {
+                        break;
+                    }
+                }
+                if (maxBytes <= streaming.bytes)
+                {
+                    blocked = true;
+                    break;
+                }
+
+                if (0 < streamedShape.references)
+                {
+                    this._loadStreamedShape(streamedShape);
+                }
+            }
+            queue.shift();
+            streamedShape.queued = false;
+
+            if (endTime <= TurbulenzEngine.getTime())
+            {
+                break;
+            }
+        }
+
+        if (queue.length && !blocked)
+        {
+            streaming.yieldFn(streaming.resume);
+        }
+        else
+        {
+            streaming.running = false;
+        }
+    }
+
+    _loadStreamedShape(streamedShape: SceneStreamedShape): void
+    {
+        var shape = streamedShape.shape;
+        if (this.loadShape(streamedShape.name,
+                           streamedShape.fileName,
+                           streamedShape.loadParams,
+                           shape))
+        {
+            var streaming = this.streaming;
+            var gd = streaming.graphicsDevice;
+
+            // Approximate, vertex values are counted as 4 bytes
+            var bytes = 0;
+            var vertexBufferAllocation = shape.vertexBufferAllocation;
+            if (vertexBufferAllocation)
+            {
+                bytes += (vertexBufferAllocation.length * vertexBufferAllocation.vertexBuffer.stride * 4);
+            }
+            var indexBufferAllocation = shape.indexBufferAllocation;
+            if (indexBufferAllocation)
+            {
+                bytes += (indexBufferAllocation.length *
+                          (indexBufferAllocation.indexBuffer.format === gd.INDEXFORMAT_UINT ? 4 : 2));
+            }
+
+            streamedShape.bytes = bytes;
+            streamedShape.resident = true;
+            streaming.bytes += bytes;
+
+            this._updateStreamedInstances(streamedShape.instances);
+        }
+    }
+
+    static _isUsedOutsideAreas(instances: GeometryInstance[]): boolean
+    {
+        // Every static node with renderables is added to an area
+        var numInstances = instances.length;
+        for (var n = 0; n < numInstances; n += 1)
+        {
+            var instance = instances[n];
+            if (instance.geometry)
+            {
+                var node = instance.node;
+                if (!node || node.dynamic)
+                {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    static _areaDistance(extents, p0: number, p1: number, p2: number): number
+    {
+        var d0 = (p0 < extents[0] ? (extents[0] - p0) : (p0 > extents[3] ? (p0 - extents[3]) : 0));
+        var d1 = (p1 < extents[1] ? (extents[1] - p1) : (p1 > extents[4] ? (p1 - extents[4]) : 0));
+        var d2 = (p2 < extents[2] ? (extents[2] - p2) : (p2 > extents[5] ? (p2 - extents[5]) : 0));
+        return Math.sqrt((d0 * d0) + (d1 * d1) + (d2 * d2));
+    }
+
+    static defaultYield(callback: { (): void; }): void
+    {
+        TurbulenzEngine.setTimeout(callback, 0);
+    }
+
+    //
+    // createMaterial
+    //
+    createMaterial(materialName, fileMaterial, effectName, fileEffects, fileImages, graphicsDevice)
+    {
+        var materials = this.materials;
+
+        var material = Material.create(graphicsDevice);
+        var param, filename, effectType, p;
+        var fileEffectMeta;
+
+        // Effect associated, load from file
+        if (fileEffects)
+        {
+            var fileEffect = fileEffects[effectName];
+            if (fileEffect)
+            {
+                var effectParameters = fileEffect.parameters;
+                for (p in effectParameters)
+                {
+                    if (effectParameters.hasOwnProperty(p))
+                    {
+                        param = effectParameters[p];
+                        if (typeof param === 'string')
+                        {
+                            if (fileImages)
+                            {
+                                filename = fileImages[param] || param;
+                            }
+                            else
+                            {
+                                filename = param;
+                            }
+
+                            if (!material.texturesNames)
+                            {
+                                material.texturesNames = {};
+                            }
+                            material.texturesNames[p] = filename;
+                            material.techniqueParameters[p] = null;
+                        }
+                        else
+                        {
+                            material.techniqueParameters[p] = param;
+                        }
+                    }
+                }
+                effectType = fileEffect.type;
+                fileEffectMeta = fileEffect.meta;
+            }
+            else
+            {
+                effectType = effectName;
+            }
+        }
+        else
+        {
+            effectType = effectName;
+        }
+
+        var materialParameters = fileMaterial.parameters;
+        for (p in materialParameters)
+        {
+            if (materialParameters.hasOwnProperty(p))
+            {
+                param = materialParameters[p];
+                if (typeof param === 'string')
+                {
+                    if (fileImages)
+                    {
+                        filename = fileImages[param] || param;
+                    }
+                    else
+                    {
+                        filename = param;
+                    }
+
+                    if (!material.texturesNames)
+                    {
+                        material.texturesNames = {};
+                    }
+                    material.texturesNames[p] = filename;
+
+                    material.techniqueParameters[p] = null;
+                }
+                else
+                {
+                    material.techniqueParameters[p] = param;
+                }
+            }
+        }
+
+        material.effectName = effectType;
+
+        var fileMaterialMeta = fileMaterial.meta;
+        if (fileMaterialMeta)
+        {
+            if (fileEffectMeta)
+            {
+                for (p in fileEffectMeta)
+                {
+                    if (fileEffectMeta.hasOwnProperty(p) &&
+                        !fileMaterialMeta.hasOwnProperty(p))
+                    {
+                        fileMaterialMeta[p] = fileEffectMeta[p];
+                    }
+                }
+            }
+            material.meta = fileMaterialMeta;
+        }
+        else if (fileEffectMeta)
+        {
+            material.meta = fileEffectMeta;
+        }
+
+        materials[materialName] = material;
+        material.name = materialName;
+        material.reference.subscribeDestroyed(this.onMaterialDestroyed);
+
+        return material;
+    }
+
+    //
+    // loadMaterials
+    //
+    loadMaterials(loadParams)
+    {
+        var sceneData = loadParams.data;
+        var gd = loadParams.graphicsDevice;
+        var textureManager = loadParams.textureManager;
+        var createMaterial = this.createMaterial;
+
+        if (!loadParams.append)
+        {
+            this.effects = [];
+            this.effectsMap = {};
+            this.clearMaterials();
+        }
+
+        // Import materials
+        var fileMaterials = sceneData.materials;
+        if (fileMaterials)
+        {
+            var fileImages = sceneData.images;
+            var fileEffects = sceneData.effects;
+            var materials = this.materials;
+            for (var m in fileMaterials)
+            {
+                if (fileMaterials.hasOwnProperty(m) &&
+                    !materials[m])
+                {
+                    var fileMaterial = fileMaterials[m];
+                    var effectName = (fileMaterial.effect || "default");
+                    createMaterial.call(this, m, fileMaterial, effectName, fileEffects, fileImages, gd, textureManager);
+                }
+            }
+        }
+    }
+
+    //
+    // loadSkeletons
+    //
+    loadSkeletons(loadParams)
+    {
+        var sceneData = loadParams.data;
+        var fileSkeletons = sceneData.skeletons;
+
+        var md = this.md;
+        var m43Build = md.m43Build;
+
+        var invLTM, bindPose;
+
+        for (var s in fileSkeletons)
+        {
+            if (fileSkeletons.hasOwnProperty(s))
+            {
+                var skeleton = fileSkeletons[s];
+
+                var numJoints = skeleton.numNodes;
+                var invLTMs = skeleton.invBoneLTMs;
+                var bindPoses = skeleton.bindPoses;
+
+                // copy the inv bone ltms and bind poses to make them native
+                for (var b = 0; b < numJoints; b += 1)
+                {
+                    invLTM = invLTMs[b];
+                    bindPose = bindPoses[b];
+
+                    invLTMs[b] = m43Build.apply(md, invLTM);
+                    bindPoses[b] = m43Build.apply(md, bindPose);
+                }
+
+                if (loadParams.skeletonNamePrefix)
+                {
+                    s = loadParams.skeletonNamePrefix + s;
+                }
+
+                this.skeletons[s] = skeleton;
+            }
+        }
+    }
+
+    // For cases where > 1-index per vertex we process it to create 1-index per vertex from data
+    _updateSingleIndexTables(surface,
+                             indicesPerVertex,
+                             verticesAsIndexLists,
+                             verticesAsIndexListTable,
+                             numUniqueVertices)
+    {
+        var faces = surface.faces;
+        var numIndices = faces.length;
+
+        var newFaces = [];
+        newFaces.length = numIndices;
+
+        var numUniqueVertIndex = verticesAsIndexLists.length;
+        var vertIdx = 0;
+        var srcIdx = 0;
+        var n, maxn, index;
+        var currentLevel, nextLevel, thisVertIndex;
 
         while (srcIdx < numIndices)
         {
@@ -3862,7 +4778,259 @@ class Scene
                 indexBufferOffset += 1;
             }
         }
-        return indexBufferOffset;
+        return indexBufferOffset;
+    }
+
+    // Layout of the vertex formats written by json2geom:
+    // [components, bytes per component, DataView getter, normalization scale]
+    static binaryVertexFormats = {
+        FLOAT1:   [1, 4, 'getFloat32', 1],
+        FLOAT2:   [2, 4, 'getFloat32', 1],
+        FLOAT3:   [3, 4, 'getFloat32', 1],
+        FLOAT4:   [4, 4, 'getFloat32', 1],
+        BYTE4N:   [4, 1, 'getInt8', (1 / 0x7f)],
+        UBYTE4:   [4, 1, 'getUint8', 1],
+        UBYTE4N:  [4, 1, 'getUint8', (1 / 0xff)],
+        SHORT2N:  [2, 2, 'getInt16', (1 / 0x7fff)],
+        SHORT4N:  [4, 2, 'getInt16', (1 / 0x7fff)],
+        USHORT2N: [2, 2, 'getUint16', (1 / 0xffff)],
+        USHORT4N: [4, 2, 'getUint16', (1 / 0xffff)]
+    };
+
+    // Decodes packed vertices back into plain values, only required when the
+    // vertex data has to be kept or the device emulates some of the formats
+    _unpackVertexData(geometryData: ArrayBuffer,
+                      byteOffset: number,
+                      numVertices: number,
+                      vertexStride: number,
+                      formats: string[]): Float32Array
+    {
+        var dataView = new DataView(geometryData, byteOffset, (numVertices * vertexStride));
+        var binaryVertexFormats = Scene.binaryVertexFormats;
+        var numAttributes = formats.length;
+        var layouts = [];
+        var numValuesPerVertex = 0;
+        var a, c, v, layout;
+        for (a = 0; a < numAttributes; a += 1)
+        {
+            layout = binaryVertexFormats[formats[a]];
+            layouts[a] = layout;
+            numValuesPerVertex += layout[0];
+        }
+
+        var vertexData = new Float32Array(numVertices * numValuesPerVertex);
+        var srcOffset = 0;
+        var destOffset = 0;
+        for (v = 0; v < numVertices; v += 1)
+        {
+            for (a = 0; a < numAttributes; a += 1)
+            {
+                layout = layouts[a];
+                var numComponents = layout[0];
+                var componentSize = layout[1];
+                var getter = dataView[layout[2]];
+                var scale = layout[3];
+                for (c = 0; c < numComponents; c += 1)
+                {
+                    vertexData[destOffset] = (getter.call(dataView, srcOffset, true) * scale);
+                    destOffset += 1;
+                    srcOffset += componentSize;
+                }
+            }
+        }
+        return vertexData;
+    }
+
+    // Creates the buffers of a shape packed by json2geom, the vertex and
+    // index data are uploaded directly from the binary geometry container.
+    _loadBinaryShape(shape: Geometry, fileShape: any, loadParams: any): boolean
+    {
+        var gd = loadParams.graphicsDevice;
+        var geometryData = loadParams.geometryData;
+        var keepVertexData = loadParams.keepVertexData;
+        var binaryShape = fileShape.binary;
+
+        var semanticsNames = binaryShape.semantics;
+        var formats = binaryShape.formats;
+        var numAttributes = formats.length;
+        var totalNumVertices = binaryShape.numVertices;
+        var vertexStride = binaryShape.vertexStride;
+        var vertexOffset = binaryShape.vertexOffset;
+
+        // Some devices emulate the smaller formats with floats
+        var deviceStride = 0;
+        var n, format;
+        for (n = 0; n < numAttributes; n += 1)
+        {
+            format = gd['VERTEXFORMAT_' + formats[n]];
+            deviceStride += ((format && format.stride) || 0);
+        }
+
+        var vertexBufferManager = (loadParams.vertexBufferManager ||
+                                   this.vertexBufferManager);
+        if (!vertexBufferManager)
+        {
+            vertexBufferManager = VertexBufferManager.create(gd);
+            this.vertexBufferManager = vertexBufferManager;
+        }
+
+        var indexBufferManager = (loadParams.indexBufferManager || this.indexBufferManager);
+        if (!indexBufferManager)
+        {
+            indexBufferManager = IndexBufferManager.create(gd);
+            this.indexBufferManager = indexBufferManager;
+        }
+
+        var vertexBufferAllocation = vertexBufferManager.allocate(totalNumVertices, formats);
+        var vertexBuffer = vertexBufferAllocation.vertexBuffer;
+        if (!vertexBuffer)
+        {
+            return false;
+        }
+
+        shape.vertexBuffer = vertexBuffer;
+        shape.vertexBufferManager = vertexBufferManager;
+        shape.vertexBufferAllocation = vertexBufferAllocation;
+
+        // Indices are relative to the shape so the vertex offset selects
+        // the allocation instead of rebasing every index
+        var baseIndex = vertexBufferAllocation.baseIndex;
+        shape.vertexOffset = baseIndex;
+
+        var vertexData = null;
+        if (keepVertexData || deviceStride !== vertexStride)
+        {
+            vertexData = this._unpackVertexData(geometryData,
+                                                vertexOffset,
+                                                totalNumVertices,
+                                                vertexStride,
+                                                formats);
+        }
+
+        if (deviceStride === vertexStride)
+        {
+            vertexBuffer.setData(geometryData.slice(vertexOffset,
+                                                    (vertexOffset + (totalNumVertices * vertexStride))),
+                                 baseIndex,
+                                 totalNumVertices);
+        }
+        else
+        {
+            vertexBuffer.setData(vertexData, baseIndex, totalNumVertices);
+        }
+
+        var numIndices = binaryShape.numIndices;
+        var indexBuffer = null;
+        var indexData = null;
+        var indexBufferBaseIndex = 0;
+        if (numIndices)
+        {
+            var indexFormat = binaryShape.indexFormat;
+            var indexBufferAllocation = indexBufferManager.allocate(numIndices, indexFormat);
+            indexBuffer = indexBufferAllocation.indexBuffer;
+            if (!indexBuffer)
+            {
+                return false;
+            }
+
+            shape.indexBufferManager = indexBufferManager;
+            shape.indexBufferAllocation = indexBufferAllocation;
+
+            indexBufferBaseIndex = indexBufferAllocation.baseIndex;
+
+            if (indexFormat === 'USHORT')
+            {
+                indexData = new Uint16Array(geometryData, binaryShape.indexOffset, numIndices);
+            }
+            else
+            {
+                indexData = new Uint32Array(geometryData, binaryShape.indexOffset, numIndices);
+            }
+
+            indexBuffer.setData(indexData, indexBufferBaseIndex, numIndices);
+        }
+
+        var primitives = {
+            triangles: gd.PRIMITIVE_TRIANGLES,
+            lines: gd.PRIMITIVE_LINES
+        };
+
+        var binarySurfaces = binaryShape.surfaces;
+        var shapeSurfaces = shape.surfaces;
+        var s, binarySurface, destSurface;
+        for (s in binarySurfaces)
+        {
+            if (binarySurfaces.hasOwnProperty(s))
+            {
+                binarySurface = binarySurfaces[s];
+
+                destSurface = {
+                    first: binarySurface.first,
+                    numVertices: binarySurface.numVertices,
+                    primitive: primitives[binarySurface.primitive]
+                };
+
+                if (binarySurface.numIndices)
+                {
+                    destSurface.indexBuffer = indexBuffer;
+                    destSurface.numIndices = binarySurface.numIndices;
+                    destSurface.first = (indexBufferBaseIndex + binarySurface.first);
+                    if (keepVertexData)
+                    {
+                        destSurface.indexData = new indexData.constructor(
+                            indexData.subarray(binarySurface.first,
+                                               (binarySurface.first + binarySurface.numIndices)));
+                    }
+                }
+
+                if (keepVertexData)
+                {
+                    destSurface.vertexData = vertexData;
+                }
+
+                shapeSurfaces[s] = destSurface;
+            }
+        }
+
+        var cachedSemantics = this.semantics;
+        var semanticsHash = semanticsNames.join();
+        var semantics = cachedSemantics[semanticsHash];
+        if (!semantics)
+        {
+            semantics = gd.createSemantics(semanticsNames);
+            cachedSemantics[semanticsHash] = semantics;
+        }
+        shape.semantics = semantics;
+
+        if (!fileShape.surfaces)
+        {
+            var surface = shapeSurfaces.singleSurface;
+            if (surface)
+            {
+                shape.primitive = surface.primitive;
+                if (keepVertexData)
+                {
+                    shape.vertexData = surface.vertexData;
+                }
+
+                shape.first = surface.first;
+                shape.numVertices = surface.numVertices;
+
+                if (surface.indexBuffer)
+                {
+                    shape.indexBuffer = surface.indexBuffer;
+                    shape.numIndices = surface.numIndices;
+                    if (keepVertexData)
+                    {
+                        shape.indexData = surface.indexData;
+                    }
+                }
+            }
+
+            delete shape.surfaces;
+        }
+
+        return true;
     }
 
     // try to group sequential renderables into a single draw call
@@ -4034,102 +5202,887 @@ class Scene
                                             numRenderables += 1;
                                         }
 
-                                        lastMaterial = material;
-                                        sequenceFirstRenderable = renderable;
-                                        sequenceNumVertices = 0;
-                                        sequenceLength = 1;
-                                        sequenceVertexOffset = geometry.vertexOffset;
+                                        lastMaterial = material;
+                                        sequenceFirstRenderable = renderable;
+                                        sequenceNumVertices = 0;
+                                        sequenceLength = 1;
+                                        sequenceVertexOffset = geometry.vertexOffset;
+
+                                        if (center)
+                                        {
+                                            sequenceExtents[0] = (center[0] - halfExtents[0]);
+                                            sequenceExtents[1] = (center[1] - halfExtents[1]);
+                                            sequenceExtents[2] = (center[2] - halfExtents[2]);
+                                            sequenceExtents[3] = (center[0] + halfExtents[0]);
+                                            sequenceExtents[4] = (center[1] + halfExtents[1]);
+                                            sequenceExtents[5] = (center[2] + halfExtents[2]);
+                                        }
+                                        else
+                                        {
+                                            sequenceExtents[0] = -halfExtents[0];
+                                            sequenceExtents[1] = -halfExtents[1];
+                                            sequenceExtents[2] = -halfExtents[2];
+                                            sequenceExtents[3] = halfExtents[0];
+                                            sequenceExtents[4] = halfExtents[1];
+                                            sequenceExtents[5] = halfExtents[2];
+                                        }
+                                    }
+                                    else
+                                    {
+                                        sequenceLength += 1;
+
+                                        if (center)
+                                        {
+                                            sequenceExtents[0] = min(sequenceExtents[0], (center[0] - halfExtents[0]));
+                                            sequenceExtents[1] = min(sequenceExtents[1], (center[1] - halfExtents[1]));
+                                            sequenceExtents[2] = min(sequenceExtents[2], (center[2] - halfExtents[2]));
+                                            sequenceExtents[3] = max(sequenceExtents[3], (center[0] + halfExtents[0]));
+                                            sequenceExtents[4] = max(sequenceExtents[4], (center[1] + halfExtents[1]));
+                                            sequenceExtents[5] = max(sequenceExtents[5], (center[2] + halfExtents[2]));
+                                        }
+                                        else
+                                        {
+                                            sequenceExtents[0] = min(sequenceExtents[0], -halfExtents[0]);
+                                            sequenceExtents[1] = min(sequenceExtents[1], -halfExtents[1]);
+                                            sequenceExtents[2] = min(sequenceExtents[2], -halfExtents[2]);
+                                            sequenceExtents[3] = max(sequenceExtents[3], halfExtents[0]);
+                                            sequenceExtents[4] = max(sequenceExtents[4], halfExtents[1]);
+                                            sequenceExtents[5] = max(sequenceExtents[5], halfExtents[2]);
+                                        }
+                                    }
+
+                                    if (surface.indexBuffer)
+                                    {
+                                        sequenceIndicesEnd = (surface.first + surface.numIndices);
+                                        sequenceNumVertices += surface.numVertices;
+                                    }
+                                    else
+                                    {
+                                        sequenceIndicesEnd = (surface.first + surface.numVertices);
+                                    }
+
+                                    g += 1;
+                                }
+                                while (g < groupSize);
+
+                                debug.assert(0 < sequenceLength);
+
+                                if (1 < sequenceLength)
+                                {
+                                    flushSequence();
+                                }
+
+                                renderables[numRenderables] = sequenceFirstRenderable;
+                                numRenderables += 1;
+                            }
+                        }
+                    }
+                }
+            }
+            for (n = 0; n < numUngroup; n += 1)
+            {
+                renderables[numRenderables] = ungroup[n];
+                numRenderables += 1;
+            }
+            for (n = numRenderables; n < renderables.length; n += 1)
+            {
+                renderables[n].setNode(null);
+            }
+            renderables.length = numRenderables;
+        }
+    }
+
+    //
+    // buildStaticBatches
+    //
+    // Merges the rigid geometry instances of static nodes that share a
+    // material and a spatial cell into batches with pre-transformed
+    // vertices. Requires shapes loaded with keepVertexData, returns the
+    // number of batches created.
+    buildStaticBatches(gd: GraphicsDevice, params?: SceneStaticBatchingParams): number
+    {
+        if (this.staticBatches)
+        {
+            this.clearStaticBatches();
+        }
+
+        // Streamed instances come and go with their areas
+        if (this.streaming)
+        {
+            return 0;
+        }
+
+        params = params || {};
+        var cellSize = (params.cellSize || 64);
+        var maxVertices = Math.min((params.maxVertices || 65536), 65536);
+        var maxInstanceVertices = (params.maxInstanceVertices || 4096);
+
+        this.updateNodes();
+
+        var triangles = gd.PRIMITIVE_TRIANGLES;
+        var bspNodes = (this.areas ? this.bspNodes : null);
+        var floor = Math.floor;
+        var groupsMap = {};
+        var groups = [];
+        var formats = [];
+        var maxSourceVertices = 0;
+        var n, node, children, numChildren, renderables, numRenderables, renderable;
+        var extents, cX, cY, cZ, key, cellGroups, group, material, g;
+
+        var nodes = this.rootNodes.slice();
+        while (nodes.length)
+        {
+            node = nodes.pop();
+
+            // Children of dynamic nodes are always dynamic
+            if (node.dynamic || node.disabled)
+            {
+                continue;
+            }
+
+            children = node.children;
+            if (children)
+            {
+                numChildren = children.length;
+                for (n = 0; n < numChildren; n += 1)
+                {
+                    nodes.push(children[n]);
+                }
+            }
+
+            renderables = node.renderables;
+            if (!renderables)
+            {
+                continue;
+            }
+
+            numRenderables = renderables.length;
+            for (n = 0; n < numRenderables; n += 1)
+            {
+                renderable = renderables[n];
+                if (!this._isStaticBatchable(renderable, triangles, maxInstanceVertices))
+                {
+                    continue;
+                }
+
+                extents = renderable.getWorldExtents();
+                cX = (extents[0] + extents[3]) * 0.5;
+                cY = (extents[1] + extents[4]) * 0.5;
+                cZ = (extents[2] + extents[5]) * 0.5;
+
+                key = -1;
+                if (bspNodes)
+                {
+                    key = this.findAreaIndex(bspNodes, cX, cY, cZ);
+                }
+                if (key >= 0)
+                {
+                    key = 'a' + key;
+                }
+                else
+                {
+                    key = ('c' + floor(cX / cellSize) +
+                           ',' + floor(cY / cellSize) +
+                           ',' + floor(cZ / cellSize));
+                }
+                key += ':' + this._staticBatchFormatKey(renderable.geometry, formats);
+
+                cellGroups = groupsMap[key];
+                if (cellGroups === undefined)
+                {
+                    groupsMap[key] = cellGroups = [];
+                }
+
+                material = renderable.sharedMaterial;
+                group = null;
+                for (g = 0; g < cellGroups.length; g += 1)
+                {
+                    if (cellGroups[g].material === material ||
+                        cellGroups[g].material.isSimilar(material))
+                    {
+                        group = cellGroups[g];
+                        break;
+                    }
+                }
+                if (!group)
+                {
+                    group = {
+                        material: material,
+                        instances: []
+                    };
+                    cellGroups.push(group);
+                    groups.push(group);
+                }
+                group.instances.push(renderable);
+
+                maxSourceVertices = Math.max(maxSourceVertices,
+                                             (renderable.surface.vertexData.length /
+                                              renderable.geometry.vertexBuffer.stride));
+            }
+        }
+
+        var staticBatches = [];
+        var numGroups = groups.length;
+        if (numGroups)
+        {
+            // Vertex remapping table shared by all the batches, entries are
+            // reset to -1 after every instance
+            var remap = new Int32Array(maxSourceVertices);
+            for (n = 0; n < maxSourceVertices; n += 1)
+            {
+                remap[n] = -1;
+            }
+
+            var instances, numInstances, i, start, numBatchVertices, numVertices, batch;
+            for (g = 0; g < numGroups; g += 1)
+            {
+                group = groups[g];
+                instances = group.instances;
+                numInstances = instances.length;
+                if (numInstances < 2)
+                {
+                    continue;
+                }
+
+                this._sortStaticBatchInstances(instances);
+
+                start = 0;
+                numBatchVertices = 0;
+                for (i = 0; i <= numInstances; i += 1)
+                {
+                    numVertices = (i < numInstances ? instances[i].surface.numVertices : 0);
+                    if (i === numInstances ||
+                        (numBatchVertices + numVertices) > maxVertices)
+                    {
+                        if ((i - start) > 1)
+                        {
+                            batch = this._buildStaticBatch(gd,
+                                                           ("staticBatch-" + staticBatches.length),
+                                                           instances.slice(start, i),
+                                                           group.material,
+                                                           remap);
+                            if (batch)
+                            {
+                                staticBatches.push(batch);
+                            }
+                        }
+                        start = i;
+                        numBatchVertices = 0;
+                    }
+                    numBatchVertices += numVertices;
+                }
+            }
+        }
+
+        var numStaticBatches = staticBatches.length;
+        this.staticBatches = (numStaticBatches ? staticBatches : null);
+        if (numStaticBatches)
+        {
+            this.update();
+        }
+        return numStaticBatches;
+    }
+
+    //
+    // clearStaticBatches
+    //
+    clearStaticBatches()
+    {
+        var staticBatches = this.staticBatches;
+        if (!staticBatches)
+        {
+            return;
+        }
+
+        var numStaticBatches = staticBatches.length;
+        var n, i, batch, instances, numInstances;
+        for (n = 0; n < numStaticBatches; n += 1)
+        {
+            batch = staticBatches[n];
+
+            instances = batch.instances;
+            numInstances = instances.length;
+            for (i = 0; i < numInstances; i += 1)
+            {
+                instances[i].disabled = false;
+            }
+
+            if (batch.node.scene === this)
+            {
+                this.removeRootNode(batch.node);
+            }
+            batch.node.destroy();
+
+            batch.vertexBuffer.destroy();
+            batch.indexBuffer.destroy();
+        }
+
+        this.staticBatches = null;
+    }
+
+    _isStaticBatchable(renderable: GeometryInstance, triangles: number, maxInstanceVertices: number): boolean
+    {
+        var surface = renderable.surface;
+        var geometry = renderable.geometry;
+        if (!surface ||
+            !geometry ||
+            renderable.disabled ||
+            renderable.geometryType !== "rigid" ||
+            geometry.skeleton ||
+            surface.primitive !== triangles)
+        {
+            return false;
+        }
+
+        // Groups built by _optimizeRenderables only keep the indices of their first surface
+        var indexData = surface.indexData;
+        if (!surface.indexBuffer ||
+            !indexData ||
+            indexData.length < surface.numIndices ||
+            !surface.vertexData ||
+            !geometry.vertexBuffer ||
+            !geometry.semantics)
+        {
+            return false;
+        }
+
+        if (surface.numVertices > maxInstanceVertices ||
+            renderable.hasCustomWorldExtents())
+        {
+            return false;
+        }
+
+        var material = renderable.sharedMaterial;
+        if (!material ||
+            material.meta.transparent ||
+            material.meta.decal)
+        {
+            return false;
+        }
+
+        return true;
+    }
+
+    // Only instances with the same vertex layout can be merged
+    _staticBatchFormatKey(geometry: Geometry, formats: any[]): string
+    {
+        var attributes = geometry.vertexBuffer.attributes;
+        var semantics = geometry.semantics;
+        var numAttributes = attributes.length;
+        var key = '';
+        var a, formatIndex;
+        for (a = 0; a < numAttributes; a += 1)
+        {
+            formatIndex = formats.indexOf(attributes[a]);
+            if (formatIndex === -1)
+            {
+                formatIndex = formats.length;
+                formats[formatIndex] = attributes[a];
+            }
+            key += formatIndex + '/' + semantics[a] + ';';
+        }
+        return key;
+    }
+
+    // Sorts the instances along a Morton curve of their centers so
+    // batches split by vertex count stay spatially compact
+    _sortStaticBatchInstances(instances: GeometryInstance[]): void
+    {
+        var numInstances = instances.length;
+        var centers = [];
+        var minX = Number.MAX_VALUE, minY = Number.MAX_VALUE, minZ = Number.MAX_VALUE;
+        var maxX = -Number.MAX_VALUE, maxY = -Number.MAX_VALUE, maxZ = -Number.MAX_VALUE;
+        var n, extents, cX, cY, cZ;
+        for (n = 0; n < numInstances; n += 1)
+        {
+            extents = instances[n].getWorldExtents();
+            cX = (extents[0] + extents[3]) * 0.5;
+            cY = (extents[1] + extents[4]) * 0.5;
+            cZ = (extents[2] + extents[5]) * 0.5;
+            centers[n] = [cX, cY, cZ];
+            minX = Math.min(minX, cX);
+            minY = Math.min(minY, cY);
+            minZ = Math.min(minZ, cZ);
+            maxX = Math.max(maxX, cX);
+            maxY = Math.max(maxY, cY);
+            maxZ = Math.max(maxZ, cZ);
+        }
+
+        var scaleX = (maxX > minX ? (1023 / (maxX - minX)) : 0);
+        var scaleY = (maxY > minY ? (1023 / (maxY - minY)) : 0);
+        var scaleZ = (maxZ > minZ ? (1023 / (maxZ - minZ)) : 0);
+        var mortonCode = Scene._mortonCode;
+        var codes = [];
+        for (n = 0; n < numInstances; n += 1)
+        {
+            var center = centers[n];
+            codes[n] = {
+                instance: instances[n],
+                code: mortonCode(Math.floor((center[0] - minX) * scaleX),
+                                 Math.floor((center[1] - minY) * scaleY),
+                                 Math.floor((center[2] - minZ) * scaleZ))
+            };
+        }
+
+        codes.sort(function (a, b) {
+            return (a.code - b.code);
+        });
+
+        for (n = 0; n < numInstances; n += 1)
+        {
+            instances[n] = codes[n].instance;
+        }
+    }
+
+    // Interleaves 10 bits of each coordinate
+    static _mortonCode(x: number, y: number, z: number): number
+    {
+        /* tslint:disable:no-bitwise */
+        function spread(v)
+        {
+            v &= 0x3ff;
+            v = (v | (v << 16)) & 0x030000ff;
+            v = (v | (v << 8)) & 0x0300f00f;
+            v = (v | (v << 4)) & 0x030c30c3;
+            v = (v | (v << 2)) & 0x09249249;
+            return v;
+        }
+        return (spread(x) | (spread(y) << 1) | (spread(z) << 2));
+        /* tslint:enable:no-bitwise */
+    }
+
+    _buildStaticBatch(gd: GraphicsDevice,
+                      name: string,
+                      instances: GeometryInstance[],
+                      material: Material,
+                      remap: any): SceneStaticBatch
+    {
+        var numInstances = instances.length;
+        var sourceGeometry = instances[0].geometry;
+        var attributes = sourceGeometry.vertexBuffer.attributes;
+        var semantics = sourceGeometry.semantics;
+        var numAttributes = attributes.length;
+
+        // Offsets of the attributes that have to be transformed
+        var positionOffset = -1, normalOffset = -1, tangentOffset = -1, binormalOffset = -1;
+        var tangentComponents = 0;
+        var numValuesPerVertex = 0;
+        var a, semantic;
+        for (a = 0; a < numAttributes; a += 1)
+        {
+            semantic = semantics[a];
+            if (semantic === gd.SEMANTIC_POSITION)
+            {
+                positionOffset = numValuesPerVertex;
+            }
+            else if (semantic === gd.SEMANTIC_NORMAL)
+            {
+                normalOffset = numValuesPerVertex;
+            }
+            else if (semantic === gd.SEMANTIC_TANGENT)
+            {
+                tangentOffset = numValuesPerVertex;
+                tangentComponents = attributes[a].numComponents;
+            }
+            else if (semantic === gd.SEMANTIC_BINORMAL)
+            {
+                binormalOffset = numValuesPerVertex;
+            }
+            numValuesPerVertex += attributes[a].numComponents;
+        }
+        if (positionOffset < 0)
+        {
+            return null;
+        }
+
+        var totalNumIndices = 0;
+        var maxNumVertices = 0;
+        var i;
+        for (i = 0; i < numInstances; i += 1)
+        {
+            totalNumIndices += instances[i].surface.numIndices;
+            maxNumVertices += instances[i].surface.numVertices;
+        }
+
+        var vertexData = new Float32Array(maxNumVertices * numValuesPerVertex);
+        // Full list of indices followed by room for the visible ones
+        var indexData = new Uint16Array(2 * totalNumIndices);
+        var pieceFirst = new Uint32Array(numInstances);
+        var pieceCount = new Uint32Array(numInstances);
+        var pieceExtentsData = new Float32Array(6 * numInstances);
+        var pieceExtents = [];
+        var batchExtents = [Number.MAX_VALUE, Number.MAX_VALUE, Number.MAX_VALUE,
+                            -Number.MAX_VALUE, -Number.MAX_VALUE, -Number.MAX_VALUE];
+        var touched = [];
+        var sqrt = Math.sqrt;
 
-                                        if (center)
-                                        {
-                                            sequenceExtents[0] = (center[0] - halfExtents[0]);
-                                            sequenceExtents[1] = (center[1] - halfExtents[1]);
-                                            sequenceExtents[2] = (center[2] - halfExtents[2]);
-                                            sequenceExtents[3] = (center[0] + halfExtents[0]);
-                                            sequenceExtents[4] = (center[1] + halfExtents[1]);
-                                            sequenceExtents[5] = (center[2] + halfExtents[2]);
-                                        }
-                                        else
-                                        {
-                                            sequenceExtents[0] = -halfExtents[0];
-                                            sequenceExtents[1] = -halfExtents[1];
-                                            sequenceExtents[2] = -halfExtents[2];
-                                            sequenceExtents[3] = halfExtents[0];
-                                            sequenceExtents[4] = halfExtents[1];
-                                            sequenceExtents[5] = halfExtents[2];
-                                        }
-                                    }
-                                    else
-                                    {
-                                        sequenceLength += 1;
+        var numVertices = 0;
+        var indexOffset = 0;
+        var instance, surface, sourceData, sourceIndices, numIndices, world, extents, pe, e;
+        var k, v, d, s, dst, x, y, z, w, l;
+        for (i = 0; i < numInstances; i += 1)
+        {
+            instance = instances[i];
+            surface = instance.surface;
+            sourceData = surface.vertexData;
+            sourceIndices = surface.indexData;
+            numIndices = surface.numIndices;
+            world = instance.node.world;
+
+            var m0 = world[0], m1 = world[1], m2 = world[2];
+            var m3 = world[3], m4 = world[4], m5 = world[5];
+            var m6 = world[6], m7 = world[7], m8 = world[8];
+            var m9 = world[9], m10 = world[10], m11 = world[11];
+
+            // Normals use the cofactor matrix, scaled only by the sign of
+            // the determinant because they are normalized afterwards
+            var c0 = (m4 * m8 - m7 * m5);
+            var c1 = (m7 * m2 - m1 * m8);
+            var c2 = (m1 * m5 - m4 * m2);
+            var c3 = (m6 * m5 - m3 * m8);
+            var c4 = (m0 * m8 - m6 * m2);
+            var c5 = (m3 * m2 - m0 * m5);
+            var c6 = (m3 * m7 - m6 * m4);
+            var c7 = (m6 * m1 - m0 * m7);
+            var c8 = (m0 * m4 - m3 * m1);
+            var det = (m0 * c0 + m3 * c1 + m6 * c2);
+            var mirrored = (det < 0);
+            if (mirrored)
+            {
+                c0 = -c0; c1 = -c1; c2 = -c2;
+                c3 = -c3; c4 = -c4; c5 = -c5;
+                c6 = -c6; c7 = -c7; c8 = -c8;
+            }
 
-                                        if (center)
-                                        {
-                                            sequenceExtents[0] = min(sequenceExtents[0], (center[0] - halfExtents[0]));
-                                            sequenceExtents[1] = min(sequenceExtents[1], (center[1] - halfExtents[1]));
-                                            sequenceExtents[2] = min(sequenceExtents[2], (center[2] - halfExtents[2]));
-                                            sequenceExtents[3] = max(sequenceExtents[3], (center[0] + halfExtents[0]));
-                                            sequenceExtents[4] = max(sequenceExtents[4], (center[1] + halfExtents[1]));
-                                            sequenceExtents[5] = max(sequenceExtents[5], (center[2] + halfExtents[2]));
-                                        }
-                                        else
-                                        {
-                                            sequenceExtents[0] = min(sequenceExtents[0], -halfExtents[0]);
-                                            sequenceExtents[1] = min(sequenceExtents[1], -halfExtents[1]);
-                                            sequenceExtents[2] = min(sequenceExtents[2], -halfExtents[2]);
-                                            sequenceExtents[3] = max(sequenceExtents[3], halfExtents[0]);
-                                            sequenceExtents[4] = max(sequenceExtents[4], halfExtents[1]);
-                                            sequenceExtents[5] = max(sequenceExtents[5], halfExtents[2]);
-                                        }
-                                    }
+            pieceFirst[i] = indexOffset;
+            pieceCount[i] = numIndices;
 
-                                    if (surface.indexBuffer)
-                                    {
-                                        sequenceIndicesEnd = (surface.first + surface.numIndices);
-                                        sequenceNumVertices += surface.numVertices;
-                                    }
-                                    else
-                                    {
-                                        sequenceIndicesEnd = (surface.first + surface.numVertices);
-                                    }
+            extents = instance.getWorldExtents();
+            pe = pieceExtentsData.subarray((6 * i), (6 * i) + 6);
+            for (e = 0; e < 3; e += 1)
+            {
+                pe[e] = extents[e];
+                pe[e + 3] = extents[e + 3];
+                batchExtents[e] = Math.min(batchExtents[e], extents[e]);
+                batchExtents[e + 3] = Math.max(batchExtents[e + 3], extents[e + 3]);
+            }
+            pieceExtents[i] = pe;
 
-                                    g += 1;
-                                }
-                                while (g < groupSize);
+            for (k = 0; k < numIndices; k += 1)
+            {
+                v = sourceIndices[k];
+                d = remap[v];
+                if (d < 0)
+                {
+                    d = numVertices;
+                    remap[v] = d;
+                    touched.push(v);
+                    numVertices += 1;
 
-                                debug.assert(0 < sequenceLength);
+                    s = (v * numValuesPerVertex);
+                    dst = (d * numValuesPerVertex);
+                    for (a = 0; a < numValuesPerVertex; a += 1)
+                    {
+                        vertexData[dst + a] = sourceData[s + a];
+                    }
 
-                                if (1 < sequenceLength)
-                                {
-                                    flushSequence();
-                                }
+                    x = sourceData[s + positionOffset];
+                    y = sourceData[s + positionOffset + 1];
+                    z = sourceData[s + positionOffset + 2];
+                    vertexData[dst + positionOffset] = (m0 * x + m3 * y + m6 * z + m9);
+                    vertexData[dst + positionOffset + 1] = (m1 * x + m4 * y + m7 * z + m10);
+                    vertexData[dst + positionOffset + 2] = (m2 * x + m5 * y + m8 * z + m11);
 
-                                renderables[numRenderables] = sequenceFirstRenderable;
-                                numRenderables += 1;
-                            }
+                    if (normalOffset >= 0)
+                    {
+                        x = sourceData[s + normalOffset];
+                        y = sourceData[s + normalOffset + 1];
+                        z = sourceData[s + normalOffset + 2];
+                        w = (c0 * x + c3 * y + c6 * z);
+                        y = (c1 * x + c4 * y + c7 * z);
+                        z = (c2 * x + c5 * y + c8 * z);
+                        x = w;
+                        l = sqrt(x * x + y * y + z * z);
+                        l = (l > 0 ? (1 / l) : 0);
+                        vertexData[dst + normalOffset] = (x * l);
+                        vertexData[dst + normalOffset + 1] = (y * l);
+                        vertexData[dst + normalOffset + 2] = (z * l);
+                    }
+
+                    if (tangentOffset >= 0)
+                    {
+                        x = sourceData[s + tangentOffset];
+                        y = sourceData[s + tangentOffset + 1];
+                        z = sourceData[s + tangentOffset + 2];
+                        w = (m0 * x + m3 * y + m6 * z);
+                        y = (m1 * x + m4 * y + m7 * z);
+                        z = (m2 * x + m5 * y + m8 * z);
+                        x = w;
+                        l = sqrt(x * x + y * y + z * z);
+                        l = (l > 0 ? (1 / l) : 0);
+                        vertexData[dst + tangentOffset] = (x * l);
+                        vertexData[dst + tangentOffset + 1] = (y * l);
+                        vertexData[dst + tangentOffset + 2] = (z * l);
+                        // Mirroring flips the handedness of the tangent frame
+                        if (mirrored && tangentComponents > 3)
+                        {
+                            vertexData[dst + tangentOffset + 3] = -sourceData[s + tangentOffset + 3];
                         }
                     }
+
+                    if (binormalOffset >= 0)
+                    {
+                        x = sourceData[s + binormalOffset];
+                        y = sourceData[s + binormalOffset + 1];
+                        z = sourceData[s + binormalOffset + 2];
+                        w = (m0 * x + m3 * y + m6 * z);
+                        y = (m1 * x + m4 * y + m7 * z);
+                        z = (m2 * x + m5 * y + m8 * z);
+                        x = w;
+                        l = sqrt(x * x + y * y + z * z);
+                        l = (l > 0 ? (1 / l) : 0);
+                        vertexData[dst + binormalOffset] = (x * l);
+                        vertexData[dst + binormalOffset + 1] = (y * l);
+                        vertexData[dst + binormalOffset + 2] = (z * l);
+                    }
                 }
+                indexData[indexOffset + k] = d;
             }
-            for (n = 0; n < numUngroup; n += 1)
+
+            // Mirroring also flips the winding of the triangles
+            if (mirrored)
             {
-                renderables[numRenderables] = ungroup[n];
-                numRenderables += 1;
+                for (k = 0; k < numIndices; k += 3)
+                {
+                    d = indexData[indexOffset + k + 1];
+                    indexData[indexOffset + k + 1] = indexData[indexOffset + k + 2];
+                    indexData[indexOffset + k + 2] = d;
+                }
             }
-            for (n = numRenderables; n < renderables.length; n += 1)
+
+            indexOffset += numIndices;
+
+            while (touched.length)
             {
-                renderables[n].setNode(null);
+                remap[touched.pop()] = -1;
             }
-            renderables.length = numRenderables;
         }
+
+        var vertexBuffer = gd.createVertexBuffer({
+                numVertices: numVertices,
+                attributes: attributes,
+                dynamic: false,
+                data: vertexData.subarray(0, (numVertices * numValuesPerVertex))
+            });
+        if (!vertexBuffer)
+        {
+            return null;
+        }
+
+        var indexBuffer = gd.createIndexBuffer({
+                numIndices: (2 * totalNumIndices),
+                format: gd.INDEXFORMAT_USHORT,
+                dynamic: true,
+                data: indexData
+            });
+        if (!indexBuffer)
+        {
+            vertexBuffer.destroy();
+            return null;
+        }
+
+        var geometry = Geometry.create();
+        geometry.name = name;
+        geometry.type = "rigid";
+        geometry.primitive = gd.PRIMITIVE_TRIANGLES;
+        geometry.semantics = semantics;
+        geometry.vertexBuffer = vertexBuffer;
+        geometry.center = [((batchExtents[0] + batchExtents[3]) * 0.5),
+                           ((batchExtents[1] + batchExtents[4]) * 0.5),
+                           ((batchExtents[2] + batchExtents[5]) * 0.5)];
+        geometry.halfExtents = [((batchExtents[3] - batchExtents[0]) * 0.5),
+                                ((batchExtents[4] - batchExtents[1]) * 0.5),
+                                ((batchExtents[5] - batchExtents[2]) * 0.5)];
+
+        var surface = {
+            first: 0,
+            numIndices: totalNumIndices,
+            numVertices: numVertices,
+            primitive: gd.PRIMITIVE_TRIANGLES,
+            indexBuffer: indexBuffer
+        };
+        geometry.surfaces[name] = surface;
+
+        var renderable = GeometryInstance.create(geometry, surface, material);
+
+        var node = SceneNode.create({
+                name: name,
+                local: this.md.m43BuildIdentity(),
+                dynamic: false
+            });
+        node.addRenderable(renderable);
+        this.addRootNode(node);
+
+        for (i = 0; i < numInstances; i += 1)
+        {
+            instances[i].disabled = true;
+        }
+
+        var visible = new Uint8Array(numInstances);
+        for (i = 0; i < numInstances; i += 1)
+        {
+            visible[i] = 1;
+        }
+
+        return {
+            renderable: renderable,
+            node: node,
+            instances: instances,
+            vertexBuffer: vertexBuffer,
+            indexBuffer: indexBuffer,
+            indexData: indexData,
+            numIndices: totalNumIndices,
+            pieceExtents: pieceExtents,
+            pieceFirst: pieceFirst,
+            pieceCount: pieceCount,
+            visible: visible,
+            compacted: indexData.subarray(totalNumIndices),
+            first: 0,
+            count: totalNumIndices
+        };
+    }
+
+    // WebGL has no multi-draw so the visible pieces of each batch are
+    // drawn either as a contiguous range of the full index list or by
+    // compacting their indices after it. Only the camera passes are
+    // narrowed, shadow maps still need the pieces outside the frustum.
+    _updateStaticBatches(): void
+    {
+        var staticBatches = this.staticBatches;
+        var numStaticBatches = staticBatches.length;
+        var frameIndex = this.frameIndex;
+        var frustumPlanes = this.frustumPlanes;
+        var isInsidePlanesAABB = this.isInsidePlanesAABB;
+        var isFullyInsidePlanesAABB = this.isFullyInsidePlanesAABB;
+        var n, batch, renderable, visible, numPieces, p, isVisible, changed, fullyVisible;
+        for (n = 0; n < numStaticBatches; n += 1)
+        {
+            batch = staticBatches[n];
+            renderable = batch.renderable;
+            if (renderable.frameVisible !== frameIndex)
+            {
+                continue;
+            }
+
+            visible = batch.visible;
+            numPieces = visible.length;
+            changed = false;
+            fullyVisible = isFullyInsidePlanesAABB(renderable.getWorldExtents(), frustumPlanes);
+            for (p = 0; p < numPieces; p += 1)
+            {
+                isVisible = ((fullyVisible || isInsidePlanesAABB(batch.pieceExtents[p], frustumPlanes)) ? 1 : 0);
+                if (visible[p] !== isVisible)
+                {
+                    visible[p] = isVisible;
+                    changed = true;
+                }
+            }
+
+            if (changed)
+            {
+                this._compactStaticBatch(batch);
+            }
+
+            this._setStaticBatchRange(renderable, batch.first, batch.count);
+        }
+    }
+
+    _compactStaticBatch(batch: SceneStaticBatch): void
+    {
+        var visible = batch.visible;
+        var pieceFirst = batch.pieceFirst;
+        var pieceCount = batch.pieceCount;
+        var numPieces = visible.length;
+        var firstPiece = -1;
+        var lastPiece = -1;
+        var contiguous = true;
+        var p;
+        for (p = 0; p < numPieces; p += 1)
+        {
+            if (visible[p])
+            {
+                if (firstPiece < 0)
+                {
+                    firstPiece = p;
+                }
+                else if (lastPiece !== (p - 1))
+                {
+                    contiguous = false;
+                }
+                lastPiece = p;
+            }
+        }
+
+        if (firstPiece < 0)
+        {
+            batch.first = 0;
+            batch.count = 0;
+        }
+        else if (contiguous)
+        {
+            batch.first = pieceFirst[firstPiece];
+            batch.count = (pieceFirst[lastPiece] + pieceCount[lastPiece] - batch.first);
+        }
+        else
+        {
+            var indexData = batch.indexData;
+            var compacted = batch.compacted;
+            var numCompacted = 0;
+            for (p = firstPiece; p <= lastPiece; p += 1)
+            {
+                if (visible[p])
+                {
+                    var first = pieceFirst[p];
+                    var count = pieceCount[p];
+                    compacted.set(indexData.subarray(first, (first + count)), numCompacted);
+                    numCompacted += count;
+                }
+            }
+            batch.indexBuffer.setData(compacted.subarray(0, numCompacted), batch.numIndices, numCompacted);
+            batch.first = batch.numIndices;
+            batch.count = numCompacted;
+        }
+    }
+
+    _setStaticBatchRange(renderable: any, first: number, count: number): void
+    {
+        var setRange = function setRangeFn(drawParametersArray: DrawParameters[])
+        {
+            if (drawParametersArray)
+            {
+                var numDrawParameters = drawParametersArray.length;
+                for (var d = 0; d < numDrawParameters; d += 1)
+                {
+                    var drawParameters = drawParametersArray[d];
+                    drawParameters.firstIndex = first;
+                    drawParameters.count = count;
+                }
+            }
+        };
+
+        setRange(renderable.drawParameters);
+        setRange(renderable.diffuseDrawParameters);
+        setRange(renderable.diffuseShadowDrawParameters);
+        setRange(renderable.clusteredDrawParameters);
     }
 
     //
     // loadShape
     //
-    loadShape(shapeName, fileShapeName, loadParams)
+    loadShape(shapeName, fileShapeName, loadParams, streamedShape?: Geometry)
     {
-        var shape = this.shapes[shapeName];
+        // When streamedShape is given the buffers are loaded into it
+        var shape = (streamedShape ? null : this.shapes[shapeName]);
 
         if (!shape)
         {
@@ -4137,6 +6090,7 @@ class Scene
 
             var sceneData = loadParams.data;
             var gd = loadParams.graphicsDevice;
+            var deferBuffers = (gd && !streamedShape && loadParams.streamAreas && this.streaming);
             var keepVertexData = loadParams.keepVertexData;
             var fileShapes = sceneData.geometries;
             var fileShape = fileShapes[fileShapeName];
@@ -4165,7 +6119,39 @@ class Scene
                 shape.type = "rigid";
             }
 
-            if (gd)
+            if (deferBuffers)
+            {
+                // Buffers are loaded when an area using the shape is requested
+                var fileSurfaces = fileShape.surfaces;
+                if (fileSurfaces)
+                {
+                    for (var fs in fileSurfaces)
+                    {
+                        if (fileSurfaces.hasOwnProperty(fs))
+                        {
+                            shape.surfaces[fs] = {
+                                first: 0,
+                                numVertices: 0,
+                                primitive: -1
+                            };
+                        }
+                    }
+                }
+                else
+                {
+                    delete shape.surfaces;
+                }
+            }
+            else if (gd &&
+                     fileShape.binary &&
+                     loadParams.geometryData)
+            {
+                if (!this._loadBinaryShape(shape, fileShape, loadParams))
+                {
+                    return undefined;
+                }
+            }
+            else if (gd)
             {
                 // First calculate data about the vertex streams
                 var offset;
@@ -4806,9 +6792,33 @@ class Scene
                 //}
             }
 
+            if (streamedShape)
+            {
+                this._copyShapeBuffers(streamedShape, shape);
+                return streamedShape;
+            }
+
             this.shapes[shapeName] = shape;
             shape.name = shapeName;
             shape.reference.subscribeDestroyed(this.onGeometryDestroyed);
+
+            if (deferBuffers)
+            {
+                this.streaming.shapes[shapeName] = {
+                    name: shapeName,
+                    fileName: fileShapeName,
+                    shape: shape,
+                    loadParams: loadParams,
+                    instances: [],
+                    references: 0,
+                    pinned: false,
+                    resident: false,
+                    queued: false,
+                    bytes: 0,
+                    distance: 0,
+                    queryCounter: -1
+                };
+            }
         }
         else
         {
@@ -4817,6 +6827,56 @@ class Scene
         return shape;
     }
 
+    // Moves the buffers of a newly loaded shape to the streamed shape
+    // created earlier without them, its surfaces are kept because geometry
+    // instances refer to them.
+    _copyShapeBuffers(dst: Geometry, src: Geometry): void
+    {
+        var p;
+        for (p in src)
+        {
+            if (src.hasOwnProperty(p) &&
+                p !== 'name' &&
+                p !== 'type' &&
+                p !== 'reference' &&
+                p !== 'skeleton' &&
+                p !== 'center' &&
+                p !== 'halfExtents' &&
+                p !== 'surfaces')
+            {
+                dst[p] = src[p];
+            }
+        }
+
+        var srcSurfaces = src.surfaces;
+        var dstSurfaces = dst.surfaces;
+        if (srcSurfaces && dstSurfaces)
+        {
+            for (var s in srcSurfaces)
+            {
+                if (srcSurfaces.hasOwnProperty(s))
+                {
+                    var srcSurface = srcSurfaces[s];
+                    var dstSurface = dstSurfaces[s];
+                    if (dstSurface)
+                    {
+                        for (p in srcSurface)
+                        {
+                            if (srcSurface.hasOwnProperty(p))
+                            {
+                                dstSurface[p] = srcSurface[p];
+                            }
+                        }
+                    }
+                    else
+                    {
+                        dstSurfaces[s] = srcSurface;
+                    }
+                }
+            }
+        }
+    }
+
     streamShapes(loadParams, postLoadFn)
     {
         // Firstly build an array listing all the shapes we need to load
@@ -4827,6 +6887,12 @@ class Scene
         var fileShapes = sceneData.geometries;
         var loadCustomShapeFn = loadParams.loadCustomShapeFn;
 
+        // Milliseconds of shapes loaded before yielding, 0 loads one shape
+        var maxTime = (loadParams.maxTime || 0);
+
+        // Streamed shapes are created by loadNodes and loaded by area
+        var streamAreas = (loadParams.streamAreas && this.streaming);
+
         var shapesToLoad = [];
         var customShapesToLoad = [];
 
@@ -4841,7 +6907,7 @@ class Scene
                     {
                         customShapesToLoad.push(fileShapeName);
                     }
-                    else
+                    else if (!streamAreas)
                     {
                         shapesToLoad.push(fileShapeName);
                     }
@@ -4851,10 +6917,26 @@ class Scene
 
         var sceneLoadNextShape = function sceneLoadNextShapeFn()
         {
-            var nextShape = shapesToLoad.pop();
+            var tracing = (typeof Trace !== "undefined" && Trace.enabled);
+            if (tracing)
+            {
+                Trace.begin("Scene.loadShapes", "scene", { numPending: shapesToLoad.length });
+            }
+
+            var endTime = (TurbulenzEngine.getTime() + maxTime);
+            do
+            {
+                var nextShape = shapesToLoad.pop();
 
-            var shapeName = (shapesNamePrefix ? (shapesNamePrefix + "-" + nextShape) : nextShape);
-            scene.loadShape(shapeName, nextShape, loadParams);
+                var shapeName = (shapesNamePrefix ? (shapesNamePrefix + "-" + nextShape) : nextShape);
+                scene.loadShape(shapeName, nextShape, loadParams);
+            }
+            while (shapesToLoad.length && TurbulenzEngine.getTime() < endTime);
+
+            if (tracing)
+            {
+                Trace.end("Scene.loadShapes", "scene");
+            }
 
             if (shapesToLoad.length)
             {
@@ -4868,10 +6950,26 @@ class Scene
 
         var sceneLoadNextCustomShape = function sceneLoadNextCustomShapeFn()
         {
-            var nextShape = customShapesToLoad.pop();
+            var tracing = (typeof Trace !== "undefined" && Trace.enabled);
+            if (tracing)
+            {
+                Trace.begin("Scene.loadCustomShapes", "scene", { numPending: customShapesToLoad.length });
+            }
+
+            var endTime = (TurbulenzEngine.getTime() + maxTime);
+            do
+            {
+                var nextShape = customShapesToLoad.pop();
+
+                var shapeName = (shapesNamePrefix ? (shapesNamePrefix + "-" + nextShape) : nextShape);
+                loadCustomShapeFn.call(scene, shapeName, nextShape, loadParams);
+            }
+            while (customShapesToLoad.length && TurbulenzEngine.getTime() < endTime);
 
-            var shapeName = (shapesNamePrefix ? (shapesNamePrefix + "-" + nextShape) : nextShape);
-            loadCustomShapeFn.call(scene, shapeName, nextShape, loadParams);
+            if (tracing)
+            {
+                Trace.end("Scene.loadCustomShapes", "scene");
+            }
 
             if (customShapesToLoad.length)
             {
@@ -5017,6 +7115,13 @@ class Scene
 
         var loadCustomGeometryInstanceFn = loadParams.loadCustomGeometryInstanceFn;
 
+        var streamAreas = (gd && loadParams.streamAreas && this.streaming);
+        if (streamAreas)
+        {
+            // Streamed shapes have no buffers to merge
+            optimizeRenderables = false;
+        }
+
         var md = this.md;
         var m43Build = md.m43Build;
         var materials = this.materials;
@@ -5180,8 +7285,12 @@ class Scene
                             if (!effect)
                             {
                                 // Load the textures since if the effect is undefined then scene.loadMaterial
-                                // has not yet been called for this material
-                                sharedMaterial.loadTextures(textureManager);
+                                // has not yet been called for this material,
+                                // streamed materials load them by area
+                                if (!streamAreas)
+                                {
+                                    sharedMaterial.loadTextures(textureManager);
+                                }
                                 var effectName = sharedMaterial.effectName;
                                 delete sharedMaterial.effectName;
                                 effect = effectManager.get(effectName);
@@ -5203,6 +7312,10 @@ class Scene
                             {
                                 geometryInstance.disabled = true;
                             }
+                            else if (streamAreas)
+                            {
+                                currentScene._addStreamedInstance(geometryInstance);
+                            }
 
                         }
                         else
@@ -5642,10 +7755,61 @@ class Scene
         {
             this.clearShapes();
             this.semantics = <Semantics><any>{}; // TODO: null?
+            this.streaming = null;
+        }
+
+        var streamAreas: SceneAreaStreamingParams = loadParams.streamAreas;
+        if (streamAreas &&
+            loadParams.graphicsDevice &&
+            !this.streaming)
+        {
+            var loadDistance = streamAreas.loadDistance;
+            this.streaming = {
+                loadDistance: loadDistance,
+                unloadDistance: Math.max((streamAreas.unloadDistance || 0), loadDistance),
+                maxBytes: (streamAreas.maxBytes || Number.MAX_VALUE),
+                maxTime: (streamAreas.maxTime || 0),
+                yieldFn: (loadParams.yieldFn || Scene.defaultYield),
+                graphicsDevice: loadParams.graphicsDevice,
+                textureManager: loadParams.textureManager,
+                shapes: {},
+                materials: {},
+                textures: {},
+                requestedAreas: [],
+                budgetDistance: Number.MAX_VALUE,
+                queue: [],
+                queryExtents: this.md.aabbBuildEmpty(),
+                bytes: 0,
+                running: false,
+                resume: null,
+                onTextureChanged: null
+            };
+
+            this.streaming.onTextureChanged = function sceneOnStreamedTextureChangedFn(textureInstance)
+            {
+                var streamedTexture = scene.streaming.textures[textureInstance.name];
+                if (streamedTexture && streamedTexture.instance === textureInstance)
+                {
+                    scene._updateStreamedTextureBytes(streamedTexture);
+                }
+            };
+        }
+
+        // The stages run on their own spans inside an async span for the
+        // whole load, which may be spread over several frames by yieldFn
+        var traceId = (typeof Trace !== "undefined" ? Trace.newId() : 0);
+        if (traceId)
+        {
+            Trace.beginAsync("Scene.load", traceId, "scene");
         }
 
         var sceneCompleteLoadStage = function sceneCompleteLoadStageFn()
         {
+            if (traceId)
+            {
+                Trace.begin("Scene.loadNodes", "scene");
+            }
+
             if (loadParams.keepLights)
             {
                 scene.loadLights(loadParams);
@@ -5660,14 +7824,36 @@ class Scene
 
             scene.loadAreas(loadParams);
 
+            if (traceId)
+            {
+                Trace.end("Scene.loadNodes", "scene");
+                Trace.begin("Scene.endLoading", "scene");
+            }
+
             scene.endLoading(loadParams.onload);
+
+            if (traceId)
+            {
+                Trace.end("Scene.endLoading", "scene");
+                Trace.endAsync("Scene.load", traceId, "scene");
+            }
         };
 
+        if (traceId)
+        {
+            Trace.begin("Scene.loadMaterials", "scene");
+        }
+
         if (loadParams.graphicsDevice)
         {
             this.loadMaterials(loadParams);
         }
 
+        if (traceId)
+        {
+            Trace.end("Scene.loadMaterials", "scene");
+        }
+
         // Needs to be called before the geometry is loaded by loadNodes or streamShapes
         scene.loadSkeletons(loadParams);
 
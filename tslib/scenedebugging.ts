@@ -4,6 +4,7 @@
 /*global GeometryInstance*/
 /*global Utilities*/
 /*global TurbulenzEngine*/
+/*global VertexBufferManager*/
 
 interface SceneMetrics
 {
@@ -344,10 +345,10 @@ Scene.prototype.drawLights = function sceneDrawLightsFn(gd, sm, camera)
 
         var sem = this.getDebugSemanticsPosCol();
         var vformatFloat3 = gd.VERTEXFORMAT_FLOAT3;
-        var writer = gd.beginDraw(gd.PRIMITIVE_LINES,
-                                  ((24 * numPoint) + (16 * numSpot) + (24 * numFog)),
-                                  [ vformatFloat3, vformatFloat3 ],
-                                  sem);
+        var writer = this.beginDebugDraw(gd, gd.PRIMITIVE_LINES,
+                                             ((24 * numPoint) + (16 * numSpot) + (24 * numFog)),
+                                             [ vformatFloat3, vformatFloat3 ],
+                                             sem);
         if (writer)
         {
             var md = this.md;
@@ -428,7 +429,7 @@ Scene.prototype.drawLights = function sceneDrawLightsFn(gd, sm, camera)
             }
             while (n < numVisibleNodes);
 
-            gd.endDraw(writer);
+            this.endDebugDraw(gd, writer);
         }
     }
 };
@@ -495,11 +496,11 @@ Scene.prototype.drawLightsExtents = function sceneDrawLightsExtentsFn(gd, sm, ca
         gd.setTechniqueParameters(techniqueParameters);
 
         var sem = this.getDebugSemanticsPosCol();
-        var writer = gd.beginDraw(gd.PRIMITIVE_LINES,
-                                  (24 * numLights),
-                                  [ gd.VERTEXFORMAT_FLOAT3,
-                                    gd.VERTEXFORMAT_FLOAT3 ],
-                                  sem);
+        var writer = this.beginDebugDraw(gd, gd.PRIMITIVE_LINES,
+                                             (24 * numLights),
+                                             [ gd.VERTEXFORMAT_FLOAT3,
+                                               gd.VERTEXFORMAT_FLOAT3 ],
+                                             sem);
         if (writer)
         {
             var writeBox = this.writeBox;
@@ -534,7 +535,7 @@ Scene.prototype.drawLightsExtents = function sceneDrawLightsExtentsFn(gd, sm, ca
             }
             while (n < numVisibleLights);
 
-            gd.endDraw(writer);
+            this.endDebugDraw(gd, writer);
         }
     }
 };
@@ -591,11 +592,11 @@ Scene.prototype.drawLightsScreenExtents = function sceneDrawLightsScreenExtentsF
         technique.clipSpace = this.md.v4Build(1.0, 1.0, 0.0, 0.0);
 
         var sem = this.getDebugSemanticsPosCol();
-        var writer = gd.beginDraw(gd.PRIMITIVE_LINES,
-                                  (8 * numLights),
-                                  [ gd.VERTEXFORMAT_FLOAT2,
-                                    gd.VERTEXFORMAT_FLOAT3 ],
-                                  sem);
+        var writer = this.beginDebugDraw(gd, gd.PRIMITIVE_LINES,
+                                             (8 * numLights),
+                                             [ gd.VERTEXFORMAT_FLOAT2,
+                                               gd.VERTEXFORMAT_FLOAT3 ],
+                                             sem);
         if (writer)
         {
             var screenExtents, minX, maxX, minY, maxY, color, r, g, b;
@@ -644,7 +645,7 @@ Scene.prototype.drawLightsScreenExtents = function sceneDrawLightsScreenExtentsF
             }
             while (n < numVisibleLights);
 
-            gd.endDraw(writer);
+            this.endDebugDraw(gd, writer);
         }
     }
 };
@@ -721,10 +722,10 @@ Scene.prototype.drawAreas = function sceneDrawAreasFn(gd, sm, camera)
 
         var sem = this.getDebugSemanticsPosCol();
         var vformatFloat3 = gd.VERTEXFORMAT_FLOAT3;
-        var writer = gd.beginDraw(gd.PRIMITIVE_LINES,
-                                  (24 * numVisibleAreas),
-                                  [ vformatFloat3, vformatFloat3 ],
-                                  sem);
+        var writer = this.beginDebugDraw(gd, gd.PRIMITIVE_LINES,
+                                             (24 * numVisibleAreas),
+                                             [ vformatFloat3, vformatFloat3 ],
+                                             sem);
         if (writer)
         {
             var writeBox = this.writeBox;
@@ -758,7 +759,7 @@ Scene.prototype.drawAreas = function sceneDrawAreasFn(gd, sm, camera)
                 writeBox(writer, area.extents, r, g, b);
             }
 
-            gd.endDraw(writer);
+            this.endDebugDraw(gd, writer);
         }
     }
 };
@@ -811,10 +812,10 @@ Scene.prototype.drawPortals = function sceneDrawPortalsFn(gd, sm, camera)
         technique.constantColor = md.v4Build(1.0, 1.0, 1.0, 1.0);
 
         var sem = this.getDebugSemanticsPos();
-        var writer = gd.beginDraw(gd.PRIMITIVE_LINES,
-                                  numVertices,
-                                  [gd.VERTEXFORMAT_FLOAT3],
-                                  sem);
+        var writer = this.beginDebugDraw(gd, gd.PRIMITIVE_LINES,
+                                             numVertices,
+                                             [gd.VERTEXFORMAT_FLOAT3],
+                                             sem);
         if (writer)
         {
             var numPortalsToRender = portalsToRender.length;
@@ -832,7 +833,7 @@ Scene.prototype.drawPortals = function sceneDrawPortalsFn(gd, sm, camera)
                 }
             }
 
-            gd.endDraw(writer);
+            this.endDebugDraw(gd, writer);
         }
 
         // Now redraw visible ones in yellow
@@ -854,10 +855,10 @@ Scene.prototype.drawPortals = function sceneDrawPortalsFn(gd, sm, camera)
 
         technique.constantColor = md.v4Build(1.0, 1.0, 0.0, 1.0);
 
-        writer = gd.beginDraw(gd.PRIMITIVE_LINES,
-                              numVertices,
-                              [gd.VERTEXFORMAT_FLOAT3],
-                              sem);
+        writer = this.beginDebugDraw(gd, gd.PRIMITIVE_LINES,
+                                         numVertices,
+                                         [gd.VERTEXFORMAT_FLOAT3],
+                                         sem);
         if (writer)
         {
             for (n = 0; n < numVisiblePortals; n += 1)
@@ -874,7 +875,7 @@ Scene.prototype.drawPortals = function sceneDrawPortalsFn(gd, sm, camera)
                 }
             }
 
-            gd.endDraw(writer);
+            this.endDebugDraw(gd, writer);
         }
     }
 };
@@ -920,10 +921,10 @@ Scene.prototype.drawTransforms = function sceneDrawTransformsFn(gd, sm, camera,
         gd.setTechniqueParameters(techniqueParameters);
 
         var sem = this.getDebugSemanticsPosCol();
-        var writer = gd.beginDraw(gd.PRIMITIVE_LINES,
-                                  numVertices,
-                                  [gd.VERTEXFORMAT_FLOAT3, gd.VERTEXFORMAT_FLOAT3],
-                                  sem);
+        var writer = this.beginDebugDraw(gd, gd.PRIMITIVE_LINES,
+                                             numVertices,
+                                             [gd.VERTEXFORMAT_FLOAT3, gd.VERTEXFORMAT_FLOAT3],
+                                             sem);
         if (writer)
         {
             for (n = 0; n < numNodes; n += 1)
@@ -949,7 +950,7 @@ Scene.prototype.drawTransforms = function sceneDrawTransformsFn(gd, sm, camera,
             writer(0, 0, 0, 0, 0, 0);
             writer(0, 0, scale, 0, 0, 1);
 
-            gd.endDraw(writer);
+            this.endDebugDraw(gd, writer);
 
             writer = null;
         }
@@ -1018,10 +1019,10 @@ Scene.prototype.drawAnimationHierarchy = function sceneDrawAnimationHierarchyFn(
     gd.setTechniqueParameters(techniqueParameters);
 
     var sem = this.getDebugSemanticsPosCol();
-    var writer = gd.beginDraw(gd.PRIMITIVE_LINES,
-                              numVertices,
-                              [gd.VERTEXFORMAT_FLOAT3, gd.VERTEXFORMAT_FLOAT3],
-                              sem);
+    var writer = this.beginDebugDraw(gd, gd.PRIMITIVE_LINES,
+                                         numVertices,
+                                         [gd.VERTEXFORMAT_FLOAT3, gd.VERTEXFORMAT_FLOAT3],
+                                         sem);
     if (writer)
     {
         var md = this.md;
@@ -1093,7 +1094,7 @@ Scene.prototype.drawAnimationHierarchy = function sceneDrawAnimationHierarchyFn(
             this.writeBox(writer, extents, rBound, gBound, bBound);
         }
 
-        gd.endDraw(writer);
+        this.endDebugDraw(gd, writer);
     }
 };
 
@@ -1182,10 +1183,10 @@ Scene.prototype.drawSceneNodeHierarchy = function drawSceneNodeHierarchy(gd, sm,
     gd.setTechniqueParameters(techniqueParameters);
 
     var sem = this.getDebugSemanticsPosCol();
-    var writer = gd.beginDraw(gd.PRIMITIVE_LINES,
-                              numVertices,
-                              [gd.VERTEXFORMAT_FLOAT3, gd.VERTEXFORMAT_FLOAT3],
-                              sem);
+    var writer = this.beginDebugDraw(gd, gd.PRIMITIVE_LINES,
+                                         numVertices,
+                                         [gd.VERTEXFORMAT_FLOAT3, gd.VERTEXFORMAT_FLOAT3],
+                                         sem);
     if (writer)
     {
         var md = this.md;
@@ -1196,7 +1197,7 @@ Scene.prototype.drawSceneNodeHierarchy = function drawSceneNodeHierarchy(gd, sm,
             drawNodeHierarchy(nodeRoot, writer, md);
         }
 
-        gd.endDraw(writer);
+        this.endDebugDraw(gd, writer);
     }
 };
 
@@ -2068,10 +2069,10 @@ Scene.prototype.drawPhysicsNodes = function sceneDrawPhysicsNodesFn(gd, sm, came
 
     var sem = this.getDebugSemanticsPosCol();
     var vformatFloat3 = gd.VERTEXFORMAT_FLOAT3;
-    var writer = gd.beginDraw(gd.PRIMITIVE_LINES,
-                              (24 * numNodes),
-                              [vformatFloat3, vformatFloat3],
-                              sem);
+    var writer = this.beginDebugDraw(gd, gd.PRIMITIVE_LINES,
+                                         (24 * numNodes),
+                                         [vformatFloat3, vformatFloat3],
+                                         sem);
     if (writer)
     {
         var transform = physicsManager.mathsDevice.m43BuildIdentity();
@@ -2104,7 +2105,7 @@ Scene.prototype.drawPhysicsNodes = function sceneDrawPhysicsNodesFn(gd, sm, came
             this.writeRotatedBox(writer, transform, body.shape.halfExtents, r, g, b);
         }
 
-        gd.endDraw(writer);
+        this.endDebugDraw(gd, writer);
     }
 };
 
@@ -2539,10 +2540,10 @@ Scene.prototype.drawVisibleRenderablesExtents = function sceneDrawVisibleRendera
         gd.setTechniqueParameters(techniqueParameters);
 
         var sem = this.getDebugSemanticsPos();
-        var writer = gd.beginDraw(gd.PRIMITIVE_LINES,
-                                  (24 * numExtents),
-                                  [gd.VERTEXFORMAT_FLOAT3],
-                                  sem);
+        var writer = this.beginDebugDraw(gd, gd.PRIMITIVE_LINES,
+                                             (24 * numExtents),
+                                             [gd.VERTEXFORMAT_FLOAT3],
+                                             sem);
         if (writer)
         {
             for (n = 0; n < numExtents; n += 1)
@@ -2592,7 +2593,7 @@ Scene.prototype.drawVisibleRenderablesExtents = function sceneDrawVisibleRendera
                 writer(n0, p1, p2);
             }
 
-            gd.endDraw(writer);
+            this.endDebugDraw(gd, writer);
 
             writer = null;
         }
@@ -2764,15 +2765,15 @@ Scene.prototype.drawNodesTree = function sceneDrawNodesTreeFn(tree, gd, sm, came
         var numVertices = 24 * md.truncate(Math.pow(2, drawLevel));
 
         var sem = this.getDebugSemanticsPos();
-        var writer = gd.beginDraw(gd.PRIMITIVE_LINES,
-                                  numVertices,
-                                  [gd.VERTEXFORMAT_FLOAT3],
-                                  sem);
+        var writer = this.beginDebugDraw(gd, gd.PRIMITIVE_LINES,
+                                             numVertices,
+                                             [gd.VERTEXFORMAT_FLOAT3],
+                                             sem);
         if (writer)
         {
             drawNodeFn(writer, nodes, 0, drawLevel);
 
-            gd.endDraw(writer);
+            this.endDebugDraw(gd, writer);
 
             writer = null;
         }
@@ -2832,10 +2833,10 @@ Scene.prototype.drawCellsGrid = function sceneDrawCellsGridFn(grid, gd, sm, came
 
         var sem = this.getDebugSemanticsPosCol();
         var vformatFloat3 = gd.VERTEXFORMAT_FLOAT3;
-        var writer = gd.beginDraw(gd.PRIMITIVE_LINES,
-                                  24 * numUsedCells,
-                                  [ vformatFloat3, vformatFloat3 ],
-                                  sem);
+        var writer = this.beginDebugDraw(gd, gd.PRIMITIVE_LINES,
+                                             24 * numUsedCells,
+                                             [ vformatFloat3, vformatFloat3 ],
+                                             sem);
         if (writer)
         {
             var cellSize = grid.getCellSize();
@@ -2882,7 +2883,7 @@ Scene.prototype.drawCellsGrid = function sceneDrawCellsGridFn(grid, gd, sm, came
                 cellExtents[5] += cellSize;
             }
 
-            gd.endDraw(writer);
+            this.endDebugDraw(gd, writer);
 
             writer = null;
         }
@@ -3850,3 +3851,111 @@ Scene.prototype.getDebugSemanticsPos = function getDebugSemanticsPosFn()
     }
     return debugSemantics;
 };
+
+//
+// beginDebugDraw
+//
+// Same as GraphicsDevice.beginDraw but the vertices are written to a
+// VertexBufferRing for each vertex format, so consecutive debug draws do not
+// overwrite the vertices of the previous ones
+//
+Scene.prototype.beginDebugDraw = function beginDebugDrawFn(gd, primitive, numVertices, formats, semantics)
+{
+    if (numVertices <= 0)
+    {
+        return null;
+    }
+
+    var vertexBufferManager = this.vertexBufferManager;
+    if (!vertexBufferManager)
+    {
+        vertexBufferManager = VertexBufferManager.create(gd);
+        this.vertexBufferManager = vertexBufferManager;
+    }
+
+    var debugVertexRings = this.debugVertexRings;
+    if (!debugVertexRings)
+    {
+        debugVertexRings = {};
+        this.debugVertexRings = debugVertexRings;
+    }
+
+    var formatsKey = formats.join(',');
+    var ring = debugVertexRings[formatsKey];
+    if (!ring || ring.numVertices < numVertices)
+    {
+        var ringVertices = (ring ? ring.numVertices : 1024);
+        while (ringVertices < numVertices)
+        {
+            ringVertices *= 2;
+        }
+        if (ring)
+        {
+            vertexBufferManager.destroyRing(ring);
+        }
+        ring = vertexBufferManager.createRing(ringVertices, formats);
+        debugVertexRings[formatsKey] = ring;
+        if (!ring)
+        {
+            return null;
+        }
+    }
+
+    var data = ring.data;
+    var stride = ring.stride;
+    var index = ring.allocate(numVertices);
+    var start = (index * stride);
+    var end = (start + (numVertices * stride));
+    var dst = start;
+
+    var writer = <any>function debugDrawWriterFn()
+    {
+        var numArguments = arguments.length;
+        var a, n;
+        for (a = 0; a < numArguments; a += 1)
+        {
+            var value = arguments[a];
+            if (typeof value === 'number')
+            {
+                data[dst] = value;
+                dst += 1;
+            }
+            else
+            {
+                var numValues = value.length;
+                for (n = 0; n < numValues; n += 1)
+                {
+                    data[dst + n] = value[n];
+                }
+                dst += numValues;
+            }
+        }
+        debug.assert(dst <= end, "Too many vertices written");
+    };
+
+    writer.ring = ring;
+    writer.index = index;
+    writer.primitive = primitive;
+    writer.semantics = semantics;
+    writer.getNumWrittenVertices = function getNumWrittenVerticesFn()
+    {
+        return Math.floor((Math.min(dst, end) - start) / stride);
+    };
+
+    return writer;
+};
+
+//
+// endDebugDraw
+//
+Scene.prototype.endDebugDraw = function endDebugDrawFn(gd, writer)
+{
+    var numVertices = writer.getNumWrittenVertices();
+    if (numVertices > 0)
+    {
+        var ring = writer.ring;
+        ring.flush();
+        gd.setStream(ring.vertexBuffer, writer.semantics, writer.index);
+        gd.draw(writer.primitive, numVertices);
+    }
+};
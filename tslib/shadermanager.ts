@@ -2,6 +2,7 @@
 
 /*global Observer: false*/
 /*global TurbulenzEngine: false*/
+/*global Trace: false*/
 
 "use strict";
 
@@ -10,6 +11,12 @@ interface ShaderManagerShaders
     [path: string]: Shader;
 }
 
+// Names of the techniques used for each shader path
+interface ShaderManagerWarmupList
+{
+    [path: string]: string[];
+}
+
 //
 // ShaderManager
 //
@@ -29,6 +36,8 @@ class ShaderManager
     isShaderMissing: (path: string) => boolean;
     setPathRemapping: (prm, assetUrl) => void;
     setAutomaticParameterResize: (name: string, size: number) => void;
+    getWarmupList: () => ShaderManagerWarmupList;
+    warmup: (list: ShaderManagerWarmupList, callback?: { (): void; }) => void;
     destroy: () => void;
 
     /**
@@ -163,6 +172,13 @@ class ShaderManager
                     loadingShader[path] = true;
                     numLoadingShaders += 1;
 
+                    var traceId = (typeof Trace !== "undefined" ? Trace.newId() : 0);
+                    if (traceId)
+                    {
+                        Trace.beginAsync(path, traceId, "shader");
+                        Trace.counter("Loading shaders", numLoadingShaders, "shader");
+                    }
+
                     var observer = Observer.create();
                     loadedObservers[path] = observer;
                     if (onShaderLoaded)
@@ -187,18 +203,38 @@ class ShaderManager
                             delete loadedObservers[path];
                             numLoadingShaders -= 1;
 
+                            if (traceId)
+                            {
+                                Trace.endAsync(path, traceId, "shader", { loaded: !!shader });
+                                Trace.counter("Loading shaders", numLoadingShaders, "shader");
+                            }
+
                             observer.notify(shader);
                         }
 
                         if (shaderText)
                         {
+                            if (traceId)
+                            {
+                                Trace.begin("JSON.parse", "shader", { path: path, length: shaderText.length });
+                            }
                             var shaderParameters = JSON.parse(shaderText);
                             if (doPreprocess)
                             {
                                 preprocessShader(shaderParameters);
                             }
+                            if (traceId)
+                            {
+                                Trace.end("JSON.parse", "shader");
+                                Trace.begin("createShader", "shader", { path: path });
+                            }
 
                             gd.createShader(shaderParameters, shaderCreated);
+
+                            if (traceId)
+                            {
+                                Trace.end("createShader", "shader");
+                            }
                         }
                         else
                         {
@@ -211,6 +247,12 @@ class ShaderManager
                             delete loadedObservers[path];
                             numLoadingShaders -= 1;
 
+                            if (traceId)
+                            {
+                                Trace.endAsync(path, traceId, "shader", { loaded: false });
+                                Trace.counter("Loading shaders", numLoadingShaders, "shader");
+                            }
+
                             observer.notify(null);
                         }
                     };
@@ -461,6 +503,162 @@ class ShaderManager
             resizeParameters[name] = size;
         };
 
+        /**
+           Get the techniques used so far for every loaded shader, to be
+           stored and given to warmup on the next session
+
+           @memberOf ShaderManager.prototype
+           @public
+           @function
+           @name getWarmupList
+
+           @return {object} Dictionary of technique names by shader path
+        */
+        sm.getWarmupList = function getWarmupListFn(): ShaderManagerWarmupList
+        {
+            var list: ShaderManagerWarmupList = {};
+            for (var p in shaders)
+            {
+                if (shaders.hasOwnProperty(p) && p !== defaultShaderName)
+                {
+                    var shader = shaders[p];
+                    if (shader)
+                    {
+                        var techniqueNames = [];
+                        var numTechniques = shader.numTechniques;
+                        var n;
+                        for (n = 0; n < numTechniques; n += 1)
+                        {
+                            var technique = shader.getTechnique(n);
+                            if (technique && technique.initialized)
+                            {
+                                techniqueNames.push(technique.name);
+                            }
+                        }
+                        if (techniqueNames.length)
+                        {
+                            list[p] = techniqueNames;
+                        }
+                    }
+                }
+            }
+            return list;
+        };
+
+        /**
+           Loads the shaders of a warm up list and links the listed
+           techniques in time slices, the callback is called once all of
+           them are ready to be used without stalling
+
+           @memberOf ShaderManager.prototype
+           @public
+           @function
+           @name warmup
+
+           @param {object} list Warm up list from getWarmupList
+           @param {function} callback Called once all techniques are ready
+        */
+        sm.warmup = function warmupFn(list: ShaderManagerWarmupList, callback?: { (): void; })
+        {
+            // Links for half of each interval to keep the page responsive
+            var warmupInterval = 16;
+            var warmupLinkTime = 8;
+
+            var pendingTechniques: Technique[] = [];
+            var numPendingShaders = 1;
+            var intervalID = null;
+
+            function checkTechniquesFn()
+            {
+                // The manager was destroyed while warming up
+                if (!gd)
+                {
+                    TurbulenzEngine.clearInterval(intervalID);
+                    intervalID = null;
+                    return;
+                }
+
+                var tracing = (typeof Trace !== "undefined" && Trace.enabled);
+                if (tracing)
+                {
+                    Trace.begin("updateShaderPrograms", "shader", { numPending: pendingTechniques.length });
+                }
+
+                gd.updateShaderPrograms(warmupLinkTime);
+
+                if (tracing)
+                {
+                    Trace.end("updateShaderPrograms", "shader");
+                }
+
+                var numTechniques = pendingTechniques.length;
+                var n = 0;
+                while (n < numTechniques)
+                {
+                    if (pendingTechniques[n].isReady())
+                    {
+                        numTechniques -= 1;
+                        pendingTechniques[n] = pendingTechniques[numTechniques];
+                        pendingTechniques.length = numTechniques;
+                    }
+                    else
+                    {
+                        n += 1;
+                    }
+                }
+
+                if (!numTechniques)
+                {
+                    TurbulenzEngine.clearInterval(intervalID);
+                    intervalID = null;
+                    if (callback)
+                    {
+                        callback();
+                    }
+                }
+            }
+
+            var onShaderLoaded = function onShaderLoadedFn(path: string)
+            {
+                return function warmupShaderLoadedFn(shader: Shader)
+                {
+                    if (shader)
+                    {
+                        var techniqueNames = list[path];
+                        var numTechniqueNames = techniqueNames.length;
+                        var n;
+                        for (n = 0; n < numTechniqueNames; n += 1)
+                        {
+                            var technique = shader.getTechnique(techniqueNames[n]);
+                            if (technique)
+                            {
+                                pendingTechniques.push(technique);
+                            }
+                        }
+                    }
+
+                    numPendingShaders -= 1;
+                    if (numPendingShaders === 0)
+                    {
+                        intervalID = TurbulenzEngine.setInterval(checkTechniquesFn, warmupInterval);
+                    }
+                };
+            };
+
+            for (var p in list)
+            {
+                if (list.hasOwnProperty(p))
+                {
+                    numPendingShaders += 1;
+                    loadShader(p, onShaderLoaded(p));
+                }
+            }
+
+            // Balances the initial count so checks only start after every
+            // shader has loaded, even if they were all loaded already
+            onShaderLoaded(null)(null);
+        };
+
         sm.destroy = function shaderManagerDestroyFn()
         {
             if (shaders)
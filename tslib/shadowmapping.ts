@@ -5,14 +5,32 @@
 //
 /*global renderingCommonCreateRendererInfoFn: false, Camera: false*/
 
+//
+// ShadowMap: A square region of the shadow atlas owned by a light instance.
+// The map is only redrawn when its light or the overlapping occluders change.
+//
 interface ShadowMap
 {
-    shadowMapTexture: Texture;
-    shadowMapRenderTarget: RenderTarget;
-    lightInstance: LightInstance;
-
-    // TODO: Is this ever set?  DeferredRendering appears to refer to it.
-    texture?: Texture;
+    texture         : Texture;      // The shadow atlas
+    renderTarget    : RenderTarget; // The shadow atlas render target
+    lightInstance   : LightInstance;
+
+    x               : number;
+    y               : number;
+    size            : number;
+    level           : number;
+    block           : number;
+
+    frameUsed       : number;
+    frameVisible    : number; // Frame the map was last drawn
+    needsBlur       : boolean;
+
+    // What the map was drawn with
+    numRenderables  : number;
+    occluders       : any[]; // SceneNode and its worldUpdate for every occluder, in order
+    minLightDistance: number;
+    maxLightDistance: number;
+    viewProjection  : any; // m44
 };
 
 class ShadowMapping
@@ -25,6 +43,10 @@ class ShadowMapping
     defaultSizeHigh = 1024;
     blurEnabled = true;
 
+    // Maps for lights covering less than this fraction of the view are
+    // halved in size for each halving of their coverage
+    fullSizeCoverage = 0.25;
+
     gd                  : GraphicsDevice;
     md                  : MathDevice;
     clearColor          : any; // v4
@@ -42,6 +64,7 @@ class ShadowMapping
 
     pixelOffsetH        : number[];
     pixelOffsetV        : number[];
+    blurRect            : number[];
 
     node                : SceneNode;
 
@@ -50,21 +73,20 @@ class ShadowMapping
 
     techniqueParameters : TechniqueParameters;
     shader              : Shader;
-    shadowMapsLow       : ShadowMap[];
-    shadowMapsHigh      : ShadowMap[];
 
     sizeLow             : number;
     sizeHigh            : number;
+    minSize             : number;
 
-    lowIndex            : number;
-    highIndex           : number;
+    atlasSize           : number;
+    atlasTexture        : Texture;
+    atlasRenderTarget   : RenderTarget;
+    depthBuffer         : RenderBuffer;
+    blurTexture         : Texture;
+    blurRenderTarget    : RenderTarget;
 
-    blurTextureHigh      : Texture;
-    blurTextureLow       : Texture;
-    depthBufferLow       : RenderBuffer;
-    depthBufferHigh      : RenderBuffer;
-    blurRenderTargetHigh : RenderTarget;
-    blurRenderTargetLow  : RenderTarget;
+    shadowMaps          : ShadowMap[];
+    freeBlocks          : number[][]; // Free atlas blocks per level
 
     occludersExtents     : any[];
 
@@ -117,87 +139,56 @@ class ShadowMapping
 
     destroyBuffers()
     {
-        var shadowMaps, numShadowMaps, n, shadowMap, renderTarget, texture;
-
-        shadowMaps = this.shadowMapsLow;
+        var shadowMaps = this.shadowMaps;
         if (shadowMaps)
         {
-            numShadowMaps = shadowMaps.length;
+            var numShadowMaps = shadowMaps.length;
+            var n, shadowMap, lightInstance;
             for (n = 0; n < numShadowMaps; n += 1)
             {
                 shadowMap = shadowMaps[n];
-
-                renderTarget = shadowMap.renderTarget;
-                if (renderTarget)
+                lightInstance = shadowMap.lightInstance;
+                if (lightInstance && lightInstance.shadowMap === shadowMap)
                 {
-                    renderTarget.destroy();
-                    shadowMap.renderTarget = null;
-                }
-
-                texture = shadowMap.texture;
-                if (texture)
-                {
-                    texture.destroy();
-                    shadowMap.texture = null;
+                    lightInstance.shadowMap = null;
                 }
+                shadowMap.lightInstance = null;
+                shadowMap.texture = null;
+                shadowMap.renderTarget = null;
             }
             shadowMaps.length = 0;
         }
 
-        shadowMaps = this.shadowMapsHigh;
-        if (shadowMaps)
+        var freeBlocks = this.freeBlocks;
+        if (freeBlocks)
         {
-            numShadowMaps = shadowMaps.length;
-            for (n = 0; n < numShadowMaps; n += 1)
-            {
-                shadowMap = shadowMaps[n];
-
-                renderTarget = shadowMap.renderTarget;
-                if (renderTarget)
-                {
-                    renderTarget.destroy();
-                    shadowMap.renderTarget = null;
-                }
-
-                texture = shadowMap.texture;
-                if (texture)
-                {
-                    texture.destroy();
-                    shadowMap.texture = null;
-                }
-            }
-            shadowMaps.length = 0;
+            freeBlocks.length = 0;
         }
 
-        if (this.blurRenderTargetLow)
-        {
-            this.blurRenderTargetLow.destroy();
-            this.blurRenderTargetLow = null;
-        }
-        if (this.blurRenderTargetHigh)
+        if (this.atlasRenderTarget)
         {
-            this.blurRenderTargetHigh.destroy();
-            this.blurRenderTargetHigh = null;
+            this.atlasRenderTarget.destroy();
+            this.atlasRenderTarget = null;
         }
-        if (this.blurTextureLow)
+        if (this.blurRenderTarget)
         {
-            this.blurTextureLow.destroy();
-            this.blurTextureLow = null;
+            this.blurRenderTarget.destroy();
+            this.blurRenderTarget = null;
         }
-        if (this.blurTextureHigh)
+        if (this.atlasTexture)
         {
-            this.blurTextureHigh.destroy();
-            this.blurTextureHigh = null;
+            this.atlasTexture.destroy();
+            this.atlasTexture = null;
         }
-        if (this.depthBufferLow)
+        if (this.blurTexture)
         {
-            this.depthBufferLow.destroy();
-            this.depthBufferLow = null;
+            this.blurTexture.destroy();
+            this.blurTexture = null;
         }
-        if (this.depthBufferHigh)
+        if (this.depthBuffer)
         {
-            this.depthBufferHigh.destroy();
-            this.depthBufferHigh = null;
+            this.depthBuffer.destroy();
+            this.depthBuffer = null;
         }
     }
 
@@ -216,82 +207,306 @@ class ShadowMapping
 
         var gd = this.gd;
 
-        this.shadowMapsHigh = [];
-        this.shadowMapsLow = [];
-
         this.destroyBuffers();
 
-        this.depthBufferLow = gd.createRenderBuffer({
-                width: sizeLow,
-                height: sizeLow,
-                format: "D16"
+        // All the shadow maps share a single atlas with room for four high
+        // resolution maps
+        var atlasSize = (2 * sizeHigh);
+        var maxTextureSize = gd.maxSupported("TEXTURE_SIZE");
+        if (maxTextureSize && atlasSize > maxTextureSize)
+        {
+            atlasSize = maxTextureSize;
+        }
+
+        var minSize = Math.max(64, Math.floor(sizeLow / 4));
+        var freeBlocks = this.freeBlocks;
+        /* tslint:disable:no-bitwise */
+        do
+        {
+            freeBlocks.push([]);
+        }
+        while ((atlasSize >> freeBlocks.length) >= minSize);
+        /* tslint:enable:no-bitwise */
+        freeBlocks[0].push(0);
+
+        this.atlasTexture = gd.createTexture({
+                name: "shadowmap-atlas",
+                width: atlasSize,
+                height: atlasSize,
+                format: "R5G6B5",
+                mipmaps: false,
+                renderable: true
             });
 
-        this.depthBufferHigh = gd.createRenderBuffer({
-                width: sizeHigh,
-                height: sizeHigh,
+        this.depthBuffer = gd.createRenderBuffer({
+                width: atlasSize,
+                height: atlasSize,
                 format: "D16"
             });
 
         if (this.blurEnabled)
         {
-            this.blurTextureLow = gd.createTexture({
-                    name: "blur-low",
-                    width: sizeLow,
-                    height: sizeLow,
-                    format: "R5G6B5",
-                    mipmaps: false,
-                    renderable: true
-                });
-
-            this.blurTextureHigh = gd.createTexture({
-                    name: "blur-high",
-                    width: sizeHigh,
-                    height: sizeHigh,
+            this.blurTexture = gd.createTexture({
+                    name: "shadowmap-blur",
+                    width: atlasSize,
+                    height: atlasSize,
                     format: "R5G6B5",
                     mipmaps: false,
                     renderable: true
                 });
         }
 
-        if (this.depthBufferLow &&
-            this.depthBufferHigh &&
-            (!this.blurEnabled ||
-             (this.blurTextureLow &&
-              this.blurTextureHigh)))
+        if (this.atlasTexture &&
+            this.depthBuffer &&
+            (!this.blurEnabled || this.blurTexture))
         {
+            this.atlasRenderTarget = gd.createRenderTarget({
+                    colorTexture0: this.atlasTexture,
+                    depthBuffer: this.depthBuffer
+                });
+
             if (this.blurEnabled)
             {
-                this.blurRenderTargetLow = gd.createRenderTarget({
-                        colorTexture0: this.blurTextureLow
+                this.blurRenderTarget = gd.createRenderTarget({
+                        colorTexture0: this.blurTexture
                     });
-
-                this.blurRenderTargetHigh = gd.createRenderTarget({
-                        colorTexture0: this.blurTextureHigh
-                    });
-
-                if (this.blurRenderTargetLow &&
-                    this.blurRenderTargetHigh)
-                {
-                    this.sizeLow = sizeLow;
-                    this.sizeHigh = sizeHigh;
-                    return true;
-                }
             }
-            else
+
+            if (this.atlasRenderTarget &&
+                (!this.blurEnabled || this.blurRenderTarget))
             {
                 this.sizeLow = sizeLow;
                 this.sizeHigh = sizeHigh;
+                this.minSize = minSize;
+                this.atlasSize = atlasSize;
                 return true;
             }
         }
 
         this.sizeLow = 0;
         this.sizeHigh = 0;
+        this.minSize = 0;
+        this.atlasSize = 0;
         this.destroyBuffers();
         return false;
     }
 
+    // Blocks are numbered by their texel offset in the atlas, (y * atlasSize) + x.
+    // Level 0 is the whole atlas and each level below splits a block in four.
+    private _allocateBlock(level: number): number
+    {
+        var freeBlocks = this.freeBlocks[level];
+        if (freeBlocks.length)
+        {
+            return freeBlocks.pop();
+        }
+        if (0 === level)
+        {
+            return -1;
+        }
+
+        var parent = this._allocateBlock(level - 1);
+        if (parent < 0)
+        {
+            return -1;
+        }
+
+        var atlasSize = this.atlasSize;
+        /* tslint:disable:no-bitwise */
+        var size = (atlasSize >> level);
+        /* tslint:enable:no-bitwise */
+        freeBlocks.push(parent + (size * atlasSize) + size,
+                        parent + (size * atlasSize),
+                        parent + size);
+        return parent;
+    }
+
+    private _freeBlock(block: number, level: number): void
+    {
+        var freeBlocks = this.freeBlocks[level];
+        if (0 < level)
+        {
+            var atlasSize = this.atlasSize;
+            /* tslint:disable:no-bitwise */
+            var size = (atlasSize >> level);
+            /* tslint:enable:no-bitwise */
+            var parentSize = (2 * size);
+            var x = (block % atlasSize);
+            var y = ((block - x) / atlasSize);
+            var parent = (((y - (y % parentSize)) * atlasSize) + (x - (x % parentSize)));
+            var buddies = [parent,
+                           parent + size,
+                           parent + (size * atlasSize),
+                           parent + (size * atlasSize) + size];
+            var numFreeBuddies = 0;
+            var n, buddy;
+            for (n = 0; n < 4; n += 1)
+            {
+                buddy = buddies[n];
+                if (buddy !== block &&
+                    freeBlocks.indexOf(buddy) !== -1)
+                {
+                    numFreeBuddies += 1;
+                }
+            }
+
+            if (3 === numFreeBuddies)
+            {
+                for (n = 0; n < 4; n += 1)
+                {
+                    buddy = buddies[n];
+                    if (buddy !== block)
+                    {
+                        freeBlocks.splice(freeBlocks.indexOf(buddy), 1);
+                    }
+                }
+                this._freeBlock(parent, (level - 1));
+                return;
+            }
+        }
+        freeBlocks.push(block);
+    }
+
+    private _freeShadowMap(shadowMap: ShadowMap): void
+    {
+        this._freeBlock(shadowMap.block, shadowMap.level);
+
+        var lightInstance: any = shadowMap.lightInstance;
+        if (lightInstance && lightInstance.shadowMap === shadowMap)
+        {
+            lightInstance.shadowMap = null;
+        }
+        shadowMap.lightInstance = null;
+
+        var shadowMaps = this.shadowMaps;
+        var index = shadowMaps.indexOf(shadowMap);
+        var last = (shadowMaps.length - 1);
+        if (index < last)
+        {
+            shadowMaps[index] = shadowMaps[last];
+        }
+        shadowMaps.length = last;
+    }
+
+    // Frees the least recently used map not in use this frame
+    private _evictShadowMap(frame: number): boolean
+    {
+        var shadowMaps = this.shadowMaps;
+        var numShadowMaps = shadowMaps.length;
+        var oldest = null;
+        var n, shadowMap;
+        for (n = 0; n < numShadowMaps; n += 1)
+        {
+            shadowMap = shadowMaps[n];
+            if (shadowMap.frameUsed !== frame &&
+                (!oldest || shadowMap.frameUsed < oldest.frameUsed))
+            {
+                oldest = shadowMap;
+            }
+        }
+
+        if (oldest)
+        {
+            this._freeShadowMap(oldest);
+            return true;
+        }
+        return false;
+    }
+
+    // Size of the map for a light from the fraction of the view it covers
+    private _shadowMapSize(cameraMatrix: any, lightInstance: any,
+                           maxExtentSize: number, size: number): number
+    {
+        var world = lightInstance.node.world;
+        var dx = (world[9] - cameraMatrix[9]);
+        var dy = (world[10] - cameraMatrix[10]);
+        var dz = (world[11] - cameraMatrix[11]);
+        var distance = Math.sqrt((dx * dx) + (dy * dy) + (dz * dz));
+        if (maxExtentSize < distance)
+        {
+            var coverage = (maxExtentSize / distance);
+            var fullSizeCoverage = this.fullSizeCoverage;
+            var minSize = this.minSize;
+            while (coverage < fullSizeCoverage &&
+                   minSize < size)
+            {
+                coverage *= 2;
+                size *= 0.5;
+            }
+        }
+        return size;
+    }
+
+    private _allocateShadowMap(lightInstance: any, size: number): ShadowMap
+    {
+        var atlasSize = this.atlasSize;
+        var maxLevel = (this.freeBlocks.length - 1);
+        var level = 0;
+        /* tslint:disable:no-bitwise */
+        while (level < maxLevel &&
+               (atlasSize >> level) > size)
+        {
+            level += 1;
+        }
+        /* tslint:enable:no-bitwise */
+
+        var frame = lightInstance.frameVisible;
+        var shadowMap = lightInstance.shadowMap;
+        if (shadowMap &&
+            shadowMap.lightInstance === lightInstance)
+        {
+            // Keep the current map unless it is too small or more than one
+            // level too big, to avoid redrawing lights close to a threshold
+            if (shadowMap.level <= level &&
+                level <= (shadowMap.level + 1))
+            {
+                shadowMap.frameUsed = frame;
+                return shadowMap;
+            }
+            this._freeShadowMap(shadowMap);
+        }
+
+        var block = this._allocateBlock(level);
+        while (block < 0)
+        {
+            if (!this._evictShadowMap(frame))
+            {
+                // The atlas is full of maps in use this frame
+                if (level === maxLevel)
+                {
+                    return null;
+                }
+                level += 1;
+            }
+            block = this._allocateBlock(level);
+        }
+
+        var x = (block % atlasSize);
+        shadowMap = {
+            texture: this.atlasTexture,
+            renderTarget: this.atlasRenderTarget,
+            lightInstance: lightInstance,
+            x: x,
+            y: ((block - x) / atlasSize),
+            /* tslint:disable:no-bitwise */
+            size: (atlasSize >> level),
+            /* tslint:enable:no-bitwise */
+            level: level,
+            block: block,
+            frameUsed: frame,
+            frameVisible: -1,
+            needsBlur: false,
+            numRenderables: -1,
+            occluders: [],
+            minLightDistance: 0,
+            maxLightDistance: 0,
+            viewProjection: this.md.m44BuildIdentity()
+        };
+        this.shadowMaps.push(shadowMap);
+        lightInstance.shadowMap = shadowMap;
+        return shadowMap;
+    }
+
     findVisibleRenderables(lightInstance): boolean
     {
         var md = this.md;
@@ -308,7 +523,8 @@ class ShadowMapping
         {
             shadowMapInfo = {
                 camera: Camera.create(md),
-                target: md.v3BuildZero()
+                target: md.v3BuildZero(),
+                occluders: []
             };
             lightInstance.shadowMapInfo = shadowMapInfo;
         }
@@ -509,7 +725,8 @@ class ShadowMapping
             shadowMapInfo.staticNodesChangeCounter !== staticNodesChangeCounter)
         {
             var occludersExtents = this.occludersExtents;
-            var numOccluders = this._filterOccluders(overlappingRenderables,
+            var numOccluders = this._filterOccluders(shadowMapInfo,
+                                                     overlappingRenderables,
                                                      numStaticOverlappingRenderables,
                                                      occludersDrawArray,
                                                      occludersExtents);
@@ -600,7 +817,6 @@ class ShadowMapping
     {
         var md = this.md;
         var gd = this.gd;
-        var node = lightInstance.node;
         var light = lightInstance.light;
 
         var shadowMapInfo = lightInstance.shadowMapInfo;
@@ -630,111 +846,16 @@ class ShadowMapping
             return;
         }
 
-        var numStaticOverlappingRenderables = lightInstance.numStaticOverlappingRenderables;
-        var numOverlappingRenderables = lightInstance.overlappingRenderables.length;
-
         var maxExtentSize = Math.max(halfExtents0, halfExtents1, halfExtents2);
-        var shadowMap, shadowMapTexture, shadowMapRenderTarget, shadowMapSize;
-        if (maxExtentSize >= minExtentsHigh)
-        {
-            shadowMapSize = this.sizeHigh;
-            var shadowMapsHighIndex = this.highIndex;
-            if (shadowMapsHighIndex < this.shadowMapsHigh.length)
-            {
-                shadowMap = this.shadowMapsHigh[shadowMapsHighIndex];
-                shadowMapTexture = shadowMap.texture;
-                shadowMapRenderTarget = shadowMap.renderTarget;
-            }
-            else
-            {
-                shadowMapTexture = gd.createTexture({
-                        name: "shadowmap-high",
-                        width: shadowMapSize,
-                        height: shadowMapSize,
-                        format: "R5G6B5",
-                        mipmaps: false,
-                        renderable: true
-                    });
-                if (shadowMapTexture)
-                {
-                    shadowMapRenderTarget = gd.createRenderTarget({
-                            colorTexture0: shadowMapTexture,
-                            depthBuffer: this.depthBufferHigh
-                        });
-                    if (!shadowMapRenderTarget)
-                    {
-                        shadowMapTexture = null;
-                        return;
-                    }
-                    else
-                    {
-                        shadowMap = {
-                            texture: shadowMapTexture,
-                            renderTarget: shadowMapRenderTarget,
-                            lightInstance: lightInstance
-                        };
-                        this.shadowMapsHigh[shadowMapsHighIndex] = shadowMap;
-                    }
-                }
-                else
-                {
-                    return;
-                }
-            }
-
-            this.highIndex = (shadowMapsHighIndex + 1);
-        }
-        else
+        var shadowMapSize = this._shadowMapSize(cameraMatrix, lightInstance, maxExtentSize,
+                                                (maxExtentSize >= minExtentsHigh ? this.sizeHigh : this.sizeLow));
+        var shadowMap = this._allocateShadowMap(lightInstance, shadowMapSize);
+        if (!shadowMap)
         {
-            shadowMapSize = this.sizeLow;
-            var shadowMapsLowIndex = this.lowIndex;
-            if (shadowMapsLowIndex < this.shadowMapsLow.length)
-            {
-                shadowMap = this.shadowMapsLow[shadowMapsLowIndex];
-                shadowMapTexture = shadowMap.texture;
-                shadowMapRenderTarget = shadowMap.renderTarget;
-            }
-            else
-            {
-                shadowMapTexture = gd.createTexture({
-                        name: "shadowmap-low",
-                        width: shadowMapSize,
-                        height: shadowMapSize,
-                        format: "R5G6B5",
-                        mipmaps: false,
-                        renderable: true
-                    });
-                if (shadowMapTexture)
-                {
-                    shadowMapRenderTarget = gd.createRenderTarget({
-                            colorTexture0: shadowMapTexture,
-                            depthBuffer: this.depthBufferLow
-                        });
-                    if (!shadowMapRenderTarget)
-                    {
-                        shadowMapTexture = null;
-                        return;
-                    }
-                    else
-                    {
-                        shadowMap = {
-                            texture: shadowMapTexture,
-                            renderTarget: shadowMapRenderTarget,
-                            lightInstance: lightInstance
-                        };
-                        this.shadowMapsLow[shadowMapsLowIndex] = shadowMap;
-                    }
-                }
-                else
-                {
-                    return;
-                }
-            }
-
-            this.lowIndex = (shadowMapsLowIndex + 1);
+            return;
         }
+        shadowMapSize = shadowMap.size;
 
-        lightInstance.shadowMap = shadowMap;
         lightInstance.shadows = true;
 
         var distanceScale = (1.0 / 65536);
@@ -891,44 +1012,45 @@ class ShadowMapping
                                                      (-viewToShadowMatrix[11] - minLightDistance) * maxDepthReciprocal,
                                                      techniqueParameters.shadowDepth);
         techniqueParameters.shadowSize = shadowMapSize;
-        techniqueParameters.shadowMapTexture = shadowMapTexture;
-
-        var frameUpdated = lightInstance.frameVisible;
-
-        if (numStaticOverlappingRenderables === numOverlappingRenderables &&
-            !node.dynamic) // No dynamic renderables
+        techniqueParameters.shadowMapAtlas = md.v3Build(shadowMap.x,
+                                                        shadowMap.y,
+                                                        (1.0 / this.atlasSize),
+                                                        techniqueParameters.shadowMapAtlas);
+        techniqueParameters.shadowMapTexture = shadowMap.texture;
+
+        var occluders = shadowMapInfo.occluders;
+        var lastViewProjection = shadowMap.viewProjection;
+        if (!shadowMapInfo.occludersAnimated &&
+            shadowMap.numRenderables === numOccluders &&
+            this._occludersEqual(shadowMap.occluders, occluders) &&
+            shadowMap.minLightDistance === minLightDistance &&
+            shadowMap.maxLightDistance === maxLightDistance &&
+            this._m44Equal(lastViewProjection, shadowProjection))
         {
-            if (shadowMap.numRenderables === numOccluders &&
-                shadowMap.lightNode === node &&
-                (shadowMap.frameUpdated + 1) === frameUpdated)
-            {
-                // No need to update shadowmap
-                //Utilities.log(numOccluders);
-                shadowMap.frameUpdated = frameUpdated;
-                shadowMap.needsBlur = false;
-                return;
-            }
-            else
-            {
-                shadowMap.numRenderables = numOccluders;
-                shadowMap.lightNode = node;
-                shadowMap.frameUpdated = frameUpdated;
-                shadowMap.frameVisible = frameUpdated;
-                shadowMap.needsBlur = this.blurEnabled;
-            }
-        }
-        else
-        {
-            shadowMap.numRenderables = numOccluders;
-            shadowMap.frameVisible = frameUpdated;
-            shadowMap.needsBlur = this.blurEnabled;
+            // Neither the light nor its occluders changed, reuse the map
+            return;
         }
 
-        if (!gd.beginRenderTarget(shadowMapRenderTarget))
+        shadowMap.numRenderables = numOccluders;
+        this._copyOccluders(occluders, shadowMap.occluders);
+        shadowMap.minLightDistance = minLightDistance;
+        shadowMap.maxLightDistance = maxLightDistance;
+        md.m44Copy(shadowProjection, lastViewProjection);
+        shadowMap.frameVisible = lightInstance.frameVisible;
+        shadowMap.needsBlur = this.blurEnabled;
+
+        if (!gd.beginRenderTarget(shadowMap.renderTarget))
         {
+            shadowMap.numRenderables = -1;
+            shadowMap.needsBlur = false;
             return;
         }
 
+        var x = shadowMap.x;
+        var y = shadowMap.y;
+        gd.setViewport(x, y, shadowMapSize, shadowMapSize);
+        gd.setScissor(x, y, shadowMapSize, shadowMapSize);
+
         gd.clear(this.clearColor, 1.0, 0);
 
         /* tslint:disable:no-string-literal */
@@ -948,13 +1070,59 @@ class ShadowMapping
         gd.endRenderTarget();
     }
 
-    private _filterOccluders(overlappingRenderables: any[],
+    private _occludersEqual(a: any[], b: any[]): boolean
+    {
+        var length = a.length;
+        if (length !== b.length)
+        {
+            return false;
+        }
+        var n;
+        for (n = 0; n < length; n += 1)
+        {
+            if (a[n] !== b[n])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    private _copyOccluders(src: any[], dst: any[]): void
+    {
+        var length = src.length;
+        var n;
+        for (n = 0; n < length; n += 1)
+        {
+            dst[n] = src[n];
+        }
+        dst.length = length;
+    }
+
+    private _m44Equal(a: any, b: any): boolean
+    {
+        var n;
+        for (n = 0; n < 16; n += 1)
+        {
+            if (a[n] !== b[n])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    private _filterOccluders(shadowMapInfo: any,
+                             overlappingRenderables: any[],
                              numStaticOverlappingRenderables: number,
                              occludersDrawArray: any[],
                              occludersExtents: any[]): number
     {
         var numOverlappingRenderables = overlappingRenderables.length;
         var numOccluders = 0;
+        var occluders = shadowMapInfo.occluders;
+        var numOccluderNodes = 0;
+        var animated = false;
         var n, renderable, worldExtents, rendererInfo;
         var drawParametersArray, numDrawParameters, drawParametersIndex;
         for (n = 0; n < numOverlappingRenderables; n += 1)
@@ -972,6 +1140,15 @@ class ShadowMapping
                 {
                     rendererInfo.shadowMappingUpdate.call(renderable);
 
+                    // The map is only reused when drawn with the same nodes at the same updates
+                    occluders[numOccluderNodes] = renderable.node;
+                    occluders[numOccluderNodes + 1] = renderable.node.worldUpdate;
+                    numOccluderNodes += 2;
+                    if (renderable.skinController)
+                    {
+                        animated = true;
+                    }
+
                     if (n >= numStaticOverlappingRenderables)
                     {
                         worldExtents = renderable.getWorldExtents();
@@ -993,6 +1170,8 @@ class ShadowMapping
                 }
             }
         }
+        occluders.length = numOccluderNodes;
+        shadowMapInfo.occludersAnimated = animated;
         return numOccluders;
     }
 
@@ -1200,8 +1379,22 @@ class ShadowMapping
 
     blurShadowMaps()
     {
+        var shadowMaps = this.shadowMaps;
+        var numShadowMaps = shadowMaps.length;
+        var n, shadowMap;
+        for (n = 0; n < numShadowMaps; n += 1)
+        {
+            if (shadowMaps[n].needsBlur)
+            {
+                break;
+            }
+        }
+        if (n === numShadowMaps)
+        {
+            return;
+        }
+
         var gd = this.gd;
-        var numShadowMaps, n, shadowMaps, shadowMap, shadowMapBlurTexture, shadowMapBlurRenderTarget;
 
         gd.setStream(this.quadVertexBuffer, this.quadSemantics);
 
@@ -1212,90 +1405,66 @@ class ShadowMapping
 
         var pixelOffsetH = this.pixelOffsetH;
         var pixelOffsetV = this.pixelOffsetV;
-
-        numShadowMaps = this.highIndex;
-        if (numShadowMaps)
+        var texelSize = (1.0 / this.atlasSize);
+        pixelOffsetV[1] = pixelOffsetH[0] = texelSize;
+        var blurRect = this.blurRect;
+
+        var atlasTexture = this.atlasTexture;
+        var atlasRenderTarget = this.atlasRenderTarget;
+        var blurTexture = this.blurTexture;
+        var blurRenderTarget = this.blurRenderTarget;
+        var x, y, size;
+
+        // The quad covers the whole atlas, the scissor limits it to each map
+        for (; n < numShadowMaps; n += 1)
         {
-            shadowMaps = this.shadowMapsHigh;
-            shadowMapBlurTexture = this.blurTextureHigh;
-            shadowMapBlurRenderTarget = this.blurRenderTargetHigh;
-            pixelOffsetV[1] = pixelOffsetH[0] = (1.0 / this.sizeHigh);
-            for (n = 0; n < numShadowMaps; n += 1)
+            shadowMap = shadowMaps[n];
+            if (shadowMap.needsBlur)
             {
-                shadowMap = shadowMaps[n];
-                if (shadowMap.needsBlur)
-                {
-                    // Horizontal
-                    if (!gd.beginRenderTarget(shadowMapBlurRenderTarget))
-                    {
-                        break;
-                    }
-
-                    /* tslint:disable:no-string-literal */
-                    shadowMappingBlurTechnique['shadowMap'] = shadowMap.texture;
-                    shadowMappingBlurTechnique['pixelOffset'] = pixelOffsetH;
-                    /* tslint:enable:no-string-literal */
-                    gd.draw(quadPrimitive, 4);
-
-                    gd.endRenderTarget();
+                shadowMap.needsBlur = false;
 
-                    // Vertical
-                    if (!gd.beginRenderTarget(shadowMap.renderTarget))
-                    {
-                        break;
-                    }
+                x = shadowMap.x;
+                y = shadowMap.y;
+                size = shadowMap.size;
 
-                    /* tslint:disable:no-string-literal */
-                    shadowMappingBlurTechnique['shadowMap'] = shadowMapBlurTexture;
-                    shadowMappingBlurTechnique['pixelOffset'] = pixelOffsetV;
-                    /* tslint:enable:no-string-literal */
-                    gd.draw(quadPrimitive, 4);
+                blurRect[0] = ((x + 0.5) * texelSize);
+                blurRect[1] = ((y + 0.5) * texelSize);
+                blurRect[2] = ((x + size - 0.5) * texelSize);
+                blurRect[3] = ((y + size - 0.5) * texelSize);
 
-                    gd.endRenderTarget();
+                // Horizontal
+                if (!gd.beginRenderTarget(blurRenderTarget))
+                {
+                    break;
                 }
-            }
-        }
 
-        numShadowMaps = this.lowIndex;
-        if (numShadowMaps)
-        {
-            shadowMaps = this.shadowMapsLow;
-            shadowMapBlurTexture = this.blurTextureLow;
-            shadowMapBlurRenderTarget = this.blurRenderTargetLow;
-            pixelOffsetV[1] = pixelOffsetH[0] = (1.0 / this.sizeLow);
-            for (n = 0; n < numShadowMaps; n += 1)
-            {
-                shadowMap = shadowMaps[n];
-                if (shadowMap.needsBlur)
-                {
-                    // Horizontal
-                    if (!gd.beginRenderTarget(shadowMapBlurRenderTarget))
-                    {
-                        break;
-                    }
+                gd.setScissor(x, y, size, size);
 
-                    /* tslint:disable:no-string-literal */
-                    shadowMappingBlurTechnique['shadowMap'] = shadowMap.texture;
-                    shadowMappingBlurTechnique['pixelOffset'] = pixelOffsetH;
-                    /* tslint:enable:no-string-literal */
-                    gd.draw(quadPrimitive, 4);
+                /* tslint:disable:no-string-literal */
+                shadowMappingBlurTechnique['shadowMap'] = atlasTexture;
+                shadowMappingBlurTechnique['pixelOffset'] = pixelOffsetH;
+                shadowMappingBlurTechnique['blurRect'] = blurRect;
+                /* tslint:enable:no-string-literal */
+                gd.draw(quadPrimitive, 4);
 
-                    gd.endRenderTarget();
+                gd.endRenderTarget();
 
-                    // Vertical
-                    if (!gd.beginRenderTarget(shadowMap.renderTarget))
-                    {
-                        break;
-                    }
+                // Vertical
+                if (!gd.beginRenderTarget(atlasRenderTarget))
+                {
+                    break;
+                }
 
-                    /* tslint:disable:no-string-literal */
-                    shadowMappingBlurTechnique['shadowMap'] = shadowMapBlurTexture;
-                    shadowMappingBlurTechnique['pixelOffset'] = pixelOffsetV;
-                    /* tslint:enable:no-string-literal */
-                    gd.draw(quadPrimitive, 4);
+                gd.setScissor(x, y, size, size);
 
-                    gd.endRenderTarget();
-                }
+                /* tslint:disable:no-string-literal */
+                shadowMappingBlurTechnique['shadowMap'] = blurTexture;
+                shadowMappingBlurTechnique['pixelOffset'] = pixelOffsetV;
+                shadowMappingBlurTechnique['blurRect'] = blurRect;
+                /* tslint:enable:no-string-literal */
+                gd.draw(quadPrimitive, 4);
+
+                gd.endRenderTarget();
             }
         }
     }
@@ -1338,8 +1507,8 @@ class ShadowMapping
             delete this.quadVertexBuffer;
         }
 
-        delete this.shadowMapsLow;
-        delete this.shadowMapsHigh;
+        delete this.shadowMaps;
+        delete this.freeBlocks;
         delete this.techniqueParameters;
         delete this.occludersExtents;
         delete this.md;
@@ -1382,14 +1551,15 @@ class ShadowMapping
 
         shadowMapping.pixelOffsetH = [0, 0];
         shadowMapping.pixelOffsetV = [0, 0];
+        shadowMapping.blurRect = [0, 0, 0, 0];
 
         shadowMapping.bufferWidth = 0;
         shadowMapping.bufferHeight = 0;
 
         shadowMapping.techniqueParameters = gd.createTechniqueParameters();
         shadowMapping.shader = null;
-        shadowMapping.shadowMapsLow = [];
-        shadowMapping.shadowMapsHigh = [];
+        shadowMapping.shadowMaps = [];
+        shadowMapping.freeBlocks = [];
 
         if (disableBlur)
         {
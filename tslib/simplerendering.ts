@@ -34,6 +34,8 @@ class SimpleRendering
     wireframe                 : boolean;
     wireframeInfo             : any; // TODO
 
+    instancedTechnique        : Technique;
+
     simplePrepare             : { (geometryInstance: GeometryInstance): void; };
     simpleUpdate              : { (camera: Camera): void; };
     simpleSkinnedUpdate       : { (camera: Camera): void; };
@@ -133,6 +135,7 @@ class SimpleRendering
         /* tslint:disable:no-string-literal */
         this.globalTechniqueParameters['time'] = currentTime;
         /* tslint:enable:no-string-literal */
+        this.globalTechniqueParameters.version += 1;
         this.camera = camera;
         this.scene = scene;
     }
@@ -207,6 +210,7 @@ class SimpleRendering
     {
         /* tslint:disable:no-string-literal */
         this.globalTechniqueParameters['lightColor'] = color;
+        this.globalTechniqueParameters.version += 1;
         /* tslint:enable:no-string-literal */
     }
 
@@ -214,6 +218,7 @@ class SimpleRendering
     {
         /* tslint:disable:no-string-literal */
         this.globalTechniqueParameters['ambientColor'] = color;
+        this.globalTechniqueParameters.version += 1;
         /* tslint:enable:no-string-literal */
     }
 
@@ -221,6 +226,7 @@ class SimpleRendering
     {
         /* tslint:disable:no-string-literal */
         this.globalTechniqueParameters['diffuse'] = tex;
+        this.globalTechniqueParameters.version += 1;
         /* tslint:enable:no-string-literal */
     }
 
@@ -237,6 +243,12 @@ class SimpleRendering
 
     destroy()
     {
+        if (this.instancedTechnique)
+        {
+            TurbulenzEngine.getGraphicsDevice().setTechniqueInstancing(this.instancedTechnique, null);
+            delete this.instancedTechnique;
+        }
+
         delete this.globalTechniqueParameters;
         delete this.lightPosition;
         delete this.eyePosition;
@@ -314,13 +326,34 @@ class SimpleRendering
             ambientColor : md.v3Build(0.2, 0.2, 0.3),
             time : 0.0
         });
+        // Versioned, update and the setters increment it after writing the values
+        dr.globalTechniqueParameters.version = 1;
 
         dr.passes = [[], [], []];
+        dr.instancedTechnique = null;
 
         var onShaderLoaded = function onShaderLoadedFn(shader)
         {
             var skinBones = shader.getParameter("skinBones");
             dr.defaultSkinBufferSize = skinBones.rows * skinBones.columns;
+
+            // Rigid blinn geometries that only differ in their node are drawn
+            // as a single instanced draw when the hardware supports it
+            var technique = shader.getTechnique("blinn");
+            var instancedTechnique = shader.getTechnique("blinn_instanced");
+            if (technique && instancedTechnique && gd.isSupported("INSTANCED_ARRAYS"))
+            {
+                var instancing = {
+                    technique: instancedTechnique,
+                    parameters: ["worldViewProjection", "lightPosition", "eyePosition"],
+                    semantics: gd.createSemantics(["TEXCOORD2", "TEXCOORD3", "TEXCOORD4",
+                                                   "TEXCOORD5", "TEXCOORD6", "TEXCOORD7"])
+                };
+                if (gd.setTechniqueInstancing(technique, instancing))
+                {
+                    dr.instancedTechnique = technique;
+                }
+            }
         };
 
         var simpleCGFX = 'shaders/simplerendering.cgfx';
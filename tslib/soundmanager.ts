@@ -16,7 +16,7 @@ interface SoundManagerOnSoundLoadedFn { (sound: Sound): void; };
 */
 class SoundManager
 {
-    static version = 1;
+    static version = 2;
 
     // TSC prevets us from writing:
     //
@@ -27,7 +27,8 @@ class SoundManager
     // forces us to give an implementation.
 
     load                : { (path: string, uncompress?: boolean,
-                             onSoundLoaded? : SoundManagerOnSoundLoadedFn)
+                             onSoundLoaded? : SoundManagerOnSoundLoadedFn,
+                             stream?: boolean)
                             : void; };
     loadArchive         : { (path: string,
                              uncompress?: boolean,
@@ -157,10 +158,11 @@ class SoundManager
            @param {string} path Path to the sound file
            @param {boolean} uncompress Uncompress the sound for faster playback
            @param {function()} onSoundLoaded function called once the sound has loaded
+           @param {boolean} stream Decode the sound in chunks while playing instead of all at once
 
            @return {Sound} object, returns the default sound if the file at given path is not yet loaded
         */
-        var loadSound = function loadSoundFn(path, uncompress?, onSoundLoaded?)
+        var loadSound = function loadSoundFn(path, uncompress?, onSoundLoaded?, stream?)
         {
             var sound = sounds[path];
             if (!sound)
@@ -198,6 +200,7 @@ class SoundManager
                         var sound = sd.createSound({
                             src : url,
                             uncompress : uncompress,
+                            stream : stream,
                             onload : onload
                         });
                         if (!sound)
@@ -407,10 +410,10 @@ class SoundManager
 
         if (log)
         {
-            sm.load = function loadSoundLogFn(path, uncompress?)
+            sm.load = function loadSoundLogFn(path, uncompress?, onSoundLoaded?, stream?)
             {
                 log.innerHTML += "SoundManager.load:&nbsp;'" + path + "'";
-                return loadSound(path, uncompress);
+                return loadSound(path, uncompress, onSoundLoaded, stream);
             };
 
             sm.loadArchive = function loadArchiveLogFn(path, uncompress?)
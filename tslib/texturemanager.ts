@@ -3,6 +3,7 @@
 /*global Reference: false*/
 /*global Observer: false*/
 /*global TurbulenzEngine: false*/
+/*global Trace: false*/
 
 "use strict";
 
@@ -14,6 +15,7 @@ class TextureInstance
     texture                : Texture;
     reference              : Reference;
     textureChangedObserver : Observer;
+    usage                  : number; // largest size in pixels on screen reported since the last update
 
     //
     // setTexture
@@ -35,6 +37,17 @@ class TextureInstance
         return this.texture;
     }
 
+    //
+    // reportUsage
+    //
+    reportUsage(pixels: number)
+    {
+        if (this.usage < pixels)
+        {
+            this.usage = pixels;
+        }
+    }
+
     //
     // subscribeTextureChanged
     //
@@ -77,6 +90,7 @@ class TextureInstance
         textureInstance.name = name;
         textureInstance.texture = texture;
         textureInstance.reference = Reference.create(textureInstance);
+        textureInstance.usage = 0;
 
         return textureInstance;
     }
@@ -93,6 +107,36 @@ interface TextureManagerArchive
     textures: { [path: string]: Texture; };
 }
 
+// DDS texture with a full mip chain streamed a range of levels at a time
+interface TextureManagerStreamedTexture
+{
+    path          : string;
+    src           : string;
+    instance      : TextureInstance;
+    header        : Uint8Array; // copy of the DDS file header
+    width         : number;
+    height        : number;
+    numLevels     : number;
+    levelOffsets  : number[];   // file offset of each level and of the end of the data
+    tailLevel     : number;     // first level not larger than streamingMinSize
+    level         : number;     // top level resident on the GPU, numLevels if none
+    targetLevel   : number;     // level being requested, same as level if none
+    desiredLevel  : number;
+    lastSeenFrame : number;
+    index         : number;
+    data          : Uint8Array; // data of the resident levels, null if none
+    failures      : number;     // consecutive failed requests
+    retryTime     : number;     // no level is requested before this time
+}
+
+interface TextureManagerStreamingMetrics
+{
+    residentBytes         : number; // bytes of the streamed levels resident on the GPU
+    numStreamedTextures   : number;
+    numPendingRequests    : number;
+    numDroppedLevels      : number;
+};
+
 /**
   @class  Texture manager
   @private
@@ -118,6 +162,16 @@ class TextureManager
     pathRemapping: { [path: string]: string; };
     pathPrefix: string;
 
+    // Mip level streaming, enabled with setStreamingBudget
+    maxBytes: number;
+    streamingMinSize: number;
+    maxStreamingRequests: number;
+    maxStreamingRetries: number;
+    streamedTextures: { [path: string]: TextureManagerStreamedTexture; };
+    streamedTextureList: TextureManagerStreamedTexture[];
+    streamingFrame: number;
+    metrics: TextureManagerStreamingMetrics;
+
     graphicsDevice: GraphicsDevice;
     requestHandler: RequestHandler;
     defaultTexture: Texture;
@@ -231,6 +285,13 @@ class TextureManager
                     this.loadingTexture[path] = true;
                     this.numLoadingTextures += 1;
 
+                    var traceId = (typeof Trace !== "undefined" ? Trace.newId() : 0);
+                    if (traceId)
+                    {
+                        Trace.beginAsync(path, traceId, "texture");
+                        Trace.counter("Loading textures", this.numLoadingTextures, "texture");
+                    }
+
                     var mipmaps = true;
                     if (nomipmaps)
                     {
@@ -257,26 +318,25 @@ class TextureManager
                         //Missing textures are left with the previous, usually default, texture.
                         delete that.loadingTexture[path];
                         that.numLoadingTextures -= 1;
-                    };
 
-                    var textureRequest = function textureRequestFn(url, onload /*, callContext */)
-                    {
-                        var texture = that.graphicsDevice.createTexture({
-                            src     : url,
-                            mipmaps : mipmaps,
-                            onload  : onload
-                        });
-                        if (!texture)
+                        if (traceId)
                         {
-                            that.errorCallback("Texture '" + url + "' not created.");
+                            Trace.endAsync(path, traceId, "texture", { status: status });
+                            Trace.counter("Loading textures", that.numLoadingTextures, "texture");
                         }
                     };
 
-                    this.requestHandler.request({
-                        src: ((this.pathRemapping && this.pathRemapping[path]) || (this.pathPrefix + path)),
-                        requestFn: textureRequest,
-                        onload: textureLoaded
-                    });
+                    var src = ((this.pathRemapping && this.pathRemapping[path]) || (this.pathPrefix + path));
+                    if (this.maxBytes && mipmaps &&
+                        src.slice(-4).toLowerCase() === '.dds' &&
+                        this.graphicsDevice.isSupported("FILEFORMAT_DDS"))
+                    {
+                        this.loadStreamed(path, src, textureLoaded);
+                    }
+                    else
+                    {
+                        this.requestTexture(src, mipmaps, textureLoaded);
+                    }
                 }
                 else
                 {
@@ -310,6 +370,745 @@ class TextureManager
         }
     }
 
+    //
+    // requestTexture
+    //
+    requestTexture(src: string, mipmaps: boolean, onload)
+    {
+        var that = this;
+        var textureRequest = function textureRequestFn(url, onload, callContext)
+        {
+            var texture = that.graphicsDevice.createTexture({
+                src     : url,
+                mipmaps : mipmaps,
+                onload  : onload,
+                data    : callContext.data
+            });
+            if (!texture)
+            {
+                that.errorCallback("Texture '" + url + "' not created.");
+            }
+        };
+
+        this.requestHandler.request({
+            src: src,
+            requestFn: textureRequest,
+            persistent: true,
+            onload: onload
+        });
+    }
+
+    /**
+      Enables the streaming of the mip levels of DDS textures loaded from then
+      on. Only the levels not larger than minSize are loaded first, higher
+      levels are requested by update for the textures on screen and the top
+      levels of the least recently seen textures are dropped to keep the
+      streamed levels within maxBytes. Setting maxBytes to 0 disables the
+      streaming of new textures.
+
+      @memberOf TextureManager.prototype
+      @public
+      @function
+      @name setStreamingBudget
+
+      @param {number} maxBytes Maximum size of the streamed levels
+      @param {number} minSize Largest size of the levels loaded first
+    */
+    setStreamingBudget(maxBytes: number, minSize?: number)
+    {
+        this.maxBytes = maxBytes;
+        if (minSize)
+        {
+            this.streamingMinSize = minSize;
+        }
+    }
+
+    /**
+      Updates the streamed levels from the usage reported to the texture
+      instances since the last update, usually called once per frame after
+      the renderer update.
+
+      @memberOf TextureManager.prototype
+      @public
+      @function
+      @name update
+    */
+    update()
+    {
+        var list = this.streamedTextureList;
+        var numStreamed = list.length;
+        if (!numStreamed)
+        {
+            return;
+        }
+
+        this.streamingFrame += 1;
+        var frame = this.streamingFrame;
+
+        var n, streamed, level;
+        var committedBytes = 0;
+        for (n = 0; n < numStreamed; n += 1)
+        {
+            streamed = list[n];
+            var instance = streamed.instance;
+            var usage = instance.usage;
+            if (usage > 0)
+            {
+                instance.usage = 0;
+                streamed.lastSeenFrame = frame;
+                streamed.desiredLevel = TextureManager.levelForSize(streamed, usage);
+            }
+            committedBytes += TextureManager.levelBytes(streamed, streamed.targetLevel);
+        }
+
+        var maxBytes = this.maxBytes;
+        if (!maxBytes)
+        {
+            maxBytes = Number.MAX_VALUE;
+        }
+
+        // Drop the top levels of the least recently seen textures first
+        if (committedBytes > maxBytes)
+        {
+            var unseen = [];
+            for (n = 0; n < numStreamed; n += 1)
+            {
+                streamed = list[n];
+                if (streamed.lastSeenFrame !== frame &&
+                    streamed.targetLevel === streamed.level &&
+                    streamed.level < streamed.tailLevel)
+                {
+                    unseen.push(streamed);
+                }
+            }
+            unseen.sort(function compareLastSeenFn(a, b)
+                        {
+                            return (a.lastSeenFrame - b.lastSeenFrame);
+                        });
+
+            var numUnseen = unseen.length;
+            for (n = 0; n < numUnseen && committedBytes > maxBytes; n += 1)
+            {
+                streamed = unseen[n];
+                level = streamed.level;
+                do
+                {
+                    level += 1;
+                    committedBytes -= (TextureManager.levelBytes(streamed, level - 1) -
+                                       TextureManager.levelBytes(streamed, level));
+                }
+                while (committedBytes > maxBytes && level < streamed.tailLevel);
+
+                this.metrics.numDroppedLevels += (level - streamed.level);
+                this.requestLevels(streamed, level, this.requestHandler.priorityHigh);
+            }
+        }
+
+        // Request the levels of the largest textures on screen first
+        if (this.metrics.numPendingRequests < this.maxStreamingRequests)
+        {
+            var time = TurbulenzEngine.time;
+            var visible = [];
+            for (n = 0; n < numStreamed; n += 1)
+            {
+                streamed = list[n];
+                if (streamed.lastSeenFrame === frame &&
+                    streamed.desiredLevel < streamed.level &&
+                    streamed.targetLevel === streamed.level &&
+                    streamed.retryTime <= time)
+                {
+                    visible.push(streamed);
+                }
+            }
+            visible.sort(function compareDesiredLevelFn(a, b)
+                         {
+                             return (a.desiredLevel - b.desiredLevel);
+                         });
+
+            var numVisible = visible.length;
+            for (n = 0; n < numVisible; n += 1)
+            {
+                if (this.metrics.numPendingRequests >= this.maxStreamingRequests)
+                {
+                    break;
+                }
+
+                streamed = visible[n];
+                var currentBytes = TextureManager.levelBytes(streamed, streamed.level);
+                level = streamed.desiredLevel;
+                while (level < streamed.level &&
+                       (committedBytes + TextureManager.levelBytes(streamed, level) - currentBytes) > maxBytes)
+                {
+                    level += 1;
+                }
+                if (level < streamed.level)
+                {
+                    committedBytes += (TextureManager.levelBytes(streamed, level) - currentBytes);
+                    this.requestLevels(streamed, level, this.requestHandler.priorityLow);
+                }
+            }
+        }
+    }
+
+    /**
+      Get the number of bytes of a streamed texture resident on the GPU
+
+      @memberOf TextureManager.prototype
+      @public
+      @function
+      @name getResidentBytes
+
+      @param {string} path Path of the texture
+
+      @return {number} 0 if the texture is not streamed
+    */
+    getResidentBytes(path): number
+    {
+        var streamed = this.streamedTextures[path];
+        if (streamed)
+        {
+            return TextureManager.levelBytes(streamed, streamed.level);
+        }
+        return 0;
+    }
+
+    /**
+      Get the number of bytes a loaded texture uses on the GPU, exact for
+      streamed textures and estimated from the pixel format otherwise
+
+      @memberOf TextureManager.prototype
+      @public
+      @function
+      @name getTextureBytes
+
+      @param {string} path Path of the texture
+
+      @return {number} 0 if the texture is not loaded
+    */
+    getTextureBytes(path): number
+    {
+        var streamed = this.streamedTextures[path];
+        if (streamed)
+        {
+            return TextureManager.levelBytes(streamed, streamed.level);
+        }
+
+        var textureInstance = this.textureInstances[path];
+        var texture = (textureInstance ? textureInstance.texture : null);
+        if (!texture || texture === this.defaultTexture)
+        {
+            return 0;
+        }
+
+        var gd = this.graphicsDevice;
+        var format = texture.format;
+        var bytesPerPixel;
+        if (format === gd.PIXELFORMAT_DXT1)
+        {
+            bytesPerPixel = 0.5;
+        }
+        else if (format === gd.PIXELFORMAT_DXT3 ||
+                 format === gd.PIXELFORMAT_DXT5 ||
+                 format === gd.PIXELFORMAT_A8 ||
+                 format === gd.PIXELFORMAT_L8 ||
+                 format === gd.PIXELFORMAT_S8)
+        {
+            bytesPerPixel = 1;
+        }
+        else if (format === gd.PIXELFORMAT_L8A8 ||
+                 format === gd.PIXELFORMAT_R5G6B5 ||
+                 format === gd.PIXELFORMAT_R5G5B5A1 ||
+                 format === gd.PIXELFORMAT_R4G4B4A4 ||
+                 format === gd.PIXELFORMAT_D16)
+        {
+            bytesPerPixel = 2;
+        }
+        else if (format === gd.PIXELFORMAT_R8G8B8)
+        {
+            bytesPerPixel = 3;
+        }
+        else if (format === gd.PIXELFORMAT_RGB16F)
+        {
+            bytesPerPixel = 6;
+        }
+        else if (format === gd.PIXELFORMAT_RGBA16F)
+        {
+            bytesPerPixel = 8;
+        }
+        else if (format === gd.PIXELFORMAT_RGB32F)
+        {
+            bytesPerPixel = 12;
+        }
+        else if (format === gd.PIXELFORMAT_RGBA32F)
+        {
+            bytesPerPixel = 16;
+        }
+        else
+        {
+            bytesPerPixel = 4;
+        }
+
+        var bytes = (texture.width * texture.height * (texture.depth || 1) * bytesPerPixel);
+        if (texture.mipmaps)
+        {
+            bytes = Math.floor(bytes * 4 / 3);
+        }
+        if (texture.cubemap)
+        {
+            bytes *= 6;
+        }
+        return bytes;
+    }
+
+    //
+    // loadStreamed
+    //
+    loadStreamed(path: string, src: string, onload)
+    {
+        var that = this;
+        var requestHandler = this.requestHandler;
+        requestHandler.request({
+            src: src,
+            requestFn: TextureManager.requestRange,
+            userData: {
+                start: 0,
+                end: 127
+            },
+            priority: requestHandler.priorityHigh,
+            onload: function headerLoadedFn(bytes, status)
+            {
+                if (!that.textureInstances)
+                {
+                    return;
+                }
+
+                if (!bytes || (status !== 200 && status !== 206))
+                {
+                    onload(null, status);
+                    return;
+                }
+
+                // Textures that can not be streamed are loaded whole
+                var streamed = that.parseHeader(path, src, bytes);
+                if (!streamed)
+                {
+                    that.requestTexture(src, true, onload);
+                    return;
+                }
+
+                // The whole file is returned if the server ignores the range
+                var fileData = (status === 200 && bytes.length > 128 ? bytes : null);
+                that.addStreamed(streamed);
+                that.requestLevels(streamed, streamed.tailLevel, requestHandler.priorityHigh, fileData, onload);
+            }
+        });
+    }
+
+    //
+    // parseHeader
+    //
+    parseHeader(path: string, src: string, bytes: Uint8Array): TextureManagerStreamedTexture
+    {
+        function readUInt32(offset)
+        {
+            return (bytes[offset] +
+                    (bytes[offset + 1] * 256) +
+                    (bytes[offset + 2] * 65536) +
+                    (bytes[offset + 3] * 16777216));
+        }
+
+        // 'DDS ' signature
+        if (bytes.length < 128 ||
+            bytes[0] !== 68 || bytes[1] !== 68 || bytes[2] !== 83 || bytes[3] !== 32)
+        {
+            return null;
+        }
+
+        var flags = readUInt32(8);
+        var height = readUInt32(12);
+        var width = readUInt32(16);
+        var numLevels = readUInt32(28);
+        var pixelFormatFlags = readUInt32(80);
+        var fourCC = readUInt32(84);
+        var rgbBitCount = readUInt32(88);
+        var caps2 = readUInt32(112);
+
+        /* tslint:disable:no-bitwise */
+        var DDSF_MIPMAPCOUNT = 0x00020000;
+        var DDSF_FOURCC = 0x00000004;
+        var DDSF_CUBEMAP = 0x00000200;
+        var DDSF_VOLUME = 0x00200000;
+
+        // Only 2D textures with a full mip chain are streamed
+        var fullLevels = (1 + Math.floor(Math.log(Math.max(width, height)) / Math.LN2));
+        if (!(flags & DDSF_MIPMAPCOUNT) ||
+            numLevels !== fullLevels ||
+            (caps2 & (DDSF_CUBEMAP | DDSF_VOLUME)))
+        {
+            return null;
+        }
+
+        var blockSize = 0;
+        var pixelSize = 0;
+        if (pixelFormatFlags & DDSF_FOURCC)
+        {
+            var fourCCString = String.fromCharCode(bytes[84], bytes[85], bytes[86], bytes[87]);
+            if (fourCCString === 'DXT1')
+            {
+                blockSize = 8;
+            }
+            else if (fourCCString === 'DXT2' || fourCCString === 'DXT3' ||
+                     fourCCString === 'DXT4' || fourCCString === 'DXT5' ||
+                     fourCCString === 'RXGB')
+            {
+                blockSize = 16;
+            }
+            else
+            {
+                // D3DFORMAT codes
+                var pixelSizes: { [fourCC: number]: number; } = {
+                    20: 3, 21: 4, 23: 2, 28: 1, 32: 4, 50: 1, 51: 2
+                };
+                pixelSize = (pixelSizes[fourCC] || 0);
+            }
+        }
+        else if (rgbBitCount === 8 || rgbBitCount === 16 ||
+                 rgbBitCount === 24 || rgbBitCount === 32)
+        {
+            pixelSize = (rgbBitCount / 8);
+        }
+        /* tslint:enable:no-bitwise */
+
+        if (!blockSize && !pixelSize)
+        {
+            return null;
+        }
+
+        var minSize = this.streamingMinSize;
+        var levelOffsets = [];
+        var tailLevel = -1;
+        var offset = 0;
+        var w = width;
+        var h = height;
+        var level;
+        for (level = 0; level < numLevels; level += 1)
+        {
+            levelOffsets[level] = offset;
+            if (tailLevel < 0 && w <= minSize && h <= minSize)
+            {
+                tailLevel = level;
+            }
+            if (blockSize)
+            {
+                offset += (Math.floor((w + 3) / 4) * Math.floor((h + 3) / 4) * blockSize);
+            }
+            else
+            {
+                offset += (w * h * pixelSize);
+            }
+            w = (w > 1 ? Math.floor(w / 2) : 1);
+            h = (h > 1 ? Math.floor(h / 2) : 1);
+        }
+        levelOffsets[numLevels] = offset;
+
+        return {
+            path: path,
+            src: src,
+            instance: this.textureInstances[path],
+            header: new Uint8Array(bytes.subarray(0, 128)),
+            width: width,
+            height: height,
+            numLevels: numLevels,
+            levelOffsets: levelOffsets,
+            tailLevel: tailLevel,
+            level: numLevels,
+            targetLevel: numLevels,
+            desiredLevel: tailLevel,
+            lastSeenFrame: this.streamingFrame,
+            index: -1,
+            data: null,
+            failures: 0,
+            retryTime: 0
+        };
+    }
+
+    //
+    // addStreamed
+    //
+    addStreamed(streamed: TextureManagerStreamedTexture)
+    {
+        var list = this.streamedTextureList;
+        streamed.index = list.length;
+        list.push(streamed);
+        this.streamedTextures[streamed.path] = streamed;
+        this.metrics.numStreamedTextures += 1;
+    }
+
+    //
+    // removeStreamed
+    //
+    removeStreamed(path: string)
+    {
+        var streamed = this.streamedTextures[path];
+        if (streamed)
+        {
+            var list = this.streamedTextureList;
+            var last = list.pop();
+            if (last !== streamed)
+            {
+                list[streamed.index] = last;
+                last.index = streamed.index;
+            }
+            streamed.index = -1;
+            streamed.data = null;
+            delete this.streamedTextures[path];
+
+            var metrics = this.metrics;
+            metrics.numStreamedTextures -= 1;
+            metrics.residentBytes -= TextureManager.levelBytes(streamed, streamed.level);
+        }
+    }
+
+    //
+    // requestLevels
+    //
+    // Creates the texture from the given level to the smallest one,
+    // replacing the texture of the instance once loaded. The data of the
+    // resident levels is kept so only the missing top levels are requested,
+    // and dropping levels needs no request at all.
+    requestLevels(streamed: TextureManagerStreamedTexture,
+                  level: number,
+                  priority: number,
+                  fileData?: Uint8Array,
+                  onload?)
+    {
+        var that = this;
+        var metrics = this.metrics;
+        var levelOffsets = streamed.levelOffsets;
+        var start = (128 + levelOffsets[level]);
+        var end = (128 + levelOffsets[streamed.numLevels]);
+
+        // Range actually requested, the rest comes from the resident data
+        var residentData = streamed.data;
+        var requestEnd = end;
+        if (residentData)
+        {
+            requestEnd = (128 + levelOffsets[streamed.level]);
+            if (requestEnd <= start)
+            {
+                residentData = residentData.subarray(start - requestEnd);
+                requestEnd = start;
+            }
+        }
+
+        streamed.targetLevel = level;
+        metrics.numPendingRequests += 1;
+
+        // Failed requests are retried with an exponential backoff, the
+        // first load gives up after maxStreamingRetries, later ones are
+        // only delayed as update will request them again
+        var levelsFailed = function levelsFailedFn(status)
+        {
+            streamed.targetLevel = streamed.level;
+            streamed.failures += 1;
+
+            var requestHandler = that.requestHandler;
+            var retryTime = Math.min((requestHandler.initialRetryTime *
+                                      Math.pow(2, (streamed.failures - 1))),
+                                     requestHandler.maxRetryTime);
+            if (onload)
+            {
+                if (streamed.failures > that.maxStreamingRetries)
+                {
+                    that.removeStreamed(streamed.path);
+                    onload(null, status);
+                    return;
+                }
+
+                streamed.targetLevel = level;
+                metrics.numPendingRequests += 1;
+                TurbulenzEngine.setTimeout(function retryLevelsFn()
+                                           {
+                                               metrics.numPendingRequests -= 1;
+                                               if (streamed.index >= 0 && that.textureInstances)
+                                               {
+                                                   that.requestLevels(streamed, level, priority, null, onload);
+                                               }
+                                           }, retryTime);
+            }
+            else
+            {
+                streamed.retryTime = (TurbulenzEngine.time + (retryTime * 0.001));
+            }
+        };
+
+        var levelsLoaded = function levelsLoadedFn(bytes, status)
+        {
+            metrics.numPendingRequests -= 1;
+            if (streamed.index < 0 || !that.textureInstances)
+            {
+                return;
+            }
+
+            if (bytes && status === 200 && bytes.length >= end)
+            {
+                bytes = bytes.subarray(start, requestEnd);
+            }
+            if (!bytes || (status !== 200 && status !== 206) || bytes.length !== (requestEnd - start))
+            {
+                levelsFailed(status);
+                return;
+            }
+
+            var levelsData;
+            if (requestEnd === end)
+            {
+                levelsData = (bytes.byteLength === bytes.buffer.byteLength ? bytes : new Uint8Array(bytes));
+            }
+            else
+            {
+                levelsData = new Uint8Array(end - start);
+                levelsData.set(bytes, 0);
+                levelsData.set(residentData, bytes.length);
+            }
+            bytes = null;
+
+            // DDS file of the requested levels
+            var ddsData = new Uint8Array(128 + levelsData.length);
+            ddsData.set(streamed.header, 0);
+            TextureManager.writeUInt32(ddsData, 12, Math.max(1, Math.floor(streamed.height / Math.pow(2, level))));
+            TextureManager.writeUInt32(ddsData, 16, Math.max(1, Math.floor(streamed.width / Math.pow(2, level))));
+            TextureManager.writeUInt32(ddsData, 28, (streamed.numLevels - level));
+            ddsData.set(levelsData, 128);
+
+            var texture = that.graphicsDevice.createTexture({
+                src     : streamed.src,
+                name    : streamed.path,
+                data    : ddsData,
+                mipmaps : true,
+                onload  : function levelsCreatedFn(newTexture)
+                {
+                    if (!newTexture)
+                    {
+                        levelsFailed(0);
+                        return;
+                    }
+                    if (streamed.index < 0 || !that.textureInstances)
+                    {
+                        newTexture.destroy();
+                        return;
+                    }
+
+                    metrics.residentBytes += (TextureManager.levelBytes(streamed, level) -
+                                              TextureManager.levelBytes(streamed, streamed.level));
+                    streamed.level = level;
+                    streamed.targetLevel = level;
+                    streamed.data = levelsData;
+                    streamed.failures = 0;
+                    streamed.retryTime = 0;
+
+                    if (onload)
+                    {
+                        onload(newTexture, 200);
+                    }
+                    else
+                    {
+                        var oldTexture = streamed.instance.getTexture();
+                        streamed.instance.setTexture(newTexture);
+                        if (oldTexture && oldTexture !== that.defaultTexture)
+                        {
+                            oldTexture.destroy();
+                        }
+                    }
+                }
+            });
+            if (!texture)
+            {
+                that.errorCallback("Texture '" + streamed.src + "' not created.");
+                levelsFailed(0);
+            }
+        };
+
+        if (fileData)
+        {
+            levelsLoaded(fileData, 200);
+        }
+        else if (requestEnd === start)
+        {
+            levelsLoaded(new Uint8Array(0), 206);
+        }
+        else
+        {
+            this.requestHandler.request({
+                src: streamed.src,
+                requestFn: TextureManager.requestRange,
+                userData: {
+                    start: start,
+                    end: (requestEnd - 1)
+                },
+                priority: priority,
+                onload: levelsLoaded
+            });
+        }
+    }
+
+    // Bytes of the levels from the given one to the smallest
+    static levelBytes(streamed: TextureManagerStreamedTexture, level: number): number
+    {
+        var levelOffsets = streamed.levelOffsets;
+        var numLevels = streamed.numLevels;
+        return (levelOffsets[numLevels] - levelOffsets[(level < numLevels ? level : numLevels)]);
+    }
+
+    // Top level with at least the given size in pixels
+    static levelForSize(streamed: TextureManagerStreamedTexture, pixels: number): number
+    {
+        var size = Math.max(streamed.width, streamed.height);
+        var tailLevel = streamed.tailLevel;
+        var level = 0;
+        while (level < tailLevel && (size * 0.5) >= pixels)
+        {
+            size *= 0.5;
+            level += 1;
+        }
+        return level;
+    }
+
+    static writeUInt32(bytes: Uint8Array, offset: number, value: number)
+    {
+        bytes[offset] = (value % 256);
+        bytes[offset + 1] = (Math.floor(value / 256) % 256);
+        bytes[offset + 2] = (Math.floor(value / 65536) % 256);
+        bytes[offset + 3] = (Math.floor(value / 16777216) % 256);
+    }
+
+    // Request function for the RequestHandler returning a byte range of
+    // the file, the whole file is returned with status 200 if the server
+    // does not support ranges
+    static requestRange(src: string, onload, callContext)
+    {
+        var userData = callContext.userData;
+        var xhr = new XMLHttpRequest();
+        xhr.onreadystatechange = function ()
+        {
+            if (xhr.readyState === 4)
+            {
+                if (!TurbulenzEngine.isUnloading())
+                {
+                    var status = xhr.status;
+                    var response = xhr.response;
+                    onload((response ? new Uint8Array(response) : null), status);
+                }
+                xhr.onreadystatechange = null;
+                xhr = null;
+            }
+        };
+        xhr.open("GET", src, true);
+        xhr.responseType = "arraybuffer";
+        xhr.setRequestHeader("Range", "bytes=" + userData.start + "-" + userData.end);
+        xhr.send(null);
+    }
+
     /**
       Alias one texture to another name
 
@@ -353,6 +1152,7 @@ class TextureManager
             {
                 this.textureInstances[path].reference.unsubscribeDestroyed(this.onTextureInstanceDestroyed);
                 delete this.textureInstances[path];
+                this.removeStreamed(path);
             }
         }
     }
@@ -694,6 +1494,8 @@ class TextureManager
         this.internalTexture = null;
         this.pathRemapping = null;
         this.pathPrefix = null;
+        this.streamedTextures = null;
+        this.streamedTextureList = null;
         this.requestHandler = null;
         this.graphicsDevice = null;
     }
@@ -762,6 +1564,20 @@ class TextureManager
         textureManager.pathRemapping = null;
         textureManager.pathPrefix = "";
 
+        textureManager.maxBytes = 0;
+        textureManager.streamingMinSize = 64;
+        textureManager.maxStreamingRequests = 4;
+        textureManager.maxStreamingRetries = 4;
+        textureManager.streamedTextures = {};
+        textureManager.streamedTextureList = [];
+        textureManager.streamingFrame = 0;
+        textureManager.metrics = {
+            residentBytes: 0,
+            numStreamedTextures: 0,
+            numPendingRequests: 0,
+            numDroppedLevels: 0
+        };
+
         textureManager.graphicsDevice = graphicsDevice;
         textureManager.requestHandler = requestHandler;
         textureManager.defaultTexture = defaultTexture;
@@ -775,6 +1591,7 @@ class TextureManager
         {
             textureInstance.reference.unsubscribeDestroyed(onTextureInstanceDestroyed);
             delete textureManager.textureInstances[textureInstance.name];
+            textureManager.removeStreamed(textureInstance.name);
         };
         textureManager.onTextureInstanceDestroyed = onTextureInstanceDestroyed;
 
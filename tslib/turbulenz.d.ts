@@ -343,6 +343,8 @@ interface Technique
 
     numParameters: number;
     device: GraphicsDevice;
+
+    isReady(): boolean;
 }
 
 interface ShaderParameter
@@ -411,6 +413,7 @@ interface Shader
 interface TechniqueParameters
 {
     [paramName: string]: any;
+    version?: number;
 }
 
 interface TechniqueParameterBufferParameters
@@ -430,6 +433,7 @@ interface TechniqueParameterBuffer extends Float32Array
     numFloats: number;
     dynamic: boolean;
     data: number[];
+    version: number;
 
     map(offset?: number, numValues?: number): ParameterWriteIterator;
     unmap(writer: ParameterWriteIterator): void;
@@ -625,6 +629,7 @@ interface DrawParameters
     firstIndex      : number;
     sortKey         : number;
     userData        : any;
+    instanceCount   : number;
     [idx: number]   : any; // TODO
 
     // Methods
@@ -638,6 +643,16 @@ interface DrawParameters
     getVertexBuffer(index: number): VertexBuffer;
     getSemantics(index: number): Semantics;
     getOffset(index: number): number;
+    setStreamPerInstance(index: number, perInstance: boolean): void;
+    getStreamPerInstance(index: number): boolean;
+}
+
+interface TechniqueInstancingParameters
+{
+    technique     : Technique;
+    parameters    : string[];
+    semantics     : Semantics;
+    minInstances? : number;
 }
 
 interface OcclusionQuery
@@ -691,6 +706,8 @@ interface GraphicsDeviceMetrics
     indexBufferChanges: number;
     vertexArrayObjectChanges: number;
     techniqueParametersChanges: number;
+    techniqueParametersSkipped: number;
+    techniqueParameterBuffersSkipped: number;
     techniqueChanges: number;
     drawCalls: number;
     primitives: number;
@@ -824,6 +841,8 @@ interface GraphicsDevice
 
     metrics?: GraphicsDeviceMetrics;
 
+    shaderLinkTime: number;
+
     // Methods
 
     createVertexBuffer(params: VertexBufferParameters): VertexBuffer;
@@ -848,6 +867,8 @@ interface GraphicsDevice
     beginFrame(): boolean;
     endFrame(): void;
 
+    updateShaderPrograms(maxTime: number): number;
+
     beginRenderTarget(renderTarget: RenderTarget): boolean;
     endRenderTarget(): void;
 
@@ -863,15 +884,20 @@ interface GraphicsDevice
     setViewport(x: number, y: number, width: number, height: number): void;
     setScissor(x: number, y: number, width: number, height: number): void;
     setStream(vertexBuffer: VertexBuffer, semantics: Semantics, offset?: number): void;
+    setInstanceStream(vertexBuffer: VertexBuffer, semantics: Semantics, offset?: number): void;
     setTechnique(technique: Technique);
     setTechniqueParameters(techniqueParameters: TechniqueParameters): void;
     setIndexBuffer(indexBuffer: IndexBuffer): void;
 
     drawIndexed(primitive: number, numIndices: number, first?: number): void;
     draw(primitive: number, numVertices: number, first?: number): void;
+    drawIndexedInstanced(primitive: number, numIndices: number, numInstances: number, first?: number): void;
+    drawInstanced(primitive: number, numVertices: number, numInstances: number, first?: number): void;
     drawArray(drawParametersArray: DrawParameters[],
               globalTechniqueParametersArray: TechniqueParameters[],
               sortMode?: number): void;
+    setTechniqueInstancing(technique: Technique,
+                           instancing: TechniqueInstancingParameters): boolean;
 
     beginDraw(primitive: number, numVertices: number, formats: any[],
               semantics: Semantics): VertexWriteIterator;
@@ -1098,6 +1124,7 @@ interface SoundParameters
 {
     src?        : string;
     uncompress? : boolean;
+    stream?     : boolean;
 
     name?       : string;
     data?       : any; // number[];
@@ -1309,6 +1336,10 @@ interface SoundDeviceParameters
     listenerTransform? : any; // m43
     listenerVelocity?  : any; // v3
     listenerGain?      : number;
+
+    maxDecodedBytes?     : number;
+    streamChunkDuration? : number; // seconds
+    streamNumBuffers?    : number;
 }
 
 interface SoundDevice
@@ -1466,7 +1497,7 @@ interface TurbulenzEngine
     setInterval(f: { (): void; }, t: number): any;
     clearInterval(i: any);
 
-    request(url: string, callback: TurbulenzRequestCallback): void;
+    request(url: string, callback: TurbulenzRequestCallback, binary?: boolean): void;
 
     base64Encode(bytes: any): string;
 
@@ -824,3 +824,233 @@ JSProfiling.sort = function JSProfilingSortFn(array, propertyName, descending)
         array.sort(sorterDescending);
     }
 };
+
+//
+// Trace
+//
+// Records the spans of the load pipeline as Chrome trace events, the JSON
+// from getJSON can be opened in chrome://tracing. Every call returns straight
+// away while tracing is disabled, callers that build arguments for the
+// events check Trace.enabled first.
+//
+interface TraceEvent
+{
+    name  : string;
+    cat   : string;
+    ph    : string; // B/E span, b/e async span, s/f flow, i instant, C counter, M metadata
+    ts    : number; // microseconds
+    pid   : number;
+    tid   : number;
+    id?   : number;
+    bp?   : string;
+    args? : any;
+};
+
+interface TraceData
+{
+    traceEvents     : TraceEvent[];
+    displayTimeUnit : string;
+    otherData       : any;
+};
+
+class Trace
+{
+    /* tslint:disable:no-unused-variable */
+    static version = 1;
+    /* tslint:enable:no-unused-variable */
+
+    static enabled = false;
+    static maxEvents = 1000000;
+    static numDroppedEvents = 0;
+    static events: TraceEvent[] = [];
+    static lastId = 0;
+
+    //
+    // start
+    //
+    // Starts recording, keeping the events already recorded
+    static start(maxEvents?: number): void
+    {
+        if (maxEvents)
+        {
+            this.maxEvents = maxEvents;
+        }
+        this.enabled = true;
+    }
+
+    //
+    // stop
+    //
+    static stop(): void
+    {
+        this.enabled = false;
+    }
+
+    //
+    // clear
+    //
+    static clear(): void
+    {
+        this.events = [];
+        this.numDroppedEvents = 0;
+    }
+
+    //
+    // newId
+    //
+    // Returns an id to match the begin and end of async spans and flows,
+    // 0 while disabled so it can be kept to check if the end is needed
+    static newId(): number
+    {
+        if (!this.enabled)
+        {
+            return 0;
+        }
+        this.lastId += 1;
+        return this.lastId;
+    }
+
+    //
+    // begin / end
+    //
+    // Span on the main thread, the ends must be in reverse order of the begins
+    static begin(name: string, category?: string, args?: any): void
+    {
+        if (this.enabled)
+        {
+            this._add('B', name, category, 0, args);
+        }
+    }
+
+    static end(name: string, category?: string, args?: any): void
+    {
+        if (this.enabled)
+        {
+            this._add('E', name, category, 0, args);
+        }
+    }
+
+    //
+    // beginAsync / endAsync
+    //
+    // Span that may overlap others, like a request or a decode on a worker,
+    // async spans with the same id are nested
+    static beginAsync(name: string, id: number, category?: string, args?: any): void
+    {
+        if (this.enabled && id)
+        {
+            this._add('b', name, category, id, args);
+        }
+    }
+
+    static endAsync(name: string, id: number, category?: string, args?: any): void
+    {
+        if (id && this.enabled)
+        {
+            this._add('e', name, category, id, args);
+        }
+    }
+
+    //
+    // flowStart / flowEnd
+    //
+    // Arrow from the span open when it starts to the span open when it ends,
+    // for example from the code making a request to the code handling it
+    static flowStart(name: string, id: number, category?: string): void
+    {
+        if (this.enabled && id)
+        {
+            this._add('s', name, category, id, null);
+        }
+    }
+
+    static flowEnd(name: string, id: number, category?: string): void
+    {
+        if (id && this.enabled)
+        {
+            var event = this._add('f', name, category, id, null);
+            if (event)
+            {
+                event.bp = 'e';
+            }
+        }
+    }
+
+    //
+    // instant
+    //
+    static instant(name: string, category?: string, args?: any): void
+    {
+        if (this.enabled)
+        {
+            this._add('i', name, category, 0, args);
+        }
+    }
+
+    //
+    // counter
+    //
+    static counter(name: string, value: number, category?: string): void
+    {
+        if (this.enabled)
+        {
+            this._add('C', name, category, 0, { value: value });
+        }
+    }
+
+    static _add(ph: string, name: string, category: string, id: number, args: any): TraceEvent
+    {
+        var events = this.events;
+        if (events.length >= this.maxEvents)
+        {
+            this.numDroppedEvents += 1;
+            return null;
+        }
+
+        var event: TraceEvent = {
+            name: name,
+            cat: (category || 'load'),
+            ph: ph,
+            ts: (TurbulenzEngine.getTime() * 1000),
+            pid: 1,
+            tid: 1
+        };
+        if (id)
+        {
+            event.id = id;
+        }
+        if (args)
+        {
+            event.args = args;
+        }
+        events.push(event);
+        return event;
+    }
+
+    //
+    // getTraceData
+    //
+    // Returns the recorded events in the Chrome trace event JSON object format
+    static getTraceData(): TraceData
+    {
+        var metadata: TraceEvent[] = [
+            { name: 'process_name', cat: '', ph: 'M', ts: 0, pid: 1, tid: 1, args: { name: 'Turbulenz' } },
+            { name: 'thread_name', cat: '', ph: 'M', ts: 0, pid: 1, tid: 1, args: { name: 'Main' } }
+        ];
+        return {
+            traceEvents: metadata.concat(this.events),
+            displayTimeUnit: 'ms',
+            otherData: {
+                numDroppedEvents: this.numDroppedEvents
+            }
+        };
+    }
+
+    //
+    // getJSON
+    //
+    static getJSON(): string
+    {
+        return JSON.stringify(this.getTraceData());
+    }
+}
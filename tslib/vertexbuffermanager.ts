@@ -30,6 +30,188 @@ interface VertexBufferAllocation
     poolIndex: number;
 };
 
+//
+// VertexBufferRing
+//
+// Streams the vertices of geometry rebuilt every frame, like sprites or debug
+// lines. The dynamic vertex buffer is split in numFrames regions and ranges
+// are allocated from the current region until it is full or nextFrame is
+// called, so a range is only written again after the other regions have been
+// used, instead of every frame rewriting a buffer the GPU may still be
+// reading. Vertices are written to a CPU copy and everything allocated since
+// the last flush is uploaded with a single setData.
+//
+class VertexBufferRing
+{
+    static version = 1;
+
+    vertexBuffer: VertexBuffer;
+    stride: number;         // Number of values per vertex
+    numVertices: number;    // Vertices per region
+    numFrames: number;
+    data: Float32Array;     // CPU copy of the whole vertex buffer
+    numUploads: number;
+
+    private regionIndex: number;
+    private head: number;       // Next vertex to allocate
+    private uploaded: number;   // First vertex not uploaded yet
+
+    //
+    // allocate
+    //
+    // Returns the index on vertexBuffer of the first vertex allocated, the
+    // values are written to data starting at (index * stride)
+    allocate(numVertices: number): number
+    {
+        if (numVertices > this.numVertices)
+        {
+            return -1;
+        }
+
+        var head = this.head;
+        if ((head + numVertices) > ((this.regionIndex + 1) * this.numVertices))
+        {
+            this.nextFrame();
+            head = this.head;
+        }
+        this.head = (head + numVertices);
+        return head;
+    }
+
+    //
+    // write
+    //
+    // Allocates numVertices and copies them from data, starting at the given
+    // vertex offset
+    write(data: any, numVertices: number, offset?: number): number
+    {
+        var index = this.allocate(numVertices);
+        if (index !== -1)
+        {
+            var stride = this.stride;
+            var start = (offset ? (offset * stride) : 0);
+            var numValues = (numVertices * stride);
+            var ringData = this.data;
+            var dst = (index * stride);
+            if (data.subarray)
+            {
+                if (start === 0 && numValues === data.length)
+                {
+                    ringData.set(data, dst);
+                }
+                else
+                {
+                    ringData.set(data.subarray(start, (start + numValues)), dst);
+                }
+            }
+            else
+            {
+                var n;
+                for (n = 0; n < numValues; n += 1)
+                {
+                    ringData[dst + n] = data[start + n];
+                }
+            }
+        }
+        return index;
+    }
+
+    //
+    // flush
+    //
+    // Uploads the vertices allocated since the last flush, must be called
+    // before drawing them
+    flush()
+    {
+        var uploaded = this.uploaded;
+        var head = this.head;
+        if (uploaded < head)
+        {
+            var stride = this.stride;
+            this.vertexBuffer.setData(this.data.subarray((uploaded * stride), (head * stride)),
+                                      uploaded,
+                                      (head - uploaded));
+            this.uploaded = head;
+            this.numUploads += 1;
+        }
+    }
+
+    //
+    // nextFrame
+    //
+    // Moves on to the next region, vertices allocated before remain valid
+    // until the ring comes back to their region. Called once per frame by
+    // the users of the ring, it does nothing if the current region is still
+    // empty so extra calls do not shorten the life of the other regions.
+    nextFrame()
+    {
+        this.flush();
+
+        var numVertices = this.numVertices;
+        if (this.head === (this.regionIndex * numVertices))
+        {
+            return;
+        }
+
+        var regionIndex = (this.regionIndex + 1);
+        if (regionIndex >= this.numFrames)
+        {
+            regionIndex = 0;
+        }
+        this.regionIndex = regionIndex;
+        this.head = this.uploaded = (regionIndex * numVertices);
+    }
+
+    //
+    // destroy
+    //
+    destroy()
+    {
+        if (this.vertexBuffer)
+        {
+            this.vertexBuffer.destroy();
+            this.vertexBuffer = null;
+        }
+        this.data = null;
+    }
+
+    //
+    // create
+    //
+    static create(graphicsDevice: GraphicsDevice,
+                  numVertices: number,
+                  attributes: any[],
+                  numFrames?: number) : VertexBufferRing
+    {
+        numFrames = (numFrames || 3);
+
+        var vertexBuffer = graphicsDevice.createVertexBuffer({
+            numVertices: (numVertices * numFrames),
+            attributes: attributes,
+            dynamic: true
+        });
+
+        debug.assert(vertexBuffer, "VertexBuffer not created.");
+
+        if (!vertexBuffer)
+        {
+            return null;
+        }
+
+        var ring = new VertexBufferRing();
+        ring.vertexBuffer = vertexBuffer;
+        ring.stride = vertexBuffer.stride;
+        ring.numVertices = numVertices;
+        ring.numFrames = numFrames;
+        ring.data = new Float32Array(numVertices * numFrames * vertexBuffer.stride);
+        ring.numUploads = 0;
+        ring.regionIndex = 0;
+        ring.head = 0;
+        ring.uploaded = 0;
+        return ring;
+    }
+}
+
 //
 // VertexBufferManager
 //
@@ -42,6 +224,7 @@ class VertexBufferManager
     numBuckets = 10;
 
     vertexBuffersPools: VertexBuffersPool[];  //Array keyed-off attribute
+    vertexBufferRings: VertexBufferRing[];
     debugCreatedVertexBuffers: number;
     graphicsDevice: GraphicsDevice;
     dynamicVertexBuffers: boolean;
@@ -426,11 +609,68 @@ class VertexBufferManager
         }
     }
 
+    //
+    // createRing
+    //
+    // For dynamic geometry written every frame, see VertexBufferRing
+    createRing(numVertices: number, attributes: any[], numFrames?: number) : VertexBufferRing
+    {
+        var ring = VertexBufferRing.create(this.graphicsDevice, numVertices, attributes, numFrames);
+        if (ring)
+        {
+            this.vertexBufferRings.push(ring);
+            this.debugCreatedVertexBuffers += 1;
+        }
+        return ring;
+    }
+
+    //
+    // destroyRing
+    //
+    destroyRing(ring: VertexBufferRing)
+    {
+        var vertexBufferRings = this.vertexBufferRings;
+        var index = vertexBufferRings.indexOf(ring);
+        if (index !== -1)
+        {
+            vertexBufferRings.splice(index, 1);
+        }
+        ring.destroy();
+    }
+
+    //
+    // nextFrame
+    //
+    // Moves all the rings created by the manager to their next region
+    nextFrame()
+    {
+        var vertexBufferRings = this.vertexBufferRings;
+        var numRings = vertexBufferRings.length;
+        var n;
+        for (n = 0; n < numRings; n += 1)
+        {
+            vertexBufferRings[n].nextFrame();
+        }
+    }
+
     //
     // destroy
     //
     destroy()
     {
+        var vertexBufferRings = this.vertexBufferRings;
+        if (vertexBufferRings)
+        {
+            var numRings = vertexBufferRings.length;
+            var n;
+            for (n = 0; n < numRings; n += 1)
+            {
+                vertexBufferRings[n].destroy();
+            }
+            vertexBufferRings.length = 0;
+            this.vertexBufferRings = null;
+        }
+
         var vertexBuffersPools = this.vertexBuffersPools;
         if (vertexBuffersPools)
         {
@@ -479,6 +719,7 @@ class VertexBufferManager
         var manager = new VertexBufferManager();
 
         manager.vertexBuffersPools = [];    //Array keyed-off attribute
+        manager.vertexBufferRings = [];
         manager.debugCreatedVertexBuffers = 0;
         manager.graphicsDevice = graphicsDevice;
         manager.dynamicVertexBuffers = dynamicVertexBuffers ? true : false;
@@ -6011,11 +6011,13 @@ var _tz_techniqueParameterBufferCreate =
                 return techniqueParameterBufferWriter;
             };
 
-            /* tslint:disable:no-empty */
             this.unmap = function techniqueParameterBufferUnmap(writer)
             {
+                if (this.version)
+                {
+                    this.version += 1;
+                }
             };
-            /* tslint:enable:no-empty */
 
             this.setData =
                 function techniqueParameterBufferSetData(data,
@@ -6034,6 +6036,21 @@ var _tz_techniqueParameterBufferCreate =
                 {
                     this[offset] = data[n];
                 }
+                if (this.version)
+                {
+                    this.version += 1;
+                }
+            };
+
+            // Writes done with the typed array set method count as well
+            var float32ArraySet = Float32Array.prototype.set;
+            this.set = function techniqueParameterBufferSet(array, offset?: number)
+            {
+                float32ArraySet.call(this, array, (offset || 0));
+                if (this.version)
+                {
+                    this.version += 1;
+                }
             };
 
             Object.defineProperty(this, "data", {
@@ -6041,6 +6058,10 @@ var _tz_techniqueParameterBufferCreate =
                 {
                     return this;
                 },
+                set: function techniqueParameterBufferDataSet(data)
+                {
+                    this.setData(data, 0, Math.min(data.length, this.length));
+                },
                 enumerable: true
             });
 
@@ -6058,6 +6079,11 @@ var _tz_techniqueParameterBufferCreate =
 
     var tpb = new Float32Array(params.numFloats);
     (<any>tpb).__proto__ = tpbProto;
+    // Zero means the values may change at any time, writes by index included.
+    // Once set to a number other than zero every write through setData, set,
+    // unmap or data increments it so the graphics device can skip uploading
+    // unchanged buffers, writes by index must then increment it themselves
+    (<any>tpb).version = 0;
     return <TechniqueParameterBuffer><any>(tpb);
 };
 
@@ -4,6 +4,7 @@
 /*global Uint8Array*/
 /*global Uint16Array*/
 /*global window*/
+/*global Trace*/
 
 "use strict";
 
@@ -30,6 +31,7 @@ class DDSLoader
     onload                  : any;
     onerror                 : any;
     src                     : any;
+    traceId                 : number; // async trace span of the decode
 
     width                   : number;
     height                  : number;
@@ -510,6 +512,12 @@ class DDSLoader
             {
                 var loader = workerQueue.shift();
 
+                if (loader.traceId)
+                {
+                    Trace.endAsync("DDS decode", loader.traceId, "texture");
+                    loader.traceId = 0;
+                }
+
                 worker['load'] -= ((((loader.width + 3) * (loader.height + 3)) >> 4) * loader.numLevels * loader.numFaces);
 
                 var data = event.data;
@@ -534,6 +542,13 @@ class DDSLoader
 
     static decodeInWorker(command: number, data: ArrayBufferView, loader: DDSLoader): void
     {
+        if (typeof Trace !== "undefined" && Trace.enabled)
+        {
+            loader.traceId = Trace.newId();
+            Trace.beginAsync("DDS decode", loader.traceId, "texture",
+                             { src: loader.src, width: loader.width, height: loader.height });
+        }
+
         var maxNumWorkers = this.maxNumWorkers;
         if (maxNumWorkers)
         {
@@ -657,6 +672,16 @@ class DDSLoader
         };
         if (decoder)
         {
+            if (loader.traceId)
+            {
+                var decodeFn = decoder;
+                decoder = function tracedDecoderFn()
+                {
+                    decodeFn();
+                    Trace.endAsync("DDS decode", loader.traceId, "texture");
+                    loader.traceId = 0;
+                };
+            }
             TurbulenzEngine.setTimeout(decoder, 0);
         }
         else
@@ -1991,7 +2016,18 @@ class DDSLoader
                             }
 
                             loader.externalBuffer = false;
+                            var tracing = (typeof Trace !== "undefined" && Trace.enabled);
+                            if (tracing)
+                            {
+                                Trace.begin("DDSLoader.processBytes", "texture", { src: src });
+                            }
+
                             loader.processBytes(new Uint8Array(buffer), xhrStatus);
+
+                            if (tracing)
+                            {
+                                Trace.end("DDSLoader.processBytes", "texture");
+                            }
                         }
                         else
                         {
@@ -2025,7 +2061,18 @@ class DDSLoader
         else
         {
             loader.externalBuffer = true;
+            var tracing = (typeof Trace !== "undefined" && Trace.enabled);
+            if (tracing)
+            {
+                Trace.begin("DDSLoader.processBytes", "texture");
+            }
+
             loader.processBytes(<any[]>(params.data), 0);
+
+            if (tracing)
+            {
+                Trace.end("DDSLoader.processBytes", "texture");
+            }
         }
 
         return loader;
@@ -16,6 +16,7 @@
 /*global DataView*/
 /*global window*/
 /*global debug*/
+/*global Trace*/
 
 "use strict";
 
@@ -182,8 +183,20 @@ class TZWebGLTexture implements Texture
         gl.texParameteri(target, gl.TEXTURE_WRAP_S, gl.CLAMP_TO_EDGE);
         gl.texParameteri(target, gl.TEXTURE_WRAP_T, gl.CLAMP_TO_EDGE);
 
+        // Trace comes from utilities.js, which may not be loaded
+        var tracing = (typeof Trace !== "undefined" && Trace.enabled);
+        if (tracing)
+        {
+            Trace.begin("Texture upload", "texture", { name: this.name, width: this.width, height: this.height });
+        }
+
         this.updateData(data);
 
+        if (tracing)
+        {
+            Trace.end("Texture upload", "texture");
+        }
+
         gd._temporaryBindTexture(target, null);
 
         return true;
@@ -3672,18 +3685,28 @@ interface WebGLProgramParameter
     location: WebGLUniformLocation;
     textureUnit: number;
     dirty?: number;
+    program: WebGLShaderProgram;
+    owner: any;               // TechniqueParameters that last set the value
+    uploadedBuffer: any;      // TechniqueParameterBuffer that last set the value
+    uploadedVersion: number;  // and its version at the time
 };
 
 class WebGLShaderProgram
 {
+    name : string;
     glProgram : WebGLProgram;
     semanticsMask : number;
     parameters : { [name: string]: WebGLProgramParameter };
     parametersArray : WebGLProgramParameter[];
     numTextureUnits : number;
     _initialized: boolean;
+    _linkRequested: boolean;
+    _ready: boolean;
+    _programs: { [name: string]: WebGLShader };
+    _programNames: string[];
 
     constructor(gd: WebGLGraphicsDevice,
+                name: string,
                 programs: { [name: string]: WebGLShader },
                 parameters: { [name: string]: WebGLShaderParameter },
                 programNames: string[],
@@ -3730,8 +3753,6 @@ class WebGLShaderProgram
             }
         }
 
-        gl.linkProgram(glProgram);
-
         // Set parameters
         var numTextureUnits = 0;
         var programParameters: { [name: string]: WebGLProgramParameter } = {};
@@ -3749,7 +3770,11 @@ class WebGLShaderProgram
                 info : paramInfo,
                 location: null,
                 values: null,
-                textureUnit: -1
+                textureUnit: -1,
+                program: this,
+                owner: null,
+                uploadedBuffer: null,
+                uploadedVersion: -1
             };
 
             if (paramInfo)
@@ -3785,12 +3810,54 @@ class WebGLShaderProgram
             programParametersArray[n] = parameter;
         }
 
+        this.name = name;
         this.glProgram = glProgram;
         this.semanticsMask = semanticsMask;
         this.parameters = programParameters;
         this.parametersArray = programParametersArray;
         this.numTextureUnits = numTextureUnits;
         this._initialized = false;
+        this._linkRequested = false;
+        this._ready = false;
+        this._programs = programs;
+        this._programNames = programNames;
+
+        // With parallel compilation the driver links in the background and
+        // completion is polled by isReady, otherwise links are queued and
+        // done in time slices by updateShaderPrograms
+        if (gd._parallelShaderCompileExtension)
+        {
+            this.link(gd);
+        }
+        else
+        {
+            gd._pendingPrograms.push(this);
+        }
+    }
+
+    link(gd: WebGLGraphicsDevice): void
+    {
+        if (!this._linkRequested)
+        {
+            this._linkRequested = true;
+            gd._gl.linkProgram(this.glProgram);
+        }
+    }
+
+    // Does not block, true once the program has been linked
+    isReady(gd: WebGLGraphicsDevice): boolean
+    {
+        if (!this._ready && this._linkRequested)
+        {
+            var parallelShaderCompileExtension = gd._parallelShaderCompileExtension;
+            if (!parallelShaderCompileExtension ||
+                gd._gl.getProgramParameter(this.glProgram,
+                                           parallelShaderCompileExtension.COMPLETION_STATUS_KHR))
+            {
+                this._ready = true;
+            }
+        }
+        return this._ready;
     }
 
     initialize(gd: WebGLGraphicsDevice): void
@@ -3804,6 +3871,37 @@ class WebGLShaderProgram
 
         var glProgram = this.glProgram;
 
+        // Used before it was linked in the background, link it now
+        this.link(gd);
+
+        // Check compiled and linked programs as late as possible
+        var linked = gl.getProgramParameter(glProgram, gl.LINK_STATUS);
+        if (!linked)
+        {
+            var programs = this._programs;
+            var programNames = this._programNames;
+            var numPrograms = programNames.length;
+            var n;
+            for (n = 0; n < numPrograms; n += 1)
+            {
+                var compiledProgram = programs[programNames[n]];
+                if (compiledProgram &&
+                    !gl.getShaderParameter(compiledProgram, gl.COMPILE_STATUS))
+                {
+                    var compilerInfo = gl.getShaderInfoLog(compiledProgram);
+                    (<WebGLTurbulenzEngine><any>TurbulenzEngine).callOnError(
+                        'Program "' + programNames[n] + '" failed to compile: ' + compilerInfo);
+                }
+            }
+
+            var linkerInfo = gl.getProgramInfoLog(glProgram);
+            (<WebGLTurbulenzEngine><any>TurbulenzEngine)
+                .callOnError(
+                    'Program "' + this.name + '" failed to link: ' +
+                        linkerInfo);
+        }
+        this._ready = true;
+
         gd.setProgram(glProgram);
 
         var parameters = this.parameters;
@@ -3973,6 +4071,7 @@ class WebGLPass implements Pass
         if (linkedProgram === undefined)
         {
             linkedProgram = new WebGLShaderProgram(gd,
+                                                   compoundProgramName,
                                                    shader._programs,
                                                    shader._parameters,
                                                    programNames,
@@ -4074,6 +4173,8 @@ class WebGLPass implements Pass
                 var paramInfo = parameter.info;
                 if (paramInfo)
                 {
+                    gd._releaseParameter(parameter);
+
                     var parameterValues = paramInfo.values;
 
                     var numColumns;
@@ -4237,7 +4338,6 @@ class WebGLTechnique implements Technique
 
         if (!this.initialized)
         {
-            this.shader.initialize(gd);
             this.initialize(gd);
         }
 
@@ -4252,6 +4352,29 @@ class WebGLTechnique implements Technique
         this.device = null;
     }
 
+    // Does not block, true once the programs of every pass have been linked
+    // so the technique can be used without waiting for the driver
+    isReady(): boolean
+    {
+        if (this.initialized)
+        {
+            return true;
+        }
+
+        var gd = this.shader._gd;
+        var passes = this.passes;
+        var numPasses = passes.length;
+        var n;
+        for (n = 0; n < numPasses; n += 1)
+        {
+            if (!passes[n]._linkedProgram.isReady(gd))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
     checkProperties(gd)
     {
         // Check for parameters set directly into the technique...
@@ -4275,7 +4398,7 @@ class WebGLTechnique implements Technique
             var passes = this.passes;
             if (passes.length === 1)
             {
-                gd._setParameters(passes[0].parameters, fakeTechniqueParameters);
+                gd._setParameters(passes[0]._linkedProgram, fakeTechniqueParameters);
             }
             else
             {
@@ -4368,6 +4491,7 @@ class WebGLTechnique implements Technique
                     {
                         if (this.device)
                         {
+                            this.device._releaseParameter(parameter);
                             this.device._setUniform1f(parameter, parameterValues);
                         }
                         else
@@ -4380,6 +4504,7 @@ class WebGLTechnique implements Technique
                 {
                     if (this.device)
                     {
+                        this.device._releaseParameter(parameter);
                         this.device._setUniform1fv(parameter.location, parameter.values, parameterValues);
                     }
                     else
@@ -4392,6 +4517,7 @@ class WebGLTechnique implements Technique
                 {
                     if (this.device)
                     {
+                        this.device._releaseParameter(parameter);
                         this.device._setUniform2fv(parameter.location, parameter.values, parameterValues);
                     }
                     else
@@ -4404,6 +4530,7 @@ class WebGLTechnique implements Technique
                 {
                     if (this.device)
                     {
+                        this.device._releaseParameter(parameter);
                         this.device._setUniform3fv(parameter.location, parameter.values, parameterValues);
                     }
                     else
@@ -4416,6 +4543,7 @@ class WebGLTechnique implements Technique
                 {
                     if (this.device)
                     {
+                        this.device._releaseParameter(parameter);
                         this.device._setUniform4fv(parameter.location, parameter.values, parameterValues);
                     }
                     else
@@ -4460,6 +4588,7 @@ class WebGLTechnique implements Technique
                     {
                         if (this.device)
                         {
+                            this.device._releaseParameter(parameter);
                             this.device._setUniform1i(parameter, parameterValues);
                         }
                         else
@@ -4472,6 +4601,7 @@ class WebGLTechnique implements Technique
                 {
                     if (this.device)
                     {
+                        this.device._releaseParameter(parameter);
                         this.device._setUniform1iv(parameter.location, parameter.values, parameterValues);
                     }
                     else
@@ -4484,6 +4614,7 @@ class WebGLTechnique implements Technique
                 {
                     if (this.device)
                     {
+                        this.device._releaseParameter(parameter);
                         this.device._setUniform2iv(parameter.location, parameter.values, parameterValues);
                     }
                     else
@@ -4496,6 +4627,7 @@ class WebGLTechnique implements Technique
                 {
                     if (this.device)
                     {
+                        this.device._releaseParameter(parameter);
                         this.device._setUniform3iv(parameter.location, parameter.values, parameterValues);
                     }
                     else
@@ -4508,6 +4640,7 @@ class WebGLTechnique implements Technique
                 {
                     if (this.device)
                     {
+                        this.device._releaseParameter(parameter);
                         this.device._setUniform4iv(parameter.location, parameter.values, parameterValues);
                     }
                     else
@@ -4643,13 +4776,12 @@ class TZWebGLShader implements Shader
     numParameters  : number;
 
     // private
-    private _initialized          : boolean;
     /* private */ _techniques     : { [techniqueName: string]: WebGLTechnique };
     /* private */ _programs       : { [name: string]: WebGLShader };
     /* private */ _parameters     : { [name: string]: WebGLShaderParameter };
     /* private */ _linkedPrograms : { [name: string]: WebGLShaderProgram };
     private _samplers             : { [name: string]: TZWebGLSampler };
-    private _gd                   : WebGLGraphicsDevice;
+    /* private */ _gd             : WebGLGraphicsDevice;
 
     getTechnique(name): Technique
     {
@@ -4708,59 +4840,6 @@ class TZWebGLShader implements Shader
         }
     }
 
-    initialize(gd: WebGLGraphicsDevice): void
-    {
-        if (this._initialized)
-        {
-            return;
-        }
-
-        var gl = gd._gl;
-        var p;
-
-        // Check copmpiled programs as late as possible
-        var shaderPrograms = this._programs;
-        for (p in shaderPrograms)
-        {
-            if (shaderPrograms.hasOwnProperty(p))
-            {
-                var compiledProgram = shaderPrograms[p];
-                var compiled = gl.getShaderParameter(compiledProgram, gl.COMPILE_STATUS);
-                if (!compiled)
-                {
-                    var compilerInfo = gl.getShaderInfoLog(compiledProgram);
-                    (<WebGLTurbulenzEngine><any>TurbulenzEngine).callOnError(
-                        'Program "' + p + '" failed to compile: ' + compilerInfo);
-                }
-            }
-        }
-
-        // Check linked programs as late as possible
-        var linkedPrograms = this._linkedPrograms;
-        for (p in linkedPrograms)
-        {
-            if (linkedPrograms.hasOwnProperty(p))
-            {
-                var linkedProgram = linkedPrograms[p];
-                var glProgram = linkedProgram.glProgram;
-                if (glProgram)
-                {
-                    var linked = gl.getProgramParameter(glProgram, gl.LINK_STATUS);
-                    if (!linked)
-                    {
-                        var linkerInfo = gl.getProgramInfoLog(glProgram);
-                        (<WebGLTurbulenzEngine><any>TurbulenzEngine)
-                            .callOnError(
-                                'Program "' + p + '" failed to link: ' +
-                                    linkerInfo);
-                    }
-                }
-            }
-        }
-
-        this._initialized = true;
-    }
-
     destroy()
     {
         var gd = this._gd;
@@ -4834,8 +4913,6 @@ class TZWebGLShader implements Shader
 
         var shader = new TZWebGLShader();
 
-        shader._initialized = false;
-
         var techniques = params.techniques;
         var parameters = params.parameters;
         var programs = params.programs;
@@ -5060,8 +5137,32 @@ class WebGLTechniqueParameters implements TechniqueParameters
 {
     [paramName: string]: any;
 
+    // Zero means the values may change at any time, otherwise it must be
+    // incremented after any change so unchanged values are not uploaded again
+    version: number;
+
+    // Programs holding all the values of this version, see _setParameters
+    _uploadedPrograms: WebGLShaderProgram[];
+    _uploadedVersions: number[];
+    _uploadedChecks: boolean[];
+
     constructor(params: any)
     {
+        // Not enumerable so they are never taken for parameters
+        Object.defineProperty(this, "version", {
+            value: 0,
+            writable: true
+        });
+        Object.defineProperty(this, "_uploadedPrograms", {
+            value: []
+        });
+        Object.defineProperty(this, "_uploadedVersions", {
+            value: []
+        });
+        Object.defineProperty(this, "_uploadedChecks", {
+            value: []
+        });
+
         if (params)
         {
             for (var p in params)
@@ -5102,11 +5203,13 @@ class WebGLDrawParameters implements DrawParameters
     firstIndex      : number;
     sortKey         : number;
     userData        : any;
+    instanceCount   : number;
     [idx: number]   : any;
 
     // WebGLDrawParameters (internal)
     /* private */ _technique              : WebGLTechnique;
     /* private */ _endStreams             : number;
+    /* private */ _instanceStreams        : number;
     /* private */ _endTechniqueParameters : number;
     /* private */ _endInstances           : number;
     /* private */ _indexBuffer            : WebGLIndexBuffer;
@@ -5125,6 +5228,8 @@ class WebGLDrawParameters implements DrawParameters
         this.count = 0;
         this.firstIndex = 0;
         this.userData = null;
+        this.instanceCount = 0;
+        this._instanceStreams = 0;
 
         this._indexBuffer = null;
         this._vao = null;
@@ -5172,6 +5277,8 @@ class WebGLDrawParameters implements DrawParameters
         dst.count = this.count;
         dst.firstIndex = this.firstIndex;
         dst.userData = this.userData;
+        dst.instanceCount = this.instanceCount;
+        dst._instanceStreams = this._instanceStreams;
 
         dst._indexBuffer = this._indexBuffer;
         dst._vao = this._vao;
@@ -5317,6 +5424,39 @@ class WebGLDrawParameters implements DrawParameters
         }
     }
 
+    // Per instance streams advance once per instance instead of once per vertex,
+    // they are only used when instanceCount is not zero
+    setStreamPerInstance(indx: number, perInstance: boolean)
+    {
+        debug.assert(indx < 16, "index parameter out of range");
+        if (indx < 16)
+        {
+            /* tslint:disable:no-bitwise */
+            var instanceStreams = this._instanceStreams;
+            if (perInstance)
+            {
+                instanceStreams |= (1 << indx);
+            }
+            else
+            {
+                instanceStreams &= ~(1 << indx);
+            }
+            /* tslint:enable:no-bitwise */
+            if (this._instanceStreams !== instanceStreams)
+            {
+                this._instanceStreams = instanceStreams;
+                this._vao = null;
+            }
+        }
+    }
+
+    getStreamPerInstance(indx: number): boolean
+    {
+        /* tslint:disable:no-bitwise */
+        return (indx < 16 && 0 !== (this._instanceStreams & (1 << indx)));
+        /* tslint:enable:no-bitwise */
+    }
+
     getTechniqueParameters(indx)
     {
         if (indx < 8)
@@ -5459,10 +5599,33 @@ Object.defineProperty(WebGLDrawParameters.prototype, "indexBuffer", {
 interface WebGLVAOItem
 {
     endStreams: number;
+    instanceStreams: number;
     vao: any;
     [idx: number]: any;
 };
 
+//
+// WebGLTechniqueInstancing
+//
+interface WebGLTechniqueInstancing
+{
+    technique: WebGLTechnique;
+    parameters: string[];
+    semantics: WebGLSemantics;
+    minInstances: number;
+};
+
+//
+// WebGLInstanceBatch
+//
+interface WebGLInstanceBatch
+{
+    drawParameters: WebGLDrawParameters;
+    vertexBuffer: WebGLVertexBuffer;
+    data: Float32Array;
+    device: GraphicsDevice;
+};
+
 
 //
 // WebGLGraphicsDevice
@@ -5523,7 +5686,7 @@ interface WebGLGraphicsDeviceState
 
 interface WebGLMetrics extends GraphicsDeviceMetrics
 {
-    addPrimitives: { (primitive: number, count: number) : void; };
+    addPrimitives: { (primitive: number, count: number, numInstances?: number) : void; };
 };
 
 interface WebGLCreationCounters
@@ -5659,6 +5822,9 @@ class WebGLGraphicsDevice implements GraphicsDevice
 
     metrics                                : WebGLMetrics;
 
+    // Milliseconds per frame spent linking queued shader programs
+    shaderLinkTime                         : number;
+
     // These are specific to WebGLGraphicsDevice
 
     /* private */ _gl                            : WebGLRenderingContext;
@@ -5699,6 +5865,25 @@ class WebGLGraphicsDevice implements GraphicsDevice
     /* private */ _standardDerivativesExtension  : boolean;
     private _vertexArrayObjectExtension          : any;
     private _cachedVAOs                          : { [id: number]: WebGLVAOItem[] };
+    /* private */ _instancedArraysExtension      : any;
+    /* private */ _parallelShaderCompileExtension : any;
+    /* private */ _pendingPrograms               : WebGLShaderProgram[];
+    private _instanceAttributeMask               : number;
+    private _techniqueInstancing                 : { [id: number]: WebGLTechniqueInstancing };
+    private _numInstancedTechniques              : number;
+    private _instanceBatches                     : WebGLInstanceBatch[];
+    private _numInstanceBatches                  : number;
+    private _batchedDrawParameters               : WebGLDrawParameters[];
+    private _instanceParameterSizes              : number[];
+    private _sortKeys                            : Float64Array;
+    private _sortKeyWords                        : Uint32Array;
+    private _sortKeysLow                         : Uint32Array;
+    private _sortKeysHigh                        : Uint32Array;
+    private _sortIndices                         : Uint32Array;
+    private _sortIndicesTemp                     : Uint32Array;
+    private _sortHistogram                       : Uint32Array;
+    private _sortHighWord                        : number;
+    private _sortedDrawParameters                : WebGLDrawParameters[];
 
     private _supportedVideoExtensions            : TZWebGLVideoSupportedExtensions;
 
@@ -5837,6 +6022,107 @@ class WebGLGraphicsDevice implements GraphicsDevice
         }
     }
 
+    drawIndexedInstanced(primitive: number, numIndices: number, numInstances: number, first?: number)
+    {
+        debug.assert(this._instancedArraysExtension, "Instancing is not supported");
+
+        var instancedArraysExtension = this._instancedArraysExtension;
+        var indexBuffer = this._activeIndexBuffer;
+
+        var offset;
+        if (first)
+        {
+            offset = (first * indexBuffer._stride);
+        }
+        else
+        {
+            offset = 0;
+        }
+
+        var format = indexBuffer.format;
+
+        var attributeMask = this._attributeMask;
+
+        var activeTechnique = this._activeTechnique;
+        var passes = activeTechnique.passes;
+        var numPasses = passes.length;
+        var mask;
+
+        if (activeTechnique.checkProperties)
+        {
+            activeTechnique.checkProperties(this);
+        }
+
+        for (var p = 0; p < numPasses; p += 1)
+        {
+            var pass = passes[p];
+
+            /* tslint:disable:no-bitwise */
+            mask = (pass.semanticsMask & attributeMask);
+            /* tslint:enable:no-bitwise */
+            if (mask !== this._clientStateMask)
+            {
+                this.enableClientState(mask);
+            }
+
+            if (1 < numPasses)
+            {
+                this.setPass(pass);
+            }
+
+            instancedArraysExtension.drawElementsInstancedANGLE(primitive, numIndices, format, offset, numInstances);
+
+            if (debug)
+            {
+                this.metrics.addPrimitives(primitive, numIndices, numInstances);
+            }
+        }
+    }
+
+    drawInstanced(primitive: number, numVertices: number, numInstances: number, first?: number)
+    {
+        debug.assert(this._instancedArraysExtension, "Instancing is not supported");
+
+        var instancedArraysExtension = this._instancedArraysExtension;
+
+        var attributeMask = this._attributeMask;
+
+        var activeTechnique = this._activeTechnique;
+        var passes = activeTechnique.passes;
+        var numPasses = passes.length;
+        var mask;
+
+        if (activeTechnique.checkProperties)
+        {
+            activeTechnique.checkProperties(this);
+        }
+
+        for (var p = 0; p < numPasses; p += 1)
+        {
+            var pass = passes[p];
+
+            /* tslint:disable:no-bitwise */
+            mask = (pass.semanticsMask & attributeMask);
+            /* tslint:enable:no-bitwise */
+            if (mask !== this._clientStateMask)
+            {
+                this.enableClientState(mask);
+            }
+
+            if (1 < numPasses)
+            {
+                this.setPass(pass);
+            }
+
+            instancedArraysExtension.drawArraysInstancedANGLE(primitive, (first || 0), numVertices, numInstances);
+
+            if (debug)
+            {
+                this.metrics.addPrimitives(primitive, numVertices, numInstances);
+            }
+        }
+    }
+
     setTechniqueParameters()
     {
         var activeTechnique = this._activeTechnique;
@@ -5845,10 +6131,10 @@ class WebGLGraphicsDevice implements GraphicsDevice
         var t;
         if (1 === passes.length)
         {
-            var parameters = passes[0].parameters;
+            var program = passes[0]._linkedProgram;
             for (t = 0; t < numTechniqueParameters; t += 1)
             {
-                this._setParameters(parameters, arguments[t]);
+                this._setParameters(program, arguments[t]);
             }
         }
         else
@@ -6175,122 +6461,205 @@ class WebGLGraphicsDevice implements GraphicsDevice
         }
     }
 
-    _setParameters(parameters: { [name: string]: WebGLProgramParameter },
-                   techniqueParameters: WebGLTechniqueParameters): void
+    // A versioned TechniqueParameters remembers the programs holding all its
+    // values and the version they were uploaded at, and every parameter of a
+    // program remembers the TechniqueParameters that set it last so setting it
+    // from anything else forgets the upload. Textures are bound to units
+    // shared by all the programs so they are always set again.
+    _isUploaded(program: WebGLShaderProgram,
+                techniqueParameters: WebGLTechniqueParameters): boolean
     {
-        for (var p in techniqueParameters)
+        var uploadedPrograms = techniqueParameters._uploadedPrograms;
+        if (uploadedPrograms)
         {
-            var parameter = parameters[p];
-            if (parameter !== undefined)
+            var numUploaded = uploadedPrograms.length;
+            var n;
+            for (n = 0; n < numUploaded; n += 1)
             {
-                var parameterValues = techniqueParameters[p];
-                if (parameterValues !== undefined)
+                if (uploadedPrograms[n] === program)
                 {
-                    var paramInfo = parameter.info;
-                    var numColumns;
-                    if (paramInfo.type === 'float')
-                    {
-                        numColumns = paramInfo.columns;
-                        if (4 === numColumns)
-                        {
-                            this._setUniform4fv(parameter.location, parameter.values, parameterValues);
-                        }
-                        else if (3 === numColumns)
-                        {
-                            this._setUniform3fv(parameter.location, parameter.values, parameterValues);
-                        }
-                        else if (2 === numColumns)
-                        {
-                            this._setUniform2fv(parameter.location, parameter.values, parameterValues);
-                        }
-                        else if (1 === paramInfo.rows)
-                        {
-                            this._setUniform1f(parameter, parameterValues);
-                        }
-                        else //if (1 === numColumns)
-                        {
-                            this._setUniform1fv(parameter.location, parameter.values, parameterValues);
-                        }
-                    }
-                    else if (paramInfo.sampler !== undefined)
-                    {
-                        this._setTexture(parameter.textureUnit, parameterValues, paramInfo.sampler);
-                    }
-                    else
-                    {
-                        numColumns = paramInfo.columns;
-                        if (4 === numColumns)
-                        {
-                            this._setUniform4iv(parameter.location, parameter.values, parameterValues);
-                        }
-                        else if (3 === numColumns)
-                        {
-                            this._setUniform3iv(parameter.location, parameter.values, parameterValues);
-                        }
-                        else if (2 === numColumns)
-                        {
-                            this._setUniform2iv(parameter.location, parameter.values, parameterValues);
-                        }
-                        else if (1 === paramInfo.rows)
-                        {
-                            this._setUniform1i(parameter, parameterValues);
-                        }
-                        else //if (1 === numColumns)
+                    return (techniqueParameters._uploadedVersions[n] === techniqueParameters.version);
+                }
+            }
+        }
+        return false;
+    }
+
+    _recordUploaded(program: WebGLShaderProgram,
+                    techniqueParameters: WebGLTechniqueParameters): void
+    {
+        var uploadedPrograms = techniqueParameters._uploadedPrograms;
+        if (uploadedPrograms)
+        {
+            var index = uploadedPrograms.indexOf(program);
+            if (index === -1)
+            {
+                index = uploadedPrograms.length;
+                uploadedPrograms[index] = program;
+            }
+            techniqueParameters._uploadedVersions[index] = techniqueParameters.version;
+        }
+    }
+
+    _claimParameter(parameter: WebGLProgramParameter,
+                    techniqueParameters: any): void
+    {
+        var owner = parameter.owner;
+        if (owner && owner._uploadedPrograms)
+        {
+            var uploadedPrograms = owner._uploadedPrograms;
+            var index = uploadedPrograms.indexOf(parameter.program);
+            if (index !== -1)
+            {
+                var uploadedVersions = owner._uploadedVersions;
+                var last = (uploadedPrograms.length - 1);
+                uploadedPrograms[index] = uploadedPrograms[last];
+                uploadedVersions[index] = uploadedVersions[last];
+                uploadedPrograms.length = last;
+                uploadedVersions.length = last;
+            }
+        }
+        parameter.owner = techniqueParameters;
+    }
+
+    // Called before setting a parameter directly from a value
+    _releaseParameter(parameter: WebGLProgramParameter): void
+    {
+        if (parameter.owner)
+        {
+            this._claimParameter(parameter, null);
+        }
+        parameter.uploadedBuffer = null;
+    }
+
+    // Versioned TechniqueParameterBuffers are only uploaded again after a write
+    _needsUpload(parameter: WebGLProgramParameter, parameterValues: any): boolean
+    {
+        var version = (parameterValues ? parameterValues.version : undefined);
+        if (!version)
+        {
+            parameter.uploadedBuffer = null;
+        }
+        else if (parameter.uploadedBuffer === parameterValues &&
+                 parameter.uploadedVersion === version)
+        {
+            if (debug)
+            {
+                // Catch writes by index that did not increment the version
+                var values = parameter.values;
+                if (values)
+                {
+                    var numValues = Math.min(values.length, parameterValues.length);
+                    var n;
+                    for (n = 0; n < numValues; n += 1)
+                    {
+                        if (values[n] !== parameterValues[n])
                         {
-                            this._setUniform1iv(parameter.location, parameter.values, parameterValues);
+                            debug.log("TechniqueParameterBuffer modified without incrementing its version");
+                            return true;
                         }
                     }
                 }
-                else
+
+                this.metrics.techniqueParameterBuffersSkipped += 1;
+            }
+            return false;
+        }
+        else
+        {
+            parameter.uploadedBuffer = parameterValues;
+            parameter.uploadedVersion = version;
+        }
+        return true;
+    }
+
+    // Sets the textures of an uploaded TechniqueParameters and checks that its
+    // TechniqueParameterBuffers were not written since
+    _checkUploaded(parameters: { [name: string]: WebGLProgramParameter },
+                   techniqueParameters: WebGLTechniqueParameters): boolean
+    {
+        for (var p in techniqueParameters)
+        {
+            var parameter = parameters[p];
+            if (parameter !== undefined)
+            {
+                var parameterValues = techniqueParameters[p];
+                if (parameterValues !== undefined)
                 {
-                    delete techniqueParameters[p];
+                    var paramInfo = parameter.info;
+                    if (paramInfo.sampler !== undefined)
+                    {
+                        this._setTexture(parameter.textureUnit, parameterValues, paramInfo.sampler);
+                    }
+                    else if (parameterValues.version !== undefined &&
+                             (!parameterValues.version ||
+                              parameter.uploadedBuffer !== parameterValues ||
+                              parameter.uploadedVersion !== parameterValues.version))
+                    {
+                        return false;
+                    }
                 }
             }
         }
+        return true;
     }
 
-    // ONLY USE FOR SINGLE PASS TECHNIQUES ON DRAWARRAY
-    _setParametersArray(parameters: { [name: string]: WebGLProgramParameter },
-                        techniqueParametersArray: any[],
-                        numTechniqueParameters: number): void
+    _setParameters(program: WebGLShaderProgram,
+                   techniqueParameters: WebGLTechniqueParameters): void
     {
-        var n;
-        for (n = 0; n < numTechniqueParameters; n += 2)
+        var parameters = program.parameters;
+        var version = techniqueParameters.version;
+        if (version &&
+            this._isUploaded(program, techniqueParameters) &&
+            this._checkUploaded(parameters, techniqueParameters))
+        {
+            if (debug)
+            {
+                this.metrics.techniqueParametersSkipped += 1;
+            }
+            return;
+        }
+
+        for (var p in techniqueParameters)
         {
-            var p = techniqueParametersArray[n];
             var parameter = parameters[p];
             if (parameter !== undefined)
             {
-                var parameterValues = techniqueParametersArray[n + 1];
-
-                if (parameter.current !== parameterValues)
+                var parameterValues = techniqueParameters[p];
+                if (parameterValues !== undefined)
                 {
-                    parameter.current = parameterValues;
+                    if (parameter.owner !== techniqueParameters)
+                    {
+                        this._claimParameter(parameter, techniqueParameters);
+                    }
 
                     var paramInfo = parameter.info;
                     var numColumns;
                     if (paramInfo.type === 'float')
                     {
-                        numColumns = paramInfo.columns;
-                        if (4 === numColumns)
-                        {
-                            this._setUniform4fv(parameter.location, parameter.values, parameterValues);
-                        }
-                        else if (3 === numColumns)
-                        {
-                            this._setUniform3fv(parameter.location, parameter.values, parameterValues);
-                        }
-                        else if (2 === numColumns)
-                        {
-                            this._setUniform2fv(parameter.location, parameter.values, parameterValues);
-                        }
-                        else if (1 === paramInfo.rows)
+                        if (this._needsUpload(parameter, parameterValues))
                         {
-                            this._setUniform1f(parameter, parameterValues);
-                        }
-                        else //if (1 === numColumns)
-                        {
-                            this._setUniform1fv(parameter.location, parameter.values, parameterValues);
+                            numColumns = paramInfo.columns;
+                            if (4 === numColumns)
+                            {
+                                this._setUniform4fv(parameter.location, parameter.values, parameterValues);
+                            }
+                            else if (3 === numColumns)
+                            {
+                                this._setUniform3fv(parameter.location, parameter.values, parameterValues);
+                            }
+                            else if (2 === numColumns)
+                            {
+                                this._setUniform2fv(parameter.location, parameter.values, parameterValues);
+                            }
+                            else if (1 === paramInfo.rows)
+                            {
+                                this._setUniform1f(parameter, parameterValues);
+                            }
+                            else //if (1 === numColumns)
+                            {
+                                this._setUniform1fv(parameter.location, parameter.values, parameterValues);
+                            }
                         }
                     }
                     else if (paramInfo.sampler !== undefined)
@@ -6322,23 +6691,201 @@ class WebGLGraphicsDevice implements GraphicsDevice
                         }
                     }
                 }
+                else
+                {
+                    delete techniqueParameters[p];
+                }
             }
         }
+
+        if (version)
+        {
+            this._recordUploaded(program, techniqueParameters);
+        }
     }
 
-    _setParametersList(techniqueParameters: WebGLTechniqueParameters,
+    // ONLY USE FOR SINGLE PASS TECHNIQUES ON DRAWARRAY
+    // The values of each TechniqueParameters are consecutive on the array, see
+    // _createTechniqueParametersArray
+    _setParametersArray(program: WebGLShaderProgram,
+                        techniqueParametersArray: any[],
+                        numTechniqueParameters: number): void
+    {
+        var parameters = program.parameters;
+        var n = 0;
+        while (n < numTechniqueParameters)
+        {
+            var techniqueParameters = techniqueParametersArray[n + 2];
+            var end = (n + 3);
+            while (end < numTechniqueParameters &&
+                   techniqueParametersArray[end + 2] === techniqueParameters)
+            {
+                end += 3;
+            }
+
+            var version = techniqueParameters.version;
+            if (version &&
+                this._isUploaded(program, techniqueParameters) &&
+                this._checkUploaded(parameters, techniqueParameters))
+            {
+                if (debug)
+                {
+                    this.metrics.techniqueParametersSkipped += 1;
+                }
+                n = end;
+                continue;
+            }
+
+            for (; n < end; n += 3)
+            {
+                var p = techniqueParametersArray[n];
+                var parameter = parameters[p];
+                if (parameter !== undefined)
+                {
+                    var parameterValues = techniqueParametersArray[n + 1];
+
+                    if (parameter.owner !== techniqueParameters)
+                    {
+                        this._claimParameter(parameter, techniqueParameters);
+                    }
+
+                    if (parameter.current !== parameterValues)
+                    {
+                        parameter.current = parameterValues;
+
+                        var paramInfo = parameter.info;
+                        var numColumns;
+                        if (paramInfo.type === 'float')
+                        {
+                            if (this._needsUpload(parameter, parameterValues))
+                            {
+                                numColumns = paramInfo.columns;
+                                if (4 === numColumns)
+                                {
+                                    this._setUniform4fv(parameter.location, parameter.values, parameterValues);
+                                }
+                                else if (3 === numColumns)
+                                {
+                                    this._setUniform3fv(parameter.location, parameter.values, parameterValues);
+                                }
+                                else if (2 === numColumns)
+                                {
+                                    this._setUniform2fv(parameter.location, parameter.values, parameterValues);
+                                }
+                                else if (1 === paramInfo.rows)
+                                {
+                                    this._setUniform1f(parameter, parameterValues);
+                                }
+                                else //if (1 === numColumns)
+                                {
+                                    this._setUniform1fv(parameter.location, parameter.values, parameterValues);
+                                }
+                            }
+                        }
+                        else if (paramInfo.sampler !== undefined)
+                        {
+                            this._setTexture(parameter.textureUnit, parameterValues, paramInfo.sampler);
+                        }
+                        else
+                        {
+                            numColumns = paramInfo.columns;
+                            if (4 === numColumns)
+                            {
+                                this._setUniform4iv(parameter.location, parameter.values, parameterValues);
+                            }
+                            else if (3 === numColumns)
+                            {
+                                this._setUniform3iv(parameter.location, parameter.values, parameterValues);
+                            }
+                            else if (2 === numColumns)
+                            {
+                                this._setUniform2iv(parameter.location, parameter.values, parameterValues);
+                            }
+                            else if (1 === paramInfo.rows)
+                            {
+                                this._setUniform1i(parameter, parameterValues);
+                            }
+                            else //if (1 === numColumns)
+                            {
+                                this._setUniform1iv(parameter.location, parameter.values, parameterValues);
+                            }
+                        }
+                    }
+                }
+            }
+
+            if (version)
+            {
+                this._recordUploaded(program, techniqueParameters);
+            }
+        }
+    }
+
+    _setParametersList(program: WebGLShaderProgram,
+                       techniqueParameters: WebGLTechniqueParameters,
                        parametersList: any[],
                        offset: number): number
     {
-        var p = parametersList[offset];
+        var p, parameter, parameterValues;
+
+        var version = techniqueParameters.version;
+        if (version &&
+            this._isUploaded(program, techniqueParameters))
+        {
+            var start = offset;
+            p = parametersList[offset];
+            offset += 1;
+
+            while (p !== null)
+            {
+                parameter = parametersList[offset];
+                offset += 1;
+
+                parameterValues = techniqueParameters[p];
+                if (parameter.info.sampler !== undefined)
+                {
+                    this._setTexture(parameter.textureUnit, parameterValues, parameter.info.sampler);
+                }
+                else if (parameterValues &&
+                         parameterValues.version !== undefined &&
+                         (!parameterValues.version ||
+                          parameter.uploadedBuffer !== parameterValues ||
+                          parameter.uploadedVersion !== parameterValues.version))
+                {
+                    break;
+                }
+
+                p = parametersList[offset];
+                offset += 1;
+            }
+
+            if (p === null)
+            {
+                if (debug)
+                {
+                    this.metrics.techniqueParametersSkipped += 1;
+                }
+                return offset;
+            }
+
+            offset = start;
+        }
+
+        p = parametersList[offset];
         offset += 1;
 
         while (p !== null)
         {
-            var parameter = parametersList[offset];
+            parameter = parametersList[offset];
             offset += 1;
 
-            var parameterValues = techniqueParameters[p];
+            parameterValues = techniqueParameters[p];
+
+            if (parameter.owner !== techniqueParameters)
+            {
+                this._claimParameter(parameter, techniqueParameters);
+            }
+
             if (parameter.current !== parameterValues)
             {
                 parameter.current = parameterValues;
@@ -6347,26 +6894,29 @@ class WebGLGraphicsDevice implements GraphicsDevice
                 var numColumns;
                 if (paramInfo.type === 'float')
                 {
-                    numColumns = paramInfo.columns;
-                    if (4 === numColumns)
-                    {
-                        this._setUniform4fv(parameter.location, parameter.values, parameterValues);
-                    }
-                    else if (3 === numColumns)
-                    {
-                        this._setUniform3fv(parameter.location, parameter.values, parameterValues);
-                    }
-                    else if (2 === numColumns)
-                    {
-                        this._setUniform2fv(parameter.location, parameter.values, parameterValues);
-                    }
-                    else if (1 === paramInfo.rows)
-                    {
-                        this._setUniform1f(parameter, parameterValues);
-                    }
-                    else //if (1 === numColumns)
+                    if (this._needsUpload(parameter, parameterValues))
                     {
-                        this._setUniform1fv(parameter.location, parameter.values, parameterValues);
+                        numColumns = paramInfo.columns;
+                        if (4 === numColumns)
+                        {
+                            this._setUniform4fv(parameter.location, parameter.values, parameterValues);
+                        }
+                        else if (3 === numColumns)
+                        {
+                            this._setUniform3fv(parameter.location, parameter.values, parameterValues);
+                        }
+                        else if (2 === numColumns)
+                        {
+                            this._setUniform2fv(parameter.location, parameter.values, parameterValues);
+                        }
+                        else if (1 === paramInfo.rows)
+                        {
+                            this._setUniform1f(parameter, parameterValues);
+                        }
+                        else //if (1 === numColumns)
+                        {
+                            this._setUniform1fv(parameter.location, parameter.values, parameterValues);
+                        }
                     }
                 }
                 else if (paramInfo.sampler !== undefined)
@@ -6403,6 +6953,11 @@ class WebGLGraphicsDevice implements GraphicsDevice
             offset += 1;
         }
 
+        if (version)
+        {
+            this._recordUploaded(program, techniqueParameters);
+        }
+
         return offset;
     }
 
@@ -6411,7 +6966,7 @@ class WebGLGraphicsDevice implements GraphicsDevice
                             passes: WebGLPass[],
                             techniqueParameters: WebGLTechniqueParameters): void
     {
-        gd._setParameters(passes[0].parameters, techniqueParameters);
+        gd._setParameters(passes[0]._linkedProgram, techniqueParameters);
     }
 
     _setParametersDeferred(gd: WebGLGraphicsDevice,
@@ -6506,69 +7061,470 @@ class WebGLGraphicsDevice implements GraphicsDevice
 
             this._activeTechnique = technique;
 
-            technique.activate(this);
+            technique.activate(this);
+
+            this.setPass(pass);
+        }
+
+        var parameters = pass.parametersArray;
+        var numParameters = parameters.length;
+        var n;
+        for (n = 0; n < numParameters; n += 1)
+        {
+            parameters[n].current = parameters[n].values;
+        }
+    }
+
+    setStream(vertexBuffer: VertexBuffer,
+              semantics: Semantics,
+              offset?: number)
+    {
+        if (debug)
+        {
+            debug.assert(vertexBuffer instanceof WebGLVertexBuffer);
+            debug.assert(semantics instanceof WebGLSemantics);
+        }
+
+        if (offset)
+        {
+            offset *= (<WebGLVertexBuffer>vertexBuffer)._strideInBytes;
+        }
+        else
+        {
+            offset = 0;
+        }
+
+        this.bindVertexBuffer((<WebGLVertexBuffer>vertexBuffer)._glBuffer);
+
+        /* tslint:disable:no-bitwise */
+        var mask = (<WebGLVertexBuffer>vertexBuffer).bindAttributesCached((<WebGLSemantics>semantics), offset);
+        this._attributeMask |= mask;
+
+        // Attributes left per instance by a previous instanced stream go back to per vertex
+        mask &= this._instanceAttributeMask;
+        if (mask)
+        {
+            this._setAttributeDivisors(mask, 0);
+        }
+        /* tslint:enable:no-bitwise */
+    }
+
+    setInstanceStream(vertexBuffer: VertexBuffer,
+                      semantics: Semantics,
+                      offset?: number)
+    {
+        if (debug)
+        {
+            debug.assert(this._instancedArraysExtension, "Instancing is not supported");
+            debug.assert(vertexBuffer instanceof WebGLVertexBuffer);
+            debug.assert(semantics instanceof WebGLSemantics);
+        }
+
+        if (offset)
+        {
+            offset *= (<WebGLVertexBuffer>vertexBuffer)._strideInBytes;
+        }
+        else
+        {
+            offset = 0;
+        }
+
+        this.bindVertexBuffer((<WebGLVertexBuffer>vertexBuffer)._glBuffer);
+
+        /* tslint:disable:no-bitwise */
+        var mask = (<WebGLVertexBuffer>vertexBuffer).bindAttributesCached((<WebGLSemantics>semantics), offset);
+        this._attributeMask |= mask;
+
+        mask &= ~this._instanceAttributeMask;
+        if (mask)
+        {
+            this._setAttributeDivisors(mask, 1);
+        }
+        /* tslint:enable:no-bitwise */
+    }
+
+    _setAttributeDivisors(mask: number, divisor: number)
+    {
+        var instancedArraysExtension = this._instancedArraysExtension;
+
+        /* tslint:disable:no-bitwise */
+        if (divisor)
+        {
+            this._instanceAttributeMask |= mask;
+        }
+        else
+        {
+            this._instanceAttributeMask &= ~mask;
+        }
+
+        var n = 0;
+        do
+        {
+            if (0 !== (0x01 & mask))
+            {
+                instancedArraysExtension.vertexAttribDivisorANGLE(n, divisor);
+            }
+            n += 1;
+            mask >>= 1;
+        }
+        while (mask);
+        /* tslint:enable:no-bitwise */
+    }
+
+    setIndexBuffer(indexBuffer: IndexBuffer)
+    {
+        if (this._activeIndexBuffer !== <WebGLIndexBuffer>indexBuffer)
+        {
+            this._activeIndexBuffer = <WebGLIndexBuffer>indexBuffer;
+            var glBuffer;
+            if (indexBuffer)
+            {
+                glBuffer = (<WebGLIndexBuffer>indexBuffer)._glBuffer;
+            }
+            else
+            {
+                glBuffer = null;
+            }
+            var gl = this._gl;
+            gl.bindBuffer(gl.ELEMENT_ARRAY_BUFFER, glBuffer);
+
+            if (debug)
+            {
+                this.metrics.indexBufferChanges += 1;
+            }
+        }
+    }
+
+    // Opt-in instance batching for drawArray: consecutive draw parameters
+    // using the given technique, with the same streams, index buffer and
+    // range, whose technique parameters only differ in the instance
+    // parameters are drawn once with the instanced technique. The instance
+    // parameters of every draw are packed in order, padded to whole FLOAT4
+    // attributes, into a per instance stream bound to the given semantics.
+    setTechniqueInstancing(technique: Technique,
+                           instancing: TechniqueInstancingParameters): boolean
+    {
+        var techniqueInstancing = this._techniqueInstancing;
+        var id = (<WebGLTechnique>technique).id;
+        if (instancing)
+        {
+            debug.assert(instancing.technique instanceof WebGLTechnique,
+                         "instancing technique must be a Technique");
+            debug.assert(instancing.semantics instanceof WebGLSemantics,
+                         "instancing semantics must be created with GraphicsDevice.createSemantics");
+
+            if (!this._instancedArraysExtension)
+            {
+                return false;
+            }
+
+            if (!techniqueInstancing[id])
+            {
+                this._numInstancedTechniques += 1;
+            }
+
+            techniqueInstancing[id] = {
+                technique: <WebGLTechnique>instancing.technique,
+                parameters: instancing.parameters.slice(),
+                semantics: <WebGLSemantics>instancing.semantics,
+                minInstances: (instancing.minInstances || 2)
+            };
+        }
+        else if (techniqueInstancing[id])
+        {
+            delete techniqueInstancing[id];
+            this._numInstancedTechniques -= 1;
+        }
+        return true;
+    }
+
+    _canBatchInstance(first: WebGLDrawParameters,
+                      drawParameters: WebGLDrawParameters,
+                      instanceParameters: string[]): boolean
+    {
+        var endStreams = first._endStreams;
+        var endTechniqueParameters = first._endTechniqueParameters;
+        if (first._technique !== drawParameters._technique ||
+            first._indexBuffer !== drawParameters._indexBuffer ||
+            first.primitive !== drawParameters.primitive ||
+            first.count !== drawParameters.count ||
+            first.firstIndex !== drawParameters.firstIndex ||
+            endStreams !== drawParameters._endStreams ||
+            endTechniqueParameters !== drawParameters._endTechniqueParameters ||
+            drawParameters._endInstances !== ((16 * 3) + 8) ||
+            drawParameters._instanceStreams !== 0 ||
+            drawParameters.instanceCount !== 0)
+        {
+            return false;
+        }
+
+        var v;
+        for (v = 0; v < endStreams; v += 1)
+        {
+            if (first[v] !== drawParameters[v])
+            {
+                return false;
+            }
+        }
+
+        var t, p;
+        for (t = (16 * 3); t < endTechniqueParameters; t += 1)
+        {
+            var firstParameters = first[t];
+            var techniqueParameters = drawParameters[t];
+            if (firstParameters !== techniqueParameters)
+            {
+                if (!firstParameters || !techniqueParameters)
+                {
+                    return false;
+                }
+
+                for (p in techniqueParameters)
+                {
+                    if (firstParameters[p] !== techniqueParameters[p] &&
+                        instanceParameters.indexOf(p) === -1)
+                    {
+                        return false;
+                    }
+                }
+
+                for (p in firstParameters)
+                {
+                    if (techniqueParameters[p] === undefined &&
+                        firstParameters[p] !== undefined)
+                    {
+                        return false;
+                    }
+                }
+            }
+        }
+
+        return true;
+    }
+
+    _createInstanceBatch(instancing: WebGLTechniqueInstancing,
+                         drawParametersArray: WebGLDrawParameters[],
+                         start: number,
+                         end: number,
+                         device: GraphicsDevice): WebGLDrawParameters
+    {
+        var first = drawParametersArray[start];
+        var endStreams = first._endStreams;
+        var endTechniqueParameters = first._endTechniqueParameters;
+        var parameters = instancing.parameters;
+        var numParameters = parameters.length;
+        var numInstances = (end - start);
+        var n, p, t, value, techniqueParameters;
+
+        debug.assert(endStreams < (16 * 3), "no stream left for the instance data");
+
+        // Batches are reused every frame, not every call, so the instance
+        // buffers of earlier draws are not overwritten while in use
+        var batch = this._instanceBatches[this._numInstanceBatches];
+        if (!batch)
+        {
+            batch = this._instanceBatches[this._numInstanceBatches] = {
+                drawParameters: WebGLDrawParameters.create(),
+                vertexBuffer: null,
+                data: null,
+                device: null
+            };
+        }
+        this._numInstanceBatches += 1;
+
+        var sizes = this._instanceParameterSizes;
+        var stride = 0;
+        for (p = 0; p < numParameters; p += 1)
+        {
+            value = undefined;
+            for (t = (endTechniqueParameters - 1); t >= (16 * 3); t -= 1)
+            {
+                techniqueParameters = first[t];
+                if (techniqueParameters && techniqueParameters[parameters[p]] !== undefined)
+                {
+                    value = techniqueParameters[parameters[p]];
+                    break;
+                }
+            }
+            sizes[p] = (typeof value === "number" ? 1 : (value ? value.length : 0));
+            stride += sizes[p];
+        }
+        var numAttributes = Math.ceil(stride / 4);
+        stride = (numAttributes * 4);
+
+        debug.assert(numAttributes <= instancing.semantics.length,
+                     "not enough instancing semantics for the instance parameters");
+
+        var data = batch.data;
+        if (!data || data.length < (numInstances * stride))
+        {
+            var capacity = 16;
+            while (capacity < numInstances)
+            {
+                capacity *= 2;
+            }
+            data = batch.data = new Float32Array(capacity * stride);
+        }
+
+        var vertexBuffer = batch.vertexBuffer;
+        if (!vertexBuffer ||
+            batch.device !== device ||
+            vertexBuffer.stride !== stride ||
+            (vertexBuffer.numVertices * stride) < data.length)
+        {
+            if (vertexBuffer)
+            {
+                vertexBuffer.destroy();
+            }
+            var attributes = [];
+            for (n = 0; n < numAttributes; n += 1)
+            {
+                attributes[n] = this.VERTEXFORMAT_FLOAT4;
+            }
+            vertexBuffer = batch.vertexBuffer = <WebGLVertexBuffer>device.createVertexBuffer({
+                numVertices: (data.length / stride),
+                attributes: attributes,
+                dynamic: true
+            });
+            batch.device = device;
+        }
+
+        // Later technique parameters override earlier ones, as when drawing
+        var offset = 0;
+        for (n = start; n < end; n += 1)
+        {
+            var drawParameters = drawParametersArray[n];
+            var instanceEnd = (offset + stride);
+            for (p = 0; p < numParameters; p += 1)
+            {
+                var size = sizes[p];
+                value = undefined;
+                for (t = (endTechniqueParameters - 1); t >= (16 * 3); t -= 1)
+                {
+                    techniqueParameters = drawParameters[t];
+                    if (techniqueParameters && techniqueParameters[parameters[p]] !== undefined)
+                    {
+                        value = techniqueParameters[parameters[p]];
+                        break;
+                    }
+                }
+                if (size === 1)
+                {
+                    data[offset] = value;
+                    offset += 1;
+                }
+                else
+                {
+                    for (var i = 0; i < size; i += 1)
+                    {
+                        data[offset + i] = value[i];
+                    }
+                    offset += size;
+                }
+            }
+            while (offset < instanceEnd)
+            {
+                data[offset] = 0;
+                offset += 1;
+            }
+        }
+
+        vertexBuffer.setData(data, 0, numInstances);
 
-            this.setPass(pass);
-        }
+        var batchDrawParameters = batch.drawParameters;
+        batchDrawParameters.technique = instancing.technique;
+        batchDrawParameters.primitive = first.primitive;
+        batchDrawParameters.count = first.count;
+        batchDrawParameters.firstIndex = first.firstIndex;
+        batchDrawParameters.indexBuffer = first._indexBuffer;
+        batchDrawParameters.sortKey = first.sortKey;
+        batchDrawParameters.userData = first.userData;
+        batchDrawParameters.instanceCount = numInstances;
 
-        var parameters = pass.parametersArray;
-        var numParameters = parameters.length;
-        var n;
-        for (n = 0; n < numParameters; n += 1)
+        var numStreams = (endStreams / 3);
+        for (n = 0; n < numStreams; n += 1)
         {
-            parameters[n].current = parameters[n].values;
+            batchDrawParameters.setVertexBuffer(n, first[(n * 3)]);
+            batchDrawParameters.setSemantics(n, first[(n * 3) + 1]);
+            batchDrawParameters.setOffset(n, first[(n * 3) + 2]);
         }
-    }
-
-    setStream(vertexBuffer: VertexBuffer,
-              semantics: Semantics,
-              offset?: number)
-    {
-        if (debug)
+        batchDrawParameters.setVertexBuffer(numStreams, vertexBuffer);
+        batchDrawParameters.setSemantics(numStreams, instancing.semantics);
+        batchDrawParameters.setOffset(numStreams, 0);
+        while (((numStreams + 1) * 3) < batchDrawParameters._endStreams)
         {
-            debug.assert(vertexBuffer instanceof WebGLVertexBuffer);
-            debug.assert(semantics instanceof WebGLSemantics);
+            batchDrawParameters.setVertexBuffer(((batchDrawParameters._endStreams / 3) - 1), null);
         }
 
-        if (offset)
+        /* tslint:disable:no-bitwise */
+        var instanceStreams = (1 << numStreams);
+        /* tslint:enable:no-bitwise */
+        if (batchDrawParameters._instanceStreams !== instanceStreams)
         {
-            offset *= (<WebGLVertexBuffer>vertexBuffer)._strideInBytes;
+            batchDrawParameters._instanceStreams = instanceStreams;
+            batchDrawParameters._vao = null;
         }
-        else
+
+        for (t = 0; t < 8; t += 1)
         {
-            offset = 0;
+            techniqueParameters = first.getTechniqueParameters(t);
+            if (techniqueParameters || batchDrawParameters.getTechniqueParameters(t))
+            {
+                batchDrawParameters.setTechniqueParameters(t, techniqueParameters);
+            }
         }
 
-        this.bindVertexBuffer((<WebGLVertexBuffer>vertexBuffer)._glBuffer);
-
-        /* tslint:disable:no-bitwise */
-        this._attributeMask |=
-            (<WebGLVertexBuffer>vertexBuffer).bindAttributesCached((<WebGLSemantics>semantics), offset);
-        /* tslint:enable:no-bitwise */
+        return batchDrawParameters;
     }
 
-    setIndexBuffer(indexBuffer: IndexBuffer)
+    // Replace the runs of draw parameters that can be instanced by their batches,
+    // the instance buffers are created by the given device so a wrapping
+    // device like CaptureGraphicsDevice sees their data
+    _batchInstances(drawParametersArray: WebGLDrawParameters[],
+                    device?: GraphicsDevice): WebGLDrawParameters[]
     {
-        if (this._activeIndexBuffer !== <WebGLIndexBuffer>indexBuffer)
+        var techniqueInstancing = this._techniqueInstancing;
+        var batchedDrawParameters = this._batchedDrawParameters;
+        var numDrawParameters = drawParametersArray.length;
+        var numBatched = 0;
+        var n = 0;
+        while (n < numDrawParameters)
         {
-            this._activeIndexBuffer = <WebGLIndexBuffer>indexBuffer;
-            var glBuffer;
-            if (indexBuffer)
+            var drawParameters = drawParametersArray[n];
+            var instancing = techniqueInstancing[drawParameters._technique.id];
+            var end = (n + 1);
+            if (instancing &&
+                drawParameters._endInstances === ((16 * 3) + 8) &&
+                drawParameters._instanceStreams === 0 &&
+                drawParameters.instanceCount === 0)
             {
-                glBuffer = (<WebGLIndexBuffer>indexBuffer)._glBuffer;
+                while (end < numDrawParameters &&
+                       this._canBatchInstance(drawParameters, drawParametersArray[end], instancing.parameters))
+                {
+                    end += 1;
+                }
             }
-            else
+
+            if (instancing && instancing.minInstances <= (end - n))
             {
-                glBuffer = null;
+                batchedDrawParameters[numBatched] = this._createInstanceBatch(instancing, drawParametersArray,
+                                                                              n, end, (device || this));
+                numBatched += 1;
+                n = end;
             }
-            var gl = this._gl;
-            gl.bindBuffer(gl.ELEMENT_ARRAY_BUFFER, glBuffer);
-
-            if (debug)
+            else
             {
-                this.metrics.indexBufferChanges += 1;
+                do
+                {
+                    batchedDrawParameters[numBatched] = drawParametersArray[n];
+                    numBatched += 1;
+                    n += 1;
+                }
+                while (n < end);
             }
         }
+        batchedDrawParameters.length = numBatched;
+        return batchedDrawParameters;
     }
 
     // This version only support technique with a single pass, but it is faster
@@ -6578,18 +7534,18 @@ class WebGLGraphicsDevice implements GraphicsDevice
     {
         var gl = this._gl;
         var ELEMENT_ARRAY_BUFFER = gl.ELEMENT_ARRAY_BUFFER;
+        var instancedArraysExtension = this._instancedArraysExtension;
 
         var numDrawParameters = drawParametersArray.length;
         if (numDrawParameters > 1 && sortMode)
         {
-            if (sortMode > 0)
-            {
-                drawParametersArray.sort(this._drawArraySortPositive);
-            }
-            else //if (sortMode < 0)
-            {
-                drawParametersArray.sort(this._drawArraySortNegative);
-            }
+            this._sortDrawParameters(drawParametersArray, numDrawParameters, sortMode);
+        }
+
+        if (this._numInstancedTechniques)
+        {
+            drawParametersArray = this._batchInstances(drawParametersArray);
+            numDrawParameters = drawParametersArray.length;
         }
 
         var globalsArray = this._techniqueParametersArray;
@@ -6605,6 +7561,7 @@ class WebGLGraphicsDevice implements GraphicsDevice
         var vertexBuffer = null;
         var pass: WebGLPass = null;
         var passParameters: { [name: string]: WebGLProgramParameter } = null;
+        var program: WebGLShaderProgram = null;
         var indexFormat = 0;
         var indexStride = 0;
         var mask = 0;
@@ -6628,6 +7585,8 @@ class WebGLGraphicsDevice implements GraphicsDevice
             var primitive = drawParameters.primitive;
             var count = drawParameters.count;
             var firstIndex = drawParameters.firstIndex;
+            var instanceCount = drawParameters.instanceCount;
+            var instanceStreams = drawParameters._instanceStreams;
 
             if (lastTechnique !== technique)
             {
@@ -6637,6 +7596,7 @@ class WebGLGraphicsDevice implements GraphicsDevice
 
                 pass = technique.passes[0];
                 passParameters = pass.parameters;
+                program = pass._linkedProgram;
 
                 /* tslint:disable:no-bitwise */
                 mask = (pass.semanticsMask & attributeMask);
@@ -6651,7 +7611,7 @@ class WebGLGraphicsDevice implements GraphicsDevice
                     technique.checkProperties(this);
                 }
 
-                this._setParametersArray(passParameters, globalsArray, numGlobalParameters);
+                this._setParametersArray(program, globalsArray, numGlobalParameters);
             }
 
             var parametersList = drawParameters._parametersList;
@@ -6663,10 +7623,11 @@ class WebGLGraphicsDevice implements GraphicsDevice
             offset = 0;
             for (t = (16 * 3); t < endTechniqueParameters; t += 1)
             {
-                offset = this._setParametersList(drawParameters[t], parametersList, offset);
+                offset = this._setParametersList(program, drawParameters[t], parametersList, offset);
             }
 
-            streamsMatch = (lastEndStreams === endStreams);
+            streamsMatch = (lastEndStreams === endStreams &&
+                            lastDrawParameters._instanceStreams === instanceStreams);
             for (v = 0; streamsMatch && v < endStreams; v += 3)
             {
                 streamsMatch = (lastDrawParameters[v]     === drawParameters[v]     &&
@@ -6683,7 +7644,16 @@ class WebGLGraphicsDevice implements GraphicsDevice
                     vertexBuffer = drawParameters[v];
                     if (vertexBuffer)
                     {
-                        this.setStream(vertexBuffer, drawParameters[v + 1], drawParameters[v + 2]);
+                        /* tslint:disable:no-bitwise */
+                        if (0 === (instanceStreams & (1 << (v / 3))))
+                        {
+                            this.setStream(vertexBuffer, drawParameters[v + 1], drawParameters[v + 2]);
+                        }
+                        else
+                        {
+                            this.setInstanceStream(vertexBuffer, drawParameters[v + 1], drawParameters[v + 2]);
+                        }
+                        /* tslint:enable:no-bitwise */
                     }
                 }
 
@@ -6724,7 +7694,7 @@ class WebGLGraphicsDevice implements GraphicsDevice
                 {
                     do
                     {
-                        this._setParameters(passParameters, drawParameters[t]);
+                        this._setParameters(program, drawParameters[t]);
 
                         gl.drawElements(primitive, count, indexFormat, firstIndex);
 
@@ -6737,6 +7707,16 @@ class WebGLGraphicsDevice implements GraphicsDevice
                     }
                     while (t < endInstances);
                 }
+                else if (instanceCount)
+                {
+                    instancedArraysExtension.drawElementsInstancedANGLE(primitive, count, indexFormat, firstIndex,
+                                                                        instanceCount);
+
+                    if (debug)
+                    {
+                        this.metrics.addPrimitives(primitive, count, instanceCount);
+                    }
+                }
                 else
                 {
                     gl.drawElements(primitive, count, indexFormat, firstIndex);
@@ -6754,7 +7734,7 @@ class WebGLGraphicsDevice implements GraphicsDevice
                 {
                     do
                     {
-                        this._setParameters(passParameters, drawParameters[t]);
+                        this._setParameters(program, drawParameters[t]);
 
                         gl.drawArrays(primitive, firstIndex, count);
 
@@ -6767,6 +7747,15 @@ class WebGLGraphicsDevice implements GraphicsDevice
                     }
                     while (t < endInstances);
                 }
+                else if (instanceCount)
+                {
+                    instancedArraysExtension.drawArraysInstancedANGLE(primitive, firstIndex, count, instanceCount);
+
+                    if (debug)
+                    {
+                        this.metrics.addPrimitives(primitive, count, instanceCount);
+                    }
+                }
                 else
                 {
                     gl.drawArrays(primitive, firstIndex, count);
@@ -6797,25 +7786,26 @@ class WebGLGraphicsDevice implements GraphicsDevice
 
         if (numDrawParameters > 1 && sortMode)
         {
-            if (sortMode > 0)
-            {
-                drawParametersArray.sort(this._drawArraySortPositive);
-            }
-            else //if (sortMode < 0)
-            {
-                drawParametersArray.sort(this._drawArraySortNegative);
-            }
+            this._sortDrawParameters(drawParametersArray, numDrawParameters, sortMode);
+        }
+
+        if (this._numInstancedTechniques)
+        {
+            drawParametersArray = this._batchInstances(drawParametersArray);
+            numDrawParameters = drawParametersArray.length;
         }
 
         var globalsArray = this._techniqueParametersArray;
         var numGlobalParameters = this._createTechniqueParametersArray(globalTechniqueParametersArray, globalsArray);
 
         var vertexArrayObjectExtension = this._vertexArrayObjectExtension;
+        var instancedArraysExtension = this._instancedArraysExtension;
 
         var lastTechnique: WebGLTechnique = null;
         var lastVAO = null;
         var pass: WebGLPass = null;
         var passParameters: { [name: string]: WebGLProgramParameter } = null;
+        var program: WebGLShaderProgram = null;
         var indexFormat = 0;
         var indexStride = 0;
         var offset = 0;
@@ -6831,6 +7821,7 @@ class WebGLGraphicsDevice implements GraphicsDevice
             var primitive = drawParameters.primitive;
             var count = drawParameters.count;
             var firstIndex = drawParameters.firstIndex;
+            var instanceCount = drawParameters.instanceCount;
 
             if (lastTechnique !== technique)
             {
@@ -6840,13 +7831,14 @@ class WebGLGraphicsDevice implements GraphicsDevice
 
                 pass = technique.passes[0];
                 passParameters = pass.parameters;
+                program = pass._linkedProgram;
 
                 if (technique.checkProperties)
                 {
                     technique.checkProperties(this);
                 }
 
-                this._setParametersArray(passParameters, globalsArray, numGlobalParameters);
+                this._setParametersArray(program, globalsArray, numGlobalParameters);
             }
 
             var parametersList = drawParameters._parametersList;
@@ -6858,7 +7850,7 @@ class WebGLGraphicsDevice implements GraphicsDevice
             offset = 0;
             for (t = (16 * 3); t < endTechniqueParameters; t += 1)
             {
-                offset = this._setParametersList(drawParameters[t], parametersList, offset);
+                offset = this._setParametersList(program, drawParameters[t], parametersList, offset);
             }
 
             var vao = drawParameters._vao;
@@ -6895,7 +7887,7 @@ class WebGLGraphicsDevice implements GraphicsDevice
                 {
                     do
                     {
-                        this._setParameters(passParameters, drawParameters[t]);
+                        this._setParameters(program, drawParameters[t]);
 
                         gl.drawElements(primitive, count, indexFormat, firstIndex);
 
@@ -6908,6 +7900,16 @@ class WebGLGraphicsDevice implements GraphicsDevice
                     }
                     while (t < endInstances);
                 }
+                else if (instanceCount)
+                {
+                    instancedArraysExtension.drawElementsInstancedANGLE(primitive, count, indexFormat, firstIndex,
+                                                                        instanceCount);
+
+                    if (debug)
+                    {
+                        this.metrics.addPrimitives(primitive, count, instanceCount);
+                    }
+                }
                 else
                 {
                     gl.drawElements(primitive, count, indexFormat, firstIndex);
@@ -6925,7 +7927,7 @@ class WebGLGraphicsDevice implements GraphicsDevice
                 {
                     do
                     {
-                        this._setParameters(passParameters, drawParameters[t]);
+                        this._setParameters(program, drawParameters[t]);
 
                         gl.drawArrays(primitive, firstIndex, count);
 
@@ -6938,6 +7940,15 @@ class WebGLGraphicsDevice implements GraphicsDevice
                     }
                     while (t < endInstances);
                 }
+                else if (instanceCount)
+                {
+                    instancedArraysExtension.drawArraysInstancedANGLE(primitive, firstIndex, count, instanceCount);
+
+                    if (debug)
+                    {
+                        this.metrics.addPrimitives(primitive, count, instanceCount);
+                    }
+                }
                 else
                 {
                     gl.drawArrays(primitive, firstIndex, count);
@@ -6970,6 +7981,7 @@ class WebGLGraphicsDevice implements GraphicsDevice
     _createVAO(drawParameters: WebGLDrawParameters): any
     {
         var endStreams = drawParameters._endStreams;
+        var instanceStreams = drawParameters._instanceStreams;
         var indexBuffer = drawParameters._indexBuffer;
         var id = (indexBuffer ? indexBuffer.id : 0);
         var vaoArray = this._cachedVAOs[id];
@@ -6984,7 +7996,8 @@ class WebGLGraphicsDevice implements GraphicsDevice
             {
                 vaoItem = vaoArray[n];
 
-                vaoMatch = (vaoItem.endStreams === endStreams);
+                vaoMatch = (vaoItem.endStreams === endStreams &&
+                            vaoItem.instanceStreams === instanceStreams);
                 for (v = 0; vaoMatch && v < endStreams; v += 3)
                 {
                     vaoMatch = (vaoItem[v]     === drawParameters[v]     &&
@@ -7031,7 +8044,24 @@ class WebGLGraphicsDevice implements GraphicsDevice
                 gl.bindBuffer(gl.ARRAY_BUFFER, vertexBuffer._glBuffer);
 
                 /* tslint:disable:no-bitwise */
-                attributeMask |= vertexBuffer.bindAttributes(semantics, offset);
+                var streamMask = vertexBuffer.bindAttributes(semantics, offset);
+                attributeMask |= streamMask;
+
+                // Divisors are part of the vertex array object state
+                if (0 !== (instanceStreams & (1 << (v / 3))))
+                {
+                    var semantic = 0;
+                    do
+                    {
+                        if (0 !== (0x01 & streamMask))
+                        {
+                            this._instancedArraysExtension.vertexAttribDivisorANGLE(semantic, 1);
+                        }
+                        semantic += 1;
+                        streamMask >>= 1;
+                    }
+                    while (streamMask);
+                }
                 /* tslint:enable:no-bitwise */
 
                 if (debug)
@@ -7058,6 +8088,7 @@ class WebGLGraphicsDevice implements GraphicsDevice
 
         vaoItem = <WebGLVAOItem>{
             endStreams: endStreams,
+            instanceStreams: instanceStreams,
             vao: vao
         };
 
@@ -7081,6 +8112,7 @@ class WebGLGraphicsDevice implements GraphicsDevice
     {
         var gl = this._gl;
         var ELEMENT_ARRAY_BUFFER = gl.ELEMENT_ARRAY_BUFFER;
+        var instancedArraysExtension = this._instancedArraysExtension;
 
         var setParametersImmediate = this._setParametersMultiPass;
         var setParametersDeferred = this._setParametersDeferred;
@@ -7090,14 +8122,13 @@ class WebGLGraphicsDevice implements GraphicsDevice
         var numDrawParameters = drawParametersArray.length;
         if (numDrawParameters > 1 && sortMode)
         {
-            if (sortMode > 0)
-            {
-                drawParametersArray.sort(this._drawArraySortPositive);
-            }
-            else //if (sortMode < 0)
-            {
-                drawParametersArray.sort(this._drawArraySortNegative);
-            }
+            this._sortDrawParameters(drawParametersArray, numDrawParameters, sortMode);
+        }
+
+        if (this._numInstancedTechniques)
+        {
+            drawParametersArray = this._batchInstances(drawParametersArray);
+            numDrawParameters = drawParametersArray.length;
         }
 
         var activeIndexBuffer = this._activeIndexBuffer;
@@ -7136,6 +8167,8 @@ class WebGLGraphicsDevice implements GraphicsDevice
             var primitive = drawParameters.primitive;
             var count = drawParameters.count;
             var firstIndex = drawParameters.firstIndex;
+            var instanceCount = drawParameters.instanceCount;
+            var instanceStreams = drawParameters._instanceStreams;
 
             if (lastTechnique !== technique)
             {
@@ -7182,7 +8215,8 @@ class WebGLGraphicsDevice implements GraphicsDevice
                 }
             }
 
-            streamsMatch = (lastEndStreams === endStreams);
+            streamsMatch = (lastEndStreams === endStreams &&
+                            lastDrawParameters._instanceStreams === instanceStreams);
             for (v = 0; streamsMatch && v < endStreams; v += 3)
             {
                 streamsMatch = (lastDrawParameters[v]     === drawParameters[v]     &&
@@ -7199,7 +8233,16 @@ class WebGLGraphicsDevice implements GraphicsDevice
                     vertexBuffer = drawParameters[v];
                     if (vertexBuffer)
                     {
-                        this.setStream(vertexBuffer, drawParameters[v + 1], drawParameters[v + 2]);
+                        /* tslint:disable:no-bitwise */
+                        if (0 === (instanceStreams & (1 << (v / 3))))
+                        {
+                            this.setStream(vertexBuffer, drawParameters[v + 1], drawParameters[v + 2]);
+                        }
+                        else
+                        {
+                            this.setInstanceStream(vertexBuffer, drawParameters[v + 1], drawParameters[v + 2]);
+                        }
+                        /* tslint:enable:no-bitwise */
                     }
                 }
 
@@ -7257,6 +8300,16 @@ class WebGLGraphicsDevice implements GraphicsDevice
                         }
                         while (t < endInstances);
                     }
+                    else if (instanceCount)
+                    {
+                        instancedArraysExtension.drawElementsInstancedANGLE(primitive, count, indexFormat, firstIndex,
+                                                                            instanceCount);
+
+                        if (debug)
+                        {
+                            this.metrics.addPrimitives(primitive, count, instanceCount);
+                        }
+                    }
                     else
                     {
                         gl.drawElements(primitive, count, indexFormat, firstIndex);
@@ -7314,11 +8367,19 @@ class WebGLGraphicsDevice implements GraphicsDevice
 
                             this.setPass(pass);
 
-                            gl.drawElements(primitive, count, indexFormat, firstIndex);
+                            if (instanceCount)
+                            {
+                                instancedArraysExtension.drawElementsInstancedANGLE(primitive, count, indexFormat,
+                                                                                    firstIndex, instanceCount);
+                            }
+                            else
+                            {
+                                gl.drawElements(primitive, count, indexFormat, firstIndex);
+                            }
 
                             if (debug)
                             {
-                                this.metrics.addPrimitives(primitive, count);
+                                this.metrics.addPrimitives(primitive, count, instanceCount);
                             }
                         }
                     }
@@ -7346,6 +8407,15 @@ class WebGLGraphicsDevice implements GraphicsDevice
                         }
                         while (t < endInstances);
                     }
+                    else if (instanceCount)
+                    {
+                        instancedArraysExtension.drawArraysInstancedANGLE(primitive, firstIndex, count, instanceCount);
+
+                        if (debug)
+                        {
+                            this.metrics.addPrimitives(primitive, count, instanceCount);
+                        }
+                    }
                     else
                     {
                         gl.drawArrays(primitive, firstIndex, count);
@@ -7403,11 +8473,19 @@ class WebGLGraphicsDevice implements GraphicsDevice
 
                             this.setPass(pass);
 
-                            gl.drawArrays(primitive, firstIndex, count);
+                            if (instanceCount)
+                            {
+                                instancedArraysExtension.drawArraysInstancedANGLE(primitive, firstIndex, count,
+                                                                                  instanceCount);
+                            }
+                            else
+                            {
+                                gl.drawArrays(primitive, firstIndex, count);
+                            }
 
                             if (debug)
                             {
-                                this.metrics.addPrimitives(primitive, count);
+                                this.metrics.addPrimitives(primitive, count, instanceCount);
                             }
                         }
                     }
@@ -7670,6 +8748,13 @@ class WebGLGraphicsDevice implements GraphicsDevice
         this.setScissor(0, 0, this.width, this.height);
         this.setViewport(0, 0, this.width, this.height);
 
+        this._numInstanceBatches = 0;
+
+        if (this._pendingPrograms.length)
+        {
+            this.updateShaderPrograms(this.shaderLinkTime);
+        }
+
         if (debug)
         {
             this.metrics.renderTargetChanges = 0;
@@ -7680,6 +8765,8 @@ class WebGLGraphicsDevice implements GraphicsDevice
             this.metrics.indexBufferChanges = 0;
             this.metrics.vertexArrayObjectChanges = 0;
             this.metrics.techniqueParametersChanges = 0;
+            this.metrics.techniqueParametersSkipped = 0;
+            this.metrics.techniqueParameterBuffersSkipped = 0;
             this.metrics.techniqueChanges = 0;
             this.metrics.drawCalls = 0;
             this.metrics.primitives = 0;
@@ -7690,6 +8777,40 @@ class WebGLGraphicsDevice implements GraphicsDevice
         /* tslint:enable:no-string-literal */
     }
 
+    // Links queued shader programs for up to maxTime milliseconds, at least
+    // one is linked per call. Returns the number of programs still queued.
+    updateShaderPrograms(maxTime: number): number
+    {
+        var pendingPrograms = this._pendingPrograms;
+        var numPending = pendingPrograms.length;
+        if (numPending)
+        {
+            var gl = this._gl;
+            var endTime = (TurbulenzEngine.getTime() + maxTime);
+            var n = 0;
+            do
+            {
+                var program = pendingPrograms[n];
+                n += 1;
+
+                // Skip programs already linked on use or destroyed
+                var glProgram = program.glProgram;
+                if (glProgram && !program._linkRequested)
+                {
+                    program.link(this);
+
+                    // Querying the status waits for the link to complete
+                    gl.getProgramParameter(glProgram, gl.LINK_STATUS);
+                }
+            }
+            while (n < numPending && TurbulenzEngine.getTime() < endTime);
+
+            pendingPrograms.splice(0, n);
+            numPending -= n;
+        }
+        return numPending;
+    }
+
     beginRenderTarget(renderTarget: RenderTarget): boolean
     {
         debug.assert(!this._activeRenderTarget,
@@ -7848,7 +8969,8 @@ class WebGLGraphicsDevice implements GraphicsDevice
                 {
                     techniqueParametersArray[n] = p;
                     techniqueParametersArray[n + 1] = parameterValues;
-                    n += 2;
+                    techniqueParametersArray[n + 2] = tp;
+                    n += 3;
                 }
             }
         }
@@ -8027,6 +9149,14 @@ class WebGLGraphicsDevice implements GraphicsDevice
         {
             return this._standardDerivativesExtension;
         }
+        else if ("INSTANCED_ARRAYS" === name)
+        {
+            return !!this._instancedArraysExtension;
+        }
+        else if ("PARALLEL_SHADER_COMPILE" === name)
+        {
+            return !!this._parallelShaderCompileExtension;
+        }
         return undefined;
     }
 
@@ -8219,6 +9349,144 @@ class WebGLGraphicsDevice implements GraphicsDevice
         return (a.sortKey - b.sortKey);
     }
 
+    // Sorts the draw parameters by decreasing (sortMode > 0) or increasing
+    // (sortMode < 0) sortKey. Small arrays use the comparators, larger ones a
+    // stable LSD radix sort on the two 32-bit words of each IEEE-754 key,
+    // mapped so that unsigned integer order matches numeric order.
+    _sortDrawParameters(drawParametersArray: WebGLDrawParameters[],
+                        numDrawParameters: number,
+                        sortMode: number): void
+    {
+        if (numDrawParameters < 32)
+        {
+            if (sortMode > 0)
+            {
+                drawParametersArray.sort(this._drawArraySortPositive);
+            }
+            else //if (sortMode < 0)
+            {
+                drawParametersArray.sort(this._drawArraySortNegative);
+            }
+            return;
+        }
+
+        var keys = this._sortKeys;
+        if (!keys || keys.length < numDrawParameters)
+        {
+            var capacity = (keys ? keys.length : 64);
+            while (capacity < numDrawParameters)
+            {
+                capacity *= 2;
+            }
+            keys = new Float64Array(capacity);
+            this._sortKeys = keys;
+            this._sortKeyWords = new Uint32Array(keys.buffer);
+            this._sortKeysLow = new Uint32Array(capacity);
+            this._sortKeysHigh = new Uint32Array(capacity);
+            this._sortIndices = new Uint32Array(capacity);
+            this._sortIndicesTemp = new Uint32Array(capacity);
+        }
+
+        var keyWords = this._sortKeyWords;
+        var keysLow = this._sortKeysLow;
+        var keysHigh = this._sortKeysHigh;
+        var source = this._sortIndices;
+        var destination = this._sortIndicesTemp;
+        var histogram = this._sortHistogram;
+        var highWord = this._sortHighWord;
+        var lowWord = (1 - highWord);
+        var n, b;
+
+        for (b = 0; b < 2048; b += 1)
+        {
+            histogram[b] = 0;
+        }
+
+        // NaN, undefined and -0 sort as 0, like the comparators
+        for (n = 0; n < numDrawParameters; n += 1)
+        {
+            keys[n] = (drawParametersArray[n].sortKey || 0);
+        }
+
+        /* tslint:disable:no-bitwise */
+        var flip = (sortMode > 0 ? 0xffffffff : 0);
+        var high, low;
+        for (n = 0; n < numDrawParameters; n += 1)
+        {
+            high = keyWords[(n * 2) + highWord];
+            low = keyWords[(n * 2) + lowWord];
+            if (high & 0x80000000)
+            {
+                high = ~high;
+                low = ~low;
+            }
+            else
+            {
+                high |= 0x80000000;
+            }
+            high ^= flip;
+            low ^= flip;
+            keysHigh[n] = high;
+            keysLow[n] = low;
+            source[n] = n;
+
+            histogram[(low & 0xff)] += 1;
+            histogram[256 + ((low >>> 8) & 0xff)] += 1;
+            histogram[512 + ((low >>> 16) & 0xff)] += 1;
+            histogram[768 + (low >>> 24)] += 1;
+            histogram[1024 + (high & 0xff)] += 1;
+            histogram[1280 + ((high >>> 8) & 0xff)] += 1;
+            histogram[1536 + ((high >>> 16) & 0xff)] += 1;
+            histogram[1792 + (high >>> 24)] += 1;
+        }
+
+        var digitKeys, shift, offset, sum, count, index, temp;
+        for (var pass = 0; pass < 8; pass += 1)
+        {
+            digitKeys = (pass < 4 ? keysLow : keysHigh);
+            shift = ((pass & 3) * 8);
+            offset = (pass * 256);
+
+            // Digits shared by every key do not change the order
+            if (histogram[offset + ((digitKeys[0] >>> shift) & 0xff)] === numDrawParameters)
+            {
+                continue;
+            }
+
+            sum = 0;
+            for (b = offset; b < (offset + 256); b += 1)
+            {
+                count = histogram[b];
+                histogram[b] = sum;
+                sum += count;
+            }
+
+            for (n = 0; n < numDrawParameters; n += 1)
+            {
+                index = source[n];
+                b = (offset + ((digitKeys[index] >>> shift) & 0xff));
+                destination[histogram[b]] = index;
+                histogram[b] += 1;
+            }
+
+            temp = source;
+            source = destination;
+            destination = temp;
+        }
+        /* tslint:enable:no-bitwise */
+
+        var sorted = this._sortedDrawParameters;
+        for (n = 0; n < numDrawParameters; n += 1)
+        {
+            sorted[n] = drawParametersArray[source[n]];
+        }
+        for (n = 0; n < numDrawParameters; n += 1)
+        {
+            drawParametersArray[n] = sorted[n];
+            sorted[n] = null;
+        }
+    }
+
     checkFullScreen()
     {
         var fullscreen = this.fullscreen;
@@ -8711,6 +9979,30 @@ class WebGLGraphicsDevice implements GraphicsDevice
             delete this._immediateVertexBuffer;
         }
 
+        var instanceBatches = this._instanceBatches;
+        if (instanceBatches)
+        {
+            var numInstanceBatches = instanceBatches.length;
+            for (var n = 0; n < numInstanceBatches; n += 1)
+            {
+                if (instanceBatches[n].vertexBuffer)
+                {
+                    instanceBatches[n].vertexBuffer.destroy();
+                }
+            }
+            delete this._instanceBatches;
+            delete this._batchedDrawParameters;
+        }
+
+        delete this._sortKeys;
+        delete this._sortKeyWords;
+        delete this._sortKeysLow;
+        delete this._sortKeysHigh;
+        delete this._sortIndices;
+        delete this._sortIndicesTemp;
+        delete this._sortHistogram;
+        delete this._sortedDrawParameters;
+
         delete this._gl;
 
         if (typeof DDSLoader !== 'undefined')
@@ -8941,6 +10233,40 @@ class WebGLGraphicsDevice implements GraphicsDevice
             gd._cachedVAOs = {};
         }
 
+        // Enable ANGLE_instanced_arrays extension
+        gd._instancedArraysExtension = null;
+        if (extensionsMap['ANGLE_instanced_arrays'])
+        {
+            gd._instancedArraysExtension = gl.getExtension('ANGLE_instanced_arrays');
+        }
+        gd._instanceAttributeMask = 0;
+        gd._techniqueInstancing = {};
+        gd._numInstancedTechniques = 0;
+        gd._instanceBatches = [];
+        gd._numInstanceBatches = 0;
+        gd._batchedDrawParameters = [];
+        gd._instanceParameterSizes = [];
+
+        // Enable KHR_parallel_shader_compile extension
+        gd._parallelShaderCompileExtension = null;
+        if (extensionsMap['KHR_parallel_shader_compile'])
+        {
+            gd._parallelShaderCompileExtension = gl.getExtension('KHR_parallel_shader_compile');
+        }
+        gd._pendingPrograms = [];
+        gd.shaderLinkTime = 2;
+
+        // Radix sort buffers for drawArray, grown on demand
+        gd._sortKeys = null;
+        gd._sortKeyWords = null;
+        gd._sortKeysLow = null;
+        gd._sortKeysHigh = null;
+        gd._sortIndices = null;
+        gd._sortIndicesTemp = null;
+        gd._sortHistogram = new Uint32Array(8 * 256);
+        gd._sortHighWord = (new Uint32Array(new Float64Array([1.0]).buffer)[1] === 0x3ff00000 ? 1 : 0);
+        gd._sortedDrawParameters = [];
+
         if (extensionsMap['WEBGL_debug_renderer_info'])
         {
             var debugRendererInfo = gl.getExtension('WEBGL_debug_renderer_info');
@@ -9308,37 +10634,45 @@ class WebGLGraphicsDevice implements GraphicsDevice
                 indexBufferChanges: 0,
                 vertexArrayObjectChanges: 0,
                 techniqueParametersChanges: 0,
+                techniqueParametersSkipped: 0,
+                techniqueParameterBuffersSkipped: 0,
                 techniqueChanges: 0,
                 drawCalls: 0,
                 primitives: 0,
 
-                addPrimitives: function addPrimitivesFn(primitive: number, count: number)
+                addPrimitives: function addPrimitivesFn(primitive: number, count: number, numInstances?: number)
                 {
                     this.drawCalls += 1;
+                    var numPrimitives = 0;
                     switch (primitive)
                     {
                     case 0x0000: //POINTS
-                        this.primitives += count;
+                        numPrimitives = count;
                         break;
                     case 0x0001: //LINES
-                        this.primitives += (count >> 1);
+                        numPrimitives = (count >> 1);
                         break;
                     case 0x0002: //LINE_LOOP
-                        this.primitives += count;
+                        numPrimitives = count;
                         break;
                     case 0x0003: //LINE_STRIP
-                        this.primitives += count - 1;
+                        numPrimitives = count - 1;
                         break;
                     case 0x0004: //TRIANGLES
-                        this.primitives += (count / 3) | 0;
+                        numPrimitives = (count / 3) | 0;
                         break;
                     case 0x0005: //TRIANGLE_STRIP
-                        this.primitives += count - 2;
+                        numPrimitives = count - 2;
                         break;
                     case 0x0006: //TRIANGLE_FAN
-                        this.primitives += count - 2;
+                        numPrimitives = count - 2;
                         break;
                     }
+                    if (numInstances)
+                    {
+                        numPrimitives *= numInstances;
+                    }
+                    this.primitives += numPrimitives;
                 }
             };
         }
@@ -0,0 +1,297 @@
+// Copyright (c) 2014 Turbulenz Limited
+/*global TurbulenzEngine*/
+/*global Uint8Array*/
+/*global Float32Array*/
+/*global window*/
+
+"use strict";
+
+// PCM samples of a WAV file, decoded a chunk at a time by the streaming sources
+interface SoundDecoderSource
+{
+    data          : Uint8Array; // the whole file
+    dataOffset    : number;     // first byte of the samples
+    format        : number;     // 1 for integer samples, 3 for float samples
+    bitsPerSample : number;
+    blockAlign    : number;     // bytes per frame
+    channels      : number;
+    frequency     : number;
+    numFrames     : number;
+};
+
+interface SoundDecoderOnDecodedFn
+{
+    (data: Float32Array, decodeTime: number): void;
+};
+
+//
+// SoundDecoder
+//
+class SoundDecoder
+{
+    static version = 1;
+
+    static maxNumWorkers = (typeof Worker !== "undefined" &&
+                            typeof Blob !== "undefined" &&
+                            (typeof URL !== "undefined" || typeof window['webkitURL'] !== "undefined") ? 1 : 0);
+    static workerQueue: SoundDecoderOnDecodedFn[] = null;
+    static worker: Worker = null;
+
+    // Returns the layout of the samples of a WAV file, or null if the file
+    // is not a WAV file or its samples are not plain PCM
+    static parseWAV(data: Uint8Array): SoundDecoderSource
+    {
+        function readUint16(n)
+        {
+            /* tslint:disable:no-bitwise */
+            return (data[n] | (data[n + 1] << 8));
+            /* tslint:enable:no-bitwise */
+        }
+
+        function readUint32(n)
+        {
+            /* tslint:disable:no-bitwise */
+            return ((data[n] | (data[n + 1] << 8) | (data[n + 2] << 16) | (data[n + 3] << 24)) >>> 0);
+            /* tslint:enable:no-bitwise */
+        }
+
+        function isTag(n, tag)
+        {
+            return (data[n] === tag.charCodeAt(0) &&
+                    data[n + 1] === tag.charCodeAt(1) &&
+                    data[n + 2] === tag.charCodeAt(2) &&
+                    data[n + 3] === tag.charCodeAt(3));
+        }
+
+        var length = data.length;
+        if (length < 12 ||
+            !isTag(0, 'RIFF') ||
+            !isTag(8, 'WAVE'))
+        {
+            return null;
+        }
+
+        var format = 0, channels = 0, frequency = 0, blockAlign = 0, bitsPerSample = 0;
+        var n = 12;
+        while ((n + 8) <= length)
+        {
+            var chunkSize = readUint32(n + 4);
+            if (isTag(n, 'fmt ') && 16 <= chunkSize)
+            {
+                format = readUint16(n + 8);
+                channels = readUint16(n + 10);
+                frequency = readUint32(n + 12);
+                blockAlign = readUint16(n + 20);
+                bitsPerSample = readUint16(n + 22);
+                // WAVE_FORMAT_EXTENSIBLE keeps the format in its sub format GUID
+                if (format === 0xfffe && 26 <= chunkSize)
+                {
+                    format = readUint16(n + 32);
+                }
+            }
+            else if (isTag(n, 'data'))
+            {
+                if (!channels ||
+                    !frequency ||
+                    blockAlign < (channels * (bitsPerSample / 8)) ||
+                    !((format === 1 && (bitsPerSample === 8 ||
+                                        bitsPerSample === 16 ||
+                                        bitsPerSample === 24 ||
+                                        bitsPerSample === 32)) ||
+                      (format === 3 && bitsPerSample === 32)))
+                {
+                    return null;
+                }
+
+                var dataLength = Math.min(chunkSize, (length - (n + 8)));
+                return {
+                    data: data,
+                    dataOffset: (n + 8),
+                    format: format,
+                    bitsPerSample: bitsPerSample,
+                    blockAlign: blockAlign,
+                    channels: channels,
+                    frequency: frequency,
+                    numFrames: Math.floor(dataLength / blockAlign)
+                };
+            }
+            /* tslint:disable:no-bitwise */
+            n += (8 + chunkSize + (chunkSize & 1));
+            /* tslint:enable:no-bitwise */
+        }
+        return null;
+    }
+
+    // Converts interleaved PCM frames into planar floats, one block of
+    // numFrames values per channel. Also runs inside the worker so it
+    // can not reference anything outside of it.
+    static decodePCM(data: Uint8Array, format: number, bitsPerSample: number,
+                     blockAlign: number, channels: number, numFrames: number): Float32Array
+    {
+        var output = new Float32Array(channels * numFrames);
+        var view = new DataView(data.buffer, data.byteOffset, data.byteLength);
+        var bytesPerSample = (bitsPerSample / 8);
+        var c, f, offset, value;
+        for (c = 0; c < channels; c += 1)
+        {
+            var dst = (c * numFrames);
+            offset = (c * bytesPerSample);
+            if (format === 3)
+            {
+                for (f = 0; f < numFrames; f += 1, offset += blockAlign)
+                {
+                    output[dst + f] = view.getFloat32(offset, true);
+                }
+            }
+            else if (bitsPerSample === 16)
+            {
+                for (f = 0; f < numFrames; f += 1, offset += blockAlign)
+                {
+                    output[dst + f] = (view.getInt16(offset, true) / 32768);
+                }
+            }
+            else if (bitsPerSample === 8)
+            {
+                for (f = 0; f < numFrames; f += 1, offset += blockAlign)
+                {
+                    output[dst + f] = ((view.getUint8(offset) - 128) / 128);
+                }
+            }
+            else if (bitsPerSample === 24)
+            {
+                for (f = 0; f < numFrames; f += 1, offset += blockAlign)
+                {
+                    value = (view.getUint8(offset) +
+                             (view.getUint8(offset + 1) * 256) +
+                             (view.getInt8(offset + 2) * 65536));
+                    output[dst + f] = (value / 8388608);
+                }
+            }
+            else
+            {
+                for (f = 0; f < numFrames; f += 1, offset += blockAlign)
+                {
+                    output[dst + f] = (view.getInt32(offset, true) / 2147483648);
+                }
+            }
+        }
+        return output;
+    }
+
+    static createWorker(): Worker
+    {
+        var code = "var decodePCM = " + this.decodePCM.toString() + ";\n" +
+           "var now = (typeof performance !== 'undefined' && performance.now ?\n" +
+           "           function () { return performance.now(); } :\n" +
+           "           function () { return Date.now(); });\n" +
+           "var command;\n" +
+           "onmessage = function decoderOnMessage(event)\n" +
+           "{\n" +
+           "    var edata = event.data;\n" +
+           "    if (edata instanceof ArrayBuffer)\n" +
+           "    {\n" +
+           "        var startTime = now();\n" +
+           "        var data = decodePCM(new Uint8Array(edata), command.format, command.bitsPerSample,\n" +
+           "                             command.blockAlign, command.channels, command.numFrames);\n" +
+           "        postMessage({ data: data.buffer, decodeTime: (now() - startTime) }, [data.buffer]);\n" +
+           "    }\n" +
+           "    else\n" +
+           "    {\n" +
+           "        command = edata;\n" +
+           "    }\n" +
+           "};";
+        var blob = new Blob([code], { type: "text/javascript" });
+
+        var url = (typeof URL !== "undefined" ? URL : window['webkitURL']);
+        var objectURL = url.createObjectURL(blob);
+
+        var worker;
+        try
+        {
+            worker = new Worker(objectURL);
+        }
+        catch (e)
+        {
+            worker = null;
+        }
+        if (worker)
+        {
+            var workerQueue = SoundDecoder.workerQueue;
+            worker.onmessage = function (event)
+            {
+                var ondecoded = workerQueue.shift();
+                var edata = event.data;
+                ondecoded(new Float32Array(edata.data), edata.decodeTime);
+            };
+            // A chunk that throws while decoding fails on its own, the
+            // worker keeps decoding the following ones
+            worker.onerror = function (event)
+            {
+                event.preventDefault();
+                var ondecoded = workerQueue.shift();
+                if (ondecoded)
+                {
+                    ondecoded(null, 0);
+                }
+            };
+        }
+
+        url.revokeObjectURL(objectURL);
+
+        return worker;
+    }
+
+    // Decodes numFrames frames starting at firstFrame. Chunks are decoded in
+    // order by a worker when available, otherwise the callback is called
+    // before returning. The callback gets null data if the decode failed.
+    static decode(source: SoundDecoderSource, firstFrame: number, numFrames: number,
+                  ondecoded: SoundDecoderOnDecodedFn): void
+    {
+        var data = source.data;
+        var start = (data.byteOffset + source.dataOffset + (firstFrame * source.blockAlign));
+        var end = (start + (numFrames * source.blockAlign));
+
+        if (this.maxNumWorkers)
+        {
+            var worker = this.worker;
+            if (!worker)
+            {
+                this.workerQueue = [];
+                this.worker = worker = this.createWorker();
+            }
+
+            if (worker)
+            {
+                this.workerQueue.push(ondecoded);
+
+                // First post the command (structural copy)
+                worker.postMessage({
+                    format: source.format,
+                    bitsPerSample: source.bitsPerSample,
+                    blockAlign: source.blockAlign,
+                    channels: source.channels,
+                    numFrames: numFrames
+                });
+
+                // Then post a copy of the chunk (ownership transfer)
+                var buffer = data.buffer.slice(start, end);
+                worker.postMessage(buffer, [buffer]);
+
+                return;
+            }
+            else
+            {
+                this.maxNumWorkers = 0;
+            }
+        }
+
+        var startTime = TurbulenzEngine.getTime();
+        var output = this.decodePCM(new Uint8Array(data.buffer, start, (end - start)),
+                                    source.format,
+                                    source.bitsPerSample,
+                                    source.blockAlign,
+                                    source.channels,
+                                    numFrames);
+        ondecoded(output, (TurbulenzEngine.getTime() - startTime));
+    }
+}
@@ -1,6 +1,7 @@
 // Copyright (c) 2011-2014 Turbulenz Limited
 /*global TurbulenzEngine: false*/
 /*global SoundTARLoader: false*/
+/*global SoundDecoder: false*/
 /*global Audio: false*/
 /*global VMath: false*/
 /*global window: false*/
@@ -18,13 +19,22 @@ interface WebGLSoundDeviceSourceMap
     [id: string] : boolean;
 };
 
+interface WebGLSoundDeviceMetrics
+{
+    numDecodes : number;
+    decodeTime : number; // milliseconds
+    evictions  : number;
+    pcmBytes   : number; // decoded sounds resident in memory
+    streamBytes: number; // buffers of the playing streams
+};
+
 //
 // WebGLSound
 //
 class WebGLSound implements Sound
 {
     /* tslint:disable:no-unused-variable */
-    static version = 1;
+    static version = 2;
     /* tslint:enable:no-unused-variable */
 
     // Sound
@@ -41,6 +51,13 @@ class WebGLSound implements Sound
     blob         : Blob;
     url          : string;
 
+    sd           : WebGLSoundDevice;
+    stream       : SoundDecoderSource; // decoded in chunks while playing
+    encodedData  : ArrayBuffer; // kept to decode the sound again once evicted
+    pcmBytes     : number;
+    lastPlayed   : number;
+    restoringSources : WebGLSoundGlobalSource[];
+
     // on prototype
     forceUncompress: boolean;
     audioContext : any; // TODO
@@ -57,12 +74,25 @@ class WebGLSound implements Sound
         this.data = null;
         this.blob = null;
         this.url = null;
+        this.sd = null;
+        this.stream = null;
+        this.encodedData = null;
+        this.pcmBytes = 0;
+        this.lastPlayed = 0;
+        this.restoringSources = null;
     }
 
     destroy()
     {
+        if (this.sd && this.buffer)
+        {
+            this.sd._removeDecodedSound(this);
+        }
         this.buffer = null;
         this.data = null;
+        this.stream = null;
+        this.encodedData = null;
+        this.restoringSources = null;
         if (this.blob)
         {
             URL.revokeObjectURL(this.url);
@@ -349,6 +379,133 @@ class WebGLSound implements Sound
         }
     }
 
+    // Decodes the whole file into an AudioBuffer, the sources that try to
+    // play the sound meanwhile start once it is decoded
+    _decode(sd: WebGLSoundDevice, data: ArrayBuffer, onload: { (sound: Sound, status: number): void; })
+    {
+        var sound = this;
+        var audioContext = sd.audioContext;
+
+        // decodeAudioData takes ownership of the data, keep a copy to be
+        // able to decode the sound again if evicted to fit the budget
+        if (sd.maxDecodedBytes && !this.encodedData)
+        {
+            this.encodedData = data.slice(0);
+        }
+
+        if (!this.restoringSources)
+        {
+            this.restoringSources = [];
+        }
+
+        var startTime = TurbulenzEngine.getTime();
+
+        var bufferCreated = function bufferCreatedFn(buffer)
+        {
+            var sources = sound.restoringSources;
+            var numSources = (sources ? sources.length : 0);
+            var n;
+            sound.restoringSources = null;
+
+            if (buffer)
+            {
+                sound.buffer = buffer;
+                sound.frequency = buffer.sampleRate;
+                sound.channels = buffer.numberOfChannels;
+                sound.bitrate = (sound.frequency * sound.channels * 2 * 8);
+                sound.length = buffer.duration;
+
+                var metrics = sd.metrics;
+                metrics.numDecodes += 1;
+                metrics.decodeTime += (TurbulenzEngine.getTime() - startTime);
+
+                sd._addDecodedSound(sound);
+
+                for (n = 0; n < numSources; n += 1)
+                {
+                    sources[n]._soundRestored(sound);
+                }
+
+                if (onload)
+                {
+                    onload(sound, 200);
+                }
+            }
+            else
+            {
+                for (n = 0; n < numSources; n += 1)
+                {
+                    var source = sources[n];
+                    if (source.sound === sound)
+                    {
+                        source.stop();
+                    }
+                }
+
+                if (onload)
+                {
+                    onload(null, 0);
+                }
+            }
+        };
+
+        var bufferFailed = function bufferFailedFn()
+        {
+            bufferCreated(null);
+        };
+
+        if (audioContext.decodeAudioData)
+        {
+            audioContext.decodeAudioData(data, bufferCreated, bufferFailed);
+        }
+        else
+        {
+            bufferCreated(audioContext.createBuffer(data, false));
+        }
+    }
+
+    // Decodes again a sound evicted to fit the memory budget
+    _restore(source: WebGLSoundGlobalSource): boolean
+    {
+        var restoringSources = this.restoringSources;
+        if (restoringSources)
+        {
+            if (restoringSources.indexOf(source) === -1)
+            {
+                restoringSources.push(source);
+            }
+        }
+        else if (this.encodedData && this.sd)
+        {
+            this.restoringSources = [source];
+            this._decode(this.sd, this.encodedData.slice(0), null);
+        }
+        else
+        {
+            return false;
+        }
+        return true;
+    }
+
+    // Keeps the PCM samples of a WAV file to be decoded in chunks while
+    // playing, returns false if the file can not be streamed that way
+    _initializeStream(sd: WebGLSoundDevice, data: ArrayBuffer): boolean
+    {
+        var stream = SoundDecoder.parseWAV(new Uint8Array(data));
+        if (!stream || !stream.numFrames)
+        {
+            return false;
+        }
+
+        this.sd = sd;
+        this.stream = stream;
+        this.frequency = stream.frequency;
+        this.channels = stream.channels;
+        this.bitrate = (stream.frequency * stream.blockAlign * 8);
+        this.length = (stream.numFrames / stream.frequency);
+        return true;
+    }
+
     static create(sd: WebGLSoundDevice, params: SoundParameters): WebGLSound
     {
         var sound = new WebGLSound(params);
@@ -356,8 +513,12 @@ class WebGLSound implements Sound
         var soundPath = params.src;
         var onload = params.onload;
         var data = params.data;
+
+        // WAV files are streamed by decoding their samples in chunks,
+        // other formats are streamed by media elements when available
+        var stream = (params.stream && sd.audioContext && soundPath ? true : false);
         var uncompress = (sound.forceUncompress ||
-                          params.uncompress ||
+                          (stream ? (soundPath.slice(-3).toLowerCase() === "wav") : params.uncompress) ||
                           (!soundPath && data));
 
         sound.compressed = (!uncompress);
@@ -380,16 +541,10 @@ class WebGLSound implements Sound
                     return null;
                 }
 
-                var bufferCreated = function bufferCreatedFn(buffer)
+                var dataLoaded = function dataLoadedFn(data: ArrayBuffer)
                 {
-                    if (buffer)
+                    if (stream && sound._initializeStream(sd, data))
                     {
-                        sound.buffer = buffer;
-                        sound.frequency = buffer.sampleRate;
-                        sound.channels = buffer.numberOfChannels;
-                        sound.bitrate = (sound.frequency * sound.channels * 2 * 8);
-                        sound.length = buffer.duration;
-
                         if (onload)
                         {
                             onload(sound, 200);
@@ -397,32 +552,13 @@ class WebGLSound implements Sound
                     }
                     else
                     {
-                        if (onload)
-                        {
-                            onload(null, 0);
-                        }
-                    }
-                };
-
-                var bufferFailed = function bufferFailedFn()
-                {
-                    if (onload)
-                    {
-                        onload(null, 0);
+                        sound._decode(sd, data, onload);
                     }
                 };
 
                 if (data)
                 {
-                    if (audioContext.decodeAudioData)
-                    {
-                        audioContext.decodeAudioData(data, bufferCreated, bufferFailed);
-                    }
-                    else
-                    {
-                        buffer = audioContext.createBuffer(data, false);
-                        bufferCreated(buffer);
-                    }
+                    dataLoaded(data);
                 }
                 else
                 {
@@ -466,15 +602,7 @@ class WebGLSound implements Sound
                                 }
                                 else if (xhrStatus === 200 || xhrStatus === 0)
                                 {
-                                    if (audioContext.decodeAudioData)
-                                    {
-                                        audioContext.decodeAudioData(response, bufferCreated, bufferFailed);
-                                    }
-                                    else
-                                    {
-                                        var buffer = audioContext.createBuffer(response, false);
-                                        bufferCreated(buffer);
-                                    }
+                                    dataLoaded(response);
                                 }
                                 else
                                 {
@@ -551,6 +679,8 @@ class WebGLSound implements Sound
                         sound.bitrate = (samplerRate * numChannels * 2 * 8);
                         sound.length = (numSamples / (samplerRate * numChannels));
 
+                        sd._addDecodedSound(sound);
+
                         if (onload)
                         {
                             onload(sound, 200);
@@ -701,13 +831,251 @@ class WebGLSound implements Sound
     }
 }
 
+//
+// WebGLSoundStream
+//
+// Plays a WAV file through a fixed ring of AudioBuffers, decoding each chunk
+// of samples just before it is scheduled so only a few seconds of PCM are
+// ever resident. Pitch is not applied to streamed sounds.
+class WebGLSoundStream
+{
+    /* tslint:disable:no-unused-variable */
+    static version = 1;
+    /* tslint:enable:no-unused-variable */
+
+    sd          : WebGLSoundDevice;
+    source      : WebGLSoundGlobalSource;
+    decoder     : SoundDecoderSource;
+    chunkFrames : number;
+    buffers     : any[]; // AudioBuffer
+    bufferNodes : any[]; // AudioBufferSourceNode
+    bufferEnds  : number[]; // context time when each buffer stops playing, -1 free, 0 decoding
+    nextBuffer  : number;
+    nextFrame   : number;
+    nextTime    : number;
+    numBytes    : number;
+    generation  : number;
+
+    update(currentTime: number): boolean
+    {
+        var buffers = this.buffers;
+        var bufferNodes = this.bufferNodes;
+        var bufferEnds = this.bufferEnds;
+        var numBuffers = buffers.length;
+        var numActive = 0;
+        var n;
+        for (n = 0; n < numBuffers; n += 1)
+        {
+            var end = bufferEnds[n];
+            if (0 < end && end <= currentTime)
+            {
+                bufferEnds[n] = -1;
+                bufferNodes[n].disconnect();
+                bufferNodes[n] = null;
+            }
+            else if (0 <= end)
+            {
+                numActive += 1;
+            }
+        }
+
+        var source = this.source;
+        var looping = source._looping;
+        var decoder = this.decoder;
+        var numFrames = decoder.numFrames;
+        while (bufferEnds[this.nextBuffer] < 0 &&
+               (looping || this.nextFrame < numFrames))
+        {
+            this._requestChunk();
+            numActive += 1;
+        }
+
+        var length = (numFrames / decoder.frequency);
+        if (looping && length < (currentTime - source.playStart))
+        {
+            source.playStart += length;
+        }
+
+        return (0 < numActive);
+    }
+
+    _requestChunk(): void
+    {
+        var decoder = this.decoder;
+        var numFrames = decoder.numFrames;
+        if (numFrames <= this.nextFrame)
+        {
+            this.nextFrame = 0;
+        }
+
+        var index = this.nextBuffer;
+        var firstFrame = this.nextFrame;
+        var chunkFrames = Math.min(this.chunkFrames, (numFrames - firstFrame));
+
+        this.bufferEnds[index] = 0;
+        this.nextBuffer = ((index + 1) % this.buffers.length);
+        this.nextFrame = (firstFrame + chunkFrames);
+
+        var stream = this;
+        var generation = this.generation;
+        SoundDecoder.decode(decoder, firstFrame, chunkFrames,
+                            function chunkDecodedFn(data: Float32Array, decodeTime: number)
+                            {
+                                if (stream.generation === generation)
+                                {
+                                    if (data)
+                                    {
+                                        stream._scheduleChunk(index, data, chunkFrames, decodeTime);
+                                    }
+                                    else
+                                    {
+                                        // Skip the chunk and free its buffer for the next one
+                                        stream.bufferEnds[index] = -1;
+                                    }
+                                }
+                            });
+    }
+
+    _scheduleChunk(index: number, data: Float32Array, numFrames: number, decodeTime: number): void
+    {
+        var decoder = this.decoder;
+        var buffer = this.buffers[index];
+        var numChannels = decoder.channels;
+        var c;
+        for (c = 0; c < numChannels; c += 1)
+        {
+            var channelData = data.subarray((c * numFrames), ((c + 1) * numFrames));
+            if (buffer.copyToChannel)
+            {
+                buffer.copyToChannel(channelData, c);
+            }
+            else
+            {
+                buffer.getChannelData(c).set(channelData);
+            }
+        }
+
+        var metrics = this.sd.metrics;
+        metrics.numDecodes += 1;
+        metrics.decodeTime += decodeTime;
+
+        var source = this.source;
+        var audioContext = source.audioContext;
+        var currentTime = audioContext.currentTime;
+        var when = this.nextTime;
+        if (when < currentTime)
+        {
+            // Underrun or first chunk, delay the rest of the stream
+            source.playStart += (currentTime - when);
+            when = currentTime;
+        }
+
+        var duration = (numFrames / decoder.frequency);
+
+        var bufferNode = audioContext.createBufferSource();
+        bufferNode.buffer = buffer;
+        bufferNode.connect(source._gainNode);
+        if (bufferNode.start)
+        {
+            bufferNode.start(when, 0, duration);
+        }
+        else
+        {
+            bufferNode.noteGrainOn(when, 0, duration);
+        }
+
+        this.bufferNodes[index] = bufferNode;
+        this.bufferEnds[index] = (when + duration);
+        this.nextTime = (when + duration);
+    }
+
+    destroy(): void
+    {
+        this.generation += 1;
+
+        var bufferNodes = this.bufferNodes;
+        if (bufferNodes)
+        {
+            var numBuffers = bufferNodes.length;
+            var n;
+            for (n = 0; n < numBuffers; n += 1)
+            {
+                var bufferNode = bufferNodes[n];
+                if (bufferNode)
+                {
+                    bufferNodes[n] = null;
+                    if (bufferNode.stop)
+                    {
+                        bufferNode.stop(0);
+                    }
+                    else
+                    {
+                        bufferNode.noteOff(0);
+                    }
+                    bufferNode.disconnect();
+                }
+            }
+            this.bufferNodes = null;
+        }
+
+        if (this.buffers)
+        {
+            this.sd.metrics.streamBytes -= this.numBytes;
+            this.numBytes = 0;
+            this.buffers = null;
+        }
+
+        this.source = null;
+        this.decoder = null;
+    }
+
+    static create(sd: WebGLSoundDevice, source: WebGLSoundGlobalSource,
+                  sound: WebGLSound, seek: number): WebGLSoundStream
+    {
+        var stream = new WebGLSoundStream();
+        var decoder = sound.stream;
+        var audioContext = sd.audioContext;
+
+        var numBuffers = sd.streamNumBuffers;
+        var chunkFrames = Math.max(1, Math.min(Math.ceil(sd.streamChunkDuration * decoder.frequency),
+                                               decoder.numFrames));
+
+        stream.sd = sd;
+        stream.source = source;
+        stream.decoder = decoder;
+        stream.chunkFrames = chunkFrames;
+        stream.buffers = [];
+        stream.bufferNodes = [];
+        stream.bufferEnds = [];
+        stream.nextBuffer = 0;
+        stream.nextFrame = Math.min(Math.floor(seek * decoder.frequency), decoder.numFrames);
+        stream.nextTime = audioContext.currentTime;
+        stream.numBytes = (numBuffers * chunkFrames * decoder.channels * 4);
+        stream.generation = 0;
+
+        var n;
+        for (n = 0; n < numBuffers; n += 1)
+        {
+            stream.buffers[n] = audioContext.createBuffer(decoder.channels, chunkFrames, decoder.frequency);
+            stream.bufferNodes[n] = null;
+            stream.bufferEnds[n] = -1;
+        }
+
+        sd.metrics.streamBytes += stream.numBytes;
+
+        stream.update(stream.nextTime);
+
+        return stream;
+    }
+}
+
 //
 // WebGLSoundGlobalSource
 //
 class WebGLSoundGlobalSource implements SoundGlobalSource
 {
     /* tslint:disable:no-unused-variable */
-    static version = 1;
+    static version = 2;
     /* tslint:enable:no-unused-variable */
 
     // SoundGlobalSource
@@ -727,6 +1095,7 @@ class WebGLSoundGlobalSource implements SoundGlobalSource
     sound: WebGLSound;
     audioContext: any; // window.AudioContext || window.webkitAudioContext
     bufferNode: any; // window.AudioContext.createbufferSource()
+    stream: WebGLSoundStream;
     mediaNode: any; // window.AudioContext.createMediaElementSource()
     playStart: number;
     playPaused: number;
@@ -756,29 +1125,13 @@ class WebGLSoundGlobalSource implements SoundGlobalSource
 
         this.sound = <WebGLSound>sound;
 
-        var audioContext = this.audioContext;
-
-        if ((<WebGLSound>sound).buffer)
+        // Decoded, streamed or waiting to be decoded, anything but media elements
+        if (this.audioContext && !(<WebGLSound>sound).url)
         {
-            var bufferNode = this._createBufferNode(<WebGLSound>sound);
-
-            if (0 < seek)
+            if (!this._startBufferNode(seek))
             {
-                var buffer = (<WebGLSound>sound).buffer;
-                if (bufferNode.loop)
-                {
-                    bufferNode.start(0, seek, buffer.duration);
-                }
-                else
-                {
-                    bufferNode.start(0, seek, (buffer.duration - seek));
-                }
-                this.playStart = (audioContext.currentTime - seek);
-            }
-            else
-            {
-                bufferNode.start(0);
-                this.playStart = audioContext.currentTime;
+                this.sound = null;
+                return false;
             }
         }
         else
@@ -871,13 +1224,7 @@ class WebGLSoundGlobalSource implements SoundGlobalSource
         }
         else
         {
-            var bufferNode = this.bufferNode;
-            if (bufferNode)
-            {
-                this.bufferNode = null;
-                bufferNode.stop(0);
-                bufferNode.disconnect();
-            }
+            this._stopBufferNode();
         }
     }
 
@@ -906,16 +1253,10 @@ class WebGLSoundGlobalSource implements SoundGlobalSource
                 {
                     audio.pause();
                 }
-                else
+                else if (this.audioContext)
                 {
-                    var bufferNode = this.bufferNode;
-                    if (bufferNode)
-                    {
-                        this.bufferNode = null;
-                        this.playPaused = this.audioContext.currentTime;
-                        bufferNode.stop(0);
-                        bufferNode.disconnect();
-                    }
+                    this.playPaused = this.audioContext.currentTime;
+                    this._stopBufferNode();
                 }
 
                 this.sd.removePlayingSource(this);
@@ -955,33 +1296,17 @@ class WebGLSoundGlobalSource implements SoundGlobalSource
             }
             else
             {
-                var audioContext = this.audioContext;
-                if (audioContext)
+                if (this.audioContext)
                 {
                     if (seek === undefined)
                     {
                         seek = (this.playPaused - this.playStart);
                     }
 
-                    var bufferNode = this._createBufferNode(this.sound);
-
-                    if (0 < seek)
+                    if (!this._startBufferNode(seek))
                     {
-                        var buffer = this.sound.buffer;
-                        if (bufferNode.loop)
-                        {
-                            bufferNode.start(0, seek, buffer.duration);
-                        }
-                        else
-                        {
-                            bufferNode.start(0, seek, (buffer.duration - seek));
-                        }
-                        this.playStart = (audioContext.currentTime - seek);
-                    }
-                    else
-                    {
-                        bufferNode.start(0);
-                        this.playStart = audioContext.currentTime;
+                        this.stop();
+                        return false;
                     }
                 }
             }
@@ -1007,21 +1332,10 @@ class WebGLSoundGlobalSource implements SoundGlobalSource
             }
             else
             {
-                var audioContext = this.audioContext;
-                if (audioContext)
+                if (this.audioContext)
                 {
-                    var bufferNode = this.bufferNode;
-                    if (bufferNode)
-                    {
-                        bufferNode.stop(0);
-                        bufferNode.disconnect();
-                    }
-
-                    bufferNode = this._createBufferNode(this.sound);
-
-                    bufferNode.start(0);
-
-                    this.playStart = audioContext.currentTime;
+                    this._stopBufferNode();
+                    this._startBufferNode(0);
 
                     return true;
                 }
@@ -1058,36 +1372,10 @@ class WebGLSoundGlobalSource implements SoundGlobalSource
                 }
                 else
                 {
-                    var audioContext = this.audioContext;
-                    if (audioContext)
+                    if (this.audioContext)
                     {
-                        var bufferNode = this.bufferNode;
-                        if (bufferNode)
-                        {
-                            bufferNode.stop(0);
-                            bufferNode.disconnect();
-                        }
-
-                        bufferNode = this._createBufferNode(this.sound);
-
-                        if (0 < seek)
-                        {
-                            var buffer = this.sound.buffer;
-                            if (bufferNode.loop)
-                            {
-                                bufferNode.start(0, seek, buffer.duration);
-                            }
-                            else
-                            {
-                                bufferNode.start(0, seek, (buffer.duration - seek));
-                            }
-                            this.playStart = (audioContext.currentTime - seek);
-                        }
-                        else
-                        {
-                            bufferNode.start(0);
-                            this.playStart = audioContext.currentTime;
-                        }
+                        this._stopBufferNode();
+                        this._startBufferNode(seek);
                     }
                 }
             }
@@ -1169,8 +1457,107 @@ class WebGLSoundGlobalSource implements SoundGlobalSource
         return bufferNode;
     }
 
+    _startBufferNode(seek: number): boolean
+    {
+        var sound = this.sound;
+        var currentTime = this.audioContext.currentTime;
+
+        sound.lastPlayed = currentTime;
+
+        this.playStart = (currentTime - seek);
+
+        if (sound.stream)
+        {
+            this.stream = WebGLSoundStream.create(this.sd, this, sound, seek);
+        }
+        else if (sound.buffer)
+        {
+            var bufferNode = this._createBufferNode(sound);
+
+            if (0 < seek)
+            {
+                var buffer = sound.buffer;
+                if (bufferNode.loop)
+                {
+                    bufferNode.start(0, seek, buffer.duration);
+                }
+                else
+                {
+                    bufferNode.start(0, seek, (buffer.duration - seek));
+                }
+            }
+            else
+            {
+                bufferNode.start(0);
+            }
+        }
+        else
+        {
+            // Not decoded yet or evicted to fit the memory budget,
+            // playback starts from the elapsed time once decoded
+            return sound._restore(this);
+        }
+
+        return true;
+    }
+
+    _stopBufferNode(): void
+    {
+        var bufferNode = this.bufferNode;
+        if (bufferNode)
+        {
+            this.bufferNode = null;
+            bufferNode.stop(0);
+            bufferNode.disconnect();
+        }
+
+        var stream = this.stream;
+        if (stream)
+        {
+            this.stream = null;
+            stream.destroy();
+        }
+    }
+
+    _soundRestored(sound: WebGLSound): void
+    {
+        if (this.sound === sound &&
+            this.playing &&
+            !this.paused &&
+            !this.bufferNode)
+        {
+            var seek = (this.audioContext.currentTime - this.playStart);
+            if (this._looping)
+            {
+                seek = (seek % sound.length);
+            }
+            else if (sound.length <= seek)
+            {
+                this.stop();
+                return;
+            }
+            this._startBufferNode(seek);
+        }
+    }
+
     _checkBufferNode(currentTime: number): boolean
     {
+        var stream = this.stream;
+        if (stream)
+        {
+            if (!stream.update(currentTime))
+            {
+                this.stream = null;
+                stream.destroy();
+                this.playing = false;
+                this.sound = null;
+
+                return false;
+            }
+
+            return true;
+        }
+
         var bufferNode = this.bufferNode;
         if (bufferNode)
         {
@@ -1218,6 +1605,7 @@ class WebGLSoundGlobalSource implements SoundGlobalSource
         if (audioContext)
         {
             source.bufferNode = null;
+            source.stream = null;
             source.mediaNode = null;
             source.playStart = -1;
             source.playPaused = -1;
@@ -1291,7 +1679,7 @@ class WebGLSoundGlobalSource implements SoundGlobalSource
 class WebGLSoundSource extends WebGLSoundGlobalSource implements SoundSource
 {
     /* tslint:disable:no-unused-variable */
-    static version = 1;
+    static version = 2;
     /* tslint:enable:no-unused-variable */
 
     // SoundSource
@@ -1424,6 +1812,7 @@ class WebGLSoundSource extends WebGLSoundGlobalSource implements SoundSource
         if (audioContext)
         {
             source.bufferNode = null;
+            source.stream = null;
             source.mediaNode = null;
             source.playStart = -1;
             source.playPaused = -1;
@@ -1563,7 +1952,7 @@ interface WebGLAudioPoolItem
 class WebGLSoundDevice implements SoundDevice
 {
     /* tslint:disable:no-unused-variable */
-    static version = 1;
+    static version = 2;
     /* tslint:enable:no-unused-variable */
 
     // SoundDevice
@@ -1602,6 +1991,12 @@ class WebGLSoundDevice implements SoundDevice
     supportedExtensions  : WebGLSoundDeviceExtensions;
     _audioPool: WebGLAudioPoolItem[];
 
+    maxDecodedBytes      : number;
+    streamChunkDuration  : number;
+    streamNumBuffers     : number;
+    metrics              : WebGLSoundDeviceMetrics;
+    _decodedSounds       : WebGLSound[]; // can be decoded again if evicted
+
 
     update: { (): void; };
 
@@ -1847,6 +2242,92 @@ class WebGLSoundDevice implements SoundDevice
         }
     }
 
+    resetMetrics(): void
+    {
+        var metrics = this.metrics;
+        metrics.numDecodes = 0;
+        metrics.decodeTime = 0;
+        metrics.evictions = 0;
+    }
+
+    _addDecodedSound(sound: WebGLSound): void
+    {
+        var buffer = sound.buffer;
+        sound.sd = this;
+        sound.pcmBytes = (buffer.length * buffer.numberOfChannels * 4);
+        this.metrics.pcmBytes += sound.pcmBytes;
+
+        if (sound.encodedData)
+        {
+            this._decodedSounds.push(sound);
+        }
+
+        if (this.maxDecodedBytes)
+        {
+            this._enforceDecodedBudget(sound);
+        }
+    }
+
+    _removeDecodedSound(sound: WebGLSound): void
+    {
+        this.metrics.pcmBytes -= sound.pcmBytes;
+        sound.pcmBytes = 0;
+
+        var decodedSounds = this._decodedSounds;
+        var index = decodedSounds.indexOf(sound);
+        if (index !== -1)
+        {
+            decodedSounds.splice(index, 1);
+        }
+    }
+
+    // Releases the decoded samples of the least recently played sounds
+    // until the total fits maxDecodedBytes, they are decoded again from
+    // their encoded data the next time they are played
+    _enforceDecodedBudget(keep: WebGLSound): void
+    {
+        var metrics = this.metrics;
+        var maxDecodedBytes = this.maxDecodedBytes;
+        var decodedSounds = this._decodedSounds;
+        var playingSources = this.playingSources;
+        var numPlayingSources = this.numPlayingSources;
+        var n, s;
+
+        while (maxDecodedBytes < metrics.pcmBytes)
+        {
+            var oldest = null;
+            var numSounds = decodedSounds.length;
+            for (n = 0; n < numSounds; n += 1)
+            {
+                var sound = decodedSounds[n];
+                if (sound !== keep &&
+                    (!oldest || sound.lastPlayed < oldest.lastPlayed))
+                {
+                    for (s = 0; s < numPlayingSources; s += 1)
+                    {
+                        if (playingSources[s].sound === sound)
+                        {
+                            break;
+                        }
+                    }
+                    if (s === numPlayingSources)
+                    {
+                        oldest = sound;
+                    }
+                }
+            }
+
+            if (!oldest)
+            {
+                break;
+            }
+
+            this._removeDecodedSound(oldest);
+            oldest.buffer = null;
+            metrics.evictions += 1;
+        }
+    }
+
     isResourceSupported(soundPath)
     {
         var extension = soundPath.slice(-3).toLowerCase();
@@ -1955,6 +2436,18 @@ class WebGLSoundDevice implements SoundDevice
 
         sd.lastSourceID = 0;
 
+        sd.maxDecodedBytes = (params.maxDecodedBytes || 0);
+        sd.streamChunkDuration = (params.streamChunkDuration || 0.5);
+        sd.streamNumBuffers = Math.max(2, (params.streamNumBuffers || 4));
+        sd.metrics = {
+            numDecodes: 0,
+            decodeTime: 0,
+            evictions: 0,
+            pcmBytes: 0,
+            streamBytes: 0
+        };
+        sd._decodedSounds = [];
+
         var AudioContextConstructor;
 
         if (sd.deviceSpecifier !== "audioelement")
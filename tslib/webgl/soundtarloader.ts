@@ -2,6 +2,7 @@
 
 /*global TurbulenzEngine*/
 /*global Uint8Array*/
+/*global WebGLSound*/
 /*global window*/
 
 "use strict";
@@ -46,12 +47,24 @@ if ((typeof ArrayBuffer !== "undefined") &&
     };
 }
 
+interface SoundTAREntry
+{
+    fileName : string;
+    offset   : number;
+    length   : number;
+    data     : ArrayBuffer; // only when unpacked by a worker
+};
+
 //
 // SoundTARLoader
 //
 class SoundTARLoader
 {
-    static version = 1;
+    static version = 2;
+
+    static maxNumWorkers = (typeof Worker !== "undefined" &&
+                            typeof Blob !== "undefined" &&
+                            (typeof URL !== "undefined" || typeof window['webkitURL'] !== "undefined") ? 1 : 0);
 
     sd: WebGLSoundDevice;
     uncompress: boolean;
@@ -63,7 +76,10 @@ class SoundTARLoader
     decodearchive: { (bytes: any): any; };
     decodesound: { (filename: string, data: any): any; };
 
-    processBytes(bytes)
+    // Returns the name, offset and length of the regular files in the
+    // archive. Also runs inside the unpacking worker so it can not
+    // reference anything outside of it.
+    static parseEntries(bytes: Uint8Array): SoundTAREntry[]
     {
         var offset = 0;
         var totalSize = bytes.length;
@@ -157,31 +173,7 @@ class SoundTARLoader
             offset += 12;
         }
 
-        var sd = this.sd;
-        var uncompress = this.uncompress;
-        var decodesound = this.decodesound;
-        var onsoundload = this.onsoundload;
-        var result = true;
-
-        // This function is called for each sound in the archive,
-        // synchronously if there is an immediate error,
-        // asynchronously otherwise.  If one fails, the load result
-        // for the whole archive is false.
-
-        this.soundsLoading = 0;
-        var that = this;
-        function onload(sound)
-        {
-            that.soundsLoading -= 1;
-            if (sound)
-            {
-                onsoundload(sound);
-            }
-            else
-            {
-                result = false;
-            }
-        }
+        var entries = [];
 
         while ((offset + 512) <= totalSize)
         {
@@ -189,7 +181,6 @@ class SoundTARLoader
             if (0 < header.length)
             {
                 var fileName;
-                var data;
 
                 if (header.fileName === "././@LongLink")
                 {
@@ -213,42 +204,183 @@ class SoundTARLoader
                 }
                 if ('' === header.fileType || '0' === header.fileType)
                 {
-                    //console.log('Loading "' + fileName + '" (' + header.length + ')');
-
-                    // If there is a 'decodesound' callback, allow it
-                    // to process the data before we create a sound
-                    // from it.  'decodesound' has the option of
-                    // ignoring this sound by returning 'null'.
-
-                    data =
-                        (sd.audioContext && (WebGLSound.prototype.forceUncompress || uncompress))?
-                        (bytes.buffer.slice(offset, (offset + header.length))) :
-                        (bytes.subarray(offset, (offset + header.length)));
-                    if (decodesound)
-                    {
-                        data = decodesound(fileName, data);
-                    }
-
-                    if (data)
-                    {
-                        this.soundsLoading += 1;
-                        sd.createSound({
-                            src : fileName,
-                            data : data,
-                            uncompress : uncompress,
-                            onload : onload
-                        });
-                    }
+                    entries.push({
+                        fileName: fileName,
+                        offset: offset,
+                        length: header.length,
+                        data: null
+                    });
                 }
                 offset += (Math.floor((header.length + 511) / 512) * 512);
             }
         }
 
+        return entries;
+    }
+
+    processBytes(bytes)
+    {
+        return this.processEntries(SoundTARLoader.parseEntries(bytes), bytes);
+    }
+
+    // Creates the sounds of the archive entries, taking the data of the
+    // entries unpacked by the worker or slicing it from the bytes
+    processEntries(entries: SoundTAREntry[], bytes?)
+    {
+        var sd = this.sd;
+        var uncompress = this.uncompress;
+        var decodesound = this.decodesound;
+        var onsoundload = this.onsoundload;
+        var result = true;
+
+        // This function is called for each sound in the archive,
+        // synchronously if there is an immediate error,
+        // asynchronously otherwise.  If one fails, the load result
+        // for the whole archive is false.
+
+        this.soundsLoading = 0;
+        var that = this;
+        function onload(sound)
+        {
+            that.soundsLoading -= 1;
+            if (sound)
+            {
+                onsoundload(sound);
+            }
+            else
+            {
+                result = false;
+            }
+        }
+
+        var numEntries = entries.length;
+        var n;
+        for (n = 0; n < numEntries; n += 1)
+        {
+            var entry = entries[n];
+            var fileName = entry.fileName;
+            var offset = entry.offset;
+            var data = entry.data;
+
+            //console.log('Loading "' + fileName + '" (' + entry.length + ')');
+
+            if (!data)
+            {
+                data =
+                    (sd.audioContext && (WebGLSound.prototype.forceUncompress || uncompress))?
+                    (bytes.buffer.slice(offset, (offset + entry.length))) :
+                    (bytes.subarray(offset, (offset + entry.length)));
+            }
+
+            // If there is a 'decodesound' callback, allow it
+            // to process the data before we create a sound
+            // from it.  'decodesound' has the option of
+            // ignoring this sound by returning 'null'.
+
+            if (decodesound)
+            {
+                data = decodesound(fileName, data);
+            }
+
+            if (data)
+            {
+                this.soundsLoading += 1;
+                sd.createSound({
+                    src : fileName,
+                    data : data,
+                    uncompress : uncompress,
+                    onload : onload
+                });
+            }
+        }
+
         bytes = null;
 
         return result;
     }
 
+    static createWorker(): Worker
+    {
+        var code = "var parseEntries = " + this.parseEntries.toString() + ";\n" +
+           "onmessage = function unpackOnMessage(event)\n" +
+           "{\n" +
+           "    var buffer = event.data;\n" +
+           "    var entries = parseEntries(new Uint8Array(buffer));\n" +
+           "    var transfers = [];\n" +
+           "    var n;\n" +
+           "    for (n = 0; n < entries.length; n += 1)\n" +
+           "    {\n" +
+           "        var entry = entries[n];\n" +
+           "        entry.data = buffer.slice(entry.offset, (entry.offset + entry.length));\n" +
+           "        transfers.push(entry.data);\n" +
+           "    }\n" +
+           "    postMessage(entries, transfers);\n" +
+           "};";
+        var blob = new Blob([code], { type: "text/javascript" });
+
+        var url = (typeof URL !== "undefined" ? URL : window['webkitURL']);
+        var objectURL = url.createObjectURL(blob);
+
+        var worker;
+        try
+        {
+            worker = new Worker(objectURL);
+        }
+        catch (e)
+        {
+            worker = null;
+        }
+
+        url.revokeObjectURL(objectURL);
+
+        return worker;
+    }
+
+    // Parses the archive and copies out the data of every sound on a
+    // worker, only for WebAudio devices that decode whole files because
+    // media elements take the data of the sounds as views of the archive.
+    // Returns false if the archive has to be processed on the main thread.
+    unpack(buffer: ArrayBuffer, onunpacked: { (entries: SoundTAREntry[]): void; }): boolean
+    {
+        if (!SoundTARLoader.maxNumWorkers ||
+            !(buffer instanceof ArrayBuffer) ||
+            !this.sd.audioContext ||
+            !(WebGLSound.prototype.forceUncompress || this.uncompress))
+        {
+            return false;
+        }
+
+        var worker = SoundTARLoader.createWorker();
+        if (!worker)
+        {
+            SoundTARLoader.maxNumWorkers = 0;
+            return false;
+        }
+
+        worker.onmessage = function unpackedFn(event)
+        {
+            worker.terminate();
+            worker.onmessage = null;
+            worker.onerror = null;
+            worker = null;
+            onunpacked(event.data);
+        };
+
+        worker.onerror = function unpackFailedFn()
+        {
+            worker.terminate();
+            worker.onmessage = null;
+            worker.onerror = null;
+            worker = null;
+            onunpacked(null);
+        };
+
+        // The archive is not needed on the main thread anymore (ownership transfer)
+        worker.postMessage(buffer, [buffer]);
+
+        return true;
+    }
+
     isValidHeader(header)
     {
         return true;
@@ -368,33 +500,56 @@ class SoundTARLoader
                             // entries in the archive was not supported or
                             // couldn't be loaded as a sound.
 
-                            var bytes = new Uint8Array(buffer);
-                            if (loader.decodearchive)
+                            var processed = function processedFn(archiveResult)
                             {
-                                bytes = loader.decodearchive(bytes);
-                            }
-                            var archiveResult = loader.processBytes(bytes);
-
-                            // Wait until all sounds have been loaded (or
-                            // failed) and return the result.
+                                // Wait until all sounds have been loaded (or
+                                // failed) and return the result.
 
-                            if (loader.onload)
-                            {
-                                var callOnload = function callOnloadFn()
+                                if (loader.onload)
                                 {
-                                    if (0 < loader.soundsLoading)
+                                    var callOnload = function callOnloadFn()
                                     {
-                                        if (!TurbulenzEngine || !TurbulenzEngine.isUnloading())
+                                        if (0 < loader.soundsLoading)
+                                        {
+                                            if (!TurbulenzEngine || !TurbulenzEngine.isUnloading())
+                                            {
+                                                window.setTimeout(callOnload, 100);
+                                            }
+                                        }
+                                        else
                                         {
-                                            window.setTimeout(callOnload, 100);
+                                            loader.onload(archiveResult, xhrStatus);
                                         }
+                                    };
+                                    callOnload();
+                                }
+                            };
+
+                            var entriesUnpacked = function entriesUnpackedFn(entries)
+                            {
+                                if (!TurbulenzEngine || !TurbulenzEngine.isUnloading())
+                                {
+                                    if (entries)
+                                    {
+                                        processed(loader.processEntries(entries));
                                     }
-                                    else
+                                    else if (loader.onerror)
                                     {
-                                        loader.onload(archiveResult, xhrStatus);
+                                        loader.onerror(0);
                                     }
-                                };
-                                callOnload();
+                                }
+                            };
+
+                            var unpacked = (!loader.decodearchive &&
+                                            loader.unpack(buffer, entriesUnpacked));
+                            if (!unpacked)
+                            {
+                                var bytes = new Uint8Array(buffer);
+                                if (loader.decodearchive)
+                                {
+                                    bytes = loader.decodearchive(bytes);
+                                }
+                                processed(loader.processBytes(bytes));
                             }
                         }
                         else
@@ -3,6 +3,7 @@
 /*global Uint8Array*/
 /*global Uint16Array*/
 /*global window*/
+/*global Trace*/
 
 "use strict";
 
@@ -671,7 +672,18 @@ class TGALoader
                                 /*jshint bitwise: true*/
                             }
 
+                            var tracing = (typeof Trace !== "undefined" && Trace.enabled);
+                            if (tracing)
+                            {
+                                Trace.begin("TGALoader.processBytes", "texture", { src: src });
+                            }
+
                             loader.processBytes(new Uint8Array(buffer));
+
+                            if (tracing)
+                            {
+                                Trace.end("TGALoader.processBytes", "texture");
+                            }
                             if (loader.data)
                             {
                                 if (loader.onload)
@@ -720,7 +732,18 @@ class TGALoader
         }
         else
         {
+            var tracing = (typeof Trace !== "undefined" && Trace.enabled);
+            if (tracing)
+            {
+                Trace.begin("TGALoader.processBytes", "texture");
+            }
+
             loader.processBytes(params.data);
+
+            if (tracing)
+            {
+                Trace.end("TGALoader.processBytes", "texture");
+            }
             if (loader.data)
             {
                 if (loader.onload)
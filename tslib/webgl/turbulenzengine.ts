@@ -317,7 +317,8 @@ class WebGLTurbulenzEngine implements TurbulenzEngine
         return this.systemInfo;
     }
 
-    request(url, callback)
+    // Binary requests return the response as a Uint8Array
+    request(url, callback, binary?)
     {
         var that = this;
 
@@ -342,16 +343,26 @@ class WebGLTurbulenzEngine implements TurbulenzEngine
             {
                 if (!that.isUnloading())
                 {
-                    var xhrResponseText = xhr.responseText;
+                    var xhrResponse;
                     var xhrStatus = xhr.status;
 
-                    if ("" === xhrResponseText)
+                    if (binary)
                     {
-                        xhrResponseText = null;
+                        var arrayBuffer = xhr.response;
+                        xhrResponse = (arrayBuffer && arrayBuffer.byteLength ?
+                                       new Uint8Array(arrayBuffer) : null);
+                    }
+                    else
+                    {
+                        xhrResponse = xhr.responseText;
+                        if ("" === xhrResponse)
+                        {
+                            xhrResponse = null;
+                        }
                     }
 
                     // Fix for loading from file
-                    if (xhrStatus === 0 && xhrResponseText && window.location.protocol === "file:")
+                    if (xhrStatus === 0 && xhrResponse && window.location.protocol === "file:")
                     {
                         xhrStatus = 200;
                     }
@@ -378,17 +389,17 @@ class WebGLTurbulenzEngine implements TurbulenzEngine
 
                         if (404 === xhrStatus)
                         {
-                            xhrResponseText = null;
+                            xhrResponse = null;
                         }
 
-                        callback(xhrResponseText, xhrStatus);
+                        callback(xhrResponse, xhrStatus);
                     }
                     else
                     {
                         // Checking xhr.statusText when xhr.status is
                         // 0 causes a silent error
 
-                        callback(xhrResponseText, 0);
+                        callback(xhrResponse, 0);
                     }
                 }
 
@@ -400,6 +411,10 @@ class WebGLTurbulenzEngine implements TurbulenzEngine
         };
 
         xhr.open('GET', url, true);
+        if (binary)
+        {
+            xhr.responseType = "arraybuffer";
+        }
         if (callback)
         {
             xhr.onreadystatechange = httpRequestCallback;